@@ -0,0 +1,208 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "BufferSuballocator.h"
+#include "Device.h"
+#include "Core/Error.h"
+
+#include <algorithm>
+
+namespace Falcor
+{
+BufferSuballocator::BufferSuballocator(ref<Device> pDevice, const Desc& desc, ref<Fence> pFence)
+    : mpDevice(pDevice), mDesc(desc), mpFence(pFence)
+{
+    FALCOR_CHECK(mDesc.blockSize > 0, "'blockSize' must be larger than zero.");
+    FALCOR_CHECK(mDesc.maxSuballocationSize <= mDesc.blockSize, "'maxSuballocationSize' must not be larger than 'blockSize'.");
+    FALCOR_CHECK(
+        mDesc.minAlignment > 0 && (mDesc.minAlignment & (mDesc.minAlignment - 1)) == 0, "'minAlignment' must be a power of two."
+    );
+}
+
+BufferSuballocator::~BufferSuballocator()
+{
+    mDeferredReleases = decltype(mDeferredReleases)();
+}
+
+ref<BufferSuballocator> BufferSuballocator::create(ref<Device> pDevice, const Desc& desc, ref<Fence> pFence)
+{
+    return ref<BufferSuballocator>(new BufferSuballocator(pDevice, desc, pFence));
+}
+
+BufferSuballocator::Allocation BufferSuballocator::allocate(uint64_t size, uint64_t alignment)
+{
+    FALCOR_CHECK(size > 0, "'size' must be larger than zero.");
+    FALCOR_CHECK(alignment == 0 || (alignment & (alignment - 1)) == 0, "'alignment' must be a power of two.");
+    alignment = std::max(alignment, mDesc.minAlignment);
+
+    Allocation allocation;
+    allocation.size = size;
+
+    // Large allocations get their own buffer.
+    if (size > mDesc.maxSuballocationSize || size + alignment - 1 > mDesc.blockSize)
+    {
+        allocation.pBuffer = mpDevice->createBuffer(size, mDesc.bindFlags, mDesc.memoryType);
+        mDedicatedCount++;
+        mDedicatedSize += size;
+        return allocation;
+    }
+
+    // Place the allocation in the first block with enough space.
+    for (uint32_t i = 0; i < mBlocks.size(); ++i)
+    {
+        if (!mBlocks[i].pBuffer)
+            continue;
+        auto blockAllocation = mBlocks[i].pAllocator->allocate(size, alignment);
+        if (blockAllocation.isValid())
+        {
+            allocation.pBuffer = mBlocks[i].pBuffer;
+            allocation.offset = blockAllocation.offset;
+            allocation.blockIndex = i;
+            allocation.blockAllocation = blockAllocation;
+            return allocation;
+        }
+    }
+
+    uint32_t blockIndex = createBlock();
+    auto blockAllocation = mBlocks[blockIndex].pAllocator->allocate(size, alignment);
+    FALCOR_ASSERT(blockAllocation.isValid());
+    allocation.pBuffer = mBlocks[blockIndex].pBuffer;
+    allocation.offset = blockAllocation.offset;
+    allocation.blockIndex = blockIndex;
+    allocation.blockAllocation = blockAllocation;
+    return allocation;
+}
+
+void BufferSuballocator::release(Allocation& allocation)
+{
+    if (!allocation.isValid())
+        return;
+
+    mDeferredReleases.push({std::move(allocation), mpFence->getSignaledValue()});
+    allocation = Allocation();
+}
+
+void BufferSuballocator::executeDeferredReleases()
+{
+    uint64_t currentValue = mpFence->getCurrentValue();
+    while (mDeferredReleases.size() && mDeferredReleases.front().fenceValue < currentValue)
+    {
+        freeAllocation(mDeferredReleases.front().allocation);
+        mDeferredReleases.pop();
+    }
+
+    // Release empty blocks beyond the number of blocks kept for reuse. Later blocks are released
+    // first so that allocations keep being packed into the first blocks.
+    uint32_t emptyBlockCount = 0;
+    for (const auto& block : mBlocks)
+        if (block.pBuffer && block.pAllocator->empty())
+            emptyBlockCount++;
+    for (size_t i = mBlocks.size(); i-- > 0 && emptyBlockCount > mDesc.maxEmptyBlocks;)
+    {
+        Block& block = mBlocks[i];
+        if (block.pBuffer && block.pAllocator->empty())
+        {
+            block.pBuffer = nullptr;
+            block.pAllocator.reset();
+            emptyBlockCount--;
+        }
+    }
+    while (!mBlocks.empty() && !mBlocks.back().pBuffer)
+        mBlocks.pop_back();
+}
+
+BufferSuballocator::Stats BufferSuballocator::getStats() const
+{
+    Stats stats;
+    for (const auto& block : mBlocks)
+    {
+        if (!block.pBuffer)
+            continue;
+        auto blockStats = block.pAllocator->getStats();
+        stats.blockCount++;
+        if (blockStats.allocationCount == 0)
+            stats.emptyBlockCount++;
+        stats.allocationCount += blockStats.allocationCount;
+        stats.reservedSize += blockStats.capacity;
+        stats.usedSize += blockStats.usedSize;
+        stats.largestFreeBlock = std::max(stats.largestFreeBlock, blockStats.largestFreeBlock);
+        stats.freeBlockCount += blockStats.freeBlockCount;
+    }
+    stats.dedicatedCount = mDedicatedCount;
+    stats.dedicatedSize = mDedicatedSize;
+    stats.pendingReleaseCount = (uint32_t)mDeferredReleases.size();
+    return stats;
+}
+
+void BufferSuballocator::breakStrongReferenceToDevice()
+{
+    mpDevice.breakStrongReference();
+
+    // The backing buffers are owned by the device if the suballocator is.
+    mBreakDeviceReference = true;
+    for (auto& block : mBlocks)
+        if (block.pBuffer)
+            block.pBuffer->breakStrongReferenceToDevice();
+}
+
+uint32_t BufferSuballocator::createBlock()
+{
+    Block block;
+    block.pBuffer = mpDevice->createBuffer(mDesc.blockSize, mDesc.bindFlags, mDesc.memoryType);
+    if (mBreakDeviceReference)
+        block.pBuffer->breakStrongReferenceToDevice();
+    block.pAllocator = std::make_unique<TLSFAllocator>(mDesc.blockSize);
+
+    for (uint32_t i = 0; i < mBlocks.size(); ++i)
+    {
+        if (!mBlocks[i].pBuffer)
+        {
+            mBlocks[i] = std::move(block);
+            return i;
+        }
+    }
+    mBlocks.push_back(std::move(block));
+    return (uint32_t)mBlocks.size() - 1;
+}
+
+void BufferSuballocator::freeAllocation(const Allocation& allocation)
+{
+    if (allocation.blockIndex == Allocation::kDedicatedBlock)
+    {
+        // The buffer is released with the last reference.
+        FALCOR_ASSERT(mDedicatedCount > 0);
+        mDedicatedCount--;
+        mDedicatedSize -= allocation.size;
+        return;
+    }
+
+    FALCOR_ASSERT(allocation.blockIndex < mBlocks.size());
+    Block& block = mBlocks[allocation.blockIndex];
+    FALCOR_ASSERT(block.pBuffer == allocation.pBuffer);
+    block.pAllocator->free(allocation.blockAllocation);
+}
+} // namespace Falcor
@@ -0,0 +1,175 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "fwd.h"
+#include "Buffer.h"
+#include "Fence.h"
+#include "Core/Macros.h"
+#include "Core/Object.h"
+#include "Utils/TLSFAllocator.h"
+#include <limits>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Suballocator for small buffers.
+ *
+ * Creating a Buffer creates a separate API resource, which has a significant driver overhead
+ * and wastes memory on placement alignment when many small buffers are used. This class carves
+ * small allocations out of large raw backing buffers (blocks). Each block is managed by a
+ * TLSFAllocator. Allocations larger than Desc::maxSuballocationSize get a dedicated buffer.
+ *
+ * Released allocations may still be in use by the GPU. They are only returned to their block
+ * once the fence has passed the value it was signaled to at the time of release (see
+ * executeDeferredReleases()). Blocks that become empty are released, except for a few that
+ * are kept to avoid re-creating blocks when the allocation count fluctuates.
+ *
+ * Allocations are placed in the first block with enough free space, so long-lived allocations
+ * tend to accumulate in the first blocks while later blocks empty out and are released.
+ *
+ * The class is not thread-safe.
+ */
+class FALCOR_API BufferSuballocator : public Object
+{
+    FALCOR_OBJECT(BufferSuballocator)
+public:
+    struct Desc
+    {
+        uint64_t blockSize = 32 * 1024 * 1024;          ///< Size in bytes of the backing buffers.
+        uint64_t maxSuballocationSize = 4 * 1024 * 1024; ///< Allocations larger than this get a dedicated buffer.
+        uint64_t minAlignment = 16;                      ///< Minimum alignment in bytes of allocations.
+        uint32_t maxEmptyBlocks = 1;                     ///< Number of empty blocks kept for reuse.
+        ResourceBindFlags bindFlags = ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess;
+        MemoryType memoryType = MemoryType::DeviceLocal;
+    };
+
+    struct Allocation
+    {
+        ref<Buffer> pBuffer; ///< Backing buffer. The allocation is the range [offset, offset + size).
+        uint64_t offset = 0; ///< Offset in bytes into the backing buffer.
+        uint64_t size = 0;   ///< Size in bytes as requested.
+
+        bool isValid() const { return pBuffer != nullptr; }
+        uint64_t getGpuAddress() const { return pBuffer->getGpuAddress() + offset; }
+
+    private:
+        static constexpr uint32_t kDedicatedBlock = std::numeric_limits<uint32_t>::max();
+
+        uint32_t blockIndex = kDedicatedBlock;
+        TLSFAllocator::Allocation blockAllocation;
+
+        friend class BufferSuballocator;
+    };
+
+    struct Stats
+    {
+        uint32_t blockCount = 0;             ///< Number of backing buffers.
+        uint32_t emptyBlockCount = 0;        ///< Number of backing buffers without allocations.
+        uint32_t allocationCount = 0;        ///< Number of suballocations (excluding dedicated allocations).
+        uint32_t dedicatedCount = 0;         ///< Number of dedicated allocations.
+        uint32_t pendingReleaseCount = 0;    ///< Number of released allocations waiting for the GPU.
+        uint64_t reservedSize = 0;           ///< Total size in bytes of the backing buffers.
+        uint64_t usedSize = 0;               ///< Total size in bytes of suballocations (including alignment padding).
+        uint64_t dedicatedSize = 0;          ///< Total size in bytes of dedicated allocations.
+        uint64_t largestFreeBlock = 0;       ///< Size in bytes of the largest free range in any backing buffer.
+        uint32_t freeBlockCount = 0;         ///< Number of free ranges in all backing buffers.
+
+        /// Fragmentation of the free space in [0, 1]. 0 if all free space is in a single range.
+        double getFragmentation() const
+        {
+            uint64_t freeSize = reservedSize - usedSize;
+            return freeSize > 0 ? 1.0 - (double)largestFreeBlock / freeSize : 0.0;
+        }
+    };
+
+    ~BufferSuballocator();
+
+    /**
+     * Create a new buffer suballocator.
+     * @param[in] pDevice GPU device.
+     * @param[in] desc Description.
+     * @param[in] pFence Fence to use for deferring releases.
+     * @return A new object, or throws an exception if creation failed.
+     */
+    static ref<BufferSuballocator> create(ref<Device> pDevice, const Desc& desc, ref<Fence> pFence);
+
+    /**
+     * Allocate a range of a buffer.
+     * @param[in] size Size in bytes. Must be larger than zero.
+     * @param[in] alignment Alignment in bytes of the offset. Must be a power of two. Desc::minAlignment is used if smaller.
+     * @return The allocation, or throws an exception if creating a backing buffer failed.
+     */
+    Allocation allocate(uint64_t size, uint64_t alignment = 0);
+
+    /**
+     * Release an allocation. The range is reused once the GPU is done with it.
+     * @param[in,out] allocation Allocation to release. Reset to an invalid allocation.
+     */
+    void release(Allocation& allocation);
+
+    /// Return released allocations that are no longer used by the GPU to their blocks.
+    void executeDeferredReleases();
+
+    const Desc& getDesc() const { return mDesc; }
+
+    Stats getStats() const;
+
+    void breakStrongReferenceToDevice();
+
+private:
+    BufferSuballocator(ref<Device> pDevice, const Desc& desc, ref<Fence> pFence);
+
+    struct Block
+    {
+        ref<Buffer> pBuffer;
+        std::unique_ptr<TLSFAllocator> pAllocator;
+    };
+
+    struct DeferredRelease
+    {
+        Allocation allocation;
+        uint64_t fenceValue = 0;
+    };
+
+    uint32_t createBlock();
+    void freeAllocation(const Allocation& allocation);
+
+    BreakableReference<Device> mpDevice;
+    Desc mDesc;
+    ref<Fence> mpFence;
+    bool mBreakDeviceReference = false;
+
+    std::vector<Block> mBlocks; ///< Blocks by index. Released blocks have a null buffer and are reused.
+    std::queue<DeferredRelease> mDeferredReleases;
+    uint32_t mDedicatedCount = 0;
+    uint64_t mDedicatedSize = 0;
+};
+} // namespace Falcor
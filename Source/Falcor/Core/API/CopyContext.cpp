@@ -679,6 +679,22 @@ void CopyContext::copyBufferRegion(const Buffer* pDst, uint64_t dstOffset, const
     mCommandsPending = true;
 }
 
+void CopyContext::copyBufferRegion(
+    const Buffer* pDst,
+    uint64_t dstOffset,
+    const GpuMemoryHeap::Allocation& src,
+    uint64_t srcOffset,
+    uint64_t numBytes
+)
+{
+    FALCOR_ASSERT(srcOffset + numBytes <= src.size);
+    resourceBarrier(pDst, Resource::State::CopyDest);
+
+    auto resourceEncoder = getLowLevelData()->getResourceCommandEncoder();
+    resourceEncoder->copyBuffer(pDst->getGfxBufferResource(), dstOffset, src.gfxBufferResource, src.offset + srcOffset, numBytes);
+    mCommandsPending = true;
+}
+
 void CopyContext::copySubresourceRegion(
     const Texture* pDst,
     uint32_t dstSubresourceIdx,
@@ -30,6 +30,7 @@
 #include "Resource.h"
 #include "ResourceViews.h"
 #include "Buffer.h"
+#include "GpuMemoryHeap.h"
 #include "LowLevelContextData.h"
 #include "Core/Macros.h"
 #include <memory>
@@ -180,6 +181,18 @@ public:
      */
     void copyBufferRegion(const Buffer* pDst, uint64_t dstOffset, const Buffer* pSrc, uint64_t srcOffset, uint64_t numBytes);
 
+    /**
+     * Copy part of an upload heap allocation to a buffer
+     * `srcOffset` is relative to the start of the allocation
+     */
+    void copyBufferRegion(
+        const Buffer* pDst,
+        uint64_t dstOffset,
+        const GpuMemoryHeap::Allocation& src,
+        uint64_t srcOffset,
+        uint64_t numBytes
+    );
+
     /**
      * Copy a region of a subresource from one texture to another
      * `srcOffset`, `dstOffset` and `size` describe the source and destination regions. For any channel of `extent` that is -1, the source
@@ -671,6 +671,10 @@ Device::Device(const Desc& desc) : mDesc(desc)
     mpReadBackHeap = GpuMemoryHeap::create(ref<Device>(this), MemoryType::ReadBack, 1024 * 1024 * 2, mpFrameFence);
     mpReadBackHeap->breakStrongReferenceToDevice();
 
+    // Backing buffers are created on first use.
+    mpBufferSuballocator = BufferSuballocator::create(ref<Device>(this), BufferSuballocator::Desc(), mpFrameFence);
+    mpBufferSuballocator->breakStrongReferenceToDevice();
+
     mpTimestampQueryHeap = QueryHeap::create(ref<Device>(this), QueryHeap::Type::Timestamp, 1024 * 1024);
     mpTimestampQueryHeap->breakStrongReferenceToDevice();
 
@@ -697,6 +701,7 @@ Device::~Device()
     mpProfiler.reset();
 
     // Release all the bound resources. Need to do that before deleting the RenderContext
+    mpBufferSuballocator.reset();
     mGfxCommandQueue.setNull();
     mDeferredReleases = decltype(mDeferredReleases)();
     mpRenderContext.reset();
@@ -962,6 +967,7 @@ void Device::executeDeferredReleases()
 {
     mpUploadHeap->executeDeferredReleases();
     mpReadBackHeap->executeDeferredReleases();
+    mpBufferSuballocator->executeDeferredReleases();
     uint64_t currentValue = mpFrameFence->getCurrentValue();
     while (mDeferredReleases.size() && mDeferredReleases.front().fenceValue < currentValue)
     {
@@ -34,6 +34,7 @@
 #include "LowLevelContextData.h"
 #include "RenderContext.h"
 #include "GpuMemoryHeap.h"
+#include "BufferSuballocator.h"
 #include "Core/Macros.h"
 #include "Core/Object.h"
 
@@ -568,6 +569,8 @@ public:
 
     const ref<GpuMemoryHeap>& getUploadHeap() const { return mpUploadHeap; }
     const ref<GpuMemoryHeap>& getReadBackHeap() const { return mpReadBackHeap; }
+    /// Get the shared suballocator for small device-local buffers. Released ranges are reused after the frame fence passes.
+    const ref<BufferSuballocator>& getBufferSuballocator() const { return mpBufferSuballocator; }
     const ref<QueryHeap>& getTimestampQueryHeap() const { return mpTimestampQueryHeap; }
     void releaseResource(ISlangUnknown* pResource);
 
@@ -671,6 +674,7 @@ private:
     ref<Sampler> mpDefaultSampler;
     ref<GpuMemoryHeap> mpUploadHeap;
     ref<GpuMemoryHeap> mpReadBackHeap;
+    ref<BufferSuballocator> mpBufferSuballocator;
     ref<QueryHeap> mpTimestampQueryHeap;
 #if FALCOR_HAS_D3D12
     ref<D3D12DescriptorPool> mpD3D12CpuDescPool;
@@ -355,5 +355,6 @@ protected:
     int3 mSparsePageRes = int3(0);
 
     friend class Device;
+    friend class AsyncTextureLoader;
 };
 } // namespace Falcor
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "AssetResolver.h"
+#include "DirectoryIndex.h"
 #include "Core/Platform/OS.h"
 #include "Utils/Scripting/ScriptBindings.h"
 
@@ -42,9 +43,9 @@ std::filesystem::path AssetResolver::resolvePath(const std::filesystem::path& pa
     FALCOR_CHECK(category < AssetCategory::Count, "Invalid asset category.");
 
     // If this is an existing absolute path, or a relative path to the working directory, return it.
-    std::filesystem::path absolute = std::filesystem::absolute(path);
-    if (std::filesystem::exists(absolute))
-        return std::filesystem::canonical(absolute);
+    std::filesystem::path absolute = DirectoryIndex::instance().resolve(path);
+    if (!absolute.empty())
+        return absolute;
 
     // Otherwise, try to resolve using search paths.
     // First try resolving for the specified asset category.
@@ -70,23 +71,31 @@ std::vector<std::filesystem::path> AssetResolver::resolvePathPattern(
     FALCOR_CHECK(category < AssetCategory::Count, "Invalid asset category.");
 
     std::regex regex(pattern);
+    auto findFiles = [&](const std::filesystem::path& directory)
+    { return DirectoryIndex::instance().findFiles(directory, regex, firstMatchOnly); };
 
-    // If this is an existing absolute path, or a relative path to the working directory, search it.
-    std::filesystem::path absolute = std::filesystem::absolute(path);
-    std::vector<std::filesystem::path> resolved = globFilesInDirectory(absolute, regex, firstMatchOnly);
-    if (!resolved.empty())
-        return resolved;
+    std::vector<std::filesystem::path> resolved = resolvePathPattern(path, findFiles, category);
+    if (resolved.empty())
+        logWarning("Failed to resolve path pattern '{}/{}' for asset type '{}'.", path, pattern, category);
 
-    // Otherwise, try to resolve using search paths.
-    // First try resolving for the specified asset category.
-    resolved = mSearchContexts[size_t(category)].resolvePathPattern(path, regex, firstMatchOnly);
+    return resolved;
+}
 
-    // If not resolved, try resolving for the Any asset category.
-    if (category != AssetCategory::Any && resolved.empty())
-        resolved = mSearchContexts[size_t(AssetCategory::Any)].resolvePathPattern(path, regex, firstMatchOnly);
+std::vector<std::filesystem::path> AssetResolver::resolveUdimPattern(
+    const std::filesystem::path& path,
+    const std::string& pattern,
+    bool firstMatchOnly,
+    AssetCategory category
+) const
+{
+    FALCOR_CHECK(category < AssetCategory::Count, "Invalid asset category.");
 
+    auto findFiles = [&](const std::filesystem::path& directory)
+    { return DirectoryIndex::instance().findUdimFiles(directory, pattern, firstMatchOnly); };
+
+    std::vector<std::filesystem::path> resolved = resolvePathPattern(path, findFiles, category);
     if (resolved.empty())
-        logWarning("Failed to resolve path pattern '{}/{}' for asset type '{}'.", path, pattern, category);
+        logWarning("Failed to resolve UDIM pattern '{}/{}' for asset type '{}'.", path, pattern, category);
 
     return resolved;
 }
@@ -104,13 +113,35 @@ AssetResolver& AssetResolver::getDefaultResolver()
     return defaultResolver;
 }
 
+std::vector<std::filesystem::path> AssetResolver::resolvePathPattern(
+    const std::filesystem::path& path,
+    const FindFilesFunc& findFiles,
+    AssetCategory category
+) const
+{
+    // If this is an existing absolute path, or a relative path to the working directory, search it.
+    std::vector<std::filesystem::path> resolved = findFiles(std::filesystem::absolute(path));
+    if (!resolved.empty())
+        return resolved;
+
+    // Otherwise, try to resolve using search paths.
+    // First try resolving for the specified asset category.
+    resolved = mSearchContexts[size_t(category)].resolvePathPattern(path, findFiles);
+
+    // If not resolved, try resolving for the Any asset category.
+    if (category != AssetCategory::Any && resolved.empty())
+        resolved = mSearchContexts[size_t(AssetCategory::Any)].resolvePathPattern(path, findFiles);
+
+    return resolved;
+}
+
 std::filesystem::path AssetResolver::SearchContext::resolvePath(const std::filesystem::path& path) const
 {
     for (const auto& searchPath : searchPaths)
     {
-        std::filesystem::path absolutePath = searchPath / path;
-        if (std::filesystem::exists(absolutePath))
-            return std::filesystem::canonical(absolutePath);
+        std::filesystem::path resolved = DirectoryIndex::instance().resolve(searchPath / path);
+        if (!resolved.empty())
+            return resolved;
     }
 
     return {};
@@ -118,14 +149,12 @@ std::filesystem::path AssetResolver::SearchContext::resolvePath(const std::files
 
 std::vector<std::filesystem::path> AssetResolver::SearchContext::resolvePathPattern(
     const std::filesystem::path& path,
-    const std::regex& regex,
-    bool firstMatchOnly
+    const FindFilesFunc& findFiles
 ) const
 {
     for (const auto& searchPath : searchPaths)
     {
-        std::filesystem::path absolutePath = searchPath / path;
-        std::vector<std::filesystem::path> resolved = globFilesInDirectory(absolutePath, regex, firstMatchOnly);
+        std::vector<std::filesystem::path> resolved = findFiles(searchPath / path);
         if (!resolved.empty())
             return resolved;
     }
@@ -168,6 +197,15 @@ FALCOR_SCRIPT_BINDING(AssetResolver)
         "category"_a = AssetCategory::Any
     );
 
+    assetResolver.def(
+        "resolve_udim_pattern",
+        &AssetResolver::resolveUdimPattern,
+        "path"_a,
+        "pattern"_a,
+        "first_match_only"_a = false,
+        "category"_a = AssetCategory::Any
+    );
+
     assetResolver.def(
         "add_search_path",
         &AssetResolver::addSearchPath,
@@ -30,6 +30,7 @@
 #include "Macros.h"
 #include "Enum.h"
 #include <filesystem>
+#include <functional>
 #include <regex>
 #include <string>
 #include <vector>
@@ -84,6 +85,8 @@ FALCOR_ENUM_REGISTER(SearchPathPriority);
  * search paths. When resolving a path, the resolver will first try to resolve the path
  * for the specified category, and if that fails, it will try to resolve it for the \c AssetCategory::Any category.
  * If no asset category is specified, the \c AssetCategory::Any category is used by default.
+ * All filesystem queries go through the global DirectoryIndex, so each directory is only listed once.
+ * Resolved paths are subject to the staleness contract of the DirectoryIndex.
  */
 class FALCOR_API AssetResolver
 {
@@ -122,6 +125,23 @@ public:
         AssetCategory category = AssetCategory::Any
     ) const;
 
+    /**
+     * Resolve \c <path>/<pattern> to a list of existing absolute file paths of UDIM tiles.
+     * Paths are resolved the same way as in resolvePathPattern(), but the pattern is a filename containing
+     * a \c <UDIM> token that matches the four digit tile numbers 1001-9999, e.g. \c "diffuse.<UDIM>.png".
+     * @param path Path prefix to resolve.
+     * @param pattern Filename pattern containing a \c <UDIM> token.
+     * @param firstMatchOnly If true, only the first found match is returned.
+     * @param category Asset category.
+     * @return Returns a list of resolved paths ordered by tile number, or an empty list if the path could not be resolved.
+     */
+    std::vector<std::filesystem::path> resolveUdimPattern(
+        const std::filesystem::path& path,
+        const std::string& pattern,
+        bool firstMatchOnly = false,
+        AssetCategory category = AssetCategory::Any
+    ) const;
+
     /**
      * Add a search path to the resolver.
      * The path needs to be absolute and exist.
@@ -141,6 +161,9 @@ public:
     static AssetResolver& getDefaultResolver();
 
 private:
+    /// Function returning the files matching a pattern in a given directory.
+    using FindFilesFunc = std::function<std::vector<std::filesystem::path>(const std::filesystem::path& directory)>;
+
     struct SearchContext
     {
         /// List of search paths. Resolving is done by searching these paths in order.
@@ -148,15 +171,17 @@ private:
 
         std::filesystem::path resolvePath(const std::filesystem::path& path) const;
 
-        std::vector<std::filesystem::path> resolvePathPattern(
-            const std::filesystem::path& path,
-            const std::regex& regex,
-            bool firstMatchOnly
-        ) const;
+        std::vector<std::filesystem::path> resolvePathPattern(const std::filesystem::path& path, const FindFilesFunc& findFiles) const;
 
         void addSearchPath(const std::filesystem::path& path, SearchPathPriority priority);
     };
 
+    std::vector<std::filesystem::path> resolvePathPattern(
+        const std::filesystem::path& path,
+        const FindFilesFunc& findFiles,
+        AssetCategory category
+    ) const;
+
     std::vector<SearchContext> mSearchContexts;
 };
 } // namespace Falcor
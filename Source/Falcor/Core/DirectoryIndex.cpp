@@ -0,0 +1,390 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "DirectoryIndex.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cctype>
+
+namespace Falcor
+{
+namespace
+{
+/// Normalize a filename or path string for use as a lookup key.
+std::string normalizeKey(std::string str)
+{
+#if FALCOR_WINDOWS
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+    return str;
+}
+
+/// Convert a path to a lexically normalized absolute path without trailing separator.
+std::filesystem::path normalizePath(const std::filesystem::path& path)
+{
+    std::filesystem::path normalized = std::filesystem::absolute(path).lexically_normal();
+    if (!normalized.has_filename() && normalized.has_relative_path())
+        normalized = normalized.parent_path();
+    return normalized;
+}
+
+/// Split a path into its normalized absolute parent directory and filename. Returns false for root paths.
+bool splitPath(const std::filesystem::path& path, std::filesystem::path& directory, std::string& filename)
+{
+    std::filesystem::path normalized = normalizePath(path);
+    if (!normalized.has_filename())
+        return false;
+    directory = normalized.parent_path();
+    filename = normalized.filename().string();
+    return true;
+}
+
+/// Check if a normalized filename matches a UDIM pattern given by its normalized prefix and suffix.
+bool matchUdim(std::string_view key, std::string_view prefix, std::string_view suffix)
+{
+    if (key.size() != prefix.size() + 4 + suffix.size())
+        return false;
+    if (key.substr(0, prefix.size()) != prefix || key.substr(prefix.size() + 4) != suffix)
+        return false;
+    std::string_view digits = key.substr(prefix.size(), 4);
+    return digits[0] >= '1' && digits[0] <= '9' && std::all_of(digits.begin() + 1, digits.end(), [](char c) { return c >= '0' && c <= '9'; });
+}
+} // namespace
+
+DirectoryIndex& DirectoryIndex::instance()
+{
+    static DirectoryIndex sInstance;
+    return sInstance;
+}
+
+void DirectoryIndex::setEnabled(bool enabled)
+{
+    if (enabled != mEnabled)
+        invalidate();
+    mEnabled = enabled;
+}
+
+bool DirectoryIndex::exists(const std::filesystem::path& path)
+{
+    std::filesystem::path directory;
+    std::string filename;
+    if (!mEnabled || !splitPath(path, directory, filename))
+    {
+        addStats({1, 0, 0, 1});
+        return std::filesystem::exists(path);
+    }
+
+    addStats({1, 0, 0, 0});
+    const std::string key = normalizeKey(filename);
+    DirectoryPtr pDirectory = getDirectory(directory);
+    if (pDirectory->entries.count(key) == 0)
+        pDirectory = revalidateDirectory(directory, pDirectory);
+    return pDirectory->entries.count(key) > 0;
+}
+
+std::filesystem::path DirectoryIndex::resolve(const std::filesystem::path& path)
+{
+    std::filesystem::path directory;
+    std::string filename;
+    if (!mEnabled || !splitPath(path, directory, filename))
+    {
+        std::filesystem::path absolute = std::filesystem::absolute(path);
+        bool exists = std::filesystem::exists(absolute);
+        addStats({1, 0, 0, exists ? 2u : 1u});
+        return exists ? std::filesystem::canonical(absolute) : std::filesystem::path();
+    }
+
+    addStats({1, 0, 0, 0});
+    const std::string key = normalizeKey(filename);
+    DirectoryPtr pDirectory = getDirectory(directory);
+    auto it = pDirectory->entries.find(key);
+    if (it == pDirectory->entries.end())
+    {
+        pDirectory = revalidateDirectory(directory, pDirectory);
+        it = pDirectory->entries.find(key);
+        if (it == pDirectory->entries.end())
+            return {};
+    }
+
+    // Symbolic links need to be resolved by the filesystem.
+    if (it->second.isSymlink || pDirectory->canonicalPath.empty())
+    {
+        addStats({0, 0, 0, 1});
+        std::error_code ec;
+        std::filesystem::path canonical = std::filesystem::canonical(directory / it->second.name, ec);
+        return ec ? std::filesystem::path() : canonical;
+    }
+
+    return pDirectory->canonicalPath / it->second.name;
+}
+
+std::vector<std::filesystem::path> DirectoryIndex::findFiles(
+    const std::filesystem::path& directory,
+    const std::regex& regex,
+    bool firstMatchOnly
+)
+{
+    if (!mEnabled)
+    {
+        addStats({1, 1, 0, 1});
+        return globFilesInDirectory(directory, regex, firstMatchOnly);
+    }
+
+    addStats({1, 0, 0, 0});
+    auto find = [&](const Directory& dir)
+    {
+        std::vector<std::filesystem::path> result;
+        for (const auto& key : dir.sortedKeys)
+        {
+            const Entry& entry = dir.entries.at(key);
+            if (entry.isRegularFile && std::regex_match(entry.name, regex))
+            {
+                result.push_back(directory / entry.name);
+                if (firstMatchOnly)
+                    break;
+            }
+        }
+        return result;
+    };
+
+    const std::filesystem::path normalized = normalizePath(directory);
+    DirectoryPtr pDirectory = getDirectory(normalized);
+    std::vector<std::filesystem::path> result = find(*pDirectory);
+    if (result.empty())
+    {
+        pDirectory = revalidateDirectory(normalized, pDirectory);
+        result = find(*pDirectory);
+    }
+    return result;
+}
+
+std::vector<std::filesystem::path> DirectoryIndex::findUdimFiles(
+    const std::filesystem::path& directory,
+    std::string_view pattern,
+    bool firstMatchOnly
+)
+{
+    auto pos = pattern.find("<UDIM>");
+    FALCOR_CHECK(pos != std::string_view::npos, "UDIM pattern '{}' does not contain a <UDIM> token.", pattern);
+    const std::string prefix = normalizeKey(std::string(pattern.substr(0, pos)));
+    const std::string suffix = normalizeKey(std::string(pattern.substr(pos + 6)));
+
+    if (!mEnabled)
+    {
+        addStats({1, 1, 0, 1});
+        std::vector<std::filesystem::path> result;
+        std::error_code ec;
+        for (auto it = std::filesystem::directory_iterator(directory, ec); !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+        {
+            std::error_code entryError;
+            std::string filename = it->path().filename().string();
+            if (it->is_regular_file(entryError) && matchUdim(normalizeKey(filename), prefix, suffix))
+                result.push_back(directory / filename);
+        }
+        std::sort(result.begin(), result.end());
+        if (firstMatchOnly && result.size() > 1)
+            result.resize(1);
+        return result;
+    }
+
+    addStats({1, 0, 0, 0});
+    auto find = [&](const Directory& dir)
+    {
+        // All matches share the prefix and are stored consecutively in the sorted key list.
+        std::vector<std::filesystem::path> result;
+        for (auto it = std::lower_bound(dir.sortedKeys.begin(), dir.sortedKeys.end(), prefix);
+             it != dir.sortedKeys.end() && it->compare(0, prefix.size(), prefix) == 0;
+             ++it)
+        {
+            const Entry& entry = dir.entries.at(*it);
+            if (entry.isRegularFile && matchUdim(*it, prefix, suffix))
+            {
+                result.push_back(directory / entry.name);
+                if (firstMatchOnly)
+                    break;
+            }
+        }
+        return result;
+    };
+
+    const std::filesystem::path normalized = normalizePath(directory);
+    DirectoryPtr pDirectory = getDirectory(normalized);
+    std::vector<std::filesystem::path> result = find(*pDirectory);
+    if (result.empty())
+    {
+        pDirectory = revalidateDirectory(normalized, pDirectory);
+        result = find(*pDirectory);
+    }
+    return result;
+}
+
+void DirectoryIndex::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirectories.clear();
+}
+
+void DirectoryIndex::invalidate(const std::filesystem::path& directory)
+{
+    std::string key = normalizeKey(normalizePath(directory).string());
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirectories.erase(key);
+}
+
+DirectoryIndex::Stats DirectoryIndex::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void DirectoryIndex::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {};
+}
+
+DirectoryIndex::DirectoryPtr DirectoryIndex::getDirectory(const std::filesystem::path& directory)
+{
+    const std::string key = normalizeKey(directory.string());
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (auto it = mDirectories.find(key); it != mDirectories.end())
+            return it->second;
+    }
+
+    // List the directory outside of the lock. Concurrent listings of the same directory are harmless.
+    DirectoryPtr pDirectory = listDirectory(directory);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirectories[key] = pDirectory;
+    return pDirectory;
+}
+
+DirectoryIndex::DirectoryPtr DirectoryIndex::revalidateDirectory(const std::filesystem::path& directory, const DirectoryPtr& pDirectory)
+{
+    auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (now - pDirectory->validationTime < kRevalidationInterval)
+            return pDirectory;
+        pDirectory->validationTime = now;
+        mStats.statCalls++;
+    }
+
+    std::error_code ec;
+    auto writeTime = std::filesystem::last_write_time(directory, ec);
+    bool unchanged = ec ? !pDirectory->exists : (pDirectory->exists && writeTime == pDirectory->writeTime);
+    if (unchanged)
+        return pDirectory;
+
+    DirectoryPtr pListed = listDirectory(directory);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDirectories[normalizeKey(directory.string())] = pListed;
+    return pListed;
+}
+
+DirectoryIndex::DirectoryPtr DirectoryIndex::listDirectory(const std::filesystem::path& directory)
+{
+    auto pDirectory = std::make_shared<Directory>();
+    pDirectory->validationTime = std::chrono::steady_clock::now();
+
+    Stats stats;
+    stats.listings = 1;
+
+    // Query the modification time before listing, so changes made during listing are detected later.
+    std::error_code ec;
+    stats.statCalls++;
+    pDirectory->writeTime = std::filesystem::last_write_time(directory, ec);
+    if (!ec)
+    {
+        auto it = std::filesystem::directory_iterator(directory, ec);
+        pDirectory->exists = !ec;
+        for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec))
+        {
+            // The entry type is cached from the listing, only symbolic links need another query.
+            std::error_code entryError;
+            Entry entry;
+            entry.name = it->path().filename().string();
+            entry.isSymlink = it->is_symlink(entryError);
+            entry.isRegularFile = it->is_regular_file(entryError);
+            if (entry.isSymlink)
+                stats.statCalls++;
+
+            std::string key = normalizeKey(entry.name);
+            pDirectory->sortedKeys.push_back(key);
+            pDirectory->entries.emplace(std::move(key), std::move(entry));
+            stats.listedEntries++;
+        }
+        std::sort(pDirectory->sortedKeys.begin(), pDirectory->sortedKeys.end());
+
+        if (pDirectory->exists)
+        {
+            stats.statCalls++;
+            pDirectory->canonicalPath = std::filesystem::canonical(directory, ec);
+            if (ec)
+                pDirectory->canonicalPath.clear();
+        }
+    }
+
+    addStats(stats);
+    return pDirectory;
+}
+
+void DirectoryIndex::addStats(const Stats& stats)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.queries += stats.queries;
+    mStats.listings += stats.listings;
+    mStats.listedEntries += stats.listedEntries;
+    mStats.statCalls += stats.statCalls;
+}
+
+FALCOR_SCRIPT_BINDING(DirectoryIndex)
+{
+    pybind11::class_<DirectoryIndex> directoryIndex(m, "DirectoryIndex");
+    directoryIndex.def_static("instance", &DirectoryIndex::instance, pybind11::return_value_policy::reference);
+    directoryIndex.def_property("enabled", &DirectoryIndex::isEnabled, &DirectoryIndex::setEnabled);
+    directoryIndex.def_property_readonly(
+        "stats",
+        [](const DirectoryIndex& self)
+        {
+            auto stats = self.getStats();
+            pybind11::dict d;
+            d["queries"] = stats.queries;
+            d["listings"] = stats.listings;
+            d["listed_entries"] = stats.listedEntries;
+            d["stat_calls"] = stats.statCalls;
+            return d;
+        }
+    );
+    directoryIndex.def("reset_stats", &DirectoryIndex::resetStats);
+    directoryIndex.def("invalidate", pybind11::overload_cast<>(&DirectoryIndex::invalidate));
+}
+} // namespace Falcor
@@ -0,0 +1,176 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Macros.h"
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * @brief Cached index of directory contents.
+ *
+ * Resolving asset paths issues many filesystem metadata queries: an existence check per search path,
+ * per mip level and a full directory scan per UDIM texture. On network filesystems each of these is
+ * expensive. The directory index lists each directory once into a hashed filename table and answers
+ * subsequent queries from memory.
+ *
+ * Listings are revalidated on misses: if a file is not found, the modification time of the directory
+ * is compared to the one recorded when it was listed, and the directory is listed again if it changed.
+ * To keep repeated misses cheap, a directory is revalidated at most once per \c kRevalidationInterval.
+ *
+ * Staleness contract: the index trades freshness for fewer filesystem calls. Callers must expect:
+ * - Stale positives: hits are never revalidated. A file deleted or renamed after its directory was
+ *   listed keeps being reported as existing (and resolve() keeps returning its path) until the
+ *   directory is invalidated. Opening such a path fails with the usual filesystem error.
+ * - Stale negatives: a file created less than \c kRevalidationInterval after the last listing or
+ *   revalidation of its directory may be reported as missing until the interval has passed. The same
+ *   applies if the filesystem's directory modification time has a coarser granularity than the change.
+ * Call invalidate() after creating or deleting files that need to be visible to the index immediately,
+ * and invalidate(directory) after failing to open a path the index reported as existing.
+ *
+ * On Windows, filenames are matched case-insensitively.
+ */
+class FALCOR_API DirectoryIndex
+{
+public:
+    /// Minimum time between two revalidations of a directory listing due to misses.
+    static constexpr std::chrono::milliseconds kRevalidationInterval{1000};
+
+    /// Filesystem access statistics.
+    struct Stats
+    {
+        uint64_t queries = 0;       ///< Number of queries.
+        uint64_t listings = 0;      ///< Number of directory listings.
+        uint64_t listedEntries = 0; ///< Number of directory entries read by listings.
+        uint64_t statCalls = 0;     ///< Number of other filesystem calls (existence checks, modification times, canonical paths).
+
+        /// Total number of filesystem calls. A listing counts as one call.
+        uint64_t getFilesystemCalls() const { return listings + statCalls; }
+    };
+
+    /// Get the global directory index.
+    static DirectoryIndex& instance();
+
+    /**
+     * Enable/disable the index. The index is enabled by default.
+     * When disabled, all queries go directly to the filesystem.
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return mEnabled; }
+
+    /**
+     * Check if a file or directory exists.
+     * The result may be stale, see the staleness contract in the class description.
+     * @param path Path to check.
+     * @return True if the path exists.
+     */
+    bool exists(const std::filesystem::path& path);
+
+    /**
+     * Resolve a path to its canonical form.
+     * The result may be stale, see the staleness contract in the class description.
+     * @param path Path to resolve.
+     * @return The canonical path, or an empty path if the path does not exist.
+     */
+    std::filesystem::path resolve(const std::filesystem::path& path);
+
+    /**
+     * Find all regular files in a directory whose filename matches a regular expression.
+     * Equivalent to globFilesInDirectory().
+     * @param directory Directory to search.
+     * @param regex Filename pattern.
+     * @param firstMatchOnly If true, only the first found match is returned.
+     * @return Paths of the matching files in the form \c <directory>/<filename>.
+     */
+    std::vector<std::filesystem::path> findFiles(const std::filesystem::path& directory, const std::regex& regex, bool firstMatchOnly = false);
+
+    /**
+     * Find all regular files in a directory matching a UDIM filename pattern.
+     * The pattern contains a single \c <UDIM> token that matches the four digit tile numbers 1001-9999.
+     * This does not need a regular expression and only visits the filenames sharing the pattern prefix.
+     * @param directory Directory to search.
+     * @param pattern Filename pattern, e.g. \c "diffuse.<UDIM>.png".
+     * @param firstMatchOnly If true, only the first found match is returned.
+     * @return Paths of the matching files in the form \c <directory>/<filename>, ordered by tile number.
+     */
+    std::vector<std::filesystem::path> findUdimFiles(const std::filesystem::path& directory, std::string_view pattern, bool firstMatchOnly = false);
+
+    /// Drop all directory listings.
+    void invalidate();
+
+    /// Drop the listing of a single directory.
+    void invalidate(const std::filesystem::path& directory);
+
+    /// Get the filesystem access statistics.
+    Stats getStats() const;
+
+    /// Reset the filesystem access statistics.
+    void resetStats();
+
+private:
+    DirectoryIndex() = default;
+
+    struct Entry
+    {
+        std::string name; ///< Filename as stored on disk.
+        bool isRegularFile = false;
+        bool isSymlink = false;
+    };
+
+    struct Directory
+    {
+        bool exists = false;
+        std::filesystem::file_time_type writeTime;
+        std::chrono::steady_clock::time_point validationTime; ///< Time of the last listing or revalidation. Protected by mMutex.
+        std::filesystem::path canonicalPath;
+        std::unordered_map<std::string, Entry> entries; ///< Entries keyed by normalized filename.
+        std::vector<std::string> sortedKeys;           ///< Sorted normalized filenames for prefix queries.
+    };
+
+    using DirectoryPtr = std::shared_ptr<Directory>;
+
+    // The following functions expect normalized absolute directory paths.
+    DirectoryPtr getDirectory(const std::filesystem::path& directory);
+    DirectoryPtr revalidateDirectory(const std::filesystem::path& directory, const DirectoryPtr& pDirectory);
+    DirectoryPtr listDirectory(const std::filesystem::path& directory);
+    void addStats(const Stats& stats);
+
+    bool mEnabled = true;
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, DirectoryPtr> mDirectories; ///< Listings keyed by normalized absolute directory path.
+    Stats mStats;
+};
+} // namespace Falcor
@@ -0,0 +1,188 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "FileWatcher.h"
+#include "Utils/Logger.h"
+#include "Utils/StringFormatters.h"
+
+#if FALCOR_WINDOWS
+// Not supported, callers fall back to polling.
+#elif FALCOR_LINUX
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#else
+#error "Unknown OS"
+#endif
+
+#include <algorithm>
+
+namespace Falcor
+{
+
+namespace
+{
+/// Interval in which the watch thread checks for the stop request.
+constexpr int kPollTimeoutMS = 100;
+/// Maximum time to wait for a burst of changes to settle, relative to the debounce interval.
+constexpr int kMaxDebounceFactor = 10;
+} // namespace
+
+FileWatcher::FileWatcher()
+{
+#if FALCOR_LINUX
+    mInotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFd == -1)
+    {
+        logWarning("Failed to initialize inotify, file changes will be polled.");
+        return;
+    }
+    mIsSupported = true;
+    mThread = std::thread(&FileWatcher::watchThread, this);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+    mStop = true;
+    if (mThread.joinable())
+        mThread.join();
+#if FALCOR_LINUX
+    if (mInotifyFd != -1)
+        ::close(mInotifyFd);
+#endif
+}
+
+bool FileWatcher::addDirectory(const std::filesystem::path& path)
+{
+    if (!mIsSupported)
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mDirectoryToWatch.find(path.string()) != mDirectoryToWatch.end())
+        return true;
+
+#if FALCOR_LINUX
+    // Watch for files being written, replaced (editors often save to a temporary file and rename it),
+    // created, deleted or touched.
+    const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_ATTRIB;
+    int wd = ::inotify_add_watch(mInotifyFd, path.c_str(), mask);
+    if (wd == -1)
+    {
+        logWarning("Failed to watch directory '{}' for changes.", path);
+        return false;
+    }
+    mWatchToDirectory[wd] = path;
+    mDirectoryToWatch[path.string()] = wd;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void FileWatcher::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+#if FALCOR_LINUX
+    for (const auto& [wd, path] : mWatchToDirectory)
+        ::inotify_rm_watch(mInotifyFd, wd);
+#endif
+    mWatchToDirectory.clear();
+    mDirectoryToWatch.clear();
+    mChangedFiles.clear();
+    mOverflow = false;
+}
+
+bool FileWatcher::getChangedFiles(std::vector<std::filesystem::path>& changedFiles, std::chrono::milliseconds debounce)
+{
+    changedFiles.clear();
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    // Wait until no new change arrived for the debounce interval.
+    // The wait is bounded so that a continuously written file doesn't block the caller.
+    auto deadline = std::chrono::steady_clock::now() + debounce * kMaxDebounceFactor;
+    while (!mChangedFiles.empty() || mOverflow)
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto settled = mLastChangeTime + debounce;
+        if (now >= settled || now >= deadline)
+            break;
+        lock.unlock();
+        std::this_thread::sleep_for(std::min(settled, deadline) - now);
+        lock.lock();
+    }
+
+    changedFiles.assign(mChangedFiles.begin(), mChangedFiles.end());
+    mChangedFiles.clear();
+    bool complete = !mOverflow;
+    mOverflow = false;
+    return complete;
+}
+
+void FileWatcher::watchThread()
+{
+#if FALCOR_LINUX
+    alignas(struct inotify_event) char buffer[16 * 1024];
+
+    while (!mStop)
+    {
+        struct pollfd pfd = {mInotifyFd, POLLIN, 0};
+        if (::poll(&pfd, 1, kPollTimeoutMS) <= 0)
+            continue;
+
+        ssize_t len = ::read(mInotifyFd, buffer, sizeof(buffer));
+        if (len <= 0)
+            continue;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (char* ptr = buffer; ptr < buffer + len;)
+        {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                mOverflow = true;
+                mLastChangeTime = std::chrono::steady_clock::now();
+                continue;
+            }
+            if (event->len == 0 || (event->mask & IN_ISDIR))
+                continue;
+
+            auto it = mWatchToDirectory.find(event->wd);
+            if (it == mWatchToDirectory.end())
+                continue;
+
+            mChangedFiles.insert(it->second / event->name);
+            mLastChangeTime = std::chrono::steady_clock::now();
+        }
+    }
+#endif
+}
+
+} // namespace Falcor
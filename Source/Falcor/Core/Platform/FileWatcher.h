@@ -0,0 +1,103 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+
+#include "Core/Macros.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Falcor
+{
+
+/**
+ * Event driven watcher for file changes in a set of directories.
+ * Uses inotify on Linux. On other systems the watcher is not supported and callers
+ * are expected to fall back to polling file modification times.
+ *
+ * Changes are collected on a background thread and returned in batches by getChangedFiles().
+ * Bursts of changes (e.g. editors writing a temporary file and renaming it) are debounced.
+ */
+class FALCOR_API FileWatcher
+{
+public:
+    static constexpr std::chrono::milliseconds kDefaultDebounce{100};
+
+    FileWatcher();
+    ~FileWatcher();
+
+    /// Returns true if event driven file watching is supported and the watcher was successfully initialized.
+    bool isSupported() const { return mIsSupported; }
+
+    /**
+     * Start watching a directory (non-recursive). Does nothing if the directory is already watched.
+     * @param path Directory path.
+     * @return True if the directory is watched.
+     */
+    bool addDirectory(const std::filesystem::path& path);
+
+    /// Stop watching all directories and discard pending changes.
+    void clear();
+
+    /**
+     * Get the files that were changed since the last call.
+     * If the last change was observed less than the debounce interval ago, this waits until no further
+     * changes arrive for the debounce interval, so that a burst of changes is returned as one batch.
+     * @param changedFiles List of changed files (directory of the watch joined with the file name).
+     * @param debounce Debounce interval.
+     * @return False if events were lost (event queue overflow), in which case the caller needs to check all files.
+     */
+    bool getChangedFiles(std::vector<std::filesystem::path>& changedFiles, std::chrono::milliseconds debounce = kDefaultDebounce);
+
+private:
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    void watchThread();
+
+    bool mIsSupported = false;
+    int mInotifyFd = -1;
+    std::thread mThread;
+    std::atomic<bool> mStop{false};
+
+    std::mutex mMutex;
+    std::unordered_map<int, std::filesystem::path> mWatchToDirectory;
+    std::unordered_map<std::string, int> mDirectoryToWatch;
+    std::set<std::filesystem::path> mChangedFiles;
+    std::chrono::steady_clock::time_point mLastChangeTime;
+    bool mOverflow = false;
+};
+
+} // namespace Falcor
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Core/Platform/OS.h"
+#include "Core/Platform/FileWatcher.h"
 #include "Core/Error.h"
 #include "Core/GLFW.h"
 #include "Utils/Logger.h"
@@ -38,13 +39,21 @@
 #include <signal.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
+#include <time.h>
 #include <pwd.h>
 #ifndef _GNU_SOURCE
 #define _GNU_SOURCE // needed for dladdr()
 #endif
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace Falcor
 {
@@ -163,17 +172,107 @@ void terminateProcess(size_t processID)
     FALCOR_UNIMPLEMENTED();
 }
 
+/**
+ * Monitors all shared files with a single file watcher (one inotify instance) and a single dispatch thread.
+ * The monitor is created on first use and runs until shutdown.
+ */
+class SharedFileMonitor
+{
+public:
+    SharedFileMonitor() { mThread = std::thread(&SharedFileMonitor::dispatchThread, this); }
+
+    ~SharedFileMonitor()
+    {
+        mStop = true;
+        if (mThread.joinable())
+            mThread.join();
+    }
+
+    void add(const std::filesystem::path& path, const std::function<void()>& callback)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mWatcher.addDirectory(path.parent_path()))
+        {
+            logError("Failed to monitor shared file '{}'.", path);
+            return;
+        }
+        mCallbacks[path.lexically_normal().string()] = callback;
+    }
+
+    void remove(const std::filesystem::path& path)
+    {
+        // Wait for a running dispatch to finish, so that the callback is not called after returning.
+        // The callback itself may close its own file, in which case the dispatch lock is already held.
+        std::unique_lock<std::mutex> dispatchLock(mDispatchMutex, std::defer_lock);
+        if (std::this_thread::get_id() != mThread.get_id())
+            dispatchLock.lock();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mCallbacks.erase(path.lexically_normal().string());
+    }
+
+private:
+    void dispatchThread()
+    {
+        std::vector<std::filesystem::path> changedFiles;
+        std::vector<std::function<void()>> callbacks;
+        while (!mStop)
+        {
+            std::this_thread::sleep_for(FileWatcher::kDefaultDebounce);
+            // If events were lost, notify all monitors.
+            bool overflow = !mWatcher.getChangedFiles(changedFiles);
+
+            std::lock_guard<std::mutex> dispatchLock(mDispatchMutex);
+            callbacks.clear();
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                if (overflow)
+                {
+                    for (const auto& [path, callback] : mCallbacks)
+                        callbacks.push_back(callback);
+                }
+                else
+                {
+                    for (const auto& file : changedFiles)
+                    {
+                        auto it = mCallbacks.find(file.lexically_normal().string());
+                        if (it != mCallbacks.end())
+                            callbacks.push_back(it->second);
+                    }
+                }
+            }
+
+            // Callbacks are called without holding mMutex, they may monitor or close shared files.
+            for (const auto& callback : callbacks)
+            {
+                if (callback && !mStop)
+                    callback();
+            }
+        }
+    }
+
+    FileWatcher mWatcher;
+    std::thread mThread;
+    std::atomic<bool> mStop{false};
+    std::mutex mMutex;         ///< Protects the callbacks.
+    std::mutex mDispatchMutex; ///< Held while callbacks are dispatched.
+    std::unordered_map<std::string, std::function<void()>> mCallbacks; ///< Callbacks by normalized file path.
+};
+
+static SharedFileMonitor& getSharedFileMonitor()
+{
+    static SharedFileMonitor sMonitor;
+    return sMonitor;
+}
+
 void monitorFileUpdates(const std::filesystem::path& path, const std::function<void()>& callback)
 {
-    (void)path;
-    (void)callback;
-    FALCOR_UNIMPLEMENTED();
+    // Only one callback is registered per file, monitoring a file again replaces the previous callback.
+    getSharedFileMonitor().add(path, callback);
 }
 
 void closeSharedFile(const std::filesystem::path& path)
 {
-    (void)path;
-    FALCOR_UNIMPLEMENTED();
+    getSharedFileMonitor().remove(path);
 }
 
 bool createJunction(const std::filesystem::path& link, const std::filesystem::path& target)
@@ -579,13 +678,32 @@ void OSServices::stop() {}
 
 size_t getCurrentRSS()
 {
-    FALCOR_UNIMPLEMENTED();
-    return 0;
+    // The second field of /proc/self/statm is the resident set size in pages.
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    long pages = 0;
+    long residentPages = 0;
+    int count = fscanf(file, "%ld %ld", &pages, &residentPages);
+    fclose(file);
+    if (count != 2)
+        return 0;
+    return (size_t)residentPages * (size_t)sysconf(_SC_PAGESIZE);
 }
 
 size_t getPeakRSS()
 {
-    FALCOR_UNIMPLEMENTED();
-    return 0;
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return (size_t)usage.ru_maxrss * 1024; // ru_maxrss is in kilobytes.
+}
+
+double getProcessCpuTime()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
 } // namespace Falcor
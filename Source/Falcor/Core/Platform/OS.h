@@ -456,6 +456,11 @@ FALCOR_API uint64_t getCurrentRSS();
  */
 FALCOR_API uint64_t getPeakRSS();
 
+/**
+ * Returns the CPU time in seconds consumed by the process so far (user and kernel time of all threads).
+ */
+FALCOR_API double getProcessCpuTime();
+
 /**
  * Returns index of most significant set bit, or 0 if no bits were set.
  */
@@ -1018,4 +1018,13 @@ size_t getPeakRSS()
         return memoryCounter.PeakWorkingSetSize;
     return 0;
 }
+
+double getProcessCpuTime()
+{
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0.0;
+    auto toSeconds = [](const FILETIME& ft) { return double((uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) * 1e-7; };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+}
 } // namespace Falcor
@@ -266,28 +266,6 @@ bool Program::setTypeConformances(const TypeConformanceList& conformances)
     return false;
 }
 
-bool Program::checkIfFilesChanged()
-{
-    if (mpActiveVersion == nullptr)
-    {
-        // We never linked, so nothing really changed
-        return false;
-    }
-
-    // Have any of the files we depend on changed?
-    for (auto& entry : mFileTimeMap)
-    {
-        auto& path = entry.first;
-        auto& modifiedTime = entry.second;
-
-        if (modifiedTime != getFileModifiedTime(path))
-        {
-            return true;
-        }
-    }
-    return false;
-}
-
 const ref<const ProgramVersion>& Program::getActiveVersion() const
 {
     if (mLinkRequired)
@@ -790,7 +790,6 @@ protected:
     using string_time_map = std::unordered_map<std::string, time_t>;
     mutable string_time_map mFileTimeMap;
 
-    bool checkIfFilesChanged();
     void reset();
 
     using StateGraph = Falcor::StateGraph<ref<RtStateObject>, void*>;
@@ -36,6 +36,13 @@
 namespace Falcor
 {
 
+inline std::string normalizeDependencyPath(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    std::filesystem::path absolutePath = std::filesystem::absolute(path, ec);
+    return (ec ? path : absolutePath).lexically_normal().string();
+}
+
 inline SlangStage getSlangStage(ShaderType type)
 {
     switch (type)
@@ -114,8 +121,13 @@ ProgramManager::ProgramManager(Device* pDevice) : mpDevice(pDevice)
 
     addGlobalDefines(globalDefines);
 
+    mpFileWatcher = std::make_unique<FileWatcher>();
+    if (!mpFileWatcher->isSupported())
+        mpFileWatcher.reset();
 }
 
+ProgramManager::~ProgramManager() = default;
+
 ref<const ProgramVersion> ProgramManager::createProgramVersion(const Program& program, std::string& log) const
 {
     CpuTimer timer;
@@ -165,12 +177,19 @@ ref<const ProgramVersion> ProgramManager::createProgramVersion(const Program& pr
 
     // Extract list of files referenced, for dependency-tracking purposes.
     int depFileCount = spGetDependencyFileCount(pSlangRequest);
+    std::vector<std::string> depFiles;
+    depFiles.reserve(depFileCount);
     for (int ii = 0; ii < depFileCount; ++ii)
     {
         std::string depFilePath = spGetDependencyFilePath(pSlangRequest, ii);
         if (std::filesystem::exists(depFilePath))
+        {
+            depFilePath = normalizeDependencyPath(depFilePath);
             program.mFileTimeMap[depFilePath] = getFileModifiedTime(depFilePath);
+            depFiles.push_back(std::move(depFilePath));
+        }
     }
+    setProgramDependencies(program, std::move(depFiles));
 
     // Note: the `ProgramReflection` needs to be able to refer back to the
     // `ProgramVersion`, but the `ProgramVersion` can't be initialized
@@ -568,16 +587,109 @@ void ProgramManager::registerProgramForReload(Program* program)
 void ProgramManager::unregisterProgramForReload(Program* program)
 {
     mLoadedPrograms.erase(std::remove(mLoadedPrograms.begin(), mLoadedPrograms.end(), program), mLoadedPrograms.end());
+    removeProgramDependencies(*program);
+}
+
+void ProgramManager::setProgramDependencies(const Program& program, std::vector<std::string> files) const
+{
+    std::lock_guard<std::mutex> lock(mDependencyMutex);
+
+    auto& programFiles = mProgramToFiles[&program];
+    for (const auto& file : programFiles)
+    {
+        auto it = mFileToPrograms.find(file);
+        if (it != mFileToPrograms.end())
+        {
+            it->second.erase(&program);
+            if (it->second.empty())
+                mFileToPrograms.erase(it);
+        }
+    }
+
+    programFiles = std::move(files);
+    for (const auto& file : programFiles)
+    {
+        auto& programs = mFileToPrograms[file];
+        // Start watching the directory when the first program depends on a file in it.
+        if (programs.empty() && mpFileWatcher)
+            mpFileWatcher->addDirectory(std::filesystem::path(file).parent_path());
+        programs.insert(&program);
+    }
+}
+
+void ProgramManager::removeProgramDependencies(const Program& program) const
+{
+    std::lock_guard<std::mutex> lock(mDependencyMutex);
+
+    auto programIt = mProgramToFiles.find(&program);
+    if (programIt == mProgramToFiles.end())
+        return;
+
+    for (const auto& file : programIt->second)
+    {
+        auto it = mFileToPrograms.find(file);
+        if (it != mFileToPrograms.end())
+        {
+            it->second.erase(&program);
+            if (it->second.empty())
+                mFileToPrograms.erase(it);
+        }
+    }
+    mProgramToFiles.erase(programIt);
+}
+
+std::unordered_set<const Program*> ProgramManager::findChangedPrograms() const
+{
+    std::unordered_set<const Program*> changedPrograms;
+
+    std::vector<std::filesystem::path> changedFiles;
+    bool useWatcher = mpFileWatcher && mpFileWatcher->getChangedFiles(changedFiles);
+
+    std::lock_guard<std::mutex> lock(mDependencyMutex);
+
+    if (useWatcher)
+    {
+        // Only programs depending on a changed file need to be reloaded.
+        for (const auto& changedFile : changedFiles)
+        {
+            auto it = mFileToPrograms.find(normalizeDependencyPath(changedFile));
+            if (it != mFileToPrograms.end())
+                changedPrograms.insert(it->second.begin(), it->second.end());
+        }
+    }
+    else
+    {
+        // No watcher available or events were lost. Check the modification time of each file once
+        // and compare it against the time recorded by each dependent program.
+        for (const auto& [file, programs] : mFileToPrograms)
+        {
+            time_t modifiedTime = getFileModifiedTime(file);
+            for (const Program* program : programs)
+            {
+                auto it = program->mFileTimeMap.find(file);
+                if (it != program->mFileTimeMap.end() && it->second != modifiedTime)
+                    changedPrograms.insert(program);
+            }
+        }
+    }
+
+    return changedPrograms;
 }
 
 bool ProgramManager::reloadAllPrograms(bool forceReload)
 {
     bool hasReloaded = false;
 
+    std::unordered_set<const Program*> changedPrograms;
+    if (!forceReload)
+        changedPrograms = findChangedPrograms();
+
     for (auto program : mLoadedPrograms)
     {
-        if (program->checkIfFilesChanged() || forceReload)
+        // Programs that were never linked have nothing to reload.
+        if (forceReload || (program->mpActiveVersion && changedPrograms.count(program) > 0))
         {
+            removeProgramDependencies(*program);
             program->reset();
             hasReloaded = true;
         }
@@ -29,8 +29,14 @@
 #include "Program.h"
 #include "Core/Macros.h"
 #include "Core/API/fwd.h"
+#include "Core/Platform/FileWatcher.h"
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace Falcor
 {
@@ -39,6 +45,7 @@ class FALCOR_API ProgramManager
 {
 public:
     ProgramManager(Device* pDevice);
+    ~ProgramManager();
 
     /**
      * Defines flags that should be forcefully disabled or enabled on all shaders.
@@ -85,7 +92,9 @@ public:
     void setHlslLanguagePrelude(const std::string& prelude);
 
     /**
-     * Reload and relink all programs.
+     * Reload and relink all programs whose source files changed.
+     * Changed files are reported by a file watcher where supported (inotify on Linux), otherwise the
+     * modification time of each source file is checked once, no matter how many programs include it.
      * @param[in] forceReload Force reloading all programs.
      * @return True if any program was reloaded, false otherwise.
      */
@@ -147,9 +156,22 @@ public:
 private:
     SlangCompileRequest* createSlangCompileRequest(const Program& program) const;
 
+    /// Replace the source file dependencies of a program in the file to program index.
+    void setProgramDependencies(const Program& program, std::vector<std::string> files) const;
+    /// Remove a program from the file to program index.
+    void removeProgramDependencies(const Program& program) const;
+    /// Find the programs depending on the given changed files. Polls file modification times if no watcher is available.
+    std::unordered_set<const Program*> findChangedPrograms() const;
+
     Device* mpDevice;
 
     std::vector<Program*> mLoadedPrograms;
+
+    // Inverted index of source file dependencies. Paths are absolute and normalized.
+    mutable std::mutex mDependencyMutex;
+    mutable std::unordered_map<std::string, std::unordered_set<const Program*>> mFileToPrograms;
+    mutable std::unordered_map<const Program*, std::vector<std::string>> mProgramToFiles;
+    std::unique_ptr<FileWatcher> mpFileWatcher;
     mutable CompilationStats mCompilationStats;
 
     DefineList mGlobalDefineList;
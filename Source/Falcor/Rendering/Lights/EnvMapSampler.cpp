@@ -37,19 +37,16 @@ namespace Falcor
         const char kShaderFilenameSetup[] = "Rendering/Lights/EnvMapSamplerSetup.cs.slang";
 
         // The defaults are 512x512 @ 64spp in the resampling step.
-        const uint32_t kDefaultDimension = 512;
-        const uint32_t kDefaultSpp = 64;
+        const uint32_t kDefaultDimension = EnvMap::kDefaultImportanceMapDimension;
+        const uint32_t kDefaultSpp = EnvMap::kDefaultImportanceMapSamples;
     }
 
-    EnvMapSampler::EnvMapSampler(ref<Device> pDevice, ref<EnvMap> pEnvMap)
+    EnvMapSampler::EnvMapSampler(ref<Device> pDevice, ref<EnvMap> pEnvMap, SetupMode setupMode)
         : mpDevice(pDevice)
         , mpEnvMap(pEnvMap)
     {
         FALCOR_ASSERT(pEnvMap);
 
-        // Create compute program for the setup phase.
-        mpSetupPass = ComputePass::create(mpDevice, kShaderFilenameSetup, "main");
-
         // Create sampler.
         Sampler::Desc samplerDesc;
         samplerDesc.setFilterMode(TextureFilteringMode::Point, TextureFilteringMode::Point, TextureFilteringMode::Point);
@@ -57,7 +54,19 @@ namespace Falcor
         mpImportanceSampler = mpDevice->createSampler(samplerDesc);
 
         // Create hierarchical importance map for sampling.
-        if (!createImportanceMap(mpDevice->getRenderContext(), kDefaultDimension, kDefaultSpp))
+        bool success = false;
+        if (setupMode == SetupMode::CPU)
+        {
+            success = uploadImportanceMap(mpEnvMap->getImportanceMap(kDefaultDimension, kDefaultSpp));
+        }
+        else
+        {
+            // Create compute program for the setup phase.
+            mpSetupPass = ComputePass::create(mpDevice, kShaderFilenameSetup, "main");
+            success = createImportanceMap(mpDevice->getRenderContext(), kDefaultDimension, kDefaultSpp);
+        }
+
+        if (!success)
         {
             FALCOR_THROW("Failed to create importance map");
         }
@@ -114,4 +123,15 @@ namespace Falcor
         return true;
     }
 
+    bool EnvMapSampler::uploadImportanceMap(const EnvMap::ImportanceMap& importanceMap)
+    {
+        uint32_t dimension = importanceMap.dimension;
+        uint32_t mips = importanceMap.getMipCount();
+        FALCOR_ASSERT(isPowerOf2(dimension));
+        FALCOR_ASSERT(mips > 1 && mips <= 12);     // Shader constant limits max resolution, increase if needed.
+
+        // All mips are provided, so no mip generation is needed.
+        mpImportanceMap = mpDevice->createTexture2D(dimension, dimension, ResourceFormat::R32Float, 1, mips, importanceMap.data.data(), ResourceBindFlags::ShaderResource);
+        return mpImportanceMap != nullptr;
+    }
 }
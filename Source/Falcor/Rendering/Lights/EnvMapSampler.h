@@ -42,11 +42,20 @@ namespace Falcor
     class FALCOR_API EnvMapSampler
     {
     public:
+        /** How the importance map is built.
+        */
+        enum class SetupMode
+        {
+            CPU,    ///< Build on the CPU. The result is cached with the environment map (see EnvMap::getImportanceMap()).
+            GPU,    ///< Build on the GPU with a compute pass. The result is not cached.
+        };
+
         /** Create a new object.
             \param[in] pDevice GPU device.
             \param[in] pEnvMap The environment map.
+            \param[in] setupMode How the importance map is built.
         */
-        EnvMapSampler(ref<Device> pDevice, ref<EnvMap> pEnvMap);
+        EnvMapSampler(ref<Device> pDevice, ref<EnvMap> pEnvMap, SetupMode setupMode = SetupMode::CPU);
         virtual ~EnvMapSampler() = default;
 
         /** Bind the environment map sampler to a given shader variable.
@@ -60,12 +69,13 @@ namespace Falcor
 
     protected:
         bool createImportanceMap(RenderContext* pRenderContext, uint32_t dimension, uint32_t samples);
+        bool uploadImportanceMap(const EnvMap::ImportanceMap& importanceMap);
 
         ref<Device>       mpDevice;
 
         ref<EnvMap>       mpEnvMap;                 ///< Environment map.
 
-        ref<ComputePass>  mpSetupPass;              ///< Compute pass for creating the importance map.
+        ref<ComputePass>  mpSetupPass;              ///< Compute pass for creating the importance map (GPU setup only).
 
         ref<Texture>      mpImportanceMap;          ///< Hierarchical importance map (luminance).
         ref<Sampler>      mpImportanceSampler;
@@ -29,6 +29,7 @@
 #include "Core/Error.h"
 #include "Core/API/RenderContext.h"
 #include "Utils/Timing/Profiler.h"
+#include <algorithm>
 
 namespace
 {
@@ -43,9 +44,9 @@ namespace Falcor
     {
         mLeafUpdater = ComputePass::create(mpDevice, kShaderFile, "updateLeafNodes");
         mInternalUpdater = ComputePass::create(mpDevice, kShaderFile, "updateInternalNodes");
+        mpUploadBatcher = std::make_unique<UploadBatcher>(mpDevice);
     }
 
-    // TODO: Only update the ones that moved.
     void LightBVH::refit(RenderContext* pRenderContext)
     {
         FALCOR_PROFILE(pRenderContext, "LightBVH::refit()");
@@ -103,7 +104,10 @@ namespace Falcor
             "  Size:                " + std::to_string(stats.byteSize) + " bytes\n" +
             "  Internal node count: " + std::to_string(stats.internalNodeCount) + "\n" +
             "  Leaf node count:     " + std::to_string(stats.leafNodeCount) + "\n" +
-            "  Triangle count:      " + std::to_string(stats.triangleCount) + "\n";
+            "  Triangle count:      " + std::to_string(stats.triangleCount) + "\n" +
+            "  SAOH cost ratio:     " + std::to_string(stats.costRatio) + "\n" +
+            "  Refit nodes:         " + std::to_string(stats.refitNodeCount) + "\n" +
+            "  Rebuilt subtrees:    " + std::to_string(stats.rebuiltSubtreeCount) + "\n";
         widget.text(statsStr);
 
         if (auto nodeGroup = widget.group("Node count per level"))
@@ -133,6 +137,10 @@ namespace Falcor
     {
         // Reset all CPU data.
         mNodes.clear();
+        mTriangleIndices.clear();
+        mTriangleBitmasks.clear();
+        mSubtreeCost.clear();
+        mSubtreeBuildCost.clear();
         mNodeIndices.clear();
         mPerDepthRefitEntryInfo.clear();
         mMaxTriangleCountPerLeaf = 0;
@@ -269,8 +277,11 @@ namespace Falcor
         mpNodeIndicesBuffer->setBlob(mNodeIndices.data(), 0, mNodeIndices.size() * sizeof(uint32_t));
     }
 
-    void LightBVH::uploadCPUBuffers(const std::vector<uint32_t>& triangleIndices, const std::vector<uint64_t>& triangleBitmasks)
+    void LightBVH::uploadCPUBuffers()
     {
+        const auto& triangleIndices = mTriangleIndices;
+        const auto& triangleBitmasks = mTriangleBitmasks;
+
         // Reallocate buffers if size requirements have changed.
         auto var = mLeafUpdater->getRootVar()["CB"]["gLightBVH"];
         if (!mpBVHNodesBuffer || mpBVHNodesBuffer->getElementCount() < mNodes.size())
@@ -303,6 +314,26 @@ namespace Falcor
         mIsCpuDataValid = true;
     }
 
+    void LightBVH::uploadNodes(RenderContext* pRenderContext, const std::vector<uint32_t>& nodeIndices)
+    {
+        // Record the given nodes, merging consecutive node indices into a single write, and upload them in one flush.
+        // The node indices are expected to be sorted in increasing order.
+        FALCOR_ASSERT(mIsCpuDataValid);
+        FALCOR_ASSERT(std::is_sorted(nodeIndices.begin(), nodeIndices.end()));
+        for (size_t i = 0; i < nodeIndices.size();)
+        {
+            size_t j = i + 1;
+            while (j < nodeIndices.size() && nodeIndices[j] == nodeIndices[j - 1] + 1) j++;
+
+            const uint32_t firstNode = nodeIndices[i];
+            const size_t nodeCount = j - i;
+            FALCOR_ASSERT(firstNode + nodeCount <= mNodes.size());
+            mpUploadBatcher->write(mpBVHNodesBuffer, firstNode * sizeof(PackedNode), &mNodes[firstNode], nodeCount * sizeof(PackedNode));
+            i = j;
+        }
+        mpUploadBatcher->flush(pRenderContext);
+    }
+
     void LightBVH::syncDataToCPU() const
     {
         if (!mIsValid || mIsCpuDataValid) return;
@@ -32,6 +32,7 @@
 #include "Scene/Lights/LightCollection.h"
 #include "Utils/Math/AABB.h"
 #include "Utils/Math/Vector.h"
+#include "Utils/UploadBatcher.h"
 #include "Utils/UI/Gui.h"
 #include <functional>
 #include <memory>
@@ -78,8 +79,9 @@ namespace Falcor
         */
         LightBVH(ref<Device> pDevice, const ref<const LightCollection>& pLightCollection);
 
-        /** Refit all the BVH nodes to the underlying geometry, without changing the hierarchy.
+        /** Refit all the BVH nodes to the underlying geometry on the GPU, without changing the hierarchy.
             The BVH needs to have been built before trying to refit it.
+            Use LightBVHBuilder::refit() to refit only the nodes affected by a set of changed triangles.
             \param[in] pRenderContext The render context.
         */
         void refit(RenderContext* pRenderContext);
@@ -102,6 +104,11 @@ namespace Falcor
             uint32_t internalNodeCount = 0;                  ///< Number of internal nodes inside the BVH.
             uint32_t leafNodeCount = 0;                      ///< Number of leaf nodes inside the BVH.
             uint32_t triangleCount = 0;                      ///< Number of triangles inside the BVH.
+
+            float cost = 0.f;                                ///< SAOH cost of the tree, i.e., the sum of the SAOH cost of all nodes.
+            float costRatio = 1.f;                           ///< Ratio of the SAOH cost to the cost when the tree was built. Values above one mean that refitting degraded the tree.
+            uint32_t refitNodeCount = 0;                     ///< Number of nodes refit by the last incremental refit.
+            uint32_t rebuiltSubtreeCount = 0;                ///< Number of subtrees rebuilt by the last incremental refit.
         };
 
         /** Returns stats.
@@ -128,7 +135,8 @@ namespace Falcor
         void updateNodeIndices();
         void renderStats(Gui::Widgets& widget, const BVHStats& stats) const;
 
-        void uploadCPUBuffers(const std::vector<uint32_t>& triangleIndices, const std::vector<uint64_t>& triangleBitmasks);
+        void uploadCPUBuffers();
+        void uploadNodes(RenderContext* pRenderContext, const std::vector<uint32_t>& nodeIndices);
         void syncDataToCPU() const;
 
         /** Invalidate the BVH.
@@ -150,6 +158,10 @@ namespace Falcor
 
         // CPU resources
         mutable std::vector<PackedNode>       mNodes;                   ///< CPU-side copy of packed BVH nodes.
+        std::vector<uint32_t>                 mTriangleIndices;         ///< CPU-side copy of the triangle indices sorted by leaf node.
+        std::vector<uint64_t>                 mTriangleBitmasks;        ///< CPU-side copy of the per triangle bit pattern retracing the tree traversal to reach the triangle.
+        std::vector<float>                    mSubtreeCost;             ///< Per-node SAOH cost of the subtree rooted at the node. Only valid while the CPU-side data is valid.
+        std::vector<float>                    mSubtreeBuildCost;        ///< Per-node SAOH cost of the subtree rooted at the node when it was built.
         std::vector<uint32_t>                 mNodeIndices;             ///< Array of all node indices sorted by tree depth.
         std::vector<RefitEntryInfo>           mPerDepthRefitEntryInfo;  ///< Array containing for each level the number of internal nodes as well as the corresponding offset into 'mpNodeIndicesBuffer'; the very last entry contains the same data, but for all leaf nodes instead.
         uint32_t                              mMaxTriangleCountPerLeaf = 0; ///< After the BVH is built, this contains the maximum light count per leaf node.
@@ -162,7 +174,9 @@ namespace Falcor
         ref<Buffer>                           mpTriangleIndicesBuffer;  ///< Triangle indices sorted by leaf node. Each leaf node refers to a contiguous array of triangle indices.
         ref<Buffer>                           mpTriangleBitmasksBuffer; ///< Array containing the per triangle bit pattern retracing the tree traversal to reach the triangle: 0=left child, 1=right child.
         ref<Buffer>                           mpNodeIndicesBuffer;      ///< Buffer holding all node indices sorted by tree depth. This is used for BVH refit.
+        std::unique_ptr<UploadBatcher>        mpUploadBatcher;          ///< Batches the uploads of incrementally refit nodes.
 
         friend LightBVHBuilder;
+        friend class LightBVHTest;
     };
 }
@@ -31,6 +31,8 @@
 #include "Utils/Timing/Profiler.h"
 #include "Utils/Math/MathConstants.slangh"
 #include <algorithm>
+#include <execution>
+#include <stack>
 
 namespace
 {
@@ -246,18 +248,7 @@ namespace Falcor
         {
             if (!mOptions.usePreintegration || triangles[i].flux > 0.f)
             {
-                LightBVHBuilder::TriangleSortData tri;
-                for (uint32_t j = 0; j < 3; j++)
-                {
-                    tri.bounds |= triangles[i].vtx[j].pos;
-                }
-                tri.center = triangles[i].getCenter();
-                tri.coneDirection = triangles[i].normal;
-                tri.cosConeAngle = 1.f; // Single flat emitter => normal bounding cone angle is zero.
-                tri.flux = triangles[i].flux;
-                tri.triangleIndex = static_cast<uint32_t>(i);
-
-                data.trianglesData.push_back(tri);
+                data.trianglesData.push_back(createTriangleSortData(triangles[i], static_cast<uint32_t>(i)));
             }
         }
 
@@ -302,10 +293,176 @@ namespace Falcor
         // The BVH is ready, mark it as valid and upload the data.
         bvh.mIsValid = true;
         bvh.mMaxTriangleCountPerLeaf = mOptions.maxTriangleCountPerLeaf;
-        bvh.uploadCPUBuffers(data.triangleIndices, data.triangleBitmasks);
+        bvh.mTriangleIndices = std::move(data.triangleIndices);
+        bvh.mTriangleBitmasks = std::move(data.triangleBitmasks);
+        bvh.uploadCPUBuffers();
 
         // Computate metadata.
         bvh.finalize();
+
+        // Store the cost of the freshly built tree as reference for tracking the quality when refitting.
+        computeSubtreeCosts(bvh, true);
+        bvh.mBVHStats.cost = bvh.mSubtreeCost[0];
+        bvh.mBVHStats.costRatio = 1.f;
+    }
+
+    void LightBVHBuilder::refit(RenderContext* pRenderContext, LightBVH& bvh, const std::vector<uint32_t>& changedTriangles)
+    {
+        FALCOR_PROFILE(pRenderContext, "LightBVHBuilder::refit()");
+
+        // If there was nothing to build from before, check again with the updated triangles.
+        if (!bvh.isValid())
+        {
+            build(pRenderContext, bvh);
+            return;
+        }
+
+        FALCOR_ASSERT(bvh.mpLightCollection);
+        const auto& triangles = bvh.mpLightCollection->getMeshLightTriangles(pRenderContext);
+        FALCOR_ASSERT(bvh.mTriangleBitmasks.size() == triangles.size());
+
+        // Bring the CPU-side nodes and costs up-to-date if the BVH was refit on the GPU.
+        if (!bvh.mIsCpuDataValid)
+        {
+            bvh.syncDataToCPU();
+            computeSubtreeCosts(bvh, false);
+        }
+
+        // Find the nodes to refit by following the path from the root to the leaf of each changed triangle.
+        // Note that the right child index of an internal node is stored in the first dword, see PackedNode::getInternalNode().
+        const uint64_t invalidBitmask = std::numeric_limits<uint64_t>::max();
+        std::vector<uint8_t> isDirty(bvh.mNodes.size(), 0);
+        std::vector<std::vector<uint32_t>> dirtyNodesPerDepth(bvh.mBVHStats.treeHeight + 1);
+
+        for (uint32_t triangleIndex : changedTriangles)
+        {
+            FALCOR_ASSERT(triangleIndex < triangles.size());
+            const uint64_t bitmask = bvh.mTriangleBitmasks[triangleIndex];
+            if (bitmask == invalidBitmask)
+            {
+                // The triangle was culled when building. If it emits light now, rebuild to include it.
+                if (triangles[triangleIndex].flux > 0.f)
+                {
+                    build(pRenderContext, bvh);
+                    return;
+                }
+                continue;
+            }
+
+            uint32_t nodeIndex = 0;
+            for (uint32_t depth = 0; ; ++depth)
+            {
+                if (!isDirty[nodeIndex])
+                {
+                    isDirty[nodeIndex] = 1;
+                    dirtyNodesPerDepth[depth].push_back(nodeIndex);
+                }
+                if (bvh.mNodes[nodeIndex].isLeaf()) break;
+                nodeIndex = ((bitmask >> depth) & 1) ? bvh.mNodes[nodeIndex].data[0].x : nodeIndex + 1;
+            }
+        }
+
+        // Refit the nodes bottom-up and update the subtree costs. The nodes at the same depth are independent.
+        uint32_t refitNodeCount = 0;
+        for (int depth = (int)dirtyNodesPerDepth.size() - 1; depth >= 0; --depth)
+        {
+            const auto& nodes = dirtyNodesPerDepth[depth];
+            std::for_each(std::execution::par, nodes.begin(), nodes.end(), [&](uint32_t nodeIndex)
+            {
+                refitNode(bvh, nodeIndex, triangles);
+                bvh.mSubtreeCost[nodeIndex] = evalSubtreeCost(bvh, nodeIndex);
+            });
+            refitNodeCount += (uint32_t)nodes.size();
+        }
+        if (refitNodeCount == 0) return;
+
+        // Find the topmost refit subtrees whose cost degraded past the threshold.
+        struct SubtreeLocation
+        {
+            uint32_t nodeIndex;
+            uint64_t bitmask;
+            uint32_t depth;
+        };
+        std::vector<SubtreeLocation> degradedSubtrees;
+
+        if (mOptions.allowPartialRebuild)
+        {
+            std::stack<SubtreeLocation> stack({ SubtreeLocation{ 0, 0ull, 0 } });
+            while (!stack.empty())
+            {
+                const SubtreeLocation location = stack.top();
+                stack.pop();
+
+                const uint32_t nodeIndex = location.nodeIndex;
+                if (!isDirty[nodeIndex] || bvh.mNodes[nodeIndex].isLeaf()) continue;
+
+                if (bvh.mSubtreeCost[nodeIndex] > mOptions.rebuildCostRatio * bvh.mSubtreeBuildCost[nodeIndex])
+                {
+                    degradedSubtrees.push_back(location);
+                    continue;
+                }
+
+                stack.push(SubtreeLocation{ nodeIndex + 1, location.bitmask, location.depth + 1 });
+                stack.push(SubtreeLocation{ bvh.mNodes[nodeIndex].data[0].x, location.bitmask | (1ull << location.depth), location.depth + 1 });
+            }
+        }
+
+        if (degradedSubtrees.empty())
+        {
+            // Upload the refit nodes only.
+            std::vector<uint32_t> dirtyNodes;
+            dirtyNodes.reserve(refitNodeCount);
+            for (uint32_t nodeIndex = 0; nodeIndex < isDirty.size(); ++nodeIndex)
+            {
+                if (isDirty[nodeIndex]) dirtyNodes.push_back(nodeIndex);
+            }
+            bvh.uploadNodes(pRenderContext, dirtyNodes);
+        }
+        else if (degradedSubtrees.front().nodeIndex == 0)
+        {
+            // The whole tree degraded.
+            build(pRenderContext, bvh);
+            bvh.mBVHStats.refitNodeCount = refitNodeCount;
+            bvh.mBVHStats.rebuiltSubtreeCount = 1;
+            return;
+        }
+        else
+        {
+            // Rebuild the subtrees in decreasing node order. Splicing a rebuilt subtree only moves the nodes stored after it.
+            std::sort(degradedSubtrees.begin(), degradedSubtrees.end(), [](const SubtreeLocation& a, const SubtreeLocation& b) { return a.nodeIndex > b.nodeIndex; });
+            for (const SubtreeLocation& location : degradedSubtrees)
+            {
+                rebuildSubtree(bvh, location.nodeIndex, location.bitmask, location.depth, triangles);
+            }
+
+            // Refit the ancestors of the rebuilt subtrees, as the lighting cones of the subtrees may have changed.
+            std::vector<std::pair<uint32_t, uint32_t>> ancestors; // Pairs of (depth, node index).
+            for (const SubtreeLocation& location : degradedSubtrees)
+            {
+                uint32_t nodeIndex = 0;
+                for (uint32_t depth = 0; depth < location.depth; ++depth)
+                {
+                    ancestors.emplace_back(depth, nodeIndex);
+                    nodeIndex = ((location.bitmask >> depth) & 1) ? bvh.mNodes[nodeIndex].data[0].x : nodeIndex + 1;
+                }
+            }
+            std::sort(ancestors.begin(), ancestors.end(), std::greater<>());
+            ancestors.erase(std::unique(ancestors.begin(), ancestors.end()), ancestors.end());
+            for (const auto& [depth, nodeIndex] : ancestors)
+            {
+                refitNode(bvh, nodeIndex, triangles);
+                bvh.mSubtreeCost[nodeIndex] = evalSubtreeCost(bvh, nodeIndex);
+            }
+
+            // The node layout changed, recompute the metadata and upload everything.
+            bvh.finalize();
+            bvh.uploadCPUBuffers();
+        }
+
+        bvh.mBVHStats.cost = bvh.mSubtreeCost[0];
+        bvh.mBVHStats.costRatio = bvh.mSubtreeBuildCost[0] > 0.f ? bvh.mSubtreeCost[0] / bvh.mSubtreeBuildCost[0] : 1.f;
+        bvh.mBVHStats.refitNodeCount = refitNodeCount;
+        bvh.mBVHStats.rebuiltSubtreeCount = (uint32_t)degradedSubtrees.size();
     }
 
     bool LightBVHBuilder::renderUI(Gui::Widgets& widget)
@@ -319,6 +476,20 @@ namespace Falcor
         bool optionsChanged = false;
 
         optionsChanged |= widget.checkbox("Allow refitting", options.allowRefitting);
+        if (options.allowRefitting)
+        {
+            optionsChanged |= widget.checkbox("Incremental refit", options.useIncrementalRefit);
+            widget.tooltip("Refit only the subtrees containing changed triangles on the CPU. Requires a light collection built on the CPU.");
+            if (options.useIncrementalRefit)
+            {
+                optionsChanged |= widget.checkbox("Allow partial rebuild", options.allowPartialRebuild);
+                if (options.allowPartialRebuild)
+                {
+                    optionsChanged |= widget.var("Rebuild cost ratio", options.rebuildCostRatio, 1.f, std::numeric_limits<float>::max(), 0.1f);
+                    widget.tooltip("Subtrees whose SAOH cost grew by more than this factor since they were built are rebuilt.");
+                }
+            }
+        }
         optionsChanged |= widget.var("Max triangle count per leaf", options.maxTriangleCountPerLeaf, 1u, kMaxLeafTriangleCount);
         optionsChanged |= widget.dropdown("Split heuristic", options.splitHeuristicSelection);
 
@@ -865,6 +1036,194 @@ namespace Falcor
         return overallBestSplit.second;
     }
 
+    LightBVHBuilder::TriangleSortData LightBVHBuilder::createTriangleSortData(const LightCollection::MeshLightTriangle& triangle, uint32_t triangleIndex)
+    {
+        TriangleSortData tri;
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            tri.bounds |= triangle.vtx[j].pos;
+        }
+        tri.center = triangle.getCenter();
+        tri.coneDirection = triangle.normal;
+        tri.cosConeAngle = 1.f; // Single flat emitter => normal bounding cone angle is zero.
+        tri.flux = triangle.flux;
+        tri.triangleIndex = triangleIndex;
+        return tri;
+    }
+
+    void LightBVHBuilder::refitNode(LightBVH& bvh, uint32_t nodeIndex, const std::vector<LightCollection::MeshLightTriangle>& triangles)
+    {
+        // This follows the refit kernels in LightBVHRefit.cs.slang, but also updates the flux.
+        PackedNode& packedNode = bvh.mNodes[nodeIndex];
+        if (packedNode.isLeaf())
+        {
+            LeafNode node = packedNode.getLeafNode();
+
+            AABB bounds;
+            float flux = 0.f;
+            float3 normalsSum = float3(0.f);
+            for (uint32_t i = 0; i < node.triangleCount; i++)
+            {
+                const auto& tri = triangles[bvh.mTriangleIndices[node.triangleOffset + i]];
+                for (uint32_t j = 0; j < 3; j++) bounds |= tri.vtx[j].pos;
+                flux += tri.flux;
+                normalsSum += tri.normal;
+            }
+            node.attribs.setAABB(bounds.minPoint, bounds.maxPoint);
+            node.attribs.flux = flux;
+
+            // Update the normal bounding cone.
+            const float coneDirectionLength = length(normalsSum);
+            node.attribs.coneDirection = float3(0.f);
+            node.attribs.cosConeAngle = kInvalidCosConeAngle;
+            if (coneDirectionLength >= FLT_MIN)
+            {
+                node.attribs.coneDirection = normalsSum / coneDirectionLength;
+                float cosConeAngle = 1.f;
+                for (uint32_t i = 0; i < node.triangleCount; i++)
+                {
+                    const auto& tri = triangles[bvh.mTriangleIndices[node.triangleOffset + i]];
+                    cosConeAngle = std::min(cosConeAngle, dot(node.attribs.coneDirection, tri.normal));
+                }
+                node.attribs.cosConeAngle = std::max(cosConeAngle, -1.f); // Guard against numerical errors
+            }
+
+            packedNode.setLeafNode(node);
+        }
+        else
+        {
+            InternalNode node = packedNode.getInternalNode();
+            SharedNodeAttributes leftNode = bvh.mNodes[nodeIndex + 1].getNodeAttributes();
+            SharedNodeAttributes rightNode = bvh.mNodes[node.rightChildIdx].getNodeAttributes();
+
+            float3 leftAabbMin, leftAabbMax;
+            float3 rightAabbMin, rightAabbMax;
+            leftNode.getAABB(leftAabbMin, leftAabbMax);
+            rightNode.getAABB(rightAabbMin, rightAabbMax);
+            node.attribs.setAABB(min(leftAabbMin, rightAabbMin), max(leftAabbMax, rightAabbMax));
+            node.attribs.flux = leftNode.flux + rightNode.flux;
+
+            // Update the normal bounding cone. The cone is invalid if either child cone is invalid or if it would represent the whole sphere.
+            const float3 coneDirectionSum = leftNode.coneDirection + rightNode.coneDirection;
+            const float coneDirectionLength = length(coneDirectionSum);
+            node.attribs.coneDirection = float3(0.f);
+            node.attribs.cosConeAngle = kInvalidCosConeAngle;
+            if (coneDirectionLength >= FLT_MIN)
+            {
+                node.attribs.coneDirection = coneDirectionSum / coneDirectionLength;
+                float cosConeAngle = computeCosConeAngle(node.attribs.coneDirection, 1.f, leftNode.coneDirection, leftNode.cosConeAngle);
+                cosConeAngle = computeCosConeAngle(node.attribs.coneDirection, cosConeAngle, rightNode.coneDirection, rightNode.cosConeAngle);
+                node.attribs.cosConeAngle = cosConeAngle != kInvalidCosConeAngle ? std::max(cosConeAngle, -1.f) : kInvalidCosConeAngle;
+            }
+
+            packedNode.setInternalNode(node);
+        }
+    }
+
+    void LightBVHBuilder::rebuildSubtree(LightBVH& bvh, uint32_t nodeIndex, uint64_t bitmask, uint32_t depth, const std::vector<LightCollection::MeshLightTriangle>& triangles)
+    {
+        // The nodes are stored in depth-first order, so the subtree occupies a contiguous range of nodes
+        // and its leaves refer to a contiguous range of triangle indices.
+        uint32_t oldNodeCount = 0;
+        uint32_t triangleOffset = std::numeric_limits<uint32_t>::max();
+        uint32_t triangleCount = 0;
+        bvh.traverseBVH(
+            [&](const LightBVH::NodeLocation& location) { ++oldNodeCount; return true; },
+            [&](const LightBVH::NodeLocation& location)
+            {
+                const LeafNode leaf = bvh.mNodes[location.nodeIndex].getLeafNode();
+                triangleOffset = std::min(triangleOffset, leaf.triangleOffset);
+                triangleCount += leaf.triangleCount;
+                ++oldNodeCount;
+                return true;
+            },
+            nodeIndex);
+        FALCOR_ASSERT(triangleCount > 0 && triangleOffset + triangleCount <= bvh.mTriangleIndices.size());
+
+        // Build the subtree from the current triangle data. The node and triangle indices are relative to the subtree.
+        std::vector<PackedNode> nodes;
+        BuildingData data(nodes);
+        data.trianglesData.reserve(triangleCount);
+        for (uint32_t i = 0; i < triangleCount; i++)
+        {
+            const uint32_t triangleIndex = bvh.mTriangleIndices[triangleOffset + i];
+            data.trianglesData.push_back(createTriangleSortData(triangles[triangleIndex], triangleIndex));
+        }
+        data.nodes.reserve(2 * triangleCount);
+        data.triangleIndices.reserve(triangleCount);
+        data.triangleBitmasks = std::move(bvh.mTriangleBitmasks);
+
+        SplitHeuristicFunction splitFunc = getSplitFunction(mOptions.splitHeuristicSelection);
+        buildInternal(mOptions, splitFunc, bitmask, depth, Range(0, triangleCount), data);
+        float cosConeAngle;
+        computeLightingConesInternal(0, data, cosConeAngle);
+
+        bvh.mTriangleBitmasks = std::move(data.triangleBitmasks);
+        FALCOR_ASSERT(data.triangleIndices.size() == triangleCount);
+        std::copy(data.triangleIndices.begin(), data.triangleIndices.end(), bvh.mTriangleIndices.begin() + triangleOffset);
+
+        // Offset the indices to the subtree location. The indices are stored in the low bits of the first dword for both node types.
+        for (PackedNode& node : nodes)
+        {
+            node.data[0].x += node.isLeaf() ? triangleOffset : nodeIndex;
+        }
+
+        // Update the right child indices of the nodes outside the subtree that point past it.
+        const uint32_t oldEnd = nodeIndex + oldNodeCount;
+        const uint32_t newNodeCount = (uint32_t)nodes.size();
+        if (newNodeCount != oldNodeCount)
+        {
+            for (uint32_t i = 0; i < bvh.mNodes.size(); ++i)
+            {
+                PackedNode& node = bvh.mNodes[i];
+                if ((i < nodeIndex || i >= oldEnd) && !node.isLeaf() && node.data[0].x >= oldEnd)
+                {
+                    node.data[0].x = node.data[0].x - oldNodeCount + newNodeCount;
+                }
+            }
+        }
+
+        // Splice the subtree into the BVH.
+        auto splice = [&](auto& vec, auto first, auto last)
+        {
+            vec.erase(vec.begin() + nodeIndex, vec.begin() + oldEnd);
+            vec.insert(vec.begin() + nodeIndex, first, last);
+        };
+        splice(bvh.mNodes, nodes.begin(), nodes.end());
+        std::vector<float> costs(newNodeCount, 0.f);
+        splice(bvh.mSubtreeCost, costs.begin(), costs.end());
+        splice(bvh.mSubtreeBuildCost, costs.begin(), costs.end());
+
+        // The children are stored after their parent, so iterating in reverse order visits the children first.
+        for (uint32_t i = nodeIndex + newNodeCount; i-- > nodeIndex; )
+        {
+            bvh.mSubtreeCost[i] = bvh.mSubtreeBuildCost[i] = evalSubtreeCost(bvh, i);
+        }
+    }
+
+    float LightBVHBuilder::evalSubtreeCost(const LightBVH& bvh, uint32_t nodeIndex) const
+    {
+        const PackedNode& node = bvh.mNodes[nodeIndex];
+        SharedNodeAttributes attribs = node.getNodeAttributes();
+        float3 aabbMin, aabbMax;
+        attribs.getAABB(aabbMin, aabbMax);
+
+        float cost = evalSAOH(AABB(aabbMin, aabbMax), attribs.flux, attribs.cosConeAngle, mOptions);
+        if (!node.isLeaf()) cost += bvh.mSubtreeCost[nodeIndex + 1] + bvh.mSubtreeCost[node.getInternalNode().rightChildIdx];
+        return cost;
+    }
+
+    void LightBVHBuilder::computeSubtreeCosts(LightBVH& bvh, bool resetBuildCost) const
+    {
+        // The children are stored after their parent, so iterating in reverse order visits the children first.
+        bvh.mSubtreeCost.resize(bvh.mNodes.size());
+        for (size_t i = bvh.mNodes.size(); i-- > 0; )
+        {
+            bvh.mSubtreeCost[i] = evalSubtreeCost(bvh, (uint32_t)i);
+        }
+        if (resetBuildCost) bvh.mSubtreeBuildCost = bvh.mSubtreeCost;
+    }
+
     LightBVHBuilder::SplitHeuristicFunction LightBVHBuilder::getSplitFunction(SplitHeuristic heuristic)
     {
         switch (heuristic)
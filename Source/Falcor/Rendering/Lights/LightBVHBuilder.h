@@ -76,6 +76,9 @@ namespace Falcor
             bool           useLeafCreationCost = true;                           ///< Set to true to avoid splitting when the cost is higher than the cost of creating a leaf node. Only used when 'createLeavesASAP' is disabled.
             bool           createLeavesASAP = true;                              ///< Rather than creating a leaf only once splitting stops, create it as soon as we can.
             bool           allowRefitting = true;                                ///< Rather than always rebuilding the BVH from scratch, keep the hierarchy but update the bounds and lighting cones.
+            bool           useIncrementalRefit = true;                           ///< Refit only the subtrees containing changed triangles on the CPU and track the tree quality. Requires a light collection built on the CPU, otherwise all nodes are refit on the GPU. Only used when 'allowRefitting' is enabled.
+            bool           allowPartialRebuild = true;                           ///< Rebuild subtrees whose SAOH cost degraded during incremental refitting. Only used when 'useIncrementalRefit' is enabled.
+            float          rebuildCostRatio = 1.5f;                              ///< Ratio of the current to the built SAOH cost of a subtree above which the subtree is rebuilt. If the root exceeds it, the whole BVH is rebuilt.
             bool           usePreintegration = true;                             ///< Use pre-integration for culling out emissive triangles and use their flux when computing the splits. Only valid when using the BinnedSAOH split heuristic.
             bool           useLightingCones = true;                              ///< Use lighting cones when computing the splits. Only valid when using the BinnedSAOH split heuristic.
 
@@ -91,6 +94,9 @@ namespace Falcor
                 ar("useLeafCreationCost", useLeafCreationCost);
                 ar("createLeavesASAP", createLeavesASAP);
                 ar("allowRefitting", allowRefitting);
+                ar("useIncrementalRefit", useIncrementalRefit);
+                ar("allowPartialRebuild", allowPartialRebuild);
+                ar("rebuildCostRatio", rebuildCostRatio);
                 ar("usePreintegration", usePreintegration);
                 ar("useLightingCones", useLightingCones);
             }
@@ -106,6 +112,16 @@ namespace Falcor
         */
         void build(RenderContext* pRenderContext, LightBVH& bvh);
 
+        /** Incrementally update the BVH after some of the emissive triangles changed.
+            Only the leaves containing the changed triangles and their ancestors are refit. The SAOH cost of the
+            refit subtrees is compared to their cost when they were built, and subtrees whose cost degraded past
+            'rebuildCostRatio' are rebuilt. This requires the light collection triangles to be available on the CPU.
+            \param[in] pRenderContext The render context.
+            \param[in,out] bvh The light BVH to update. It must have been built with the same options.
+            \param[in] changedTriangles Global indices of the emissive triangles that changed.
+        */
+        void refit(RenderContext* pRenderContext, LightBVH& bvh, const std::vector<uint32_t>& changedTriangles);
+
         bool renderUI(Gui::Widgets& widget);
 
         const Options& getOptions() const { return mOptions; }
@@ -199,6 +215,31 @@ namespace Falcor
 
         static SplitHeuristicFunction getSplitFunction(SplitHeuristic heuristic);
 
+        /** Creates the data needed for building from an emissive triangle.
+        */
+        static TriangleSortData createTriangleSortData(const LightCollection::MeshLightTriangle& triangle, uint32_t triangleIndex);
+
+        /** Refit a node to its triangles or children. The children need to be up-to-date.
+        */
+        static void refitNode(LightBVH& bvh, uint32_t nodeIndex, const std::vector<LightCollection::MeshLightTriangle>& triangles);
+
+        /** Rebuild the subtree rooted at a node with its current triangles and splice it into the BVH.
+            The node indices after the subtree change if the rebuilt subtree has a different node count.
+            \param[in] nodeIndex Index of the root node of the subtree.
+            \param[in] bitmask Bit pattern retracing the tree traversal to reach the node.
+            \param[in] depth Depth of the node.
+        */
+        void rebuildSubtree(LightBVH& bvh, uint32_t nodeIndex, uint64_t bitmask, uint32_t depth, const std::vector<LightCollection::MeshLightTriangle>& triangles);
+
+        /** Evaluates the SAOH cost of the subtree rooted at a node. The costs of the children need to be up-to-date.
+        */
+        float evalSubtreeCost(const LightBVH& bvh, uint32_t nodeIndex) const;
+
+        /** Evaluates the SAOH cost of all subtrees.
+            \param[in] resetBuildCost Also reset the build cost of all subtrees to their current cost.
+        */
+        void computeSubtreeCosts(LightBVH& bvh, bool resetBuildCost) const;
+
         // Configuration
         Options mOptions;
     };
@@ -56,7 +56,22 @@ namespace Falcor
         }
         else if (needsRefit)
         {
-            mpBVH->refit(pRenderContext);
+            const auto& pLightCollection = mpScene->getLightCollection(pRenderContext);
+            if (mOptions.buildOptions.useIncrementalRefit && pLightCollection->isBuiltOnCPU())
+            {
+                // Refit only the parts of the BVH containing triangles of the changed mesh lights.
+                std::vector<uint32_t> changedTriangles;
+                for (uint32_t lightIdx : pLightCollection->getUpdatedMeshLights())
+                {
+                    const auto& meshLight = pLightCollection->getMeshLights()[lightIdx];
+                    for (uint32_t i = 0; i < meshLight.triangleCount; i++) changedTriangles.push_back(meshLight.triangleOffset + i);
+                }
+                mpBVHBuilder->refit(pRenderContext, *mpBVH, changedTriangles);
+            }
+            else
+            {
+                mpBVH->refit(pRenderContext);
+            }
             samplerChanged = true;
         }
 
@@ -195,6 +195,7 @@ namespace Falcor
         FALCOR_PROFILE(pRenderContext, "animate");
 
         std::fill(mMatricesChanged.begin(), mMatricesChanged.end(), false);
+        mChangedMatrices.clear();
 
         // Check for edited scene nodes and update local matrices.
         const auto& sceneGraph = mpScene->mSceneGraph;
@@ -267,6 +268,7 @@ namespace Falcor
                 updateLocalMatrices(time);
                 updateWorldMatrices();
                 uploadWorldMatrices();
+                mpScene->mpUploadBatcher->flush(pRenderContext); // The skinning pass reads the matrices.
                 bindBuffers();
                 executeSkinningPass(pRenderContext);
                 changed = true;
@@ -302,6 +304,9 @@ namespace Falcor
     {
         const auto& sceneGraph = mpScene->mSceneGraph;
 
+        // The change flags accumulate over the frame, rebuild the list of changed matrices.
+        mChangedMatrices.clear();
+
         for (size_t i = 0; i < mGlobalMatrices.size(); i++)
         {
             // Propagate matrix change flag to children.
@@ -310,6 +315,8 @@ namespace Falcor
                 mMatricesChanged[i] = mMatricesChanged[i] || mMatricesChanged[sceneGraph[i].parent.get()];
             }
 
+            if (mMatricesChanged[i]) mChangedMatrices.push_back((uint32_t)i);
+
             if (!mMatricesChanged[i] && !updateAll) continue;
 
             mGlobalMatrices[i] = mLocalMatrices[i];
@@ -352,12 +359,13 @@ namespace Falcor
                 bool changed = mMatricesChanged[i];
                 while (i < mGlobalMatrices.size() && mMatricesChanged[i] == changed) ++i;
 
-                // Upload range of changed matrices.
+                // Record range of changed matrices. The ranges are uploaded together when the scene's upload batcher is flushed.
                 if (changed)
                 {
                     size_t count = i - offset;
-                    mpWorldMatricesBuffer->setBlob(&mGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
-                    mpInvTransposeWorldMatricesBuffer->setBlob(&mInvTransposeGlobalMatrices[offset], offset * sizeof(float4x4), count * sizeof(float4x4));
+                    auto& batcher = *mpScene->mpUploadBatcher;
+                    batcher.write(mpWorldMatricesBuffer, offset * sizeof(float4x4), &mGlobalMatrices[offset], count * sizeof(float4x4));
+                    batcher.write(mpInvTransposeWorldMatricesBuffer, offset * sizeof(float4x4), &mInvTransposeGlobalMatrices[offset], count * sizeof(float4x4));
                 }
             }
         }
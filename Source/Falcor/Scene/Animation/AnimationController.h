@@ -110,6 +110,11 @@ namespace Falcor
         */
         bool isMatrixChanged(NodeID matrixID) const { return mMatricesChanged[matrixID.get()]; }
 
+        /** Get the IDs of all matrices that changed since last frame.
+            \return List of matrix IDs in ascending order. Only valid after animate() was called.
+        */
+        const std::vector<uint32_t>& getChangedMatrices() const { return mChangedMatrices; }
+
         /** Get the local matrices.
             These represent the current local transform for each scene graph node.
         */
@@ -165,6 +170,7 @@ namespace Falcor
         std::vector<float4x4> mGlobalMatrices;
         std::vector<float4x4> mInvTransposeGlobalMatrices;
         std::vector<bool> mMatricesChanged;         ///< Flag per matrix, true if matrix changed since last frame.
+        std::vector<uint32_t> mChangedMatrices;     ///< IDs of the matrices flagged in mMatricesChanged.
 
         bool mFirstUpdate = true;       ///< True if this is the first update.
         bool mEnabled = true;           ///< True if animations are enabled.
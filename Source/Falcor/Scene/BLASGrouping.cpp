@@ -0,0 +1,329 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "BLASGrouping.h"
+#include "Core/Error.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace Falcor
+{
+    namespace BLASGrouping
+    {
+        namespace
+        {
+            constexpr uint32_t kBinCount = 16;
+            constexpr uint64_t kBLASBytesPerTriangle = 64;  ///< Rough size of a compacted BLAS per triangle.
+            constexpr uint64_t kTLASBytesPerInstance = 64;  ///< Size of a ray tracing instance descriptor.
+
+            int largestAxis(const float3& v)
+            {
+                if (v.x >= v.y && v.x >= v.z) return 0;
+                else if (v.y >= v.z) return 1;
+                else return 2;
+            }
+
+            size_t countTriangles(const std::vector<MeshInfo>& meshes, const Group& group)
+            {
+                size_t triangleCount = 0;
+                for (uint32_t meshIndex : group) triangleCount += meshes[meshIndex].triangleCount;
+                return triangleCount;
+            }
+
+            AABB calculateBoundingBox(const std::vector<MeshInfo>& meshes, const Group& group)
+            {
+                AABB bb;
+                for (uint32_t meshIndex : group) bb.include(meshes[meshIndex].bounds);
+                return bb;
+            }
+
+            float surfaceArea(const AABB& bb)
+            {
+                return bb.valid() ? bb.area() : 0.f;
+            }
+
+            void append(std::vector<Group>& dst, std::vector<Group>&& src)
+            {
+                dst.insert(dst.end(), std::make_move_iterator(src.begin()), std::make_move_iterator(src.end()));
+            }
+
+            std::vector<Group> partitionSimple(const std::vector<MeshInfo>& meshes, const Group& group, size_t maxTriangles)
+            {
+                // Each new group holds at least one mesh, or if multiple, up to the target number of triangles.
+                const size_t triangleCount = countTriangles(meshes, group);
+                const size_t targetGroupCount = (triangleCount + maxTriangles - 1) / maxTriangles;
+                const size_t targetTrianglesPerGroup = triangleCount / targetGroupCount;
+
+                std::vector<Group> groups;
+                size_t groupTriangles = 0;
+                for (uint32_t meshIndex : group)
+                {
+                    size_t meshTris = meshes[meshIndex].triangleCount;
+                    if (groupTriangles == 0 || groupTriangles + meshTris > targetTrianglesPerGroup)
+                    {
+                        groups.emplace_back();
+                        groupTriangles = 0;
+                    }
+                    groups.back().push_back(meshIndex);
+                    groupTriangles += meshTris;
+                }
+                return groups;
+            }
+
+            /// Split a group in two halves in centroid order along the largest axis. Returns false if the group has a single mesh.
+            bool splitMiddle(const std::vector<MeshInfo>& meshes, const Group& group, Group& left, Group& right)
+            {
+                if (group.size() < 2) return false;
+
+                const int axis = largestAxis(calculateBoundingBox(meshes, group).extent());
+                Group sorted = group;
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b)
+                    { return meshes[a].bounds.center()[axis] < meshes[b].bounds.center()[axis]; });
+
+                auto splitIter = sorted.begin() + sorted.size() / 2;
+                left.assign(sorted.begin(), splitIter);
+                right.assign(splitIter, sorted.end());
+                return true;
+            }
+
+            bool splitMedian(const std::vector<MeshInfo>& meshes, const Group& group, Group& left, Group& right)
+            {
+                if (group.size() < 2) return false;
+
+                // Sort the meshes by centroid along the largest axis.
+                const int axis = largestAxis(calculateBoundingBox(meshes, group).extent());
+                Group sorted = group;
+                std::stable_sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b)
+                    { return meshes[a].bounds.center()[axis] < meshes[b].bounds.center()[axis]; });
+
+                // Find the median mesh in terms of triangle count.
+                const size_t triangleCount = countTriangles(meshes, sorted);
+                size_t triangles = 0;
+                auto splitIter = std::find_if(sorted.begin(), sorted.end(), [&](uint32_t meshIndex)
+                    {
+                        triangles += meshes[meshIndex].triangleCount;
+                        return triangles > triangleCount / 2;
+                    });
+
+                // If all meshes ended up on either side, fall back on splitting at the middle mesh.
+                if (splitIter == sorted.begin() || splitIter == sorted.end()) splitIter = sorted.begin() + sorted.size() / 2;
+
+                left.assign(sorted.begin(), splitIter);
+                right.assign(splitIter, sorted.end());
+                return true;
+            }
+
+            bool splitMidpoint(const std::vector<MeshInfo>& meshes, const Group& group, Group& left, Group& right)
+            {
+                const AABB bb = calculateBoundingBox(meshes, group);
+                const int axis = largestAxis(bb.extent());
+                const float pos = bb.center()[axis];
+
+                left.clear();
+                right.clear();
+                for (uint32_t meshIndex : group)
+                {
+                    if (meshes[meshIndex].bounds.center()[axis] < pos) left.push_back(meshIndex);
+                    else right.push_back(meshIndex);
+                }
+                return !left.empty() && !right.empty();
+            }
+
+            bool splitSAH(const std::vector<MeshInfo>& meshes, const Group& group, Group& left, Group& right)
+            {
+                if (group.size() < 2) return false;
+
+                AABB centroidBounds;
+                for (uint32_t meshIndex : group) centroidBounds.include(meshes[meshIndex].bounds.center());
+                const float3 extent = centroidBounds.extent();
+
+                struct Bin
+                {
+                    AABB bounds;
+                    uint64_t triangleCount = 0;
+                    uint32_t meshCount = 0;
+                };
+
+                // Find the split with the lowest cost A(L) * N(L) + A(R) * N(R) over all axes.
+                // Since both sides are charged their full surface area, splits with overlapping sides are penalized.
+                float bestCost = std::numeric_limits<float>::infinity();
+                int bestAxis = -1;
+                uint32_t bestBin = 0;
+
+                auto binIndex = [&](uint32_t meshIndex, int axis)
+                {
+                    float t = (meshes[meshIndex].bounds.center()[axis] - centroidBounds.minPoint[axis]) / extent[axis];
+                    return std::min(uint32_t(t * kBinCount), kBinCount - 1);
+                };
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    if (!(extent[axis] > 0.f)) continue;
+
+                    std::array<Bin, kBinCount> bins;
+                    for (uint32_t meshIndex : group)
+                    {
+                        Bin& bin = bins[binIndex(meshIndex, axis)];
+                        bin.bounds.include(meshes[meshIndex].bounds);
+                        bin.triangleCount += meshes[meshIndex].triangleCount;
+                        bin.meshCount++;
+                    }
+
+                    // Sweep from the right to get the cost of the right side of each split plane.
+                    std::array<float, kBinCount> rightCost;
+                    std::array<uint32_t, kBinCount> rightMeshes;
+                    AABB rightBounds;
+                    uint64_t rightTriangles = 0;
+                    uint32_t rightMeshCount = 0;
+                    for (uint32_t i = kBinCount - 1; i > 0; i--)
+                    {
+                        rightBounds.include(bins[i].bounds);
+                        rightTriangles += bins[i].triangleCount;
+                        rightMeshCount += bins[i].meshCount;
+                        rightCost[i] = surfaceArea(rightBounds) * float(rightTriangles);
+                        rightMeshes[i] = rightMeshCount;
+                    }
+
+                    // Sweep from the left. Split i puts bins [0, i) on the left side.
+                    AABB leftBounds;
+                    uint64_t leftTriangles = 0;
+                    uint32_t leftMeshCount = 0;
+                    for (uint32_t i = 1; i < kBinCount; i++)
+                    {
+                        leftBounds.include(bins[i - 1].bounds);
+                        leftTriangles += bins[i - 1].triangleCount;
+                        leftMeshCount += bins[i - 1].meshCount;
+                        if (leftMeshCount == 0 || rightMeshes[i] == 0) continue;
+
+                        float cost = surfaceArea(leftBounds) * float(leftTriangles) + rightCost[i];
+                        if (cost < bestCost)
+                        {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestBin = i;
+                        }
+                    }
+                }
+
+                if (bestAxis >= 0)
+                {
+                    left.clear();
+                    right.clear();
+                    for (uint32_t meshIndex : group)
+                    {
+                        if (binIndex(meshIndex, bestAxis) < bestBin) left.push_back(meshIndex);
+                        else right.push_back(meshIndex);
+                    }
+                    if (!left.empty() && !right.empty()) return true;
+                }
+
+                // All centroids coincide, split in list order.
+                return splitMiddle(meshes, group, left, right);
+            }
+        }
+
+        std::vector<Group> partition(const std::vector<MeshInfo>& meshes, const Group& group, Strategy strategy, size_t maxTrianglesPerGroup)
+        {
+            FALCOR_CHECK(maxTrianglesPerGroup > 0, "Triangle limit must be positive.");
+            if (group.empty()) return {};
+            if (countTriangles(meshes, group) <= maxTrianglesPerGroup || group.size() == 1) return { group };
+
+            if (strategy == Strategy::Simple) return partitionSimple(meshes, group, maxTrianglesPerGroup);
+
+            Group left, right;
+            bool split = false;
+            switch (strategy)
+            {
+            case Strategy::Median: split = splitMedian(meshes, group, left, right); break;
+            case Strategy::Midpoint: split = splitMidpoint(meshes, group, left, right); break;
+            case Strategy::SAH: split = splitSAH(meshes, group, left, right); break;
+            default: FALCOR_UNREACHABLE();
+            }
+
+            // If the group cannot be split further, keep it as is.
+            if (!split) return { group };
+
+            std::vector<Group> groups = partition(meshes, left, strategy, maxTrianglesPerGroup);
+            append(groups, partition(meshes, right, strategy, maxTrianglesPerGroup));
+            return groups;
+        }
+
+        Stats evaluate(const std::vector<MeshInfo>& meshes, const std::vector<Group>& groups)
+        {
+            Stats stats;
+            stats.groupCount = groups.size();
+
+            std::vector<AABB> bounds(groups.size());
+            std::vector<uint64_t> triangleCounts(groups.size());
+            std::vector<uint32_t> instanceCounts(groups.size(), 1);
+            AABB sceneBounds;
+            uint64_t instanceCount = 0;
+
+            for (size_t i = 0; i < groups.size(); i++)
+            {
+                FALCOR_CHECK(!groups[i].empty(), "Groups must not be empty.");
+                bounds[i] = calculateBoundingBox(meshes, groups[i]);
+                triangleCounts[i] = countTriangles(meshes, groups[i]);
+                instanceCounts[i] = meshes[groups[i][0]].instanceCount;
+                sceneBounds.include(bounds[i]);
+
+                stats.triangleCount += triangleCounts[i];
+                stats.blasMemory += triangleCounts[i] * kBLASBytesPerTriangle;
+                stats.tlasMemory += instanceCounts[i] * kTLASBytesPerInstance;
+                instanceCount += instanceCounts[i];
+            }
+
+            // TLAS traversal followed by the BLASes a ray hits. Instances are assumed to have the size of the BLAS bounds.
+            const float sceneArea = surfaceArea(sceneBounds);
+            stats.traversalCost = std::log2(double(std::max<uint64_t>(instanceCount, 1))) + 1.0;
+            for (size_t i = 0; i < groups.size(); i++)
+            {
+                double hitProbability = sceneArea > 0.f ? std::min(1.0, double(surfaceArea(bounds[i])) / sceneArea) : 1.0;
+                double blasCost = std::log2(double(std::max<uint64_t>(triangleCounts[i], 1))) + 1.0;
+                stats.traversalCost += instanceCounts[i] * hitProbability * blasCost;
+            }
+
+            // Pairwise overlap of the group bounds.
+            double totalVolume = 0.0;
+            double overlapVolume = 0.0;
+            for (size_t i = 0; i < bounds.size(); i++)
+            {
+                totalVolume += bounds[i].valid() ? bounds[i].volume() : 0.f;
+                for (size_t j = i + 1; j < bounds.size(); j++)
+                {
+                    AABB overlap = bounds[i] & bounds[j];
+                    if (overlap.valid()) overlapVolume += overlap.volume();
+                }
+            }
+            stats.overlapRatio = totalVolume > 0.0 ? overlapVolume / totalVolume : 0.0;
+
+            return stats;
+        }
+    }
+}
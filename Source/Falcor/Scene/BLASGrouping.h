@@ -0,0 +1,92 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Strategies for partitioning the meshes of a mesh group into BLAS groups when the group exceeds
+        the per-BLAS triangle limit, and an offline evaluator to compare the resulting groupings.
+        All functions work on mesh bounding boxes and triangle counts only, so no GPU is required.
+    */
+    namespace BLASGrouping
+    {
+        enum class Strategy
+        {
+            Simple,     ///< Partition meshes in list order by triangle count.
+            Median,     ///< Recursively split at the median triangle count along the largest axis.
+            Midpoint,   ///< Recursively split at the midpoint of the largest axis, assigning meshes by centroid. Meshes are not split.
+            SAH,        ///< Recursively split at the binned SAH optimum over all axes.
+        };
+
+        /** Mesh description for grouping.
+        */
+        struct MeshInfo
+        {
+            AABB bounds;                    ///< Bounding box in the space of the BLAS.
+            uint32_t triangleCount = 0;     ///< Number of triangles.
+            uint32_t instanceCount = 1;     ///< Number of instances of the BLAS containing the mesh. Only used by evaluate().
+        };
+
+        using Group = std::vector<uint32_t>; ///< Indices into the mesh list.
+
+        /** Partition a group of meshes into groups of at most the given number of triangles.
+            Groups are split recursively until they are under the limit or contain a single mesh.
+            \param[in] meshes List of all meshes.
+            \param[in] group Indices of the meshes to partition.
+            \param[in] strategy Partitioning strategy.
+            \param[in] maxTrianglesPerGroup Triangle limit per group.
+            \return List of groups. The order of meshes within each group is deterministic.
+        */
+        FALCOR_API std::vector<Group> partition(const std::vector<MeshInfo>& meshes, const Group& group, Strategy strategy, size_t maxTrianglesPerGroup);
+
+        /** Estimated cost of a grouping.
+        */
+        struct Stats
+        {
+            size_t groupCount = 0;          ///< Number of BLASes.
+            uint64_t triangleCount = 0;     ///< Number of triangles over all BLASes.
+            uint64_t blasMemory = 0;        ///< Estimated BLAS memory in bytes. Instanced BLASes are counted once.
+            uint64_t tlasMemory = 0;        ///< Estimated TLAS memory in bytes (one entry per BLAS instance).
+            double traversalCost = 0.0;     ///< Estimated traversal cost per ray, in units of one BVH node visit.
+            double overlapRatio = 0.0;      ///< Pairwise overlap volume of the group bounding boxes relative to their total volume.
+        };
+
+        /** Estimate the ray traversal cost and memory of a grouping with the surface area heuristic.
+            A ray is assumed to hit each BLAS with probability proportional to its surface area relative to the bounds of
+            all groups. Hit BLASes cost a traversal proportional to their depth, so overlapping BLASes are traversed redundantly.
+            \param[in] meshes List of all meshes.
+            \param[in] groups Grouping to evaluate.
+            \return Estimated cost.
+        */
+        FALCOR_API Stats evaluate(const std::vector<MeshInfo>& meshes, const std::vector<Group>& groups);
+    }
+}
@@ -26,13 +26,79 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "EnvMap.h"
+#include "EnvMapCache.h"
 #include "Core/API/Device.h"
+#include "Core/API/RenderContext.h"
 #include "Core/Program/ShaderVar.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include "Utils/Math/Common.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "GlobalState.h"
+#include <algorithm>
+#include <execution>
+#include <optional>
 
 namespace Falcor
 {
+    namespace
+    {
+        // Host-side versions of the mappings used by EnvMapSamplerSetup.cs.slang (see Utils/Math/MathHelpers.slang).
+
+        float3 oct_to_ndir_equal_area_unorm(float2 p)
+        {
+            p = p * 2.f - 1.f;
+
+            float d = 1.f - (std::abs(p.x) + std::abs(p.y));
+            float r = 1.f - std::abs(d);
+
+            float phi = (r > 0.f) ? ((std::abs(p.y) - std::abs(p.x)) / r + 1.f) * (float)M_PI_4 : 0.f;
+
+            float f = r * std::sqrt(2.f - r * r);
+            float x = f * math::sign(p.x) * std::cos(phi);
+            float y = f * math::sign(p.y) * std::sin(phi);
+            float z = math::sign(d) * (1.f - r * r);
+
+            return float3(x, y, z);
+        }
+
+        float2 world_to_latlong_map(float3 dir)
+        {
+            float3 p = normalize(dir);
+            float2 uv;
+            uv.x = std::atan2(p.x, -p.z) * (float)(0.5 * M_1_PI) + 0.5f;
+            uv.y = std::acos(std::clamp(p.y, -1.f, 1.f)) * (float)M_1_PI;
+            return uv;
+        }
+
+        /** Bilinear lookup in a lat-long map of scalars, with the addressing modes of the env map sampler (wrap in U, clamp in V).
+        */
+        float sampleLatLongMap(const std::vector<float>& texels, uint32_t width, uint32_t height, float2 uv)
+        {
+            float x = uv.x * width - 0.5f;
+            float y = uv.y * height - 0.5f;
+            float x0 = std::floor(x);
+            float y0 = std::floor(y);
+            float fx = x - x0;
+            float fy = y - y0;
+
+            auto wrap = [width](int32_t i) { i %= (int32_t)width; return uint32_t(i < 0 ? i + (int32_t)width : i); };
+            auto clamp = [height](int32_t i) { return (uint32_t)std::clamp(i, 0, (int32_t)height - 1); };
+            uint32_t ix0 = wrap((int32_t)x0), ix1 = wrap((int32_t)x0 + 1);
+            const float* row0 = texels.data() + (size_t)clamp((int32_t)y0) * width;
+            const float* row1 = texels.data() + (size_t)clamp((int32_t)y0 + 1) * width;
+
+            float l0 = math::lerp(row0[ix0], row0[ix1], fx);
+            float l1 = math::lerp(row1[ix0], row1[ix1], fx);
+            return math::lerp(l0, l1, fy);
+        }
+    }
+
+    uint32_t EnvMap::ImportanceMap::getMipCount() const
+    {
+        return dimension > 0 ? (uint32_t)std::log2(dimension) + 1 : 0;
+    }
+
     ref<EnvMap> EnvMap::create(ref<Device> pDevice, const ref<Texture>& pTexture)
     {
         return ref<EnvMap>(new EnvMap(pDevice, pTexture));
@@ -86,6 +152,113 @@ namespace Falcor
         mData.tint = tint;
     }
 
+    const EnvMap::ImportanceMap& EnvMap::getImportanceMap(uint32_t dimension, uint32_t samples)
+    {
+        if (mImportanceMap.dimension == dimension && mImportanceMap.samples == samples) return mImportanceMap;
+
+        // Environment maps loaded from file are looked up in the env map cache, so the map is only built once per file.
+        std::optional<EnvMapCache::Key> cacheKey;
+        if (!mpEnvMap->getSourcePath().empty())
+        {
+            cacheKey = EnvMapCache::getKey(mpEnvMap->getSourcePath(), mpEnvMap->getFormat(), dimension, samples);
+            if (cacheKey && EnvMapCache::instance().read(*cacheKey, mImportanceMap)) return mImportanceMap;
+        }
+
+        // Read back the base level as RGBA32Float. Blitting first handles all texture formats, including compressed ones.
+        RenderContext* pRenderContext = mpDevice->getRenderContext();
+        uint32_t width = mpEnvMap->getWidth();
+        uint32_t height = mpEnvMap->getHeight();
+        ref<Texture> pTexels = mpDevice->createTexture2D(width, height, ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
+        pRenderContext->blit(mpEnvMap->getSRV(0, 1, 0, 1), pTexels->getRTV(0, 0, 1));
+        std::vector<uint8_t> texels = pRenderContext->readTextureSubresource(pTexels.get(), 0);
+        FALCOR_ASSERT(texels.size() == (size_t)width * height * sizeof(float4));
+
+        mImportanceMap = computeImportanceMap(reinterpret_cast<const float4*>(texels.data()), width, height, dimension, samples);
+        if (cacheKey) EnvMapCache::instance().write(*cacheKey, mImportanceMap);
+        return mImportanceMap;
+    }
+
+    EnvMap::ImportanceMap EnvMap::computeImportanceMap(const float4* pTexels, uint32_t width, uint32_t height, uint32_t dimension, uint32_t samples)
+    {
+        FALCOR_CHECK(pTexels != nullptr && width > 0 && height > 0, "Invalid environment map texels");
+        FALCOR_CHECK(isPowerOf2(dimension) && dimension > 1 && dimension <= 2048, "'dimension' ({}) must be a power of two in [2,2048]", dimension);
+        FALCOR_CHECK(isPowerOf2(samples), "'samples' ({}) must be a power of two", samples);
+
+        // Bilinear filtering is linear, so filtering the luminance is equivalent to taking the luminance of the filtered radiance.
+        std::vector<float> luminances((size_t)width * height);
+        std::for_each(
+            std::execution::par,
+            NumericRange<size_t>(0, luminances.size()).begin(),
+            NumericRange<size_t>(0, luminances.size()).end(),
+            [&](size_t i) { luminances[i] = luminance(pTexels[i].xyz()); }
+        );
+
+        const uint32_t samplesX = std::max(1u, (uint32_t)std::sqrt(samples));
+        const uint32_t samplesY = samples / samplesX;
+        FALCOR_ASSERT(samples == samplesX * samplesY);
+        const float2 outputDimInSamples = float2(float(dimension * samplesX), float(dimension * samplesY));
+        const float invSamples = 1.f / (samplesX * samplesY);
+
+        ImportanceMap importanceMap;
+        importanceMap.dimension = dimension;
+        importanceMap.samples = samples;
+
+        size_t texelCount = 0;
+        for (uint32_t mip = 0; mip < importanceMap.getMipCount(); mip++) texelCount += size_t(dimension >> mip) * (dimension >> mip);
+        importanceMap.data.resize(texelCount);
+
+        // Compute the base mip. Each texel is the average luminance over a regular grid of samples in the octahedral map.
+        float* pBase = importanceMap.data.data();
+        std::for_each(
+            std::execution::par,
+            NumericRange<uint32_t>(0, dimension).begin(),
+            NumericRange<uint32_t>(0, dimension).end(),
+            [&](uint32_t py)
+            {
+                for (uint32_t px = 0; px < dimension; px++)
+                {
+                    float L = 0.f;
+                    for (uint32_t y = 0; y < samplesY; y++)
+                    {
+                        for (uint32_t x = 0; x < samplesX; x++)
+                        {
+                            float2 samplePos = float2(float(px * samplesX + x), float(py * samplesY + y));
+                            float2 p = (samplePos + 0.5f) / outputDimInSamples;
+                            float2 uv = world_to_latlong_map(oct_to_ndir_equal_area_unorm(p));
+                            L += sampleLatLongMap(luminances, width, height, uv);
+                        }
+                    }
+                    pBase[(size_t)py * dimension + px] = L * invSamples;
+                }
+            }
+        );
+
+        // Compute the mip hierarchy by averaging 2x2 texels, which is what mip generation on the GPU does for power-of-two sizes.
+        float* pSrc = pBase;
+        for (uint32_t srcDim = dimension; srcDim > 1; srcDim /= 2)
+        {
+            const uint32_t dstDim = srcDim / 2;
+            float* pDst = pSrc + (size_t)srcDim * srcDim;
+            std::for_each(
+                std::execution::par,
+                NumericRange<uint32_t>(0, dstDim).begin(),
+                NumericRange<uint32_t>(0, dstDim).end(),
+                [&](uint32_t y)
+                {
+                    const float* row0 = pSrc + (size_t)(2 * y) * srcDim;
+                    const float* row1 = row0 + srcDim;
+                    for (uint32_t x = 0; x < dstDim; x++)
+                    {
+                        pDst[(size_t)y * dstDim + x] = 0.25f * (row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1]);
+                    }
+                }
+            );
+            pSrc = pDst;
+        }
+
+        return importanceMap;
+    }
+
     void EnvMap::bindShaderData(const ShaderVar& var) const
     {
         FALCOR_ASSERT(var.isValid());
@@ -35,6 +35,7 @@
 #include "Utils/UI/Gui.h"
 #include <memory>
 #include <filesystem>
+#include <vector>
 
 namespace Falcor
 {
@@ -47,6 +48,22 @@ namespace Falcor
     {
         FALCOR_OBJECT(EnvMap)
     public:
+        /** Hierarchical importance map for sampling the environment map (see EnvMapSampler).
+            The base mip stores the average luminance over the texels of an equal-area octahedral map
+            of dimension x dimension texels. The coarser mips are 2x2 averages down to a single texel.
+        */
+        struct ImportanceMap
+        {
+            uint32_t dimension = 0;     ///< Resolution of the base mip in texels (power of two), or zero if not built.
+            uint32_t samples = 0;       ///< Number of luminance samples per texel of the base mip (power of two).
+            std::vector<float> data;    ///< Average luminance per texel for all mips, base mip first.
+
+            uint32_t getMipCount() const;
+        };
+
+        static constexpr uint32_t kDefaultImportanceMapDimension = 512;
+        static constexpr uint32_t kDefaultImportanceMapSamples = 64;
+
         virtual ~EnvMap() = default;
 
         /** Create a new environment map.
@@ -102,6 +119,28 @@ namespace Falcor
         const ref<Texture>& getEnvMap() const { return mpEnvMap; }
         const ref<Sampler>& getEnvSampler() const { return mpEnvSampler; }
 
+        /** Get the importance map for sampling the environment map.
+            The map is built on the CPU on first use and cached with the environment map and in the scene cache.
+            Maps of environment maps loaded from file are also stored in the on-disk EnvMapCache, so they are
+            only built once per file, also across scenes and processes.
+            \param[in] dimension Resolution of the base mip in texels (power of two).
+            \param[in] samples Number of luminance samples per texel of the base mip (power of two).
+            \return The importance map.
+        */
+        const ImportanceMap& getImportanceMap(uint32_t dimension = kDefaultImportanceMapDimension, uint32_t samples = kDefaultImportanceMapSamples);
+
+        /** Build an importance map from environment map texels.
+            This computes the same map as the GPU setup pass in EnvMapSampler, without requiring a device.
+            The env map is sampled with bilinear filtering, wrapping horizontally and clamping vertically.
+            \param[in] pTexels Environment map texels in lat-long layout (RGB(A) radiance, row-major, width x height).
+            \param[in] width Width of the environment map in texels.
+            \param[in] height Height of the environment map in texels.
+            \param[in] dimension Resolution of the base mip in texels (power of two).
+            \param[in] samples Number of luminance samples per texel of the base mip (power of two).
+            \return The importance map.
+        */
+        static ImportanceMap computeImportanceMap(const float4* pTexels, uint32_t width, uint32_t height, uint32_t dimension, uint32_t samples);
+
         /** Bind the environment map to a given shader variable.
             \param[in] var Shader variable.
         */
@@ -138,6 +177,8 @@ namespace Falcor
 
         float3                  mRotation = { 0.f, 0.f, 0.f };
 
+        ImportanceMap           mImportanceMap;     ///< Cached importance map.
+
         Changes                 mChanges = Changes::None;
 
         friend class Scene;
@@ -0,0 +1,339 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "EnvMapCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specifies the current env map cache file version.
+            This needs to be incremented every time the file format or the importance map computation changes!
+        */
+        const uint32_t kVersion = 1;
+
+        /** Env map cache directory (subdirectory in the application data directory).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/EnvMapCache";
+
+        const char* kMagic = "FalcorE$";
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+
+            bool isValid() const
+            {
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+            }
+        };
+
+        bool isEntry(const std::filesystem::directory_entry& entry)
+        {
+            // Skip temporary files of writes in progress.
+            std::error_code ec;
+            return entry.is_regular_file(ec) && !entry.path().has_extension();
+        }
+    }
+
+    EnvMapCache& EnvMapCache::instance()
+    {
+        static EnvMapCache sInstance;
+        return sInstance;
+    }
+
+    EnvMapCache::EnvMapCache()
+        : mDirectory(getAppDataDirectory() / kDirectory)
+    {}
+
+    std::optional<EnvMapCache::Key> EnvMapCache::getKey(const std::filesystem::path& path, ResourceFormat format, uint32_t dimension, uint32_t samples)
+    {
+        // The key covers the file content, so that copies of the same environment map share an entry.
+        std::ifstream fs(path, std::ios_base::binary);
+        if (!fs.good()) return {};
+
+        SHA1 sha1;
+        sha1.update(kVersion);
+        sha1.update((uint32_t)format);
+        sha1.update(dimension);
+        sha1.update(samples);
+        std::vector<char> buffer(1 << 20);
+        while (fs)
+        {
+            fs.read(buffer.data(), buffer.size());
+            sha1.update(buffer.data(), (size_t)fs.gcount());
+        }
+        if (fs.bad()) return {};
+        return sha1.finalize();
+    }
+
+    void EnvMapCache::setDirectory(const std::filesystem::path& directory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDirectory = directory;
+        mSize.reset();
+    }
+
+    std::filesystem::path EnvMapCache::getDirectory() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory;
+    }
+
+    void EnvMapCache::setMaxSize(uint64_t maxSize)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxSize = maxSize;
+    }
+
+    uint64_t EnvMapCache::getMaxSize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mMaxSize;
+    }
+
+    bool EnvMapCache::read(const Key& key, EnvMap::ImportanceMap& importanceMap)
+    {
+        auto entryPath = getEntryPath(key);
+
+        auto miss = [&]()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.misses++;
+            return false;
+        };
+
+        std::error_code ec;
+        const uint64_t fileSize = std::filesystem::file_size(entryPath, ec);
+        if (ec) return miss();
+
+        std::ifstream fs(entryPath, std::ios_base::binary);
+        if (!fs.good()) return miss();
+
+        Header header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!fs.good() || !header.isValid()) return miss();
+
+        EnvMap::ImportanceMap result;
+        uint64_t size = 0;
+        fs.read(reinterpret_cast<char*>(&result.dimension), sizeof(result.dimension));
+        fs.read(reinterpret_cast<char*>(&result.samples), sizeof(result.samples));
+        fs.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!fs.good() || size > fileSize / sizeof(float)) return miss();
+
+        // Validate the size against the mip chain, so that a truncated or corrupt entry is never used.
+        size_t texelCount = 0;
+        for (uint32_t mip = 0; mip < result.getMipCount(); mip++) texelCount += size_t(result.dimension >> mip) * (result.dimension >> mip);
+        if (texelCount == 0 || size != texelCount) return miss();
+
+        result.data.resize(size);
+        fs.read(reinterpret_cast<char*>(result.data.data()), size * sizeof(float));
+        if (!fs.good())
+        {
+            logWarning("Failed to read env map cache file '{}'.", entryPath);
+            return miss();
+        }
+        fs.close();
+
+        importanceMap = std::move(result);
+
+        // Mark the entry as recently used.
+        std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.hits++;
+        mStats.bytesRead += fileSize;
+        return true;
+    }
+
+    void EnvMapCache::write(const Key& key, const EnvMap::ImportanceMap& importanceMap)
+    {
+        auto entryPath = getEntryPath(key);
+
+        std::error_code ec;
+        std::filesystem::create_directories(entryPath.parent_path(), ec);
+
+        // Write to a temporary file first, the same env map may be written from multiple threads or processes.
+        std::ostringstream suffix;
+        suffix << ".tmp" << std::this_thread::get_id();
+        std::filesystem::path tmpPath = entryPath;
+        tmpPath += suffix.str();
+
+        {
+            std::ofstream fs(tmpPath, std::ios_base::binary);
+            if (!fs.good())
+            {
+                logWarning("Failed to create env map cache file '{}'.", tmpPath);
+                return;
+            }
+
+            Header header;
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = kVersion;
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            uint64_t size = importanceMap.data.size();
+            fs.write(reinterpret_cast<const char*>(&importanceMap.dimension), sizeof(importanceMap.dimension));
+            fs.write(reinterpret_cast<const char*>(&importanceMap.samples), sizeof(importanceMap.samples));
+            fs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            fs.write(reinterpret_cast<const char*>(importanceMap.data.data()), size * sizeof(float));
+            if (!fs.good())
+            {
+                logWarning("Failed to write env map cache file '{}'.", tmpPath);
+                fs.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+
+        const uint64_t fileSize = std::filesystem::file_size(tmpPath, ec);
+        std::filesystem::rename(tmpPath, entryPath, ec);
+        if (ec)
+        {
+            logWarning("Failed to write env map cache file '{}': {}", entryPath, ec.message());
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.writes++;
+        mStats.bytesWritten += fileSize;
+
+        if (!mSize)
+        {
+            // Scan the cache directory on the first write (this includes the entry just written).
+            trimLocked(mMaxSize);
+        }
+        else
+        {
+            *mSize += fileSize;
+            if (*mSize > mMaxSize) trimLocked(mMaxSize);
+        }
+    }
+
+    void EnvMapCache::trim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(mMaxSize);
+    }
+
+    void EnvMapCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(0);
+    }
+
+    EnvMapCache::Stats EnvMapCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void EnvMapCache::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats = {};
+    }
+
+    std::filesystem::path EnvMapCache::getEntryPath(const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory / SHA1::toString(key);
+    }
+
+    void EnvMapCache::trimLocked(uint64_t maxSize)
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+
+        std::error_code ec;
+        for (const auto& it : std::filesystem::directory_iterator(mDirectory, ec))
+        {
+            if (!isEntry(it)) continue;
+            Entry entry{ it.path(), it.last_write_time(ec), it.file_size(ec) };
+            if (ec) continue;
+            totalSize += entry.size;
+            entries.push_back(std::move(entry));
+        }
+
+        // Evict the least recently used entries first.
+        if (totalSize > maxSize)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+            for (const auto& entry : entries)
+            {
+                if (totalSize <= maxSize) break;
+                if (std::filesystem::remove(entry.path, ec))
+                {
+                    totalSize -= entry.size;
+                    mStats.evictions++;
+                }
+            }
+        }
+
+        mSize = totalSize;
+    }
+
+    FALCOR_SCRIPT_BINDING(EnvMapCache)
+    {
+        pybind11::class_<EnvMapCache> envMapCache(m, "EnvMapCache");
+        envMapCache.def_static("instance", &EnvMapCache::instance, pybind11::return_value_policy::reference);
+        envMapCache.def_property("directory", &EnvMapCache::getDirectory, &EnvMapCache::setDirectory);
+        envMapCache.def_property("max_size", &EnvMapCache::getMaxSize, &EnvMapCache::setMaxSize);
+        envMapCache.def_property_readonly("stats", [](const EnvMapCache& self)
+        {
+            auto stats = self.getStats();
+            pybind11::dict d;
+            d["hits"] = stats.hits;
+            d["misses"] = stats.misses;
+            d["writes"] = stats.writes;
+            d["evictions"] = stats.evictions;
+            d["bytes_read"] = stats.bytesRead;
+            d["bytes_written"] = stats.bytesWritten;
+            d["hit_rate"] = stats.getHitRate();
+            return d;
+        });
+        envMapCache.def("reset_stats", &EnvMapCache::resetStats);
+        envMapCache.def("trim", &EnvMapCache::trim);
+        envMapCache.def("clear", &EnvMapCache::clear);
+    }
+}
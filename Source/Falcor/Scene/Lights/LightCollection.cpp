@@ -31,10 +31,17 @@
 #include "Scene/Scene.h"
 #include "Scene/Material/BasicMaterial.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Color/ColorHelpers.slang"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Timing/Profiler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <execution>
 #include <fstream>
+#include <map>
+#include <numeric>
 
 namespace Falcor
 {
@@ -48,9 +55,258 @@ namespace Falcor
         const char kBuildTriangleListFile[] = "Scene/Lights/BuildTriangleList.cs.slang";
         const char kUpdateTriangleVerticesFile[] = "Scene/Lights/UpdateTriangleVertices.cs.slang";
         const char kFinalizeIntegrationFile[] = "Scene/Lights/FinalizeIntegration.cs.slang";
+
+        // Host-side versions of the clipping helpers in Utils/Geometry/GeometryHelpers.slang.
+
+        int classifyPointPlane2D(const float2 p, const uint32_t axis, const float sign, const float c, const float planeThickness = 1e-6f)
+        {
+            float d = sign * (p[axis] - c);
+            if (d > planeThickness) return 1;
+            else if (d < -planeThickness) return -1;
+            else return 0;
+        }
+
+        void clipPolygonPlane2D(float2 p[7], uint32_t& n, const uint32_t axis, const float sign, const float c)
+        {
+            if (n <= 1)
+            {
+                n = 0;
+                return;
+            }
+
+            float2 q[7];
+            uint32_t k = 0;
+            bool fullyOnPlane = true;
+
+            float2 p1 = p[n - 1];
+            int d1 = classifyPointPlane2D(p1, axis, sign, c);
+
+            // Iterate over all polygon edges (p1,p2) in order.
+            for (uint32_t i = 0; i < n; i++)
+            {
+                float2 p2 = p[i];
+                int d2 = classifyPointPlane2D(p2, axis, sign, c);
+
+                if (d2 == 0) // p2 lies on the plane
+                {
+                    if (d1 != 0) q[k++] = p2;
+                }
+                else // p2 is on either side
+                {
+                    fullyOnPlane = false;
+
+                    if (d1 == 0) // p1 lies on the plane
+                    {
+                        if (k == 0 || any(q[k - 1] != p1)) q[k++] = p1;
+                    }
+                    else if (d1 != d2) // p1 and p2 are on opposite sides => clip
+                    {
+                        float alpha = (p2[axis] - c) / (p2[axis] - p1[axis]);
+                        q[k++] = math::lerp(p2, p1, float2(alpha));
+                    }
+
+                    if (d2 > 0) q[k++] = p2;
+                }
+
+                p1 = p2;
+                d1 = d2;
+            }
+
+            if (fullyOnPlane) return;
+
+            n = k;
+            for (uint32_t i = 0; i < k; i++) p[i] = q[i];
+        }
+
+        float computeClippedTriangleArea2D(const float2 pos[3], const float2 minPoint, const float2 maxPoint)
+        {
+            // Clip triangle to axis-aligned box.
+            uint32_t n = 3;
+            float2 p[7] = {};
+
+            p[0] = pos[0];
+            p[1] = pos[1];
+            p[2] = pos[2];
+
+            clipPolygonPlane2D(p, n, 0, +1.f, minPoint.x);
+            clipPolygonPlane2D(p, n, 0, -1.f, maxPoint.x);
+            clipPolygonPlane2D(p, n, 1, +1.f, minPoint.y);
+            clipPolygonPlane2D(p, n, 1, -1.f, maxPoint.y);
+
+            if (n < 3) return 0.f;
+
+            // Compute area of convex polygon.
+            float area = 0.f;
+            for (uint32_t i = 0; i < n; i++)
+            {
+                uint32_t j = i + 1 < n ? i + 1 : 0;
+                area += p[i].x * p[j].y - p[i].y * p[j].x;
+            }
+
+            return 0.5f * area;
+        }
+
+        int32_t applyAddressMode(int32_t i, int32_t n, TextureAddressingMode mode)
+        {
+            switch (mode)
+            {
+            case TextureAddressingMode::Wrap:
+                i %= n;
+                return i < 0 ? i + n : i;
+            case TextureAddressingMode::Mirror:
+            {
+                int32_t m = i % (2 * n);
+                if (m < 0) m += 2 * n;
+                return m < n ? m : 2 * n - 1 - m;
+            }
+            case TextureAddressingMode::MirrorOnce:
+                return std::min(i < 0 ? -1 - i : i, n - 1);
+            case TextureAddressingMode::Border:
+                return i >= 0 && i < n ? i : -1;
+            case TextureAddressingMode::Clamp:
+            default:
+                return std::clamp(i, 0, n - 1);
+            }
+        }
+
+        std::vector<LightCollection::EmissiveTexture> readEmissiveTextures(RenderContext* pRenderContext, Device* pDevice, const std::vector<ref<Texture>>& textures, const Sampler* pSampler)
+        {
+            // Blit the finest mip of each texture to RGBA32Float, which handles all texture formats including compressed ones,
+            // and record the readbacks. The data is fetched after all readbacks are submitted, so we wait for the GPU once.
+            std::vector<ref<Texture>> texels(textures.size());
+            std::vector<CopyContext::ReadTextureTask::SharedPtr> readTasks(textures.size());
+            for (size_t i = 0; i < textures.size(); i++)
+            {
+                const Texture* pTexture = textures[i].get();
+                texels[i] = pDevice->createTexture2D(pTexture->getWidth(), pTexture->getHeight(), ResourceFormat::RGBA32Float, 1, 1, nullptr, ResourceBindFlags::RenderTarget | ResourceBindFlags::ShaderResource);
+                pRenderContext->blit(pTexture->getSRV(0, 1, 0, 1), texels[i]->getRTV(0, 0, 1));
+                readTasks[i] = pRenderContext->asyncReadTextureSubresource(texels[i].get(), 0);
+            }
+
+            std::vector<LightCollection::EmissiveTexture> result(textures.size());
+            for (size_t i = 0; i < textures.size(); i++)
+            {
+                LightCollection::EmissiveTexture& texture = result[i];
+                texture.width = textures[i]->getWidth();
+                texture.height = textures[i]->getHeight();
+                if (pSampler)
+                {
+                    texture.addressModeU = pSampler->getAddressModeU();
+                    texture.addressModeV = pSampler->getAddressModeV();
+                }
+
+                std::vector<uint8_t> data = readTasks[i]->getData();
+                FALCOR_ASSERT(data.size() == (size_t)texture.width * texture.height * sizeof(float4));
+
+                const float4* pData = reinterpret_cast<const float4*>(data.data());
+                texture.texels.resize((size_t)texture.width * texture.height);
+                for (size_t j = 0; j < texture.texels.size(); j++) texture.texels[j] = pData[j].xyz();
+            }
+            return result;
+        }
+
+        /** Packs the GPU data of a range of mesh light triangles.
+        */
+        void packTriangles(const std::vector<LightCollection::MeshLightTriangle>& triangles, const std::vector<MeshLightData>& meshLights, uint32_t triangleOffset, uint32_t triangleCount, PackedEmissiveTriangle* pTriangleData, EmissiveFlux* pFluxData)
+        {
+            for (uint32_t i = 0; i < triangleCount; i++)
+            {
+                const LightCollection::MeshLightTriangle& tri = triangles[triangleOffset + i];
+                FALCOR_ASSERT(tri.lightIdx < meshLights.size());
+
+                EmissiveTriangle emissiveTri;
+                for (uint32_t j = 0; j < 3; j++)
+                {
+                    emissiveTri.posW[j] = tri.vtx[j].pos;
+                    emissiveTri.texCoords[j] = tri.vtx[j].uv;
+                }
+                emissiveTri.normal = tri.normal;
+                emissiveTri.area = tri.area;
+                emissiveTri.materialID = meshLights[tri.lightIdx].materialID;
+                emissiveTri.lightIdx = tri.lightIdx;
+                pTriangleData[i].pack(emissiveTri);
+
+                pFluxData[i].flux = tri.flux;
+                pFluxData[i].averageRadiance = tri.averageRadiance;
+            }
+        }
     }
 
-    LightCollection::LightCollection(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene)
+    float3 LightCollection::EmissiveTexture::fetch(int32_t x, int32_t y) const
+    {
+        FALCOR_ASSERT(width > 0 && height > 0);
+        x = applyAddressMode(x, (int32_t)width, addressModeU);
+        y = applyAddressMode(y, (int32_t)height, addressModeV);
+        if (x < 0 || y < 0) return float3(0.f);
+        return texels[(size_t)y * width + x];
+    }
+
+    float3 LightCollection::EmissiveTexture::sample(float2 uv) const
+    {
+        return fetch((int32_t)std::floor(uv.x * width), (int32_t)std::floor(uv.y * height));
+    }
+
+    float3 LightCollection::integrateEmissiveTexture(const EmissiveTexture& texture, const float2 texCoords[3])
+    {
+        FALCOR_ASSERT(texture.width > 0 && texture.height > 0);
+        const float2 dim = float2((float)texture.width, (float)texture.height);
+
+        // Place the triangle in texture space with one unit per texel. As in the GPU integrator,
+        // the texture coordinates are offset by an integer amount so that they are always positive.
+        const float2 uvOffset = floor(min(min(texCoords[0], texCoords[1]), texCoords[2]));
+        float2 vtx[3];
+        for (uint32_t i = 0; i < 3; i++) vtx[i] = (texCoords[i] - uvOffset) * dim;
+
+        const float2 pMin = min(min(vtx[0], vtx[1]), vtx[2]);
+        const float2 pMax = max(max(vtx[0], vtx[1]), vtx[2]);
+        const int32_t x0 = (int32_t)std::floor(pMin.x), x1 = std::max((int32_t)std::ceil(pMax.x), x0 + 1);
+        const int32_t y0 = (int32_t)std::floor(pMin.y), y1 = std::max((int32_t)std::ceil(pMax.y), y0 + 1);
+        const int2 texelOffset = int2(uvOffset * dim);
+
+        // Edge functions for detecting texels that are fully covered, which skips the clipping for interior texels.
+        const float orientation = (vtx[1].x - vtx[0].x) * (vtx[2].y - vtx[0].y) - (vtx[1].y - vtx[0].y) * (vtx[2].x - vtx[0].x) < 0.f ? -1.f : 1.f;
+        auto isInside = [&](float2 p)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                const float2 a = vtx[i], b = vtx[(i + 1) % 3];
+                if (orientation * ((b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)) < 0.f) return false;
+            }
+            return true;
+        };
+
+        // Sum up the texels weighted by coverage. We accumulate in double precision to avoid large accumulated errors.
+        double texelSum[3] = { 0.0, 0.0, 0.0 };
+        double weightSum = 0.0;
+        for (int32_t y = y0; y < y1; y++)
+        {
+            for (int32_t x = x0; x < x1; x++)
+            {
+                const float2 texelMin = float2((float)x, (float)y);
+                const float2 texelMax = texelMin + 1.f;
+
+                float weight = 1.f;
+                if (!(isInside(texelMin) && isInside(texelMax) && isInside(float2(texelMin.x, texelMax.y)) && isInside(float2(texelMax.x, texelMin.y))))
+                {
+                    weight = std::min(std::abs(computeClippedTriangleArea2D(vtx, texelMin, texelMax)), 1.f); // The area may be negative due to winding.
+                    if (weight <= 0.f) continue;
+                }
+
+                const float3 texel = texture.fetch(x + texelOffset.x, y + texelOffset.y);
+                for (uint32_t i = 0; i < 3; i++) texelSum[i] += (double)texel[i] * weight;
+                weightSum += weight;
+            }
+        }
+
+        if (weightSum > 0.0) return float3((float)(texelSum[0] / weightSum), (float)(texelSum[1] / weightSum), (float)(texelSum[2] / weightSum));
+
+        // The triangle is degenerate in texture space (line or point).
+        float3 averageColor = float3(0.f);
+        for (uint32_t i = 0; i < 3; i++) averageColor += texture.sample(texCoords[i]);
+        return averageColor / 3.f;
+    }
+
+    LightCollection::LightCollection(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene, bool allowBuildOnCPU)
         : mpDevice(pDevice)
         , mpScene(pScene)
     {
@@ -58,10 +314,12 @@ namespace Falcor
 
         // Setup the lights.
         setupMeshLights(*mpScene);
+        mBuildOnCPU = allowBuildOnCPU && canBuildOnCPU(*mpScene);
+        if (mBuildOnCPU) mpUploadBatcher = std::make_unique<UploadBatcher>(mpDevice);
 
         // Create program for integrating emissive textures.
         // This should be done after lights are setup, so that we know which sampler state etc. to use.
-        initIntegrator(pRenderContext, *mpScene);
+        if (!mBuildOnCPU) initIntegrator(pRenderContext, *mpScene);
 
         // Create programs for building/updating the mesh lights.
         DefineList defines = mpScene->getSceneDefines();
@@ -87,8 +345,9 @@ namespace Falcor
 
         // Update transform matrices and check for updates.
         // TODO: Move per-mesh instance update flags into Scene. Return just a list of mesh lights that have changed.
-        std::vector<uint32_t> updatedLights;
-        updatedLights.reserve(mMeshLights.size());
+        std::vector<uint32_t>& updatedLights = mUpdatedLights;
+        std::vector<UpdateFlags> updatedLightFlags;
+        updatedLights.clear();
 
         for (uint32_t lightIdx = 0; lightIdx < mMeshLights.size(); ++lightIdx)
         {
@@ -98,15 +357,33 @@ namespace Falcor
             // Check if instance transform changed.
             if (mpScene->getAnimationController()->isMatrixChanged(NodeID{ instanceData.globalMatrixID })) updateFlags |= UpdateFlags::MatrixChanged;
 
+            // Check if the emissive material changed. Only the CPU build updates the emission after the initial build.
+            if (mBuildOnCPU && is_set(mpScene->getMaterialSystem().getMaterialUpdates(MaterialID::fromSlang(mMeshLights[lightIdx].materialID)), Material::UpdateFlags::EmissiveChanged))
+            {
+                updateFlags |= UpdateFlags::EmissiveChanged;
+            }
+
             // Store update status.
-            if (updateFlags != UpdateFlags::None) updatedLights.push_back(lightIdx);
+            if (updateFlags != UpdateFlags::None)
+            {
+                updatedLights.push_back(lightIdx);
+                updatedLightFlags.push_back(updateFlags);
+            }
             if (pUpdateStatus) pUpdateStatus->lightsUpdateInfo.push_back(updateFlags);
         }
 
         // Update light data if needed.
         if (!updatedLights.empty())
         {
-            updateTrianglePositions(pRenderContext, *mpScene, updatedLights);
+            if (mBuildOnCPU)
+            {
+                bool activeChanged = updateMeshLightsOnCPU(pRenderContext, *mpScene, updatedLights, updatedLightFlags);
+                uploadMeshLightData(pRenderContext, updatedLights);
+
+                // Triangles that started or stopped emitting need to be added to or removed from the active list.
+                if (activeChanged) updateActiveTriangleList(pRenderContext);
+            }
+            else updateTrianglePositions(pRenderContext, *mpScene, updatedLights);
             return true;
         }
 
@@ -230,6 +507,24 @@ namespace Falcor
             mStagingBufferValid = true;
             mStatsValid = true;
         }
+        else if (mBuildOnCPU)
+        {
+            TimeReport timeReport;
+
+            // Build the triangle list and pre-integrate the emissive triangles on the CPU.
+            // The CPU data is valid right away and the GPU buffers are created from it, so no readback is needed.
+            buildOnCPU(pRenderContext, scene);
+            timeReport.measure("LightCollection::build on CPU");
+
+            mCPUInvalidData = CPUOutOfDateFlags::None;
+            mStagingBufferValid = true;
+            mStatsValid = false;
+
+            updateActiveTriangleList(pRenderContext);
+
+            timeReport.measure("LightCollection::build finalize");
+            timeReport.printToLog();
+        }
         else
         {
             TimeReport timeReport;
@@ -491,9 +786,8 @@ namespace Falcor
     void LightCollection::updateActiveTriangleList(RenderContext* pRenderContext)
     {
         // This function updates the list of active (non-culled) triangles based on the pre-integrated flux.
-        // We currently run this as part of initialization. To support animated emissive textures and/or
-        // dynamically changing emissive intensities, it should be run as part of update().
-        // In that case, we may want to move it to the GPU to avoid syncing the data to the CPU first.
+        // We run this as part of initialization, and as part of update() with the CPU build if a triangle's flux
+        // changed between zero and non-zero. The GPU build does not update the flux after initialization.
 
         // Read back the current data. This is potentially expensive.
         syncCPUData(pRenderContext);
@@ -571,6 +865,183 @@ namespace Falcor
         mStagingBufferValid = false;
     }
 
+    bool LightCollection::canBuildOnCPU(const Scene& scene) const
+    {
+        for (const auto& meshLight : mMeshLights)
+        {
+            const GeometryInstanceData& instanceData = scene.getGeometryInstance(meshLight.instanceID);
+            if (!scene.getEmissiveMeshGeometry(MeshID::fromSlang(instanceData.geometryID))) return false;
+        }
+        return true;
+    }
+
+    void LightCollection::buildOnCPU(RenderContext* pRenderContext, const Scene& scene)
+    {
+        FALCOR_ASSERT(mTriangleCount > 0);
+
+        mMeshLightTriangles.assign(mTriangleCount, MeshLightTriangle());
+        mTriangleEmissiveColor.assign(mTriangleCount, float3(0.f));
+        mEmissiveTextures.assign(mMeshLights.size(), nullptr);
+
+        std::vector<uint32_t> lights(mMeshLights.size());
+        std::iota(lights.begin(), lights.end(), 0u);
+        std::vector<UpdateFlags> updateFlags(mMeshLights.size(), UpdateFlags::MatrixChanged | UpdateFlags::EmissiveChanged);
+        updateMeshLightsOnCPU(pRenderContext, scene, lights, updateFlags);
+
+        // Create the GPU buffers with the data of all triangles.
+        std::vector<PackedEmissiveTriangle> triangleData(mTriangleCount);
+        std::vector<EmissiveFlux> fluxData(mTriangleCount);
+        packTriangles(mMeshLightTriangles, mMeshLights, 0, mTriangleCount, triangleData.data(), fluxData.data());
+
+        mpTriangleData = mpDevice->createStructuredBuffer(mpTriangleListBuilder->getRootVar()["gTriangleData"], mTriangleCount, ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, MemoryType::DeviceLocal, triangleData.data(), false);
+        mpTriangleData->setName("LightCollection::mpTriangleData");
+        if (mpTriangleData->getStructSize() != sizeof(PackedEmissiveTriangle)) FALCOR_THROW("Struct PackedEmissiveTriangle size mismatch between CPU/GPU");
+
+        mpFluxData = mpDevice->createStructuredBuffer(mpFinalizeIntegration->getRootVar()["gFluxData"], mTriangleCount, ResourceBindFlags::ShaderResource | ResourceBindFlags::UnorderedAccess, MemoryType::DeviceLocal, fluxData.data(), false);
+        mpFluxData->setName("LightCollection::mpFluxData");
+        if (mpFluxData->getStructSize() != sizeof(EmissiveFlux)) FALCOR_THROW("Struct EmissiveFlux size mismatch between CPU/GPU");
+    }
+
+    bool LightCollection::updateMeshLightsOnCPU(RenderContext* pRenderContext, const Scene& scene, const std::vector<uint32_t>& updatedLights, const std::vector<UpdateFlags>& updateFlags)
+    {
+        // This function updates the triangles of the given mesh lights only.
+        // Transform changes update the geometry, emissive changes update the emission. The flux is updated in both cases.
+        // Textured emission is only re-integrated if the emissive texture changed, as the texture coordinates are static.
+        // Returns true if the flux of a triangle changed between zero and non-zero, so that the active triangle list is out of date.
+        FALCOR_ASSERT(mBuildOnCPU);
+        FALCOR_ASSERT(updatedLights.size() == updateFlags.size());
+
+        // Gather the triangles to update and the emissive textures that need to be integrated.
+        // Each texture is read back once, even if it's used by multiple mesh lights.
+        std::vector<uint32_t> triangles;
+        std::vector<ref<Texture>> textures;
+        std::map<const Texture*, uint32_t> textureIndices;
+        std::vector<std::pair<uint32_t, uint32_t>> lightTextures; // Pairs of mesh light and texture index.
+        for (size_t i = 0; i < updatedLights.size(); i++)
+        {
+            const uint32_t lightIdx = updatedLights[i];
+            const MeshLightData& meshLight = mMeshLights[lightIdx];
+            for (uint32_t triIdx = meshLight.triangleOffset; triIdx < meshLight.triangleOffset + meshLight.triangleCount; triIdx++) triangles.push_back(triIdx);
+
+            if (!is_set(updateFlags[i], UpdateFlags::EmissiveChanged)) continue;
+
+            auto pMaterial = scene.getMaterial(MaterialID::fromSlang(meshLight.materialID))->toBasicMaterial();
+            FALCOR_ASSERT(pMaterial);
+            ref<Texture> pTexture = pMaterial->getEmissiveTexture();
+            if (pTexture && pTexture != mEmissiveTextures[lightIdx])
+            {
+                auto [it, inserted] = textureIndices.emplace(pTexture.get(), (uint32_t)textures.size());
+                if (inserted) textures.push_back(pTexture);
+                lightTextures.emplace_back(lightIdx, it->second);
+            }
+            mEmissiveTextures[lightIdx] = pTexture;
+        }
+
+        // Read back all textures at once.
+        std::vector<EmissiveTexture> texels = readEmissiveTextures(pRenderContext, mpDevice.get(), textures, mpSamplerState.get());
+        std::vector<const EmissiveTexture*> triangleTextures(mTriangleCount, nullptr);
+        for (const auto& [lightIdx, textureIdx] : lightTextures)
+        {
+            const MeshLightData& meshLight = mMeshLights[lightIdx];
+            for (uint32_t triIdx = meshLight.triangleOffset; triIdx < meshLight.triangleOffset + meshLight.triangleCount; triIdx++) triangleTextures[triIdx] = &texels[textureIdx];
+        }
+
+        const auto& globalMatrices = scene.getAnimationController()->getGlobalMatrices();
+
+        // Set if a triangle's flux changed between zero and non-zero, i.e., it needs to be added to or removed from the active list.
+        std::atomic<bool> activeChanged = false;
+
+        auto updateTriangle = [&](uint32_t triIdx)
+        {
+            MeshLightTriangle& tri = mMeshLightTriangles[triIdx];
+            if (tri.lightIdx == MeshLightData::kInvalidIndex)
+            {
+                // The triangle is updated for the first time. Find its mesh light.
+                auto it = std::upper_bound(mMeshLights.begin(), mMeshLights.end(), triIdx, [](uint32_t i, const MeshLightData& m) { return i < m.triangleOffset; });
+                FALCOR_ASSERT(it != mMeshLights.begin());
+                tri.lightIdx = (uint32_t)std::distance(mMeshLights.begin(), it) - 1;
+            }
+
+            const MeshLightData& meshLight = mMeshLights[tri.lightIdx];
+            const GeometryInstanceData& instanceData = scene.getGeometryInstance(meshLight.instanceID);
+            const Scene::MeshGeometry* pGeometry = scene.getEmissiveMeshGeometry(MeshID::fromSlang(instanceData.geometryID));
+            FALCOR_ASSERT(pGeometry);
+
+            // Update geometry. The vertices are transformed to world space and the texture coordinates are quantized like on the GPU.
+            // We always do this, as the area of the triangle is needed for the flux.
+            const uint32_t vtxIdx = (triIdx - meshLight.triangleOffset) * 3;
+            const float4x4& worldMat = globalMatrices[instanceData.globalMatrixID];
+            EmissiveTriangle emissiveTri;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                emissiveTri.posW[j] = transformPoint(worldMat, pGeometry->positions[vtxIdx + j]);
+                emissiveTri.texCoords[j] = pGeometry->texCrds[vtxIdx + j];
+            }
+
+            float3 N = cross(emissiveTri.posW[1] - emissiveTri.posW[0], emissiveTri.posW[2] - emissiveTri.posW[0]);
+            float length2 = dot(N, N);
+            emissiveTri.area = 0.5f * std::sqrt(length2);
+            if (instanceData.isWorldFrontFaceCW()) N = -N;
+            emissiveTri.normal = length2 > 0.f ? N / std::sqrt(length2) : float3(0.f);
+            emissiveTri.materialID = meshLight.materialID;
+            emissiveTri.lightIdx = tri.lightIdx;
+
+            PackedEmissiveTriangle packedTri;
+            packedTri.pack(emissiveTri);
+            emissiveTri = packedTri.unpack();
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                tri.vtx[j].pos = emissiveTri.posW[j];
+                tri.vtx[j].uv = emissiveTri.texCoords[j];
+            }
+            tri.normal = emissiveTri.normal;
+            tri.area = emissiveTri.area;
+
+            // Update emission.
+            if (const EmissiveTexture* pTexture = triangleTextures[triIdx])
+            {
+                mTriangleEmissiveColor[triIdx] = integrateEmissiveTexture(*pTexture, emissiveTri.texCoords);
+            }
+
+            const BasicMaterial* pMaterial = static_cast<const BasicMaterial*>(scene.getMaterial(MaterialID::fromSlang(meshLight.materialID)).get());
+            const BasicMaterialData& materialData = pMaterial->getData();
+            float3 averageEmissiveColor = pMaterial->getEmissiveTexture() ? mTriangleEmissiveColor[triIdx] : materialData.emissive;
+
+            // Pre-compute the luminous flux emitted, see FinalizeIntegration.cs.slang.
+            const bool wasActive = tri.flux > 0.f;
+            tri.averageRadiance = averageEmissiveColor * materialData.emissiveFactor;
+            tri.flux = luminance(tri.averageRadiance) * tri.area * (float)M_PI;
+            if ((tri.flux > 0.f) != wasActive) activeChanged.store(true, std::memory_order_relaxed);
+        };
+
+        std::for_each(std::execution::par, triangles.begin(), triangles.end(), updateTriangle);
+
+        mStatsValid = false;
+        return activeChanged;
+    }
+
+    void LightCollection::uploadMeshLightData(RenderContext* pRenderContext, const std::vector<uint32_t>& lights)
+    {
+        // Record the triangle ranges of the given mesh lights. The batcher merges adjacent ranges,
+        // so the flush issues one copy per contiguous range of updated triangles.
+        std::vector<PackedEmissiveTriangle> triangleData;
+        std::vector<EmissiveFlux> fluxData;
+        for (uint32_t lightIdx : lights)
+        {
+            const MeshLightData& meshLight = mMeshLights[lightIdx];
+            if (meshLight.triangleCount == 0) continue;
+
+            triangleData.resize(meshLight.triangleCount);
+            fluxData.resize(meshLight.triangleCount);
+            packTriangles(mMeshLightTriangles, mMeshLights, meshLight.triangleOffset, meshLight.triangleCount, triangleData.data(), fluxData.data());
+
+            mpUploadBatcher->write(mpTriangleData, meshLight.triangleOffset * sizeof(PackedEmissiveTriangle), triangleData.data(), triangleData.size() * sizeof(PackedEmissiveTriangle));
+            mpUploadBatcher->write(mpFluxData, meshLight.triangleOffset * sizeof(EmissiveFlux), fluxData.data(), fluxData.size() * sizeof(EmissiveFlux));
+        }
+
+        mpUploadBatcher->flush(pRenderContext);
+    }
+
     void LightCollection::bindShaderData(const ShaderVar& var) const
     {
         FALCOR_ASSERT(var.isValid());
@@ -31,12 +31,14 @@
 #include "Core/Object.h"
 #include "Core/API/Buffer.h"
 #include "Core/API/Sampler.h"
+#include "Core/API/Texture.h"
 #include "Core/API/Fence.h"
 #include "Core/State/GraphicsState.h"
 #include "Core/Program/Program.h"
 #include "Core/Program/ProgramVars.h"
 #include "Core/Pass/ComputePass.h"
 #include "Utils/Math/Vector.h"
+#include "Utils/UploadBatcher.h"
 #include <memory>
 #include <vector>
 
@@ -62,6 +64,7 @@ namespace Falcor
         {
             None                = 0u,   ///< Nothing was changed.
             MatrixChanged       = 1u,   ///< Mesh instance transform changed.
+            EmissiveChanged     = 2u,   ///< Emissive material properties changed (CPU build only).
         };
 
         struct UpdateStatus
@@ -114,19 +117,49 @@ namespace Falcor
             }
         };
 
+        /** Texels of an emissive texture for integrating textured emission on the CPU.
+        */
+        struct EmissiveTexture
+        {
+            uint32_t                width = 0;
+            uint32_t                height = 0;
+            std::vector<float3>     texels;                                             ///< Texels of the finest mip (RGB) in row-major order.
+            TextureAddressingMode   addressModeU = TextureAddressingMode::Wrap;         ///< Addressing mode of the material sampler. Border texels are black.
+            TextureAddressingMode   addressModeV = TextureAddressingMode::Wrap;
+
+            /** Fetch a texel. Coordinates outside the texture are resolved with the addressing modes.
+            */
+            float3 fetch(int32_t x, int32_t y) const;
+
+            /** Sample the texture with nearest filtering.
+            */
+            float3 sample(float2 uv) const;
+        };
+
+        /** Computes the average emitted color over a textured emissive triangle.
+            This is the CPU equivalent of EmissiveIntegrator.3d.slang. The triangle is rasterized in texture space
+            at the finest mip and each texel is weighted by its exact coverage. If the triangle is degenerate in
+            texture space, the emission is approximated by the average of the texels at the three vertices.
+            \param[in] texture Emissive texture.
+            \param[in] texCoords Texture coordinates of the three vertices.
+            \return Average emitted color (not scaled by the emissive factor).
+        */
+        static float3 integrateEmissiveTexture(const EmissiveTexture& texture, const float2 texCoords[3]);
+
         /** Creates a light collection for the given scene.
             Note that update() must be called before the collection is ready to use.
             \param[in] pDevice GPU device.
             \param[in] pRenderContext The render context.
             \param[in] pScene The scene.
+            \param[in] allowBuildOnCPU If false, the mesh lights are always built with GPU passes (see isBuiltOnCPU()).
             \return A pointer to a new light collection object, or throws an exception if creation failed.
         */
-        static ref<LightCollection> create(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene)
+        static ref<LightCollection> create(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene, bool allowBuildOnCPU = true)
         {
-            return make_ref<LightCollection>(pDevice, pRenderContext, pScene);
+            return make_ref<LightCollection>(pDevice, pRenderContext, pScene, allowBuildOnCPU);
         }
 
-        LightCollection(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene);
+        LightCollection(ref<Device> pDevice, RenderContext* pRenderContext, Scene* pScene, bool allowBuildOnCPU = true);
         ~LightCollection() = default;
 
         /** Updates the light collection to the current state of the scene.
@@ -141,6 +174,13 @@ namespace Falcor
         */
         void bindShaderData(const ShaderVar& var) const;
 
+        /** Returns true if the mesh lights are built and updated on the CPU.
+            This is the case if CPU copies of the geometry of all mesh lights are available (see Scene::getEmissiveMeshGeometry()).
+            The GPU data is then uploaded directly and the CPU data is available without a readback.
+            Otherwise the mesh lights are built with GPU passes.
+        */
+        bool isBuiltOnCPU() const { return mBuildOnCPU; }
+
         /** Returns the total number of active (non-culled) triangle lights.
         */
         uint32_t getActiveLightCount(RenderContext* pRenderContext) const { return getStats(pRenderContext).trianglesActive; }
@@ -164,6 +204,10 @@ namespace Falcor
         */
         const std::vector<MeshLightData>& getMeshLights() const { return mMeshLights; }
 
+        /** Returns the indices of the mesh lights that were changed by the last call to update().
+        */
+        const std::vector<uint32_t>& getUpdatedMeshLights() const { return mUpdatedLights; }
+
         /** Prepare for syncing the CPU data.
             If the mesh light triangles will be accessed with getMeshLightTriangles()
             performance can be improved by calling this function ahead of time.
@@ -197,6 +241,11 @@ namespace Falcor
         void updateActiveTriangleList(RenderContext* pRenderContext);
         void updateTrianglePositions(RenderContext* pRenderContext, const Scene& scene, const std::vector<uint32_t>& updatedLights);
 
+        bool canBuildOnCPU(const Scene& scene) const;
+        void buildOnCPU(RenderContext* pRenderContext, const Scene& scene);
+        bool updateMeshLightsOnCPU(RenderContext* pRenderContext, const Scene& scene, const std::vector<uint32_t>& updatedLights, const std::vector<UpdateFlags>& updateFlags);
+        void uploadMeshLightData(RenderContext* pRenderContext, const std::vector<uint32_t>& lights);
+
         void copyDataToStagingBuffer(RenderContext* pRenderContext) const;
         void syncCPUData(RenderContext* pRenderContext) const;
 
@@ -210,6 +259,12 @@ namespace Falcor
         mutable std::vector<MeshLightTriangle>  mMeshLightTriangles;    ///< List of all pre-processed mesh light triangles.
         mutable std::vector<uint32_t>           mActiveTriangleList;    ///< List of active (non-culled) emissive triangles.
         mutable std::vector<uint32_t>           mTriToActiveList;       ///< Mapping of all light triangles to index in mActiveTriangleList.
+        std::vector<uint32_t>                   mUpdatedLights;         ///< List of mesh lights changed by the last update.
+
+        bool                                    mBuildOnCPU = false;    ///< True if the mesh lights are built and updated on the CPU.
+        std::vector<float3>                     mTriangleEmissiveColor; ///< Per-triangle average emissive color before scaling by the emissive factor (CPU build only).
+        std::vector<ref<Texture>>               mEmissiveTextures;      ///< Per-mesh light emissive texture used for the last integration (CPU build only).
+        std::unique_ptr<UploadBatcher>          mpUploadBatcher;        ///< Batches the uploads of updated mesh lights (CPU build only).
 
         mutable MeshLightStats                  mMeshLightStats;        ///< Stats before/after pre-processing of mesh lights. Do not access this directly, use getStats() which ensures the stats are up-to-date.
         mutable bool                            mStatsValid = false;    ///< True when stats are valid.
@@ -243,6 +298,8 @@ namespace Falcor
 
         mutable CPUOutOfDateFlags               mCPUInvalidData = CPUOutOfDateFlags::None;  ///< Flags indicating which CPU data is valid.
         mutable bool                            mStagingBufferValid = true;                 ///< Flag to indicate if the contents of the staging buffer is up-to-date.
+
+        friend class LightCollectionTest;
     };
 
     FALCOR_ENUM_CLASS_OPERATORS(LightCollection::CPUOutOfDateFlags);
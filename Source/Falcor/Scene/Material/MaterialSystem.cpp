@@ -67,6 +67,7 @@ namespace Falcor
 
         mpFence = mpDevice->createFence();
         mpTextureManager = std::make_unique<TextureManager>(mpDevice, kMaxTextureCount);
+        mpUploadBatcher = std::make_unique<UploadBatcher>(mpDevice);
 
         // Create a default texture sampler.
         Sampler::Desc desc;
@@ -104,6 +105,8 @@ namespace Falcor
                 materialID++;
             }
         }
+
+        mpUploadBatcher->flush(mpDevice->getRenderContext());
     }
 
     void MaterialSystem::updateUI()
@@ -505,6 +508,7 @@ namespace Falcor
                     uploadMaterial(materialID);
                 }
             }
+            mpUploadBatcher->flush(mpDevice->getRenderContext());
         }
 
         auto blockVar = mpMaterialsBlock->getRootVar();
@@ -757,9 +761,8 @@ namespace Falcor
         const auto& pMaterial = mMaterials[materialID];
         FALCOR_ASSERT(pMaterial);
 
-        // TODO: On initial upload of materials, we could improve this by not having separate calls to setElement()
-        // but instead prepare a buffer containing all data.
+        // The data is recorded in the upload batcher, consecutive materials are uploaded with a single copy on flush.
         FALCOR_ASSERT(mpMaterialDataBuffer);
-        mpMaterialDataBuffer->setElement(materialID, pMaterial->getDataBlob());
+        mpUploadBatcher->setElement(mpMaterialDataBuffer, materialID, pMaterial->getDataBlob());
     }
 }
@@ -35,6 +35,7 @@
 #include "Core/Program/DefineList.h"
 #include "Core/Program/Program.h"
 #include "Utils/Image/TextureManager.h"
+#include "Utils/UploadBatcher.h"
 #include "Utils/UI/Gui.h"
 #include <memory>
 #include <vector>
@@ -82,6 +83,15 @@ namespace Falcor
         */
         Material::UpdateFlags update(bool forceUpdate);
 
+        /** Get the update flags of a material from the last call to update().
+            \param[in] materialID The material ID.
+            \return Update flags of the material.
+        */
+        Material::UpdateFlags getMaterialUpdates(MaterialID materialID) const
+        {
+            return materialID.get() < mMaterialsUpdateFlags.size() ? mMaterialsUpdateFlags[materialID.get()] : Material::UpdateFlags::None;
+        }
+
         /** Get shader defines.
             These need to be set before binding the material system parameter block.
             Adds defines to an existing list, rather than creating a new list.
@@ -289,6 +299,7 @@ namespace Falcor
         ref<Fence> mpFence;
         ref<ParameterBlock> mpMaterialsBlock;                       ///< Parameter block for binding all material resources.
         ref<Buffer> mpMaterialDataBuffer;                           ///< GPU buffer holding all material data.
+        std::unique_ptr<UploadBatcher> mpUploadBatcher;             ///< Batches the uploads of modified material data.
         ref<Sampler> mpDefaultTextureSampler;                       ///< Default texture sampler to use for all materials.
         std::vector<ref<Sampler>> mTextureSamplers;                 ///< Texture sampler states. These are indexed by ID in the materials.
         std::vector<ref<Buffer>> mBuffers;                          ///< Buffers used by the materials. These are indexed by ID in the materials.
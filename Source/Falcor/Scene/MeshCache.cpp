@@ -0,0 +1,342 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "MeshCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specifies the current mesh cache file version.
+            This needs to be incremented every time the file format or the output of SceneBuilder::processMesh() changes!
+        */
+        const uint32_t kVersion = 1;
+
+        /** Mesh cache directory (subdirectory in the application data directory).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/MeshCache";
+
+        const char* kMagic = "FalcorM$";
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+
+            bool isValid() const
+            {
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+            }
+        };
+
+        template<typename T>
+        void writeVector(std::ostream& stream, const std::vector<T>& vec)
+        {
+            uint64_t size = vec.size();
+            stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            stream.write(reinterpret_cast<const char*>(vec.data()), size * sizeof(T));
+        }
+
+        template<typename T>
+        void readVector(std::istream& stream, std::vector<T>& vec, uint64_t maxSize)
+        {
+            uint64_t size = 0;
+            stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if (!stream.good() || size > maxSize / sizeof(T))
+            {
+                stream.setstate(std::ios_base::failbit);
+                return;
+            }
+            vec.resize(size);
+            stream.read(reinterpret_cast<char*>(vec.data()), size * sizeof(T));
+        }
+
+        bool isEntry(const std::filesystem::directory_entry& entry)
+        {
+            // Skip temporary files of writes in progress.
+            std::error_code ec;
+            return entry.is_regular_file(ec) && !entry.path().has_extension();
+        }
+    }
+
+    MeshCache& MeshCache::instance()
+    {
+        static MeshCache sInstance;
+        return sInstance;
+    }
+
+    MeshCache::MeshCache()
+        : mDirectory(getAppDataDirectory() / kDirectory)
+    {}
+
+    void MeshCache::setDirectory(const std::filesystem::path& directory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDirectory = directory;
+        mSize.reset();
+    }
+
+    std::filesystem::path MeshCache::getDirectory() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory;
+    }
+
+    void MeshCache::setMaxSize(uint64_t maxSize)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxSize = maxSize;
+    }
+
+    uint64_t MeshCache::getMaxSize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mMaxSize;
+    }
+
+    bool MeshCache::contains(const Key& key) const
+    {
+        std::error_code ec;
+        return std::filesystem::is_regular_file(getEntryPath(key), ec);
+    }
+
+    bool MeshCache::read(const Key& key, SceneBuilder::ProcessedMesh& mesh)
+    {
+        auto entryPath = getEntryPath(key);
+
+        auto miss = [&]()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.misses++;
+            return false;
+        };
+
+        std::error_code ec;
+        const uint64_t fileSize = std::filesystem::file_size(entryPath, ec);
+        if (ec) return miss();
+
+        std::ifstream fs(entryPath, std::ios_base::binary);
+        if (!fs.good()) return miss();
+
+        Header header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!fs.good() || !header.isValid()) return miss();
+
+        uint8_t use16BitIndices = 0;
+        fs.read(reinterpret_cast<char*>(&mesh.indexCount), sizeof(mesh.indexCount));
+        fs.read(reinterpret_cast<char*>(&use16BitIndices), sizeof(use16BitIndices));
+        mesh.use16BitIndices = use16BitIndices != 0;
+        readVector(fs, mesh.indexData, fileSize);
+        readVector(fs, mesh.staticData, fileSize);
+        readVector(fs, mesh.skinningData, fileSize);
+        if (!fs.good())
+        {
+            logWarning("Failed to read mesh cache file '{}'.", entryPath);
+            mesh.indexCount = 0;
+            mesh.indexData.clear();
+            mesh.staticData.clear();
+            mesh.skinningData.clear();
+            return miss();
+        }
+        fs.close();
+
+        // Mark the entry as recently used.
+        std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.hits++;
+        mStats.bytesRead += fileSize;
+        return true;
+    }
+
+    void MeshCache::write(const Key& key, const SceneBuilder::ProcessedMesh& mesh)
+    {
+        auto entryPath = getEntryPath(key);
+
+        std::error_code ec;
+        std::filesystem::create_directories(entryPath.parent_path(), ec);
+
+        // Write to a temporary file first, the same mesh may be written from multiple threads or processes.
+        std::ostringstream suffix;
+        suffix << ".tmp" << std::this_thread::get_id();
+        std::filesystem::path tmpPath = entryPath;
+        tmpPath += suffix.str();
+
+        {
+            std::ofstream fs(tmpPath, std::ios_base::binary);
+            if (!fs.good())
+            {
+                logWarning("Failed to create mesh cache file '{}'.", tmpPath);
+                return;
+            }
+
+            Header header;
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = kVersion;
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            uint8_t use16BitIndices = mesh.use16BitIndices ? 1 : 0;
+            fs.write(reinterpret_cast<const char*>(&mesh.indexCount), sizeof(mesh.indexCount));
+            fs.write(reinterpret_cast<const char*>(&use16BitIndices), sizeof(use16BitIndices));
+            writeVector(fs, mesh.indexData);
+            writeVector(fs, mesh.staticData);
+            writeVector(fs, mesh.skinningData);
+            if (!fs.good())
+            {
+                logWarning("Failed to write mesh cache file '{}'.", tmpPath);
+                fs.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+
+        const uint64_t fileSize = std::filesystem::file_size(tmpPath, ec);
+        std::filesystem::rename(tmpPath, entryPath, ec);
+        if (ec)
+        {
+            logWarning("Failed to write mesh cache file '{}': {}", entryPath, ec.message());
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.writes++;
+        mStats.bytesWritten += fileSize;
+
+        if (!mSize)
+        {
+            // Scan the cache directory on the first write (this includes the entry just written).
+            trimLocked(mMaxSize);
+        }
+        else
+        {
+            *mSize += fileSize;
+            if (*mSize > mMaxSize) trimLocked(mMaxSize);
+        }
+    }
+
+    void MeshCache::trim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(mMaxSize);
+    }
+
+    void MeshCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(0);
+    }
+
+    MeshCache::Stats MeshCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void MeshCache::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats = {};
+    }
+
+    std::filesystem::path MeshCache::getEntryPath(const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory / SHA1::toString(key);
+    }
+
+    void MeshCache::trimLocked(uint64_t maxSize)
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+
+        std::error_code ec;
+        for (const auto& it : std::filesystem::directory_iterator(mDirectory, ec))
+        {
+            if (!isEntry(it)) continue;
+            Entry entry{ it.path(), it.last_write_time(ec), it.file_size(ec) };
+            if (ec) continue;
+            totalSize += entry.size;
+            entries.push_back(std::move(entry));
+        }
+
+        // Evict the least recently used entries first.
+        if (totalSize > maxSize)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+            for (const auto& entry : entries)
+            {
+                if (totalSize <= maxSize) break;
+                if (std::filesystem::remove(entry.path, ec))
+                {
+                    totalSize -= entry.size;
+                    mStats.evictions++;
+                }
+            }
+        }
+
+        mSize = totalSize;
+    }
+
+    FALCOR_SCRIPT_BINDING(MeshCache)
+    {
+        pybind11::class_<MeshCache> meshCache(m, "MeshCache");
+        meshCache.def_static("instance", &MeshCache::instance, pybind11::return_value_policy::reference);
+        meshCache.def_property("directory", &MeshCache::getDirectory, &MeshCache::setDirectory);
+        meshCache.def_property("max_size", &MeshCache::getMaxSize, &MeshCache::setMaxSize);
+        meshCache.def_property_readonly("stats", [](const MeshCache& self)
+        {
+            auto stats = self.getStats();
+            pybind11::dict d;
+            d["hits"] = stats.hits;
+            d["misses"] = stats.misses;
+            d["writes"] = stats.writes;
+            d["evictions"] = stats.evictions;
+            d["bytes_read"] = stats.bytesRead;
+            d["bytes_written"] = stats.bytesWritten;
+            d["hit_rate"] = stats.getHitRate();
+            return d;
+        });
+        meshCache.def("reset_stats", &MeshCache::resetStats);
+        meshCache.def("trim", &MeshCache::trim);
+        meshCache.def("clear", &MeshCache::clear);
+    }
+}
@@ -0,0 +1,127 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+#include "Core/Macros.h"
+#include "Utils/CryptoUtils.h"
+#include <filesystem>
+#include <mutex>
+#include <optional>
+
+namespace Falcor
+{
+    /** On-disk cache of processed meshes.
+
+        Each entry stores the geometry of a SceneBuilder::ProcessedMesh (indices and vertex data, without the material).
+        Entries are keyed by a hash of the source mesh content and the build options that affect mesh processing,
+        see SceneBuilder::processMesh(). The cache is therefore shared by all scenes that use the same geometry,
+        and unchanged meshes are reused when a scene file or unrelated settings change. Meshes loaded from files
+        are keyed by the file content instead, so that importers can skip loading them (see SceneBuilder::getMeshCacheKey()).
+
+        The total size of the cache is limited. When a write exceeds the limit, the least recently used
+        entries are evicted. Reading an entry marks it as used by updating the file modification time.
+        The cache can be used concurrently from multiple threads and processes.
+    */
+    class FALCOR_API MeshCache
+    {
+    public:
+        using Key = SHA1::MD;
+
+        struct Stats
+        {
+            uint64_t hits = 0;          ///< Number of successful reads.
+            uint64_t misses = 0;        ///< Number of reads of missing or invalid entries.
+            uint64_t writes = 0;        ///< Number of written entries.
+            uint64_t evictions = 0;     ///< Number of entries removed to stay within the size limit.
+            uint64_t bytesRead = 0;     ///< Total size of the read entries in bytes.
+            uint64_t bytesWritten = 0;  ///< Total size of the written entries in bytes.
+
+            double getHitRate() const { return hits + misses > 0 ? double(hits) / double(hits + misses) : 0.0; }
+        };
+
+        /// Default size limit of the cache in bytes.
+        static constexpr uint64_t kDefaultMaxSize = 16ull << 30;
+
+        /// Get the global mesh cache.
+        static MeshCache& instance();
+
+        /** Set the cache directory. By default, the cache is stored in the application data directory.
+            \param[in] directory Cache directory.
+        */
+        void setDirectory(const std::filesystem::path& directory);
+        std::filesystem::path getDirectory() const;
+
+        /** Set the size limit of the cache. Entries are evicted on the next write if the cache is larger.
+            \param[in] maxSize Size limit in bytes.
+        */
+        void setMaxSize(uint64_t maxSize);
+        uint64_t getMaxSize() const;
+
+        /** Check if the cache contains an entry. The entry may still be evicted before it is read.
+            \param[in] key Cache key.
+            \return True if the entry exists.
+        */
+        bool contains(const Key& key) const;
+
+        /** Read a cache entry.
+            Only the geometry of the processed mesh is written (index count/format, index data and vertex data).
+            \param[in] key Cache key.
+            \param[out] mesh Processed mesh.
+            \return True if the entry was found and is valid.
+        */
+        bool read(const Key& key, SceneBuilder::ProcessedMesh& mesh);
+
+        /** Write a cache entry. Failures are logged but not reported to the caller.
+            \param[in] key Cache key.
+            \param[in] mesh Processed mesh.
+        */
+        void write(const Key& key, const SceneBuilder::ProcessedMesh& mesh);
+
+        /// Evict the least recently used entries until the cache is within the size limit.
+        void trim();
+
+        /// Remove all entries.
+        void clear();
+
+        /// Get the statistics accumulated since the last call to resetStats().
+        Stats getStats() const;
+        void resetStats();
+
+    private:
+        MeshCache();
+
+        std::filesystem::path getEntryPath(const Key& key) const;
+        void trimLocked(uint64_t maxSize);
+
+        mutable std::mutex mMutex;
+        std::filesystem::path mDirectory;
+        uint64_t mMaxSize = kDefaultMaxSize;
+        std::optional<uint64_t> mSize; ///< Total size of the entries. Computed on the first write.
+        Stats mStats;
+    };
+}
@@ -0,0 +1,208 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "MeshLayoutOptimizer.h"
+#include <algorithm>
+#include <limits>
+
+namespace Falcor
+{
+    namespace MeshLayoutOptimizer
+    {
+        namespace
+        {
+            constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+            /** Vertex to triangle adjacency in compressed row format.
+            */
+            struct Adjacency
+            {
+                std::vector<uint32_t> offsets;      ///< Offset into 'triangles' for each vertex, vertexCount + 1 entries.
+                std::vector<uint32_t> triangles;    ///< Triangle indices.
+
+                Adjacency(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+                {
+                    offsets.assign(vertexCount + 1, 0);
+                    for (uint32_t index : indices) offsets[index + 1]++;
+                    for (uint32_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+
+                    triangles.resize(indices.size());
+                    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                    for (size_t i = 0; i < indices.size(); i++) triangles[fill[indices[i]]++] = uint32_t(i / 3);
+                }
+            };
+        }
+
+        CacheStats computeCacheStats(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+        {
+            FALCOR_ASSERT(indices.size() % 3 == 0);
+            FALCOR_ASSERT(cacheSize > 0);
+
+            CacheStats stats;
+            stats.triangleCount = indices.size() / 3;
+
+            // FIFO cache: a vertex is in the cache if it was inserted less than 'cacheSize' insertions ago.
+            std::vector<uint64_t> insertTime(vertexCount, std::numeric_limits<uint64_t>::max());
+            std::vector<bool> referenced(vertexCount, false);
+            uint64_t time = 0;
+
+            for (uint32_t index : indices)
+            {
+                FALCOR_ASSERT(index < vertexCount);
+                if (!referenced[index])
+                {
+                    referenced[index] = true;
+                    stats.vertexCount++;
+                }
+                if (insertTime[index] == std::numeric_limits<uint64_t>::max() || time - insertTime[index] >= cacheSize)
+                {
+                    insertTime[index] = time++;
+                    stats.transformedVertexCount++;
+                }
+            }
+
+            return stats;
+        }
+
+        void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+        {
+            FALCOR_ASSERT(indices.size() % 3 == 0);
+            FALCOR_ASSERT(cacheSize > 0);
+
+            const uint32_t triangleCount = uint32_t(indices.size() / 3);
+            if (triangleCount == 0) return;
+
+            const Adjacency adjacency(indices, vertexCount);
+
+            // Number of not yet emitted triangles referencing each vertex.
+            std::vector<uint32_t> liveTriangles(vertexCount);
+            for (uint32_t v = 0; v < vertexCount; v++) liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+            std::vector<uint32_t> cacheTime(vertexCount, 0);
+            std::vector<bool> emitted(triangleCount, false);
+            std::vector<uint32_t> deadEndStack;
+            std::vector<uint32_t> candidates;
+            std::vector<uint32_t> output;
+            output.reserve(indices.size());
+
+            uint32_t time = cacheSize + 1;
+            uint32_t cursor = 0;
+
+            // Returns the next vertex with live triangles when the local neighborhood is exhausted.
+            auto skipDeadEnd = [&]() -> uint32_t
+            {
+                while (!deadEndStack.empty())
+                {
+                    uint32_t v = deadEndStack.back();
+                    deadEndStack.pop_back();
+                    if (liveTriangles[v] > 0) return v;
+                }
+                while (cursor < vertexCount)
+                {
+                    if (liveTriangles[cursor] > 0) return cursor;
+                    cursor++;
+                }
+                return kInvalidIndex;
+            };
+
+            // Selects the candidate vertex that will still be in the cache after emitting all of its triangles and was used least recently.
+            auto getNextVertex = [&]() -> uint32_t
+            {
+                uint32_t best = kInvalidIndex;
+                int64_t bestPriority = -1;
+                for (uint32_t v : candidates)
+                {
+                    if (liveTriangles[v] == 0) continue;
+                    int64_t priority = 0;
+                    if (int64_t(time) - cacheTime[v] + 2 * int64_t(liveTriangles[v]) <= int64_t(cacheSize))
+                    {
+                        priority = int64_t(time) - cacheTime[v];
+                    }
+                    if (priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        best = v;
+                    }
+                }
+                return best != kInvalidIndex ? best : skipDeadEnd();
+            };
+
+            uint32_t fanningVertex = skipDeadEnd();
+            while (fanningVertex != kInvalidIndex)
+            {
+                candidates.clear();
+
+                for (uint32_t i = adjacency.offsets[fanningVertex]; i < adjacency.offsets[fanningVertex + 1]; i++)
+                {
+                    uint32_t t = adjacency.triangles[i];
+                    if (emitted[t]) continue;
+                    emitted[t] = true;
+
+                    for (uint32_t j = 0; j < 3; j++)
+                    {
+                        uint32_t v = indices[3 * t + j];
+                        output.push_back(v);
+                        deadEndStack.push_back(v);
+                        candidates.push_back(v);
+                        liveTriangles[v]--;
+                        if (time - cacheTime[v] > cacheSize)
+                        {
+                            cacheTime[v] = time++;
+                        }
+                    }
+                }
+
+                fanningVertex = getNextVertex();
+            }
+
+            FALCOR_ASSERT(output.size() == indices.size());
+            indices = std::move(output);
+        }
+
+        std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount)
+        {
+            std::vector<uint32_t> remap(vertexCount, kInvalidIndex);
+            uint32_t nextIndex = 0;
+
+            for (uint32_t& index : indices)
+            {
+                FALCOR_ASSERT(index < vertexCount);
+                if (remap[index] == kInvalidIndex) remap[index] = nextIndex++;
+                index = remap[index];
+            }
+
+            // Move unreferenced vertices to the end to keep the vertex count unchanged.
+            for (uint32_t& newIndex : remap)
+            {
+                if (newIndex == kInvalidIndex) newIndex = nextIndex++;
+            }
+            FALCOR_ASSERT(nextIndex == vertexCount);
+
+            return remap;
+        }
+    }
+}
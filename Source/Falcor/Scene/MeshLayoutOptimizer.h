@@ -0,0 +1,107 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/Error.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Utilities for optimizing the memory layout of indexed triangle meshes.
+        Triangles are reordered for post-transform vertex cache locality using the Tipsify
+        algorithm [Sander et al. 2007], and vertices are then reordered into the order in
+        which they are first referenced by the index buffer to improve vertex fetch locality.
+        Improved locality of the index order also benefits BVH builders that process
+        primitives in index order.
+    */
+    namespace MeshLayoutOptimizer
+    {
+        /// Vertex cache size used by the optimization and the statistics by default.
+        static constexpr uint32_t kDefaultCacheSize = 16;
+
+        /** Vertex cache statistics of an index buffer, simulated with a FIFO cache.
+        */
+        struct CacheStats
+        {
+            uint64_t transformedVertexCount = 0;    ///< Number of vertex shader invocations (cache misses).
+            uint64_t triangleCount = 0;             ///< Number of triangles.
+            uint64_t vertexCount = 0;               ///< Number of referenced vertices.
+
+            /// Average cache miss ratio (transformed vertices per triangle). The optimum is 0.5 for large regular meshes.
+            double getACMR() const { return triangleCount > 0 ? double(transformedVertexCount) / triangleCount : 0.0; }
+            /// Average transform to vertex ratio (transformed vertices per vertex). The optimum is 1.0.
+            double getATVR() const { return vertexCount > 0 ? double(transformedVertexCount) / vertexCount : 0.0; }
+
+            CacheStats& operator+=(const CacheStats& other)
+            {
+                transformedVertexCount += other.transformedVertexCount;
+                triangleCount += other.triangleCount;
+                vertexCount += other.vertexCount;
+                return *this;
+            }
+        };
+
+        /** Simulate a FIFO vertex cache on an index buffer.
+            \param[in] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] cacheSize Number of entries in the simulated cache.
+            \return Cache statistics.
+        */
+        FALCOR_API CacheStats computeCacheStats(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Reorder triangles for vertex cache locality (Tipsify).
+            The winding of each triangle is preserved.
+            \param[in,out] indices Triangle list indices.
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] cacheSize Target cache size.
+        */
+        FALCOR_API void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Compute a vertex order for fetch locality and update the indices to the new order.
+            Vertices are ordered by first reference in the index buffer. Unreferenced vertices are moved to the end.
+            \param[in,out] indices Triangle list indices, remapped to the new vertex order.
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \return Remapping table where element i holds the new index of old vertex i.
+        */
+        FALCOR_API std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /** Reorder an array of per-vertex data according to a remapping table from optimizeVertexFetch().
+            \param[in,out] data Vertex data.
+            \param[in] remap Remapping table.
+        */
+        template<typename T>
+        void remapVertices(std::vector<T>& data, const std::vector<uint32_t>& remap)
+        {
+            FALCOR_ASSERT(data.size() == remap.size());
+            std::vector<T> remapped(data.size());
+            for (size_t i = 0; i < data.size(); i++) remapped[remap[i]] = data[i];
+            data = std::move(remapped);
+        }
+    }
+}
@@ -0,0 +1,544 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "PlyReader.h"
+#include "Core/Error.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Falcor
+{
+    namespace PlyReader
+    {
+        namespace
+        {
+            enum class Format
+            {
+                Ascii,
+                BinaryLittleEndian,
+                BinaryBigEndian,
+            };
+
+            enum class Type
+            {
+                Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64,
+            };
+
+            struct Property
+            {
+                std::string name;
+                Type type = Type::Float32;
+                bool isList = false;
+                Type countType = Type::UInt8;
+            };
+
+            struct Element
+            {
+                std::string name;
+                size_t count = 0;
+                std::vector<Property> properties;
+            };
+
+            /// Vertex attribute a vertex property is decoded to.
+            enum class Attribute
+            {
+                None, PositionX, PositionY, PositionZ, NormalX, NormalY, NormalZ, TexCoordU, TexCoordV,
+            };
+
+            Attribute getAttribute(std::string_view name)
+            {
+                if (name == "x") return Attribute::PositionX;
+                if (name == "y") return Attribute::PositionY;
+                if (name == "z") return Attribute::PositionZ;
+                if (name == "nx") return Attribute::NormalX;
+                if (name == "ny") return Attribute::NormalY;
+                if (name == "nz") return Attribute::NormalZ;
+                if (name == "u" || name == "s" || name == "texture_u" || name == "texture_s") return Attribute::TexCoordU;
+                if (name == "v" || name == "t" || name == "texture_v" || name == "texture_t") return Attribute::TexCoordV;
+                return Attribute::None;
+            }
+
+            Type parseType(std::string_view name)
+            {
+                if (name == "char" || name == "int8") return Type::Int8;
+                if (name == "uchar" || name == "uint8") return Type::UInt8;
+                if (name == "short" || name == "int16") return Type::Int16;
+                if (name == "ushort" || name == "uint16") return Type::UInt16;
+                if (name == "int" || name == "int32") return Type::Int32;
+                if (name == "uint" || name == "uint32") return Type::UInt32;
+                if (name == "float" || name == "float32") return Type::Float32;
+                if (name == "double" || name == "float64") return Type::Float64;
+                FALCOR_THROW("Unknown PLY property type '{}'.", name);
+            }
+
+            size_t getTypeSize(Type type)
+            {
+                switch (type)
+                {
+                case Type::Int8: case Type::UInt8: return 1;
+                case Type::Int16: case Type::UInt16: return 2;
+                case Type::Int32: case Type::UInt32: case Type::Float32: return 4;
+                case Type::Float64: return 8;
+                }
+                FALCOR_UNREACHABLE();
+            }
+
+            std::vector<std::string_view> splitTokens(std::string_view line)
+            {
+                std::vector<std::string_view> tokens;
+                size_t pos = 0;
+                while (pos < line.size())
+                {
+                    while (pos < line.size() && std::isspace((unsigned char)line[pos])) pos++;
+                    size_t start = pos;
+                    while (pos < line.size() && !std::isspace((unsigned char)line[pos])) pos++;
+                    if (pos > start) tokens.push_back(line.substr(start, pos - start));
+                }
+                return tokens;
+            }
+
+            bool isHostLittleEndian()
+            {
+                const uint16_t value = 1;
+                uint8_t firstByte;
+                std::memcpy(&firstByte, &value, 1);
+                return firstByte == 1;
+            }
+
+            /** Cursor over binary element data.
+            */
+            class BinaryCursor
+            {
+            public:
+                BinaryCursor(const uint8_t* begin, const uint8_t* end, bool swapBytes) : mPtr(begin), mEnd(end), mSwapBytes(swapBytes) {}
+
+                template<typename T>
+                T readRaw()
+                {
+                    if (sizeof(T) > getRemainingSize()) FALCOR_THROW("Unexpected end of PLY file.");
+                    T value;
+                    if (mSwapBytes)
+                    {
+                        uint8_t bytes[sizeof(T)];
+                        for (size_t i = 0; i < sizeof(T); i++) bytes[i] = mPtr[sizeof(T) - 1 - i];
+                        std::memcpy(&value, bytes, sizeof(T));
+                    }
+                    else
+                    {
+                        std::memcpy(&value, mPtr, sizeof(T));
+                    }
+                    mPtr += sizeof(T);
+                    return value;
+                }
+
+                double read(Type type)
+                {
+                    switch (type)
+                    {
+                    case Type::Int8: return readRaw<int8_t>();
+                    case Type::UInt8: return readRaw<uint8_t>();
+                    case Type::Int16: return readRaw<int16_t>();
+                    case Type::UInt16: return readRaw<uint16_t>();
+                    case Type::Int32: return readRaw<int32_t>();
+                    case Type::UInt32: return readRaw<uint32_t>();
+                    case Type::Float32: return readRaw<float>();
+                    case Type::Float64: return readRaw<double>();
+                    }
+                    FALCOR_UNREACHABLE();
+                }
+
+                uint32_t readIndex(Type type)
+                {
+                    switch (type)
+                    {
+                    case Type::Int32: case Type::UInt32: return readRaw<uint32_t>();
+                    case Type::Int16: case Type::UInt16: return readRaw<uint16_t>();
+                    default: return (uint32_t)read(type);
+                    }
+                }
+
+                void skip(size_t size)
+                {
+                    if (size > getRemainingSize()) FALCOR_THROW("Unexpected end of PLY file.");
+                    mPtr += size;
+                }
+
+                /** Check that the remaining data can hold the given number of items before allocating storage for them.
+                    \param[in] count Number of items.
+                    \param[in] minItemSize Minimum size of an item in bytes.
+                */
+                void checkRemaining(size_t count, size_t minItemSize) const
+                {
+                    if (count > getRemainingSize() / std::max<size_t>(minItemSize, 1)) FALCOR_THROW("Unexpected end of PLY file.");
+                }
+
+                /// Minimum size of a value of the given type.
+                static size_t getMinValueSize(Type type) { return getTypeSize(type); }
+
+                const uint8_t* getPtr() const { return mPtr; }
+                size_t getRemainingSize() const { return size_t(mEnd - mPtr); }
+
+            private:
+                const uint8_t* mPtr;
+                const uint8_t* mEnd;
+                bool mSwapBytes;
+            };
+
+            /** Cursor over ASCII element data.
+            */
+            class AsciiCursor
+            {
+            public:
+                AsciiCursor(const char* begin, const char* end) : mPtr(begin), mEnd(end) {}
+
+                double read(Type type)
+                {
+                    std::string_view token = nextToken();
+                    double value = 0.0;
+                    std::from_chars_result result;
+                    if (type == Type::Float32 || type == Type::Float64)
+                    {
+                        result = std::from_chars(token.data(), token.data() + token.size(), value);
+                    }
+                    else
+                    {
+                        int64_t intValue = 0;
+                        result = std::from_chars(token.data(), token.data() + token.size(), intValue);
+                        value = (double)intValue;
+                    }
+                    if (result.ec != std::errc() || result.ptr != token.data() + token.size()) FALCOR_THROW("Invalid PLY value '{}'.", token);
+                    return value;
+                }
+
+                uint32_t readIndex(Type type) { return (uint32_t)read(type); }
+
+                /** Check that the remaining data can hold the given number of items before allocating storage for them.
+                    \param[in] count Number of items.
+                    \param[in] minItemSize Minimum size of an item in characters.
+                */
+                void checkRemaining(size_t count, size_t minItemSize) const
+                {
+                    if (count > size_t(mEnd - mPtr) / std::max<size_t>(minItemSize, 1)) FALCOR_THROW("Unexpected end of PLY file.");
+                }
+
+                /// Minimum size of a value, each value is at least one character.
+                static size_t getMinValueSize(Type) { return 1; }
+
+            private:
+                std::string_view nextToken()
+                {
+                    while (mPtr < mEnd && std::isspace((unsigned char)*mPtr)) mPtr++;
+                    const char* start = mPtr;
+                    while (mPtr < mEnd && !std::isspace((unsigned char)*mPtr)) mPtr++;
+                    if (mPtr == start) FALCOR_THROW("Unexpected end of PLY file.");
+                    return std::string_view(start, mPtr - start);
+                }
+
+                const char* mPtr;
+                const char* mEnd;
+            };
+
+            template<typename Cursor>
+            void readVertices(Cursor& cursor, const Element& element, const std::vector<Attribute>& attributes, Mesh& mesh)
+            {
+                mesh.vertices.resize(element.count);
+                for (auto& vertex : mesh.vertices)
+                {
+                    vertex = {};
+                    for (size_t i = 0; i < element.properties.size(); i++)
+                    {
+                        const auto& property = element.properties[i];
+                        if (property.isList)
+                        {
+                            uint32_t count = cursor.readIndex(property.countType);
+                            for (uint32_t j = 0; j < count; j++) cursor.read(property.type);
+                            continue;
+                        }
+                        float value = (float)cursor.read(property.type);
+                        switch (attributes[i])
+                        {
+                        case Attribute::PositionX: vertex.position.x = value; break;
+                        case Attribute::PositionY: vertex.position.y = value; break;
+                        case Attribute::PositionZ: vertex.position.z = value; break;
+                        case Attribute::NormalX: vertex.normal.x = value; break;
+                        case Attribute::NormalY: vertex.normal.y = value; break;
+                        case Attribute::NormalZ: vertex.normal.z = value; break;
+                        case Attribute::TexCoordU: vertex.texCoord.x = value; break;
+                        case Attribute::TexCoordV: vertex.texCoord.y = value; break;
+                        default: break;
+                        }
+                    }
+                }
+            }
+
+            /// Fast path for binary vertices in host byte order with only 32-bit float properties.
+            void readFloatVertices(BinaryCursor& cursor, const Element& element, const std::vector<Attribute>& attributes, Mesh& mesh)
+            {
+                const size_t stride = element.properties.size() * sizeof(float);
+                const uint8_t* data = cursor.getPtr();
+                cursor.checkRemaining(element.count, stride);
+                cursor.skip(stride * element.count);
+
+                int offsets[9];
+                for (int& offset : offsets) offset = -1;
+                for (size_t i = 0; i < attributes.size(); i++) offsets[(size_t)attributes[i]] = int(i * sizeof(float));
+                auto get = [&](const uint8_t* src, Attribute attribute)
+                {
+                    int offset = offsets[(size_t)attribute];
+                    float value = 0.f;
+                    if (offset >= 0) std::memcpy(&value, src + offset, sizeof(float));
+                    return value;
+                };
+
+                mesh.vertices.resize(element.count);
+                for (size_t i = 0; i < element.count; i++)
+                {
+                    const uint8_t* src = data + i * stride;
+                    auto& vertex = mesh.vertices[i];
+                    vertex.position = float3(get(src, Attribute::PositionX), get(src, Attribute::PositionY), get(src, Attribute::PositionZ));
+                    vertex.normal = float3(get(src, Attribute::NormalX), get(src, Attribute::NormalY), get(src, Attribute::NormalZ));
+                    vertex.texCoord = float2(get(src, Attribute::TexCoordU), get(src, Attribute::TexCoordV));
+                }
+            }
+
+            template<typename Cursor>
+            void readFaces(Cursor& cursor, const Element& element, Mesh& mesh)
+            {
+                std::vector<uint32_t> polygon;
+                mesh.indices.reserve(mesh.indices.size() + element.count * 3);
+                for (size_t face = 0; face < element.count; face++)
+                {
+                    for (const auto& property : element.properties)
+                    {
+                        if (!property.isList)
+                        {
+                            cursor.read(property.type);
+                            continue;
+                        }
+
+                        uint32_t count = cursor.readIndex(property.countType);
+                        const bool isIndices = property.name == "vertex_indices" || property.name == "vertex_index";
+                        if (!isIndices)
+                        {
+                            for (uint32_t j = 0; j < count; j++) cursor.read(property.type);
+                            continue;
+                        }
+
+                        cursor.checkRemaining(count, Cursor::getMinValueSize(property.type));
+                        polygon.resize(count);
+                        for (uint32_t j = 0; j < count; j++) polygon[j] = cursor.readIndex(property.type);
+
+                        // Triangulate as a fan.
+                        for (uint32_t j = 2; j < count; j++)
+                        {
+                            mesh.indices.push_back(polygon[0]);
+                            mesh.indices.push_back(polygon[j - 1]);
+                            mesh.indices.push_back(polygon[j]);
+                        }
+                    }
+                }
+            }
+
+            template<typename Cursor>
+            void skipElement(Cursor& cursor, const Element& element)
+            {
+                for (size_t i = 0; i < element.count; i++)
+                {
+                    for (const auto& property : element.properties)
+                    {
+                        uint32_t count = property.isList ? cursor.readIndex(property.countType) : 1;
+                        for (uint32_t j = 0; j < count; j++) cursor.read(property.type);
+                    }
+                }
+            }
+
+            template<typename Cursor>
+            void readElements(Cursor& cursor, const std::vector<Element>& elements, Mesh& mesh, bool useFloatFastPath)
+            {
+                for (const auto& element : elements)
+                {
+                    // Reject element counts exceeding the file size before allocating storage for them.
+                    size_t minElementSize = 0;
+                    for (const auto& property : element.properties)
+                        minElementSize += Cursor::getMinValueSize(property.isList ? property.countType : property.type);
+                    cursor.checkRemaining(element.count, minElementSize);
+
+                    if (element.name == "vertex")
+                    {
+                        std::vector<Attribute> attributes;
+                        bool allFloat = true;
+                        for (const auto& property : element.properties)
+                        {
+                            attributes.push_back(getAttribute(property.name));
+                            allFloat &= !property.isList && property.type == Type::Float32;
+                        }
+
+                        if constexpr (std::is_same_v<Cursor, BinaryCursor>)
+                        {
+                            if (useFloatFastPath && allFloat)
+                            {
+                                readFloatVertices(cursor, element, attributes, mesh);
+                                continue;
+                            }
+                        }
+                        readVertices(cursor, element, attributes, mesh);
+                    }
+                    else if (element.name == "face")
+                    {
+                        readFaces(cursor, element, mesh);
+                    }
+                    else
+                    {
+                        skipElement(cursor, element);
+                    }
+                }
+            }
+        }
+
+        Mesh read(const void* data, size_t size)
+        {
+            const char* begin = static_cast<const char*>(data);
+            const char* end = begin + size;
+            const char* ptr = begin;
+
+            auto nextLine = [&]()
+            {
+                if (ptr >= end) FALCOR_THROW("Unexpected end of PLY header.");
+                const char* lineEnd = static_cast<const char*>(std::memchr(ptr, '\n', end - ptr));
+                if (!lineEnd) lineEnd = end;
+                std::string_view line(ptr, lineEnd - ptr);
+                ptr = lineEnd < end ? lineEnd + 1 : end;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                return line;
+            };
+
+            if (nextLine() != "ply") FALCOR_THROW("Not a PLY file.");
+
+            // Parse the header.
+            std::optional<Format> format;
+            std::vector<Element> elements;
+            while (true)
+            {
+                auto tokens = splitTokens(nextLine());
+                if (tokens.empty()) continue;
+
+                if (tokens[0] == "end_header")
+                {
+                    break;
+                }
+                else if (tokens[0] == "format")
+                {
+                    if (tokens.size() < 2) FALCOR_THROW("Invalid PLY format line.");
+                    if (tokens[1] == "ascii") format = Format::Ascii;
+                    else if (tokens[1] == "binary_little_endian") format = Format::BinaryLittleEndian;
+                    else if (tokens[1] == "binary_big_endian") format = Format::BinaryBigEndian;
+                    else FALCOR_THROW("Unknown PLY format '{}'.", tokens[1]);
+                }
+                else if (tokens[0] == "element")
+                {
+                    if (tokens.size() < 3) FALCOR_THROW("Invalid PLY element line.");
+                    Element element;
+                    element.name = tokens[1];
+                    auto result = std::from_chars(tokens[2].data(), tokens[2].data() + tokens[2].size(), element.count);
+                    if (result.ec != std::errc()) FALCOR_THROW("Invalid PLY element count '{}'.", tokens[2]);
+                    elements.push_back(std::move(element));
+                }
+                else if (tokens[0] == "property")
+                {
+                    if (elements.empty()) FALCOR_THROW("PLY property without element.");
+                    Property property;
+                    if (tokens.size() >= 5 && tokens[1] == "list")
+                    {
+                        property.isList = true;
+                        property.countType = parseType(tokens[2]);
+                        property.type = parseType(tokens[3]);
+                        property.name = tokens[4];
+                    }
+                    else if (tokens.size() >= 3)
+                    {
+                        property.type = parseType(tokens[1]);
+                        property.name = tokens[2];
+                    }
+                    else
+                    {
+                        FALCOR_THROW("Invalid PLY property line.");
+                    }
+                    elements.back().properties.push_back(std::move(property));
+                }
+                // Ignore comment, obj_info and unknown lines.
+            }
+
+            if (!format) FALCOR_THROW("Missing PLY format.");
+
+            Mesh mesh;
+            for (const auto& element : elements)
+            {
+                if (element.name != "vertex") continue;
+                for (const auto& property : element.properties)
+                {
+                    Attribute attribute = getAttribute(property.name);
+                    mesh.hasNormals |= attribute == Attribute::NormalX;
+                    mesh.hasTexCoords |= attribute == Attribute::TexCoordU;
+                }
+            }
+
+            if (*format == Format::Ascii)
+            {
+                AsciiCursor cursor(ptr, end);
+                readElements(cursor, elements, mesh, false);
+            }
+            else
+            {
+                // Swap bytes only if the file byte order differs from the host byte order.
+                const bool swapBytes = (*format == Format::BinaryBigEndian) == isHostLittleEndian();
+                BinaryCursor cursor(reinterpret_cast<const uint8_t*>(ptr), reinterpret_cast<const uint8_t*>(end), swapBytes);
+                readElements(cursor, elements, mesh, !swapBytes);
+            }
+
+            for (uint32_t index : mesh.indices)
+            {
+                if (index >= mesh.vertices.size()) FALCOR_THROW("PLY vertex index {} out of range (vertex count {}).", index, mesh.vertices.size());
+            }
+
+            return mesh;
+        }
+
+        Mesh readFile(const std::filesystem::path& path)
+        {
+            MemoryMappedFile file(path, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+            if (!file.isOpen()) FALCOR_THROW("Failed to open PLY file '{}'.", path);
+            return read(file.getData(), file.getMappedSize());
+        }
+    }
+}
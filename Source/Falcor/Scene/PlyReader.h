@@ -0,0 +1,64 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "TriangleMesh.h"
+#include "Core/Macros.h"
+#include <filesystem>
+
+namespace Falcor
+{
+    /** Reader for PLY polygon files.
+
+        Supports ASCII as well as little and big endian binary files. Vertex positions, normals and
+        texture coordinates are decoded directly into TriangleMesh vertices, polygons are triangulated
+        as fans. All other elements and properties are skipped.
+    */
+    namespace PlyReader
+    {
+        struct Mesh
+        {
+            TriangleMesh::VertexList vertices;
+            TriangleMesh::IndexList indices;
+            bool hasNormals = false;    ///< True if the file has vertex normals (nx, ny, nz).
+            bool hasTexCoords = false;  ///< True if the file has vertex texture coordinates (u/s/texture_u, v/t/texture_v).
+        };
+
+        /** Parse a PLY file from memory. Throws a RuntimeError if the data is malformed.
+            \param[in] data File data.
+            \param[in] size File size in bytes.
+            \return The decoded mesh.
+        */
+        FALCOR_API Mesh read(const void* data, size_t size);
+
+        /** Read a PLY file by mapping it into memory. Throws a RuntimeError if the file cannot be read or is malformed.
+            \param[in] path File path.
+            \return The decoded mesh.
+        */
+        FALCOR_API Mesh readFile(const std::filesystem::path& path);
+    }
+}
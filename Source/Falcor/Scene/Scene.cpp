@@ -45,6 +45,7 @@
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/Profiler.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "Utils/UI/InputTypes.h"
 #include "Utils/Scripting/ScriptWriter.h"
 #include "Utils/NumericRange.h"
@@ -145,6 +146,42 @@ namespace Falcor
         {
             return determinant(float3x3(m)) < 0.f;
         }
+
+        // Returns the local vertex indices within the mesh for a triangle.
+        uint3 getMeshTriangleIndices(const MeshDesc& desc, const uint8_t* indexData8, uint32_t triangleIndex)
+        {
+            uint3 vidx;
+            if (desc.useVertexIndices())
+            {
+                FALCOR_ASSERT(indexData8 != nullptr);
+                uint baseIndex = desc.ibOffset * 4;
+                if (desc.use16BitIndices())
+                {
+                    baseIndex += triangleIndex * 3 * sizeof(uint16_t);
+                    vidx[0] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[0];
+                    vidx[1] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[1];
+                    vidx[2] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[2];
+                }
+                else
+                {
+                    baseIndex += triangleIndex * 3 * sizeof(uint32_t);
+                    vidx[0] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[0];
+                    vidx[1] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[1];
+                    vidx[2] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[2];
+                }
+            }
+            else
+            {
+                uint baseIndex = triangleIndex * 3;
+                vidx[0] = baseIndex + 0;
+                vidx[1] = baseIndex + 1;
+                vidx[2] = baseIndex + 2;
+            }
+            FALCOR_ASSERT(vidx[0] < desc.vertexCount);
+            FALCOR_ASSERT(vidx[1] < desc.vertexCount);
+            FALCOR_ASSERT(vidx[2] < desc.vertexCount);
+            return vidx;
+        }
     }
 
     const FileDialogFilterVec& Scene::getFileExtensionFilters()
@@ -164,6 +201,7 @@ namespace Falcor
 
     Scene::Scene(ref<Device> pDevice, SceneData&& sceneData)
         : mpDevice(pDevice)
+        , mpUploadBatcher(std::make_unique<UploadBatcher>(pDevice))
     {
         // Copy/move scene data to member variables.
         mPath = sceneData.path;
@@ -227,6 +265,7 @@ namespace Falcor
         createMeshVao(sceneData.meshDrawCount, sceneData.meshIndexData, sceneData.meshStaticData, sceneData.meshSkinningData);
         createCurveVao(mCurveIndexData, mCurveStaticData);
         createMeshUVTiles(mMeshDesc, sceneData.meshIndexData, sceneData.meshStaticData);
+        createEmissiveMeshGeometry(sceneData.meshIndexData, sceneData.meshStaticData);
 
         // Create animation controller.
         mpAnimationController = std::make_unique<AnimationController>(mpDevice, this, sceneData.meshStaticData, sceneData.meshSkinningData, sceneData.prevVertexCount, sceneData.animations);
@@ -572,36 +611,7 @@ namespace Falcor
             for (uint tidx = 0; tidx < tcount; ++tidx)
             {
                 // Compute local vertex indices within the mesh.
-                uint32_t vidx[3] = {};
-                if (desc.useVertexIndices())
-                {
-                    FALCOR_ASSERT(indexData8 != nullptr);
-                    uint baseIndex = desc.ibOffset * 4;
-                    if (desc.use16BitIndices())
-                    {
-                        baseIndex += tidx * 3 * sizeof(uint16_t);
-                        vidx[0] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[0];
-                        vidx[1] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[1];
-                        vidx[2] = reinterpret_cast<const uint16_t*>(indexData8 + baseIndex)[2];
-                    }
-                    else
-                    {
-                        baseIndex += tidx * 3 * sizeof(uint32_t);
-                        vidx[0] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[0];
-                        vidx[1] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[1];
-                        vidx[2] = reinterpret_cast<const uint32_t*>(indexData8 + baseIndex)[2];
-                    }
-                }
-                else
-                {
-                    uint baseIndex = tidx * 3;
-                    vidx[0] = baseIndex + 0;
-                    vidx[1] = baseIndex + 1;
-                    vidx[2] = baseIndex + 2;
-                }
-                FALCOR_ASSERT(vidx[0] < desc.vertexCount);
-                FALCOR_ASSERT(vidx[1] < desc.vertexCount);
-                FALCOR_ASSERT(vidx[2] < desc.vertexCount);
+                uint3 vidx = getMeshTriangleIndices(desc, indexData8, tidx);
 
                 // Load vertices from global vertex buffer.
                 // Note that the mesh local vbOffset is added to address into the global vertex buffer.
@@ -642,6 +652,57 @@ namespace Falcor
         std::for_each(std::execution::par_unseq, range.begin(), range.end(), processMeshTile);
     }
 
+    void Scene::createEmissiveMeshGeometry(const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData)
+    {
+        // Find the static meshes that are instanced with an emissive material.
+        // Dynamic meshes are excluded as their vertices are updated on the GPU.
+        std::vector<bool> isEmissiveMesh(mMeshDesc.size(), false);
+        for (const auto& instance : mGeometryInstanceData)
+        {
+            if (instance.getType() != GeometryType::TriangleMesh) continue;
+            if (mMeshDesc[instance.geometryID].isDynamic()) continue;
+            auto pMaterial = getMaterial(MaterialID::fromSlang(instance.materialID))->toBasicMaterial();
+            if (pMaterial && pMaterial->isEmissive()) isEmissiveMesh[instance.geometryID] = true;
+        }
+
+        const uint8_t* indexData8 = reinterpret_cast<const uint8_t*>(indexData.data());
+        mEmissiveMeshGeometry.clear();
+        mEmissiveMeshGeometry.resize(mMeshDesc.size());
+
+        auto copyMesh = [&](size_t meshIndex)
+        {
+            if (!isEmissiveMesh[meshIndex]) return;
+
+            const MeshDesc& desc = mMeshDesc[meshIndex];
+            MeshGeometry& geometry = mEmissiveMeshGeometry[meshIndex];
+            const uint triangleCount = desc.getTriangleCount();
+            geometry.positions.resize((size_t)triangleCount * 3);
+            geometry.texCrds.resize((size_t)triangleCount * 3);
+
+            FALCOR_ASSERT((size_t)desc.vbOffset + desc.vertexCount <= staticData.size());
+            for (uint tidx = 0; tidx < triangleCount; ++tidx)
+            {
+                uint3 vidx = getMeshTriangleIndices(desc, indexData8, tidx);
+                for (uint j = 0; j < 3; j++)
+                {
+                    const PackedStaticVertexData& vertex = staticData[(size_t)desc.vbOffset + vidx[j]];
+                    geometry.positions[tidx * 3 + j] = vertex.position;
+                    geometry.texCrds[tidx * 3 + j] = vertex.texCrd;
+                }
+            }
+        };
+
+        auto range = NumericRange<size_t>(0, mMeshDesc.size());
+        std::for_each(std::execution::par, range.begin(), range.end(), copyMesh);
+    }
+
+    const Scene::MeshGeometry* Scene::getEmissiveMeshGeometry(MeshID meshID) const
+    {
+        if (meshID.get() >= mEmissiveMeshGeometry.size()) return nullptr;
+        const MeshGeometry& geometry = mEmissiveMeshGeometry[meshID.get()];
+        return geometry.positions.empty() ? nullptr : &geometry;
+    }
+
     void Scene::setSDFGridConfig()
     {
         if (mSDFGrids.empty()) return;
@@ -914,43 +975,98 @@ namespace Falcor
         }
     }
 
-    void Scene::updateGeometryInstances(bool forceUpdate)
+    void Scene::createMatrixInstanceMap()
     {
-        if (mGeometryInstanceData.empty()) return;
+        // Bucket the geometry instances by global matrix ID (CSR layout).
+        // This allows the per-frame update to visit only the instances affected by changed matrices.
+        const size_t matrixCount = mSceneGraph.size();
+        mMatrixInstanceOffsets.assign(matrixCount + 1, 0);
+        for (const auto& inst : mGeometryInstanceData)
+        {
+            FALCOR_ASSERT(inst.globalMatrixID < matrixCount);
+            mMatrixInstanceOffsets[inst.globalMatrixID + 1]++;
+        }
+        for (size_t i = 0; i < matrixCount; i++) mMatrixInstanceOffsets[i + 1] += mMatrixInstanceOffsets[i];
+
+        mMatrixInstances.resize(mGeometryInstanceData.size());
+        std::vector<uint32_t> writeOffsets(mMatrixInstanceOffsets.begin(), mMatrixInstanceOffsets.end() - 1);
+        for (uint32_t instanceID = 0; instanceID < (uint32_t)mGeometryInstanceData.size(); instanceID++)
+        {
+            mMatrixInstances[writeOffsets[mGeometryInstanceData[instanceID].globalMatrixID]++] = instanceID;
+        }
+
+        mDirtyGeometryInstances.clear();
+    }
+
+    bool Scene::updateGeometryInstance(GeometryInstanceData& inst)
+    {
+        if (inst.getType() != GeometryType::TriangleMesh && inst.getType() != GeometryType::DisplacedTriangleMesh) return false;
 
-        bool dataChanged = false;
         const auto& globalMatrices = mpAnimationController->getGlobalMatrices();
+        uint32_t prevFlags = inst.flags;
 
-        for (auto& inst : mGeometryInstanceData)
-        {
-            if (inst.getType() == GeometryType::TriangleMesh || inst.getType() == GeometryType::DisplacedTriangleMesh)
-            {
-                uint32_t prevFlags = inst.flags;
+        FALCOR_ASSERT(inst.globalMatrixID < globalMatrices.size());
+        const float4x4& transform = globalMatrices[inst.globalMatrixID];
+        bool isTransformFlipped = doesTransformFlip(transform);
+        bool isObjectFrontFaceCW = getMesh(MeshID::fromSlang(inst.geometryID)).isFrontFaceCW();
+        bool isWorldFrontFaceCW = isObjectFrontFaceCW ^ isTransformFlipped;
 
-                FALCOR_ASSERT(inst.globalMatrixID < globalMatrices.size());
-                const float4x4& transform = globalMatrices[inst.globalMatrixID];
-                bool isTransformFlipped = doesTransformFlip(transform);
-                bool isObjectFrontFaceCW = getMesh(MeshID::fromSlang(inst.geometryID)).isFrontFaceCW();
-                bool isWorldFrontFaceCW = isObjectFrontFaceCW ^ isTransformFlipped;
+        if (isTransformFlipped) inst.flags |= (uint32_t)GeometryInstanceFlags::TransformFlipped;
+        else inst.flags &= ~(uint32_t)GeometryInstanceFlags::TransformFlipped;
 
-                if (isTransformFlipped) inst.flags |= (uint32_t)GeometryInstanceFlags::TransformFlipped;
-                else inst.flags &= ~(uint32_t)GeometryInstanceFlags::TransformFlipped;
+        if (isObjectFrontFaceCW) inst.flags |= (uint32_t)GeometryInstanceFlags::IsObjectFrontFaceCW;
+        else inst.flags &= ~(uint32_t)GeometryInstanceFlags::IsObjectFrontFaceCW;
 
-                if (isObjectFrontFaceCW) inst.flags |= (uint32_t)GeometryInstanceFlags::IsObjectFrontFaceCW;
-                else inst.flags &= ~(uint32_t)GeometryInstanceFlags::IsObjectFrontFaceCW;
+        if (isWorldFrontFaceCW) inst.flags |= (uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
+        else inst.flags &= ~(uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
 
-                if (isWorldFrontFaceCW) inst.flags |= (uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
-                else inst.flags &= ~(uint32_t)GeometryInstanceFlags::IsWorldFrontFaceCW;
+        return inst.flags != prevFlags;
+    }
 
-                dataChanged |= (inst.flags != prevFlags);
-            }
-        }
+    void Scene::updateGeometryInstances(bool forceUpdate)
+    {
+        if (mGeometryInstanceData.empty()) return;
 
-        if (forceUpdate || dataChanged)
+        if (forceUpdate)
         {
+            for (auto& inst : mGeometryInstanceData) updateGeometryInstance(inst);
+
             uint32_t byteSize = (uint32_t)(mGeometryInstanceData.size() * sizeof(GeometryInstanceData));
-            mpGeometryInstancesBuffer->setBlob(mGeometryInstanceData.data(), 0, byteSize);
+            mpUploadBatcher->write(mpGeometryInstancesBuffer, 0, mGeometryInstanceData.data(), byteSize);
+            mDirtyGeometryInstances.clear();
+            return;
         }
+
+        // Only revisit the instances whose transform changed. The dirty list is gathered in ascending
+        // matrix order, sort it by instance ID so that the changed instances can be uploaded as ranges.
+        std::sort(mDirtyGeometryInstances.begin(), mDirtyGeometryInstances.end());
+        mDirtyGeometryInstances.erase(std::unique(mDirtyGeometryInstances.begin(), mDirtyGeometryInstances.end()), mDirtyGeometryInstances.end());
+
+        // Upload changed instances in contiguous ranges. Nearby ranges are merged to limit the number of copies.
+        const uint32_t kMaxRangeGap = 64;
+        uint32_t rangeBegin = 0;
+        uint32_t rangeEnd = 0;
+        auto flushRange = [&]()
+        {
+            if (rangeEnd == rangeBegin) return;
+            mpUploadBatcher->write(mpGeometryInstancesBuffer, rangeBegin * sizeof(GeometryInstanceData), &mGeometryInstanceData[rangeBegin], (rangeEnd - rangeBegin) * sizeof(GeometryInstanceData));
+        };
+
+        for (uint32_t instanceID : mDirtyGeometryInstances)
+        {
+            FALCOR_ASSERT(instanceID < mGeometryInstanceData.size());
+            if (!updateGeometryInstance(mGeometryInstanceData[instanceID])) continue;
+
+            if (rangeEnd == rangeBegin || instanceID > rangeEnd + kMaxRangeGap)
+            {
+                flushRange();
+                rangeBegin = instanceID;
+            }
+            rangeEnd = instanceID + 1;
+        }
+        flushRange();
+
+        mDirtyGeometryInstances.clear();
     }
 
     Scene::UpdateFlags Scene::updateRaytracingAABBData(bool forceUpdate)
@@ -1273,6 +1389,7 @@ namespace Falcor
 
         mpAnimationController->animate(pRenderContext, 0); // Requires Scene block to exist
         updateGeometry(pRenderContext, true); // Requires scene defines
+        createMatrixInstanceMap();
         updateGeometryInstances(true);
 
         updateBounds();
@@ -1290,6 +1407,7 @@ namespace Falcor
         updateGridVolumes(true);
         updateEnvMap(true);
         uploadGeometry();
+        mpUploadBatcher->flush(pRenderContext);
         bindParameterBlock(); // Bind final data after initialization is complete.
 
         // Update stats and UI data.
@@ -1637,8 +1755,7 @@ namespace Falcor
             auto changes = light->getChanges();
             if (changes != Light::Changes::None || is_set(combinedChanges, Light::Changes::Active) || forceUpdate)
             {
-                // TODO: This is slow since the buffer is not CPU writable. Copy into CPU buffer and upload once instead.
-                mpLightsBuffer->setElement(activeLightIndex, light->getData());
+                mpUploadBatcher->setElement(mpLightsBuffer, activeLightIndex, light->getData());
             }
 
             activeLightIndex++;
@@ -1693,8 +1810,8 @@ namespace Falcor
         // Early out if no volumes have changed.
         if (!forceUpdate && combinedUpdates == GridVolume::UpdateFlags::None) return UpdateFlags::None;
 
-        // Upload grids.
-        if (forceUpdate)
+        // Upload grids. Streamed grid sequences replace the grid resources when the frame changes.
+        if (forceUpdate || is_set(combinedUpdates, GridVolume::UpdateFlags::GridsChanged))
         {
             bindGridVolumes();
         }
@@ -1716,7 +1833,7 @@ namespace Falcor
                     data.transform = mul(data.transform, densityGrid->getTransform());
                     data.invTransform = mul(densityGrid->getInvTransform(), data.invTransform);
                 }
-                mpGridVolumesBuffer->setElement(volumeIndex, data);
+                mpUploadBatcher->setElement(mpGridVolumesBuffer, volumeIndex, data);
             }
             pGridVolume->clearUpdates();
             volumeIndex++;
@@ -1893,12 +2010,16 @@ namespace Falcor
             mUpdates |= UpdateFlags::SceneGraphChanged;
             if (mpAnimationController->hasSkinnedMeshes()) mUpdates |= UpdateFlags::MeshesChanged;
 
-            for (const auto& inst : mGeometryInstanceData)
+            // Gather the geometry instances affected by the changed matrices.
+            for (uint32_t matrixID : mpAnimationController->getChangedMatrices())
             {
-                if (mpAnimationController->isMatrixChanged(NodeID{ inst.globalMatrixID }))
-                {
-                    mUpdates |= UpdateFlags::GeometryMoved;
-                }
+                FALCOR_ASSERT(matrixID + 1 < mMatrixInstanceOffsets.size());
+                uint32_t begin = mMatrixInstanceOffsets[matrixID];
+                uint32_t end = mMatrixInstanceOffsets[matrixID + 1];
+                if (begin == end) continue;
+
+                mUpdates |= UpdateFlags::GeometryMoved;
+                mDirtyGeometryInstances.insert(mDirtyGeometryInstances.end(), mMatrixInstances.begin() + begin, mMatrixInstances.begin() + end);
             }
 
             // We might end up setting the flag even if curves haven't changed (if looping is disabled for example).
@@ -1925,6 +2046,9 @@ namespace Falcor
             updateGeometryInstances(false);
         }
 
+        // Upload the light, grid volume and geometry instance updates recorded above.
+        mpUploadBatcher->flush(pRenderContext);
+
         // Update existing BLASes if skinned animation and/or procedural primitives moved.
         bool updateProcedural = is_set(mUpdates, UpdateFlags::CurvesMoved) || is_set(mUpdates, UpdateFlags::CustomPrimitivesMoved);
         bool blasUpdateRequired = is_set(mUpdates, UpdateFlags::MeshesChanged) || updateProcedural;
@@ -1955,6 +2079,8 @@ namespace Falcor
         //}
         if (mpLightCollection && mpLightCollection->update(pRenderContext))
         {
+            // Rebind as the active triangle list may have been rebuilt.
+            mpLightCollection->bindShaderData(mpSceneBlock->getRootVar()["lightCollection"]);
             mUpdates |= UpdateFlags::LightCollectionChanged;
             mSceneStats.emissiveMemoryInBytes = mpLightCollection->getMemoryUsageInBytes();
         }
@@ -3243,6 +3369,7 @@ namespace Falcor
     void Scene::buildBlas(RenderContext* pRenderContext)
     {
         FALCOR_PROFILE(pRenderContext, "buildBlas");
+        FALCOR_LOAD_PHASE("Build BLAS");
 
         if (!mBlasDataValid) FALCOR_THROW("buildBlas() BLAS data is invalid");
         if (!pRenderContext->getDevice()->isFeatureSupported(Device::SupportedFeatures::Raytracing))
@@ -53,6 +53,7 @@
 #include "Utils/Math/Matrix.h"
 #include "Utils/UI/Gui.h"
 #include "Utils/Settings/Settings.h"
+#include "Utils/UploadBatcher.h"
 
 #include <functional>
 #include <memory>
@@ -338,6 +339,8 @@ namespace Falcor
             std::vector<uint32_t> meshIndexData;                    ///< Vertex indices for all meshes in either 32-bit or 16-bit format packed tightly, decided per mesh.
             std::vector<PackedStaticVertexData> meshStaticData;     ///< Vertex attributes for all meshes in packed format.
             std::vector<SkinningVertexData> meshSkinningData;       ///< Additional vertex attributes for skinned meshes.
+            uint32_t quantizedPositionBits = 0;                     ///< Position bits of the meshes stored quantized in the scene cache (see VertexQuantization), or zero if none.
+            std::vector<uint32_t> quantizedMeshes;                  ///< IDs of meshes whose static vertex data is stored quantized in the scene cache.
 
             // Curve data
             std::vector<CurveDesc> curveDesc;                       ///< List of curve descriptors.
@@ -721,6 +724,22 @@ namespace Falcor
         */
         const MeshDesc& getMesh(MeshID meshID) const { return mMeshDesc[meshID.get()]; }
 
+        /** Object-space triangle geometry of a mesh (non-indexed, three vertices per triangle).
+        */
+        struct MeshGeometry
+        {
+            std::vector<float3> positions;  ///< Vertex positions in object space.
+            std::vector<float2> texCrds;    ///< Vertex texture coordinates.
+        };
+
+        /** Get a CPU copy of the geometry of an emissive mesh.
+            A copy is kept for static meshes that are instanced with an emissive material when the scene is created.
+            This allows the light collection to build the mesh lights without reading back GPU data.
+            \param[in] meshID Mesh ID.
+            \return The mesh geometry, or nullptr if no copy is available.
+        */
+        const MeshGeometry* getEmissiveMeshGeometry(MeshID meshID) const;
+
         /** Get mesh vertex and index data.
             \param[in] meshID Mesh ID.
             \param[in] buffers Map of buffers containing mesh data: "triangleIndices", "positions", and "texcrds" are required.
@@ -1139,6 +1158,7 @@ namespace Falcor
         void createMeshVao(uint32_t drawCount, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData, const std::vector<SkinningVertexData>& skinningData);
         void createCurveVao(const std::vector<uint32_t>& indexData, const std::vector<StaticCurveVertexData>& staticData);
         void createMeshUVTiles(const std::vector<MeshDesc>& meshDesc, const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData);
+        void createEmissiveMeshGeometry(const std::vector<uint32_t>& indexData, const std::vector<PackedStaticVertexData>& staticData);
 
         void updateSceneDefines();
         DefineList getSceneSDFGridDefines() const;
@@ -1163,10 +1183,22 @@ namespace Falcor
         */
         void updateBounds();
 
+        /** Build the mapping from global matrices to the geometry instances using them.
+        */
+        void createMatrixInstanceMap();
+
         /** Update geometry instances.
+            If not forced, only the instances in mDirtyGeometryInstances are updated and uploaded.
+            \param[in] forceUpdate Update and upload all instances.
         */
         void updateGeometryInstances(bool forceUpdate);
 
+        /** Update the flags of a single geometry instance from its current transform.
+            \param[in,out] inst Geometry instance.
+            \return True if the instance data changed.
+        */
+        bool updateGeometryInstance(GeometryInstanceData& inst);
+
         /** Update geometry type flags.
         */
         void updateGeometryTypes();
@@ -1268,6 +1300,9 @@ namespace Falcor
         GeometryTypeFlags mGeometryTypes;                           ///< Set of geometry types that exist in the scene.
 
         std::vector<GeometryInstanceData> mGeometryInstanceData;    ///< Geometry instance data (for all types of geometry).
+        std::vector<uint32_t> mMatrixInstanceOffsets;               ///< Per global matrix, offset into mMatrixInstances. Has one extra entry for the end offset.
+        std::vector<uint32_t> mMatrixInstances;                     ///< Geometry instance IDs grouped by global matrix ID.
+        std::vector<uint32_t> mDirtyGeometryInstances;              ///< Geometry instances whose transform changed since the last call to updateGeometryInstances().
 
         bool mUseCompressedHitInfo = false;                         ///< True if scene should used compressed HitInfo (on scenes with triangles meshes only).
         bool mHas16BitIndices = false;                              ///< True if any meshes use 16-bit indices.
@@ -1281,6 +1316,7 @@ namespace Falcor
         // Triangle meshes
         std::vector<MeshDesc> mMeshDesc;                            ///< Copy of mesh data GPU buffer (mpMeshesBuffer).
         std::vector<std::vector<Rectangle>> mMeshUVTiles;           ///< Bounding tiles for the mesh UVs
+        std::vector<MeshGeometry> mEmissiveMeshGeometry;            ///< CPU copy of the geometry of emissive meshes, indexed by mesh ID. Empty for other meshes.
         std::vector<MeshGroup> mMeshGroups;                         ///< Groups of meshes. Each group maps to a BLAS for ray tracing.
         std::vector<std::string> mMeshNames;                        ///< Mesh names, indxed by mesh ID
         std::vector<Node> mSceneGraph;                              ///< For each index i, the array element indicates the parent node. Indices are in relation to mLocalToWorldMatrices.
@@ -1363,6 +1399,7 @@ namespace Falcor
         ref<Buffer> mpLightsBuffer;
         ref<Buffer> mpGridVolumesBuffer;
         ref<ParameterBlock> mpSceneBlock;
+        std::unique_ptr<UploadBatcher> mpUploadBatcher;             ///< Batches the per-frame updates of the scene block buffers.
 
         // Camera
         UpDirection mUpDirection = UpDirection::YPos;
@@ -27,19 +27,24 @@
  **************************************************************************/
 #include "SceneBuilder.h"
 #include "SceneCache.h"
+#include "MeshCache.h"
+#include "MeshLayoutOptimizer.h"
+#include "TangentGenerator.h"
+#include "VertexQuantization.h"
 #include "Importer.h"
 #include "Curves/CurveConfig.h"
 #include "Material/StandardMaterial.h"
 #include "Utils/Logger.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Image/TextureAnalyzer.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Scripting/ScriptBindings.h"
 #include "Utils/Math/MathHelpers.h"
 #include "Utils/ObjectIDPython.h"
 #include "Utils/NumericRange.h"
-#include <mikktspace.h>
 #include <filesystem>
+#include <fstream>
 #include <cmath>
 #include <execution>
 
@@ -62,93 +67,6 @@ namespace Falcor
             else return 2;
         }
 
-        class MikkTSpaceWrapper
-        {
-        public:
-            static std::vector<float4> generateTangents(const SceneBuilder::Mesh& mesh)
-            {
-                if (!mesh.normals.pData || !mesh.positions.pData || !mesh.texCrds.pData || !mesh.pIndices)
-                {
-                    logWarning("Can't generate tangent space. The mesh '{}' doesn't have positions/normals/texCrd/indices.", mesh.name);
-                    return {};
-                }
-
-                // Generate new tangent space.
-                SMikkTSpaceInterface mikktspace = {};
-                mikktspace.m_getNumFaces = [](const SMikkTSpaceContext* pContext) { return ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getFaceCount(); };
-                mikktspace.m_getNumVerticesOfFace = [](const SMikkTSpaceContext* pContext, int32_t face) { return 3; };
-                mikktspace.m_getPosition = [](const SMikkTSpaceContext* pContext, float position[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getPosition(position, face, vert); };
-                mikktspace.m_getNormal = [](const SMikkTSpaceContext* pContext, float normal[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getNormal(normal, face, vert); };
-                mikktspace.m_getTexCoord = [](const SMikkTSpaceContext* pContext, float texCrd[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getTexCrd(texCrd, face, vert); };
-                mikktspace.m_setTSpaceBasic = [](const SMikkTSpaceContext* pContext, const float tangent[], float sign, int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->setTangent(tangent, sign, face, vert); };
-
-                MikkTSpaceWrapper wrapper(mesh);
-                SMikkTSpaceContext context = {};
-                context.m_pInterface = &mikktspace;
-                context.m_pUserData = &wrapper;
-
-                if (genTangSpaceDefault(&context) == false)
-                {
-                    FALCOR_THROW("MikkTSpace failed to generate tangents for the mesh '{}'.", mesh.name);
-                }
-
-                return wrapper.mTangents;
-            }
-
-        private:
-            MikkTSpaceWrapper(const SceneBuilder::Mesh& mesh)
-                : mMesh(mesh)
-            {
-                FALCOR_ASSERT(mesh.indexCount > 0);
-                mTangents.resize(mesh.indexCount, float4(0));
-
-                FALCOR_ASSERT_EQ(mesh.indexCount, mMesh.faceCount * 3);
-                mPositions.resize(mMesh.faceCount * 3);
-                switch (mMesh.positions.frequency)
-                {
-                case SceneBuilder::Mesh::AttributeFrequency::Constant:
-                {
-                    std::fill_n(mPositions.begin(), mPositions.size(), mMesh.positions.pData[0]);
-                    break;
-                }
-                case SceneBuilder::Mesh::AttributeFrequency::Uniform:
-                {
-                    for (uint32_t i = 0; i < mMesh.faceCount; ++i)
-                        std::fill_n(mPositions.begin() + i * 3, 3, mMesh.positions.pData[i]);
-                    break;
-                }
-                case SceneBuilder::Mesh::AttributeFrequency::Vertex:
-                {
-                    FALCOR_ASSERT_EQ(mesh.indexCount, mPositions.size());
-                    for (size_t fvarIdx = 0; fvarIdx < mPositions.size(); ++fvarIdx)
-                        mPositions[fvarIdx] = mMesh.positions.pData[mMesh.pIndices[fvarIdx]];
-                    break;
-                }
-                case SceneBuilder::Mesh::AttributeFrequency::FaceVarying:
-                {
-                    memcpy(mPositions.data(), mMesh.positions.pData, mPositions.size() * sizeof(float3));
-                    break;
-                }
-                default:
-                    FALCOR_UNREACHABLE();
-                }
-
-            }
-            const SceneBuilder::Mesh& mMesh;
-            std::vector<float4> mTangents;
-            std::vector<float3> mPositions;
-            int32_t getFaceCount() const { return (int32_t)mMesh.faceCount; }
-            void getPosition(float position[], int32_t face, int32_t vert) const { FALCOR_ASSERT_LT(size_t(face) * 3 + vert, mPositions.size()); memcpy(position, mPositions.data() + (face * 3 + vert), sizeof(float3)); }
-            void getNormal(float normal[], int32_t face, int32_t vert) { *reinterpret_cast<float3*>(normal) = mMesh.getNormal(face, vert); }
-            void getTexCrd(float texCrd[], int32_t face, int32_t vert) { *reinterpret_cast<float2*>(texCrd) = mMesh.getTexCrd(face, vert); }
-
-            void setTangent(const float tangent[], float sign, int32_t face, int32_t vert)
-            {
-                float3 T = *reinterpret_cast<const float3*>(tangent);
-                mTangents[face * 3 + vert] = float4(normalize(T), sign);
-            }
-        };
-
         void validateVertex(const SceneBuilder::Mesh::Vertex& v, size_t& invalidCount, size_t& zeroCount)
         {
             auto isInvalid = [](const auto& x)
@@ -177,6 +95,16 @@ namespace Falcor
             return true;
         }
 
+        /** Run a function on each element of a range, in parallel unless serial execution is requested.
+            The parallel policy is not vectorized (par_unseq), as the functions may allocate.
+        */
+        template<typename Iterator, typename Func>
+        void forEach(bool parallel, Iterator first, Iterator last, Func&& func)
+        {
+            if (parallel) std::for_each(std::execution::par, first, last, std::forward<Func>(func));
+            else std::for_each(first, last, std::forward<Func>(func));
+        }
+
         std::vector<uint32_t> compact16BitIndices(const std::vector<uint32_t>& indices)
         {
             if (indices.empty()) return {};
@@ -206,7 +134,7 @@ namespace Falcor
     SceneBuilder::SceneBuilder(ref<Device> pDevice, const Settings& settings, Flags flags)
         : mpDevice(pDevice)
         , mSettings(settings)
-        , mFlags(flags)
+        , mFlags(is_set(flags, Flags::CompactSceneCacheVertices21Bit) ? flags | Flags::CompactSceneCacheVertices : flags)
     {
         mAssetResolver = AssetResolver::getDefaultResolver();
         mSceneData.pMaterials = std::make_unique<MaterialSystem>(mpDevice);
@@ -222,7 +150,7 @@ namespace Falcor
         }
 
         // Compute scene cache key based on absolute scene path and build flags.
-        mSceneCacheKey = computeSceneCacheKey(resolvedPath, flags);
+        mSceneCacheKey = computeSceneCacheKey(resolvedPath, mFlags);
 
         // Determine if scene cache should be written after import.
         bool useCache = is_set(flags, Flags::UseCache);
@@ -234,6 +162,7 @@ namespace Falcor
         {
             try
             {
+                FALCOR_LOAD_PHASE("Reading scene cache");
                 mpScene = Scene::create(pDevice, SceneCache::readCache(pDevice, mSceneCacheKey));
                 return;
             }
@@ -283,6 +212,7 @@ namespace Falcor
         mSceneData.path = resolvedPath;
         if (auto importer = Importer::create(getExtensionFromPath(resolvedPath)))
         {
+            FALCOR_LOAD_PHASE("Import");
             importer->importScene(resolvedPath, *this, materialToShortName);
         }
         else
@@ -299,6 +229,7 @@ namespace Falcor
         mSceneData.path = "";
         if (auto importer = Importer::create(extension))
         {
+            FALCOR_LOAD_PHASE("Import");
             importer->importSceneFromMemory(buffer, byteSize, extension, *this, materialToShortName);
         }
         else
@@ -323,8 +254,13 @@ namespace Falcor
     {
         if (mpScene) return mpScene;
 
+        FALCOR_LOAD_PHASE("Build scene");
+
         // Finish loading textures. This blocks until all textures are loaded and assigned.
-        mpMaterialTextureLoader.reset();
+        {
+            FALCOR_LOAD_PHASE("Finish texture loading");
+            mpMaterialTextureLoader.reset();
+        }
 
         // If no meshes were added, we create a dummy mesh to keep the scene generation working.
         // Scenes with no meshes can be useful for example when using volumes in isolation.
@@ -343,60 +279,100 @@ namespace Falcor
         // Post-process the scene data.
         TimeReport timeReport;
 
-        // Prepare displacement maps. This either removes them (if requested in build flags)
-        // or makes sure that normal maps are removed if displacement is in use.
-        prepareDisplacementMaps();
-
-        prepareSceneGraph();
-        prepareMeshes();
-        removeUnusedMeshes();
-        flattenStaticMeshInstances();
-        pretransformStaticMeshes();
-        unifyTriangleWinding();
-        optimizeSceneGraph();
-        calculateMeshBoundingBoxes();
-        createMeshGroups();
-        optimizeGeometry();
-        sortMeshes();
-        createGlobalBuffers();
-        createCurveGlobalBuffers();
-        collectVolumeGrids();
-        removeDuplicateSDFGrids();
+        {
+            FALCOR_LOAD_PHASE("Post processing geometry");
+
+            // Prepare displacement maps. This either removes them (if requested in build flags)
+            // or makes sure that normal maps are removed if displacement is in use.
+            prepareDisplacementMaps();
+
+            prepareSceneGraph();
+            prepareMeshes();
+            removeUnusedMeshes();
+            flattenStaticMeshInstances();
+            pretransformStaticMeshes();
+            unifyTriangleWinding();
+            optimizeSceneGraph();
+            calculateMeshBoundingBoxes();
+            createMeshGroups();
+            {
+                FALCOR_LOAD_PHASE("optimizeGeometry");
+                optimizeGeometry();
+            }
+            if (is_set(mFlags, Flags::OptimizeMeshLayout))
+            {
+                FALCOR_LOAD_PHASE("optimizeMeshLayout");
+                optimizeMeshLayout();
+            }
+            if (is_set(mFlags, Flags::CompactSceneCacheVertices))
+            {
+                FALCOR_LOAD_PHASE("selectCompactCacheMeshes");
+                selectCompactCacheMeshes();
+            }
+            sortMeshes();
+            {
+                FALCOR_LOAD_PHASE("createGlobalBuffers");
+                createGlobalBuffers();
+            }
+            createCurveGlobalBuffers();
+            collectVolumeGrids();
+            removeDuplicateSDFGrids();
+        }
 
         timeReport.measure("Post processing geometry");
 
-        optimizeMaterials();
-        removeDuplicateMaterials();
-        quantizeTexCoords();
+        {
+            FALCOR_LOAD_PHASE("Optimizing materials");
+            optimizeMaterials();
+            removeDuplicateMaterials();
+            quantizeTexCoords();
+        }
 
         timeReport.measure("Optimizing materials");
 
-        // Prepare scene resources.
-        createSceneGraph();
-        createMeshData();
-        createMeshBoundingBoxes();
-        createCurveData();
-        calculateCurveBoundingBoxes();
+        {
+            FALCOR_LOAD_PHASE("Preparing scene data");
+
+            // Prepare scene resources.
+            createSceneGraph();
+            createMeshData();
+            createMeshBoundingBoxes();
+            createCurveData();
+            calculateCurveBoundingBoxes();
 
-        // Create instance data.
-        uint32_t tlasInstanceIndex = 0;
-        createMeshInstanceData(tlasInstanceIndex);
-        createCurveInstanceData(tlasInstanceIndex);
-        // Adjust instance indices of SDF grid instances.
-        for (auto& sdfInstanceData : mSceneData.sdfGridInstances) sdfInstanceData.instanceIndex = tlasInstanceIndex++;
+            // Create instance data.
+            uint32_t tlasInstanceIndex = 0;
+            createMeshInstanceData(tlasInstanceIndex);
+            createCurveInstanceData(tlasInstanceIndex);
+            // Adjust instance indices of SDF grid instances.
+            for (auto& sdfInstanceData : mSceneData.sdfGridInstances) sdfInstanceData.instanceIndex = tlasInstanceIndex++;
 
-        mSceneData.useCompressedHitInfo = is_set(mFlags, Flags::UseCompressedHitInfo);
+            mSceneData.useCompressedHitInfo = is_set(mFlags, Flags::UseCompressedHitInfo);
+
+            auto& profiler = LoadProfiler::instance();
+            profiler.addCount("meshes", mSceneData.meshDesc.size());
+            profiler.addCount("meshInstances", mSceneData.meshInstanceData.size());
+            profiler.addCount("vertices", mSceneData.meshStaticData.size());
+            uint64_t triangleCount = 0;
+            for (const auto& meshDesc : mSceneData.meshDesc) triangleCount += meshDesc.getTriangleCount();
+            profiler.addCount("triangles", triangleCount);
+            profiler.addCount("materials", mSceneData.pMaterials->getMaterialCount());
+        }
 
         // Write scene cache if requested.
         if (mWriteSceneCache)
         {
+            FALCOR_LOAD_PHASE("Writing cache");
             SceneCache::writeCache(mSceneData, mSceneCacheKey);
             timeReport.measure("Writing cache");
         }
 
         // Create the scene object.
-        mpScene = Scene::create(mpDevice, std::move(mSceneData));
-        mSceneData = {};
+        {
+            FALCOR_LOAD_PHASE("Creating resources");
+            mpScene = Scene::create(mpDevice, std::move(mSceneData));
+            mSceneData = {};
+        }
 
         timeReport.measure("Creating resources");
         timeReport.printToLog();
@@ -411,7 +387,7 @@ namespace Falcor
         return addProcessedMesh(processMesh(mesh));
     }
 
-    MeshID SceneBuilder::addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated)
+    MeshID SceneBuilder::addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated, const std::optional<SHA1::MD>& cacheKey)
     {
         FALCOR_CHECK(pTriangleMesh != nullptr, "'pTriangleMesh' is missing");
         FALCOR_CHECK(pMaterial != nullptr, "'pMaterial' is missing");
@@ -430,6 +406,7 @@ namespace Falcor
         mesh.isFrontFaceCW = pTriangleMesh->getFrontFaceCW();
         mesh.pMaterial = pMaterial;
         mesh.isAnimated = isAnimated;
+        mesh.cacheKey = cacheKey;
 
         std::vector<float3> positions(vertices.size());
         std::vector<float3> normals(vertices.size());
@@ -455,6 +432,8 @@ namespace Falcor
         //  - Validate final vertex data
         //  - Compact vertices/indices into runtime format
 
+        FALCOR_LOAD_ITEM_PHASE("processMesh");
+
         // Copy the mesh desc so we can update it. The caller retains the ownership of the data.
         Mesh mesh = mesh_;
         ProcessedMesh processedMesh;
@@ -495,12 +474,24 @@ namespace Falcor
             if (mesh.boneWeights.pData == nullptr) throw_on_missing_element("bone weights");
         }
 
+        // Look up the processed mesh in the mesh cache.
+        // The cache is skipped if the caller needs the attribute indices or tangents, which are not cached.
+        // Meshes with a cache key from getMeshCacheKey() have already been looked up by the importer.
+        const bool useMeshCache = is_set(mFlags, Flags::UseCache) && !pAttributeIndices && !pTangents;
+        SHA1::MD meshCacheKey;
+        if (useMeshCache)
+        {
+            meshCacheKey = computeMeshCacheKey(mesh);
+            if (!mesh.cacheKey && readMeshCache(meshCacheKey, processedMesh)) return processedMesh;
+        }
+
         // Generate tangent space if that's required.
         std::vector<float4> localTangents;
         if (!pTangents)
             pTangents = &localTangents;
         if (!(is_set(mFlags, Flags::UseOriginalTangentSpace) || mesh.useOriginalTangentSpace) || !mesh.tangents.pData)
         {
+            FALCOR_LOAD_ITEM_PHASE("generateTangents");
             generateTangents(mesh, *pTangents);
         }
 
@@ -690,35 +681,141 @@ namespace Falcor
             }
         }
 
+        if (useMeshCache) MeshCache::instance().write(meshCacheKey, processedMesh);
+
         return processedMesh;
     }
 
-    void SceneBuilder::generateTangents(Mesh& mesh, std::vector<float4>& tangents)
+    std::optional<SHA1::MD> SceneBuilder::getMeshCacheKey(const std::vector<std::filesystem::path>& paths, std::string_view meshName) const
+    {
+        if (!is_set(mFlags, Flags::UseCache)) return {};
+
+        SHA1 sha1;
+        const Flags processingFlags = Flags::UseOriginalTangentSpace | Flags::NonIndexedVertices | Flags::Force32BitIndices | Flags::ReferenceTangentSpace;
+        sha1.update((uint32_t)(mFlags & processingFlags));
+        sha1.update(meshName);
+        sha1.update((uint8_t)0);
+
+        // Hash each file only once, importers typically load many meshes from the same file.
+        // The lock is held while hashing so that concurrent callers do not read the same file.
+        std::lock_guard<std::mutex> lock(mFileHashMutex);
+        for (const auto& path : paths)
+        {
+            auto it = mFileHashes.find(path);
+            if (it == mFileHashes.end())
+            {
+                std::ifstream fs(path, std::ios_base::binary);
+                if (!fs.good()) return {};
+
+                SHA1 fileSha1;
+                std::vector<char> buffer(1 << 20);
+                while (fs)
+                {
+                    fs.read(buffer.data(), buffer.size());
+                    fileSha1.update(buffer.data(), (size_t)fs.gcount());
+                }
+                if (fs.bad()) return {};
+                it = mFileHashes.emplace(path, fileSha1.finalize()).first;
+            }
+            sha1.update(it->second.data(), it->second.size());
+        }
+        return sha1.finalize();
+    }
+
+    bool SceneBuilder::isMeshCached(const SHA1::MD& cacheKey, const ref<Material>& pMaterial) const
+    {
+        FALCOR_CHECK(pMaterial != nullptr, "'pMaterial' is missing");
+        if (is_set(mFlags, Flags::RebuildCache)) return false;
+        return MeshCache::instance().contains(computeMeshCacheKey(cacheKey, pMaterial));
+    }
+
+    bool SceneBuilder::readCachedMesh(const Mesh& mesh, ProcessedMesh& processedMesh) const
+    {
+        FALCOR_CHECK(mesh.cacheKey.has_value(), "Mesh '{}' has no cache key", mesh.name);
+        FALCOR_CHECK(mesh.pMaterial != nullptr, "Mesh '{}' has no material", mesh.name);
+        if (!is_set(mFlags, Flags::UseCache)) return false;
+
+        processedMesh.name = mesh.name;
+        processedMesh.topology = mesh.topology;
+        processedMesh.pMaterial = mesh.pMaterial;
+        processedMesh.isFrontFaceCW = mesh.isFrontFaceCW;
+        processedMesh.isAnimated = mesh.isAnimated;
+        processedMesh.skeletonNodeId = mesh.skeletonNodeId;
+
+        return readMeshCache(computeMeshCacheKey(*mesh.cacheKey, mesh.pMaterial), processedMesh);
+    }
+
+    bool SceneBuilder::readMeshCache(const SHA1::MD& key, ProcessedMesh& processedMesh) const
+    {
+        if (!is_set(mFlags, Flags::RebuildCache) && MeshCache::instance().read(key, processedMesh))
+        {
+            LoadProfiler::instance().addCount("meshCacheHits", 1);
+            return true;
+        }
+        LoadProfiler::instance().addCount("meshCacheMisses", 1);
+        return false;
+    }
+
+    SHA1::MD SceneBuilder::computeMeshCacheKey(const SHA1::MD& cacheKey, const ref<Material>& pMaterial) const
+    {
+        // The key from getMeshCacheKey() covers the file content and the build flags.
+        // Texture coordinates are pre-transformed by the material's texture transform.
+        SHA1 sha1;
+        sha1.update(cacheKey.data(), cacheKey.size());
+        const float4x4 xform = pMaterial->getTextureTransform().getMatrix();
+        sha1.update(&xform, sizeof(xform));
+        return sha1.finalize();
+    }
+
+    SHA1::MD SceneBuilder::computeMeshCacheKey(const Mesh& mesh) const
     {
-        tangents = MikkTSpaceWrapper::generateTangents(mesh);
+        // The key covers everything processMesh() depends on, but not the mesh name or anything else that is
+        // copied to the processed mesh unchanged. Meshes with the same content share the cache entry.
+        if (mesh.cacheKey) return computeMeshCacheKey(*mesh.cacheKey, mesh.pMaterial);
+
+        SHA1 sha1;
+
+        const Flags processingFlags = Flags::UseOriginalTangentSpace | Flags::NonIndexedVertices | Flags::Force32BitIndices | Flags::ReferenceTangentSpace;
+        sha1.update((uint32_t)(mFlags & processingFlags));
+
+        sha1.update(mesh.faceCount);
+        sha1.update(mesh.vertexCount);
+        sha1.update(mesh.indexCount);
+        sha1.update((uint32_t)mesh.topology);
+        sha1.update(mesh.useOriginalTangentSpace);
+        sha1.update(mesh.mergeDuplicateVertices);
+        sha1.update(mesh.pIndices, mesh.indexCount * sizeof(uint32_t));
+
+        auto updateAttribute = [&](const auto& attribute)
+        {
+            sha1.update((uint32_t)attribute.frequency);
+            sha1.update(attribute.pData != nullptr);
+            if (attribute.pData) sha1.update(attribute.pData, mesh.getAttributeCount(attribute) * sizeof(attribute.pData[0]));
+        };
+        updateAttribute(mesh.positions);
+        updateAttribute(mesh.normals);
+        updateAttribute(mesh.tangents);
+        updateAttribute(mesh.texCrds);
+        updateAttribute(mesh.curveRadii);
+        updateAttribute(mesh.boneIDs);
+        updateAttribute(mesh.boneWeights);
+
+        // Texture coordinates are pre-transformed by the material's texture transform.
+        const float4x4 xform = mesh.pMaterial->getTextureTransform().getMatrix();
+        sha1.update(&xform, sizeof(xform));
+
+        return sha1.finalize();
+    }
+
+    void SceneBuilder::generateTangents(Mesh& mesh, std::vector<float4>& tangents) const
+    {
+        auto mode = is_set(mFlags, Flags::ReferenceTangentSpace) ? TangentGenerator::Mode::Reference : TangentGenerator::Mode::Parallel;
+        tangents = TangentGenerator::generate(mesh, mode);
         if (!tangents.empty())
         {
             FALCOR_ASSERT(tangents.size() == mesh.indexCount);
             mesh.tangents.pData = tangents.data();
             mesh.tangents.frequency = Mesh::AttributeFrequency::FaceVarying;
-
-            /// MikkTSpace can produces NaN tangents in case of degenerate triangles,
-            /// e.g. triangles where all three points, normals, and texture coordinates happen to be identical.
-            /// We are replacing these NaN tangents by arbitrary tangent orthonormal to the vertex normal
-            if (mesh.tangents.pData)
-            {
-                FALCOR_ASSERT(mesh.tangents.frequency == Mesh::AttributeFrequency::FaceVarying);
-                NumericRange<uint32_t> range(0, mesh.indexCount);
-                std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](uint32_t fvIndex)
-                {
-                    if (!any(isnan(mesh.tangents.pData[fvIndex])))
-                        return;
-                    uint32_t faceIndex = fvIndex / 3;
-                    uint32_t vertexIndex = fvIndex % 3;
-                    float3 normal = mesh.getNormal(faceIndex, vertexIndex);
-                    tangents[fvIndex] = float4(perp_stark(normal), 1.f);
-                });
-            }
         }
         else
         {
@@ -1140,6 +1237,11 @@ namespace Falcor
         mSceneData.sdfGridInstances.push_back(instance);
     }
 
+    bool SceneBuilder::isParallelBuild() const
+    {
+        return !is_set(mFlags, Flags::SerialBuild);
+    }
+
     bool SceneBuilder::doesNodeHaveAnimation(NodeID nodeID) const
     {
         FALCOR_ASSERT(nodeID != NodeID::Invalid() && nodeID.get() < mSceneGraph.size());
@@ -1669,7 +1771,11 @@ namespace Falcor
         NodeID identityNodeID = addNode(Node{ "Identity", float4x4::identity(), float4x4::identity() });
         auto& identityNode = mSceneGraph[identityNodeID.get()];
 
-        size_t transformedMeshCount = 0;
+        // Find the static meshes and their object->world transforms, and link them to the identity node.
+        // The scene graph is updated serially to keep the node mesh lists deterministic.
+        std::vector<float4x4> meshTransforms(mMeshes.size(), float4x4::identity());
+        std::vector<bool> isTransformed(mMeshes.size(), false);
+
         for (MeshID meshID{ 0 }; meshID.get() < (uint32_t)mMeshes.size(); ++meshID)
         {
             auto& mesh = mMeshes[meshID.get()];
@@ -1701,24 +1807,8 @@ namespace Falcor
             // Transform vertices to world space if not already identity transform.
             if (transform != float4x4::identity())
             {
-                FALCOR_ASSERT(!mesh.staticData.empty());
-                FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
-
-                float3x3 invTranspose3x3 = float3x3(transpose(inverse(transform)));
-                float3x3 transform3x3 = float3x3(transform);
-
-                for (auto& v : mesh.staticData)
-                {
-                    v.position = transformPoint(transform, v.position);
-                    v.normal = normalize(transformVector(invTranspose3x3, v.normal));
-                    v.tangent = float4(normalize(transformVector(transform3x3, v.tangent.xyz())), v.tangent.w);
-                    // TODO: We should flip the sign of v.tangent.w if flippedWinding is true.
-                    // Leaving that out for now for consistency with the shader code that needs the same fix.
-
-                    v.curveRadius = length(transformVector(transform3x3, float3(v.curveRadius, 0.f, 0.f)));
-                }
-
-                transformedMeshCount++;
+                meshTransforms[meshID.get()] = transform;
+                isTransformed[meshID.get()] = true;
             }
 
             // Unlink mesh from its previous transform node.
@@ -1735,6 +1825,35 @@ namespace Falcor
             mesh.instances.insert(identityNodeID);
         }
 
+        // Transform the vertices of the meshes in parallel.
+        auto transformMesh = [&](size_t meshIndex)
+        {
+            if (!isTransformed[meshIndex]) return;
+
+            auto& mesh = mMeshes[meshIndex];
+            FALCOR_ASSERT(!mesh.staticData.empty());
+            FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
+
+            const float4x4& transform = meshTransforms[meshIndex];
+            float3x3 invTranspose3x3 = float3x3(transpose(inverse(transform)));
+            float3x3 transform3x3 = float3x3(transform);
+
+            for (auto& v : mesh.staticData)
+            {
+                v.position = transformPoint(transform, v.position);
+                v.normal = normalize(transformVector(invTranspose3x3, v.normal));
+                v.tangent = float4(normalize(transformVector(transform3x3, v.tangent.xyz())), v.tangent.w);
+                // TODO: We should flip the sign of v.tangent.w if flippedWinding is true.
+                // Leaving that out for now for consistency with the shader code that needs the same fix.
+
+                v.curveRadius = length(transformVector(transform3x3, float3(v.curveRadius, 0.f, 0.f)));
+            }
+        };
+
+        auto range = NumericRange<size_t>(0, mMeshes.size());
+        forEach(isParallelBuild(), range.begin(), range.end(), transformMesh);
+
+        size_t transformedMeshCount = std::count(isTransformed.begin(), isTransformed.end(), true);
         if (transformedMeshCount > 0) logInfo("Pre-transformed {} static meshes to world space.", transformedMeshCount);
     }
 
@@ -1804,25 +1923,33 @@ namespace Falcor
         // as those transforms may flip the winding.
 
         size_t flippedMeshCount = 0;
-        for (uint32_t meshID = 0; meshID < (uint32_t)mMeshes.size(); meshID++)
+        for (const auto& mesh : mMeshes)
         {
-            auto& mesh = mMeshes[meshID];
-
             // Skip meshes that are already front face counter-clockwise.
             if (mesh.isFrontFaceCW == false) continue;
 
-            flipTriangleWinding(mesh);
-            FALCOR_ASSERT(!mesh.isFrontFaceCW);
-
+            // Check for unsupported meshes up front, exceptions cannot propagate out of the parallel loop below.
+            if (mesh.indexCount == 0)
+            {
+                FALCOR_THROW("SceneBuilder::flipTriangleWinding() is not implemented for non-indexed meshes");
+            }
             flippedMeshCount++;
         }
 
+        forEach(isParallelBuild(), mMeshes.begin(), mMeshes.end(), [this](MeshSpec& mesh)
+        {
+            if (mesh.isFrontFaceCW == false) return;
+
+            flipTriangleWinding(mesh);
+            FALCOR_ASSERT(!mesh.isFrontFaceCW);
+        });
+
         if (flippedMeshCount > 0) logInfo("Flipped triangle winding for {} out of {} meshes.", flippedMeshCount, mMeshes.size());
     }
 
     void SceneBuilder::calculateMeshBoundingBoxes()
     {
-        for (auto& mesh : mMeshes)
+        forEach(isParallelBuild(), mMeshes.begin(), mMeshes.end(), [](MeshSpec& mesh)
         {
             FALCOR_ASSERT(!mesh.staticData.empty());
             FALCOR_ASSERT((size_t)mesh.vertexCount == mesh.staticData.size());
@@ -1834,7 +1961,7 @@ namespace Falcor
             }
 
             mesh.boundingBox = meshBB;
-        }
+        });
     }
 
     void SceneBuilder::createMeshGroups()
@@ -2020,6 +2147,9 @@ namespace Falcor
             spec.materialId = mesh.materialId;
             spec.isStatic = mesh.isStatic;
             spec.isFrontFaceCW = mesh.isFrontFaceCW;
+            spec.isDisplaced = mesh.isDisplaced;
+            spec.isQuantized = mesh.isQuantized;
+            spec.skeletonNodeID = mesh.skeletonNodeID;
             spec.instances = mesh.instances;
             FALCOR_ASSERT(mesh.isDynamic() == false);
             FALCOR_ASSERT(mesh.skinningVertexCount == 0);
@@ -2066,8 +2196,8 @@ namespace Falcor
         FALCOR_ASSERT(mesh.indexCount > 0 && !mesh.indexData.empty());
 
         const uint32_t invalidIdx = uint32_t(-1);
-        std::vector<uint32_t> leftIndexMap(mesh.indexCount, invalidIdx);
-        std::vector<uint32_t> rightIndexMap(mesh.indexCount, invalidIdx);
+        std::vector<uint32_t> leftIndexMap(mesh.staticData.size(), invalidIdx);
+        std::vector<uint32_t> rightIndexMap(mesh.staticData.size(), invalidIdx);
 
         // Iterate over the triangles.
         const size_t triangleCount = mesh.getTriangleCount();
@@ -2125,7 +2255,50 @@ namespace Falcor
     void SceneBuilder::splitNonIndexedMesh(const MeshSpec& mesh, MeshSpec& leftMesh, MeshSpec& rightMesh, const int axis, const float pos)
     {
         FALCOR_ASSERT(mesh.indexCount == 0 && mesh.indexData.empty());
-        FALCOR_THROW("SceneBuilder::splitNonIndexedMesh() not implemented");
+
+        // Non-indexed meshes have unique vertices per triangle, so the vertices are copied as-is.
+        const size_t triangleCount = mesh.getTriangleCount();
+        for (size_t i = 0; i < triangleCount * 3; i += 3)
+        {
+            float centroid = 0.f;
+            for (size_t j = 0; j < 3; j++)
+            {
+                centroid += mesh.staticData[i + j].position[axis];
+            }
+            centroid /= 3.f;
+
+            MeshSpec& dstMesh = centroid < pos ? leftMesh : rightMesh;
+            dstMesh.staticData.insert(dstMesh.staticData.end(), mesh.staticData.begin() + i, mesh.staticData.begin() + i + 3);
+        }
+
+        auto finalizeMesh = [](MeshSpec& m)
+        {
+            m.vertexCount = (uint32_t)m.staticData.size();
+            m.staticVertexCount = m.vertexCount;
+
+            m.boundingBox = AABB();
+            for (auto& v : m.staticData) m.boundingBox.include(v.position);
+        };
+
+        finalizeMesh(leftMesh);
+        finalizeMesh(rightMesh);
+    }
+
+    bool SceneBuilder::isMeshSplittable(MeshID meshID) const
+    {
+        const auto& mesh = mMeshes[meshID.get()];
+        if (mesh.isDynamic() || mesh.topology != Vao::Topology::TriangleList) return false;
+
+        // Meshes animated by vertex caches reference the original vertex order.
+        for (const auto& cache : mSceneData.cachedMeshes)
+        {
+            if (cache.meshID == meshID) return false;
+        }
+        for (const auto& cache : mSceneData.cachedCurves)
+        {
+            if (cache.tessellationMode != CurveTessellationMode::LinearSweptSphere && cache.geometryID.get() == meshID.get()) return false;
+        }
+        return true;
     }
 
     size_t SceneBuilder::countTriangles(const MeshGroup& meshGroup) const
@@ -2169,22 +2342,48 @@ namespace Falcor
         {
             return false;
         }
-        else if (meshGroup.meshList.size() == 1)
+        else if (meshGroup.meshList.size() == 1 && !isMeshSplittable(meshGroup.meshList[0]))
         {
-            // Issue warning if single mesh exceeds the triangle count limit.
-            // TODO: Implement mesh splitting to handle this case.
+            // Issue warning if single mesh exceeds the triangle count limit and cannot be split.
             const auto& mesh = mMeshes[meshGroup.meshList[0].get()];
             FALCOR_ASSERT(mesh.getTriangleCount() == triangleCount);
-            logWarning("Mesh '{}' has {} triangles, expect extraneous GPU memory usage.", mesh.name, triangleCount);
+            logWarning("Mesh '{}' has {} triangles and cannot be split, expect extraneous GPU memory usage.", mesh.name, triangleCount);
 
             return false;
         }
-        FALCOR_ASSERT(meshGroup.meshList.size() > 1);
         FALCOR_ASSERT(triangleCount > kMaxTrianglesPerBLAS);
 
         return true;
     }
 
+    std::vector<BLASGrouping::MeshInfo> SceneBuilder::getGroupingMeshInfos(const MeshGroup& meshGroup) const
+    {
+        std::vector<BLASGrouping::MeshInfo> meshInfos;
+        meshInfos.reserve(meshGroup.meshList.size());
+        for (auto meshID : meshGroup.meshList)
+        {
+            const auto& mesh = mMeshes[meshID.get()];
+            meshInfos.push_back({ mesh.boundingBox, mesh.getTriangleCount(), (uint32_t)std::max<size_t>(mesh.instances.size(), 1) });
+        }
+        return meshInfos;
+    }
+
+    SceneBuilder::MeshGroupList SceneBuilder::partitionMeshGroup(const MeshGroup& meshGroup, BLASGrouping::Strategy strategy) const
+    {
+        // Partitions the meshes of a group with the given strategy. Individual meshes are not split.
+        auto meshInfos = getGroupingMeshInfos(meshGroup);
+        BLASGrouping::Group group(meshInfos.size());
+        for (uint32_t i = 0; i < group.size(); i++) group[i] = i;
+
+        MeshGroupList groups;
+        for (const auto& indices : BLASGrouping::partition(meshInfos, group, strategy, kMaxTrianglesPerBLAS))
+        {
+            MeshGroup& newGroup = groups.emplace_back(MeshGroup{ std::vector<MeshID>(), meshGroup.isStatic });
+            for (uint32_t i : indices) newGroup.meshList.push_back(meshGroup.meshList[i]);
+        }
+        return groups;
+    }
+
     SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupSimple(MeshGroup& meshGroup) const
     {
         // This function partitions a mesh group into smaller groups based on triangle count.
@@ -2195,31 +2394,7 @@ namespace Falcor
         size_t triangleCount = 0;
         if (!needsSplit(meshGroup, triangleCount)) return MeshGroupList{ std::move(meshGroup) };
 
-        // Each new group holds at least one mesh, or if multiple, up to the target number of triangles.
-        FALCOR_ASSERT(triangleCount > 0);
-        size_t targetGroupCount = div_round_up(triangleCount, kMaxTrianglesPerBLAS);
-        size_t targetTrianglesPerGroup = triangleCount / targetGroupCount;
-
-        triangleCount = 0;
-        MeshGroupList groups;
-
-        for (auto meshID : meshGroup.meshList)
-        {
-            // Start new group on first iteration or if triangle count would exceed the target.
-            size_t meshTris = mMeshes[meshID.get()].getTriangleCount();
-            if (triangleCount == 0 || triangleCount + meshTris > targetTrianglesPerGroup)
-            {
-                groups.push_back({ std::vector<MeshID>(), meshGroup.isStatic });
-                triangleCount = 0;
-            }
-
-            // Add mesh to group.
-            groups.back().meshList.push_back(meshID);
-            triangleCount += meshTris;
-        }
-
-        FALCOR_ASSERT(!groups.empty());
-        return groups;
+        return partitionMeshGroup(meshGroup, BLASGrouping::Strategy::Simple);
     }
 
     SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupMedian(MeshGroup& meshGroup) const
@@ -2232,50 +2407,28 @@ namespace Falcor
         size_t triangleCount = 0;
         if (!needsSplit(meshGroup, triangleCount)) return MeshGroupList{ std::move(meshGroup) };
 
-        // Sort the meshes by centroid along the largest axis.
-        AABB bb = calculateBoundingBox(meshGroup);
-        const int axis = largestAxis(bb.extent());
-        auto compareCentroids = [this, axis](MeshID leftMeshID, MeshID rightMeshID)
-        {
-            return mMeshes[leftMeshID.get()].boundingBox.center()[axis] < mMeshes[rightMeshID.get()].boundingBox.center()[axis];
-        };
-
-        std::vector<MeshID> meshes = std::move(meshGroup.meshList);
-        std::sort(meshes.begin(), meshes.end(), compareCentroids);
+        return partitionMeshGroup(meshGroup, BLASGrouping::Strategy::Median);
+    }
 
-        // Find the median mesh in terms of triangle count.
-        size_t triangles = 0;
-        auto countTriangles = [&](MeshID meshID)
-        {
-            triangles += mMeshes[meshID.get()].getTriangleCount();
-            return triangles > triangleCount / 2;
-        };
+    SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupSAH(MeshGroup& meshGroup)
+    {
+        // This function partitions a mesh group by recursively splitting at the binned SAH optimum over whole meshes.
+        // Unlike splitting at the midpoint, meshes are kept intact, which avoids duplicating vertices along the
+        // splitting planes, and the split position minimizes the expected traversal cost including the overlap
+        // between the resulting BLASes. Groups that are still over the limit are single oversized meshes,
+        // those are split at the midpoint.
 
-        auto splitIter = std::find_if(meshes.begin(), meshes.end(), countTriangles);
+        // Early out if splitting is not needed or possible.
+        size_t triangleCount = 0;
+        if (!needsSplit(meshGroup, triangleCount)) return MeshGroupList{ std::move(meshGroup) };
 
-        // If all meshes ended up on either side, fall back on splitting at the middle mesh.
-        if (splitIter == meshes.begin() || splitIter == meshes.end())
+        MeshGroupList result;
+        for (auto& group : partitionMeshGroup(meshGroup, BLASGrouping::Strategy::SAH))
         {
-            FALCOR_ASSERT(meshes.size() >= 2);
-            splitIter = meshes.begin() + meshes.size() / 2;
+            auto groups = splitMeshGroupMidpointMeshes(group);
+            result.insert(result.end(), std::make_move_iterator(groups.begin()), std::make_move_iterator(groups.end()));
         }
-        FALCOR_ASSERT(splitIter != meshes.begin() && splitIter != meshes.end());
-
-        // Recursively split the left and right mesh groups.
-        MeshGroup leftGroup{ std::vector<MeshID>(meshes.begin(), splitIter), meshGroup.isStatic };
-        MeshGroup rightGroup{ std::vector<MeshID>(splitIter, meshes.end()), meshGroup.isStatic };
-        FALCOR_ASSERT(!leftGroup.meshList.empty() && !rightGroup.meshList.empty());
-
-        MeshGroupList leftList = splitMeshGroupMedian(leftGroup);
-        MeshGroupList rightList = splitMeshGroupMedian(rightGroup);
-
-        // Move elements into a single list and return.
-        leftList.insert(
-            leftList.end(),
-            std::make_move_iterator(rightList.begin()),
-            std::make_move_iterator(rightList.end()));
-
-        return leftList;
+        return result;
     }
 
     SceneBuilder::MeshGroupList SceneBuilder::splitMeshGroupMidpointMeshes(MeshGroup& meshGroup)
@@ -2283,6 +2436,7 @@ namespace Falcor
         // This function recursively splits a mesh group at the midpoint along the largest axis.
         // Individual meshes that straddle the splitting plane are split into two halves.
         // This will ensure minimal spatial overlaps between groups.
+        // A single oversized mesh is split the same way, until the chunks are under the triangle limit.
 
         // Early out if splitting is not needed or possible.
         size_t triangleCount = 0;
@@ -2303,8 +2457,26 @@ namespace Falcor
             if (auto rightMeshID = result.second) rightMeshes.push_back(*rightMeshID);
         }
 
+        // If a single mesh has all triangle centroids on one side of the midpoint, split it at the median centroid instead.
+        if ((leftMeshes.empty() || rightMeshes.empty()) && meshGroup.meshList.size() == 1)
+        {
+            leftMeshes.clear();
+            rightMeshes.clear();
+            auto result = splitMesh(meshGroup.meshList[0], axis, findMedianCentroid(mMeshes[meshGroup.meshList[0].get()], axis));
+            if (auto leftMeshID = result.first) leftMeshes.push_back(*leftMeshID);
+            if (auto rightMeshID = result.second) rightMeshes.push_back(*rightMeshID);
+        }
+
         // If either side contains all meshes, do not split further.
-        if (leftMeshes.empty() || rightMeshes.empty()) return MeshGroupList{ std::move(meshGroup) };
+        if (leftMeshes.empty() || rightMeshes.empty())
+        {
+            if (meshGroup.meshList.size() == 1)
+            {
+                const auto& mesh = mMeshes[meshGroup.meshList[0].get()];
+                logWarning("Mesh '{}' has {} triangles and could not be split further, expect extraneous GPU memory usage.", mesh.name, triangleCount);
+            }
+            return MeshGroupList{ std::move(meshGroup) };
+        }
 
         // Recursively split the left and right mesh groups.
         MeshGroup leftGroup{ std::move(leftMeshes), meshGroup.isStatic };
@@ -2322,6 +2494,31 @@ namespace Falcor
         return leftList;
     }
 
+    float SceneBuilder::findMedianCentroid(const MeshSpec& mesh, const int axis)
+    {
+        // Returns the median of the triangle centroids along the given axis.
+        // Splitting at the median puts the triangles with smaller centroids on the left side.
+        const size_t triangleCount = mesh.getTriangleCount();
+        FALCOR_ASSERT(triangleCount > 0);
+
+        std::vector<float> centroids(triangleCount);
+        auto range = NumericRange<size_t>(0, triangleCount);
+        std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](size_t i)
+        {
+            float centroid = 0.f;
+            for (size_t j = 0; j < 3; j++)
+            {
+                uint32_t vtxIndex = mesh.indexCount > 0 ? mesh.getIndex(i * 3 + j) : uint32_t(i * 3 + j);
+                centroid += mesh.staticData[vtxIndex].position[axis];
+            }
+            centroids[i] = centroid / 3.f;
+        });
+
+        auto median = centroids.begin() + triangleCount / 2;
+        std::nth_element(centroids.begin(), median, centroids.end());
+        return *median;
+    }
+
     void SceneBuilder::optimizeGeometry()
     {
         // This function optimizes the geometry for raytracing performance and memory usage.
@@ -2339,11 +2536,32 @@ namespace Falcor
 
         for (auto& meshGroup : mMeshGroups)
         {
-            //auto groups = splitMeshGroupSimple(meshGroup);
-            //auto groups = splitMeshGroupMedian(meshGroup);
-            auto groups = splitMeshGroupMidpointMeshes(meshGroup);
+            const size_t meshCount = meshGroup.meshList.size();
+            auto groups = is_set(mFlags, Flags::SAHMeshGrouping) ? splitMeshGroupSAH(meshGroup) : splitMeshGroupMidpointMeshes(meshGroup);
+
+            if (groups.size() > 1)
+            {
+                // Report the estimated cost of the new groups. Overlapping BLASes are traversed redundantly
+                // by rays passing through the shared space.
+                std::vector<BLASGrouping::MeshInfo> meshInfos;
+                std::vector<BLASGrouping::Group> indices;
+                for (const auto& group : groups)
+                {
+                    auto& groupIndices = indices.emplace_back();
+                    for (const auto& meshInfo : getGroupingMeshInfos(group))
+                    {
+                        groupIndices.push_back((uint32_t)meshInfos.size());
+                        meshInfos.push_back(meshInfo);
+                    }
+                }
+                auto stats = BLASGrouping::evaluate(meshInfos, indices);
 
-            if (groups.size() > 1) logWarning("SceneBuilder::optimizeGeometry() performance warning - Mesh group was split into {} groups.", groups.size());
+                logWarning(
+                    "SceneBuilder::optimizeGeometry() performance warning - Mesh group with {} meshes was split into {} groups, bounding box overlap {:.1f}%, estimated traversal cost {:.2f}.",
+                    meshCount, groups.size(), stats.overlapRatio * 100.0, stats.traversalCost
+                );
+                LoadProfiler::instance().addCount("split mesh groups", groups.size());
+            }
 
             optimizedGroups.insert(
                 optimizedGroups.end(),
@@ -2354,6 +2572,117 @@ namespace Falcor
         mMeshGroups = std::move(optimizedGroups);
     }
 
+    void SceneBuilder::optimizeMeshLayout()
+    {
+        // This function reorders the triangles of each mesh for post-transform vertex cache locality,
+        // and then reorders the vertices into the order in which they are referenced.
+        // Meshes whose vertex order is referenced by external data (vertex caches, curves) or
+        // that may be modified at runtime are left untouched.
+
+        std::vector<bool> isExternallyReferenced(mMeshes.size(), false);
+        for (const auto& cache : mSceneData.cachedMeshes) isExternallyReferenced[cache.meshID.get()] = true;
+        for (const auto& cache : mSceneData.cachedCurves)
+        {
+            if (cache.tessellationMode != CurveTessellationMode::LinearSweptSphere) isExternallyReferenced[cache.geometryID.get()] = true;
+        }
+
+        std::vector<MeshLayoutOptimizer::CacheStats> statsBefore(mMeshes.size());
+        std::vector<MeshLayoutOptimizer::CacheStats> statsAfter(mMeshes.size());
+
+        auto optimizeMesh = [&](size_t meshIndex)
+        {
+            auto& mesh = mMeshes[meshIndex];
+            if (mesh.indexCount == 0 || mesh.isAnimated || isExternallyReferenced[meshIndex]) return;
+            FALCOR_ASSERT(mesh.topology == Vao::Topology::TriangleList);
+            FALCOR_ASSERT(mesh.staticData.size() == mesh.vertexCount);
+            FALCOR_ASSERT(!mesh.isSkinned() || mesh.skinningData.size() == mesh.vertexCount);
+
+            std::vector<uint32_t> indices(mesh.indexCount);
+            for (uint32_t i = 0; i < mesh.indexCount; i++) indices[i] = mesh.getIndex(i);
+
+            statsBefore[meshIndex] = MeshLayoutOptimizer::computeCacheStats(indices, mesh.vertexCount);
+            MeshLayoutOptimizer::optimizeVertexCache(indices, mesh.vertexCount);
+            auto remap = MeshLayoutOptimizer::optimizeVertexFetch(indices, mesh.vertexCount);
+            statsAfter[meshIndex] = MeshLayoutOptimizer::computeCacheStats(indices, mesh.vertexCount);
+
+            MeshLayoutOptimizer::remapVertices(mesh.staticData, remap);
+            if (mesh.isSkinned())
+            {
+                // Skinned vertices reference the static vertex with the same local index.
+                MeshLayoutOptimizer::remapVertices(mesh.skinningData, remap);
+                for (uint32_t i = 0; i < mesh.vertexCount; i++) mesh.skinningData[i].staticIndex = i;
+            }
+
+            if (mesh.use16BitIndices)
+            {
+                uint16_t* indices16 = reinterpret_cast<uint16_t*>(mesh.indexData.data());
+                for (uint32_t i = 0; i < mesh.indexCount; i++) indices16[i] = uint16_t(indices[i]);
+            }
+            else
+            {
+                mesh.indexData = std::move(indices);
+            }
+        };
+
+        auto range = NumericRange<size_t>(0, mMeshes.size());
+        std::for_each(std::execution::par, range.begin(), range.end(), optimizeMesh);
+
+        MeshLayoutOptimizer::CacheStats totalBefore, totalAfter;
+        for (size_t i = 0; i < mMeshes.size(); i++)
+        {
+            totalBefore += statsBefore[i];
+            totalAfter += statsAfter[i];
+        }
+
+        if (totalBefore.triangleCount > 0)
+        {
+            logInfo("SceneBuilder::optimizeMeshLayout() optimized {} triangles: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} (cache size {}).",
+                totalBefore.triangleCount, totalBefore.getACMR(), totalAfter.getACMR(), totalBefore.getATVR(), totalAfter.getATVR(), MeshLayoutOptimizer::kDefaultCacheSize);
+        }
+    }
+
+    void SceneBuilder::selectCompactCacheMeshes()
+    {
+        // This function selects the meshes whose static vertex data is stored quantized in the scene cache
+        // and reports the error that loading the scene from the cache introduces. The vertex data itself is
+        // left at full precision, the encoding is only applied by SceneCache::writeMeshStaticData().
+        // Meshes that may be modified at runtime are left untouched.
+
+        const auto format = is_set(mFlags, Flags::CompactSceneCacheVertices21Bit) ? VertexQuantization::PositionFormat::Unorm21 : VertexQuantization::PositionFormat::Unorm16;
+
+        std::vector<VertexQuantization::ErrorStats> stats(mMeshes.size());
+
+        auto selectMesh = [&](size_t meshIndex)
+        {
+            auto& mesh = mMeshes[meshIndex];
+            if (mesh.isAnimated || mesh.staticData.empty()) return;
+            FALCOR_ASSERT(mesh.staticData.size() == mesh.vertexCount);
+
+            auto decoded = VertexQuantization::decode(VertexQuantization::encode(mesh.staticData, format));
+            stats[meshIndex] = VertexQuantization::computeError(mesh.staticData, decoded);
+
+            // Keep the bounding box conservative for the vertices decoded from the cache.
+            for (const auto& v : decoded) mesh.boundingBox.include(v.position);
+
+            mesh.isQuantized = true;
+        };
+
+        auto range = NumericRange<size_t>(0, mMeshes.size());
+        std::for_each(std::execution::par, range.begin(), range.end(), selectMesh);
+
+        VertexQuantization::ErrorStats total;
+        for (const auto& s : stats) total += s;
+
+        if (total.vertexCount > 0)
+        {
+            const uint32_t bytesPerVertex = VertexQuantization::getBytesPerVertex(format);
+            logInfo("SceneBuilder::selectCompactCacheMeshes() stores {} vertices with {}-bit positions in the scene cache ({} instead of {} bytes per vertex). "
+                "Loading from the cache introduces position error max {:g} mean {:g}, normal error max {:g} rad, tangent error max {:g} rad, texcoord error max {:g}.",
+                total.vertexCount, (uint32_t)format, bytesPerVertex, sizeof(PackedStaticVertexData),
+                total.maxPositionError, total.getMeanPositionError(), total.maxNormalError, total.maxTangentError, total.maxTexCrdError);
+        }
+    }
+
     void SceneBuilder::sortMeshes()
     {
         // This function sorts meshes by the order they are used in the mesh groups.
@@ -2407,16 +2736,22 @@ namespace Falcor
 
         const bool isIndexed = !is_set(mFlags, Flags::NonIndexedVertices);
 
-        // Count total number of vertex and index data elements.
+        // Compute the offsets of all meshes into the global buffers.
+        // The offsets are assigned in mesh order so that the layout is deterministic.
         size_t totalIndexDataCount = 0;
         size_t totalStaticVertexCount = 0;
         size_t totalSkinningVertexCount = 0;
 
-        for (const auto& mesh : mMeshes)
+        for (auto& mesh : mMeshes)
         {
-            totalIndexDataCount += mesh.indexData.size();
+            mesh.staticVertexOffset = (uint32_t)totalStaticVertexCount;
+            mesh.skinningVertexOffset = (uint32_t)totalSkinningVertexCount;
+            mesh.prevVertexOffset = mesh.skinningVertexOffset;
+            if (isIndexed) mesh.indexOffset = (uint32_t)totalIndexDataCount;
+
+            totalIndexDataCount += isIndexed ? mesh.indexData.size() : 0;
             totalStaticVertexCount += mesh.staticData.size();
-            totalSkinningVertexCount += mesh.skinningData.size();
+            totalSkinningVertexCount += mesh.isSkinned() ? mesh.skinningData.size() : 0;
             mSceneData.prevVertexCount += mesh.prevVertexCount;
         }
 
@@ -2428,31 +2763,28 @@ namespace Falcor
             FALCOR_THROW("Trying to build a scene that exceeds supported mesh data size.");
         }
 
-        mSceneData.meshIndexData.reserve(totalIndexDataCount);
-        mSceneData.meshStaticData.reserve(totalStaticVertexCount);
-        mSceneData.meshSkinningData.reserve(totalSkinningVertexCount);
+        mSceneData.meshIndexData.resize(totalIndexDataCount);
+        mSceneData.meshStaticData.resize(totalStaticVertexCount);
+        mSceneData.meshSkinningData.resize(totalSkinningVertexCount);
 
-        // Copy all vertex and index data into the global buffers.
-        for (auto& mesh : mMeshes)
+        // Copy all vertex and index data into the global buffers in parallel.
+        auto copyMesh = [&](size_t meshIndex)
         {
-            mesh.staticVertexOffset = (uint32_t)mSceneData.meshStaticData.size();
-            mesh.skinningVertexOffset = (uint32_t)mSceneData.meshSkinningData.size();
-            mesh.prevVertexOffset = mesh.skinningVertexOffset;
+            auto& mesh = mMeshes[meshIndex];
 
             // Insert the static vertex data in the global array.
-            // The vertices are automatically converted to their packed format in this step.
-            mSceneData.meshStaticData.insert(mSceneData.meshStaticData.end(), mesh.staticData.begin(), mesh.staticData.end());
+            // The vertices are converted to their packed format in this step.
+            std::copy(mesh.staticData.begin(), mesh.staticData.end(), mSceneData.meshStaticData.begin() + mesh.staticVertexOffset);
 
             if (isIndexed)
             {
-                mesh.indexOffset = (uint32_t)mSceneData.meshIndexData.size();
-                mSceneData.meshIndexData.insert(mSceneData.meshIndexData.end(), mesh.indexData.begin(), mesh.indexData.end());
+                std::copy(mesh.indexData.begin(), mesh.indexData.end(), mSceneData.meshIndexData.begin() + mesh.indexOffset);
             }
 
             if (mesh.isSkinned())
             {
                 FALCOR_ASSERT(!mesh.skinningData.empty());
-                mSceneData.meshSkinningData.insert(mSceneData.meshSkinningData.end(), mesh.skinningData.begin(), mesh.skinningData.end());
+                std::copy(mesh.skinningData.begin(), mesh.skinningData.end(), mSceneData.meshSkinningData.begin() + mesh.skinningVertexOffset);
 
                 // Patch vertex index references.
                 for (uint32_t i = 0; i < mesh.skinningData.size(); ++i)
@@ -2462,10 +2794,13 @@ namespace Falcor
             }
 
             // Free the mesh local data.
-            mesh.indexData.clear();
-            mesh.staticData.clear();
-            mesh.skinningData.clear();
-        }
+            mesh.indexData = {};
+            mesh.staticData = {};
+            mesh.skinningData = {};
+        };
+
+        auto range = NumericRange<size_t>(0, mMeshes.size());
+        forEach(isParallelBuild(), range.begin(), range.end(), copyMesh);
 
         // Initialize offsets for prev vertex data for vertex-animated meshes
         uint32_t prevOffset = (uint32_t)mSceneData.meshSkinningData.size();
@@ -2586,7 +2921,7 @@ namespace Falcor
         // Match texture coordinate quantization for textured emissives to format of PackedEmissiveTriangle.
         // This is to avoid mismatch when sampling and evaluating emissive triangles.
         // Note that non-emissive meshes are unmodified and use full precision texcoords.
-        for (auto& mesh : mMeshes)
+        forEach(isParallelBuild(), mMeshes.begin(), mMeshes.end(), [this](const MeshSpec& mesh)
         {
             const auto& pMaterial = mSceneData.pMaterials->getMaterial(mesh.materialId)->toBasicMaterial();
             if (pMaterial && pMaterial->getEmissiveTexture() != nullptr)
@@ -2631,7 +2966,7 @@ namespace Falcor
                     }
                 }
             }
-        }
+        });
     }
 
     void SceneBuilder::removeDuplicateSDFGrids()
@@ -2674,8 +3009,22 @@ namespace Falcor
         auto& meshData = mSceneData.meshDesc;
         meshData.resize(mMeshes.size());
 
-        // Setup all mesh data.
+        if (is_set(mFlags, Flags::CompactSceneCacheVertices))
+        {
+            mSceneData.quantizedPositionBits = (uint32_t)(is_set(mFlags, Flags::CompactSceneCacheVertices21Bit) ? VertexQuantization::PositionFormat::Unorm21 : VertexQuantization::PositionFormat::Unorm16);
+        }
+
+        mSceneData.meshNames.resize(mMeshes.size());
         for (uint32_t meshID = 0; meshID < mMeshes.size(); meshID++)
+        {
+            const auto& mesh = mMeshes[meshID];
+            if (mesh.use16BitIndices) mSceneData.has16BitIndices = true;
+            else mSceneData.has32BitIndices = true;
+            if (mesh.isQuantized) mSceneData.quantizedMeshes.push_back(meshID);
+        }
+
+        // Setup all mesh data.
+        auto setupMesh = [&](uint32_t meshID)
         {
             const auto& mesh = mMeshes[meshID];
             meshData[meshID].materialID = mesh.materialId.getSlang();
@@ -2687,7 +3036,7 @@ namespace Falcor
             meshData[meshID].prevVbOffset = mesh.isDynamic() ? mesh.prevVertexOffset : 0;
             FALCOR_ASSERT(mesh.skinningVertexCount == 0 || mesh.skinningVertexCount == mesh.staticVertexCount);
 
-            mSceneData.meshNames.push_back(mesh.name);
+            mSceneData.meshNames[meshID] = mesh.name;
 
             uint32_t meshFlags = 0;
             meshFlags |= mesh.use16BitIndices ? (uint32_t)MeshFlags::Use16BitIndices : 0;
@@ -2697,9 +3046,6 @@ namespace Falcor
             meshFlags |= mesh.isAnimated ? (uint32_t)MeshFlags::IsAnimated : 0;
             meshData[meshID].flags = meshFlags;
 
-            if (mesh.use16BitIndices) mSceneData.has16BitIndices = true;
-            else mSceneData.has32BitIndices = true;
-
             if (mesh.isSkinned())
             {
                 // Dynamic (skinned) meshes can only be instanced if an explicit skeleton transform node is specified.
@@ -2716,7 +3062,10 @@ namespace Falcor
                     s.skeletonMatrixID = mesh.skeletonNodeID == NodeID::Invalid() ? mesh.instances.begin()->getSlang() : mesh.skeletonNodeID.getSlang();
                 }
             }
-        }
+        };
+
+        auto range = NumericRange<uint32_t>(0, (uint32_t)mMeshes.size());
+        forEach(isParallelBuild(), range.begin(), range.end(), setupMesh);
     }
 
     void SceneBuilder::createMeshInstanceData(uint32_t& tlasInstanceIndex)
@@ -2752,22 +3101,44 @@ namespace Falcor
         FALCOR_ASSERT(mSceneData.meshIdToInstanceIds.empty());
         FALCOR_ASSERT(mSceneData.meshGroups.empty());
 
-        auto& instanceData = mSceneData.meshInstanceData;
+        // Compute the offsets of the mesh groups into the instance list and the TLAS instance indices.
+        // This makes the instance layout independent of the order in which the groups are processed below.
+        std::vector<size_t> instanceDataOffsets(mMeshGroups.size());
+        std::vector<uint32_t> tlasInstanceIndices(mMeshGroups.size());
         size_t drawCount = 0;
 
-        for (const auto& meshGroup : mMeshGroups)
+        for (size_t groupIndex = 0; groupIndex < mMeshGroups.size(); groupIndex++)
         {
-            const auto& meshList = meshGroup.meshList;
+            const auto& meshList = mMeshGroups[groupIndex].meshList;
 
             // If mesh group is instanced, all meshes have identical lists of instances.
             // This is a requirement for ray tracing and ensured by createMeshGroups().
             // For non-instanced static mesh groups, we allow the meshes to have different nodes.
             // This case is handled by pre-transforming the vertices in the BLAS build.
             FALCOR_ASSERT(!meshList.empty());
+            size_t instanceCount = mMeshes[meshList[0].get()].instances.size();
+            FALCOR_ASSERT(instanceCount > 0);
+
+            instanceDataOffsets[groupIndex] = drawCount;
+            tlasInstanceIndices[groupIndex] = tlasInstanceIndex;
+            tlasInstanceIndex += (uint32_t)instanceCount;
+            drawCount += instanceCount * meshList.size();
+        }
+
+        auto& instanceData = mSceneData.meshInstanceData;
+        instanceData.resize(drawCount);
+        mSceneData.meshIdToInstanceIds.resize(mMeshes.size());
+
+        auto setupMeshGroup = [&](size_t groupIndex)
+        {
+            const auto& meshGroup = mMeshGroups[groupIndex];
+            const auto& meshList = meshGroup.meshList;
             const auto& firstMesh = mMeshes[meshList[0].get()];
             size_t instanceCount = firstMesh.instances.size();
 
-            FALCOR_ASSERT(instanceCount > 0);
+            size_t instanceID = instanceDataOffsets[groupIndex];
+            uint32_t tlasIndex = tlasInstanceIndices[groupIndex];
+
             auto instIter = firstMesh.instances.cbegin();
             for (size_t instanceIdx = 0; instanceIdx < instanceCount; instanceIdx++, instIter++)
             {
@@ -2798,26 +3169,24 @@ namespace Falcor
                     instance.ibOffset = mesh.indexOffset;
                     instance.flags |= mesh.use16BitIndices ? (uint32_t)GeometryInstanceFlags::Use16BitIndices : 0;
                     instance.flags |= mesh.isDynamic() ? (uint32_t)GeometryInstanceFlags::IsDynamic : 0;
-                    instance.instanceIndex = tlasInstanceIndex;
+                    instance.instanceIndex = tlasIndex;
                     instance.geometryIndex = blasGeometryIndex;
-                    instanceData.push_back(instance);
+                    instanceData[instanceID] = instance;
+
+                    // Create mapping of mesh IDs to their instance IDs.
+                    // Each mesh belongs to a single mesh group, so only this task writes to its list.
+                    mSceneData.meshIdToInstanceIds[meshID.get()].push_back((uint32_t)instanceID);
 
+                    instanceID++;
                     blasGeometryIndex++;
                 }
 
-                tlasInstanceIndex++;
+                tlasIndex++;
             }
+        };
 
-            drawCount += instanceCount * meshList.size();
-        }
-
-        // Create mapping of mesh IDs to their instance IDs.
-        mSceneData.meshIdToInstanceIds.resize(mMeshes.size());
-        for (uint32_t instanceID = 0; instanceID < (uint32_t)instanceData.size(); instanceID++)
-        {
-            const auto& instance = instanceData[instanceID];
-            mSceneData.meshIdToInstanceIds[instance.geometryID].push_back(instanceID);
-        }
+        auto range = NumericRange<size_t>(0, mMeshGroups.size());
+        forEach(isParallelBuild(), range.begin(), range.end(), setupMeshGroup);
 
         // Setup mesh groups. This just copies our final list.
         mSceneData.meshGroups = mMeshGroups;
@@ -2955,6 +3324,12 @@ namespace Falcor
         flags.value("DontUseDisplacement", SceneBuilder::Flags::DontUseDisplacement);
         flags.value("UseCompressedHitInfo", SceneBuilder::Flags::UseCompressedHitInfo);
         flags.value("TessellateCurvesIntoPolyTubes", SceneBuilder::Flags::TessellateCurvesIntoPolyTubes);
+        flags.value("OptimizeMeshLayout", SceneBuilder::Flags::OptimizeMeshLayout);
+        flags.value("CompactSceneCacheVertices", SceneBuilder::Flags::CompactSceneCacheVertices);
+        flags.value("CompactSceneCacheVertices21Bit", SceneBuilder::Flags::CompactSceneCacheVertices21Bit);
+        flags.value("SAHMeshGrouping", SceneBuilder::Flags::SAHMeshGrouping);
+        flags.value("ReferenceTangentSpace", SceneBuilder::Flags::ReferenceTangentSpace);
+        flags.value("SerialBuild", SceneBuilder::Flags::SerialBuild);
         flags.value("UseCache", SceneBuilder::Flags::UseCache);
         flags.value("RebuildCache", SceneBuilder::Flags::RebuildCache);
         ScriptBindings::addEnumBinaryOperators(flags);
@@ -2972,7 +3347,10 @@ namespace Falcor
         sceneBuilder.def_property("selectedCamera", &SceneBuilder::getSelectedCamera, &SceneBuilder::setSelectedCamera);
         sceneBuilder.def_property("cameraSpeed", &SceneBuilder::getCameraSpeed, &SceneBuilder::setCameraSpeed);
         sceneBuilder.def("importScene", &SceneBuilder::import, "path"_a, "dict"_a = pybind11::dict());
-        sceneBuilder.def("addTriangleMesh", &SceneBuilder::addTriangleMesh, "triangleMesh"_a, "material"_a, "isAnimated"_a = false);
+        sceneBuilder.def("addTriangleMesh", [] (SceneBuilder* pSceneBuilder, const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated) {
+            FALCOR_CHECK(pSceneBuilder, "'pSceneBuilder' is missing");
+            return pSceneBuilder->addTriangleMesh(pTriangleMesh, pMaterial, isAnimated);
+        }, "triangleMesh"_a, "material"_a, "isAnimated"_a = false);
         sceneBuilder.def("addSDFGrid", &SceneBuilder::addSDFGrid, "sdfGrid"_a, "material"_a);
         sceneBuilder.def("addMaterial", &SceneBuilder::addMaterial, "material"_a);
         sceneBuilder.def("replaceMaterial", &SceneBuilder::replaceMaterial, "material"_a, "replacement"_a);
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include "BLASGrouping.h"
 #include "Scene.h"
 #include "SceneCache.h"
 #include "SceneIDs.h"
@@ -42,12 +43,17 @@
 #include "Utils/Math/Vector.h"
 #include "Utils/Math/Matrix.h"
 #include "Utils/Settings/Settings.h"
+#include "Utils/CryptoUtils.h"
 
 #include <pybind11/pytypes.h>
 
 #include <filesystem>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Falcor
@@ -77,8 +83,14 @@ namespace Falcor
             DontUseDisplacement             = 0x4000,   ///< Don't use displacement mapping.
             UseCompressedHitInfo            = 0x8000,   ///< Use compressed hit info (on scenes with triangle meshes only).
             TessellateCurvesIntoPolyTubes   = 0x10000,  ///< Tessellate curves into poly-tubes (the default is linear swept spheres).
-
-            UseCache                        = 0x10000000, ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time.
+            OptimizeMeshLayout              = 0x20000,  ///< Reorder triangles for vertex cache locality and vertices for fetch locality. Does not apply to animated meshes.
+            CompactSceneCacheVertices       = 0x40000,  ///< Store the static vertices of non-animated meshes in the scene cache in a compact quantized encoding (16-bit positions relative to the mesh bounds, octahedral normals/tangents, half texture coordinates). The scene is built and rendered with full-precision vertices; only scenes loaded from the cache use the decoded vertices. The runtime vertex format is unchanged.
+            CompactSceneCacheVertices21Bit  = 0x80000,  ///< Use 21-bit instead of 16-bit positions for CompactSceneCacheVertices. Implies CompactSceneCacheVertices.
+            SAHMeshGrouping                 = 0x100000, ///< Partition mesh groups that exceed the per-BLAS triangle limit with a binned SAH cost over whole meshes instead of splitting meshes at the midpoint.
+            ReferenceTangentSpace           = 0x200000, ///< Generate tangents with the MikkTSpace library instead of the parallel tangent generator. The result is bit-exact with MikkTSpace, but each mesh is processed on a single thread.
+            SerialBuild                     = 0x400000, ///< Run the per-mesh scene build passes on a single thread. The result is identical to the parallel build, this is used to validate it.
+
+            UseCache                        = 0x10000000, ///< Enable scene caching. This caches the runtime scene representation on disk to reduce load time. Processed meshes are also cached individually (see MeshCache), so unchanged meshes are reused when the scene cache is invalid.
             RebuildCache                    = 0x20000000, ///< Rebuild scene cache.
 
             Default = None
@@ -128,6 +140,7 @@ namespace Falcor
             bool useOriginalTangentSpace = false;       ///< Indicate whether to use the original tangent space that was loaded with the mesh. By default, we will ignore it and use MikkTSpace to generate the tangent space.
             bool mergeDuplicateVertices = true;         ///< Indicate whether to merge identical vertices and adjust indices.
             NodeID skeletonNodeId{ NodeID::Invalid() }; ///< For skinned meshes, the node ID of the skeleton's world transform. If invalid, the skeleton is based on the mesh's own world position (Assimp behavior pre-multiplies instance transform).
+            std::optional<SHA1::MD> cacheKey;           ///< Optional. Mesh cache key from getMeshCacheKey(). If set, the processed mesh is cached under this key instead of a hash of the mesh data, and processMesh() leaves the cache lookup to the caller (see readCachedMesh()).
 
             template<typename T>
             uint32_t getAttributeIndex(const Attribute<T>& attribute, uint32_t face, uint32_t vert) const
@@ -169,7 +182,7 @@ namespace Falcor
             }
 
             template<typename T>
-            size_t getAttributeCount(const Attribute<T>& attribute)
+            size_t getAttributeCount(const Attribute<T>& attribute) const
             {
                 switch (attribute.frequency)
                 {
@@ -418,9 +431,10 @@ namespace Falcor
             \param The triangle mesh to add.
             \param pMaterial The material to use for the mesh.
             \param isAnimated True if the mesh vertices can be modified during rendering (e.g., skinning or inverse rendering).
+            \param cacheKey Optional mesh cache key from getMeshCacheKey(), see Mesh::cacheKey.
             \return The ID of the mesh in the scene.
         */
-        MeshID addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated = false);
+        MeshID addTriangleMesh(const ref<TriangleMesh>& pTriangleMesh, const ref<Material>& pMaterial, bool isAnimated = false, const std::optional<SHA1::MD>& cacheKey = {});
 
         /** Pre-process a mesh into the data format that is used in the global scene buffers.
             Throws an exception if something went wrong.
@@ -431,11 +445,34 @@ namespace Falcor
         */
         ProcessedMesh processMesh(const Mesh& mesh, MeshAttributeIndices* pAttributeIndices = nullptr, std::vector<float4>* pTangents = nullptr) const;
 
+        /** Get the mesh cache key of a mesh loaded from files.
+            Importers look up the processed mesh with this key before loading the mesh, so that unchanged meshes are neither loaded nor processed.
+            The key covers the file contents, the mesh within the files and the build flags that affect mesh processing. This function is thread safe.
+            \param paths Paths of the files the mesh is loaded from, e.g. a glTF file and its buffers.
+            \param meshName Identifies the mesh within the files and the importer settings used to load it.
+            \return The key, or an empty optional if mesh caching is disabled (see Flags::UseCache) or a file cannot be read.
+        */
+        std::optional<SHA1::MD> getMeshCacheKey(const std::vector<std::filesystem::path>& paths, std::string_view meshName) const;
+
+        /** Check if a mesh is in the mesh cache. This function is thread safe.
+            \param cacheKey Key from getMeshCacheKey().
+            \param pMaterial The material of the mesh.
+            \return True if the mesh is cached and the cache is not being rebuilt.
+        */
+        bool isMeshCached(const SHA1::MD& cacheKey, const ref<Material>& pMaterial) const;
+
+        /** Read a processed mesh from the mesh cache. This function is thread safe.
+            \param mesh The mesh description with Mesh::cacheKey set. Only the name, topology, material, winding and animation fields are used, the geometry is read from the cache.
+            \param processedMesh The processed mesh, to be added with addProcessedMesh().
+            \return True if the mesh was found in the cache.
+        */
+        bool readCachedMesh(const Mesh& mesh, ProcessedMesh& processedMesh) const;
+
         /** Generate tangents for a mesh.
             \param mesh The mesh to generate tangents for. If successful, the tangent attribute on the mesh will be set to the output vector.
             \param tangents Output for generated tangents.
         */
-        static void generateTangents(Mesh& mesh, std::vector<float4>& tangents);
+        void generateTangents(Mesh& mesh, std::vector<float4>& tangents) const;
 
         /** Add a pre-processed mesh.
             \param mesh The pre-processed mesh.
@@ -708,6 +745,7 @@ namespace Falcor
             bool isFrontFaceCW = false;             ///< Indicate whether front-facing side has clockwise winding in object space.
             bool isDisplaced = false;               ///< True if mesh has displacement map.
             bool isAnimated = false;                ///< True if the mesh vertices can be modified during rendering (e.g., skinning or inverse rendering).
+            bool isQuantized = false;               ///< True if the static vertex data is stored quantized in the scene cache, see selectCompactCacheMeshes().
             AABB boundingBox;                       ///< Mesh bounding-box in object space.
             std::set<NodeID> instances;             ///< IDs of all nodes that instantiate this mesh.
 
@@ -787,13 +825,20 @@ namespace Falcor
 
         std::unique_ptr<MaterialTextureLoader> mpMaterialTextureLoader;
 
+        mutable std::mutex mFileHashMutex;
+        mutable std::map<std::filesystem::path, SHA1::MD> mFileHashes; ///< Content hashes of the files passed to getMeshCacheKey().
+
         // Helpers
+        bool isParallelBuild() const;
         bool doesNodeHaveAnimation(NodeID nodeID) const;
         void updateLinkedObjects(NodeID oldNodeID, NodeID newNodeID);
         bool collapseNodes(NodeID parentNodeID, NodeID childNodeID);
         bool mergeNodes(NodeID dstNodeID, NodeID srcNodeID);
         void flipTriangleWinding(MeshSpec& mesh);
         void updateSDFGridID(SdfGridID oldID, SdfGridID newID);
+        SHA1::MD computeMeshCacheKey(const Mesh& mesh) const;
+        SHA1::MD computeMeshCacheKey(const SHA1::MD& cacheKey, const ref<Material>& pMaterial) const;
+        bool readMeshCache(const SHA1::MD& key, ProcessedMesh& processedMesh) const;
 
         /** Split a mesh by the given axis-aligned splitting plane.
             \return Pair of optional mesh IDs for the meshes on the left and right side, respectively.
@@ -801,7 +846,9 @@ namespace Falcor
         std::pair<std::optional<MeshID>, std::optional<MeshID>> splitMesh(MeshID meshID, const int axis, const float pos);
 
         void splitIndexedMesh(const MeshSpec& mesh, MeshSpec& leftMesh, MeshSpec& rightMesh, const int axis, const float pos);
-        void splitNonIndexedMesh(const MeshSpec& mesh, MeshSpec& leftMesh, MeshSpec& rightMesh, const int axis, const float pos);
+        static void splitNonIndexedMesh(const MeshSpec& mesh, MeshSpec& leftMesh, MeshSpec& rightMesh, const int axis, const float pos);
+        bool isMeshSplittable(MeshID meshID) const;
+        static float findMedianCentroid(const MeshSpec& mesh, const int axis);
 
         // Mesh group helpers
         size_t countTriangles(const MeshGroup& meshGroup) const;
@@ -810,6 +857,9 @@ namespace Falcor
         MeshGroupList splitMeshGroupSimple(MeshGroup& meshGroup) const;
         MeshGroupList splitMeshGroupMedian(MeshGroup& meshGroup) const;
         MeshGroupList splitMeshGroupMidpointMeshes(MeshGroup& meshGroup);
+        MeshGroupList splitMeshGroupSAH(MeshGroup& meshGroup);
+        MeshGroupList partitionMeshGroup(const MeshGroup& meshGroup, BLASGrouping::Strategy strategy) const;
+        std::vector<BLASGrouping::MeshInfo> getGroupingMeshInfos(const MeshGroup& meshGroup) const;
 
         // Post processing
         void prepareDisplacementMaps();
@@ -823,6 +873,8 @@ namespace Falcor
         void calculateMeshBoundingBoxes();
         void createMeshGroups();
         void optimizeGeometry();
+        void optimizeMeshLayout();
+        void selectCompactCacheMeshes();
         void sortMeshes();
         void createGlobalBuffers();
         void createCurveGlobalBuffers();
@@ -843,6 +895,7 @@ namespace Falcor
 
         friend class SceneCache;
         friend class SceneBuilderDump;
+        friend class SceneBuilderTest;
     };
 
     FALCOR_ENUM_CLASS_OPERATORS(SceneBuilder::Flags);
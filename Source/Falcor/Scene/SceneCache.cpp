@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "SceneCache.h"
+#include "VertexQuantization.h"
 #include "Material/StandardMaterial.h"
 #include "Material/HairMaterial.h"
 #include "Material/ClothMaterial.h"
@@ -43,7 +44,7 @@ namespace Falcor
         /** Specfies the current cache file version.
             This needs to be incremented every time the file format changes!
         */
-        const uint32_t kVersion = 25;
+        const uint32_t kVersion = 28;
 
         /** Scene cache directory (subdirectory in the application data directory).
         */
@@ -348,7 +349,7 @@ namespace Falcor
         stream.write(sceneData.has32BitIndices);
         stream.write(sceneData.meshDrawCount);
         stream.write(sceneData.meshIndexData);
-        stream.write(sceneData.meshStaticData);
+        writeMeshStaticData(stream, sceneData);
         stream.write(sceneData.meshSkinningData);
 
         writeMarker(stream, "Curves");
@@ -469,7 +470,7 @@ namespace Falcor
         stream.read(sceneData.has32BitIndices);
         stream.read(sceneData.meshDrawCount);
         stream.read(sceneData.meshIndexData);
-        stream.read(sceneData.meshStaticData);
+        readMeshStaticData(stream, sceneData);
         stream.read(sceneData.meshSkinningData);
 
         readMarker(stream, "Curves");
@@ -501,6 +502,90 @@ namespace Falcor
         return sceneData;
     }
 
+    // Mesh static vertex data
+
+    void SceneCache::writeMeshStaticData(OutputStream& stream, const Scene::SceneData& sceneData)
+    {
+        stream.write(sceneData.quantizedPositionBits);
+        stream.write(sceneData.quantizedMeshes);
+
+        // Write vertices of non-quantized meshes as is.
+        std::vector<bool> isQuantized(sceneData.meshStaticData.size(), false);
+        for (uint32_t meshID : sceneData.quantizedMeshes)
+        {
+            const auto& meshDesc = sceneData.meshDesc[meshID];
+            std::fill_n(isQuantized.begin() + meshDesc.vbOffset, meshDesc.vertexCount, true);
+        }
+
+        std::vector<PackedStaticVertexData> vertices;
+        for (size_t i = 0; i < sceneData.meshStaticData.size(); i++)
+        {
+            if (!isQuantized[i]) vertices.push_back(sceneData.meshStaticData[i]);
+        }
+        stream.write((uint64_t)sceneData.meshStaticData.size());
+        stream.write(vertices);
+
+        // Write vertices of quantized meshes in compact form.
+        const auto format = VertexQuantization::PositionFormat(sceneData.quantizedPositionBits);
+        for (uint32_t meshID : sceneData.quantizedMeshes)
+        {
+            const auto& meshDesc = sceneData.meshDesc[meshID];
+            std::vector<StaticVertexData> meshVertices(meshDesc.vertexCount);
+            for (uint32_t i = 0; i < meshDesc.vertexCount; i++) meshVertices[i] = sceneData.meshStaticData[meshDesc.vbOffset + i].unpack();
+
+            auto encoded = VertexQuantization::encode(meshVertices, format);
+            stream.write(encoded.bounds);
+            stream.write(encoded.positions16);
+            stream.write(encoded.positions21);
+            stream.write(encoded.normals);
+            stream.write(encoded.tangents);
+            stream.write(encoded.tangentSigns);
+            stream.write(encoded.texCrds);
+        }
+    }
+
+    void SceneCache::readMeshStaticData(InputStream& stream, Scene::SceneData& sceneData)
+    {
+        stream.read(sceneData.quantizedPositionBits);
+        stream.read(sceneData.quantizedMeshes);
+
+        std::vector<bool> isQuantized(stream.read<uint64_t>(), false);
+        for (uint32_t meshID : sceneData.quantizedMeshes)
+        {
+            const auto& meshDesc = sceneData.meshDesc[meshID];
+            std::fill_n(isQuantized.begin() + meshDesc.vbOffset, meshDesc.vertexCount, true);
+        }
+
+        std::vector<PackedStaticVertexData> vertices;
+        stream.read(vertices);
+        sceneData.meshStaticData.resize(isQuantized.size());
+        size_t next = 0;
+        for (size_t i = 0; i < isQuantized.size(); i++)
+        {
+            if (!isQuantized[i]) sceneData.meshStaticData[i] = vertices[next++];
+        }
+        FALCOR_ASSERT(next == vertices.size());
+
+        const auto format = VertexQuantization::PositionFormat(sceneData.quantizedPositionBits);
+        for (uint32_t meshID : sceneData.quantizedMeshes)
+        {
+            VertexQuantization::EncodedVertices encoded;
+            encoded.positionFormat = format;
+            stream.read(encoded.bounds);
+            stream.read(encoded.positions16);
+            stream.read(encoded.positions21);
+            stream.read(encoded.normals);
+            stream.read(encoded.tangents);
+            stream.read(encoded.tangentSigns);
+            stream.read(encoded.texCrds);
+
+            const auto& meshDesc = sceneData.meshDesc[meshID];
+            auto meshVertices = VertexQuantization::decode(encoded);
+            FALCOR_CHECK(meshVertices.size() == meshDesc.vertexCount, "Invalid vertex count for quantized mesh {}.", meshID);
+            for (uint32_t i = 0; i < meshDesc.vertexCount; i++) sceneData.meshStaticData[meshDesc.vbOffset + i].pack(meshVertices[i]);
+        }
+    }
+
     // Metadata
 
     void SceneCache::writeMetadata(OutputStream& stream, const Scene::Metadata& metadata)
@@ -820,6 +905,15 @@ namespace Falcor
                 stream.write(id);
             }
         }
+        for (const auto& pStreamer : pGridVolume->mStreamers)
+        {
+            stream.write(pStreamer != nullptr);
+            if (!pStreamer) continue;
+            stream.write(pStreamer->getPaths());
+            stream.write(pStreamer->getGridname());
+            stream.write(pStreamer->getWindowSize());
+            stream.write(pStreamer->getUseCache());
+        }
         stream.write(pGridVolume->mGridFrame);
         stream.write(pGridVolume->mGridFrameCount);
         stream.write(pGridVolume->mBounds);
@@ -844,11 +938,40 @@ namespace Falcor
                 pGrid = id == uint32_t(-1) ? nullptr : grids[id];
             }
         }
+        struct StreamerDesc
+        {
+            bool enabled = false;
+            std::vector<std::filesystem::path> paths;
+            std::string gridname;
+            uint32_t windowSize = 0;
+            bool useCache = false;
+        };
+        std::array<StreamerDesc, (size_t)GridVolume::GridSlot::Count> streamers;
+        for (auto& desc : streamers)
+        {
+            stream.read(desc.enabled);
+            if (!desc.enabled) continue;
+            stream.read(desc.paths);
+            stream.read(desc.gridname);
+            stream.read(desc.windowSize);
+            stream.read(desc.useCache);
+        }
         stream.read(pGridVolume->mGridFrame);
         stream.read(pGridVolume->mGridFrameCount);
         stream.read(pGridVolume->mBounds);
         stream.read(pGridVolume->mData);
 
+        // Continue streaming into the cached grids, which hold the current frame.
+        for (size_t slotIndex = 0; slotIndex < streamers.size(); ++slotIndex)
+        {
+            const auto& desc = streamers[slotIndex];
+            if (!desc.enabled) continue;
+            auto pStreamer = GridSequenceStreamer::create(pDevice, desc.paths, desc.gridname, desc.windowSize, desc.useCache);
+            const auto& gridSequence = pGridVolume->mGrids[slotIndex];
+            pStreamer->setGrid(gridSequence.empty() ? nullptr : gridSequence[0], std::min(pGridVolume->mGridFrame, pStreamer->getFrameCount() - 1));
+            pGridVolume->mStreamers[slotIndex] = pStreamer;
+        }
+
         return pGridVolume;
     }
 
@@ -877,6 +1000,12 @@ namespace Falcor
         stream.write(path);
         stream.write(pEnvMap->mData);
         stream.write(pEnvMap->mRotation);
+
+        // Store the importance map so that it doesn't need to be rebuilt when loading from the cache.
+        const auto& importanceMap = pEnvMap->getImportanceMap();
+        stream.write(importanceMap.dimension);
+        stream.write(importanceMap.samples);
+        stream.write(importanceMap.data);
     }
 
     ref<EnvMap> SceneCache::readEnvMap(InputStream& stream, ref<Device> pDevice)
@@ -886,6 +1015,9 @@ namespace Falcor
         if (!pEnvMap) FALCOR_THROW("Failed to load environment map");
         stream.read(pEnvMap->mData);
         stream.read(pEnvMap->mRotation);
+        stream.read(pEnvMap->mImportanceMap.dimension);
+        stream.read(pEnvMap->mImportanceMap.samples);
+        stream.read(pEnvMap->mImportanceMap.data);
         return pEnvMap;
     }
 
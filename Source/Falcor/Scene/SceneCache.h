@@ -84,6 +84,9 @@ namespace Falcor
         static void writeSceneData(OutputStream& stream, const Scene::SceneData& sceneData);
         static Scene::SceneData readSceneData(InputStream& stream, ref<Device> pDevice);
 
+        static void writeMeshStaticData(OutputStream& stream, const Scene::SceneData& sceneData);
+        static void readMeshStaticData(InputStream& stream, Scene::SceneData& sceneData);
+
         static void writeMetadata(OutputStream& stream, const Scene::Metadata& metadata);
         static Scene::Metadata readMetadata(InputStream& stream);
 
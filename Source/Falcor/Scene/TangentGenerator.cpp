@@ -0,0 +1,364 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TangentGenerator.h"
+#include "Core/Error.h"
+#include "Utils/Logger.h"
+#include "Utils/Math/MathHelpers.h"
+#include "Utils/NumericRange.h"
+#include <mikktspace.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <execution>
+
+namespace Falcor
+{
+    namespace TangentGenerator
+    {
+        namespace
+        {
+            using Mesh = SceneBuilder::Mesh;
+
+            class MikkTSpaceWrapper
+            {
+            public:
+                static std::vector<float4> generateTangents(const Mesh& mesh)
+                {
+                    // Generate new tangent space.
+                    SMikkTSpaceInterface mikktspace = {};
+                    mikktspace.m_getNumFaces = [](const SMikkTSpaceContext* pContext) { return ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getFaceCount(); };
+                    mikktspace.m_getNumVerticesOfFace = [](const SMikkTSpaceContext* pContext, int32_t face) { return 3; };
+                    mikktspace.m_getPosition = [](const SMikkTSpaceContext* pContext, float position[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getPosition(position, face, vert); };
+                    mikktspace.m_getNormal = [](const SMikkTSpaceContext* pContext, float normal[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getNormal(normal, face, vert); };
+                    mikktspace.m_getTexCoord = [](const SMikkTSpaceContext* pContext, float texCrd[], int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->getTexCrd(texCrd, face, vert); };
+                    mikktspace.m_setTSpaceBasic = [](const SMikkTSpaceContext* pContext, const float tangent[], float sign, int32_t face, int32_t vert) { ((MikkTSpaceWrapper*)(pContext->m_pUserData))->setTangent(tangent, sign, face, vert); };
+
+                    MikkTSpaceWrapper wrapper(mesh);
+                    SMikkTSpaceContext context = {};
+                    context.m_pInterface = &mikktspace;
+                    context.m_pUserData = &wrapper;
+
+                    if (genTangSpaceDefault(&context) == false)
+                    {
+                        FALCOR_THROW("MikkTSpace failed to generate tangents for the mesh '{}'.", mesh.name);
+                    }
+
+                    return std::move(wrapper.mTangents);
+                }
+
+            private:
+                MikkTSpaceWrapper(const Mesh& mesh)
+                    : mMesh(mesh)
+                {
+                    FALCOR_ASSERT(mesh.indexCount > 0);
+                    mTangents.resize(mesh.indexCount, float4(0));
+
+                    FALCOR_ASSERT_EQ(mesh.indexCount, mMesh.faceCount * 3);
+                    mPositions.resize(mMesh.faceCount * 3);
+                    switch (mMesh.positions.frequency)
+                    {
+                    case Mesh::AttributeFrequency::Constant:
+                    {
+                        std::fill_n(mPositions.begin(), mPositions.size(), mMesh.positions.pData[0]);
+                        break;
+                    }
+                    case Mesh::AttributeFrequency::Uniform:
+                    {
+                        for (uint32_t i = 0; i < mMesh.faceCount; ++i)
+                            std::fill_n(mPositions.begin() + i * 3, 3, mMesh.positions.pData[i]);
+                        break;
+                    }
+                    case Mesh::AttributeFrequency::Vertex:
+                    {
+                        FALCOR_ASSERT_EQ(mesh.indexCount, mPositions.size());
+                        for (size_t fvarIdx = 0; fvarIdx < mPositions.size(); ++fvarIdx)
+                            mPositions[fvarIdx] = mMesh.positions.pData[mMesh.pIndices[fvarIdx]];
+                        break;
+                    }
+                    case Mesh::AttributeFrequency::FaceVarying:
+                    {
+                        memcpy(mPositions.data(), mMesh.positions.pData, mPositions.size() * sizeof(float3));
+                        break;
+                    }
+                    default:
+                        FALCOR_UNREACHABLE();
+                    }
+
+                }
+                const Mesh& mMesh;
+                std::vector<float4> mTangents;
+                std::vector<float3> mPositions;
+                int32_t getFaceCount() const { return (int32_t)mMesh.faceCount; }
+                void getPosition(float position[], int32_t face, int32_t vert) const { FALCOR_ASSERT_LT(size_t(face) * 3 + vert, mPositions.size()); memcpy(position, mPositions.data() + (face * 3 + vert), sizeof(float3)); }
+                void getNormal(float normal[], int32_t face, int32_t vert) { *reinterpret_cast<float3*>(normal) = mMesh.getNormal(face, vert); }
+                void getTexCrd(float texCrd[], int32_t face, int32_t vert) { *reinterpret_cast<float2*>(texCrd) = mMesh.getTexCrd(face, vert); }
+
+                void setTangent(const float tangent[], float sign, int32_t face, int32_t vert)
+                {
+                    float3 T = *reinterpret_cast<const float3*>(tangent);
+                    mTangents[face * 3 + vert] = float4(normalize(T), sign);
+                }
+            };
+
+            /// Texture space orientation of a triangle. Tangents are only averaged over triangles with the same orientation.
+            enum class Orientation : uint8_t
+            {
+                Preserving,
+                Reversing,
+            };
+
+            /// Attributes that identify a vertex. Corners with bitwise identical attributes are welded, as in MikkTSpace.
+            struct CornerVertex
+            {
+                float3 position;
+                float3 normal;
+                float2 texCrd;
+            };
+            static_assert(sizeof(CornerVertex) == 32);
+
+            struct CornerKey
+            {
+                uint64_t hash;
+                uint32_t corner;
+            };
+
+            /// Same threshold as MikkTSpace.
+            bool notZero(float x) { return std::fabs(x) > FLT_MIN; }
+            bool notZero(const float3& v) { return notZero(v.x) || notZero(v.y) || notZero(v.z); }
+            float3 normalizeIfNotZero(const float3& v) { return notZero(v) ? normalize(v) : v; }
+
+            /// Map -0 to +0 so that welding by bit pattern matches welding by value.
+            float canonical(float x) { return x == 0.f ? 0.f : x; }
+            float3 canonical(const float3& v) { return float3(canonical(v.x), canonical(v.y), canonical(v.z)); }
+            float2 canonical(const float2& v) { return float2(canonical(v.x), canonical(v.y)); }
+
+            uint64_t hashVertex(const CornerVertex& v)
+            {
+                uint32_t words[8];
+                std::memcpy(words, &v, sizeof(words));
+                uint64_t hash = 0xcbf29ce484222325ull;
+                for (uint32_t w : words) hash = (hash ^ w) * 0x100000001b3ull;
+                return hash ^ (hash >> 32);
+            }
+
+            float4 getFallbackTangent(const float3& normal)
+            {
+                return float4(perp_stark(normal), 1.f);
+            }
+
+            std::vector<float4> generateParallel(const Mesh& mesh)
+            {
+                const uint32_t faceCount = mesh.faceCount;
+                const uint32_t cornerCount = faceCount * 3;
+
+                std::vector<CornerVertex> vertices(cornerCount);
+                std::vector<Orientation> orientations(faceCount);
+                std::vector<uint8_t> isValidFace(faceCount);
+                std::vector<float3> weightedTangents(cornerCount);
+
+                // Evaluate the texture space derivatives of each triangle and the angle weighted contribution to each corner.
+                NumericRange<uint32_t> faceRange(0, faceCount);
+                std::for_each(std::execution::par_unseq, faceRange.begin(), faceRange.end(), [&](uint32_t face)
+                {
+                    CornerVertex v[3];
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        v[i].position = canonical(mesh.getPosition(face, i));
+                        v[i].normal = canonical(mesh.getNormal(face, i));
+                        v[i].texCrd = canonical(mesh.getTexCrd(face, i));
+                        vertices[face * 3 + i] = v[i];
+                    }
+
+                    const float2 t21 = v[1].texCrd - v[0].texCrd;
+                    const float2 t31 = v[2].texCrd - v[0].texCrd;
+                    const float3 d1 = v[1].position - v[0].position;
+                    const float3 d2 = v[2].position - v[0].position;
+
+                    const float signedAreaSTx2 = t21.x * t31.y - t21.y * t31.x;
+                    const float3 vOs = t31.y * d1 - t21.y * d2;
+                    const float3 vOt = -t31.x * d1 + t21.x * d2;
+
+                    float3 tangent(0.f);
+                    bool isValid = false;
+                    if (notZero(signedAreaSTx2))
+                    {
+                        const float absArea = std::fabs(signedAreaSTx2);
+                        const float lenOs = length(vOs);
+                        const float lenOt = length(vOt);
+                        const float s = signedAreaSTx2 > 0.f ? 1.f : -1.f;
+                        if (notZero(lenOs)) tangent = vOs * (s / lenOs);
+                        isValid = notZero(lenOs / absArea) && notZero(lenOt / absArea);
+                    }
+                    orientations[face] = signedAreaSTx2 > 0.f ? Orientation::Preserving : Orientation::Reversing;
+                    isValidFace[face] = isValid;
+
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        if (!isValid)
+                        {
+                            weightedTangents[face * 3 + i] = float3(0.f);
+                            continue;
+                        }
+
+                        // Project onto the tangent plane and weight by the angle between the two edges at the corner.
+                        const float3 n = v[i].normal;
+                        const float3 t = normalizeIfNotZero(tangent - n * dot(n, tangent));
+                        float3 e0 = v[(i + 2) % 3].position - v[i].position;
+                        float3 e1 = v[(i + 1) % 3].position - v[i].position;
+                        e0 = normalizeIfNotZero(e0 - n * dot(n, e0));
+                        e1 = normalizeIfNotZero(e1 - n * dot(n, e1));
+                        const float angle = std::acos(std::clamp(dot(e0, e1), -1.f, 1.f));
+                        weightedTangents[face * 3 + i] = angle * t;
+                    }
+                });
+
+                // Weld corners into vertices by sorting on the vertex attributes.
+                // Ties are broken by the corner index, which fixes the summation order below.
+                std::vector<CornerKey> keys(cornerCount);
+                NumericRange<uint32_t> cornerRange(0, cornerCount);
+                std::for_each(std::execution::par_unseq, cornerRange.begin(), cornerRange.end(), [&](uint32_t corner)
+                {
+                    keys[corner] = { hashVertex(vertices[corner]), corner };
+                });
+                std::sort(std::execution::par, keys.begin(), keys.end(), [&](const CornerKey& a, const CornerKey& b)
+                {
+                    if (a.hash != b.hash) return a.hash < b.hash;
+                    int cmp = std::memcmp(&vertices[a.corner], &vertices[b.corner], sizeof(CornerVertex));
+                    if (cmp != 0) return cmp < 0;
+                    return a.corner < b.corner;
+                });
+
+                std::vector<uint8_t> isVertexStart(cornerCount);
+                std::for_each(std::execution::par_unseq, cornerRange.begin(), cornerRange.end(), [&](uint32_t i)
+                {
+                    isVertexStart[i] = i == 0 || keys[i - 1].hash != keys[i].hash ||
+                        std::memcmp(&vertices[keys[i - 1].corner], &vertices[keys[i].corner], sizeof(CornerVertex)) != 0;
+                });
+                std::vector<uint32_t> vertexStarts;
+                for (uint32_t i = 0; i < cornerCount; i++)
+                {
+                    if (isVertexStart[i]) vertexStarts.push_back(i);
+                }
+                const uint32_t vertexCount = (uint32_t)vertexStarts.size();
+                vertexStarts.push_back(cornerCount);
+
+                // Accumulate the corner contributions per vertex and orientation.
+                std::vector<uint32_t> cornerVertices(cornerCount);
+                std::vector<float4> vertexTangents(vertexCount * 2);
+                std::vector<uint8_t> vertexOrientations(vertexCount); // Bit mask of the orientations of the valid triangles sharing the vertex.
+                NumericRange<uint32_t> vertexRange(0, vertexCount);
+                std::for_each(std::execution::par, vertexRange.begin(), vertexRange.end(), [&](uint32_t vertex)
+                {
+                    float3 sums[2] = { float3(0.f), float3(0.f) };
+                    uint8_t mask = 0;
+                    for (uint32_t i = vertexStarts[vertex]; i < vertexStarts[vertex + 1]; i++)
+                    {
+                        const uint32_t corner = keys[i].corner;
+                        cornerVertices[corner] = vertex;
+                        if (!isValidFace[corner / 3]) continue;
+                        const uint32_t orientation = (uint32_t)orientations[corner / 3];
+                        sums[orientation] += weightedTangents[corner];
+                        mask |= 1 << orientation;
+                    }
+                    vertexOrientations[vertex] = mask;
+
+                    const float3 normal = vertices[keys[vertexStarts[vertex]].corner].normal;
+                    for (uint32_t orientation = 0; orientation < 2; orientation++)
+                    {
+                        const float3& sum = sums[orientation];
+                        vertexTangents[vertex * 2 + orientation] = notZero(sum) ? float4(normalize(sum), orientation == 0 ? 1.f : -1.f) : getFallbackTangent(normal);
+                    }
+                });
+
+                // Write the vertex tangents to the corners. Triangles with degenerate texture coordinates don't have an orientation
+                // of their own and join the orientation of the valid triangles at their vertices. If the vertices disagree,
+                // the orientation given by the sign of the texture space area is kept.
+                std::vector<float4> tangents(cornerCount);
+                std::for_each(std::execution::par_unseq, faceRange.begin(), faceRange.end(), [&](uint32_t face)
+                {
+                    uint32_t orientation = (uint32_t)orientations[face];
+                    if (!isValidFace[face])
+                    {
+                        int votes = 0;
+                        for (uint32_t i = 0; i < 3; i++)
+                        {
+                            const uint8_t mask = vertexOrientations[cornerVertices[face * 3 + i]];
+                            votes += mask == 1 ? 1 : (mask == 2 ? -1 : 0);
+                        }
+                        if (votes != 0) orientation = votes > 0 ? 0 : 1;
+                    }
+
+                    for (uint32_t i = 0; i < 3; i++)
+                    {
+                        const uint32_t corner = face * 3 + i;
+                        const uint32_t vertex = cornerVertices[corner];
+                        if (vertexOrientations[vertex] & (1 << orientation))
+                        {
+                            tangents[corner] = vertexTangents[vertex * 2 + orientation];
+                        }
+                        else
+                        {
+                            // No valid triangle with this orientation shares the vertex.
+                            tangents[corner] = float4(getFallbackTangent(vertices[corner].normal).xyz(), orientation == 0 ? 1.f : -1.f);
+                        }
+                    }
+                });
+
+                return tangents;
+            }
+        }
+
+        std::vector<float4> generate(const SceneBuilder::Mesh& mesh, Mode mode)
+        {
+            if (!mesh.normals.pData || !mesh.positions.pData || !mesh.texCrds.pData || !mesh.pIndices)
+            {
+                logWarning("Can't generate tangent space. The mesh '{}' doesn't have positions/normals/texCrd/indices.", mesh.name);
+                return {};
+            }
+            FALCOR_CHECK(mesh.indexCount == mesh.faceCount * 3, "The mesh '{}' must be a triangle list.", mesh.name);
+
+            if (mode == Mode::Parallel) return generateParallel(mesh);
+
+            std::vector<float4> tangents = MikkTSpaceWrapper::generateTangents(mesh);
+
+            // MikkTSpace can produce NaN tangents in case of degenerate triangles,
+            // e.g. triangles where all three points, normals, and texture coordinates happen to be identical.
+            // We are replacing these NaN tangents by arbitrary tangent orthonormal to the vertex normal.
+            NumericRange<uint32_t> range(0, mesh.indexCount);
+            std::for_each(std::execution::par_unseq, range.begin(), range.end(), [&](uint32_t fvIndex)
+            {
+                if (!any(isnan(tangents[fvIndex])))
+                    return;
+                tangents[fvIndex] = getFallbackTangent(mesh.getNormal(fvIndex / 3, fvIndex % 3));
+            });
+
+            return tangents;
+        }
+    }
+}
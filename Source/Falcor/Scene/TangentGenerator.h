@@ -0,0 +1,68 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneBuilder.h"
+#include "Core/Macros.h"
+#include "Utils/Math/Vector.h"
+#include <vector>
+
+namespace Falcor
+{
+    /** Tangent space generation for triangle meshes.
+
+        The parallel generator evaluates the MikkTSpace tangent space directly on the mesh attribute arrays.
+        Per-triangle tangents are projected onto the tangent plane of each corner and weighted by the corner
+        angle as in MikkTSpace. Corners are then welded into vertices with identical position, normal and
+        texture coordinate and the same texture space orientation, and the weighted tangents are summed per
+        vertex. All passes are split over the triangles/vertices of the mesh, so large meshes use all cores.
+        Summation order is fixed by the corner order, so the output does not depend on the thread count.
+
+        The output matches MikkTSpace up to floating-point summation order, with two exceptions: triangle fans
+        around a vertex are not split into separate groups when they are only connected through the vertex, and
+        triangles with degenerate texture coordinates pick their orientation from their vertices rather than
+        from MikkTSpace's traversal order.
+        Use Mode::Reference to run the MikkTSpace library for results that are bit-exact with MikkTSpace.
+    */
+    namespace TangentGenerator
+    {
+        enum class Mode
+        {
+            Parallel,   ///< Evaluate on the attribute arrays, parallelized within the mesh.
+            Reference,  ///< Run the MikkTSpace library. Bit-exact with MikkTSpace, single-threaded.
+        };
+
+        /** Generate tangents for a triangle mesh.
+            The mesh must have positions, normals, texture coordinates and indices.
+            Corners without a valid tangent (degenerate texture coordinates) get an arbitrary tangent orthogonal to the normal.
+            \param[in] mesh The mesh.
+            \param[in] mode Generation mode.
+            \return Per-corner tangents (face-varying frequency) with the bitangent sign in w, or an empty vector if the mesh is missing required attributes.
+        */
+        FALCOR_API std::vector<float4> generate(const SceneBuilder::Mesh& mesh, Mode mode = Mode::Parallel);
+    }
+}
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "TriangleMesh.h"
+#include "PlyReader.h"
 #include "GlobalState.h"
 #include "Core/Error.h"
 #include "Core/Platform/OS.h"
@@ -201,6 +202,11 @@ namespace Falcor
             return nullptr;
         }
 
+        if (hasExtension(path, "ply") || (hasExtension(path, "gz") && hasExtension(path.stem(), "ply")))
+        {
+            return createFromPlyFile(path, importFlags);
+        }
+
         Assimp::Importer importer;
 
         unsigned int flags =
@@ -273,6 +279,82 @@ namespace Falcor
         return create(vertices, indices);
     }
 
+    ref<TriangleMesh> TriangleMesh::createFromPlyFile(const std::filesystem::path& path, ImportFlags importFlags)
+    {
+        PlyReader::Mesh mesh;
+        try
+        {
+            if (hasExtension(path, "gz"))
+            {
+                auto decompressed = decompressFile(path);
+                mesh = PlyReader::read(decompressed.data(), decompressed.size());
+            }
+            else
+            {
+                mesh = PlyReader::readFile(path);
+            }
+        }
+        catch (const std::exception& e)
+        {
+            logWarning("Failed to load triangle mesh from '{}': {}", path, e.what());
+            return nullptr;
+        }
+
+        auto& vertices = mesh.vertices;
+        auto& indices = mesh.indices;
+
+        // Flip texture coordinates to match the ASSIMP import path (aiProcess_FlipUVs).
+        if (mesh.hasTexCoords)
+        {
+            for (auto& v : vertices) v.texCoord.y = 1.f - v.texCoord.y;
+        }
+
+        // Generate normals if missing, same as the ASSIMP import path.
+        if (!mesh.hasNormals)
+        {
+            if (is_set(importFlags, ImportFlags::GenSmoothNormals))
+            {
+                // Area weighted vertex normals.
+                for (auto& v : vertices) v.normal = float3(0.f);
+                for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    auto& v0 = vertices[indices[i]];
+                    auto& v1 = vertices[indices[i + 1]];
+                    auto& v2 = vertices[indices[i + 2]];
+                    float3 n = cross(v1.position - v0.position, v2.position - v0.position);
+                    v0.normal += n;
+                    v1.normal += n;
+                    v2.normal += n;
+                }
+                for (auto& v : vertices)
+                {
+                    float len = length(v.normal);
+                    v.normal = len > 0.f ? v.normal / len : float3(0.f, 0.f, 1.f);
+                }
+            }
+            else
+            {
+                // Facet normals. Vertices are duplicated per triangle.
+                VertexList flatVertices(indices.size());
+                for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    for (size_t j = 0; j < 3; j++) flatVertices[i + j] = vertices[indices[i + j]];
+                    float3 n = cross(flatVertices[i + 1].position - flatVertices[i].position, flatVertices[i + 2].position - flatVertices[i].position);
+                    float len = length(n);
+                    n = len > 0.f ? n / len : float3(0.f, 0.f, 1.f);
+                    for (size_t j = 0; j < 3; j++) flatVertices[i + j].normal = n;
+                }
+                vertices = std::move(flatVertices);
+                for (uint32_t i = 0; i < (uint32_t)indices.size(); i++) indices[i] = i;
+            }
+        }
+
+        ref<TriangleMesh> pMesh = create();
+        pMesh->mVertices = std::move(vertices);
+        pMesh->mIndices = std::move(indices);
+        return pMesh;
+    }
+
     ref<TriangleMesh> TriangleMesh::createFromFile(const std::filesystem::path& path, bool smoothNormals)
     {
         ImportFlags flags = smoothNormals ? ImportFlags::GenSmoothNormals : ImportFlags::None;
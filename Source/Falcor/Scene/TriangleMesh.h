@@ -111,6 +111,7 @@ namespace Falcor
 
         /** Creates a triangle mesh from a file.
             This is using ASSIMP to support a wide variety of asset formats.
+            PLY files (optionally gzip compressed) are loaded with a dedicated reader (see PlyReader).
             All geometry found in the asset is pre-transformed and merged into the same triangle mesh.
             \param[in] path File path to load mesh from (absolute or relative to working directory).
             \param[in] flags Flags controlling ASSIMP mesh import options.
@@ -190,6 +191,8 @@ namespace Falcor
         TriangleMesh();
         TriangleMesh(const VertexList& vertices, const IndexList& indices, bool frontFaceCW);
 
+        static ref<TriangleMesh> createFromPlyFile(const std::filesystem::path& path, ImportFlags flags);
+
         std::string mName;
         std::vector<Vertex> mVertices;
         std::vector<uint32_t> mIndices;
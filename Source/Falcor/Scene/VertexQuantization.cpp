@@ -0,0 +1,200 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "VertexQuantization.h"
+#include "Core/Error.h"
+#include "Utils/Math/Float16.h"
+#include "Utils/Math/PackedFormats.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Falcor
+{
+    namespace VertexQuantization
+    {
+        namespace
+        {
+            uint32_t getMaxCode(PositionFormat format)
+            {
+                return (1u << uint32_t(format)) - 1;
+            }
+
+            /** Encode a direction. Zero length directions (e.g. invalid tangents) are encoded as +z.
+            */
+            uint32_t encodeDirection(float3 v)
+            {
+                float len = length(v);
+                return encodeNormal2x16(len > 0.f ? v / len : float3(0.f, 0.f, 1.f));
+            }
+
+            float angleBetween(float3 a, float3 b)
+            {
+                float la = length(a);
+                float lb = length(b);
+                if (la == 0.f || lb == 0.f) return 0.f;
+                return std::acos(std::clamp(dot(a, b) / (la * lb), -1.f, 1.f));
+            }
+        }
+
+        ErrorStats& ErrorStats::operator+=(const ErrorStats& other)
+        {
+            vertexCount += other.vertexCount;
+            maxPositionError = std::max(maxPositionError, other.maxPositionError);
+            sumPositionError += other.sumPositionError;
+            maxNormalError = std::max(maxNormalError, other.maxNormalError);
+            maxTangentError = std::max(maxTangentError, other.maxTangentError);
+            maxTexCrdError = std::max(maxTexCrdError, other.maxTexCrdError);
+            return *this;
+        }
+
+        uint32_t getBytesPerVertex(PositionFormat format)
+        {
+            uint32_t positionBytes = format == PositionFormat::Unorm16 ? 3 * sizeof(uint16_t) : sizeof(uint64_t);
+            return positionBytes + 2 * sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t);
+        }
+
+        float getPositionErrorBound(const AABB& bounds, PositionFormat format)
+        {
+            // Half a quantization step per component, plus a small slack for float rounding in the decoder.
+            float3 step = bounds.extent() / float(getMaxCode(format));
+            float3 bound = 0.5f * step + 1e-6f * (abs(bounds.minPoint) + abs(bounds.maxPoint));
+            return length(bound);
+        }
+
+        EncodedVertices encode(const std::vector<StaticVertexData>& vertices, PositionFormat format)
+        {
+            EncodedVertices encoded;
+            encoded.positionFormat = format;
+
+            for (const auto& v : vertices) encoded.bounds.include(v.position);
+
+            const size_t count = vertices.size();
+            const uint32_t maxCode = getMaxCode(format);
+            const float3 extent = encoded.bounds.extent();
+            const float3 scale = float3(
+                extent.x > 0.f ? maxCode / extent.x : 0.f,
+                extent.y > 0.f ? maxCode / extent.y : 0.f,
+                extent.z > 0.f ? maxCode / extent.z : 0.f);
+
+            if (format == PositionFormat::Unorm16) encoded.positions16.resize(3 * count);
+            else encoded.positions21.resize(count);
+            encoded.normals.resize(count);
+            encoded.tangents.resize(count);
+            encoded.tangentSigns.resize(count);
+            encoded.texCrds.resize(count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const auto& v = vertices[i];
+
+                float3 p = (v.position - encoded.bounds.minPoint) * scale;
+                uint3 q = uint3(clamp(round(p), float3(0.f), float3(float(maxCode))));
+                if (format == PositionFormat::Unorm16)
+                {
+                    encoded.positions16[3 * i + 0] = uint16_t(q.x);
+                    encoded.positions16[3 * i + 1] = uint16_t(q.y);
+                    encoded.positions16[3 * i + 2] = uint16_t(q.z);
+                }
+                else
+                {
+                    encoded.positions21[i] = uint64_t(q.x) | (uint64_t(q.y) << 21) | (uint64_t(q.z) << 42);
+                }
+
+                encoded.normals[i] = encodeDirection(v.normal);
+                encoded.tangents[i] = encodeDirection(v.tangent.xyz());
+
+                // Same convention as PackedStaticVertexData: the curve radius is folded into the tangent sign.
+                float tangentSign = v.tangent.w;
+                if (v.curveRadius > 0.f) tangentSign *= v.curveRadius;
+                encoded.tangentSigns[i] = uint16_t(f32tof16(tangentSign));
+
+                encoded.texCrds[i] = f32tof16(v.texCrd.x) | (f32tof16(v.texCrd.y) << 16);
+            }
+
+            return encoded;
+        }
+
+        std::vector<StaticVertexData> decode(const EncodedVertices& encoded)
+        {
+            const size_t count = encoded.getVertexCount();
+            const uint32_t maxCode = getMaxCode(encoded.positionFormat);
+            const float3 step = encoded.bounds.extent() / float(maxCode);
+
+            FALCOR_CHECK(encoded.positionFormat == PositionFormat::Unorm16 ? encoded.positions16.size() == 3 * count : encoded.positions21.size() == count, "Invalid position count.");
+            FALCOR_CHECK(encoded.tangents.size() == count && encoded.tangentSigns.size() == count && encoded.texCrds.size() == count, "Invalid attribute count.");
+
+            std::vector<StaticVertexData> vertices(count);
+            for (size_t i = 0; i < count; i++)
+            {
+                auto& v = vertices[i];
+
+                uint3 q;
+                if (encoded.positionFormat == PositionFormat::Unorm16)
+                {
+                    q = uint3(encoded.positions16[3 * i + 0], encoded.positions16[3 * i + 1], encoded.positions16[3 * i + 2]);
+                }
+                else
+                {
+                    uint64_t packed = encoded.positions21[i];
+                    q = uint3(uint32_t(packed & maxCode), uint32_t((packed >> 21) & maxCode), uint32_t((packed >> 42) & maxCode));
+                }
+                v.position = encoded.bounds.minPoint + float3(q) * step;
+
+                v.normal = decodeNormal2x16(encoded.normals[i]);
+
+                float tangentSign = f16tof32(encoded.tangentSigns[i]);
+                v.tangent = float4(decodeNormal2x16(encoded.tangents[i]), tangentSign > 0.f ? 1.f : (tangentSign < 0.f ? -1.f : 0.f));
+                v.curveRadius = std::abs(tangentSign);
+
+                v.texCrd = float2(f16tof32(encoded.texCrds[i] & 0xffff), f16tof32(encoded.texCrds[i] >> 16));
+            }
+
+            return vertices;
+        }
+
+        ErrorStats computeError(const std::vector<StaticVertexData>& original, const std::vector<StaticVertexData>& decoded)
+        {
+            FALCOR_CHECK(original.size() == decoded.size(), "Vertex count mismatch.");
+
+            ErrorStats stats;
+            stats.vertexCount = original.size();
+            for (size_t i = 0; i < original.size(); i++)
+            {
+                const auto& a = original[i];
+                const auto& b = decoded[i];
+
+                float positionError = length(a.position - b.position);
+                stats.maxPositionError = std::max(stats.maxPositionError, positionError);
+                stats.sumPositionError += positionError;
+                stats.maxNormalError = std::max(stats.maxNormalError, angleBetween(a.normal, b.normal));
+                if (a.tangent.w != 0.f) stats.maxTangentError = std::max(stats.maxTangentError, angleBetween(a.tangent.xyz(), b.tangent.xyz()));
+                stats.maxTexCrdError = std::max(stats.maxTexCrdError, length(a.texCrd - b.texCrd));
+            }
+            return stats;
+        }
+    }
+}
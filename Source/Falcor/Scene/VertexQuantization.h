@@ -0,0 +1,114 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "SceneTypes.slang"
+#include "Core/Macros.h"
+#include "Utils/Math/AABB.h"
+#include <cstdint>
+#include <vector>
+
+namespace Falcor
+{
+    /** Compact quantized encoding of static mesh vertices.
+
+        Positions are quantized per mesh to 16 or 21 bits per component relative to the mesh bounding box.
+        Normals and tangents are stored as octahedral 2x16-bit snorm, the tangent sign (scaled by the curve radius)
+        and the texture coordinates as half floats. This reduces the storage of a vertex from 48 bytes
+        (StaticVertexData) or 32 bytes (PackedStaticVertexData) to 20 or 22 bytes.
+    */
+    namespace VertexQuantization
+    {
+        enum class PositionFormat : uint32_t
+        {
+            Unorm16 = 16,   ///< 3x 16-bit unorm relative to the mesh bounds.
+            Unorm21 = 21,   ///< 3x 21-bit unorm relative to the mesh bounds, packed in 64 bits.
+        };
+
+        /** Encoded vertices of a single mesh, stored as one array per attribute.
+        */
+        struct EncodedVertices
+        {
+            PositionFormat positionFormat = PositionFormat::Unorm16;
+            AABB bounds;                        ///< Bounds used for position quantization.
+            std::vector<uint16_t> positions16;  ///< Positions for PositionFormat::Unorm16, 3 elements per vertex.
+            std::vector<uint64_t> positions21;  ///< Positions for PositionFormat::Unorm21, 1 element per vertex.
+            std::vector<uint32_t> normals;      ///< Octahedral normals (2x 16-bit snorm).
+            std::vector<uint32_t> tangents;     ///< Octahedral tangents (2x 16-bit snorm).
+            std::vector<uint16_t> tangentSigns; ///< Tangent sign times curve radius (half). Zero marks an invalid tangent.
+            std::vector<uint32_t> texCrds;      ///< Texture coordinates (2x half).
+
+            size_t getVertexCount() const { return normals.size(); }
+        };
+
+        /** Quantization error statistics.
+        */
+        struct ErrorStats
+        {
+            uint64_t vertexCount = 0;
+            float maxPositionError = 0.f;           ///< Max distance between original and decoded positions.
+            double sumPositionError = 0.0;          ///< Sum of distances between original and decoded positions.
+            float maxNormalError = 0.f;             ///< Max angle in radians between original and decoded normals.
+            float maxTangentError = 0.f;            ///< Max angle in radians between original and decoded valid tangents.
+            float maxTexCrdError = 0.f;             ///< Max distance between original and decoded texture coordinates.
+
+            double getMeanPositionError() const { return vertexCount > 0 ? sumPositionError / vertexCount : 0.0; }
+
+            ErrorStats& operator+=(const ErrorStats& other);
+        };
+
+        /** Get the storage size of an encoded vertex in bytes.
+        */
+        FALCOR_API uint32_t getBytesPerVertex(PositionFormat format);
+
+        /** Get the upper bound of the position error (distance) introduced by quantization.
+            \param[in] bounds Bounds used for quantization.
+            \param[in] format Position format.
+        */
+        FALCOR_API float getPositionErrorBound(const AABB& bounds, PositionFormat format);
+
+        /** Encode vertices. The position bounds are computed from the vertices.
+            \param[in] vertices Vertices.
+            \param[in] format Position format.
+            \return Encoded vertices.
+        */
+        FALCOR_API EncodedVertices encode(const std::vector<StaticVertexData>& vertices, PositionFormat format);
+
+        /** Decode vertices.
+            \param[in] encoded Encoded vertices.
+            \return Decoded vertices.
+        */
+        FALCOR_API std::vector<StaticVertexData> decode(const EncodedVertices& encoded);
+
+        /** Measure the error between original and decoded vertices.
+            \param[in] original Original vertices.
+            \param[in] decoded Decoded vertices.
+            \return Error statistics.
+        */
+        FALCOR_API ErrorStats computeError(const std::vector<StaticVertexData>& original, const std::vector<StaticVertexData>& decoded);
+    }
+}
@@ -27,6 +27,9 @@
  **************************************************************************/
 #pragma once
 #include "Core/API/Texture.h"
+#include "Core/API/Formats.h"
+#include "Utils/Math/Vector.h"
+#include <vector>
 
 namespace Falcor
 {
@@ -36,4 +39,18 @@ namespace Falcor
         ref<Texture> indirection;
         ref<Texture> atlas;
     };
+
+    /** Host-side data of a bricked grid.
+        This is the output of the CPU conversion from NanoVDB, which can run on any thread.
+        The textures of a BrickedGrid are created from it on the main thread.
+    */
+    struct BrickedGridData
+    {
+        uint3 rangeSize = uint3(0);         ///< Size of the range and indirection textures at mip 0 (in bricks).
+        uint3 atlasSize = uint3(0);         ///< Size of the atlas texture (in texels).
+        ResourceFormat atlasFormat = ResourceFormat::Unknown;
+        std::vector<uint32_t> rangeData;    ///< Range texture data (RG16Float, 4 mips).
+        std::vector<uint32_t> ptrData;      ///< Indirection texture data (RGBA8Uint).
+        std::vector<uint8_t> atlasData;     ///< Atlas texture data.
+    };
 }
@@ -26,6 +26,7 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #include "Grid.h"
+#include "GridCache.h"
 #include "GridConverter.h"
 #include "Core/API/Device.h"
 #include "Core/Program/ShaderVar.h"
@@ -89,27 +90,78 @@ namespace Falcor
         return ref<Grid>(new Grid(pDevice, std::move(handle)));
     }
 
-    ref<Grid> Grid::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    ref<Grid> Grid::createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname, bool useCache)
+    {
+        HostData hostData;
+        if (!loadHostData(path, gridname, hostData, useCache)) return nullptr;
+        return createFromHostData(pDevice, std::move(hostData));
+    }
+
+    bool Grid::loadHostData(const std::filesystem::path& path, const std::string& gridname, HostData& hostData, bool useCache)
     {
         if (!std::filesystem::exists(path))
         {
             logWarning("Error when loading grid. Can't open grid file '{}'.", path);
-            return nullptr;
+            return false;
+        }
+
+        GridCache::Key cacheKey;
+        if (useCache)
+        {
+            cacheKey = GridCache::getKey(path, gridname);
+            if (GridCache::instance().read(cacheKey, hostData)) return true;
         }
 
+        nanovdb::GridHandle<nanovdb::HostBuffer> handle;
         if (hasExtension(path, "nvdb"))
         {
-            return createFromNanoVDBFile(pDevice, path, gridname);
+            handle = readNanoVDBFile(path, gridname);
         }
         else if (hasExtension(path, "vdb"))
         {
-            return createFromOpenVDBFile(pDevice, path, gridname);
+            handle = readOpenVDBFile(path, gridname);
         }
         else
         {
             logWarning("Error when loading grid. Unsupported grid file '{}'.", path);
-            return nullptr;
+            return false;
         }
+        if (!handle) return false;
+
+        hostData = createHostData(std::move(handle));
+        if (useCache) GridCache::instance().write(cacheKey, hostData);
+        return true;
+    }
+
+    Grid::HostData Grid::createHostData(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
+    {
+        HostData hostData;
+        hostData.gridHandle = std::move(gridHandle);
+
+        auto floatGrid = hostData.gridHandle.grid<float>();
+        FALCOR_CHECK(floatGrid, "Grid is not of type float.");
+        if (!floatGrid->hasMinMax())
+        {
+            nanovdb::gridStats(*floatGrid);
+        }
+
+        using NanoVDBGridConverter = NanoVDBConverterBC4;
+        hostData.bricks = NanoVDBGridConverter(floatGrid).convert();
+        return hostData;
+    }
+
+    ref<Grid> Grid::createFromHostData(ref<Device> pDevice, HostData hostData)
+    {
+        return ref<Grid>(new Grid(pDevice, std::move(hostData)));
+    }
+
+    void Grid::setHostData(HostData hostData)
+    {
+        mGridHandle = std::move(hostData.gridHandle);
+        mpFloatGrid = mGridHandle.grid<float>();
+        FALCOR_CHECK(mpFloatGrid, "Grid is not of type float.");
+        mAccessor = mpFloatGrid->getAccessor();
+        createDeviceData(hostData.bricks);
     }
 
     void Grid::renderUI(Gui::Widgets& widget)
@@ -203,16 +255,20 @@ namespace Falcor
     }
 
     Grid::Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle)
+        : Grid(pDevice, createHostData(std::move(gridHandle)))
+    {}
+
+    Grid::Grid(ref<Device> pDevice, HostData hostData)
         : mpDevice(pDevice)
-        , mGridHandle(std::move(gridHandle))
+        , mGridHandle(std::move(hostData.gridHandle))
         , mpFloatGrid(mGridHandle.grid<float>())
         , mAccessor(mpFloatGrid->getAccessor())
     {
-        if (!mpFloatGrid->hasMinMax())
-        {
-            nanovdb::gridStats(*mpFloatGrid);
-        }
+        createDeviceData(hostData.bricks);
+    }
 
+    void Grid::createDeviceData(const BrickedGridData& bricks)
+    {
         // Keep both NanoVDB and brick textures resident in GPU memory for simplicity for now (~15% increased footprint).
         mpBuffer = mpDevice->createStructuredBuffer(
             sizeof(uint32_t),
@@ -221,42 +277,43 @@ namespace Falcor
             MemoryType::DeviceLocal,
             mGridHandle.data()
         );
-        using NanoVDBGridConverter = NanoVDBConverterBC4;
-        mBrickedGrid = NanoVDBGridConverter(mpFloatGrid).convert(mpDevice);
+        mBrickedGrid.range = mpDevice->createTexture3D(bricks.rangeSize.x, bricks.rangeSize.y, bricks.rangeSize.z, ResourceFormat::RG16Float, 4, bricks.rangeData.data(), ResourceBindFlags::ShaderResource);
+        mBrickedGrid.indirection = mpDevice->createTexture3D(bricks.rangeSize.x, bricks.rangeSize.y, bricks.rangeSize.z, ResourceFormat::RGBA8Uint, 1, bricks.ptrData.data(), ResourceBindFlags::ShaderResource);
+        mBrickedGrid.atlas = mpDevice->createTexture3D(bricks.atlasSize.x, bricks.atlasSize.y, bricks.atlasSize.z, bricks.atlasFormat, 1, bricks.atlasData.data(), ResourceBindFlags::ShaderResource);
     }
 
-    ref<Grid> Grid::createFromNanoVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         if (!nanovdb::io::hasGrid(path.string(), gridname))
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         auto handle = nanovdb::io::readGrid(path.string(), gridname);
         if (!handle)
         {
             logWarning("Error when loading grid.");
-            return nullptr;
+            return {};
         }
 
         auto floatGrid = handle.grid<float>();
         if (!floatGrid || floatGrid->gridType() != nanovdb::GridType::Float)
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (floatGrid->isEmpty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return handle;
     }
 
-    ref<Grid> Grid::createFromOpenVDBFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname)
+    nanovdb::GridHandle<nanovdb::HostBuffer> Grid::readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname)
     {
         openvdb::initialize();
 
@@ -278,25 +335,23 @@ namespace Falcor
         if (!baseGrid)
         {
             logWarning("Error when loading grid. Can't find grid '{}' in '{}'.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (!baseGrid->isType<openvdb::FloatGrid>())
         {
             logWarning("Error when loading grid. Grid '{}' in '{}' is not of type float.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         if (baseGrid->empty())
         {
             logWarning("Grid '{}' in '{}' is empty.", gridname, path);
-            return nullptr;
+            return {};
         }
 
         openvdb::FloatGrid::Ptr floatGrid = openvdb::gridPtrCast<openvdb::FloatGrid>(baseGrid);
-        auto handle = nanovdb::openToNanoVDB(floatGrid);
-
-        return ref<Grid>(new Grid(pDevice, std::move(handle)));
+        return nanovdb::openToNanoVDB(floatGrid);
     }
 
 
@@ -327,7 +382,9 @@ namespace Falcor
 
         auto createFromFile = [] (const std::filesystem::path& path, const std::string& gridname)
         {
-            return Grid::createFromFile(accessActivePythonSceneBuilder().getDevice(), getActiveAssetResolver().resolvePath(path), gridname);
+            auto& sceneBuilder = accessActivePythonSceneBuilder();
+            bool useCache = is_set(sceneBuilder.getFlags(), SceneBuilder::Flags::UseCache);
+            return Grid::createFromFile(sceneBuilder.getDevice(), getActiveAssetResolver().resolvePath(path), gridname, useCache);
         };
         grid.def_static("createFromFile", createFromFile, "path"_a, "gridname"_a); // PYTHONDEPRECATED
     }
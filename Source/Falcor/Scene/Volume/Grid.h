@@ -60,6 +60,16 @@ namespace Falcor
     {
         FALCOR_OBJECT(Grid)
     public:
+        /** Host-side grid data.
+            This is the result of the CPU stage of loading a grid (file I/O, conversion to NanoVDB and to bricks).
+            It can be produced on any thread, creating a grid from it only uploads the data to the GPU.
+        */
+        struct HostData
+        {
+            nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle;
+            BrickedGridData bricks;
+        };
+
         /** Create a sphere voxel grid.
             \param[in] pDevice GPU device.
             \param[in] radius Radius of the sphere in world units.
@@ -85,9 +95,40 @@ namespace Falcor
             \param[in] pDevice GPU device.
             \param[in] path File path of the grid (absolute or relative to working directory).
             \param[in] gridname Name of the grid to load.
+            \param[in] useCache Use the on-disk grid cache (see GridCache). Converted grids are stored in the cache and reused on later loads.
             \return A new grid, or nullptr if the grid failed to load.
         */
-        static ref<Grid> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname);
+        static ref<Grid> createFromFile(ref<Device> pDevice, const std::filesystem::path& path, const std::string& gridname, bool useCache = false);
+
+        /** Load host-side grid data from a file.
+            This does not access the GPU and is safe to call from multiple threads.
+            \param[in] path File path of the grid (absolute or relative to working directory).
+            \param[in] gridname Name of the grid to load.
+            \param[out] hostData Loaded host-side grid data.
+            \param[in] useCache Use the on-disk grid cache (see GridCache). Converted grids are stored in the cache and reused on later loads.
+            \return True if the grid was loaded successfully.
+        */
+        static bool loadHostData(const std::filesystem::path& path, const std::string& gridname, HostData& hostData, bool useCache = false);
+
+        /** Create host-side grid data from a NanoVDB grid.
+            Computes the grid statistics if missing and converts the grid to bricks.
+            \param[in] gridHandle NanoVDB grid of type float.
+            \return Host-side grid data.
+        */
+        static HostData createHostData(nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+
+        /** Create a grid from host-side data.
+            \param[in] pDevice GPU device.
+            \param[in] hostData Host-side grid data.
+            \return A new grid.
+        */
+        static ref<Grid> createFromHostData(ref<Device> pDevice, HostData hostData);
+
+        /** Replace the content of the grid.
+            The grid object stays the same, which allows swapping grids without rebuilding the scene (e.g. for streaming sequences).
+            \param[in] hostData Host-side grid data.
+        */
+        void setHostData(HostData hostData);
 
         /** Render the UI.
         */
@@ -146,9 +187,12 @@ namespace Falcor
 
     private:
         Grid(ref<Device> pDevice, nanovdb::GridHandle<nanovdb::HostBuffer> gridHandle);
+        Grid(ref<Device> pDevice, HostData hostData);
+
+        void createDeviceData(const BrickedGridData& bricks);
 
-        static ref<Grid> createFromNanoVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
-        static ref<Grid> createFromOpenVDBFile(ref<Device>, const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readNanoVDBFile(const std::filesystem::path& path, const std::string& gridname);
+        static nanovdb::GridHandle<nanovdb::HostBuffer> readOpenVDBFile(const std::filesystem::path& path, const std::string& gridname);
 
         ref<Device> mpDevice;
 
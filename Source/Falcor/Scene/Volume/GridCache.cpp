@@ -0,0 +1,365 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "GridCache.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Scripting/ScriptBindings.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace Falcor
+{
+    namespace
+    {
+        /** Specifies the current grid cache file version.
+            This needs to be incremented every time the file format or the brick conversion changes!
+        */
+        const uint32_t kVersion = 1;
+
+        /** Grid cache directory (subdirectory in the application data directory).
+        */
+        const std::string kDirectory = "NVIDIA/Falcor/GridCache";
+
+        const char* kMagic = "FalcorG$";
+        struct Header
+        {
+            uint8_t magic[8]{};
+            uint32_t version{};
+
+            bool isValid() const
+            {
+                return std::memcmp(magic, kMagic, sizeof(Header::magic)) == 0 && version == kVersion;
+            }
+        };
+
+        template<typename T>
+        void writeVector(std::ostream& stream, const std::vector<T>& vec)
+        {
+            uint64_t size = vec.size();
+            stream.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            stream.write(reinterpret_cast<const char*>(vec.data()), size * sizeof(T));
+        }
+
+        template<typename T>
+        void readVector(std::istream& stream, std::vector<T>& vec, uint64_t maxSize)
+        {
+            uint64_t size = 0;
+            stream.read(reinterpret_cast<char*>(&size), sizeof(size));
+            if (!stream.good() || size > maxSize / sizeof(T))
+            {
+                stream.setstate(std::ios_base::failbit);
+                return;
+            }
+            vec.resize(size);
+            stream.read(reinterpret_cast<char*>(vec.data()), size * sizeof(T));
+        }
+
+        bool isEntry(const std::filesystem::directory_entry& entry)
+        {
+            // Skip temporary files of writes in progress.
+            std::error_code ec;
+            return entry.is_regular_file(ec) && !entry.path().has_extension();
+        }
+    }
+
+    GridCache& GridCache::instance()
+    {
+        static GridCache sInstance;
+        return sInstance;
+    }
+
+    GridCache::GridCache()
+        : mDirectory(getAppDataDirectory() / kDirectory)
+    {}
+
+    GridCache::Key GridCache::getKey(const std::filesystem::path& path, const std::string& gridname)
+    {
+        // The key includes the file size and modification time so that entries of modified files are not used.
+        SHA1 sha1;
+        sha1.update(kVersion);
+        sha1.update(std::filesystem::absolute(path).string());
+        sha1.update((uint8_t)0);
+        sha1.update(gridname);
+        sha1.update((uint64_t)std::filesystem::file_size(path));
+        sha1.update((int64_t)std::filesystem::last_write_time(path).time_since_epoch().count());
+        return sha1.finalize();
+    }
+
+    void GridCache::setDirectory(const std::filesystem::path& directory)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDirectory = directory;
+        mSize.reset();
+    }
+
+    std::filesystem::path GridCache::getDirectory() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory;
+    }
+
+    void GridCache::setMaxSize(uint64_t maxSize)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxSize = maxSize;
+    }
+
+    uint64_t GridCache::getMaxSize() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mMaxSize;
+    }
+
+    bool GridCache::read(const Key& key, Grid::HostData& hostData)
+    {
+        auto entryPath = getEntryPath(key);
+
+        auto miss = [&]()
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.misses++;
+            return false;
+        };
+
+        std::error_code ec;
+        const uint64_t fileSize = std::filesystem::file_size(entryPath, ec);
+        if (ec) return miss();
+
+        std::ifstream fs(entryPath, std::ios_base::binary);
+        if (!fs.good()) return miss();
+
+        Header header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!fs.good() || !header.isValid()) return miss();
+
+        uint64_t size = 0;
+        fs.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!fs.good() || size == 0 || size > fileSize) return miss();
+        auto buffer = nanovdb::HostBuffer::create(size);
+        fs.read(reinterpret_cast<char*>(buffer.data()), size);
+
+        auto& bricks = hostData.bricks;
+        fs.read(reinterpret_cast<char*>(&bricks.rangeSize), sizeof(bricks.rangeSize));
+        fs.read(reinterpret_cast<char*>(&bricks.atlasSize), sizeof(bricks.atlasSize));
+        fs.read(reinterpret_cast<char*>(&bricks.atlasFormat), sizeof(bricks.atlasFormat));
+        readVector(fs, bricks.rangeData, fileSize);
+        readVector(fs, bricks.ptrData, fileSize);
+        readVector(fs, bricks.atlasData, fileSize);
+        if (!fs.good())
+        {
+            logWarning("Failed to read grid cache file '{}'.", entryPath);
+            hostData.bricks = {};
+            return miss();
+        }
+        fs.close();
+
+        hostData.gridHandle = nanovdb::GridHandle<nanovdb::HostBuffer>(std::move(buffer));
+        if (hostData.gridHandle.grid<float>() == nullptr)
+        {
+            hostData = {};
+            return miss();
+        }
+
+        // Mark the entry as recently used.
+        std::filesystem::last_write_time(entryPath, std::filesystem::file_time_type::clock::now(), ec);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.hits++;
+        mStats.bytesRead += fileSize;
+        return true;
+    }
+
+    void GridCache::write(const Key& key, const Grid::HostData& hostData)
+    {
+        auto entryPath = getEntryPath(key);
+
+        std::error_code ec;
+        std::filesystem::create_directories(entryPath.parent_path(), ec);
+
+        // Write to a temporary file first, the same grid may be written from multiple threads or processes.
+        std::ostringstream suffix;
+        suffix << ".tmp" << std::this_thread::get_id();
+        std::filesystem::path tmpPath = entryPath;
+        tmpPath += suffix.str();
+
+        {
+            std::ofstream fs(tmpPath, std::ios_base::binary);
+            if (!fs.good())
+            {
+                logWarning("Failed to create grid cache file '{}'.", tmpPath);
+                return;
+            }
+
+            Header header;
+            std::memcpy(header.magic, kMagic, sizeof(Header::magic));
+            header.version = kVersion;
+            fs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            const auto& buffer = hostData.gridHandle.buffer();
+            uint64_t size = buffer.size();
+            fs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+            fs.write(reinterpret_cast<const char*>(buffer.data()), size);
+
+            const auto& bricks = hostData.bricks;
+            fs.write(reinterpret_cast<const char*>(&bricks.rangeSize), sizeof(bricks.rangeSize));
+            fs.write(reinterpret_cast<const char*>(&bricks.atlasSize), sizeof(bricks.atlasSize));
+            fs.write(reinterpret_cast<const char*>(&bricks.atlasFormat), sizeof(bricks.atlasFormat));
+            writeVector(fs, bricks.rangeData);
+            writeVector(fs, bricks.ptrData);
+            writeVector(fs, bricks.atlasData);
+            if (!fs.good())
+            {
+                logWarning("Failed to write grid cache file '{}'.", tmpPath);
+                fs.close();
+                std::filesystem::remove(tmpPath, ec);
+                return;
+            }
+        }
+
+        const uint64_t fileSize = std::filesystem::file_size(tmpPath, ec);
+        std::filesystem::rename(tmpPath, entryPath, ec);
+        if (ec)
+        {
+            logWarning("Failed to write grid cache file '{}': {}", entryPath, ec.message());
+            std::filesystem::remove(tmpPath, ec);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.writes++;
+        mStats.bytesWritten += fileSize;
+
+        if (!mSize)
+        {
+            // Scan the cache directory on the first write (this includes the entry just written).
+            trimLocked(mMaxSize);
+        }
+        else
+        {
+            *mSize += fileSize;
+            if (*mSize > mMaxSize) trimLocked(mMaxSize);
+        }
+    }
+
+    void GridCache::trim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(mMaxSize);
+    }
+
+    void GridCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        trimLocked(0);
+    }
+
+    GridCache::Stats GridCache::getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+    void GridCache::resetStats()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats = {};
+    }
+
+    std::filesystem::path GridCache::getEntryPath(const Key& key) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mDirectory / SHA1::toString(key);
+    }
+
+    void GridCache::trimLocked(uint64_t maxSize)
+    {
+        struct Entry
+        {
+            std::filesystem::path path;
+            std::filesystem::file_time_type time;
+            uint64_t size;
+        };
+
+        std::vector<Entry> entries;
+        uint64_t totalSize = 0;
+
+        std::error_code ec;
+        for (const auto& it : std::filesystem::directory_iterator(mDirectory, ec))
+        {
+            if (!isEntry(it)) continue;
+            Entry entry{ it.path(), it.last_write_time(ec), it.file_size(ec) };
+            if (ec) continue;
+            totalSize += entry.size;
+            entries.push_back(std::move(entry));
+        }
+
+        // Evict the least recently used entries first.
+        if (totalSize > maxSize)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+            for (const auto& entry : entries)
+            {
+                if (totalSize <= maxSize) break;
+                if (std::filesystem::remove(entry.path, ec))
+                {
+                    totalSize -= entry.size;
+                    mStats.evictions++;
+                }
+            }
+        }
+
+        mSize = totalSize;
+    }
+
+    FALCOR_SCRIPT_BINDING(GridCache)
+    {
+        pybind11::class_<GridCache> gridCache(m, "GridCache");
+        gridCache.def_static("instance", &GridCache::instance, pybind11::return_value_policy::reference);
+        gridCache.def_property("directory", &GridCache::getDirectory, &GridCache::setDirectory);
+        gridCache.def_property("max_size", &GridCache::getMaxSize, &GridCache::setMaxSize);
+        gridCache.def_property_readonly("stats", [](const GridCache& self)
+        {
+            auto stats = self.getStats();
+            pybind11::dict d;
+            d["hits"] = stats.hits;
+            d["misses"] = stats.misses;
+            d["writes"] = stats.writes;
+            d["evictions"] = stats.evictions;
+            d["bytes_read"] = stats.bytesRead;
+            d["bytes_written"] = stats.bytesWritten;
+            d["hit_rate"] = stats.getHitRate();
+            return d;
+        });
+        gridCache.def("reset_stats", &GridCache::resetStats);
+        gridCache.def("trim", &GridCache::trim);
+        gridCache.def("clear", &GridCache::clear);
+    }
+}
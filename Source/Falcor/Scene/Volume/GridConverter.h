@@ -32,6 +32,7 @@
 #include "Utils/Logger.h"
 #include "Utils/HostDeviceShared.slangh"
 #include "Utils/NumericRange.h"
+#include "Utils/Math/Common.h"
 #include "Utils/Math/Vector.h"
 #include "Utils/Timing/CpuTimer.h"
 
@@ -45,7 +46,7 @@
 #endif
 
 #include <algorithm>
-#include <atomic>
+#include <cstring>
 #include <execution>
 #include <vector>
 
@@ -56,6 +57,13 @@ namespace Falcor
     using NanoVDBConverterUNORM8 = NanoVDBToBricksConverter<uint8_t, 8>;
     using NanoVDBConverterUNORM16 = NanoVDBToBricksConverter<uint16_t, 16>;
 
+    /** Converts a NanoVDB float grid to bricks (range and indirection textures with a brick atlas).
+        The conversion is sparse: only active leaf nodes are visited to compute the brick value ranges
+        (including a 1 voxel halo) and to encode the atlas bricks. Leaves are processed in parallel in batches.
+        Only leaves with a non-constant value range are stored in the atlas, so the atlas size scales with
+        the number of such leaves. The range and indirection textures are dense over the grid bounds as
+        required by the shader, the range mips are built level by level with parallel slices.
+    */
     template <typename TexelType, unsigned int kBitsPerTexel>
     struct NanoVDBToBricksConverter
     {
@@ -63,18 +71,35 @@ namespace Falcor
         NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid);
         NanoVDBToBricksConverter(const NanoVDBToBricksConverter& rhs) = delete;
 
-        BrickedGrid convert(ref<Device> pDevice);
+        /** Convert the grid to bricks on the CPU.
+            The converter is consumed, the returned data takes ownership of the buffers.
+        */
+        BrickedGridData convert();
 
     private:
+        using LeafNode = nanovdb::NanoLeaf<float>;
+
         const static uint32_t kBrickSize = 8; // Must be 8, to match both NanoVDB leaf size.
+        const static uint32_t kBrickVoxelCount = kBrickSize * kBrickSize * kBrickSize;
         const static int32_t kBC4Compress = kBitsPerTexel == 4;
+        const static uint32_t kLeafBatchSize = 64;
+        const static uint32_t kInvalidSlot = uint32_t(-1);
 
+        void analyzeLeaf(uint32_t leafIndex, nanovdb::FloatGrid::AccessorType& a);
+        void encodeLeaf(uint32_t leafIndex);
         void convertSlice(int z);
-        void computeMip(int mip);
+        void computeMipSlice(int mip, int z);
+
+        template<typename Func>
+        void forEachLeafBatch(Func func);
 
         inline uint3 getAtlasSizeBricks() const { return mAtlasSizeBricks; }
         inline uint3 getAtlasSizePixels() const { return mAtlasSizeBricks * kBrickSize; }
         inline uint32_t getAtlasMaxBrick() const { return mAtlasSizeBricks.x * mAtlasSizeBricks.y * mAtlasSizeBricks.z; }
+        inline uint3 getAtlasBrick(uint32_t slot) const
+        {
+            return uint3(slot % mAtlasSizeBricks.x, (slot / mAtlasSizeBricks.x) % mAtlasSizeBricks.y, slot / (mAtlasSizeBricks.x * mAtlasSizeBricks.y));
+        }
 
         inline ResourceFormat getAtlasFormat() {
             switch (kBitsPerTexel) {
@@ -103,21 +128,26 @@ namespace Falcor
         }
 
         const nanovdb::FloatGrid* mpFloatGrid;
+        const LeafNode* mpLeaves;
+        uint32_t mLeafNodeCount;
         uint3 mAtlasSizeBricks;
         int3 mLeafDim[4];
         int3 mBBMin, mBBMax, mPixDim;
         uint32_t mLeafCount[4];
+        std::vector<float2> mLeafMajMin;    ///< Value range (majorant, minorant) of each leaf, including the halo.
+        std::vector<uint32_t> mLeafSlot;    ///< Atlas slot of each leaf, or kInvalidSlot for constant leaves.
         std::vector<uint32_t> mRangeData;
         std::vector<uint32_t> mPtrData;
         std::vector<TexelType> mAtlasData;
-        std::atomic_uint32_t mNonEmptyCount;
+        uint32_t mNonEmptyCount = 0;
     };
 
     template <typename TexelType, unsigned int kBitsPerTexel>
     NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::NanoVDBToBricksConverter(const nanovdb::FloatGrid* grid)
     {
-        mNonEmptyCount.store(0);
         mpFloatGrid = grid;
+        mpLeaves = grid->tree().template getFirstNode<0>();
+        mLeafNodeCount = grid->tree().nodeCount(0);
         auto& voxelbox = mpFloatGrid->indexBBox();
         mBBMin = (int3(voxelbox.min().x(), voxelbox.min().y(), voxelbox.min().z())) & (~7);
         mBBMax = (int3(voxelbox.max().x(), voxelbox.max().y(), voxelbox.max().z()) + 7) & (~7);
@@ -128,25 +158,153 @@ namespace Falcor
             mLeafDim[i] = mPixDim / (8 << i);
             mLeafCount[i] = (mLeafDim[i].x * mLeafDim[i].y * mLeafDim[i].z) + (i ? mLeafCount[i - 1] : 0); // Cumulative leaf count up the mips.
         }
-        uint leafCount = grid->tree().nodeCount(0);
-        uint approxdim = 1u << uint(log2f((float)leafCount + 1.f) / 3.f); // Choose the first 2 dimensions to be powers of 2.
-        uint lastdim = (leafCount + approxdim * approxdim - 1) / (approxdim * approxdim);
-        mAtlasSizeBricks = uint3(approxdim, approxdim, lastdim);
-        uint3 atlasSizePixels = getAtlasSizePixels();
-        uint leafTexelCount = atlasSizePixels.x * atlasSizePixels.y * atlasSizePixels.z;
         mRangeData.resize(mLeafCount[3]);
         mPtrData.resize(mLeafCount[0]);
-        mAtlasData.resize(kBC4Compress ? (leafTexelCount / 16) : leafTexelCount);
+        mLeafMajMin.resize(mLeafNodeCount);
+        mLeafSlot.resize(mLeafNodeCount);
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertSlice(int z)
+    template <typename Func>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::forEachLeafBatch(Func func)
+    {
+        uint32_t batchCount = div_round_up(mLeafNodeCount, kLeafBatchSize);
+        auto range = NumericRange<uint32_t>(0, batchCount);
+        std::for_each(std::execution::par, range.begin(), range.end(), [&](uint32_t batch)
+        {
+            auto a = mpFloatGrid->getAccessor();
+            uint32_t end = std::min((batch + 1) * kLeafBatchSize, mLeafNodeCount);
+            for (uint32_t leafIndex = batch * kLeafBatchSize; leafIndex < end; ++leafIndex) func(leafIndex, a);
+        });
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::analyzeLeaf(uint32_t leafIndex, nanovdb::FloatGrid::AccessorType& a)
     {
+        const LeafNode* leaf = mpLeaves + leafIndex;
+        const float* data = leaf->data()->mValues;
+
+        // Value range of the leaf voxels. Use independent lanes so that the loop vectorizes.
+        const uint32_t kLanes = 8;
+        float laneMin[kLanes], laneMax[kLanes];
+        for (uint32_t l = 0; l < kLanes; ++l) laneMin[l] = laneMax[l] = data[l];
+        for (uint32_t i = 0; i < kBrickVoxelCount; i += kLanes)
+        {
+            for (uint32_t l = 0; l < kLanes; ++l)
+            {
+                laneMin[l] = std::min(laneMin[l], data[i + l]);
+                laneMax[l] = std::max(laneMax[l], data[i + l]);
+            }
+        }
+        float minorant = laneMin[0], majorant = laneMax[0];
+        for (uint32_t l = 1; l < kLanes; ++l) expandMinorantMajorant(laneMin[l], minorant, majorant), expandMinorantMajorant(laneMax[l], minorant, majorant);
+
+        // We also need the 1-halo from the 26 neighbouring bricks. Read the values of neighbouring leaves directly,
+        // bricks without a leaf are covered by a tile and have a constant value.
+        const nanovdb::Coord origin = leaf->origin();
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    if (dx == 0 && dy == 0 && dz == 0) continue;
+                    nanovdb::Coord ijk = origin + nanovdb::Coord(dx * (int)kBrickSize, dy * (int)kBrickSize, dz * (int)kBrickSize);
+                    auto neighbor = a.probeLeaf(ijk);
+                    if (!neighbor)
+                    {
+                        expandMinorantMajorant(a.getValue(ijk), minorant, majorant);
+                        continue;
+                    }
+                    const float* neighborData = neighbor->data()->mValues;
+                    int x0 = dx < 0 ? kBrickSize - 1 : 0, x1 = dx > 0 ? 0 : kBrickSize - 1;
+                    int y0 = dy < 0 ? kBrickSize - 1 : 0, y1 = dy > 0 ? 0 : kBrickSize - 1;
+                    int z0 = dz < 0 ? kBrickSize - 1 : 0, z1 = dz > 0 ? 0 : kBrickSize - 1;
+                    for (int x = x0; x <= x1; ++x)
+                        for (int y = y0; y <= y1; ++y)
+                            for (int z = z0; z <= z1; ++z)
+                                expandMinorantMajorant(neighborData[x * kBrickSize * kBrickSize + y * kBrickSize + z], minorant, majorant);
+                }
+            }
+        }
+
+        if (minorant != majorant)
+        {
+            // Widen the range to fp16 precision to make sure the quantized voxels fall into it.
+            majorant = f16tof32(f32tof16(majorant) + 1);
+            minorant = f16tof32(f32tof16(minorant));
+            mLeafSlot[leafIndex] = 0;
+        }
+        else
+        {
+            mLeafSlot[leafIndex] = kInvalidSlot;
+        }
+        mLeafMajMin[leafIndex] = float2(majorant, minorant);
+    }
+
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::encodeLeaf(uint32_t leafIndex)
+    {
+        uint32_t slot = mLeafSlot[leafIndex];
+        if (slot == kInvalidSlot) return;
+
         uint3 atlasSizePixels = getAtlasSizePixels();
-        uint brickMax = getAtlasMaxBrick();
-        uint bricksPerSlice = mAtlasSizeBricks.x * mAtlasSizeBricks.y;
         uint pixelsPerSlice = atlasSizePixels.x * atlasSizePixels.y;
+        uint3 atlasBrick = getAtlasBrick(slot);
+        uint32_t atlasx = atlasBrick.x, atlasy = atlasBrick.y, atlasz = atlasBrick.z;
+
+        const float* data = mpLeaves[leafIndex].data()->mValues;
+        float majorant = mLeafMajMin[leafIndex].x;
+        float minorant = mLeafMajMin[leafIndex].y;
+
+        if (!kBC4Compress) {
+            float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
+            TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
+            for (int pixz = 0; pixz < kBrickSize; ++pixz)
+            {
+                for (int pixy = 0; pixy < kBrickSize; ++pixy)
+                {
+                    for (int pixx = 0; pixx < kBrickSize; ++pixx)
+                    {
+                        float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
+                        *atlasdst++ = TexelType((f - minorant) * invRange);
+                    }
+                    atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
+                }
+                atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
+            }
+        }
+        else {
+            // BC4 compression:
+            float invRange = (255.f) / (majorant - minorant);
+            uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
+            for (int pixz = 0; pixz < kBrickSize; ++pixz)
+            {
+                for (int tiley = 0; tiley < kBrickSize; tiley += 4)
+                {
+                    for (int tilex = 0; tilex < kBrickSize; tilex += 4) {
+                        uint8_t tilevals[4][4];
+                        for (int pixy = 0; pixy < 4; ++pixy)
+                        {
+                            for (int pixx = 0; pixx < 4; ++pixx)
+                            {
+                                float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
+                                tilevals[pixy][pixx] = uint8_t((f - minorant) * invRange);
+                            }
+                        }
+                        CompressAlphaDxt5((uint8_t*)&tilevals[0][0], atlasdst);
+                        atlasdst++;
+                    }
+                    atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
+                }
+                atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
+            } // z slice loop
+        } // bc4 compress?
+    }
 
+    template <typename TexelType, unsigned int kBitsPerTexel>
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convertSlice(int z)
+    {
         size_t offset = z * mLeafDim[0].x * mLeafDim[0].y;
         uint32_t* rangedst = mRangeData.data() + offset;
         uint32_t* ptrdst = mPtrData.data() + offset;
@@ -156,147 +314,116 @@ namespace Falcor
             for (int x = 0; x < mLeafDim[0].x; ++x)
             {
                 nanovdb::Coord ijk = { x * 8 + mBBMin.x, y * 8 + mBBMin.y, z * 8 + mBBMin.z };
-                auto val = a.getValue(ijk);
                 auto leaf = a.probeLeaf(ijk);
-                float minorant = val, majorant = val;
-                uint myleaf = 0;
+                uint32_t slot = kInvalidSlot;
+                float majorant, minorant;
                 if (leaf)
                 {
-                    // Nanovdb only stores minorant/majorant for active voxels, but we need all of them... Grab the central 8x8x8 first the quick way.
-                    const float* data = leaf->data()->mValues;
-                    for (int i = 0; i < kBrickSize * kBrickSize * kBrickSize; ++i) expandMinorantMajorant(data[i], minorant, majorant);
-                    // We also need the 1-halo from neighbouring bricks. Fetch them in an order that maximises nanovdb's internal cache reuse.
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, j, kBrickSize)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, -1, j)), minorant, majorant);
-                    for (int j = 0; j < kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(i, kBrickSize, j)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) for (int i = 0; i < kBrickSize; ++i) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, i)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, -1)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(-1, j, kBrickSize)), minorant, majorant);
-                    for (int j = -1; j <= kBrickSize; ++j) expandMinorantMajorant(a.getValue(ijk + nanovdb::Coord(kBrickSize, j, kBrickSize)), minorant, majorant);
-
-                    if (minorant != majorant) myleaf = mNonEmptyCount.fetch_add(1);
+                    uint32_t leafIndex = uint32_t(leaf - mpLeaves);
+                    slot = mLeafSlot[leafIndex];
+                    majorant = mLeafMajMin[leafIndex].x;
+                    minorant = mLeafMajMin[leafIndex].y;
                 }
-                if (majorant == minorant || myleaf >= brickMax || leaf == nullptr)
+                else
+                {
+                    // Bricks without a leaf are covered by a tile.
+                    majorant = minorant = a.getValue(ijk);
+                }
+
+                if (slot == kInvalidSlot)
                 {
                     *rangedst++ = f32tof16(majorant) + (f32tof16(majorant) << 16); // force identical major and minor
                     *ptrdst++ = 0;
                 }
                 else
                 {
-                    const float* data = leaf->data()->mValues;
-                    majorant = f16tof32(f32tof16(majorant) + 1);
-                    minorant = f16tof32(f32tof16(minorant));
+                    uint3 atlasBrick = getAtlasBrick(slot);
                     *rangedst++ = f32tof16(majorant) + (f32tof16(minorant) << 16);
-                    uint32_t atlasx = myleaf % mAtlasSizeBricks.x;
-                    uint32_t atlasy = (myleaf / mAtlasSizeBricks.x) % mAtlasSizeBricks.y;
-                    uint32_t atlasz = myleaf / bricksPerSlice;
-                    *ptrdst++ = (atlasx + (atlasy << 8) + (atlasz << 16));
-
-                    if (!kBC4Compress) {
-                        float invRange = ((1 << kBitsPerTexel) - 1.f) / (majorant - minorant);
-                        TexelType* atlasdst = (TexelType*)mAtlasData.data() + atlasx * kBrickSize + atlasy * (atlasSizePixels.x * kBrickSize) + atlasz * (pixelsPerSlice * kBrickSize);
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
-                        {
-                            for (int pixy = 0; pixy < kBrickSize; ++pixy)
-                            {
-                                for (int pixx = 0; pixx < kBrickSize; ++pixx)
-                                {
-                                    float f = data[pixx * kBrickSize * kBrickSize + pixy * kBrickSize + pixz];
-                                    *atlasdst++ = TexelType((f - minorant) * invRange);
-                                }
-                                atlasdst += (atlasSizePixels.x - kBrickSize); // next scanline
-                            }
-                            atlasdst += (pixelsPerSlice - (atlasSizePixels.x * kBrickSize)); // next slice
-                        }
-                    }
-                    else {
-                        // BC4 compression:
-                        float invRange = (255.f) / (majorant - minorant);
-                        uint64_t* atlasdst = ((uint64_t*)mAtlasData.data() + atlasx * (kBrickSize / 4) + atlasy * ((atlasSizePixels.x / 4) * kBrickSize / 4) + atlasz * (pixelsPerSlice / 16 * kBrickSize));
-                        for (int pixz = 0; pixz < kBrickSize; ++pixz)
-                        {
-                            for (int tiley = 0; tiley < kBrickSize; tiley += 4)
-                            {
-                                for (int tilex = 0; tilex < kBrickSize; tilex += 4) {
-                                    uint8_t tilevals[4][4];
-                                    uint8_t tileminorant = 255, tilemajorant = 0;
-                                    for (int pixy = 0; pixy < 4; ++pixy)
-                                    {
-                                        for (int pixx = 0; pixx < 4; ++pixx)
-                                        {
-                                            float f = data[(pixx + tilex) * (kBrickSize * kBrickSize) + (pixy + tiley) * kBrickSize + pixz];
-                                            uint8_t voxel = uint8_t((f - minorant) * invRange);
-                                            tileminorant = std::min(tileminorant, voxel);
-                                            tilemajorant = std::max(tilemajorant, voxel);
-                                            tilevals[pixy][pixx] = voxel;
-                                        }
-                                    }
-                                    CompressAlphaDxt5((uint8_t*)&tilevals[0][0], atlasdst);
-                                    atlasdst++;
-                                }
-                                atlasdst += (atlasSizePixels.x / 4 - kBrickSize / 4); // next scanline
-                            }
-                            atlasdst += (pixelsPerSlice / 16 - (atlasSizePixels.x / 4 * kBrickSize / 4)); // next slice
-                        } // z slice loop
-                    } // bc4 compress?
-                } // non empty brick?
+                    *ptrdst++ = (atlasBrick.x + (atlasBrick.y << 8) + (atlasBrick.z << 16));
+                }
             } // x brick loop
         } // y brick loop
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMip(int mip)
+    void NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::computeMipSlice(int mip, int z)
     {
-        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1];
-        uint32_t* rangesrc = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0);
         int3 leafdim_src = mLeafDim[mip - 1];
         uint32_t rowstride_src = leafdim_src.x;
         uint32_t slicestride_src = leafdim_src.y * rowstride_src;
-
         int3 leafdim_tgt = mLeafDim[mip];
-        uint32_t rowstride_tgt = leafdim_tgt.x;
-        uint32_t slicestride_tgt = leafdim_tgt.y * rowstride_tgt;
 
-        for (int z = 0; z < leafdim_tgt.z; ++z, rangesrc += slicestride_src)
+        const uint32_t* rangebase = mRangeData.data() + ((mip > 1) ? mLeafCount[mip - 2] : 0) + 2 * z * slicestride_src;
+        uint32_t* rangedst = mRangeData.data() + mLeafCount[mip - 1] + z * leafdim_tgt.x * leafdim_tgt.y;
+
+        for (int y = 0; y < leafdim_tgt.y; ++y)
         {
-            for (int y = 0; y < leafdim_tgt.y; ++y, rangesrc += rowstride_src)
+            const uint32_t* rangesrc = rangebase + 2 * y * rowstride_src;
+            for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
             {
-                for (int x = 0; x < leafdim_tgt.x; ++x, rangesrc += 2)
-                {
-                    float2 majmin_dst = combineMajMin(
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
-                        ),
-                        combineMajMin(
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
-                            combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
-                        )
-                    );
-                    *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
-                } // x
-            } // y
-        } // z
+                float2 majmin_dst = combineMajMin(
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc), unpackMajMin(rangesrc + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + rowstride_src), unpackMajMin(rangesrc + 1 + rowstride_src))
+                    ),
+                    combineMajMin(
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src), unpackMajMin(rangesrc + slicestride_src + 1)),
+                        combineMajMin(unpackMajMin(rangesrc + slicestride_src + rowstride_src), unpackMajMin(rangesrc + slicestride_src + 1 + rowstride_src))
+                    )
+                );
+                *rangedst++ = f32tof16(majmin_dst.x) + (f32tof16(majmin_dst.y) << 16);
+            } // x
+        } // y
     }
 
     template <typename TexelType, unsigned int kBitsPerTexel>
-    BrickedGrid NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convert(ref<Device> pDevice)
+    BrickedGridData NanoVDBToBricksConverter<TexelType, kBitsPerTexel>::convert()
     {
         auto t0 = CpuTimer::getCurrentTimePoint();
+
+        // Compute the value range of all leaves.
+        forEachLeafBatch([&](uint32_t leafIndex, nanovdb::FloatGrid::AccessorType& a) { analyzeLeaf(leafIndex, a); });
+
+        // Assign atlas slots to non-constant leaves in leaf order.
+        mNonEmptyCount = 0;
+        for (auto& slot : mLeafSlot)
+        {
+            if (slot != kInvalidSlot) slot = mNonEmptyCount++;
+        }
+
+        // Size the atlas for the non-constant leaves. Choose the first 2 dimensions to be powers of 2.
+        uint brickCount = std::max(mNonEmptyCount, 1u);
+        uint approxdim = 1u << uint(log2f((float)brickCount + 1.f) / 3.f);
+        uint lastdim = (brickCount + approxdim * approxdim - 1) / (approxdim * approxdim);
+        mAtlasSizeBricks = uint3(approxdim, approxdim, lastdim);
+        uint3 atlasSizePixels = getAtlasSizePixels();
+        uint leafTexelCount = atlasSizePixels.x * atlasSizePixels.y * atlasSizePixels.z;
+        mAtlasData.resize(kBC4Compress ? (leafTexelCount / 16) : leafTexelCount);
+
+        // Encode the atlas bricks.
+        forEachLeafBatch([&](uint32_t leafIndex, nanovdb::FloatGrid::AccessorType&) { encodeLeaf(leafIndex); });
+
+        // Build the dense range and indirection textures, followed by the range mips.
         auto range = NumericRange<int>(0, mLeafDim[0].z);
         std::for_each(std::execution::par, range.begin(), range.end(), [&](int z) { convertSlice(z); });
-        for (int mip = 1; mip < 4; ++mip) computeMip(mip);
+        for (int mip = 1; mip < 4; ++mip)
+        {
+            auto mipRange = NumericRange<int>(0, mLeafDim[mip].z);
+            std::for_each(std::execution::par_unseq, mipRange.begin(), mipRange.end(), [&](int z) { computeMipSlice(mip, z); });
+        }
 
-        BrickedGrid bricks;
-        bricks.range = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RG16Float, 4, mRangeData.data(), ResourceBindFlags::ShaderResource);
-        bricks.indirection = pDevice->createTexture3D(mLeafDim[0].x, mLeafDim[0].y, mLeafDim[0].z, ResourceFormat::RGBA8Uint, 1, mPtrData.data(), ResourceBindFlags::ShaderResource);
-        bricks.atlas = pDevice->createTexture3D(getAtlasSizePixels().x, getAtlasSizePixels().y, getAtlasSizePixels().z, getAtlasFormat(), 1, mAtlasData.data(), ResourceBindFlags::ShaderResource);
+        BrickedGridData data;
+        data.rangeSize = uint3(mLeafDim[0]);
+        data.atlasSize = getAtlasSizePixels();
+        data.atlasFormat = getAtlasFormat();
+        data.rangeData = std::move(mRangeData);
+        data.ptrData = std::move(mPtrData);
+        data.atlasData.resize(mAtlasData.size() * sizeof(TexelType));
+        std::memcpy(data.atlasData.data(), mAtlasData.data(), data.atlasData.size());
+        mAtlasData = {};
 
         double dt = CpuTimer::calcDuration(t0, CpuTimer::getCurrentTimePoint());
-        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} vs max {}", mpFloatGrid->gridName(), dt, mNonEmptyCount.load(), getAtlasMaxBrick());
-        return bricks;
+        logDebug("Converted '{}' in {:.4}ms: mNonEmptyCount {} of {} leaves", mpFloatGrid->gridName(), dt, mNonEmptyCount, mLeafNodeCount);
+        return data;
     }
 }
@@ -0,0 +1,219 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "GridSequenceStreamer.h"
+#include "Core/Error.h"
+#include "Utils/Logger.h"
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        // Grids are converted with parallel loops, a few workers are enough to overlap file I/O and conversion.
+        const uint32_t kMaxWorkerCount = 4;
+
+        const uint32_t kInvalidFrame = uint32_t(-1);
+    }
+
+    GridSequenceStreamer::GridSequenceStreamer(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, bool useCache)
+        : mpDevice(pDevice)
+        , mPaths(paths)
+        , mGridname(gridname)
+        , mFrameCount((uint32_t)paths.size())
+        , mWindowSize(std::max(windowSize, 1u))
+        , mUseCache(useCache)
+    {
+        mLoadFunc = [this](uint32_t frame, Grid::HostData& hostData) { return Grid::loadHostData(mPaths[frame], mGridname, hostData, mUseCache); };
+        startWorkers();
+    }
+
+    GridSequenceStreamer::GridSequenceStreamer(ref<Device> pDevice, uint32_t frameCount, LoadFunc loadFunc, uint32_t windowSize)
+        : mpDevice(pDevice)
+        , mFrameCount(frameCount)
+        , mLoadFunc(std::move(loadFunc))
+        , mWindowSize(std::max(windowSize, 1u))
+    {
+        FALCOR_CHECK(mLoadFunc, "Missing load function.");
+        startWorkers();
+    }
+
+    GridSequenceStreamer::~GridSequenceStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+        mWorkCondition.notify_all();
+        for (auto& thread : mThreads) thread.join();
+    }
+
+    bool GridSequenceStreamer::setFrame(uint32_t frame)
+    {
+        FALCOR_CHECK(frame < getFrameCount(), "Grid frame {} is out of range (frame count {}).", frame, getFrameCount());
+        if (mHasFrame && frame == mFrame) return false;
+
+        Grid::HostData hostData;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWindowStart = frame;
+            updateWindow();
+            mWorkCondition.notify_all();
+
+            // Wait for the frame to be decoded. Map references stay valid while other entries are inserted or erased.
+            Frame& entry = mFrames.at(frame);
+            mDoneCondition.wait(lock, [&entry] { return entry.state != FrameState::Pending && entry.state != FrameState::Loading; });
+
+            mFrame = frame;
+            mHasFrame = true;
+            if (entry.state != FrameState::Ready) return false;
+
+            hostData = std::move(entry.hostData);
+            entry.hostData = {};
+            entry.state = FrameState::Uploaded;
+        }
+
+        if (mpGrid) mpGrid->setHostData(std::move(hostData));
+        else mpGrid = Grid::createFromHostData(mpDevice, std::move(hostData));
+        return true;
+    }
+
+    void GridSequenceStreamer::setGrid(const ref<Grid>& pGrid, uint32_t frame)
+    {
+        FALCOR_CHECK(frame < getFrameCount(), "Grid frame {} is out of range (frame count {}).", frame, getFrameCount());
+
+        mpGrid = pGrid;
+        mFrame = frame;
+        mHasFrame = pGrid != nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mWindowStart = frame;
+            updateWindow();
+            auto& entry = mFrames.at(frame);
+            if (mHasFrame && entry.state == FrameState::Pending) entry.state = FrameState::Uploaded;
+        }
+        mWorkCondition.notify_all();
+    }
+
+    uint32_t GridSequenceStreamer::getResidentFrameCount() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return (uint32_t)std::count_if(mFrames.begin(), mFrames.end(), [](const auto& it) { return it.second.state == FrameState::Ready; });
+    }
+
+    void GridSequenceStreamer::startWorkers()
+    {
+        FALCOR_CHECK(mFrameCount > 0, "Grid sequence must not be empty.");
+
+        uint32_t threadCount = std::min({mWindowSize, mFrameCount, kMaxWorkerCount});
+        for (uint32_t i = 0; i < threadCount; ++i)
+            mThreads.emplace_back(&GridSequenceStreamer::runWorker, this);
+    }
+
+    bool GridSequenceStreamer::isInWindow(uint32_t frame) const
+    {
+        uint32_t frameCount = getFrameCount();
+        uint32_t distance = (frame + frameCount - mWindowStart) % frameCount;
+        return distance < std::min(mWindowSize, frameCount);
+    }
+
+    void GridSequenceStreamer::updateWindow()
+    {
+        // Evict frames that left the window. Frames that are still loading are evicted by the worker.
+        // The uploaded frame is no longer current and needs to be loaded again if it is still in the window.
+        for (auto it = mFrames.begin(); it != mFrames.end();)
+        {
+            auto& entry = it->second;
+            if (entry.state == FrameState::Uploaded) entry.state = FrameState::Pending;
+            if (!isInWindow(it->first) && entry.state != FrameState::Loading) it = mFrames.erase(it);
+            else ++it;
+        }
+
+        uint32_t frameCount = getFrameCount();
+        for (uint32_t i = 0; i < std::min(mWindowSize, frameCount); ++i)
+        {
+            mFrames.try_emplace((mWindowStart + i) % frameCount);
+        }
+    }
+
+    void GridSequenceStreamer::runWorker()
+    {
+        while (true)
+        {
+            uint32_t frame = kInvalidFrame;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+
+                // Pick the next pending frame, closest to the current frame first.
+                auto findPendingFrame = [this]()
+                {
+                    uint32_t frameCount = getFrameCount();
+                    for (uint32_t i = 0; i < std::min(mWindowSize, frameCount); ++i)
+                    {
+                        uint32_t f = (mWindowStart + i) % frameCount;
+                        auto it = mFrames.find(f);
+                        if (it != mFrames.end() && it->second.state == FrameState::Pending) return f;
+                    }
+                    return kInvalidFrame;
+                };
+                mWorkCondition.wait(lock, [&]() { return mTerminate || (frame = findPendingFrame()) != kInvalidFrame; });
+                if (mTerminate) return;
+
+                mFrames.at(frame).state = FrameState::Loading;
+            }
+
+            Grid::HostData hostData;
+            bool success = false;
+            try
+            {
+                success = mLoadFunc(frame, hostData);
+            }
+            catch (const std::exception& e)
+            {
+                logWarning("Failed to load grid frame {}: {}", frame, e.what());
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                auto it = mFrames.find(frame);
+                FALCOR_ASSERT(it != mFrames.end() && it->second.state == FrameState::Loading);
+                if (!isInWindow(frame))
+                {
+                    // Frame left the window while loading.
+                    mFrames.erase(it);
+                }
+                else
+                {
+                    it->second.state = success ? FrameState::Ready : FrameState::Failed;
+                    it->second.hostData = std::move(hostData);
+                }
+            }
+            mDoneCondition.notify_all();
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Grid.h"
+#include "Core/Macros.h"
+#include "Core/Object.h"
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+    /** Streams a sequence of grids from files.
+        Instead of keeping all frames resident, a window of frames starting at the current frame is kept decoded
+        in host memory and the frames ahead of the current frame are loaded asynchronously on worker threads.
+        Only the current frame is resident on the GPU. The grid returned by getGrid() is a single grid object
+        whose content is replaced when the current frame changes.
+        The window wraps around at the end of the sequence to match looping playback.
+    */
+    class FALCOR_API GridSequenceStreamer : public Object
+    {
+        FALCOR_OBJECT(GridSequenceStreamer)
+    public:
+        /** Function loading the host-side data of a frame. Called on worker threads.
+            Returns true if the frame was loaded successfully.
+        */
+        using LoadFunc = std::function<bool(uint32_t frame, Grid::HostData& hostData)>;
+
+        /** Create a streamer.
+            \param[in] pDevice GPU device.
+            \param[in] paths File paths of the grids (absolute or relative to working directory).
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to keep decoded in host memory, including the current frame.
+            \param[in] useCache Use the on-disk grid cache.
+            \return A new streamer.
+        */
+        static ref<GridSequenceStreamer> create(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, bool useCache = false)
+        {
+            return make_ref<GridSequenceStreamer>(pDevice, paths, gridname, windowSize, useCache);
+        }
+
+        /** Create a streamer loading frames with a custom function.
+            Such a streamer has no paths and can't be stored in the scene cache.
+            \param[in] pDevice GPU device.
+            \param[in] frameCount Number of frames in the sequence.
+            \param[in] loadFunc Function loading a frame.
+            \param[in] windowSize Number of frames to keep decoded in host memory, including the current frame.
+            \return A new streamer.
+        */
+        static ref<GridSequenceStreamer> create(ref<Device> pDevice, uint32_t frameCount, LoadFunc loadFunc, uint32_t windowSize)
+        {
+            return make_ref<GridSequenceStreamer>(pDevice, frameCount, std::move(loadFunc), windowSize);
+        }
+
+        GridSequenceStreamer(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, bool useCache);
+        GridSequenceStreamer(ref<Device> pDevice, uint32_t frameCount, LoadFunc loadFunc, uint32_t windowSize);
+
+        /** Destructor.
+            Blocks until all worker threads have terminated.
+        */
+        ~GridSequenceStreamer();
+
+        /** Set the current frame.
+            Blocks until the frame is decoded if it is not resident yet and replaces the grid content.
+            Frames outside of the new window are evicted and the frames ahead are scheduled for loading.
+            \param[in] frame Frame index.
+            \return True if the grid content changed.
+        */
+        bool setFrame(uint32_t frame);
+
+        /** Get the current frame.
+        */
+        uint32_t getFrame() const { return mFrame; }
+
+        /** Get the grid holding the current frame. This is nullptr until a frame was successfully loaded.
+        */
+        const ref<Grid>& getGrid() const { return mpGrid; }
+
+        /** Set the grid holding the given frame.
+            This is used to continue streaming into a grid restored from the scene cache.
+        */
+        void setGrid(const ref<Grid>& pGrid, uint32_t frame);
+
+        /** Get the number of frames in the sequence.
+        */
+        uint32_t getFrameCount() const { return mFrameCount; }
+
+        /** Get the number of frames currently decoded in host memory.
+        */
+        uint32_t getResidentFrameCount() const;
+
+        const std::vector<std::filesystem::path>& getPaths() const { return mPaths; }
+        const std::string& getGridname() const { return mGridname; }
+        uint32_t getWindowSize() const { return mWindowSize; }
+        bool getUseCache() const { return mUseCache; }
+
+    private:
+        enum class FrameState
+        {
+            Pending,    ///< Waiting to be loaded.
+            Loading,    ///< Currently loaded by a worker.
+            Ready,      ///< Decoded in host memory.
+            Uploaded,   ///< Moved to the grid.
+            Failed,     ///< Failed to load.
+        };
+
+        struct Frame
+        {
+            FrameState state = FrameState::Pending;
+            Grid::HostData hostData;
+        };
+
+        void startWorkers();
+        bool isInWindow(uint32_t frame) const;
+        void updateWindow();
+        void runWorker();
+
+        ref<Device> mpDevice;
+        std::vector<std::filesystem::path> mPaths;
+        std::string mGridname;
+        uint32_t mFrameCount;
+        LoadFunc mLoadFunc;
+        uint32_t mWindowSize;
+        bool mUseCache = false;
+
+        ref<Grid> mpGrid;
+        uint32_t mFrame = 0;
+        bool mHasFrame = false;
+
+        mutable std::mutex mMutex;              ///< Mutex for synchronizing access to the frames.
+        std::condition_variable mWorkCondition; ///< Condition variable for workers to wait on.
+        std::condition_variable mDoneCondition; ///< Condition variable to wait on loaded frames.
+        std::vector<std::thread> mThreads;      ///< Worker threads.
+
+        // Internal state. Do not access outside of critical section.
+        std::map<uint32_t, Frame> mFrames;      ///< Frames in the window (and frames still loading that left the window).
+        uint32_t mWindowStart = 0;              ///< First frame of the window.
+        bool mTerminate = false;                ///< Flag to terminate worker threads.
+    };
+}
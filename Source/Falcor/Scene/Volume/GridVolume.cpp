@@ -29,8 +29,14 @@
 #include "Grid.h"
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Threading.h"
 #include "Utils/Scripting/ScriptBindings.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "GlobalState.h"
+#include <exception>
+#include <execution>
+#include <mutex>
 #include <set>
 #include <filesystem>
 
@@ -49,6 +55,43 @@ namespace Falcor
         const float kMaxAnisotropy = 0.99f;
         const double kMinFrameRate = 1.0;
         const double kMaxFrameRate = 1000.0;
+
+        /** Enumerate the grid files in a directory, sorted by frame.
+        */
+        bool enumerateGridFiles(const std::filesystem::path& path, std::vector<std::filesystem::path>& paths)
+        {
+            if (!std::filesystem::exists(path))
+            {
+                logWarning("'{}' does not exist.", path);
+                return false;
+            }
+            if (!std::filesystem::is_directory(path))
+            {
+                logWarning("'{}' is not a directory.", path);
+                return false;
+            }
+
+            // Enumerate grid files.
+            paths.clear();
+            for (auto it : std::filesystem::directory_iterator(path))
+            {
+                if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
+            }
+
+            // Sort by length first, then alpha-numerically.
+            auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
+                auto sa = a.string();
+                auto sb = b.string();
+                return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
+            };
+            std::sort(paths.begin(), paths.end(), cmp);
+            return true;
+        }
+
+        bool useGridCache(const SceneBuilder& sceneBuilder)
+        {
+            return is_set(sceneBuilder.getFlags(), SceneBuilder::Flags::UseCache);
+        }
     }
 
     static_assert(sizeof(GridVolumeData) % 16 == 0, "GridVolumeData size should be a multiple of 16");
@@ -118,61 +161,110 @@ namespace Falcor
         return changed;
     }
 
-    bool GridVolume::loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname)
+    bool GridVolume::loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool useCache)
     {
-        auto grid = Grid::createFromFile(mpDevice, path, gridname);
+        auto grid = Grid::createFromFile(mpDevice, path, gridname, useCache);
         if (grid) setGrid(slot, grid);
         return grid != nullptr;
     }
 
-    GridVolume::GridSequence GridVolume::createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty)
+    GridVolume::GridSequence GridVolume::createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty, bool useCache)
     {
+        ScopedLoadPhase phase("Loading grid sequence");
+
+        // Load and convert the grids in parallel and create the GPU resources on the calling thread.
+        // Grids are processed in batches to bound the host memory held before uploading.
+        const size_t batchSize = std::max<size_t>(Threading::getLogicalThreadCount(), 1);
+        std::vector<Grid::HostData> hostData(std::min(batchSize, paths.size()));
+        std::vector<uint8_t> loaded(hostData.size());
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+
         GridSequence grids;
-        for (const auto& path : paths)
+        for (size_t batchStart = 0; batchStart < paths.size(); batchStart += batchSize)
         {
-            auto grid = Grid::createFromFile(pDevice, path, gridname);
-            if (keepEmpty || grid) grids.push_back(grid);
+            const size_t batchCount = std::min(batchSize, paths.size() - batchStart);
+
+            // Use the parallel (non-vectorized) policy as loading does file I/O and may log warnings.
+            auto range = NumericRange<size_t>(0, batchCount);
+            std::for_each(std::execution::par, range.begin(), range.end(), [&](size_t i)
+            {
+                loaded[i] = 0;
+                try
+                {
+                    loaded[i] = Grid::loadHostData(paths[batchStart + i], gridname, hostData[i], useCache);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!exception) exception = std::current_exception();
+                }
+            });
+            if (exception) std::rethrow_exception(exception);
+
+            for (size_t i = 0; i < batchCount; ++i)
+            {
+                auto grid = loaded[i] ? Grid::createFromHostData(pDevice, std::move(hostData[i])) : nullptr;
+                hostData[i] = {};
+                if (keepEmpty || grid) grids.push_back(grid);
+            }
         }
 
+        phase.addCount("grids", grids.size());
         return grids;
     }
 
-    uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty)
+    uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty, bool useCache)
     {
-        GridVolume::GridSequence grids = GridVolume::createGridSequence(mpDevice, paths, gridname, keepEmpty);
+        GridVolume::GridSequence grids = GridVolume::createGridSequence(mpDevice, paths, gridname, keepEmpty, useCache);
         setGridSequence(slot, grids);
         return (uint32_t)grids.size();
     }
 
-    uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty)
+    uint32_t GridVolume::loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty, bool useCache)
     {
-        if (!std::filesystem::exists(path))
-        {
-            logWarning("'{}' does not exist.", path);
-            return 0;
-        }
-        if (!std::filesystem::is_directory(path))
+        std::vector<std::filesystem::path> paths;
+        if (!enumerateGridFiles(path, paths)) return 0;
+        return loadGridSequence(slot, paths, gridname, keepEmpty, useCache);
+    }
+
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize, bool useCache)
+    {
+        if (paths.empty())
         {
-            logWarning("'{}' is not a directory.", path);
+            setGridSequence(slot, {});
             return 0;
         }
 
-        // Enumerate grid files.
-        std::vector<std::filesystem::path> paths;
-        for (auto it : std::filesystem::directory_iterator(path))
-        {
-            if (hasExtension(it.path(), "nvdb") || hasExtension(it.path(), "vdb")) paths.push_back(it.path());
-        }
+        auto pStreamer = GridSequenceStreamer::create(mpDevice, paths, gridname, windowSize, useCache);
+        setGridStreamer(slot, pStreamer);
+        return pStreamer->getFrameCount();
+    }
 
-        // Sort by length first, then alpha-numerically.
-        auto cmp = [](const std::filesystem::path& a, const std::filesystem::path& b) {
-            auto sa = a.string();
-            auto sb = b.string();
-            return sa.length() != sb.length() ? sa.length() < sb.length() : sa < sb;
-        };
-        std::sort(paths.begin(), paths.end(), cmp);
+    uint32_t GridVolume::streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize, bool useCache)
+    {
+        std::vector<std::filesystem::path> paths;
+        if (!enumerateGridFiles(path, paths)) return 0;
+        return streamGridSequence(slot, paths, gridname, windowSize, useCache);
+    }
 
-        return loadGridSequence(slot, paths, gridname, keepEmpty);
+    void GridVolume::setGridStreamer(GridSlot slot, const ref<GridSequenceStreamer>& pStreamer)
+    {
+        uint32_t slotIndex = (uint32_t)slot;
+        FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
+        FALCOR_CHECK(pStreamer != nullptr, "'pStreamer' is missing");
+
+        // Load the current frame synchronously to have a grid to put in the slot.
+        pStreamer->setFrame(std::min(mGridFrame, pStreamer->getFrameCount() - 1));
+
+        // Register the streamer before updating the sequence so that the frame count includes the streamed frames.
+        // Going through setGridSequence() would clamp the current frame to the single streamed grid.
+        const auto& pGrid = pStreamer->getGrid();
+        mGrids[slotIndex] = pGrid ? GridSequence{pGrid} : GridSequence{};
+        mStreamers[slotIndex] = pStreamer;
+        updateSequence();
+        updateBounds();
+        markUpdates(UpdateFlags::GridsChanged);
     }
 
     void GridVolume::setGridSequence(GridSlot slot, const GridSequence& grids)
@@ -180,7 +272,10 @@ namespace Falcor
         uint32_t slotIndex = (uint32_t)slot;
         FALCOR_ASSERT(slotIndex >= 0 && slotIndex < (uint32_t)GridSlot::Count);
 
-        if (mGrids[slotIndex] != grids)
+        bool wasStreaming = mStreamers[slotIndex] != nullptr;
+        mStreamers[slotIndex] = nullptr;
+
+        if (wasStreaming || mGrids[slotIndex] != grids)
         {
             mGrids[slotIndex] = grids;
             updateSequence();
@@ -229,6 +324,10 @@ namespace Falcor
         if (mGridFrame != gridFrame)
         {
             mGridFrame = gridFrame;
+            for (const auto& pStreamer : mStreamers)
+            {
+                if (pStreamer) pStreamer->setFrame(std::min(gridFrame, pStreamer->getFrameCount() - 1));
+            }
             markUpdates(UpdateFlags::GridsChanged);
             updateBounds();
         }
@@ -328,7 +427,11 @@ namespace Falcor
     void GridVolume::updateSequence()
     {
         mGridFrameCount = 1;
-        for (const auto& grids : mGrids) mGridFrameCount = std::max(mGridFrameCount, (uint32_t)grids.size());
+        for (size_t slotIndex = 0; slotIndex < mGrids.size(); ++slotIndex)
+        {
+            uint32_t frameCount = mStreamers[slotIndex] ? mStreamers[slotIndex]->getFrameCount() : (uint32_t)mGrids[slotIndex].size();
+            mGridFrameCount = std::max(mGridFrameCount, frameCount);
+        }
         setGridFrame(std::min(mGridFrame, mGridFrameCount - 1));
     }
 
@@ -403,7 +506,7 @@ namespace Falcor
         volume.def(pybind11::init(create), "name"_a); // PYTHONDEPRECATED
         volume.def("loadGrid",
             [](GridVolume& self, GridVolume::GridSlot slot, const std::filesystem::path& path, const std::string& gridname)
-            { return self.loadGrid(slot, getActiveAssetResolver().resolvePath(path), gridname); },
+            { return self.loadGrid(slot, getActiveAssetResolver().resolvePath(path), gridname, useGridCache(accessActivePythonSceneBuilder())); },
             "slot"_a, "path"_a, "gridname"_a
         ); // PYTHONDEPRECATED
         volume.def("loadGridSequence",
@@ -412,15 +515,31 @@ namespace Falcor
                 std::vector<std::filesystem::path> resolvedPaths;
                 for (const auto& path : paths)
                     resolvedPaths.push_back(getActiveAssetResolver().resolvePath(path));
-                return self.loadGridSequence(slot, resolvedPaths, gridname, keepEmpty);
+                return self.loadGridSequence(slot, resolvedPaths, gridname, keepEmpty, useGridCache(accessActivePythonSceneBuilder()));
             },
             "slot"_a, "paths"_a, "gridname"_a, "keepEmpty"_a = true
         ); // PYTHONDEPRECATED
         volume.def("loadGridSequence",
             [](GridVolume& self, GridVolume::GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty)
-            { return self.loadGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, keepEmpty); },
+            { return self.loadGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, keepEmpty, useGridCache(accessActivePythonSceneBuilder())); },
             "slot"_a, "path"_a, "gridnames"_a, "keepEmpty"_a = true
         ); // PYTHONDEPRECATED
+        volume.def("streamGridSequence",
+            [](GridVolume& self, GridVolume::GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize)
+            {
+                std::vector<std::filesystem::path> resolvedPaths;
+                for (const auto& path : paths)
+                    resolvedPaths.push_back(getActiveAssetResolver().resolvePath(path));
+                return self.streamGridSequence(slot, resolvedPaths, gridname, windowSize, useGridCache(accessActivePythonSceneBuilder()));
+            },
+            "slot"_a, "paths"_a, "gridname"_a, "windowSize"_a = 8
+        );
+        volume.def("streamGridSequence",
+            [](GridVolume& self, GridVolume::GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize)
+            { return self.streamGridSequence(slot, getActiveAssetResolver().resolvePath(path), gridname, windowSize, useGridCache(accessActivePythonSceneBuilder())); },
+            "slot"_a, "path"_a, "gridname"_a, "windowSize"_a = 8
+        );
+        volume.def("isStreaming", &GridVolume::isStreaming, "slot"_a);
 
         m.attr("Volume") = m.attr("GridVolume"); // PYTHONDEPRECATED
     }
@@ -27,6 +27,7 @@
  **************************************************************************/
 #pragma once
 #include "Grid.h"
+#include "GridSequenceStreamer.h"
 #include "GridVolumeData.slang"
 #include "Core/Macros.h"
 #include "Utils/Math/AABB.h"
@@ -113,18 +114,21 @@ namespace Falcor
             \param[in] slot Grid slot.
             \param[in] path File path of the grid. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
+            \param[in] useCache Use the on-disk grid cache.
             \return Returns true if grid was loaded successfully.
         */
-        bool loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname);
+        bool loadGrid(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool useCache = false);
 
         /** Create a GridSequence from a list of files.
+            The files are loaded and converted in parallel, in batches to bound the host memory used for loading.
             \param[in] pDevice GPU device
             \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
             \param[in] keepEmpty Add empty (nullptr) grids to the sequence if one cannot be loaded from the file.
+            \param[in] useCache Use the on-disk grid cache.
             \return Returns the resulting GridSequence
         */
-        static GridSequence createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty = true);
+        static GridSequence createGridSequence(ref<Device> pDevice, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty = true, bool useCache = false);
 
         /** Load a sequence of grids from files to a grid slot.
             Note: This will replace any existing grid sequence for that slot.
@@ -132,9 +136,10 @@ namespace Falcor
             \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
             \param[in] keepEmpty Add empty (nullptr) grids to the sequence if one cannot be loaded from the file.
+            \param[in] useCache Use the on-disk grid cache.
             \return Returns the length of the loaded sequence.
         */
-        uint32_t loadGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty = true);
+        uint32_t loadGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, bool keepEmpty = true, bool useCache = false);
 
         /** Load a sequence of grids from a directory to a grid slot.
             Note: This will replace any existing grid sequence for that slot.
@@ -142,9 +147,50 @@ namespace Falcor
             \param[in] path Directory containing grid files. Can also include a full path or relative path from a data directory.
             \param[in] gridname Name of the grid to load.
             \param[in] keepEmpty Add empty (nullptr) grids to the sequence if one cannot be loaded from the file.
+            \param[in] useCache Use the on-disk grid cache.
             \return Returns the length of the loaded sequence.
         */
-        uint32_t loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty = true);
+        uint32_t loadGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, bool keepEmpty = true, bool useCache = false);
+
+        /** Stream a sequence of grids from files to a grid slot.
+            Only a window of frames starting at the current grid frame is kept decoded in host memory and only the
+            current frame is resident on the GPU. Frames ahead of the current frame are loaded asynchronously.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] paths File paths of the grids. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to keep decoded in host memory, including the current frame.
+            \param[in] useCache Use the on-disk grid cache.
+            \return Returns the length of the sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::vector<std::filesystem::path>& paths, const std::string& gridname, uint32_t windowSize = 8, bool useCache = false);
+
+        /** Stream a sequence of grids from a directory to a grid slot.
+            See streamGridSequence() above for details.
+            \param[in] slot Grid slot.
+            \param[in] path Directory containing grid files. Can also include a full path or relative path from a data directory.
+            \param[in] gridname Name of the grid to load.
+            \param[in] windowSize Number of frames to keep decoded in host memory, including the current frame.
+            \param[in] useCache Use the on-disk grid cache.
+            \return Returns the length of the sequence.
+        */
+        uint32_t streamGridSequence(GridSlot slot, const std::filesystem::path& path, const std::string& gridname, uint32_t windowSize = 8, bool useCache = false);
+
+        /** Stream the grid sequence of a slot with the given streamer.
+            The streamer is set to the current grid frame, which blocks until the frame is loaded.
+            Note: This will replace any existing grid sequence for that slot.
+            \param[in] slot Grid slot.
+            \param[in] pStreamer Grid sequence streamer.
+        */
+        void setGridStreamer(GridSlot slot, const ref<GridSequenceStreamer>& pStreamer);
+
+        /** Get the streamer of the specified slot, or nullptr if the slot is not streamed.
+        */
+        const ref<GridSequenceStreamer>& getGridStreamer(GridSlot slot) const { return mStreamers[(size_t)slot]; }
+
+        /** Check if the grid sequence of the specified slot is streamed.
+        */
+        bool isStreaming(GridSlot slot) const { return mStreamers[(size_t)slot] != nullptr; }
 
         /** Set the grid sequence for the specified slot.
         */
@@ -292,6 +338,7 @@ namespace Falcor
         ref<Device> mpDevice;
         std::string mName;
         std::array<GridSequence, (size_t)GridSlot::Count> mGrids;
+        std::array<ref<GridSequenceStreamer>, (size_t)GridSlot::Count> mStreamers; ///< Streamers of streamed slots. The grid sequence of these slots holds the single streamed grid.
         uint32_t mGridFrame = 0;
         uint32_t mGridFrameCount = 1;
         double mFrameRate = 30.f;
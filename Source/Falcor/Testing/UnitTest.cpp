@@ -38,14 +38,19 @@
 #include "Utils/Logger.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/Vector.h"
+#include "Utils/Timing/LoadProfiler.h"
 
 #include <fmt/format.h>
 #include <fmt/color.h>
+#include <nlohmann/json.hpp>
 #include <pugixml.hpp>
 #include <BS_thread_pool_light.hpp>
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <fstream>
+#include <numeric>
 #include <regex>
 #include <cstdint>
 
@@ -84,6 +89,21 @@ static std::vector<TestDesc>& getTestRegistry()
     return registry;
 }
 
+/// Benchmark settings and results of the current test run.
+struct BenchmarkSession
+{
+    BenchmarkOptions options;
+    std::map<std::string, double> baselineMedianTimes; ///< Median time per iteration in seconds by benchmark name.
+    std::map<std::string, Benchmark::Result> results;  ///< Results by benchmark name. Repeated runs overwrite earlier results.
+    std::mutex mutex;
+};
+
+static BenchmarkSession& getBenchmarkSession()
+{
+    static BenchmarkSession session;
+    return session;
+}
+
 class DevicePool
 {
 public:
@@ -162,6 +182,107 @@ void reportLine(const std::string_view format, Args&&... args)
     logInfo(report);
 }
 
+/// Format a duration in seconds with a suitable unit.
+inline std::string formatTime(double seconds)
+{
+    if (seconds >= 1.0)
+        return fmt::format("{:.3f} s", seconds);
+    if (seconds >= 1e-3)
+        return fmt::format("{:.3f} ms", seconds * 1e3);
+    if (seconds >= 1e-6)
+        return fmt::format("{:.3f} us", seconds * 1e6);
+    return fmt::format("{:.1f} ns", seconds * 1e9);
+}
+
+/// Format a rate (per second) with an SI prefix.
+inline std::string formatRate(double rate, std::string_view unit)
+{
+    const char* kPrefixes[] = {"", "K", "M", "G", "T"};
+    size_t prefix = 0;
+    while (rate >= 1000.0 && prefix + 1 < std::size(kPrefixes))
+    {
+        rate /= 1000.0;
+        prefix++;
+    }
+    return fmt::format("{:.2f} {}{}/s", rate, kPrefixes[prefix], unit);
+}
+
+/// Percentile of sorted values with linear interpolation. p is in [0, 1].
+inline double percentile(const std::vector<double>& sortedValues, double p)
+{
+    FALCOR_ASSERT(!sortedValues.empty());
+    double index = p * (sortedValues.size() - 1);
+    size_t i0 = (size_t)std::floor(index);
+    size_t i1 = std::min(i0 + 1, sortedValues.size() - 1);
+    double t = index - i0;
+    return sortedValues[i0] * (1.0 - t) + sortedValues[i1] * t;
+}
+
+inline nlohmann::json benchmarkResultToJson(const Benchmark::Result& result)
+{
+    nlohmann::json json;
+    json["name"] = result.name;
+    json["iterations"] = result.iterations;
+    json["samples"] = result.sampleCount;
+    json["min"] = result.minTime;
+    json["median"] = result.medianTime;
+    json["mean"] = result.meanTime;
+    json["p90"] = result.p90Time;
+    json["max"] = result.maxTime;
+    json["stddev"] = result.stdDevTime;
+    if (result.itemsPerIteration > 0.0)
+        json["itemsPerSecond"] = result.itemsPerIteration / result.medianTime;
+    if (result.bytesPerIteration > 0.0)
+        json["bytesPerSecond"] = result.bytesPerIteration / result.medianTime;
+    if (result.baselineMedianTime > 0.0)
+        json["baselineMedian"] = result.baselineMedianTime;
+    return json;
+}
+
+/// Load the median times of a benchmark report used as baseline.
+inline void loadBenchmarkBaseline(BenchmarkSession& session)
+{
+    session.baselineMedianTimes.clear();
+    const auto& path = session.options.baselinePath;
+    if (path.empty())
+        return;
+
+    std::ifstream ifs(path);
+    if (!ifs.good())
+        FALCOR_THROW("Failed to open benchmark baseline '{}'.", path);
+
+    try
+    {
+        nlohmann::json json = nlohmann::json::parse(ifs);
+        for (const auto& entry : json.at("benchmarks"))
+            session.baselineMedianTimes[entry.at("name").get<std::string>()] = entry.at("median").get<double>();
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        FALCOR_THROW("Failed to parse benchmark baseline '{}': {}", path, e.what());
+    }
+}
+
+/// Write the results of all benchmarks that ran to a JSON report.
+inline void writeBenchmarkReport(BenchmarkSession& session)
+{
+    const auto& path = session.options.reportPath;
+    if (path.empty())
+        return;
+
+    nlohmann::json json;
+    json["version"] = getLongVersionString();
+    json["benchmarks"] = nlohmann::json::array();
+    for (const auto& [name, result] : session.results)
+        json["benchmarks"].push_back(benchmarkResultToJson(result));
+
+    std::ofstream ofs(path);
+    if (!ofs.good())
+        FALCOR_THROW("Failed to open '{}' for writing.", path);
+    ofs << json.dump(4);
+    reportLine("Wrote benchmark report to '{}'.", path);
+}
+
 /**
  * Write a test report in JUnit's XML format.
  * @param[in] path File path.
@@ -322,7 +443,10 @@ inline int32_t runTestsParallel(const RunOptions& options)
 
                 reportLine("[ RUN      ] {}:{}{}", test.suiteName, test.name, repeats);
 
-                result = runTest(test, devicePool);
+                {
+                    FALCOR_LOAD_PHASE(fmt::format("{}:{}", test.suiteName, test.name));
+                    result = runTest(test, devicePool);
+                }
 
                 std::string statusTag;
                 switch (result.status)
@@ -430,7 +554,11 @@ inline int32_t runTestsSerial(const RunOptions& options)
                 if (options.repeat > 1)
                     repeats = fmt::format("[{}/{}]", repeatIndex + 1, options.repeat);
                 reportLine("[ RUN      ] {}:{}{}", suiteName, test.name, repeats);
-                TestResult result = runTest(test, devicePool);
+                TestResult result;
+                {
+                    FALCOR_LOAD_PHASE(fmt::format("{}:{}", suiteName, test.name));
+                    result = runTest(test, devicePool);
+                }
                 report.emplace_back(test, result);
 
                 std::string statusTag;
@@ -507,7 +635,23 @@ int32_t runTests(const RunOptions& options)
     Threading::start();
     Scripting::start();
 
-    int32_t failureCount = options.parallel > 1 ? runTestsParallel(options) : runTestsSerial(options);
+    auto& benchmarkSession = getBenchmarkSession();
+    benchmarkSession.options = options.benchmarkOptions;
+    benchmarkSession.results.clear();
+    loadBenchmarkBaseline(benchmarkSession);
+
+    // Record load phases (scene import etc.) of all tests below a common root phase.
+    // Phases opened on the worker threads of the parallel runner are attached to it.
+    LoadProfiler::instance().reset();
+    int32_t failureCount = 0;
+    {
+        FALCOR_LOAD_PHASE("Running tests");
+        failureCount = options.parallel > 1 ? runTestsParallel(options) : runTestsSerial(options);
+    }
+
+    if (!options.loadReportPath.empty())
+        LoadProfiler::instance().writeJson(options.loadReportPath);
+    writeBenchmarkReport(benchmarkSession);
 
     Scripting::shutdown();
     Threading::shutdown();
@@ -599,6 +743,10 @@ std::vector<Test> filterTests(
             includeTags.insert(token);
     }
 
+    // Benchmarks are slow and only run when explicitly requested, either by the tag filter
+    // or by a test case filter matching them.
+    const bool excludeBenchmarks = includeTags.count("benchmark") == 0 && testCaseFilter.empty();
+
     auto matchTags =
         [](const std::set<std::string>& tags, const std::set<std::string>& includeTags, const std::set<std::string>& excludeTags)
     {
@@ -622,6 +770,8 @@ std::vector<Test> filterTests(
             continue;
         if (!matchTags(test.tags, includeTags, excludeTags))
             continue;
+        if (excludeBenchmarks && test.tags.count("benchmark") > 0)
+            continue;
         if (deviceType != Device::Type::Default && test.deviceType != deviceType)
             continue;
         filtered.push_back(test);
@@ -645,6 +795,116 @@ void UnitTestContext::reportFailure(const std::string& message)
 
 ///////////////////////////////////////////////////////////////////////////
 
+Benchmark::Benchmark(UnitTestContext& ctx, std::string name) : mCtx(ctx), mName(std::move(name)) {}
+
+Benchmark::Result Benchmark::runSamples(const std::string& runName, const SampleFunc& sampleFunc)
+{
+    BenchmarkOptions options;
+    {
+        auto& session = getBenchmarkSession();
+        std::lock_guard<std::mutex> lock(session.mutex);
+        options = session.options;
+    }
+
+    Result result;
+    result.name = runName.empty() ? mName : mName + "/" + runName;
+    result.itemsPerIteration = mItemsPerIteration;
+    result.bytesPerIteration = mBytesPerIteration;
+
+    // Warmup. Run at least once and double the iteration count until the warmup time is reached.
+    // The last batch also gives an estimate of the time per iteration.
+    uint64_t iterations = 1;
+    double warmupTime = 0.0;
+    double iterationTime = 0.0;
+    while (true)
+    {
+        double batchTime = sampleFunc(iterations);
+        warmupTime += batchTime;
+        iterationTime = batchTime / iterations;
+        if (warmupTime >= options.warmupTime)
+            break;
+        iterations *= 2;
+    }
+
+    // Calibrate the iterations per sample to reach the minimum time over all samples.
+    // Slow benchmarks use fewer samples to stay within the maximum time.
+    uint32_t sampleCount = std::max(1u, options.sampleCount);
+    double sampleTime = options.minTime / sampleCount;
+    iterations = std::max<uint64_t>(1, (uint64_t)std::ceil(sampleTime / std::max(iterationTime, 1e-9)));
+    if (iterations == 1 && iterationTime * sampleCount > options.maxTime)
+        sampleCount = std::clamp((uint32_t)(options.maxTime / iterationTime), std::min(3u, sampleCount), sampleCount);
+
+    // Measure.
+    std::vector<double> samples(sampleCount);
+    for (uint32_t i = 0; i < sampleCount; ++i)
+        samples[i] = sampleFunc(iterations) / iterations;
+
+    std::vector<double> sortedSamples = samples;
+    std::sort(sortedSamples.begin(), sortedSamples.end());
+    result.iterations = iterations;
+    result.sampleCount = sampleCount;
+    result.minTime = sortedSamples.front();
+    result.maxTime = sortedSamples.back();
+    result.medianTime = percentile(sortedSamples, 0.5);
+    result.p90Time = percentile(sortedSamples, 0.9);
+    result.meanTime = std::accumulate(samples.begin(), samples.end(), 0.0) / sampleCount;
+    double variance = 0.0;
+    for (double sample : samples)
+        variance += (sample - result.meanTime) * (sample - result.meanTime);
+    result.stdDevTime = sampleCount > 1 ? std::sqrt(variance / (sampleCount - 1)) : 0.0;
+
+    // Report.
+    std::string line = fmt::format(
+        "[ BENCH    ] {}: median {}, min {}, p90 {}, stddev {} ({} x {} iterations)",
+        result.name,
+        formatTime(result.medianTime),
+        formatTime(result.minTime),
+        formatTime(result.p90Time),
+        formatTime(result.stdDevTime),
+        sampleCount,
+        iterations
+    );
+    if (result.itemsPerIteration > 0.0)
+        line += ", " + formatRate(result.itemsPerIteration / result.medianTime, " items");
+    if (result.bytesPerIteration > 0.0)
+        line += ", " + formatRate(result.bytesPerIteration / result.medianTime, "B");
+
+    // Compare against the baseline.
+    std::string regressionMessage;
+    {
+        auto& session = getBenchmarkSession();
+        std::lock_guard<std::mutex> lock(session.mutex);
+        if (auto it = session.baselineMedianTimes.find(result.name); it != session.baselineMedianTimes.end() && it->second > 0.0)
+        {
+            result.baselineMedianTime = it->second;
+            double change = result.medianTime / result.baselineMedianTime - 1.0;
+            line += fmt::format(", {:+.1f}% vs baseline", change * 100.0);
+            if (change > options.regressionThreshold)
+            {
+                regressionMessage = fmt::format(
+                    "Benchmark '{}' regressed: median {} vs baseline {} ({:+.1f}%, threshold {:.1f}%).",
+                    result.name,
+                    formatTime(result.medianTime),
+                    formatTime(result.baselineMedianTime),
+                    change * 100.0,
+                    options.regressionThreshold * 100.0
+                );
+            }
+        }
+        session.results[result.name] = result;
+    }
+
+    reportLine("{}", line);
+    if (!regressionMessage.empty())
+        mCtx.reportFailure(regressionMessage);
+
+    // Return a copy, later runs may reallocate the result list.
+    mResults.push_back(result);
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////
+
 void GPUUnitTestContext::createProgram(
     const std::filesystem::path& path,
     const std::string& entry,
@@ -798,4 +1058,19 @@ CPU_TEST(TestTags, TAGS("tag1", "tag2", "tag3"))
     EXPECT(true);
 }
 
+CPU_BENCHMARK(TestBenchmark)
+{
+    std::vector<uint32_t> values(1000);
+    std::iota(values.begin(), values.end(), 0);
+    bench.setItemsPerIteration((double)values.size());
+    const auto& result = bench.run([&]() { doNotOptimize(std::accumulate(values.begin(), values.end(), 0u)); });
+
+    EXPECT_EQ(result.name, "UnitTest.cpp:TestBenchmark");
+    EXPECT_GE(result.iterations, 1);
+    EXPECT_GE(result.sampleCount, 1);
+    EXPECT_LE(result.minTime, result.medianTime);
+    EXPECT_LE(result.medianTime, result.p90Time);
+    EXPECT_LE(result.p90Time, result.maxTime);
+}
+
 } // namespace Falcor
@@ -37,6 +37,8 @@
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <functional>
 #include <map>
@@ -84,6 +86,17 @@ public:
     SkippingTestException(const std::string& what) : std::runtime_error(what.c_str()) {}
 };
 
+struct BenchmarkOptions
+{
+    double warmupTime = 0.1;             ///< Minimum time in seconds to run a benchmark before measuring.
+    double minTime = 0.5;                ///< Minimum measured time in seconds per benchmark. Used to calibrate the iteration count.
+    double maxTime = 10.0;               ///< Maximum measured time in seconds per benchmark. Reduces the sample count for slow benchmarks.
+    uint32_t sampleCount = 20;           ///< Number of samples (timings of a batch of iterations) per benchmark.
+    std::filesystem::path reportPath;    ///< If set, the benchmark results are written to this file (JSON).
+    std::filesystem::path baselinePath;  ///< If set, the benchmark results are compared against this report (JSON).
+    double regressionThreshold = 0.1;    ///< Relative increase of the median time over the baseline that fails a benchmark.
+};
+
 struct RunOptions
 {
     Device::Desc deviceDesc;
@@ -91,8 +104,10 @@ struct RunOptions
     std::string testCaseFilter;
     std::string tagFilter;
     std::filesystem::path xmlReportPath;
+    std::filesystem::path loadReportPath; ///< If set, a hierarchical load report (JSON) of all tests is written to this file.
     uint32_t parallel = 1;
     uint32_t repeat = 1;
+    BenchmarkOptions benchmarkOptions;
 };
 
 FALCOR_API int32_t runTests(const RunOptions& options);
@@ -279,6 +294,107 @@ private:
     std::map<std::string, ref<Buffer>> mStructuredBuffers;
 };
 
+/**
+ * Measures the run time of a piece of code. Used by the CPU_BENCHMARK/GPU_BENCHMARK macros.
+ *
+ * Each call to run() executes the code for a warmup period, calibrates the number of iterations per
+ * sample so that all samples together take at least BenchmarkOptions::minTime and then records the
+ * time per iteration of each sample. The median, percentiles etc. are reported to the test log and
+ * collected for the JSON report. If a baseline is given, a median slower than the baseline by more
+ * than the regression threshold is reported as a test failure.
+ */
+class FALCOR_API Benchmark
+{
+public:
+    struct Result
+    {
+        std::string name;                   ///< Full name (suite:test[/run]).
+        uint64_t iterations = 0;            ///< Iterations per sample.
+        uint32_t sampleCount = 0;           ///< Number of samples.
+        double minTime = 0.0;               ///< Time per iteration in seconds (fastest sample).
+        double medianTime = 0.0;            ///< Time per iteration in seconds (median sample).
+        double meanTime = 0.0;              ///< Time per iteration in seconds (mean over samples).
+        double p90Time = 0.0;               ///< Time per iteration in seconds (90th percentile sample).
+        double maxTime = 0.0;               ///< Time per iteration in seconds (slowest sample).
+        double stdDevTime = 0.0;            ///< Standard deviation of the time per iteration in seconds.
+        double itemsPerIteration = 0.0;     ///< Items processed per iteration (0 if not set).
+        double bytesPerIteration = 0.0;     ///< Bytes processed per iteration (0 if not set).
+        double baselineMedianTime = 0.0;    ///< Median time per iteration of the baseline (0 if no baseline).
+    };
+
+    /**
+     * Create a benchmark.
+     * @param[in] ctx Test context. Regressions are reported as failures to this context.
+     * @param[in] name Full name of the benchmark (suite:test).
+     */
+    Benchmark(UnitTestContext& ctx, std::string name);
+
+    /// Set the number of items processed per iteration of the following runs. Reported as throughput in items/s.
+    void setItemsPerIteration(double items) { mItemsPerIteration = items; }
+
+    /// Set the number of bytes processed per iteration of the following runs. Reported as throughput in bytes/s.
+    void setBytesPerIteration(double bytes) { mBytesPerIteration = bytes; }
+
+    /**
+     * Benchmark a function.
+     * @param[in] func Function to benchmark. Use doNotOptimize() on results to keep the compiler from removing the work.
+     * @return Benchmark result.
+     */
+    template<typename Func>
+    Result run(Func&& func)
+    {
+        return run("", std::forward<Func>(func));
+    }
+
+    /**
+     * Benchmark a function. Used for benchmarking multiple variants in the same test.
+     * @param[in] runName Name of the run, appended to the benchmark name.
+     * @param[in] func Function to benchmark.
+     * @return Benchmark result.
+     */
+    template<typename Func>
+    Result run(const std::string& runName, Func&& func)
+    {
+        // The loop is instantiated here so that the benchmarked function can be inlined.
+        return runSamples(
+            runName,
+            [&func](uint64_t iterations)
+            {
+                auto startTime = std::chrono::steady_clock::now();
+                for (uint64_t i = 0; i < iterations; ++i)
+                    func();
+                return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            }
+        );
+    }
+
+    /// Get the results of all runs.
+    const std::vector<Result>& getResults() const { return mResults; }
+
+private:
+    /// Runs a batch of iterations and returns the elapsed time in seconds.
+    using SampleFunc = std::function<double(uint64_t iterations)>;
+
+    Result runSamples(const std::string& runName, const SampleFunc& sampleFunc);
+
+    UnitTestContext& mCtx;
+    std::string mName;
+    double mItemsPerIteration = 0.0;
+    double mBytesPerIteration = 0.0;
+    std::vector<Result> mResults;
+};
+
+/**
+ * Prevent the compiler from optimizing away the computation of a value in a benchmark.
+ */
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+    static const void* volatile sSink;
+    sSink = &value;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
 struct Tags
 {
     Tags(std::string tag) { tags.push_back(std::move(tag)); }
@@ -533,6 +649,7 @@ inline std::optional<std::string> createBinaryMessage(std::string_view lhsStr, s
 using UnitTestContext = unittest::UnitTestContext;
 using CPUUnitTestContext = unittest::CPUUnitTestContext;
 using GPUUnitTestContext = unittest::GPUUnitTestContext;
+using unittest::doNotOptimize;
 
 /**
  * Macro to define a CPU unit test. The optional arguments include:
@@ -609,6 +726,82 @@ using GPUUnitTestContext = unittest::GPUUnitTestContext;
     } RegisterGPUTest##name;                                                    \
     static void GPUUnitTest##name(GPUUnitTestContext& ctx) /* over to the user for the braces */
 
+/**
+ * Macro to define a CPU benchmark. Takes the same optional arguments as CPU_TEST.
+ * The body has access to the test context `ctx` and the benchmark `bench`:
+ *
+ * CPU_BENCHMARK(Sort)
+ * {
+ *     std::vector<float> values = createValues(); // Setup is not timed.
+ *     bench.setItemsPerIteration(values.size());
+ *     bench.run([&]() { auto copy = values; std::sort(copy.begin(), copy.end()); doNotOptimize(copy); });
+ * }
+ *
+ * Note: All CPU benchmarks are implicitly tagged with "cpu" and "benchmark".
+ * Benchmarks only run if the tag filter explicitly includes "benchmark" or a test case filter matches them.
+ */
+#define CPU_BENCHMARK(name, ...)                                                                                       \
+    static void CPUBenchmark##name(CPUUnitTestContext& ctx, unittest::Benchmark& bench);                               \
+    struct CPUBenchmarkRegisterer##name                                                                                \
+    {                                                                                                                  \
+        CPUBenchmarkRegisterer##name()                                                                                 \
+        {                                                                                                              \
+            std::filesystem::path path = __FILE__;                                                                     \
+            unittest::Options options;                                                                                 \
+            applyArgs(options, ##__VA_ARGS__);                                                                         \
+            options.tags.insert("cpu");                                                                                \
+            options.tags.insert("benchmark");                                                                          \
+            std::string benchName = path.filename().string() + ":" #name;                                              \
+            unittest::registerCPUTest(                                                                                 \
+                path,                                                                                                  \
+                #name,                                                                                                 \
+                options,                                                                                               \
+                [benchName](CPUUnitTestContext& ctx)                                                                   \
+                {                                                                                                      \
+                    unittest::Benchmark bench(ctx, benchName);                                                         \
+                    CPUBenchmark##name(ctx, bench);                                                                    \
+                }                                                                                                      \
+            );                                                                                                         \
+        }                                                                                                              \
+    } RegisterCPUBenchmark##name;                                                                                      \
+    static void CPUBenchmark##name(CPUUnitTestContext& ctx, unittest::Benchmark& bench) /* over to the user for the braces */
+
+/**
+ * Macro to define a GPU benchmark. Takes the same optional arguments as GPU_TEST.
+ * The body has access to the test context `ctx` and the benchmark `bench`, see CPU_BENCHMARK.
+ * The benchmark name includes the device type. Note that GPU work is asynchronous, flush and
+ * wait for the device in the benchmarked function to include the GPU time.
+ *
+ * Note: All GPU benchmarks are implicitly tagged with "gpu" and "benchmark".
+ * Benchmarks only run if the tag filter explicitly includes "benchmark" or a test case filter matches them.
+ */
+#define GPU_BENCHMARK(name, ...)                                                                                       \
+    static void GPUBenchmark##name(GPUUnitTestContext& ctx, unittest::Benchmark& bench);                               \
+    struct GPUBenchmarkRegisterer##name                                                                                \
+    {                                                                                                                  \
+        GPUBenchmarkRegisterer##name()                                                                                 \
+        {                                                                                                              \
+            std::filesystem::path path = __FILE__;                                                                     \
+            unittest::Options options;                                                                                 \
+            applyArgs(options, ##__VA_ARGS__);                                                                         \
+            options.tags.insert("gpu");                                                                                \
+            options.tags.insert("benchmark");                                                                          \
+            std::string benchName = path.filename().string() + ":" #name;                                              \
+            unittest::registerGPUTest(                                                                                 \
+                path,                                                                                                  \
+                #name,                                                                                                 \
+                options,                                                                                               \
+                [benchName](GPUUnitTestContext& ctx)                                                                   \
+                {                                                                                                      \
+                    std::string deviceName = fmt::format("{} ({})", benchName, ctx.getDevice()->getType());            \
+                    unittest::Benchmark bench(ctx, deviceName);                                                        \
+                    GPUBenchmark##name(ctx, bench);                                                                    \
+                }                                                                                                      \
+            );                                                                                                         \
+        }                                                                                                              \
+    } RegisterGPUBenchmark##name;                                                                                      \
+    static void GPUBenchmark##name(GPUUnitTestContext& ctx, unittest::Benchmark& bench) /* over to the user for the braces */
+
 // clang-format off
 
 /// Used as an argument of CPU_TEST/GPU_TEST to tag a test with a set of strings.
@@ -27,17 +27,31 @@
  **************************************************************************/
 #include "AsyncTextureLoader.h"
 #include "Core/API/Device.h"
-#include "Utils/Threading.h"
+#include "Core/API/Fence.h"
+#include "Core/API/RenderContext.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/Timing/CpuTimer.h"
+#include "Utils/Timing/LoadProfiler.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Falcor
 {
 namespace
 {
-constexpr size_t kUploadsPerFlush = 16; ///< Number of texture uploads before issuing a flush (to keep upload heap from growing).
-}
+constexpr bool kTopDown = true; ///< Memory layout when loading from file.
+
+constexpr size_t kMaxBatchTextureCount = 64;           ///< Maximum number of textures uploaded in a single batch.
+constexpr uint64_t kMaxBatchBytes = 64ull << 20;       ///< Maximum size of the texture data uploaded in a single batch.
+constexpr uint64_t kMaxBatchesInFlight = 2;            ///< Maximum number of submitted batches the GPU may lag behind.
+constexpr uint64_t kUploadBytesPerSync = 256ull << 20; ///< Size of uploaded data before synchronizing the GPU (to keep upload heap from growing).
+} // namespace
 
-AsyncTextureLoader::AsyncTextureLoader(ref<Device> pDevice, size_t threadCount) : mpDevice(pDevice)
+AsyncTextureLoader::AsyncTextureLoader(ref<Device> pDevice, size_t threadCount, uint64_t maxInFlightBytes)
+    : mpDevice(pDevice), mMaxInFlightBytes(maxInFlightBytes)
 {
+    mpUploadFence = mpDevice->createFence();
     runWorkers(threadCount);
 }
 
@@ -58,7 +72,7 @@ std::future<ref<Texture>> AsyncTextureLoader::loadMippedFromFiles(
 {
     std::lock_guard<std::mutex> lock(mMutex);
     mLoadRequestQueue.push(LoadRequest{{paths.begin(), paths.end()}, false, loadAsSrgb, bindFlags, importFlags, callback});
-    mCondition.notify_one();
+    mDecoderCondition.notify_one();
     return mLoadRequestQueue.back().promise.get_future();
 }
 
@@ -73,96 +87,195 @@ std::future<ref<Texture>> AsyncTextureLoader::loadFromFile(
 {
     std::lock_guard<std::mutex> lock(mMutex);
     mLoadRequestQueue.push(LoadRequest{{path}, generateMipLevels, loadAsSrgb, bindFlags, importFlags, callback});
-    mCondition.notify_one();
+    mDecoderCondition.notify_one();
     return mLoadRequestQueue.back().promise.get_future();
 }
 
-void AsyncTextureLoader::runWorkers(size_t threadCount)
+void AsyncTextureLoader::setMaxInFlightBytes(uint64_t maxInFlightBytes)
 {
-    // Create a barrier to synchronize worker threads before issuing a global flush.
-    mFlushBarrier = std::make_shared<Barrier>(
-        threadCount,
-        [&]()
-        {
-            mpDevice->wait();
-            mFlushPending = false;
-            mUploadCounter = 0;
-        }
-    );
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMaxInFlightBytes = maxInFlightBytes;
+    mDecoderCondition.notify_all();
+}
+
+uint64_t AsyncTextureLoader::getMaxInFlightBytes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMaxInFlightBytes;
+}
 
-    for (size_t i = 0; i < threadCount; ++i)
+AsyncTextureLoader::Stats AsyncTextureLoader::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void AsyncTextureLoader::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats = {};
+}
+
+void AsyncTextureLoader::runWorkers(size_t threadCount)
+{
+    for (size_t i = 0; i < std::max<size_t>(threadCount, 1); ++i)
     {
-        mThreads.emplace_back(&AsyncTextureLoader::runWorker, this);
+        mDecoderThreads.emplace_back(&AsyncTextureLoader::runDecoder, this);
     }
+    mUploaderThread = std::thread(&AsyncTextureLoader::runUploader, this);
 }
 
-void AsyncTextureLoader::runWorker()
+void AsyncTextureLoader::runDecoder()
 {
-    // This function is the entry point for worker threads.
-    // The workers wait on the load request queue and load a texture when woken up.
-    // To avoid the upload heap growing too large, we synchronize the threads and
-    // issue a global GPU flush at regular intervals.
+    // This function is the entry point for decoder threads.
+    // The decoders wait on the load request queue and decode a texture to CPU memory when woken up.
+    // To bound memory usage, no new decode is started while the decoded data waiting for upload
+    // is at or above the cap. Decoders never synchronize with the GPU.
 
     while (true)
     {
-        // Wait on condition until more work is ready.
+        // Wait on condition until more work is ready and there is room for more decoded data.
         std::unique_lock<std::mutex> lock(mMutex);
-        mCondition.wait(lock, [&]() { return mTerminate || !mLoadRequestQueue.empty() || mFlushPending; });
-
-        // Sync thread if a flush is pending.
-        if (mFlushPending)
-        {
-            lock.unlock();
-            mFlushBarrier->wait();
-            mCondition.notify_one();
-            continue;
-        }
-
-        // Terminate thread unless there is more work to do.
-        if (mTerminate && mLoadRequestQueue.empty() && !mFlushPending)
-            break;
+        mDecoderCondition.wait(
+            lock,
+            [&]()
+            {
+                if (mLoadRequestQueue.empty())
+                    return mTerminate;
+                return mInFlightBytes < mMaxInFlightBytes || mInFlightBytes == 0;
+            }
+        );
 
-        // Go back waiting if queue is currently empty.
+        // Terminate thread if there is no more work to do.
         if (mLoadRequestQueue.empty())
-            continue;
+            break;
 
         // Pop next load request from queue.
         auto request = std::move(mLoadRequestQueue.front());
         mLoadRequestQueue.pop();
+        mDecodesInProgress++;
 
         lock.unlock();
 
-        // Load the textures (this part is running in parallel).
-        ref<Texture> pTexture;
-        if (request.paths.size() == 1)
+        // Decode the texture (this part is running in parallel).
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        DecodedTexture decoded = decode(std::move(request));
+        double decodeTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()) * 1e-3;
+        uint64_t size = decoded.getSize();
+
+        lock.lock();
+
+        // Hand the decoded texture over to the upload thread.
+        mDecodedQueue.push_back(std::move(decoded));
+        mDecodesInProgress--;
+        mInFlightBytes += size;
+        mStats.decodedBytes += size;
+        mStats.decodeTime += decodeTime;
+        mStats.peakInFlightBytes = std::max(mStats.peakInFlightBytes, mInFlightBytes);
+
+        mUploaderCondition.notify_one();
+    }
+}
+
+void AsyncTextureLoader::runUploader()
+{
+    // This function is the entry point for the upload thread.
+    // The upload thread collects decoded textures into batches, creates the textures and submits the
+    // uploads to the GPU. Each batch is tracked with a fence to limit how far the GPU may lag behind.
+    // Memory in the upload heap is only recycled after the GPU has been synchronized, which is done
+    // after a fixed amount of uploaded data. Only this thread ever waits on the GPU.
+
+    uint64_t uploadedBytesSinceSync = 0;
+    std::vector<DecodedTexture> batch;
+    std::vector<ref<Texture>> textures;
+
+    while (true)
+    {
+        uint64_t batchBytes = 0;
         {
-            pTexture = Texture::createFromFile(
-                mpDevice, request.paths[0], request.generateMipLevels, request.loadAsSRGB, request.bindFlags, request.importFlags
+            // Wait on condition until decoded textures are ready.
+            std::unique_lock<std::mutex> lock(mMutex);
+            mUploaderCondition.wait(
+                lock,
+                [&]() { return !mDecodedQueue.empty() || (mTerminate && mLoadRequestQueue.empty() && mDecodesInProgress == 0); }
             );
+
+            // Terminate thread if all requests have been processed.
+            if (mDecodedQueue.empty())
+                break;
+
+            // Pop as many decoded textures as fit in a batch.
+            while (!mDecodedQueue.empty() && batch.size() < kMaxBatchTextureCount)
+            {
+                uint64_t size = mDecodedQueue.front().getSize();
+                if (!batch.empty() && batchBytes + size > kMaxBatchBytes)
+                    break;
+                batchBytes += size;
+                batch.push_back(std::move(mDecodedQueue.front()));
+                mDecodedQueue.pop_front();
+            }
         }
-        else
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+
+        // Create the textures. This records the uploads on the render context.
+        textures.resize(batch.size());
+        for (size_t i = 0; i < batch.size(); ++i)
         {
-            pTexture = Texture::createMippedFromFiles(mpDevice, request.paths, request.loadAsSRGB, request.bindFlags, request.importFlags);
-        }
+            textures[i] = createTexture(batch[i]);
 
-        request.promise.set_value(pTexture);
+            // Release the decoded data right away, it has been copied to the upload heap.
+            batch[i].pBitmap.reset();
+            batch[i].data.imageData = {};
+        }
 
-        if (request.callback)
+        // Submit the batch and bound the number of batches in flight.
+        uint64_t syncCount = 0;
         {
-            request.callback(pTexture);
+            std::lock_guard<std::mutex> lock(mpDevice->getGlobalGfxMutex());
+            uploadedBytesSinceSync += batchBytes;
+            if (uploadedBytesSinceSync >= kUploadBytesPerSync)
+            {
+                mpDevice->wait();
+                uploadedBytesSinceSync = 0;
+                syncCount++;
+            }
+            else
+            {
+                RenderContext* pRenderContext = mpDevice->getRenderContext();
+                pRenderContext->submit(false);
+                uint64_t fenceValue = pRenderContext->signal(mpUploadFence.get());
+                if (fenceValue > kMaxBatchesInFlight)
+                    mpUploadFence->wait(fenceValue - kMaxBatchesInFlight);
+            }
         }
 
-        lock.lock();
+        double uploadTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint()) * 1e-3;
+
+        // Make room for more decoded data.
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            FALCOR_ASSERT(mInFlightBytes >= batchBytes);
+            mInFlightBytes -= batchBytes;
+            mStats.textureCount += batch.size();
+            mStats.failedCount += std::count_if(textures.begin(), textures.end(), [](const ref<Texture>& pTex) { return !pTex; });
+            mStats.batchCount++;
+            mStats.syncCount += syncCount;
+            mStats.uploadTime += uploadTime;
+        }
+        mDecoderCondition.notify_all();
 
-        // Issue a global flush if necessary.
-        // TODO: It would be better to check the size of the upload heap instead.
-        if (!mTerminate && pTexture != nullptr && ++mUploadCounter >= kUploadsPerFlush)
+        // Notify requesters.
+        for (size_t i = 0; i < batch.size(); ++i)
         {
-            mFlushPending = true;
-            mCondition.notify_all();
+            auto& request = batch[i].request;
+            request.promise.set_value(textures[i]);
+            if (request.callback)
+                request.callback(textures[i]);
         }
 
-        mCondition.notify_one();
+        batch.clear();
+        textures.clear();
     }
 }
 
@@ -173,9 +286,165 @@ void AsyncTextureLoader::terminateWorkers()
         mTerminate = true;
     }
 
-    mCondition.notify_all();
+    mDecoderCondition.notify_all();
+    mUploaderCondition.notify_all();
 
-    for (auto& thread : mThreads)
+    for (auto& thread : mDecoderThreads)
         thread.join();
+    mUploaderThread.join();
+}
+
+AsyncTextureLoader::DecodedTexture AsyncTextureLoader::decode(LoadRequest&& request) const
+{
+    FALCOR_LOAD_ITEM_PHASE("Texture decode");
+
+    DecodedTexture decoded;
+    decoded.request = std::move(request);
+    const auto& req = decoded.request;
+    auto& data = decoded.data;
+    decoded.sourcePath = req.paths[0];
+
+    try
+    {
+        if (req.paths.size() == 1)
+        {
+            const auto& path = req.paths[0];
+            if (!std::filesystem::exists(path))
+            {
+                logWarning("Error when loading image file. File '{}' does not exist.", path);
+            }
+            else if (hasExtension(path, "dds"))
+            {
+                decoded.isValid = ImageIO::loadDDSData(path, req.loadAsSRGB, data);
+            }
+            else
+            {
+                decoded.pBitmap = Bitmap::createFromFile(path, kTopDown, req.importFlags);
+                if (decoded.pBitmap)
+                {
+                    data.format = req.loadAsSRGB ? linearToSrgbFormat(decoded.pBitmap->getFormat()) : decoded.pBitmap->getFormat();
+                    data.type = Resource::Type::Texture2D;
+                    data.width = decoded.pBitmap->getWidth();
+                    data.height = decoded.pBitmap->getHeight();
+                    data.mipLevels = req.generateMipLevels ? Texture::kMaxPossible : 1;
+                    decoded.isValid = true;
+                }
+            }
+        }
+        else
+        {
+            std::vector<Bitmap::UniqueConstPtr> mips;
+            mips.reserve(req.paths.size());
+            size_t combinedSize = 0;
+
+            for (const auto& path : req.paths)
+            {
+                Bitmap::UniqueConstPtr pBitmap =
+                    hasExtension(path, "dds") ? ImageIO::loadBitmapFromDDS(path) : Bitmap::createFromFile(path, kTopDown, req.importFlags);
+                if (!pBitmap)
+                {
+                    logWarning("Error loading mip {}. Loading failed for image file '{}'.", mips.size(), path);
+                    break;
+                }
+
+                if (!mips.empty())
+                {
+                    if (mips.back()->getFormat() != pBitmap->getFormat())
+                    {
+                        logWarning("Error loading mip {} from file {}. Texture format of all mip levels must match.", mips.size(), path);
+                        break;
+                    }
+                    if (std::max(mips.back()->getWidth() / 2, 1u) != pBitmap->getWidth() ||
+                        std::max(mips.back()->getHeight() / 2, 1u) != pBitmap->getHeight())
+                    {
+                        logWarning(
+                            "Error loading mip {} from file {}. Image resolution must decrease by half. ({}, {}) != ({}, {})/2",
+                            mips.size(),
+                            path,
+                            pBitmap->getWidth(),
+                            pBitmap->getHeight(),
+                            mips.back()->getWidth(),
+                            mips.back()->getHeight()
+                        );
+                        break;
+                    }
+                }
+                combinedSize += pBitmap->getSize();
+                mips.emplace_back(std::move(pBitmap));
+            }
+
+            if (!mips.empty())
+            {
+                // Combine all the mip data into a single buffer.
+                data.imageData.resize(combinedSize);
+                size_t copyDst = 0;
+                for (const auto& mip : mips)
+                {
+                    std::memcpy(data.imageData.data() + copyDst, mip->getData(), mip->getSize());
+                    copyDst += mip->getSize();
+                }
+
+                data.format = req.loadAsSRGB ? linearToSrgbFormat(mips[0]->getFormat()) : mips[0]->getFormat();
+                data.type = Resource::Type::Texture2D;
+                data.width = mips[0]->getWidth();
+                data.height = mips[0]->getHeight();
+                data.mipLevels = (uint32_t)mips.size();
+                decoded.isValid = true;
+            }
+        }
+    }
+    catch (const std::exception& e)
+    {
+        logWarning("Error loading '{}': {}", decoded.sourcePath, e.what());
+        decoded.isValid = false;
+    }
+
+    if (!decoded.isValid)
+    {
+        decoded.pBitmap.reset();
+        data.imageData = {};
+    }
+
+    return decoded;
+}
+
+ref<Texture> AsyncTextureLoader::createTexture(const DecodedTexture& decoded) const
+{
+    if (!decoded.isValid)
+        return nullptr;
+
+    const auto& req = decoded.request;
+    const auto& data = decoded.data;
+
+    ref<Texture> pTex;
+    try
+    {
+        if (decoded.pBitmap)
+            pTex = mpDevice->createTexture2D(data.width, data.height, data.format, 1, data.mipLevels, decoded.pBitmap->getData(), req.bindFlags);
+        else
+            pTex = ImageIO::createTextureFromDDSData(mpDevice, data, req.bindFlags);
+    }
+    catch (const std::exception& e)
+    {
+        logWarning("Error creating texture for '{}': {}", decoded.sourcePath, e.what());
+    }
+
+    if (pTex != nullptr)
+    {
+        pTex->setSourcePath(decoded.sourcePath);
+        pTex->mImportFlags = req.importFlags;
+
+        // Log debug info.
+        logDebug(
+            "Loaded texture: size={}x{} mips={} format={} path={}",
+            pTex->getWidth(),
+            pTex->getHeight(),
+            pTex->getMipCount(),
+            to_string(pTex->getFormat()),
+            decoded.sourcePath
+        );
+    }
+
+    return pTex;
 }
 } // namespace Falcor
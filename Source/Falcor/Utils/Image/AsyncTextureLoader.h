@@ -26,11 +26,13 @@
  # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  **************************************************************************/
 #pragma once
+#include "ImageIO.h"
 #include "Core/Macros.h"
 #include "Core/API/fwd.h"
 #include "Core/API/Resource.h"
 #include "Core/API/Texture.h"
 #include <condition_variable>
+#include <deque>
 #include <filesystem>
 #include <functional>
 #include <future>
@@ -42,21 +44,49 @@
 
 namespace Falcor
 {
-class Barrier;
-
 /**
- * Utility class to load textures asynchronously using multiple worker threads.
+ * Utility class to load textures asynchronously.
+ *
+ * Loading is split into two pipeline stages:
+ * - Decoder threads read and decode the image files into CPU memory.
+ * - A single upload thread creates the textures from the decoded data and submits the uploads
+ *   to the GPU in batches. Each batch is tracked with a fence.
+ *
+ * Decoder threads never wait on the GPU. They only stall when the amount of decoded data waiting
+ * for upload reaches the in-flight memory cap. The upload thread is the only thread synchronizing
+ * with the GPU, which it does to recycle upload heap memory after a fixed amount of uploaded data.
  */
 class FALCOR_API AsyncTextureLoader
 {
 public:
     using LoadCallback = std::function<void(ref<Texture> pTexture)>;
 
+    /// Default cap on the decoded texture data waiting for upload.
+    static constexpr uint64_t kDefaultMaxInFlightBytes = 1ull << 30;
+
+    /// Loading statistics.
+    struct Stats
+    {
+        uint64_t textureCount = 0;      ///< Number of processed load requests (including failed loads).
+        uint64_t failedCount = 0;       ///< Number of load requests that failed.
+        uint64_t decodedBytes = 0;      ///< Total size of decoded texture data in bytes.
+        uint64_t batchCount = 0;        ///< Number of upload batches submitted to the GPU.
+        uint64_t syncCount = 0;         ///< Number of full GPU synchronizations to recycle the upload heap.
+        uint64_t peakInFlightBytes = 0; ///< Peak size of decoded data waiting for upload in bytes.
+        double decodeTime = 0.0;        ///< Accumulated decode time of all decoder threads in seconds.
+        double uploadTime = 0.0;        ///< Accumulated time spent in the upload stage in seconds.
+    };
+
     /**
      * Constructor.
-     * @param[in] threadCount Number of worker threads.
+     * @param[in] threadCount Number of decoder threads.
+     * @param[in] maxInFlightBytes Cap on the decoded texture data waiting for upload in bytes.
      */
-    AsyncTextureLoader(ref<Device> pDevice, size_t threadCount = std::thread::hardware_concurrency());
+    AsyncTextureLoader(
+        ref<Device> pDevice,
+        size_t threadCount = std::thread::hardware_concurrency(),
+        uint64_t maxInFlightBytes = kDefaultMaxInFlightBytes
+    );
 
     /**
      * Destructor.
@@ -100,11 +130,24 @@ public:
         LoadCallback callback = {}
     );
 
-private:
-    void runWorkers(size_t threadCount);
-    void runWorker();
-    void terminateWorkers();
+    /**
+     * Set the cap on the decoded texture data waiting for upload.
+     * Decoder threads do not start decoding while the cap is reached. As the size of a texture is only known
+     * after decoding, the cap can be exceeded by at most one texture per decoder thread.
+     * @param[in] maxInFlightBytes Cap in bytes.
+     */
+    void setMaxInFlightBytes(uint64_t maxInFlightBytes);
+
+    /// Get the cap on the decoded texture data waiting for upload.
+    uint64_t getMaxInFlightBytes() const;
 
+    /// Get the loading statistics.
+    Stats getStats() const;
+
+    /// Reset the loading statistics.
+    void resetStats();
+
+private:
     struct LoadRequest
     {
         std::vector<std::filesystem::path> paths;
@@ -116,18 +159,43 @@ private:
         std::promise<ref<Texture>> promise;
     };
 
+    /// Decoded texture waiting for upload.
+    struct DecodedTexture
+    {
+        LoadRequest request;
+        bool isValid = false;
+        std::filesystem::path sourcePath;
+        ImageIO::DDSData data;          ///< Texture description. Holds the image data unless pBitmap is set.
+        Bitmap::UniqueConstPtr pBitmap; ///< Decoded image for textures loaded from a single non-DDS file.
+
+        uint64_t getSize() const { return pBitmap ? pBitmap->getSize() : data.imageData.size(); }
+    };
+
+    void runWorkers(size_t threadCount);
+    void runDecoder();
+    void runUploader();
+    void terminateWorkers();
+
+    DecodedTexture decode(LoadRequest&& request) const;
+    ref<Texture> createTexture(const DecodedTexture& decoded) const;
+
     ref<Device> mpDevice;
+    ref<Fence> mpUploadFence; ///< Fence signaled after each upload batch.
 
-    std::mutex mMutex;                      ///< Mutex for synchronizing access to shared resources.
-    std::condition_variable mCondition;     ///< Condition variable for workers to wait on.
-    std::shared_ptr<Barrier> mFlushBarrier; ///< Barrier for flushing the GPU to upload textures.
-    std::vector<std::thread> mThreads;      ///< Worker threads.
+    mutable std::mutex mMutex;                  ///< Mutex for synchronizing access to shared resources.
+    std::condition_variable mDecoderCondition;  ///< Condition variable for decoder threads to wait on.
+    std::condition_variable mUploaderCondition; ///< Condition variable for the upload thread to wait on.
+    std::vector<std::thread> mDecoderThreads;   ///< Decoder threads.
+    std::thread mUploaderThread;                ///< Upload thread.
 
     // Internal state. Do not access outside of critical section.
     std::queue<LoadRequest> mLoadRequestQueue; ///< Texture loading request queue.
+    std::deque<DecodedTexture> mDecodedQueue;  ///< Decoded textures waiting for upload.
+    size_t mDecodesInProgress = 0;             ///< Number of requests currently being decoded.
+    uint64_t mInFlightBytes = 0;               ///< Size of decoded data waiting for or in upload.
+    uint64_t mMaxInFlightBytes;                ///< Cap on mInFlightBytes.
+    Stats mStats;                              ///< Loading statistics.
 
-    bool mTerminate = false;     ///< Flag to terminate worker threads.
-    bool mFlushPending = false;  ///< Flag to indicate a GPU flush is pending.
-    uint32_t mUploadCounter = 0; ///< Counter to issue a flush every few uploads.
+    bool mTerminate = false; ///< Flag to terminate worker threads.
 };
 } // namespace Falcor
@@ -43,21 +43,7 @@ namespace Falcor
 {
 namespace
 {
-struct ImportData
-{
-    // Commonly used values converted or casted for cleaner access
-    ResourceFormat format;
-    Resource::Type type;
-    uint32_t width;
-    uint32_t height;
-    uint32_t depth;
-    uint32_t arraySize;
-    uint32_t mipLevels;
-    bool hasDX10Header = false;
-
-    // Data to be imported
-    std::vector<uint8_t> imageData;
-};
+using ImportData = ImageIO::DDSData;
 
 struct ExportData
 {
@@ -577,9 +563,8 @@ Bitmap::UniqueConstPtr ImageIO::loadBitmapFromDDS(const std::filesystem::path& p
     return Bitmap::create(data.width, data.height, data.format, data.imageData.data());
 }
 
-ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb)
+bool ImageIO::loadDDSData(const std::filesystem::path& path, bool loadAsSrgb, DDSData& data)
 {
-    ImportData data;
     try
     {
         loadDDS(path, loadAsSrgb, data);
@@ -587,30 +572,38 @@ ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesys
     catch (const RuntimeError& e)
     {
         logWarning("Failed to load DDS image from '{}': {}", path, e.what());
-        return nullptr;
+        return false;
     }
+    return true;
+}
 
-    ref<Texture> pTex;
+ref<Texture> ImageIO::createTextureFromDDSData(ref<Device> pDevice, const DDSData& data, ResourceBindFlags bindFlags)
+{
     // TODO: Automatic mip generation
+    const void* pData = data.imageData.data();
     switch (data.type)
     {
     case Resource::Type::Texture1D:
-        pTex = pDevice->createTexture1D(data.width, data.format, data.arraySize, data.mipLevels, data.imageData.data());
-        break;
+        return pDevice->createTexture1D(data.width, data.format, data.arraySize, data.mipLevels, pData, bindFlags);
     case Resource::Type::Texture2D:
-        pTex = pDevice->createTexture2D(data.width, data.height, data.format, data.arraySize, data.mipLevels, data.imageData.data());
-        break;
+        return pDevice->createTexture2D(data.width, data.height, data.format, data.arraySize, data.mipLevels, pData, bindFlags);
     case Resource::Type::TextureCube:
-        pTex = pDevice->createTextureCube(data.width, data.height, data.format, data.arraySize / 6, data.mipLevels, data.imageData.data());
-        break;
+        return pDevice->createTextureCube(data.width, data.height, data.format, data.arraySize / 6, data.mipLevels, pData, bindFlags);
     case Resource::Type::Texture3D:
-        pTex = pDevice->createTexture3D(data.width, data.height, data.depth, data.format, data.mipLevels, data.imageData.data());
-        break;
+        return pDevice->createTexture3D(data.width, data.height, data.depth, data.format, data.mipLevels, pData, bindFlags);
     default:
-        logWarning("Failed to load DDS image from '{}': Unrecognized texture type.", path);
+        logWarning("Failed to create texture from DDS data: Unrecognized texture type.");
         return nullptr;
     }
+}
+
+ref<Texture> ImageIO::loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb)
+{
+    DDSData data;
+    if (!loadDDSData(path, loadAsSrgb, data))
+        return nullptr;
 
+    ref<Texture> pTex = createTextureFromDDSData(pDevice, data);
     if (pTex != nullptr)
     {
         pTex->setSourcePath(path);
@@ -30,6 +30,7 @@
 #include "Core/Macros.h"
 #include "Core/API/Texture.h"
 #include <filesystem>
+#include <vector>
 
 namespace Falcor
 {
@@ -72,6 +73,21 @@ public:
         None
     };
 
+    /// Texture description and image data of a DDS file.
+    struct DDSData
+    {
+        ResourceFormat format = ResourceFormat::Unknown;
+        Resource::Type type = Resource::Type::Texture2D;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t depth = 1;
+        uint32_t arraySize = 1;
+        uint32_t mipLevels = 1;
+        bool hasDX10Header = false;
+
+        std::vector<uint8_t> imageData; ///< Image data of all subresources.
+    };
+
     /**
      * Load a DDS file to a Bitmap. If the file contains an image array and/or mips, only the first image will be loaded.
      * Throws an exception if the DDS file is malformed.
@@ -90,6 +106,28 @@ public:
      */
     static ref<Texture> loadTextureFromDDS(ref<Device> pDevice, const std::filesystem::path& path, bool loadAsSrgb);
 
+    /**
+     * Load the texture description and image data of a DDS file without creating a GPU resource.
+     * This can be called from any thread, the texture can be created later with createTextureFromDDSData().
+     * @param[in] path Path of file to load.
+     * @param[in] loadAsSrgb If true, convert the image format property to a corresponding sRGB format if available.
+     * @param[out] data Texture description and image data.
+     * @return True if loading was successful. Otherwise, false (a warning is logged).
+     */
+    static bool loadDDSData(const std::filesystem::path& path, bool loadAsSrgb, DDSData& data);
+
+    /**
+     * Create a texture from data previously loaded with loadDDSData().
+     * @param[in] data Texture description and image data.
+     * @param[in] bindFlags The bind flags for the texture resource.
+     * @return Texture object if creation was successful. Otherwise, nullptr.
+     */
+    static ref<Texture> createTextureFromDDSData(
+        ref<Device> pDevice,
+        const DDSData& data,
+        ResourceBindFlags bindFlags = ResourceBindFlags::ShaderResource
+    );
+
     /**
      * Saves a bitmap to a DDS file.
      * Throws an exception if path is invalid or the image cannot be saved.
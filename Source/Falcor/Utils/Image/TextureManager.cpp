@@ -27,11 +27,10 @@
  **************************************************************************/
 #include "TextureManager.h"
 #include "Core/AssetResolver.h"
+#include "Core/DirectoryIndex.h"
 #include "Core/API/Device.h"
 #include "Utils/Logger.h"
-#include "Utils/NumericRange.h"
-
-#include <execution>
+#include "Utils/Timing/LoadProfiler.h"
 
 // Temporarily disable asynchronous texture loader until Falcor supports parallel GPU work submission.
 // Until then `TextureManager` should only called from the main thread.
@@ -128,14 +127,12 @@ TextureManager::CpuTextureHandle TextureManager::loadUdimTexture(
         return loadTexture(path, generateMipLevels, loadAsSRGB, bindFlags, async, importFlags, assetResolver, loadedTextureCount);
 
     std::filesystem::path dirpath = path.parent_path();
-    filename.replace(pos, 6, "[1-9][0-9][0-9][0-9]");
-    std::regex udimRegex(filename);
     std::vector<std::filesystem::path> texturePaths;
     // Find the first directory containing the pattern, in case the UDIM set lives in multiple available directories
     if (assetResolver)
-        texturePaths = assetResolver->resolvePathPattern(dirpath, filename, true /* firstMatchOnly */);
+        texturePaths = assetResolver->resolveUdimPattern(dirpath, filename, true /* firstMatchOnly */);
     else
-        texturePaths = globFilesInDirectory(dirpath, udimRegex, true /* firstMatchOnly */);
+        texturePaths = DirectoryIndex::instance().findUdimFiles(dirpath, filename, true /* firstMatchOnly */);
 
     // Nothing found, return an invalid handle
     if (texturePaths.empty())
@@ -148,7 +145,7 @@ TextureManager::CpuTextureHandle TextureManager::loadUdimTexture(
 
     // Now load all the files from that directory
     std::filesystem::path loadedDir = texturePaths[0].parent_path();
-    texturePaths = globFilesInDirectory(loadedDir, udimRegex);
+    texturePaths = DirectoryIndex::instance().findUdimFiles(loadedDir, filename);
 
     if (loadedTextureCount)
         *loadedTextureCount = texturePaths.size();
@@ -222,7 +219,7 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
         else
         {
             fullPath = p;
-            found = std::filesystem::exists(fullPath);
+            found = DirectoryIndex::instance().exists(fullPath);
         }
 
         if (found)
@@ -324,13 +321,16 @@ TextureManager::CpuTextureHandle TextureManager::loadTexture(
 #else
         // Load texture from main thread.
         ref<Texture> pTexture;
-        if (paths.size() > 1)
         {
-            pTexture = Texture::createMippedFromFiles(mpDevice, paths, loadAsSRGB, bindFlags, importFlags);
-        }
-        else
-        {
-            pTexture = Texture::createFromFile(mpDevice, paths[0], generateMipLevels, loadAsSRGB, bindFlags, importFlags);
+            FALCOR_LOAD_ITEM_PHASE("Texture decode");
+            if (paths.size() > 1)
+            {
+                pTexture = Texture::createMippedFromFiles(mpDevice, paths, loadAsSRGB, bindFlags, importFlags);
+            }
+            else
+            {
+                pTexture = Texture::createFromFile(mpDevice, paths[0], generateMipLevels, loadAsSRGB, bindFlags, importFlags);
+            }
         }
 
         // Add new texture desc.
@@ -407,47 +407,36 @@ void TextureManager::endDeferredLoading()
     if (jobs.empty())
         return;
 
-    // Load textures in parallel.
-    std::atomic<size_t> texturesLoaded;
-    NumericRange<size_t> jobRange(0, jobs.size());
-    std::for_each(
-        std::execution::par_unseq,
-        jobRange.begin(),
-        jobRange.end(),
-        [&](size_t i)
+    // Load textures using the async texture loader. Files are decoded in parallel and uploaded in batches.
+    std::vector<std::future<ref<Texture>>> futures;
+    futures.reserve(jobs.size());
+    for (const auto& job : jobs)
+    {
+        const auto& key = job.key;
+        logDebug("Loading texture from '{}'", key.fullPaths[0]);
+        if (key.fullPaths.size() == 1)
         {
-            const auto& job = jobs[i];
-            auto& desc = getDesc(job.handle);
-            if (job.key.fullPaths.size() == 1)
-            {
-                desc.pTexture = Texture::createFromFile(
-                    mpDevice, job.key.fullPaths[0], job.key.generateMipLevels, job.key.loadAsSRGB, job.key.bindFlags, job.key.importFlags
-                );
-                logDebug("Loading texture from '{}'", job.key.fullPaths[0]);
-            }
-            else
-            {
-                desc.pTexture =
-                    Texture::createMippedFromFiles(mpDevice, job.key.fullPaths, job.key.loadAsSRGB, job.key.bindFlags, job.key.importFlags);
-                logDebug("Loading mipped texture from '{}'", job.key.fullPaths[0]);
-            }
-            if (texturesLoaded.fetch_add(1) % 10 == 9)
-            {
-                logDebug("Flush");
-                std::lock_guard<std::mutex> lock(mpDevice->getGlobalGfxMutex());
-                mpDevice->wait();
-            }
+            futures.push_back(mAsyncTextureLoader.loadFromFile(
+                key.fullPaths[0], key.generateMipLevels, key.loadAsSRGB, key.bindFlags, key.importFlags
+            ));
         }
-    );
-    mpDevice->wait();
+        else
+        {
+            futures.push_back(mAsyncTextureLoader.loadMippedFromFiles(key.fullPaths, key.loadAsSRGB, key.bindFlags, key.importFlags));
+        }
+    }
 
     // Mark loaded textures and add them to lookup table.
-    for (const auto& job : jobs)
+    for (size_t i = 0; i < jobs.size(); ++i)
     {
-        auto& desc = getDesc(job.handle);
+        auto& desc = getDesc(jobs[i].handle);
+        desc.pTexture = futures[i].get();
         desc.state = desc.pTexture ? TextureState::Loaded : TextureState::Invalid;
-        mTextureToHandle[desc.pTexture.get()] = job.handle;
+        if (desc.pTexture)
+            mTextureToHandle[desc.pTexture.get()] = jobs[i].handle;
     }
+
+    mpDevice->wait();
 }
 
 void TextureManager::removeTexture(const CpuTextureHandle& handle)
@@ -199,6 +199,7 @@ public:
      * Marks the beginning of a section where texture loading is deferred.
      * All loadTexture() and loadUdimTexture() calls after calling this will be put on a deferred list.
      * A later call to endDeferredLoading() will load all queued up textures in parallel.
+     * Files are decoded by multiple threads while a single thread uploads the textures in batches.
      * WARNING: This is a dangerous operation because Falcor is generally not thread-safe. Only use this
      * from the main thread when it is guaranteed to not be interleaved with any other thread.
      */
@@ -279,6 +280,12 @@ public:
      */
     Stats getStats() const;
 
+    /**
+     * Get the texture loader used for deferred loading.
+     * This can be used to adjust the cap on in-flight decoded data and to query loading statistics.
+     */
+    AsyncTextureLoader& getTextureLoader() { return mAsyncTextureLoader; }
+
 private:
     size_t getUdimRange(size_t requiredSize);
     void freeUdimRange(size_t rangeStart);
@@ -28,9 +28,64 @@
 #include "AliasTable.h"
 #include "Core/Error.h"
 #include "Core/API/Device.h"
+#include "Utils/NumericRange.h"
+#include <algorithm>
+#include <execution>
+#include <limits>
 
 namespace Falcor
 {
+namespace
+{
+/// Number of weights per block. Blocks are the unit of parallel work; the result only depends on this constant.
+const size_t kBlockSize = 1 << 16;
+
+/// Lists of below-average (low) and above-average (high) entries that still need to be placed in the table.
+struct Worklist
+{
+    std::vector<uint32_t> lows;
+    std::vector<uint32_t> highs;
+    size_t lowPos = 0;
+    size_t highPos = 0;
+};
+
+/**
+ * Combine low and high entries into alias table items until either list is exhausted.
+ * Each item consumes one low entry and removes the missing weight from a high entry. A high entry
+ * whose residual weight drops below the average is moved to the end of the low list.
+ * The residual weight of the current high entry is kept in double precision, as a single high entry
+ * can be paired with a large number of low entries.
+ * Only the weights of entries in the worklist are modified.
+ */
+template<typename EmitFunc>
+void sweep(std::vector<float>& weights, double avgWeight, Worklist& list, EmitFunc emit)
+{
+    if (list.highPos >= list.highs.size())
+        return;
+
+    double highWeight = weights[list.highs[list.highPos]];
+    while (list.lowPos < list.lows.size() && list.highPos < list.highs.size())
+    {
+        uint32_t low = list.lows[list.lowPos++];
+        uint32_t high = list.highs[list.highPos];
+        float threshold = float(weights[low] / avgWeight);
+        emit(AliasTable::Item{threshold, high, low, 0});
+
+        // We've removed some weight from element high; update it's weight and move it
+        // to the below-average list once it drops below average. The removed weight is computed
+        // from the stored threshold, so that rounding errors don't accumulate in the last entries.
+        highWeight -= avgWeight * (1.0 - threshold);
+        weights[high] = (float)highWeight;
+        if (highWeight < avgWeight)
+        {
+            list.lows.push_back(high);
+            if (++list.highPos < list.highs.size())
+                highWeight = weights[list.highs[list.highPos]];
+        }
+    }
+}
+} // namespace
+
 // This builds an alias table via the O(N) algorithm from Vose 1991, "A linear algorithm for generating random
 // numbers with a given distribution," IEEE Transactions on Software Engineering 17(9), 972-975.
 //
@@ -42,100 +97,210 @@ namespace Falcor
 // merging the first elements in each temporary buffer.  The residual sample is interted into either the
 // overweighted or underweighted set, depending on its residual weight.
 //
+// To build large tables in parallel, the input is split into fixed-size blocks. Each block's underweighted
+// samples are paired with a range of the overweighted samples whose excess weight approximately matches
+// the block's missing weight (found with prefix sums over the blocks). The blocks are then swept independently.
+// Each block produces at most as many items as it has samples, so its items are written to a disjoint range
+// of the output. The few samples left over at the block boundaries are swept serially in a final merge step,
+// filling the remaining slots. The items of a table are sampled uniformly, so their order doesn't matter.
+//
 // The main complexity is dealing with corner cases, thanks to numerical precision issues, where you don't
 // have 2 valid entries to combine.  By definition, in these corner cases, all remaining unhandled samples
 // actually have the average weight (within numerical precision limits)
-AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng) : mCount((uint32_t)weights.size())
+std::vector<AliasTable::Item> AliasTable::build(std::vector<float> weights, double& weightSum)
 {
-    // Use >= since we reserve 0xFFFFFFFFu as an invalid flag marker during construction.
+    // Use >= to keep the same limit as the shader side, which stores the count in a uint.
     if (weights.size() >= std::numeric_limits<uint32_t>::max())
         FALCOR_THROW("Too many entries for alias table.");
 
-    std::uniform_int_distribution<uint32_t> rngDist;
+    const uint32_t count = (uint32_t)weights.size();
+    weightSum = 0.0;
+    if (count == 0)
+        return {};
 
-    mpWeights =
-        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, weights.data());
+    const size_t blockCount = (count + kBlockSize - 1) / kBlockSize;
+    auto blockRange = NumericRange<size_t>(0, blockCount);
+    auto getBlockBegin = [&](size_t block) { return (uint32_t)(block * kBlockSize); };
+    auto getBlockEnd = [&](size_t block) { return (uint32_t)std::min<size_t>((block + 1) * kBlockSize, count); };
 
-    // Our working set / intermediate buffers (underweight & overweight); initialize to "invalid"
-    std::vector<uint32_t> lowIdx(mCount, 0xFFFFFFFFu);
-    std::vector<uint32_t> highIdx(mCount, 0xFFFFFFFFu);
+    // Sum element weights, use double to minimize precision issues.
+    // The block sums are added in order to make the result independent of the scheduling.
+    std::vector<double> blockWeightSums(blockCount, 0.0);
+    std::for_each(
+        std::execution::par,
+        blockRange.begin(),
+        blockRange.end(),
+        [&](size_t block)
+        {
+            double sum = 0.0;
+            for (uint32_t i = getBlockBegin(block); i < getBlockEnd(block); ++i)
+                sum += weights[i];
+            blockWeightSums[block] = sum;
+        }
+    );
+    for (double sum : blockWeightSums)
+        weightSum += sum;
 
-    // Sum element weights, use double to minimize precision issues
-    mWeightSum = 0.0;
-    for (float f : weights)
-        mWeightSum += f;
+    // Find the average weight. Use double to avoid a bias of the last entries due to rounding of the average.
+    const double avgWeight = weightSum / double(count);
 
-    // Find the average weight
-    float avgWeight = float(mWeightSum / double(mCount));
+    // Initialize working set. Each block's below-average elements are inserted into its own low list.
+    // Count the above-average elements and the missing/excess weight per block.
+    std::vector<Worklist> worklists(blockCount);
+    std::vector<uint32_t> blockHighCounts(blockCount, 0);
+    std::vector<double> blockDeficits(blockCount, 0.0);
+    std::vector<double> blockSurpluses(blockCount, 0.0);
+    std::for_each(
+        std::execution::par,
+        blockRange.begin(),
+        blockRange.end(),
+        [&](size_t block)
+        {
+            auto& lows = worklists[block].lows;
+            for (uint32_t i = getBlockBegin(block); i < getBlockEnd(block); ++i)
+            {
+                if (weights[i] < avgWeight)
+                {
+                    lows.push_back(i);
+                    blockDeficits[block] += avgWeight - weights[i];
+                }
+                else
+                {
+                    blockHighCounts[block]++;
+                    blockSurpluses[block] += weights[i] - avgWeight;
+                }
+            }
+        }
+    );
 
-    // Initialize working set. Inset inputs into our lists of above-average or below-average weight elements.
-    int lowCount = 0;
-    int highCount = 0;
-    for (uint32_t i = 0; i < mCount; ++i)
+    // Compute prefix sums over the blocks.
+    std::vector<uint32_t> highOffsets(blockCount + 1, 0);
+    std::vector<uint32_t> lowOffsets(blockCount + 1, 0);
+    std::vector<double> deficitPrefix(blockCount + 1, 0.0);
+    std::vector<double> surplusPrefix(blockCount + 1, 0.0);
+    for (size_t block = 0; block < blockCount; ++block)
     {
-        if (weights[i] < avgWeight)
-            lowIdx[lowCount++] = i;
-        else
-            highIdx[highCount++] = i;
+        highOffsets[block + 1] = highOffsets[block] + blockHighCounts[block];
+        lowOffsets[block + 1] = lowOffsets[block] + (uint32_t)worklists[block].lows.size();
+        deficitPrefix[block + 1] = deficitPrefix[block] + blockDeficits[block];
+        surplusPrefix[block + 1] = surplusPrefix[block] + blockSurpluses[block];
     }
+    const uint32_t highCount = highOffsets[blockCount];
 
-    // Create alias table entries by merging above- and below-average samples
-    std::vector<AliasTable::Item> items(mCount);
-    for (uint32_t i = 0; i < mCount; ++i)
-    {
-        // Usual case:  We have an above-average and below-average sample we can combine into one alias table entry
-        if ((lowIdx[i] != 0xFFFFFFFFu) && (highIdx[i] != 0xFFFFFFFFu))
+    // Gather all above-average elements into a single list in index order.
+    std::vector<uint32_t> highs(highCount);
+    std::for_each(
+        std::execution::par,
+        blockRange.begin(),
+        blockRange.end(),
+        [&](size_t block)
         {
-            // Create an alias table tuple:
-            items[i] = {weights[lowIdx[i]] / avgWeight, highIdx[i], lowIdx[i], 0};
-
-            // We've removed some weight from element highIdx[i]; update it's weight, then re-enter it
-            // on the end of either the above-average or below-average lists.
-            float updatedWeight = (weights[lowIdx[i]] + weights[highIdx[i]]) - avgWeight;
-            weights[highIdx[i]] = updatedWeight;
-            if (updatedWeight < avgWeight)
-                lowIdx[lowCount++] = highIdx[i];
-            else
-                highIdx[highCount++] = highIdx[i];
+            uint32_t offset = highOffsets[block];
+            for (uint32_t i = getBlockBegin(block); i < getBlockEnd(block); ++i)
+                if (!(weights[i] < avgWeight))
+                    highs[offset++] = i;
         }
+    );
 
-        // The next two cases can only occur towards the end of table creation, because either:
-        //    (a) all the remaining possible alias table entries have weight *exactly* equal to avgWeight,
-        //        which means these alias table entries only have one input item that is selected
-        //        with 100% probability
-        //    (b) all the remaining alias table entires have *almost* avgWeight, but due to (compounding)
-        //        precision issues throughout the process, they don't have *quite* that value.  In this case
-        //        treating these entries as having exactly avgWeight (as in case (a)) is the only right
-        //        thing to do mathematically (other than re-generating the alias table using higher precision
-        //        or trying to reduce catasrophic numerical cancellation in the "updatedWeight" computation above).
-        else if (highIdx[i] != 0xFFFFFFFFu)
+    // Assign each block the range of above-average elements whose accumulated excess weight
+    // approximately balances the accumulated missing weight of the preceding blocks.
+    std::vector<uint32_t> highSplits(blockCount + 1, 0);
+    highSplits[blockCount] = highCount;
+    std::for_each(
+        std::execution::par,
+        blockRange.begin(),
+        blockRange.end(),
+        [&](size_t block)
         {
-            items[i] = {1.0f, highIdx[i], highIdx[i], 0};
+            if (block == 0)
+                return;
+            double target = deficitPrefix[block];
+            size_t highBlock = std::upper_bound(surplusPrefix.begin(), surplusPrefix.end(), target) - surplusPrefix.begin();
+            highBlock = std::clamp<size_t>(highBlock, 1, blockCount) - 1;
+            double surplus = surplusPrefix[highBlock];
+            uint32_t i = highOffsets[highBlock];
+            while (i < highOffsets[highBlock + 1] && surplus < target)
+                surplus += weights[highs[i++]] - avgWeight;
+            highSplits[block] = i;
         }
-        else if (lowIdx[i] != 0xFFFFFFFFu)
+    );
+    for (size_t block = 1; block <= blockCount; ++block)
+        highSplits[block] = std::max(highSplits[block], highSplits[block - 1]);
+
+    // Create alias table entries by merging above- and below-average samples in each block.
+    // Block i writes to the range starting at lowOffsets[i] + highSplits[i], which holds all of its samples.
+    std::vector<AliasTable::Item> items(count);
+    std::vector<uint32_t> itemCounts(blockCount, 0);
+    std::for_each(
+        std::execution::par,
+        blockRange.begin(),
+        blockRange.end(),
+        [&](size_t block)
         {
-            items[i] = {1.0f, lowIdx[i], lowIdx[i], 0};
+            Worklist& list = worklists[block];
+            list.highs.assign(highs.begin() + highSplits[block], highs.begin() + highSplits[block + 1]);
+            AliasTable::Item* pItems = items.data() + lowOffsets[block] + highSplits[block];
+            uint32_t& itemCount = itemCounts[block];
+            sweep(weights, avgWeight, list, [&](const AliasTable::Item& item) { pItems[itemCount++] = item; });
         }
+    );
 
-        // If there is neither a highIdx[i] or lowIdx[i] for some array element(s).  By construction,
-        // this cannot occur (without some logic bug above).
-        else
+    // Merge the samples left over in all blocks and place them in the remaining slots.
+    Worklist merged;
+    for (const auto& list : worklists)
+    {
+        merged.lows.insert(merged.lows.end(), list.lows.begin() + list.lowPos, list.lows.end());
+        merged.highs.insert(merged.highs.end(), list.highs.begin() + list.highPos, list.highs.end());
+    }
+    worklists.clear();
+
+    size_t slotBlock = 0;
+    uint32_t slot = itemCounts[0];
+    auto emit = [&](const AliasTable::Item& item)
+    {
+        while (slot == lowOffsets[slotBlock + 1] + highSplits[slotBlock + 1] - lowOffsets[slotBlock] - highSplits[slotBlock])
         {
-            FALCOR_ASSERT(false); // Should not occur
+            slotBlock++;
+            FALCOR_ASSERT(slotBlock < blockCount);
+            slot = itemCounts[slotBlock];
         }
-    }
+        items[lowOffsets[slotBlock] + highSplits[slotBlock] + slot++] = item;
+    };
+    sweep(weights, avgWeight, merged, emit);
 
-    // TODO: We can simplify the alias table to implicitly store indexB (aka lowIdx[i]), so the AliasTable::Item
+    // The remaining entries can only occur towards the end of table creation, because either:
+    //    (a) all the remaining possible alias table entries have weight *exactly* equal to avgWeight,
+    //        which means these alias table entries only have one input item that is selected
+    //        with 100% probability
+    //    (b) all the remaining alias table entires have *almost* avgWeight, but due to (compounding)
+    //        precision issues throughout the process, they don't have *quite* that value.  In this case
+    //        treating these entries as having exactly avgWeight (as in case (a)) is the only right
+    //        thing to do mathematically (other than re-generating the alias table using higher precision
+    //        or trying to reduce catasrophic numerical cancellation in the residual weight computation in sweep()).
+    for (size_t i = merged.highPos; i < merged.highs.size(); ++i)
+        emit({1.0f, merged.highs[i], merged.highs[i], 0});
+    for (size_t i = merged.lowPos; i < merged.lows.size(); ++i)
+        emit({1.0f, merged.lows[i], merged.lows[i], 0});
+
+    // TODO: We can simplify the alias table to implicitly store indexB, so the AliasTable::Item
     // structure would be 1 float + 1 uint32_t, rather than 128 bits.  This, of course, would change usage in shaders
     // and elsewhere.  To do this, here you'd need to sort elements by indexB so that when looking up mpItems[j],
     // indexB==j.  This works since, by construction, only one element in the table has indexB==j (for any j
-    // in [0...mCount-1]).  Alternatively, during the loop above, you could directly enter elements into the
-    // correct location in the alias table.
+    // in [0...mCount-1]).  Alternatively, the items could directly be entered into the correct location above.
+
+    return items;
+}
+
+AliasTable::AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng) : mCount((uint32_t)weights.size())
+{
+    mpWeights =
+        pDevice->createStructuredBuffer(sizeof(float), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, weights.data());
+
+    std::vector<Item> items = build(std::move(weights), mWeightSum);
 
     // Stash the alias table in our GPU buffer
-    mpItems = pDevice->createStructuredBuffer(
-        sizeof(AliasTable::Item), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, items.data()
-    );
+    mpItems =
+        pDevice->createStructuredBuffer(sizeof(Item), mCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, items.data());
 }
 
 void AliasTable::bindShaderData(const ShaderVar& var) const
@@ -31,6 +31,7 @@
 #include "Core/Program/ShaderVar.h"
 #include <memory>
 #include <random>
+#include <vector>
 
 namespace Falcor
 {
@@ -40,6 +41,15 @@ namespace Falcor
 class FALCOR_API AliasTable
 {
 public:
+    /// Item structure for the items buffer. Matches AliasTable.slang.
+    struct Item
+    {
+        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
+        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
+        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
+        uint32_t _pad;
+    };
+
     /**
      * Create an alias table.
      * The weights don't need to be normalized to sum up to 1.
@@ -49,6 +59,15 @@ public:
      */
     AliasTable(ref<Device> pDevice, std::vector<float> weights, std::mt19937& rng);
 
+    /**
+     * Build the alias table items on the CPU. This is used by the constructor and does not need a device.
+     * Large tables are built in parallel. The result only depends on the weights, not on the number of threads.
+     * @param[in] weights The weights we'd like to sample each entry proportional to. Don't need to be normalized.
+     * @param[out] weightSum Total sum of all weights.
+     * @return List of items, one per weight. Each weight index occurs exactly once as indexB.
+     */
+    static std::vector<Item> build(std::vector<float> weights, double& weightSum);
+
     /**
      * Bind the alias table data to a given shader var.
      * @param[in] var The shader variable to set the data into.
@@ -66,15 +85,6 @@ public:
     double getWeightSum() const { return mWeightSum; }
 
 private:
-    // Item structure for the mpItems buffer.
-    struct Item
-    {
-        float threshold; ///< If rand() < threshold, pick indexB (else pick indexA)
-        uint32_t indexA; ///< The "redirect" index, if uniform sampling would overweight indexB.
-        uint32_t indexB; ///< The original / permutation index, sampled uniformly in [0...mCount-1]
-        uint32_t _pad;
-    };
-
     uint32_t mCount;       ///< Number of items in the alias table.
     double mWeightSum;     ///< Total weight of all elements used to create the alias table.
     ref<Buffer> mpItems;   ///< Buffer containing table items.
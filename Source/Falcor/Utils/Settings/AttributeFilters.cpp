@@ -27,18 +27,210 @@
  **************************************************************************/
 #include "AttributeFilters.h"
 
+#include <cctype>
 #include <set>
 
 namespace Falcor
 {
 namespace settings
 {
+namespace
+{
+/// Parse a regex consisting only of literal characters and escaped punctuation. Returns false if the regex contains other syntax.
+bool parseLiteral(std::string_view regexStr, std::string& literal)
+{
+    static constexpr std::string_view kSpecialChars = "^$\\.*+?()[]{}|";
+    literal.clear();
+    for (size_t i = 0; i < regexStr.size(); ++i)
+    {
+        char c = regexStr[i];
+        if (c == '\\')
+        {
+            // Only escaped punctuation is a literal, escapes like \d or \b are character classes/assertions.
+            if (++i == regexStr.size() || std::isalnum((unsigned char)regexStr[i]))
+                return false;
+            literal.push_back(regexStr[i]);
+        }
+        else if (kSpecialChars.find(c) != std::string_view::npos)
+        {
+            return false;
+        }
+        else
+        {
+            literal.push_back(c);
+        }
+    }
+    return true;
+}
+} // namespace
+
+void AttributeFilter::Record::setRegex(const std::string& regexStr)
+{
+    regex = std::regex(regexStr);
+
+    std::string_view str = regexStr;
+    const bool anyPrefix = str.size() >= 2 && str.substr(0, 2) == ".*";
+    if (anyPrefix)
+        str.remove_prefix(2);
+    const bool anySuffix = str.size() >= 2 && str.substr(str.size() - 2) == ".*";
+    if (anySuffix)
+        str.remove_suffix(2);
+
+    matchType = MatchType::Regex;
+    if (!parseLiteral(str, literal))
+        return;
+
+    if (literal.empty() && (anyPrefix || anySuffix))
+        matchType = MatchType::All;
+    else if (anyPrefix && anySuffix)
+        matchType = MatchType::Contains;
+    else if (anyPrefix)
+        matchType = MatchType::Suffix;
+    else if (anySuffix)
+        matchType = MatchType::Prefix;
+    else
+        matchType = MatchType::Exact;
+}
+
+bool AttributeFilter::Record::match(std::string_view shapeName) const
+{
+    // The wildcard `.` does not match line terminators, leave such names to std::regex.
+    if (matchType != MatchType::Exact && matchType != MatchType::Regex && shapeName.find_first_of("\r\n") != std::string_view::npos)
+        return std::regex_match(shapeName.begin(), shapeName.end(), regex);
+
+    switch (matchType)
+    {
+    case MatchType::All:
+        return true;
+    case MatchType::Exact:
+        return shapeName == literal;
+    case MatchType::Prefix:
+        return shapeName.size() >= literal.size() && shapeName.substr(0, literal.size()) == literal;
+    case MatchType::Suffix:
+        return shapeName.size() >= literal.size() && shapeName.substr(shapeName.size() - literal.size()) == literal;
+    case MatchType::Contains:
+        return shapeName.find(literal) != std::string_view::npos;
+    default:
+        return std::regex_match(shapeName.begin(), shapeName.end(), regex);
+    }
+}
+
+AttributeFilter::AttributeFilter(const AttributeFilter& other)
+{
+    *this = other;
+}
+
+AttributeFilter& AttributeFilter::operator=(const AttributeFilter& other)
+{
+    if (this != &other)
+    {
+        mAttributes = other.mAttributes;
+        updateIndex();
+    }
+    return *this;
+}
+
+void AttributeFilter::add(const nlohmann::json& json)
+{
+    addJson(json);
+    updateIndex();
+}
+
+void AttributeFilter::clear()
+{
+    mAttributes.clear();
+    updateIndex();
+}
+
+void AttributeFilter::updateIndex()
+{
+    mAttributeRecords.clear();
+    for (uint32_t i = (uint32_t)mAttributes.size(); i-- > 0;)
+    {
+        for (auto& attrIt : mAttributes[i].attributes.items())
+            mAttributeRecords[attrIt.key()].push_back(i);
+    }
+
+    std::unique_lock lock(mCacheMutex);
+    mCache.clear();
+}
+
+const nlohmann::json* AttributeFilter::findAttribute(std::string_view shapeName, std::string_view attrName) const
+{
+    // The memo key is the attribute name and shape name separated by a null character.
+    // Reuse a per-thread buffer to avoid allocations on memo hits.
+    thread_local std::string key;
+    key.assign(attrName);
+    key.push_back('\0');
+    key.append(shapeName);
+
+    uint32_t recordIndex = kNoRecord;
+    bool cached = false;
+    {
+        std::shared_lock lock(mCacheMutex);
+        auto it = mCache.find(key);
+        if (it != mCache.end())
+        {
+            recordIndex = it->second;
+            cached = true;
+        }
+    }
+
+    if (cached)
+    {
+        mCacheHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        mCacheMisses.fetch_add(1, std::memory_order_relaxed);
+        auto recordsIt = mAttributeRecords.find(key.substr(0, attrName.size()));
+        if (recordsIt != mAttributeRecords.end())
+        {
+            // The last added filter matching the shape wins, the records are stored in reverse order.
+            for (uint32_t i : recordsIt->second)
+            {
+                if (mAttributes[i].match(shapeName))
+                {
+                    recordIndex = i;
+                    break;
+                }
+            }
+        }
+
+        // Bound the memory used by the memo, scenes can have many more shapes than are queried repeatedly.
+        std::unique_lock lock(mCacheMutex);
+        if (mCache.size() >= kMaxCacheSize)
+            mCache.clear();
+        mCache.emplace(key, recordIndex);
+    }
+
+    if (recordIndex == kNoRecord)
+        return nullptr;
+    return &mAttributes[recordIndex].attributes.find(attrName).value();
+}
+
+nlohmann::json AttributeFilter::getAttributeUncached(std::string_view shapeName, std::string_view attrName) const
+{
+    nlohmann::json attribute = nullptr;
+
+    for (const Record& recordIt : mAttributes)
+    {
+        if (!std::regex_match(shapeName.begin(), shapeName.end(), recordIt.regex))
+            continue;
+        auto attrIt = recordIt.attributes.find(attrName);
+        if (attrIt != recordIt.attributes.end())
+            attribute = attrIt.value();
+    }
+
+    return attribute;
+}
+
 Attributes AttributeFilter::getAttributes(std::string_view shapeName) const
 {
     Attributes result;
     for (const Record& recordIt : mAttributes)
     {
-        if (!std::regex_match(shapeName.begin(), shapeName.end(), recordIt.regex))
+        if (!recordIt.match(shapeName))
             continue;
 
         result.addDict(recordIt.attributes);
@@ -86,7 +278,7 @@ void AttributeFilter::addDictionary(const nlohmann::json& dict)
     std::string regexStr = ".*";
     if (regexIt != dict.end())
         regexStr = regexIt.value().get<std::string>();
-    record.regex = std::regex(regexStr);
+    record.setRegex(regexStr);
 
     nlohmann::json allFlattened;
     if (attrIt != dict.end())
@@ -110,7 +302,7 @@ nlohmann::json AttributeFilter::processDeprecatedFilters(std::string_view name,
     {
         const std::string& filterKey = filterIt.key();
         size_t pos = filterKey.find(".filter");
-        if (pos != filterKey.size() - 7)
+        if (pos == std::string::npos || pos != filterKey.size() - 7)
             continue;
 
         std::string attrKey = filterKey.substr(0, pos);
@@ -148,7 +340,7 @@ nlohmann::json AttributeFilter::processDeprecatedFilters(std::string_view name,
             {
                 Record filteredRecord;
                 filteredRecord.name = fmt::format("{}_{}", name, filterKey);
-                filteredRecord.regex = std::regex(filterRegexStr);
+                filteredRecord.setRegex(filterRegexStr);
                 filteredRecord.attributes = nlohmann::json::object();
                 filteredRecord.attributes[attrIT.key()] = attrIT.value();
                 mAttributes.push_back(std::move(filteredRecord));
@@ -157,13 +349,13 @@ nlohmann::json AttributeFilter::processDeprecatedFilters(std::string_view name,
             {
                 Record filteredRecord;
                 filteredRecord.name = fmt::format("{}_{}_apply", name, filterKey);
-                filteredRecord.regex = std::regex(".*");
+                filteredRecord.setRegex(".*");
                 filteredRecord.attributes = nlohmann::json::object();
                 filteredRecord.attributes[attrIT.key()] = attrIT.value();
                 mAttributes.push_back(std::move(filteredRecord));
 
                 filteredRecord.name = fmt::format("{}_{}_unapply", name, filterKey);
-                filteredRecord.regex = std::regex(filterRegexStr);
+                filteredRecord.setRegex(filterRegexStr);
                 filteredRecord.attributes = nlohmann::json::object();
                 filteredRecord.attributes[attrIT.key()] = nullptr;
                 mAttributes.push_back(std::move(filteredRecord));
@@ -35,8 +35,13 @@
 #include <type_traits>
 #include <optional>
 #include <regex>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
@@ -52,37 +57,64 @@ namespace Falcor
 namespace settings
 {
 
-class AttributeFilter
+/**
+ * Applies attributes to shapes based on their names.
+ *
+ * Each filter consists of a regex over the shape name and a set of attributes. Filters are applied
+ * in the order in which they were added, later filters overriding earlier ones.
+ *
+ * The regexes are compiled once when added. Common patterns (match all, exact name, prefix, suffix
+ * and substring) are matched without std::regex. Attribute lookups only visit the filters setting
+ * the requested attribute, starting from the last added one, and are memoized per shape name and
+ * attribute name, so repeated queries during scene import are a single hash map lookup. The memo is
+ * cleared when filters change and when it reaches kMaxCacheSize entries.
+ * Lookups are thread safe, adding or clearing filters is not.
+ */
+class FALCOR_API AttributeFilter
 {
     struct Record
     {
+        /// Type of the regex, simple patterns are matched without std::regex.
+        enum class MatchType
+        {
+            All,      ///< ".*"
+            Exact,    ///< "literal"
+            Prefix,   ///< "literal.*"
+            Suffix,   ///< ".*literal"
+            Contains, ///< ".*literal.*"
+            Regex,    ///< Anything else.
+        };
+
         std::string name;
         std::regex regex;
+        MatchType matchType = MatchType::Regex;
+        std::string literal;
         nlohmann::json attributes;
+
+        void setRegex(const std::string& regexStr);
+        bool match(std::string_view shapeName) const;
     };
 
 public:
-    void add(const nlohmann::json& json) { addJson(json); }
-    void clear() { mAttributes.clear(); }
+    /// Maximum number of memoized lookups. The memo is cleared when it is full.
+    static constexpr size_t kMaxCacheSize = 1 << 18;
+
+    AttributeFilter() = default;
+    AttributeFilter(const AttributeFilter& other);
+    AttributeFilter& operator=(const AttributeFilter& other);
+
+    void add(const nlohmann::json& json);
+    void clear();
 
     Attributes getAttributes(std::string_view shapeName_) const;
 
     template<typename T>
     std::optional<T> getAttribute(std::string_view shapeName, std::string_view attrName) const
     {
-        nlohmann::json attribute = nullptr;
-
-        for (const Record& recordIt : mAttributes)
-        {
-            if (!std::regex_match(shapeName.begin(), shapeName.end(), recordIt.regex))
-                continue;
-            auto attrIt = recordIt.attributes.find(attrName);
-            if (attrIt != recordIt.attributes.end())
-                attribute = attrIt.value();
-        }
-
-        if (attribute.is_null())
+        const nlohmann::json* pAttribute = findAttribute(shapeName, attrName);
+        if (!pAttribute || pAttribute->is_null())
             return {};
+        const nlohmann::json& attribute = *pAttribute;
 
         if (!detail::TypeChecker<T>::validType(attribute))
             throw detail::TypeError("Attribute's type does not match the requested type.");
@@ -104,17 +136,38 @@ public:
     }
 
 private:
+    friend struct AttributeFilterTest;
+
     void addJson(const nlohmann::json& json);
     void addArray(const nlohmann::json& array);
     void addDictionary(const nlohmann::json& dict);
 
+    /// Rebuild the attribute name index and clear the lookup memo.
+    void updateIndex();
+
+    /// Find the value of an attribute for a shape. Returns nullptr if no filter sets the attribute.
+    const nlohmann::json* findAttribute(std::string_view shapeName, std::string_view attrName) const;
+
+    /// Reference implementation of the attribute lookup, matching all filters with std::regex. Used for testing.
+    nlohmann::json getAttributeUncached(std::string_view shapeName, std::string_view attrName) const;
+
 private:
     /// Filters out all attributes using the deprecated `name.filter` syntax,
     /// processes into filters, and returns the remaining attributes
     nlohmann::json processDeprecatedFilters(std::string_view name, nlohmann::json flattened, const std::string& regexStr);
 
 private:
+    static constexpr uint32_t kNoRecord = uint32_t(-1);
+
     std::vector<Record> mAttributes;
+    /// Indices of the records setting each attribute, in reverse order (last added first).
+    std::unordered_map<std::string, std::vector<uint32_t>> mAttributeRecords;
+
+    /// Memoized lookups. Maps attribute name and shape name to the index of the record providing the value.
+    mutable std::shared_mutex mCacheMutex;
+    mutable std::unordered_map<std::string, uint32_t> mCache;
+    mutable std::atomic<uint64_t> mCacheHits{0};   ///< Number of lookups answered by the memo.
+    mutable std::atomic<uint64_t> mCacheMisses{0}; ///< Number of lookups that matched the filters.
 };
 
 } // namespace settings
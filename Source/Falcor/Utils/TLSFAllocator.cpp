@@ -0,0 +1,371 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "TLSFAllocator.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Math/Common.h"
+
+#include <algorithm>
+
+namespace Falcor
+{
+namespace
+{
+/// Index of the most significant set bit. Value must be non-zero.
+uint32_t msb64(uint64_t value)
+{
+    uint32_t hi = (uint32_t)(value >> 32);
+    return hi ? 32 + bitScanReverse(hi) : bitScanReverse((uint32_t)value);
+}
+
+/// Index of the least significant set bit. Value must be non-zero.
+uint32_t lsb64(uint64_t value)
+{
+    uint32_t lo = (uint32_t)value;
+    return lo ? bitScanForward(lo) : 32 + bitScanForward((uint32_t)(value >> 32));
+}
+} // namespace
+
+TLSFAllocator::TLSFAllocator(uint64_t capacity)
+{
+    FALCOR_CHECK(capacity > 0, "'capacity' must be larger than zero.");
+    for (auto& lists : mFreeLists)
+        std::fill(std::begin(lists), std::end(lists), kInvalidIndex);
+
+    mStats.capacity = capacity;
+    mStats.freeSize = capacity;
+    uint32_t index = createBlock(0, capacity);
+    insertFreeBlock(index);
+}
+
+TLSFAllocator::Allocation TLSFAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+    FALCOR_CHECK(size > 0, "'size' must be larger than zero.");
+    FALCOR_CHECK(alignment > 0 && (alignment & (alignment - 1)) == 0, "'alignment' must be a power of two.");
+
+    // Search for a block that fits the allocation at any offset alignment.
+    uint64_t searchSize = size + alignment - 1;
+    if (searchSize < size || searchSize > mStats.capacity)
+        return {};
+    uint32_t index = findFreeBlock(searchSize);
+    if (index == kInvalidIndex)
+        return {};
+    removeFreeBlock(index);
+
+    // Return the padding in front of the aligned offset to the free lists.
+    uint64_t padding = align_to(alignment, mBlocks[index].offset) - mBlocks[index].offset;
+    if (padding > 0)
+    {
+        uint32_t paddingIndex = index;
+        index = splitBlock(paddingIndex, padding);
+        insertFreeBlock(paddingIndex);
+    }
+
+    // Return the tail to the free lists.
+    if (mBlocks[index].size > size)
+    {
+        uint32_t tail = splitBlock(index, size);
+        insertFreeBlock(tail);
+    }
+
+    Block& block = mBlocks[index];
+    block.isFree = false;
+    mStats.usedSize += block.size;
+    mStats.freeSize -= block.size;
+    mStats.allocationCount++;
+
+    Allocation allocation;
+    allocation.offset = block.offset;
+    allocation.size = size;
+    allocation.blockIndex = index;
+    return allocation;
+}
+
+void TLSFAllocator::free(const Allocation& allocation)
+{
+    if (!allocation.isValid())
+        return;
+
+    uint32_t index = allocation.blockIndex;
+    FALCOR_CHECK(
+        index < mBlocks.size() && mBlocks[index].isUsed && !mBlocks[index].isFree && mBlocks[index].offset == allocation.offset,
+        "Invalid allocation (offset {}).",
+        allocation.offset
+    );
+
+    mStats.usedSize -= mBlocks[index].size;
+    mStats.freeSize += mBlocks[index].size;
+    mStats.allocationCount--;
+    mBlocks[index].isFree = true;
+
+    // Merge with free neighbors.
+    uint32_t next = mBlocks[index].nextPhys;
+    if (next != kInvalidIndex && mBlocks[next].isFree)
+    {
+        removeFreeBlock(next);
+        mergeWithNext(index);
+    }
+    uint32_t prev = mBlocks[index].prevPhys;
+    if (prev != kInvalidIndex && mBlocks[prev].isFree)
+    {
+        removeFreeBlock(prev);
+        mergeWithNext(prev);
+        index = prev;
+    }
+
+    insertFreeBlock(index);
+}
+
+TLSFAllocator::Stats TLSFAllocator::getStats() const
+{
+    Stats stats = mStats;
+    stats.freeBlockCount = 0;
+    stats.largestFreeBlock = 0;
+    for (uint32_t fl = 0; fl < kFLCount; ++fl)
+    {
+        for (uint32_t sl = 0; sl < kSLCount; ++sl)
+        {
+            for (uint32_t index = mFreeLists[fl][sl]; index != kInvalidIndex; index = mBlocks[index].nextFree)
+            {
+                stats.freeBlockCount++;
+                stats.largestFreeBlock = std::max(stats.largestFreeBlock, mBlocks[index].size);
+            }
+        }
+    }
+    return stats;
+}
+
+bool TLSFAllocator::validate() const
+{
+    // Walk the physical blocks starting at offset 0.
+    uint32_t first = kInvalidIndex;
+    for (uint32_t i = 0; i < mBlocks.size(); ++i)
+    {
+        if (mBlocks[i].isUsed && mBlocks[i].prevPhys == kInvalidIndex)
+        {
+            if (first != kInvalidIndex)
+                return false;
+            first = i;
+        }
+    }
+    if (first == kInvalidIndex || mBlocks[first].offset != 0)
+        return false;
+
+    uint64_t offset = 0;
+    uint64_t usedSize = 0;
+    uint32_t allocationCount = 0;
+    uint32_t freeBlockCount = 0;
+    uint32_t prev = kInvalidIndex;
+    for (uint32_t index = first; index != kInvalidIndex; index = mBlocks[index].nextPhys)
+    {
+        const Block& block = mBlocks[index];
+        if (!block.isUsed || block.offset != offset || block.size == 0 || block.prevPhys != prev)
+            return false;
+        if (block.isFree)
+        {
+            if (prev != kInvalidIndex && mBlocks[prev].isFree)
+                return false;
+            freeBlockCount++;
+        }
+        else
+        {
+            usedSize += block.size;
+            allocationCount++;
+        }
+        offset += block.size;
+        prev = index;
+    }
+    if (offset != mStats.capacity || usedSize != mStats.usedSize || allocationCount != mStats.allocationCount)
+        return false;
+
+    // Check that the free lists hold exactly the free blocks in the correct size class.
+    uint32_t listedBlockCount = 0;
+    for (uint32_t fl = 0; fl < kFLCount; ++fl)
+    {
+        bool flBit = (mFLBitmap >> fl) & 1;
+        if (flBit != (mSLBitmaps[fl] != 0))
+            return false;
+        for (uint32_t sl = 0; sl < kSLCount; ++sl)
+        {
+            bool slBit = (mSLBitmaps[fl] >> sl) & 1;
+            if (slBit != (mFreeLists[fl][sl] != kInvalidIndex))
+                return false;
+            uint32_t prevFree = kInvalidIndex;
+            for (uint32_t index = mFreeLists[fl][sl]; index != kInvalidIndex; index = mBlocks[index].nextFree)
+            {
+                const Block& block = mBlocks[index];
+                uint32_t blockFL, blockSL;
+                mapping(block.size, blockFL, blockSL);
+                if (!block.isUsed || !block.isFree || block.prevFree != prevFree || blockFL != fl || blockSL != sl)
+                    return false;
+                listedBlockCount++;
+                prevFree = index;
+            }
+        }
+    }
+    return listedBlockCount == freeBlockCount;
+}
+
+void TLSFAllocator::mapping(uint64_t size, uint32_t& fl, uint32_t& sl)
+{
+    FALCOR_ASSERT(size > 0);
+    if (size < kSLCount)
+    {
+        // Small sizes are mapped linearly to the first level.
+        fl = 0;
+        sl = (uint32_t)size;
+    }
+    else
+    {
+        uint32_t msb = msb64(size);
+        fl = msb - kSLBits + 1;
+        sl = (uint32_t)(size >> (msb - kSLBits)) ^ kSLCount;
+    }
+}
+
+uint32_t TLSFAllocator::findFreeBlock(uint64_t size) const
+{
+    // Round up to the next size class so that any block in the found list is large enough.
+    if (size >= kSLCount)
+    {
+        uint64_t roundedSize = size + (1ull << (msb64(size) - kSLBits)) - 1;
+        if (roundedSize < size)
+            return kInvalidIndex;
+        size = roundedSize;
+    }
+
+    uint32_t fl, sl;
+    mapping(size, fl, sl);
+
+    uint32_t slMap = mSLBitmaps[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        uint64_t flMap = fl + 1 < 64 ? mFLBitmap & (~0ull << (fl + 1)) : 0;
+        if (flMap == 0)
+            return kInvalidIndex;
+        fl = lsb64(flMap);
+        slMap = mSLBitmaps[fl];
+        FALCOR_ASSERT(slMap != 0);
+    }
+    sl = bitScanForward(slMap);
+    return mFreeLists[fl][sl];
+}
+
+void TLSFAllocator::insertFreeBlock(uint32_t index)
+{
+    Block& block = mBlocks[index];
+    uint32_t fl, sl;
+    mapping(block.size, fl, sl);
+
+    block.isFree = true;
+    block.prevFree = kInvalidIndex;
+    block.nextFree = mFreeLists[fl][sl];
+    if (block.nextFree != kInvalidIndex)
+        mBlocks[block.nextFree].prevFree = index;
+    mFreeLists[fl][sl] = index;
+    mFLBitmap |= 1ull << fl;
+    mSLBitmaps[fl] |= 1u << sl;
+}
+
+void TLSFAllocator::removeFreeBlock(uint32_t index)
+{
+    Block& block = mBlocks[index];
+    uint32_t fl, sl;
+    mapping(block.size, fl, sl);
+
+    if (block.prevFree != kInvalidIndex)
+        mBlocks[block.prevFree].nextFree = block.nextFree;
+    else
+        mFreeLists[fl][sl] = block.nextFree;
+    if (block.nextFree != kInvalidIndex)
+        mBlocks[block.nextFree].prevFree = block.prevFree;
+    block.prevFree = block.nextFree = kInvalidIndex;
+
+    if (mFreeLists[fl][sl] == kInvalidIndex)
+    {
+        mSLBitmaps[fl] &= ~(1u << sl);
+        if (mSLBitmaps[fl] == 0)
+            mFLBitmap &= ~(1ull << fl);
+    }
+}
+
+uint32_t TLSFAllocator::createBlock(uint64_t offset, uint64_t size)
+{
+    uint32_t index;
+    if (mUnusedBlocks != kInvalidIndex)
+    {
+        index = mUnusedBlocks;
+        mUnusedBlocks = mBlocks[index].nextFree;
+    }
+    else
+    {
+        index = (uint32_t)mBlocks.size();
+        mBlocks.emplace_back();
+    }
+
+    Block& block = mBlocks[index];
+    block = Block();
+    block.offset = offset;
+    block.size = size;
+    block.isUsed = true;
+    return index;
+}
+
+void TLSFAllocator::destroyBlock(uint32_t index)
+{
+    mBlocks[index] = Block();
+    mBlocks[index].nextFree = mUnusedBlocks;
+    mUnusedBlocks = index;
+}
+
+uint32_t TLSFAllocator::splitBlock(uint32_t index, uint64_t size)
+{
+    FALCOR_ASSERT(size > 0 && size < mBlocks[index].size);
+    uint32_t tail = createBlock(mBlocks[index].offset + size, mBlocks[index].size - size);
+
+    // Note: createBlock() may reallocate the block array, access blocks by index only.
+    mBlocks[tail].prevPhys = index;
+    mBlocks[tail].nextPhys = mBlocks[index].nextPhys;
+    if (mBlocks[tail].nextPhys != kInvalidIndex)
+        mBlocks[mBlocks[tail].nextPhys].prevPhys = tail;
+    mBlocks[index].nextPhys = tail;
+    mBlocks[index].size = size;
+    return tail;
+}
+
+void TLSFAllocator::mergeWithNext(uint32_t index)
+{
+    uint32_t next = mBlocks[index].nextPhys;
+    FALCOR_ASSERT(next != kInvalidIndex);
+    mBlocks[index].size += mBlocks[next].size;
+    mBlocks[index].nextPhys = mBlocks[next].nextPhys;
+    if (mBlocks[index].nextPhys != kInvalidIndex)
+        mBlocks[mBlocks[index].nextPhys].prevPhys = index;
+    destroyBlock(next);
+}
+} // namespace Falcor
@@ -0,0 +1,143 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Two-level segregated fit (TLSF) allocator for a range of offsets.
+ *
+ * Manages the address range [0, capacity) of some external memory (e.g. a GPU buffer) without
+ * touching the memory itself. Free blocks are kept in segregated lists indexed by a first level
+ * (power of two) and a second level (linear subdivision of the power of two). Two bitmaps allow
+ * finding a suitable free block in constant time, and freed blocks are merged with their physical
+ * neighbors immediately, so allocate() and free() run in O(1) independent of the number of blocks.
+ *
+ * The allocator does not depend on a device and is used as the core of BufferSuballocator.
+ */
+class FALCOR_API TLSFAllocator
+{
+public:
+    static constexpr uint64_t kInvalidOffset = std::numeric_limits<uint64_t>::max();
+
+    struct Allocation
+    {
+        uint64_t offset = kInvalidOffset; ///< Offset of the allocation.
+        uint64_t size = 0;                ///< Size of the allocation as requested.
+        uint32_t blockIndex = 0;          ///< Internal block index.
+
+        bool isValid() const { return offset != kInvalidOffset; }
+    };
+
+    struct Stats
+    {
+        uint64_t capacity = 0;         ///< Size of the managed range.
+        uint64_t usedSize = 0;         ///< Total size of allocated blocks (including alignment padding).
+        uint64_t freeSize = 0;         ///< Total size of free blocks.
+        uint64_t largestFreeBlock = 0; ///< Size of the largest free block.
+        uint32_t allocationCount = 0;  ///< Number of allocations.
+        uint32_t freeBlockCount = 0;   ///< Number of free blocks.
+
+        /// Fragmentation of the free space in [0, 1]. 0 if all free space is in a single block.
+        double getFragmentation() const { return freeSize > 0 ? 1.0 - (double)largestFreeBlock / freeSize : 0.0; }
+    };
+
+    /**
+     * Create an allocator.
+     * @param[in] capacity Size of the managed range.
+     */
+    TLSFAllocator(uint64_t capacity);
+
+    /**
+     * Allocate a range.
+     * @param[in] size Size of the range. Must be larger than zero.
+     * @param[in] alignment Alignment of the offset. Must be a power of two.
+     * @return The allocation, or an invalid allocation if there is no free block large enough.
+     */
+    Allocation allocate(uint64_t size, uint64_t alignment = 1);
+
+    /**
+     * Free an allocation. The range is merged with adjacent free ranges.
+     * @param[in] allocation Allocation returned by allocate(). Invalid allocations are ignored.
+     */
+    void free(const Allocation& allocation);
+
+    /// Returns true if there are no allocations.
+    bool empty() const { return mStats.allocationCount == 0; }
+
+    uint64_t getCapacity() const { return mStats.capacity; }
+
+    /// Get usage statistics. The largest free block is computed on demand.
+    Stats getStats() const;
+
+    /**
+     * Check the internal consistency of the allocator. Used for testing.
+     * @return True if all blocks tile the range, no two free blocks are adjacent and the free lists and bitmaps match.
+     */
+    bool validate() const;
+
+private:
+    static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+    static constexpr uint32_t kSLBits = 4;
+    static constexpr uint32_t kSLCount = 1u << kSLBits;
+    static constexpr uint32_t kFLCount = 64 - kSLBits + 1;
+
+    struct Block
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint32_t prevPhys = kInvalidIndex;
+        uint32_t nextPhys = kInvalidIndex;
+        uint32_t prevFree = kInvalidIndex; ///< Previous block in the free list. Also links unused block records.
+        uint32_t nextFree = kInvalidIndex; ///< Next block in the free list. Also links unused block records.
+        bool isFree = false;
+        bool isUsed = false; ///< True if the block record is part of the range.
+    };
+
+    static void mapping(uint64_t size, uint32_t& fl, uint32_t& sl);
+    uint32_t findFreeBlock(uint64_t size) const;
+    void insertFreeBlock(uint32_t index);
+    void removeFreeBlock(uint32_t index);
+    uint32_t createBlock(uint64_t offset, uint64_t size);
+    void destroyBlock(uint32_t index);
+    uint32_t splitBlock(uint32_t index, uint64_t size);
+    void mergeWithNext(uint32_t index);
+
+    std::vector<Block> mBlocks;
+    uint32_t mUnusedBlocks = kInvalidIndex;
+    uint64_t mFLBitmap = 0;
+    uint32_t mSLBitmaps[kFLCount] = {};
+    uint32_t mFreeLists[kFLCount][kSLCount];
+    Stats mStats;
+};
+} // namespace Falcor
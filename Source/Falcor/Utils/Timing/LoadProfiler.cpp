@@ -0,0 +1,408 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "LoadProfiler.h"
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Utils/Logger.h"
+#include "Utils/StringUtils.h"
+#include "Utils/StringFormatters.h"
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+nlohmann::json phaseToJson(const std::vector<LoadProfiler::Phase>& phases, uint32_t index)
+{
+    const auto& phase = phases[index];
+    nlohmann::json json;
+    json["name"] = phase.name;
+    json["itemPhase"] = phase.isItemPhase;
+    json["calls"] = phase.callCount;
+    json["wallTime"] = phase.wallTime;
+    json["cpuTime"] = phase.cpuTime;
+    json["startRSS"] = phase.startRSS;
+    json["endRSS"] = phase.endRSS;
+    json["peakRSS"] = phase.peakRSS;
+    json["counters"] = nlohmann::json::object();
+    for (const auto& [name, value] : phase.counters)
+        json["counters"][name] = value;
+    json["children"] = nlohmann::json::array();
+    for (uint32_t child : phase.children)
+        json["children"].push_back(phaseToJson(phases, child));
+    return json;
+}
+} // namespace
+
+/// Per-item phase statistics accumulated by one thread.
+struct LoadProfiler::ThreadData
+{
+    struct ItemStats
+    {
+        uint64_t callCount = 0;
+        double wallTime = 0.0;
+    };
+
+    std::mutex mutex; ///< Only contended while the phases are collected.
+    std::vector<ItemStats> items; ///< Stats indexed by phase index.
+};
+
+struct LoadProfiler::ThreadState
+{
+    uint64_t generation = 0;
+    std::vector<uint32_t> stack;                                      ///< Open phases of the thread.
+    std::vector<std::vector<std::pair<std::string, uint32_t>>> children; ///< Cached child phase indices per parent phase.
+    std::shared_ptr<ThreadData> pData;
+};
+
+LoadProfiler& LoadProfiler::instance()
+{
+    static LoadProfiler sInstance;
+    return sInstance;
+}
+
+LoadProfiler::LoadProfiler()
+{
+    reset();
+}
+
+void LoadProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    FALCOR_CHECK(mMainStack.empty(), "Cannot reset the load profiler while phases are open.");
+    mPhases.clear();
+    mPhases.push_back(Phase{"Total"});
+    mMainParent = 0;
+    mMainThread = std::this_thread::get_id();
+    mThreadData.clear();
+    mGeneration++;
+}
+
+void LoadProfiler::setMainThread()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    FALCOR_CHECK(mMainStack.empty(), "Cannot change the main thread while phases are open.");
+    mMainThread = std::this_thread::get_id();
+}
+
+LoadProfiler::ThreadState& LoadProfiler::getThreadState()
+{
+    thread_local ThreadState sState;
+    if (sState.generation != mGeneration)
+    {
+        sState.generation = mGeneration;
+        sState.stack.clear();
+        sState.children.clear();
+        sState.pData.reset();
+    }
+    return sState;
+}
+
+uint32_t LoadProfiler::findOrAddChild(uint32_t parent, std::string_view name, bool isItemPhase)
+{
+    FALCOR_ASSERT(parent < mPhases.size());
+    // Regular and per-item phases record different statistics, keep them apart even if they share a name.
+    for (uint32_t child : mPhases[parent].children)
+    {
+        if (mPhases[child].name == name && mPhases[child].isItemPhase == isItemPhase)
+            return child;
+    }
+    uint32_t index = (uint32_t)mPhases.size();
+    Phase phase;
+    phase.name = name;
+    phase.parent = parent;
+    phase.isItemPhase = isItemPhase;
+    mPhases.push_back(std::move(phase));
+    mPhases[parent].children.push_back(index);
+    return index;
+}
+
+uint32_t LoadProfiler::beginPhase(std::string_view name)
+{
+    if (!mEnabled)
+        return kInvalidIndex;
+
+    // Query memory usage outside of the lock.
+    uint64_t rss = getCurrentRSS();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto& threadStack = getThreadState();
+    const bool isMainThread = mMainThread == std::this_thread::get_id();
+
+    uint32_t parent = 0;
+    if (!threadStack.stack.empty())
+        parent = threadStack.stack.back();
+    else if (!mMainStack.empty())
+        parent = mMainStack.back();
+
+    uint32_t index = findOrAddChild(parent, name, false);
+    auto& phase = mPhases[index];
+    if (phase.callCount == 0)
+        phase.startRSS = rss;
+    phase.callCount++;
+
+    threadStack.stack.push_back(index);
+    if (isMainThread)
+    {
+        mMainStack.push_back(index);
+        mMainParent = index;
+    }
+
+    return index;
+}
+
+void LoadProfiler::endPhase(uint32_t index, CpuTimer::TimePoint startTime, double startCpuTime)
+{
+    if (index == kInvalidIndex)
+        return;
+
+    double wallTime = std::chrono::duration<double>(CpuTimer::getCurrentTimePoint() - startTime).count();
+    double cpuTime = getProcessCpuTime() - startCpuTime;
+    uint64_t rss = getCurrentRSS();
+    uint64_t peakRSS = getPeakRSS();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto& threadStack = getThreadState();
+    if (threadStack.stack.empty())
+        return; // Profiler was reset while the phase was open.
+
+    FALCOR_ASSERT(threadStack.stack.back() == index);
+    threadStack.stack.pop_back();
+    if (std::this_thread::get_id() == mMainThread && !mMainStack.empty())
+    {
+        FALCOR_ASSERT(mMainStack.back() == index);
+        mMainStack.pop_back();
+        mMainParent = mMainStack.empty() ? 0 : mMainStack.back();
+    }
+
+    auto& phase = mPhases[index];
+    phase.wallTime += wallTime;
+    phase.cpuTime += cpuTime;
+    phase.endRSS = rss;
+    phase.peakRSS = std::max(phase.peakRSS, peakRSS);
+}
+
+uint32_t LoadProfiler::beginItemPhase(std::string_view name)
+{
+    if (!mEnabled)
+        return kInvalidIndex;
+
+    auto& state = getThreadState();
+    uint32_t parent = !state.stack.empty() ? state.stack.back() : mMainParent.load();
+
+    // Look up the phase in the per-thread cache first to avoid taking the lock.
+    if (parent >= state.children.size())
+        state.children.resize(parent + 1);
+    auto& children = state.children[parent];
+    auto it = std::find_if(children.begin(), children.end(), [&](const auto& child) { return child.first == name; });
+    uint32_t index = kInvalidIndex;
+    if (it != children.end())
+    {
+        index = it->second;
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        index = findOrAddChild(parent, name, true);
+        children.emplace_back(std::string(name), index);
+    }
+
+    state.stack.push_back(index);
+    return index;
+}
+
+void LoadProfiler::endItemPhase(uint32_t index, CpuTimer::TimePoint startTime)
+{
+    if (index == kInvalidIndex)
+        return;
+
+    double wallTime = std::chrono::duration<double>(CpuTimer::getCurrentTimePoint() - startTime).count();
+
+    auto& state = getThreadState();
+    if (state.stack.empty())
+        return; // Profiler was reset while the phase was open.
+
+    FALCOR_ASSERT(state.stack.back() == index);
+    state.stack.pop_back();
+
+    if (!state.pData)
+    {
+        state.pData = std::make_shared<ThreadData>();
+        std::lock_guard<std::mutex> lock(mMutex);
+        mThreadData.push_back(state.pData);
+    }
+
+    std::lock_guard<std::mutex> lock(state.pData->mutex);
+    auto& items = state.pData->items;
+    if (index >= items.size())
+        items.resize(index + 1);
+    items[index].callCount++;
+    items[index].wallTime += wallTime;
+}
+
+void LoadProfiler::addCount(std::string_view name, uint64_t count)
+{
+    if (!mEnabled)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    uint32_t index = 0;
+    const auto& threadStack = getThreadState();
+    if (!threadStack.stack.empty())
+        index = threadStack.stack.back();
+    else if (!mMainStack.empty())
+        index = mMainStack.back();
+
+    mPhases[index].counters[std::string(name)] += count;
+}
+
+void LoadProfiler::addCount(uint32_t index, std::string_view name, uint64_t count)
+{
+    if (index == kInvalidIndex)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (index < mPhases.size())
+        mPhases[index].counters[std::string(name)] += count;
+}
+
+std::vector<LoadProfiler::Phase> LoadProfiler::getPhases() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<Phase> phases = mPhases;
+
+    // Merge the per-item phases accumulated by each thread.
+    for (const auto& pData : mThreadData)
+    {
+        std::lock_guard<std::mutex> dataLock(pData->mutex);
+        for (size_t i = 0; i < pData->items.size() && i < phases.size(); ++i)
+        {
+            phases[i].callCount += pData->items[i].callCount;
+            phases[i].wallTime += pData->items[i].wallTime;
+        }
+    }
+
+    return phases;
+}
+
+void LoadProfiler::printToLog() const
+{
+    auto phases = getPhases();
+
+    auto printPhase = [&](auto&& self, uint32_t index, uint32_t depth) -> void
+    {
+        const auto& phase = phases[index];
+        std::string line = padStringToLength(std::string(depth * 2, ' ') + phase.name + ":", 40);
+        if (phase.isItemPhase)
+            line += fmt::format(" {:.3f} s wall (summed over threads)", phase.wallTime);
+        else
+            line += fmt::format(" {:.3f} s wall, {:.3f} s cpu", phase.wallTime, phase.cpuTime);
+        if (phase.callCount > 1)
+            line += fmt::format(", {} calls", phase.callCount);
+        if (phase.peakRSS > 0)
+            line += fmt::format(", peak RSS {}", formatByteSize(phase.peakRSS));
+        for (const auto& [name, value] : phase.counters)
+            line += fmt::format(", {} {}", value, name);
+        logInfo(line);
+
+        for (uint32_t child : phase.children)
+            self(self, child, depth + 1);
+    };
+
+    for (uint32_t child : phases[0].children)
+        printPhase(printPhase, child, 0);
+}
+
+std::string LoadProfiler::toJsonString() const
+{
+    auto phases = getPhases();
+
+    // The root phase only groups the top-level phases, report the accumulated times.
+    auto& root = phases[0];
+    root.callCount = 1;
+    for (uint32_t child : root.children)
+    {
+        root.wallTime += phases[child].wallTime;
+        root.cpuTime += phases[child].cpuTime;
+        root.peakRSS = std::max(root.peakRSS, phases[child].peakRSS);
+    }
+
+    return phaseToJson(phases, 0).dump(4);
+}
+
+void LoadProfiler::writeJson(const std::filesystem::path& path) const
+{
+    std::ofstream ofs(path);
+    if (!ofs.good())
+        FALCOR_THROW("Failed to open '{}' for writing.", path);
+    ofs << toJsonString();
+    logInfo("Wrote load profile to '{}'.", path);
+}
+
+ScopedLoadPhase::ScopedLoadPhase(std::string_view name)
+{
+    auto& profiler = LoadProfiler::instance();
+    if (!profiler.isEnabled())
+        return;
+    mIndex = profiler.beginPhase(name);
+    mStartCpuTime = getProcessCpuTime();
+    mStartTime = CpuTimer::getCurrentTimePoint();
+}
+
+ScopedLoadPhase::~ScopedLoadPhase()
+{
+    LoadProfiler::instance().endPhase(mIndex, mStartTime, mStartCpuTime);
+}
+
+void ScopedLoadPhase::addCount(std::string_view name, uint64_t count)
+{
+    LoadProfiler::instance().addCount(mIndex, name, count);
+}
+
+ScopedLoadItemPhase::ScopedLoadItemPhase(std::string_view name)
+{
+    auto& profiler = LoadProfiler::instance();
+    if (!profiler.isEnabled())
+        return;
+    mIndex = profiler.beginItemPhase(name);
+    mStartTime = CpuTimer::getCurrentTimePoint();
+}
+
+ScopedLoadItemPhase::~ScopedLoadItemPhase()
+{
+    LoadProfiler::instance().endItemPhase(mIndex, mStartTime);
+}
+} // namespace Falcor
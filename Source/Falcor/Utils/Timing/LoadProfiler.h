@@ -0,0 +1,214 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "CpuTimer.h"
+#include "Core/Macros.h"
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+/**
+ * Hierarchical instrumentation of long running load tasks (scene import, scene building, etc.).
+ *
+ * Phases are opened and closed with ScopedLoadPhase (or the FALCOR_LOAD_PHASE macro) and form a tree
+ * based on the nesting of the calls. Each phase records wall time, process CPU time, the resident set
+ * size at the start/end of the phase and the peak resident set size observed when the phase ended.
+ * Item counters (number of meshes, triangles, textures etc.) can be attached to the innermost open phase.
+ *
+ * Phases with the same name and the same parent are merged. This is used for phases that are entered
+ * many times (e.g. once per mesh), possibly from multiple threads. In that case the call count is
+ * recorded and the times are summed. Phases opened on a worker thread without an open phase of
+ * their own are parented to the innermost phase open on the main thread. The main thread is the
+ * thread that created the profiler or last called reset() or setMainThread().
+ *
+ * Phases entered per item (ScopedLoadItemPhase or the FALCOR_LOAD_ITEM_PHASE macro) only record wall
+ * time and call count. They are accumulated per thread without taking the global lock and without
+ * querying process CPU time or memory usage, so they are cheap enough for parallel per-mesh loops.
+ *
+ * The collected data can be printed to the log or exported as JSON.
+ */
+class FALCOR_API LoadProfiler
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        uint32_t parent = kInvalidIndex;
+        std::vector<uint32_t> children;
+
+        bool isItemPhase = false;    ///< True for per-item phases, which only record wall time and call count.
+        uint64_t callCount = 0;      ///< Number of times the phase was entered.
+        double wallTime = 0.0;       ///< Accumulated wall time in seconds.
+        double cpuTime = 0.0;        ///< Accumulated process CPU time in seconds (all threads).
+        uint64_t startRSS = 0;       ///< Resident set size in bytes when the phase was first entered.
+        uint64_t endRSS = 0;         ///< Resident set size in bytes when the phase was last exited.
+        uint64_t peakRSS = 0;        ///< Process peak resident set size in bytes when the phase was last exited.
+        std::map<std::string, uint64_t> counters; ///< Item counters.
+    };
+
+    static constexpr uint32_t kInvalidIndex = uint32_t(-1);
+
+    /// Get the global load profiler.
+    static LoadProfiler& instance();
+
+    /// Enable/disable recording. Recording is enabled by default.
+    void setEnabled(bool enabled) { mEnabled = enabled; }
+    bool isEnabled() const { return mEnabled; }
+
+    /// Clear all recorded phases. The calling thread becomes the main thread.
+    void reset();
+
+    /// Make the calling thread the main thread. Must not be called while phases are open.
+    void setMainThread();
+
+    /**
+     * Open a phase. The phase is nested in the innermost phase open on the calling thread.
+     * @param[in] name Phase name.
+     * @return Phase index to be passed to endPhase().
+     */
+    uint32_t beginPhase(std::string_view name);
+
+    /**
+     * Close a phase previously opened with beginPhase().
+     * @param[in] index Phase index.
+     * @param[in] startTime Wall time when the phase was opened.
+     * @param[in] startCpuTime Process CPU time when the phase was opened.
+     */
+    void endPhase(uint32_t index, CpuTimer::TimePoint startTime, double startCpuTime);
+
+    /**
+     * Open a per-item phase. The phase is nested in the innermost phase open on the calling thread.
+     * A regular phase with the same name under the same parent is kept as a separate phase.
+     * @param[in] name Phase name.
+     * @return Phase index to be passed to endItemPhase().
+     */
+    uint32_t beginItemPhase(std::string_view name);
+
+    /**
+     * Close a phase previously opened with beginItemPhase().
+     * @param[in] index Phase index.
+     * @param[in] startTime Wall time when the phase was opened.
+     */
+    void endItemPhase(uint32_t index, CpuTimer::TimePoint startTime);
+
+    /**
+     * Add to an item counter of the innermost phase open on the calling thread.
+     * @param[in] name Counter name.
+     * @param[in] count Value to add.
+     */
+    void addCount(std::string_view name, uint64_t count);
+
+    /**
+     * Add to an item counter of a specific phase.
+     * @param[in] index Phase index as returned by beginPhase().
+     * @param[in] name Counter name.
+     * @param[in] count Value to add.
+     */
+    void addCount(uint32_t index, std::string_view name, uint64_t count);
+
+    /// Get a copy of all recorded phases. Index 0 is the root phase.
+    std::vector<Phase> getPhases() const;
+
+    /// Print the phase tree to the log.
+    void printToLog() const;
+
+    /// Get the phase tree as JSON formatted string.
+    std::string toJsonString() const;
+
+    /// Write the phase tree as JSON to a file.
+    void writeJson(const std::filesystem::path& path) const;
+
+private:
+    struct ThreadData;
+    struct ThreadState;
+
+    LoadProfiler();
+
+    ThreadState& getThreadState();
+    uint32_t findOrAddChild(uint32_t parent, std::string_view name, bool isItemPhase);
+
+    std::atomic<bool> mEnabled{true};
+    mutable std::mutex mMutex;
+    std::vector<Phase> mPhases;
+    std::vector<uint32_t> mMainStack; ///< Open phases of the main thread.
+    std::atomic<uint32_t> mMainParent{0}; ///< Innermost open phase of the main thread. Used as parent for worker threads.
+    std::thread::id mMainThread;
+    std::vector<std::shared_ptr<ThreadData>> mThreadData; ///< Per-thread accumulated per-item phases.
+    std::atomic<uint64_t> mGeneration{0}; ///< Incremented on reset() to invalidate the per-thread state.
+};
+
+/**
+ * Helper class for recording a load phase for the duration of a scope.
+ */
+class FALCOR_API ScopedLoadPhase
+{
+public:
+    ScopedLoadPhase(std::string_view name);
+    ~ScopedLoadPhase();
+
+    ScopedLoadPhase(const ScopedLoadPhase&) = delete;
+    ScopedLoadPhase& operator=(const ScopedLoadPhase&) = delete;
+
+    /// Add to an item counter of this phase.
+    void addCount(std::string_view name, uint64_t count);
+
+private:
+    uint32_t mIndex = LoadProfiler::kInvalidIndex;
+    CpuTimer::TimePoint mStartTime;
+    double mStartCpuTime = 0.0;
+};
+
+/**
+ * Helper class for recording a per-item load phase for the duration of a scope.
+ * Use this for phases entered many times, e.g. once per mesh or texture.
+ */
+class FALCOR_API ScopedLoadItemPhase
+{
+public:
+    ScopedLoadItemPhase(std::string_view name);
+    ~ScopedLoadItemPhase();
+
+    ScopedLoadItemPhase(const ScopedLoadItemPhase&) = delete;
+    ScopedLoadItemPhase& operator=(const ScopedLoadItemPhase&) = delete;
+
+private:
+    uint32_t mIndex = LoadProfiler::kInvalidIndex;
+    CpuTimer::TimePoint mStartTime;
+};
+} // namespace Falcor
+
+#define FALCOR_LOAD_PHASE(_name) Falcor::ScopedLoadPhase FALCOR_CONCAT_STRINGS(_loadPhase, __LINE__)(_name)
+#define FALCOR_LOAD_ITEM_PHASE(_name) Falcor::ScopedLoadItemPhase FALCOR_CONCAT_STRINGS(_loadItemPhase, __LINE__)(_name)
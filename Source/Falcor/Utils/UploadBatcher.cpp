@@ -0,0 +1,200 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "UploadBatcher.h"
+#include "Core/Error.h"
+#include "Core/API/CopyContext.h"
+#include "Core/API/Device.h"
+#include "Core/API/GpuMemoryHeap.h"
+#include "Utils/Math/Common.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Falcor
+{
+namespace
+{
+/// Alignment in bytes of each range in the staging allocation.
+const uint64_t kStagingAlignment = 16;
+} // namespace
+
+void UploadRangeList::write(uint64_t offset, const void* pData, uint64_t size)
+{
+    if (size == 0)
+        return;
+
+    FALCOR_ASSERT(pData);
+    Write w;
+    w.offset = offset;
+    w.size = size;
+    w.dataOffset = mData.size();
+    mWrites.push_back(w);
+
+    const uint8_t* pSrc = static_cast<const uint8_t*>(pData);
+    mData.insert(mData.end(), pSrc, pSrc + size);
+}
+
+std::vector<UploadRangeList::Range> UploadRangeList::coalesce() const
+{
+    std::vector<Range> ranges;
+    ranges.reserve(mWrites.size());
+    for (const auto& w : mWrites)
+        ranges.push_back({w.offset, w.size});
+
+    // Writes are usually recorded in ascending order, avoid the sort in that case.
+    auto lessOffset = [](const Range& a, const Range& b) { return a.offset < b.offset; };
+    if (!std::is_sorted(ranges.begin(), ranges.end(), lessOffset))
+        std::sort(ranges.begin(), ranges.end(), lessOffset);
+
+    // Merge overlapping and adjacent ranges in place.
+    size_t count = 0;
+    for (const auto& range : ranges)
+    {
+        if (count > 0 && range.offset <= ranges[count - 1].offset + ranges[count - 1].size)
+        {
+            Range& last = ranges[count - 1];
+            last.size = std::max(last.offset + last.size, range.offset + range.size) - last.offset;
+        }
+        else
+        {
+            ranges[count++] = range;
+        }
+    }
+    ranges.resize(count);
+
+    return ranges;
+}
+
+uint64_t UploadRangeList::getStagingSize(const std::vector<Range>& ranges, uint64_t alignment)
+{
+    uint64_t size = 0;
+    for (const auto& range : ranges)
+        size = align_to(alignment, size) + range.size;
+    return size;
+}
+
+void UploadRangeList::gather(const std::vector<Range>& ranges, uint8_t* pDst, uint64_t alignment) const
+{
+    // Compute the staging offset of each range.
+    std::vector<uint64_t> stagingOffsets(ranges.size());
+    uint64_t stagingOffset = 0;
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        stagingOffsets[i] = align_to(alignment, stagingOffset);
+        stagingOffset = stagingOffsets[i] + ranges[i].size;
+    }
+
+    // Apply the writes in recording order. Each write is fully contained in one of the ranges.
+    for (const auto& w : mWrites)
+    {
+        auto it = std::upper_bound(ranges.begin(), ranges.end(), w.offset, [](uint64_t offset, const Range& r) { return offset < r.offset; });
+        FALCOR_ASSERT(it != ranges.begin());
+        size_t rangeIndex = std::distance(ranges.begin(), it) - 1;
+        const Range& range = ranges[rangeIndex];
+        FALCOR_ASSERT(w.offset >= range.offset && w.offset + w.size <= range.offset + range.size);
+        std::memcpy(pDst + stagingOffsets[rangeIndex] + (w.offset - range.offset), mData.data() + w.dataOffset, w.size);
+    }
+}
+
+void UploadRangeList::clear()
+{
+    mWrites.clear();
+    mData.clear();
+}
+
+UploadBatcher::UploadBatcher(ref<Device> pDevice) : mpDevice(pDevice) {}
+
+void UploadBatcher::write(const ref<Buffer>& pBuffer, uint64_t offset, const void* pData, uint64_t size)
+{
+    FALCOR_ASSERT(pBuffer);
+    if (size == 0)
+        return;
+    FALCOR_CHECK(
+        offset + size <= pBuffer->getSize(), "'offset' ({}) and 'size' ({}) don't fit the buffer size {}.", offset, size, pBuffer->getSize()
+    );
+
+    // Buffers in upload memory are CPU writable, no need to go through a copy.
+    if (pBuffer->getMemoryType() != MemoryType::DeviceLocal)
+    {
+        pBuffer->setBlob(pData, offset, size);
+        return;
+    }
+
+    auto [it, inserted] = mDestinationIndices.try_emplace(pBuffer.get(), mDestinations.size());
+    if (inserted)
+        mDestinations.push_back({pBuffer, {}});
+    mDestinations[it->second].writes.write(offset, pData, size);
+
+    mStats.writeCount++;
+    mStats.writtenBytes += size;
+}
+
+void UploadBatcher::flush(CopyContext* pCopyContext)
+{
+    if (mDestinations.empty())
+        return;
+
+    FALCOR_ASSERT(pCopyContext);
+
+    // Coalesce the writes and compute the total staging size.
+    std::vector<std::vector<UploadRangeList::Range>> ranges(mDestinations.size());
+    uint64_t totalSize = 0;
+    for (size_t i = 0; i < mDestinations.size(); i++)
+    {
+        ranges[i] = mDestinations[i].writes.coalesce();
+        totalSize = align_to(kStagingAlignment, totalSize) + UploadRangeList::getStagingSize(ranges[i], kStagingAlignment);
+    }
+
+    // Stage all data in a single upload heap allocation and issue one copy per range.
+    const auto& pUploadHeap = mpDevice->getUploadHeap();
+    auto allocation = pUploadHeap->allocate(totalSize, kStagingAlignment);
+
+    uint64_t stagingOffset = 0;
+    for (size_t i = 0; i < mDestinations.size(); i++)
+    {
+        const auto& dst = mDestinations[i];
+        stagingOffset = align_to(kStagingAlignment, stagingOffset);
+        dst.writes.gather(ranges[i], allocation.pData + stagingOffset, kStagingAlignment);
+
+        for (const auto& range : ranges[i])
+        {
+            stagingOffset = align_to(kStagingAlignment, stagingOffset);
+            pCopyContext->copyBufferRegion(dst.pBuffer.get(), range.offset, allocation, stagingOffset, range.size);
+            stagingOffset += range.size;
+            mStats.copyCount++;
+            mStats.uploadedBytes += range.size;
+        }
+    }
+
+    pUploadHeap->release(allocation);
+
+    mDestinations.clear();
+    mDestinationIndices.clear();
+    mStats.flushCount++;
+}
+} // namespace Falcor
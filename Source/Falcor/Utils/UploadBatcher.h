@@ -0,0 +1,183 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#pragma once
+#include "Core/Macros.h"
+#include "Core/API/fwd.h"
+#include "Core/API/Buffer.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Falcor
+{
+class CopyContext;
+
+/**
+ * Records writes to a single destination and coalesces them into a minimal set of byte ranges.
+ *
+ * This is the CPU side of UploadBatcher. It keeps a copy of the written data and does not
+ * depend on a device, so it can be used and tested standalone.
+ */
+class FALCOR_API UploadRangeList
+{
+public:
+    struct Range
+    {
+        uint64_t offset = 0; ///< Offset in bytes into the destination.
+        uint64_t size = 0;   ///< Size in bytes.
+
+        bool operator==(const Range& other) const { return offset == other.offset && size == other.size; }
+    };
+
+    /**
+     * Record a write. The data is copied.
+     * @param[in] offset Offset in bytes into the destination.
+     * @param[in] pData Pointer to the source data.
+     * @param[in] size Size in bytes.
+     */
+    void write(uint64_t offset, const void* pData, uint64_t size);
+
+    /**
+     * Coalesce the recorded writes. Overlapping and adjacent writes are merged into a single range.
+     * @return List of disjoint, non-adjacent ranges sorted by offset.
+     */
+    std::vector<Range> coalesce() const;
+
+    /**
+     * Get the size of a staging area holding the given ranges back to back.
+     * @param[in] ranges Ranges as returned by coalesce().
+     * @param[in] alignment Alignment in bytes of the start of each range in the staging area.
+     * @return Size in bytes.
+     */
+    static uint64_t getStagingSize(const std::vector<Range>& ranges, uint64_t alignment = 1);
+
+    /**
+     * Copy the recorded data into a staging area holding the given ranges back to back.
+     * Writes are applied in the order they were recorded, so later writes win where they overlap.
+     * @param[in] ranges Ranges as returned by coalesce().
+     * @param[out] pDst Staging area. Must hold at least getStagingSize(ranges, alignment) bytes.
+     * @param[in] alignment Alignment in bytes of the start of each range in the staging area.
+     */
+    void gather(const std::vector<Range>& ranges, uint8_t* pDst, uint64_t alignment = 1) const;
+
+    /// Returns true if no writes are recorded.
+    bool empty() const { return mWrites.empty(); }
+
+    /// Get the number of recorded writes.
+    size_t getWriteCount() const { return mWrites.size(); }
+
+    /// Get the total size in bytes of all recorded writes.
+    uint64_t getDataSize() const { return mData.size(); }
+
+    /// Remove all recorded writes.
+    void clear();
+
+private:
+    struct Write
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint64_t dataOffset = 0; ///< Offset in bytes into mData.
+    };
+
+    std::vector<Write> mWrites;
+    std::vector<uint8_t> mData;
+};
+
+/**
+ * Per-frame batcher for small updates of device-local buffers.
+ *
+ * Updates are recorded on the CPU and uploaded on flush(). All data of a flush is written to a
+ * single allocation from the device upload heap (a ring of persistently mapped pages recycled
+ * once the GPU is done with them) and overlapping/adjacent writes to the same buffer are
+ * coalesced, so each flush issues one copy command per contiguous range that was written.
+ * Writes to buffers in upload memory are applied immediately.
+ *
+ * The recorded data only becomes visible to GPU work recorded after the flush.
+ */
+class FALCOR_API UploadBatcher
+{
+public:
+    struct Stats
+    {
+        uint64_t writeCount = 0;    ///< Number of recorded writes.
+        uint64_t writtenBytes = 0;  ///< Total size in bytes of the recorded writes.
+        uint64_t copyCount = 0;     ///< Number of copy commands issued.
+        uint64_t uploadedBytes = 0; ///< Total size in bytes copied to the GPU.
+        uint64_t flushCount = 0;    ///< Number of flushes with pending writes.
+    };
+
+    UploadBatcher(ref<Device> pDevice);
+
+    /**
+     * Record an update of a buffer. The data is copied.
+     * @param[in] pBuffer Destination buffer. Kept alive until the next flush.
+     * @param[in] offset Offset in bytes into the destination buffer.
+     * @param[in] pData Pointer to the source data.
+     * @param[in] size Size in bytes.
+     */
+    void write(const ref<Buffer>& pBuffer, uint64_t offset, const void* pData, uint64_t size);
+
+    /**
+     * Record an update of a single element. Same layout as Buffer::setElement().
+     * @param[in] pBuffer Destination buffer.
+     * @param[in] index Element index.
+     * @param[in] value Element value.
+     */
+    template<typename T>
+    void setElement(const ref<Buffer>& pBuffer, uint32_t index, const T& value)
+    {
+        write(pBuffer, sizeof(T) * (uint64_t)index, &value, sizeof(T));
+    }
+
+    /// Returns true if there are writes that have not been flushed.
+    bool hasPendingWrites() const { return !mDestinations.empty(); }
+
+    /**
+     * Upload all pending writes.
+     * @param[in] pCopyContext Context to record the copy commands to.
+     */
+    void flush(CopyContext* pCopyContext);
+
+    const Stats& getStats() const { return mStats; }
+    void resetStats() { mStats = {}; }
+
+private:
+    struct Destination
+    {
+        ref<Buffer> pBuffer;
+        UploadRangeList writes;
+    };
+
+    ref<Device> mpDevice;
+    std::vector<Destination> mDestinations; ///< Buffers with pending writes in order of first write.
+    std::unordered_map<const Buffer*, size_t> mDestinationIndices;
+    Stats mStats;
+};
+} // namespace Falcor
@@ -34,6 +34,7 @@
 #include "RenderGraph/RenderGraphImportExport.h"
 #include "RenderGraph/RenderPassStandardFlags.h"
 #include "Utils/Scripting/Scripting.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Settings/Settings.h"
 
@@ -543,9 +544,18 @@ namespace Mogwai
             try
             {
                 TimeReport timeReport;
-                setScene(SceneBuilder(getDevice(), path, getSettings(), buildFlags).getScene());
+                LoadProfiler::instance().reset();
+                {
+                    FALCOR_LOAD_PHASE("Loading scene");
+                    setScene(SceneBuilder(getDevice(), path, getSettings(), buildFlags).getScene());
+                }
                 timeReport.measure("Loading scene (total)");
                 timeReport.printToLog();
+                if (!mOptions.loadReportFile.empty())
+                {
+                    LoadProfiler::instance().printToLog();
+                    LoadProfiler::instance().writeJson(mOptions.loadReportFile);
+                }
                 return;
             }
             catch (const ImporterError &e)
@@ -844,6 +854,7 @@ int runMain(int argc, char** argv)
     args::ValueFlag<uint32_t> heightFlag(parser, "pixels", "Initial window height.", {"height"});
     args::Flag useSceneCacheFlag(parser, "", "Use scene cache to improve scene load times.", {'c', "use-cache"});
     args::Flag rebuildSceneCacheFlag(parser, "", "Rebuild the scene cache.", {"rebuild-cache"});
+    args::ValueFlag<std::string> loadReportFlag(parser, "path", "Write a hierarchical scene load report (JSON) to the given file.", {"load-report"});
     args::Flag generateShaderDebugInfoFlag(parser, "", "Generate shader debug info.", {"debug-shaders"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
     args::Flag preciseProgramFlag(parser, "", "Force all slang programs to run in precise mode", { "precise" });
@@ -946,6 +957,7 @@ int runMain(int argc, char** argv)
     if (silentFlag) options.silentMode = true;
     if (useSceneCacheFlag) options.useSceneCache = true;
     if (rebuildSceneCacheFlag) options.rebuildSceneCache = true;
+    if (loadReportFlag) options.loadReportFile = args::get(loadReportFlag);
 
     Mogwai::Renderer renderer(config, options);
     return renderer.run();
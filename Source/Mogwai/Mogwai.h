@@ -87,6 +87,7 @@ namespace Mogwai
             bool silentMode = false;
             bool useSceneCache = false;
             bool rebuildSceneCache = false;
+            std::string loadReportFile; ///< If set, a hierarchical load report (JSON) is written to this file after each scene load.
         };
 
         using KeyCallback = std::function<bool(bool pressed, uint32_t key)>;
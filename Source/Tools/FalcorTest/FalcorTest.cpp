@@ -55,7 +55,17 @@ int runMain(int argc, char** argv)
     args::ValueFlag<std::string> testCaseFilterFlag(parser, "regex", "Filter test cases to run.", {'f', "test-case"});
     args::ValueFlag<std::string> tagFilterFlag(parser, "tags", "Filter test cases by tags.", {'t', "tags"});
     args::ValueFlag<std::string> xmlReportFlag(parser, "path", "XML report output file.", {'x', "xml-report"});
+    args::ValueFlag<std::string> loadReportFlag(parser, "path", "Load profile (JSON) output file.", {"load-report"});
     args::ValueFlag<uint32_t> repeatFlag(parser, "N", "Number of times to repeat the test.", {'r', "repeat"});
+    args::ValueFlag<std::string> benchmarkReportFlag(parser, "path", "Benchmark report (JSON) output file.", {"benchmark-report"});
+    args::ValueFlag<std::string> benchmarkBaselineFlag(
+        parser, "path", "Benchmark report (JSON) to compare against. Regressions fail the benchmark.", {"benchmark-baseline"}
+    );
+    args::ValueFlag<double> benchmarkThresholdFlag(
+        parser, "fraction", "Relative slowdown over the baseline reported as regression (default: 0.1).", {"benchmark-threshold"}
+    );
+    args::ValueFlag<double> benchmarkMinTimeFlag(parser, "seconds", "Minimum measured time per benchmark (default: 0.5).", {"benchmark-min-time"});
+    args::ValueFlag<uint32_t> benchmarkSamplesFlag(parser, "N", "Number of samples per benchmark (default: 20).", {"benchmark-samples"});
     args::Flag enableDebugLayerFlag(parser, "", "Enable debug layer (enabled by default in Debug build).", {"enable-debug-layer"});
     args::Flag enableAftermathFlag(parser, "", "Enable Aftermath GPU crash dump.", {"enable-aftermath"});
 
@@ -125,10 +135,22 @@ int runMain(int argc, char** argv)
         options.tagFilter = args::get(tagFilterFlag);
     if (xmlReportFlag)
         options.xmlReportPath = args::get(xmlReportFlag);
+    if (loadReportFlag)
+        options.loadReportPath = args::get(loadReportFlag);
     if (parallelFlag)
         options.parallel = args::get(parallelFlag);
     if (repeatFlag)
         options.repeat = args::get(repeatFlag);
+    if (benchmarkReportFlag)
+        options.benchmarkOptions.reportPath = args::get(benchmarkReportFlag);
+    if (benchmarkBaselineFlag)
+        options.benchmarkOptions.baselinePath = args::get(benchmarkBaselineFlag);
+    if (benchmarkThresholdFlag)
+        options.benchmarkOptions.regressionThreshold = args::get(benchmarkThresholdFlag);
+    if (benchmarkMinTimeFlag)
+        options.benchmarkOptions.minTime = args::get(benchmarkMinTimeFlag);
+    if (benchmarkSamplesFlag)
+        options.benchmarkOptions.sampleCount = args::get(benchmarkSamplesFlag);
 
     if (listTestSuites || listTestCases || listTags)
     {
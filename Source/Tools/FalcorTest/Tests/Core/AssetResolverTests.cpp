@@ -27,6 +27,7 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Core/AssetResolver.h"
+#include "Core/DirectoryIndex.h"
 #include <fstream>
 
 namespace Falcor
@@ -191,4 +192,119 @@ CPU_TEST(AssetResolver)
     removeTestFiles(ctx);
 }
 
+CPU_TEST(AssetResolver_DirectoryIndex)
+{
+    createTestFiles(ctx);
+
+    DirectoryIndex& index = DirectoryIndex::instance();
+    const std::filesystem::path dir = kTestRoot / "media5";
+    std::filesystem::create_directories(dir);
+    for (const char* name : {"tex.1001.png", "tex.1002.png", "tex.1011.png", "tex.0999.png", "tex.1003.png.bak", "other.1001.png"})
+        std::ofstream(dir / name).close();
+    std::filesystem::create_directories(dir / "tex.1004.png");
+
+    EXPECT(index.exists(kTestRoot / "media1/asset1"));
+    EXPECT(index.exists(kTestRoot / "media4/textures"));
+    EXPECT(!index.exists(kTestRoot / "media1/asset2"));
+    EXPECT(!index.exists(kTestRoot / "missing/asset1"));
+    EXPECT_EQ(index.resolve(kTestRoot / "media2/asset2"), std::filesystem::canonical(kTestRoot / "media2/asset2"));
+    EXPECT_EQ(index.resolve(kTestRoot / "media2/asset3"), std::filesystem::path());
+
+    // UDIM tiles are matched without regular expressions and returned ordered by tile number.
+    auto tiles = index.findUdimFiles(dir, "tex.<UDIM>.png");
+    ASSERT_EQ(tiles.size(), 3);
+    EXPECT_EQ(tiles[0], dir / "tex.1001.png");
+    EXPECT_EQ(tiles[1], dir / "tex.1002.png");
+    EXPECT_EQ(tiles[2], dir / "tex.1011.png");
+    EXPECT_EQ(index.findUdimFiles(dir, "tex.<UDIM>.png", true).size(), 1);
+    EXPECT(index.findUdimFiles(dir, "missing.<UDIM>.png").empty());
+
+    auto files = index.findFiles(dir, std::regex(R"(tex\.[0-9]+\.png)"));
+    EXPECT_EQ(files.size(), 4);
+
+    // Files added after listing are visible after invalidation.
+    std::ofstream(dir / "tex.1005.png").close();
+    index.invalidate(dir);
+    EXPECT(index.exists(dir / "tex.1005.png"));
+    EXPECT_EQ(index.findUdimFiles(dir, "tex.<UDIM>.png").size(), 4);
+
+    // Asset resolver uses the index for UDIM patterns.
+    AssetResolver resolver;
+    resolver.addSearchPath(kTestRoot / "media1");
+    resolver.addSearchPath(kTestRoot);
+    tiles = resolver.resolveUdimPattern("media5", "tex.<UDIM>.png");
+    EXPECT_EQ(tiles.size(), 4);
+    EXPECT(resolver.resolveUdimPattern("media5", "none.<UDIM>.png").empty());
+
+    removeTestFiles(ctx);
+    index.invalidate();
+}
+
+CPU_BENCHMARK(AssetResolver_DirectoryIndex)
+{
+    const uint32_t searchPathCount = 5;
+    const uint32_t fileCount = 20000;
+    const uint32_t udimCount = 200;
+    const uint32_t tileCount = 10;
+
+    // Create search paths, all assets are located in the last one.
+    std::vector<std::filesystem::path> searchPaths;
+    for (uint32_t i = 0; i < searchPathCount; i++)
+    {
+        searchPaths.push_back(kTestRoot / fmt::format("search{}", i));
+        std::filesystem::create_directories(searchPaths.back());
+    }
+    const std::filesystem::path& assetDir = searchPaths.back();
+    for (uint32_t i = 0; i < fileCount; i++)
+        std::ofstream(assetDir / fmt::format("texture{}.png", i)).close();
+    for (uint32_t i = 0; i < udimCount; i++)
+        for (uint32_t j = 0; j < tileCount; j++)
+            std::ofstream(assetDir / fmt::format("udim{}.{}.png", i, 1001 + j)).close();
+
+    AssetResolver resolver;
+    for (const auto& searchPath : searchPaths)
+        resolver.addSearchPath(searchPath);
+
+    auto resolveAll = [&]()
+    {
+        size_t resolvedCount = 0;
+        for (uint32_t i = 0; i < fileCount; i++)
+            resolvedCount += !resolver.resolvePath(fmt::format("texture{}.png", i)).empty();
+        for (uint32_t i = 0; i < udimCount; i++)
+            resolvedCount += resolver.resolveUdimPattern(".", fmt::format("udim{}.<UDIM>.png", i)).size() == tileCount;
+        return resolvedCount;
+    };
+
+    DirectoryIndex& index = DirectoryIndex::instance();
+    auto run = [&](bool enabled)
+    {
+        index.setEnabled(enabled);
+        index.invalidate();
+
+        // Count the filesystem calls of a single pass starting with an empty index.
+        index.resetStats();
+        EXPECT_EQ(resolveAll(), fileCount + udimCount);
+        auto stats = index.getStats();
+        logInfo(
+            "Directory index {}: {} filesystem calls ({} listings, {} stat calls), {} queries.",
+            enabled ? "enabled" : "disabled",
+            stats.getFilesystemCalls(),
+            stats.listings,
+            stats.statCalls,
+            stats.queries
+        );
+
+        bench.run(enabled ? "Enabled" : "Disabled", [&]() { doNotOptimize(resolveAll()); });
+        return stats;
+    };
+
+    bench.setItemsPerIteration(fileCount + udimCount);
+    auto disabledStats = run(false);
+    auto enabledStats = run(true);
+    EXPECT_LT(enabledStats.getFilesystemCalls(), disabledStats.getFilesystemCalls());
+
+    index.invalidate();
+    std::filesystem::remove_all(kTestRoot);
+}
+
 } // namespace Falcor
@@ -0,0 +1,94 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/API/BufferSuballocator.h"
+
+#include <numeric>
+
+namespace Falcor
+{
+GPU_TEST(BufferSuballocator_Allocate)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    BufferSuballocator::Desc desc;
+    desc.blockSize = 64 * 1024;
+    desc.maxSuballocationSize = 16 * 1024;
+    ref<Fence> pFence = pDevice->createFence();
+    ref<BufferSuballocator> pSuballocator = BufferSuballocator::create(pDevice, desc, pFence);
+
+    // Write distinct data to a number of small allocations and read it back.
+    std::vector<BufferSuballocator::Allocation> allocations;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        auto allocation = pSuballocator->allocate(256 + i * 64);
+        ASSERT(allocation.isValid());
+        EXPECT_EQ(allocation.offset % desc.minAlignment, 0);
+
+        std::vector<uint32_t> data(allocation.size / sizeof(uint32_t));
+        std::iota(data.begin(), data.end(), i * 1000);
+        allocation.pBuffer->setBlob(data.data(), allocation.offset, allocation.size);
+        allocations.push_back(allocation);
+    }
+
+    auto stats = pSuballocator->getStats();
+    EXPECT_EQ(stats.allocationCount, 64);
+    EXPECT_EQ(stats.dedicatedCount, 0);
+    EXPECT_EQ(stats.blockCount, 5);
+
+    for (uint32_t i = 0; i < allocations.size(); ++i)
+    {
+        const auto& allocation = allocations[i];
+        std::vector<uint32_t> data(allocation.size / sizeof(uint32_t));
+        allocation.pBuffer->getBlob(data.data(), allocation.offset, allocation.size);
+        for (uint32_t j = 0; j < data.size(); ++j)
+            EXPECT_EQ(data[j], i * 1000 + j) << "allocation = " << i;
+    }
+
+    auto dedicated = pSuballocator->allocate(32 * 1024);
+    EXPECT(dedicated.isValid());
+    EXPECT_EQ(dedicated.offset, 0);
+    EXPECT_EQ(pSuballocator->getStats().dedicatedCount, 1);
+
+    // Releases are deferred until the fence passes the value signaled at the time of release.
+    for (auto& allocation : allocations)
+        pSuballocator->release(allocation);
+    pSuballocator->release(dedicated);
+    pSuballocator->executeDeferredReleases();
+    EXPECT_EQ(pSuballocator->getStats().pendingReleaseCount, 65);
+
+    ctx.getRenderContext()->signal(pFence.get());
+    pFence->wait();
+    pSuballocator->executeDeferredReleases();
+    stats = pSuballocator->getStats();
+    EXPECT_EQ(stats.pendingReleaseCount, 0);
+    EXPECT_EQ(stats.allocationCount, 0);
+    EXPECT_EQ(stats.dedicatedCount, 0);
+    EXPECT_EQ(stats.blockCount, desc.maxEmptyBlocks);
+}
+} // namespace Falcor
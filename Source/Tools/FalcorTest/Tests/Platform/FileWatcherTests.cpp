@@ -0,0 +1,134 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Core/Platform/OS.h"
+#include "Core/Platform/FileWatcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+CPU_TEST(FileWatcher_Changes)
+{
+    FileWatcher watcher;
+    if (!watcher.isSupported())
+        ctx.skip("FileWatcher not supported on this platform");
+
+    const std::filesystem::path directory = std::filesystem::absolute("test_file_watcher");
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path watchedFile = directory / "watched.txt";
+    const std::filesystem::path otherFile = directory / "other.txt";
+    std::ofstream(watchedFile) << "0";
+
+    ASSERT_TRUE(watcher.addDirectory(directory));
+    // Adding the same directory twice is allowed.
+    EXPECT_TRUE(watcher.addDirectory(directory));
+
+    // No changes yet.
+    std::vector<std::filesystem::path> changedFiles;
+    EXPECT_TRUE(watcher.getChangedFiles(changedFiles));
+    EXPECT_TRUE(changedFiles.empty());
+
+    auto waitForChanges = [&]()
+    {
+        // Events are delivered asynchronously, give the watch thread some time.
+        std::vector<std::filesystem::path> result;
+        for (int i = 0; i < 50 && result.empty(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            watcher.getChangedFiles(result, std::chrono::milliseconds(20));
+        }
+        return result;
+    };
+
+    // A burst of writes to the same file is reported once.
+    for (int i = 0; i < 10; ++i)
+        std::ofstream(watchedFile) << i;
+    changedFiles = waitForChanges();
+    EXPECT_EQ(changedFiles.size(), 1u);
+    EXPECT(std::count(changedFiles.begin(), changedFiles.end(), watchedFile) == 1);
+
+    // Creating another file and replacing the watched file through a rename are both reported.
+    std::ofstream(otherFile) << "1";
+    std::filesystem::rename(otherFile, watchedFile);
+    changedFiles = waitForChanges();
+    EXPECT(std::count(changedFiles.begin(), changedFiles.end(), watchedFile) == 1);
+
+    // Cleanup.
+    watcher.clear();
+    std::filesystem::remove_all(directory);
+    ASSERT_FALSE(std::filesystem::exists(directory));
+}
+
+CPU_TEST(FileWatcher_MonitorFileUpdates)
+{
+    if (!FileWatcher().isSupported())
+        ctx.skip("FileWatcher not supported on this platform");
+
+    const std::filesystem::path directory = std::filesystem::absolute("test_monitor_file_updates");
+    std::filesystem::create_directories(directory);
+    const std::filesystem::path sharedFile = directory / "shared.txt";
+    const std::filesystem::path otherFile = directory / "other.txt";
+    std::ofstream(sharedFile) << "0";
+
+    // The callback registers another monitor, i.e. it takes the same lock as monitorFileUpdates() and closeSharedFile().
+    std::atomic<uint32_t> callCount{0};
+    monitorFileUpdates(
+        sharedFile,
+        [&]()
+        {
+            monitorFileUpdates(otherFile);
+            callCount++;
+        }
+    );
+
+    // Keep writing until the callback ran, then replace the monitor while it may still be in the callback.
+    for (int i = 0; i < 100 && callCount == 0; ++i)
+    {
+        std::ofstream(sharedFile) << i;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EXPECT_GT(callCount, 0u);
+    monitorFileUpdates(sharedFile, [&]() { callCount++; });
+
+    // After closing, the monitor thread has exited and the callback is no longer invoked.
+    closeSharedFile(sharedFile);
+    closeSharedFile(otherFile);
+    uint32_t closedCallCount = callCount;
+    std::ofstream(sharedFile) << "closed";
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(callCount, closedCallCount);
+
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace Falcor
@@ -0,0 +1,345 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Rendering/Lights/LightBVH.h"
+#include "Rendering/Lights/LightBVHBuilder.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Animation/Animation.h"
+#include "Scene/Material/StandardMaterial.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace Falcor
+{
+namespace
+{
+/**
+ * Build a scene with a grid of emissive quads. Every animatedStride-th quad gets an animation
+ * that moves it by the given offset over time.
+ */
+ref<Scene> buildEmissiveScene(ref<Device> pDevice, uint32_t quadCount, uint32_t animatedStride, float3 offset)
+{
+    SceneBuilder builder(pDevice, Settings());
+    auto pMaterial = StandardMaterial::create(pDevice, "Emissive");
+    pMaterial->setEmissiveColor(float3(1.f));
+    MeshID meshID = builder.addTriangleMesh(TriangleMesh::createQuad(float2(0.5f)), pMaterial);
+
+    for (uint32_t i = 0; i < quadCount; i++)
+    {
+        float3 translation = float3(float(i % 32), float((i / 32) % 32), float(i / 1024));
+        NodeID nodeID = builder.addNode(SceneBuilder::Node{fmt::format("Node{}", i), math::matrixFromTranslation(translation), float4x4::identity()});
+        builder.addMeshInstance(nodeID, meshID);
+
+        if (i % animatedStride == 0)
+        {
+            auto pAnimation = Animation::create(fmt::format("Anim{}", i), nodeID, 1.0);
+            pAnimation->addKeyframe(Animation::Keyframe{0.0, translation, float3(1.f)});
+            pAnimation->addKeyframe(Animation::Keyframe{1.0, translation + offset, float3(1.f)});
+            builder.addAnimation(pAnimation);
+        }
+    }
+
+    return builder.getScene();
+}
+
+std::vector<uint32_t> getChangedTriangles(const LightCollection& lightCollection)
+{
+    std::vector<uint32_t> triangles;
+    for (uint32_t lightIdx : lightCollection.getUpdatedMeshLights())
+    {
+        const auto& meshLight = lightCollection.getMeshLights()[lightIdx];
+        for (uint32_t i = 0; i < meshLight.triangleCount; i++) triangles.push_back(meshLight.triangleOffset + i);
+    }
+    return triangles;
+}
+
+bool isClose(float a, float b, float eps)
+{
+    return std::abs(a - b) <= eps;
+}
+} // namespace
+
+class LightBVHTest
+{
+public:
+    static const std::vector<PackedNode>& getNodes(const LightBVH& bvh) { return bvh.mNodes; }
+
+    static std::vector<PackedNode> getGPUNodes(const LightBVH& bvh)
+    {
+        return bvh.mpBVHNodesBuffer->getElements<PackedNode>(0, (uint32_t)bvh.mNodes.size());
+    }
+
+    /// Checks that the path encoded in the bitmask of each triangle leads to the leaf containing it.
+    static void expectBitmasksReachLeaves(GPUUnitTestContext& ctx, const LightBVH& bvh, const std::vector<LightCollection::MeshLightTriangle>& triangles)
+    {
+        ASSERT_EQ(bvh.mTriangleBitmasks.size(), triangles.size());
+        uint32_t reachedCount = 0;
+        for (uint32_t triangleIndex = 0; triangleIndex < triangles.size(); triangleIndex++)
+        {
+            const uint64_t bitmask = bvh.mTriangleBitmasks[triangleIndex];
+            if (bitmask == std::numeric_limits<uint64_t>::max())
+            {
+                EXPECT_EQ(triangles[triangleIndex].flux, 0.f) << fmt::format("triangle {}", triangleIndex);
+                continue;
+            }
+
+            uint32_t nodeIndex = 0;
+            for (uint32_t depth = 0; !bvh.mNodes[nodeIndex].isLeaf(); depth++)
+            {
+                ASSERT_LT(depth, 64u);
+                nodeIndex = ((bitmask >> depth) & 1) ? bvh.mNodes[nodeIndex].getInternalNode().rightChildIdx : nodeIndex + 1;
+            }
+
+            const LeafNode leaf = bvh.mNodes[nodeIndex].getLeafNode();
+            const auto begin = bvh.mTriangleIndices.begin() + leaf.triangleOffset;
+            EXPECT(std::find(begin, begin + leaf.triangleCount, triangleIndex) != begin + leaf.triangleCount) << fmt::format("triangle {}", triangleIndex);
+            reachedCount++;
+        }
+        EXPECT_EQ(reachedCount, bvh.getStats().triangleCount);
+    }
+
+    /**
+     * Checks the bounds, flux and lighting cone of every node against the triangles in its subtree.
+     * The node bounds are stored in half precision, so small differences are allowed.
+     */
+    static void expectNodesMatchTriangles(GPUUnitTestContext& ctx, const LightBVH& bvh, const std::vector<LightCollection::MeshLightTriangle>& triangles)
+    {
+        std::vector<std::vector<uint32_t>> subtreeTriangles(bvh.mNodes.size());
+        for (size_t nodeIndex = bvh.mNodes.size(); nodeIndex-- > 0; )
+        {
+            const PackedNode& node = bvh.mNodes[nodeIndex];
+            auto& nodeTriangles = subtreeTriangles[nodeIndex];
+            if (node.isLeaf())
+            {
+                const LeafNode leaf = node.getLeafNode();
+                nodeTriangles.assign(bvh.mTriangleIndices.begin() + leaf.triangleOffset, bvh.mTriangleIndices.begin() + leaf.triangleOffset + leaf.triangleCount);
+            }
+            else
+            {
+                // The children are stored after their parent.
+                nodeTriangles = subtreeTriangles[nodeIndex + 1];
+                const auto& right = subtreeTriangles[node.getInternalNode().rightChildIdx];
+                nodeTriangles.insert(nodeTriangles.end(), right.begin(), right.end());
+            }
+
+            AABB bounds;
+            float flux = 0.f;
+            for (uint32_t triangleIndex : nodeTriangles)
+            {
+                for (uint32_t j = 0; j < 3; j++) bounds.include(triangles[triangleIndex].vtx[j].pos);
+                flux += triangles[triangleIndex].flux;
+            }
+
+            SharedNodeAttributes attribs = node.getNodeAttributes();
+            float3 aabbMin, aabbMax;
+            attribs.getAABB(aabbMin, aabbMax);
+            const float boundsEps = 1e-2f * std::max(1.f, std::max(bounds.extent().x, std::max(bounds.extent().y, bounds.extent().z)));
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                EXPECT(isClose(aabbMin[i], bounds.minPoint[i], boundsEps)) << fmt::format("node {}", nodeIndex);
+                EXPECT(isClose(aabbMax[i], bounds.maxPoint[i], boundsEps)) << fmt::format("node {}", nodeIndex);
+            }
+            EXPECT(isClose(attribs.flux, flux, 1e-4f * flux)) << fmt::format("node {}", nodeIndex);
+
+            if (attribs.cosConeAngle != kInvalidCosConeAngle)
+            {
+                for (uint32_t triangleIndex : nodeTriangles)
+                {
+                    EXPECT_GE(dot(attribs.coneDirection, triangles[triangleIndex].normal), attribs.cosConeAngle - 1e-3f) << fmt::format("node {} triangle {}", nodeIndex, triangleIndex);
+                }
+            }
+
+            // Children are not needed once the parent is done.
+            if (!node.isLeaf())
+            {
+                subtreeTriangles[nodeIndex + 1] = {};
+                subtreeTriangles[node.getInternalNode().rightChildIdx] = {};
+            }
+        }
+    }
+
+    /// Checks that the root of the BVH matches the root of a BVH built from scratch.
+    static void expectRootMatchesFreshBuild(GPUUnitTestContext& ctx, const LightBVH& bvh, const LightBVHBuilder::Options& options)
+    {
+        LightBVHBuilder builder(options);
+        LightBVH freshBVH(ctx.getDevice(), bvh.mpLightCollection);
+        builder.build(ctx.getRenderContext(), freshBVH);
+        ASSERT(freshBVH.isValid());
+        EXPECT_EQ(bvh.getStats().triangleCount, freshBVH.getStats().triangleCount);
+
+        SharedNodeAttributes attribs = bvh.mNodes[0].getNodeAttributes();
+        SharedNodeAttributes freshAttribs = freshBVH.mNodes[0].getNodeAttributes();
+        float3 aabbMin, aabbMax, freshAabbMin, freshAabbMax;
+        attribs.getAABB(aabbMin, aabbMax);
+        freshAttribs.getAABB(freshAabbMin, freshAabbMax);
+        const float boundsEps = 1e-2f * std::max(1.f, std::max(freshAttribs.extent.x, std::max(freshAttribs.extent.y, freshAttribs.extent.z)));
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            EXPECT(isClose(aabbMin[i], freshAabbMin[i], boundsEps));
+            EXPECT(isClose(aabbMax[i], freshAabbMax[i], boundsEps));
+        }
+        EXPECT(isClose(attribs.flux, freshAttribs.flux, 1e-4f * freshAttribs.flux));
+    }
+
+    /// Checks that the GPU nodes match the CPU nodes.
+    static void expectGPUNodesMatchCPU(GPUUnitTestContext& ctx, const LightBVH& bvh)
+    {
+        const auto gpuNodes = getGPUNodes(bvh);
+        ASSERT_EQ(gpuNodes.size(), bvh.mNodes.size());
+        EXPECT(std::memcmp(gpuNodes.data(), bvh.mNodes.data(), gpuNodes.size() * sizeof(PackedNode)) == 0);
+    }
+};
+
+GPU_TEST(LightBVH_IncrementalRefit)
+{
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    ref<Scene> pScene = buildEmissiveScene(ctx.getDevice(), 4096, 64, float3(0.f, 0.f, 0.5f));
+    pScene->update(pRenderContext, 0.0);
+    const auto& pLightCollection = pScene->getLightCollection(pRenderContext);
+    ASSERT(pLightCollection->isBuiltOnCPU());
+
+    LightBVHBuilder::Options options;
+    options.allowPartialRebuild = false;
+    LightBVHBuilder builder(options);
+    LightBVH bvh(ctx.getDevice(), pLightCollection);
+    builder.build(pRenderContext, bvh);
+    ASSERT(bvh.isValid());
+    EXPECT_EQ(bvh.getStats().triangleCount, 2u * 4096u);
+    EXPECT_EQ(bvh.getStats().costRatio, 1.f);
+    const uint32_t nodeCount = bvh.getStats().internalNodeCount + bvh.getStats().leafNodeCount;
+
+    // Only the paths to the leaves of the animated quads are refit.
+    pScene->update(pRenderContext, 0.5);
+    auto changedTriangles = getChangedTriangles(*pLightCollection);
+    EXPECT_EQ(changedTriangles.size(), 2u * 4096u / 64u);
+    builder.refit(pRenderContext, bvh, changedTriangles);
+
+    const auto& stats = bvh.getStats();
+    EXPECT_GT(stats.refitNodeCount, 0u);
+    EXPECT_LT(stats.refitNodeCount, nodeCount);
+    EXPECT_EQ(stats.rebuiltSubtreeCount, 0u);
+    EXPECT_GE(stats.costRatio, 1.f);
+
+    // The incrementally refit nodes must be identical to refitting all nodes of the same tree.
+    LightBVH referenceBVH(ctx.getDevice(), pLightCollection);
+    pScene->update(pRenderContext, 0.0);
+    builder.build(pRenderContext, referenceBVH);
+    pScene->update(pRenderContext, 0.5);
+    std::vector<uint32_t> allTriangles(pLightCollection->getTotalLightCount());
+    std::iota(allTriangles.begin(), allTriangles.end(), 0u);
+    builder.refit(pRenderContext, referenceBVH, allTriangles);
+    EXPECT_EQ(referenceBVH.getStats().refitNodeCount, nodeCount);
+
+    const auto& nodes = LightBVHTest::getNodes(bvh);
+    const auto& referenceNodes = LightBVHTest::getNodes(referenceBVH);
+    ASSERT_EQ(nodes.size(), referenceNodes.size());
+    EXPECT(std::memcmp(nodes.data(), referenceNodes.data(), nodes.size() * sizeof(PackedNode)) == 0);
+
+    const auto& triangles = pLightCollection->getMeshLightTriangles(pRenderContext);
+    LightBVHTest::expectNodesMatchTriangles(ctx, bvh, triangles);
+    LightBVHTest::expectBitmasksReachLeaves(ctx, bvh, triangles);
+    LightBVHTest::expectRootMatchesFreshBuild(ctx, bvh, options);
+    LightBVHTest::expectGPUNodesMatchCPU(ctx, bvh);
+}
+
+GPU_TEST(LightBVH_PartialRebuild)
+{
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    ref<Scene> pScene = buildEmissiveScene(ctx.getDevice(), 4096, 16, float3(8.f, 0.f, 0.f));
+    pScene->update(pRenderContext, 0.0);
+    const auto& pLightCollection = pScene->getLightCollection(pRenderContext);
+    ASSERT(pLightCollection->isBuiltOnCPU());
+
+    // Without rebuilding, the tree degrades as the animated quads move away from their neighbors.
+    LightBVHBuilder::Options options;
+    options.allowPartialRebuild = false;
+    LightBVHBuilder refitBuilder(options);
+    LightBVH refitBVH(ctx.getDevice(), pLightCollection);
+    refitBuilder.build(pRenderContext, refitBVH);
+
+    options.allowPartialRebuild = true;
+    options.rebuildCostRatio = 1.1f;
+    LightBVHBuilder rebuildBuilder(options);
+    LightBVH rebuildBVH(ctx.getDevice(), pLightCollection);
+    rebuildBuilder.build(pRenderContext, rebuildBVH);
+
+    pScene->update(pRenderContext, 1.0);
+    auto changedTriangles = getChangedTriangles(*pLightCollection);
+    refitBuilder.refit(pRenderContext, refitBVH, changedTriangles);
+    rebuildBuilder.refit(pRenderContext, rebuildBVH, changedTriangles);
+
+    EXPECT_GT(refitBVH.getStats().costRatio, options.rebuildCostRatio);
+    EXPECT_GT(rebuildBVH.getStats().rebuiltSubtreeCount, 0u);
+    EXPECT_LT(rebuildBVH.getStats().costRatio, refitBVH.getStats().costRatio);
+    EXPECT_EQ(rebuildBVH.getStats().triangleCount, 2u * 4096u);
+
+    const auto& triangles = pLightCollection->getMeshLightTriangles(pRenderContext);
+    for (const LightBVH* pBVH : {&refitBVH, &rebuildBVH})
+    {
+        LightBVHTest::expectNodesMatchTriangles(ctx, *pBVH, triangles);
+        LightBVHTest::expectBitmasksReachLeaves(ctx, *pBVH, triangles);
+        LightBVHTest::expectRootMatchesFreshBuild(ctx, *pBVH, options);
+        LightBVHTest::expectGPUNodesMatchCPU(ctx, *pBVH);
+    }
+}
+
+GPU_BENCHMARK(LightBVH_Update)
+{
+    // Compare the cost of a full rebuild, a full GPU refit and an incremental refit when 1% of the lights move.
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    ref<Scene> pScene = buildEmissiveScene(ctx.getDevice(), 32768, 100, float3(0.f, 0.f, 0.5f));
+    pScene->update(pRenderContext, 0.0);
+    const auto& pLightCollection = pScene->getLightCollection(pRenderContext);
+    pScene->update(pRenderContext, 0.5);
+    auto changedTriangles = getChangedTriangles(*pLightCollection);
+
+    LightBVHBuilder::Options options;
+    options.allowPartialRebuild = false;
+    LightBVHBuilder builder(options);
+    LightBVH bvh(ctx.getDevice(), pLightCollection);
+    builder.build(pRenderContext, bvh);
+
+    bench.setItemsPerIteration(pLightCollection->getTotalLightCount());
+    bench.run("Rebuild", [&]()
+    {
+        builder.build(pRenderContext, bvh);
+        pRenderContext->submit(true);
+    });
+    bench.run("RefitGPU", [&]()
+    {
+        bvh.refit(pRenderContext);
+        pRenderContext->submit(true);
+    });
+    bench.run("RefitIncremental", [&]()
+    {
+        builder.refit(pRenderContext, bvh, changedTriangles);
+        pRenderContext->submit(true);
+    });
+}
+} // namespace Falcor
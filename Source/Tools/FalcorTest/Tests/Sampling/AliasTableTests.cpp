@@ -30,7 +30,10 @@
 
 #include <hypothesis/hypothesis.h>
 
+#include <cmath>
 #include <iostream>
+#include <new>
+#include <random>
 
 namespace Falcor
 {
@@ -137,8 +140,153 @@ void testAliasTable(GPUUnitTestContext& ctx, uint32_t N, std::vector<float> spec
         }
     }
 }
+
+/// Compute the probability of sampling each entry from the alias table items.
+std::vector<double> computeProbabilities(const std::vector<AliasTable::Item>& items)
+{
+    std::vector<double> probabilities(items.size(), 0.0);
+    for (const auto& item : items)
+    {
+        probabilities[item.indexB] += item.threshold / items.size();
+        probabilities[item.indexA] += (1.0 - item.threshold) / items.size();
+    }
+    return probabilities;
+}
+
+void testBuild(CPUUnitTestContext& ctx, const std::vector<float>& weights)
+{
+    double weightSum = 0.0;
+    std::vector<AliasTable::Item> items = AliasTable::build(weights, weightSum);
+    ASSERT_EQ(items.size(), weights.size());
+
+    double expectedSum = 0.0;
+    for (float weight : weights)
+        expectedSum += weight;
+    EXPECT_LE(std::abs(weightSum - expectedSum), 1e-9 * expectedSum);
+
+    // Each entry occurs exactly once as indexB.
+    std::vector<uint32_t> indexBCount(weights.size(), 0);
+    for (const auto& item : items)
+    {
+        ASSERT_LT(item.indexA, weights.size());
+        ASSERT_LT(item.indexB, weights.size());
+        indexBCount[item.indexB]++;
+    }
+    for (size_t i = 0; i < weights.size(); ++i)
+        EXPECT_EQ(indexBCount[i], 1) << "i = " << i;
+
+    // The probabilities of the table match the weights. The error is measured relative to the average probability.
+    std::vector<double> probabilities = computeProbabilities(items);
+    double maxError = 0.0;
+    for (size_t i = 0; i < weights.size(); ++i)
+        maxError = std::max(maxError, std::abs(probabilities[i] - weights[i] / weightSum) * weights.size());
+    EXPECT_LE(maxError, 1e-3) << "N = " << weights.size();
+}
 } // namespace
 
+CPU_TEST(AliasTable_Build)
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+
+    testBuild(ctx, {1.f});
+    testBuild(ctx, {1.f, 2.f});
+    testBuild(ctx, {0.f, 0.f, 0.f});
+
+    // Sizes spanning multiple blocks of the parallel build.
+    for (uint32_t N : {100u, 1000u, 70000u, 1000000u})
+    {
+        std::vector<float> weights(N);
+        for (auto& weight : weights)
+            weight = uniform(rng);
+        for (uint32_t i = 0; i < N / 100; ++i)
+            weights[rng() % N] = 0.f;
+        testBuild(ctx, weights);
+    }
+
+    // Spatially coherent weights, e.g. a small bright region in an environment map.
+    {
+        const uint32_t N = 1000000;
+        std::vector<float> weights(N);
+        for (uint32_t i = 0; i < N; ++i)
+            weights[i] = (i >= N / 2 && i < N / 2 + 1000) ? 1000.f : 0.01f * uniform(rng);
+        testBuild(ctx, weights);
+    }
+
+    // Sorted weights.
+    {
+        const uint32_t N = 1000000;
+        std::vector<float> weights(N);
+        for (uint32_t i = 0; i < N; ++i)
+            weights[i] = (float)i;
+        testBuild(ctx, weights);
+    }
+}
+
+CPU_TEST(AliasTable_BuildSampling)
+{
+    // Sample the table on the CPU the same way as AliasTable.slang and verify the histogram.
+    const uint32_t N = 200000;
+    const uint32_t samplesPerWeight = 100;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float> weights(N);
+    for (uint32_t i = 0; i < N; ++i)
+        weights[i] = i % 1000 < 10 ? 100.f * uniform(rng) : uniform(rng);
+
+    double weightSum = 0.0;
+    std::vector<AliasTable::Item> items = AliasTable::build(weights, weightSum);
+
+    std::vector<double> obsFrequencies(N, 0.0);
+    for (uint32_t i = 0; i < N * samplesPerWeight; ++i)
+    {
+        uint32_t index = std::min(N - 1, (uint32_t)(uniform(rng) * N));
+        const auto& item = items[index];
+        obsFrequencies[uniform(rng) >= item.threshold ? item.indexA : item.indexB]++;
+    }
+
+    std::vector<double> expFrequencies(N);
+    for (uint32_t i = 0; i < N; ++i)
+        expFrequencies[i] = (weights[i] / weightSum) * N * samplesPerWeight;
+
+    const auto& [success, report] = hypothesis::chi2_test(N, obsFrequencies.data(), expFrequencies.data(), N * samplesPerWeight, 5, 0.1);
+    if (!success)
+        std::cout << report << std::endl;
+    EXPECT(success);
+}
+
+CPU_BENCHMARK(AliasTable_Build)
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+
+    for (auto [name, N] : {std::make_pair("1M", 1000000u), std::make_pair("100M", 100000000u)})
+    {
+        // The 100M case needs several GB for the weights and the table.
+        try
+        {
+            std::vector<float> weights(N);
+            for (auto& weight : weights)
+                weight = uniform(rng);
+
+            bench.setItemsPerIteration(N);
+            bench.run(
+                name,
+                [&]()
+                {
+                    double weightSum;
+                    doNotOptimize(AliasTable::build(weights, weightSum));
+                }
+            );
+        }
+        catch (const std::bad_alloc&)
+        {
+            ctx.skip(fmt::format("Not enough memory to build an alias table with {} weights.", name).c_str());
+        }
+    }
+}
+
 GPU_TEST(AliasTable)
 {
     testAliasTable(ctx, 1, {1.f});
@@ -0,0 +1,179 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/BLASGrouping.h"
+#include "Utils/StringUtils.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+const BLASGrouping::Strategy kStrategies[] = {
+    BLASGrouping::Strategy::Simple,
+    BLASGrouping::Strategy::Median,
+    BLASGrouping::Strategy::Midpoint,
+    BLASGrouping::Strategy::SAH,
+};
+
+const char* getStrategyName(BLASGrouping::Strategy strategy)
+{
+    switch (strategy)
+    {
+    case BLASGrouping::Strategy::Simple:
+        return "Simple";
+    case BLASGrouping::Strategy::Median:
+        return "Median";
+    case BLASGrouping::Strategy::Midpoint:
+        return "Midpoint";
+    case BLASGrouping::Strategy::SAH:
+        return "SAH";
+    default:
+        return "Unknown";
+    }
+}
+
+/// Random boxes in a few clusters, listed in random order.
+std::vector<BLASGrouping::MeshInfo> createClusteredMeshes(uint32_t meshCount, uint32_t clusterCount)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(0.f, 1.f);
+
+    std::vector<float3> clusterCenters(clusterCount);
+    for (auto& c : clusterCenters)
+        c = float3(u(rng), u(rng), u(rng)) * 1000.f;
+
+    std::vector<BLASGrouping::MeshInfo> meshes(meshCount);
+    for (auto& mesh : meshes)
+    {
+        float3 center = clusterCenters[rng() % clusterCount] + float3(u(rng), u(rng), u(rng)) * 50.f;
+        float3 halfSize = float3(u(rng), u(rng), u(rng)) * 2.f + 0.1f;
+        mesh.bounds = AABB(center - halfSize, center + halfSize);
+        mesh.triangleCount = 100 + rng() % 10000;
+    }
+    return meshes;
+}
+
+BLASGrouping::Group createGroup(size_t meshCount)
+{
+    BLASGrouping::Group group(meshCount);
+    for (uint32_t i = 0; i < meshCount; i++)
+        group[i] = i;
+    return group;
+}
+} // namespace
+
+CPU_TEST(BLASGrouping_Partition)
+{
+    const auto meshes = createClusteredMeshes(2000, 8);
+    const auto group = createGroup(meshes.size());
+    const size_t maxTriangles = 500000;
+
+    for (auto strategy : kStrategies)
+    {
+        auto groups = BLASGrouping::partition(meshes, group, strategy, maxTriangles);
+        EXPECT_GT(groups.size(), 1);
+
+        // Each mesh is in exactly one group and groups are within the limit.
+        std::vector<uint32_t> count(meshes.size(), 0);
+        for (const auto& g : groups)
+        {
+            ASSERT(!g.empty());
+            size_t triangles = 0;
+            for (uint32_t meshIndex : g)
+            {
+                count[meshIndex]++;
+                triangles += meshes[meshIndex].triangleCount;
+            }
+            if (strategy != BLASGrouping::Strategy::Midpoint)
+                EXPECT_LE(triangles, maxTriangles);
+        }
+        for (uint32_t c : count)
+            EXPECT_EQ(c, 1u);
+
+        // Partitioning is deterministic.
+        EXPECT(groups == BLASGrouping::partition(meshes, group, strategy, maxTriangles));
+    }
+
+    // Groups under the limit and single meshes are not split.
+    EXPECT_EQ(BLASGrouping::partition(meshes, group, BLASGrouping::Strategy::SAH, 1ull << 32).size(), 1);
+    EXPECT_EQ(BLASGrouping::partition(meshes, {0}, BLASGrouping::Strategy::SAH, 1).size(), 1);
+}
+
+CPU_TEST(BLASGrouping_SAHSeparatesClusters)
+{
+    // Two clusters of equal size far apart should end up in separate, non-overlapping groups.
+    std::vector<BLASGrouping::MeshInfo> meshes;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        float3 center = float3(float((i * 37) % 50), 0.f, 0.f) + ((i % 2) ? float3(0.f, 1000.f, 0.f) : float3(0.f));
+        meshes.push_back({AABB(center - 0.5f, center + 0.5f), 1000});
+    }
+    const auto group = createGroup(meshes.size());
+
+    auto sahGroups = BLASGrouping::partition(meshes, group, BLASGrouping::Strategy::SAH, 50000);
+    ASSERT_EQ(sahGroups.size(), 2);
+    for (const auto& g : sahGroups)
+    {
+        for (uint32_t meshIndex : g)
+            EXPECT_EQ(meshIndex % 2, g[0] % 2);
+    }
+
+    auto sahStats = BLASGrouping::evaluate(meshes, sahGroups);
+    auto simpleStats = BLASGrouping::evaluate(meshes, BLASGrouping::partition(meshes, group, BLASGrouping::Strategy::Simple, 50000));
+    EXPECT_EQ(sahStats.overlapRatio, 0.0);
+    EXPECT_GT(simpleStats.overlapRatio, 0.0);
+    EXPECT_LT(sahStats.traversalCost, simpleStats.traversalCost);
+    EXPECT_EQ(sahStats.triangleCount, 100000u);
+    EXPECT_EQ(sahStats.blasMemory, simpleStats.blasMemory);
+}
+
+CPU_BENCHMARK(BLASGrouping_Partition)
+{
+    // Compare the partitioning time and the estimated cost of the strategies on a clustered scene.
+    const auto meshes = createClusteredMeshes(20000, 32);
+    const auto group = createGroup(meshes.size());
+
+    bench.setItemsPerIteration(meshes.size());
+    for (auto strategy : kStrategies)
+    {
+        std::vector<BLASGrouping::Group> groups;
+        bench.run(getStrategyName(strategy), [&]() { groups = BLASGrouping::partition(meshes, group, strategy, 1u << 24); });
+
+        auto stats = BLASGrouping::evaluate(meshes, groups);
+        logInfo(
+            "{}: {} BLASes, traversal cost {:.2f}, overlap {:.1f}%, BLAS memory {}.",
+            getStrategyName(strategy),
+            stats.groupCount,
+            stats.traversalCost,
+            stats.overlapRatio * 100.0,
+            formatByteSize(stats.blasMemory)
+        );
+    }
+}
+} // namespace Falcor
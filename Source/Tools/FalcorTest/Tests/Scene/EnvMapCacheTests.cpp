@@ -0,0 +1,139 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Lights/EnvMapCache.h"
+#include "Core/Platform/OS.h"
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+EnvMapCache::Key createKey(uint32_t value)
+{
+    SHA1 sha1;
+    sha1.update(value);
+    return sha1.finalize();
+}
+
+EnvMap::ImportanceMap createImportanceMap(uint32_t dimension)
+{
+    std::vector<float4> texels(32 * 16);
+    for (size_t i = 0; i < texels.size(); i++)
+        texels[i] = float4(float(i % 7), float(i % 5), float(i % 3), 1.f);
+    return EnvMap::computeImportanceMap(texels.data(), 32, 16, dimension, 4);
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& content)
+{
+    std::ofstream fs(path, std::ios_base::binary);
+    fs << content;
+}
+
+/// Use a temporary cache directory for the duration of a test.
+struct ScopedEnvMapCache
+{
+    EnvMapCache& cache = EnvMapCache::instance();
+    std::filesystem::path prevDirectory = cache.getDirectory();
+    uint64_t prevMaxSize = cache.getMaxSize();
+
+    ScopedEnvMapCache()
+    {
+        std::filesystem::path directory = getTempFilePath();
+        directory += "_envmapcache";
+        cache.setDirectory(directory);
+        cache.clear();
+        cache.resetStats();
+    }
+
+    ~ScopedEnvMapCache()
+    {
+        std::error_code ec;
+        cache.clear();
+        std::filesystem::remove_all(cache.getDirectory(), ec);
+        cache.setDirectory(prevDirectory);
+        cache.setMaxSize(prevMaxSize);
+        cache.resetStats();
+    }
+};
+} // namespace
+
+CPU_TEST(EnvMapCache_ReadWrite)
+{
+    ScopedEnvMapCache scope;
+    auto& cache = scope.cache;
+
+    EnvMap::ImportanceMap importanceMap;
+    EXPECT(!cache.read(createKey(0), importanceMap));
+
+    auto src = createImportanceMap(32);
+    cache.write(createKey(0), src);
+    EXPECT(cache.read(createKey(0), importanceMap));
+    EXPECT_EQ(importanceMap.dimension, src.dimension);
+    EXPECT_EQ(importanceMap.samples, src.samples);
+    EXPECT(importanceMap.data == src.data);
+
+    // Truncated entries are rejected.
+    auto entryPath = cache.getDirectory() / SHA1::toString(createKey(0));
+    std::filesystem::resize_file(entryPath, std::filesystem::file_size(entryPath) - sizeof(float));
+    EnvMap::ImportanceMap truncated;
+    EXPECT(!cache.read(createKey(0), truncated));
+    EXPECT_EQ(truncated.dimension, 0u);
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 2);
+    EXPECT_EQ(stats.writes, 1);
+    EXPECT_GT(stats.bytesRead, 0);
+    EXPECT_EQ(stats.bytesRead, stats.bytesWritten);
+}
+
+CPU_TEST(EnvMapCache_Key)
+{
+    std::filesystem::path pathA = getTempFilePath();
+    std::filesystem::path pathB = getTempFilePath();
+    writeFile(pathA, "envmap");
+    writeFile(pathB, "envmap");
+
+    // The key depends on the file content, not on the path.
+    auto key = EnvMapCache::getKey(pathA, ResourceFormat::RGBA32Float, 512, 64);
+    ASSERT(key.has_value());
+    EXPECT(EnvMapCache::getKey(pathB, ResourceFormat::RGBA32Float, 512, 64) == key);
+
+    EXPECT(EnvMapCache::getKey(pathA, ResourceFormat::RGBA8UnormSrgb, 512, 64) != key);
+    EXPECT(EnvMapCache::getKey(pathA, ResourceFormat::RGBA32Float, 256, 64) != key);
+    EXPECT(EnvMapCache::getKey(pathA, ResourceFormat::RGBA32Float, 512, 16) != key);
+
+    writeFile(pathB, "envmap2");
+    EXPECT(EnvMapCache::getKey(pathB, ResourceFormat::RGBA32Float, 512, 64) != key);
+
+    std::filesystem::remove(pathA);
+    std::filesystem::remove(pathB);
+    EXPECT(!EnvMapCache::getKey(pathA, ResourceFormat::RGBA32Float, 512, 64).has_value());
+}
+} // namespace Falcor
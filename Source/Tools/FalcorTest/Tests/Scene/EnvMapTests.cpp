@@ -27,8 +27,12 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Core/AssetResolver.h"
+#include "Core/Platform/OS.h"
 #include "Scene/Lights/EnvMap.h"
+#include "Scene/Lights/EnvMapCache.h"
 #include "Rendering/Lights/EnvMapSampler.h"
+#include "Utils/Color/ColorHelpers.slang"
+#include <random>
 
 namespace Falcor
 {
@@ -36,8 +40,95 @@ namespace
 {
 // TODO: This is not ideal, we should only access files in the runtime directory.
 const std::filesystem::path kEnvMapPath = getProjectDirectory() / "media/test_scenes/envmaps/20050806-03_hd.hdr";
+
+std::vector<float4> createRandomEnvMap(uint32_t width, uint32_t height)
+{
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform;
+    std::vector<float4> texels(width * height);
+    for (auto& texel : texels)
+        texel = float4(uniform(rng), uniform(rng), uniform(rng), 1.f) * 10.f;
+    return texels;
+}
+
+size_t getMipOffset(uint32_t dimension, uint32_t mip)
+{
+    size_t offset = 0;
+    for (uint32_t i = 0; i < mip; i++)
+        offset += size_t(dimension >> i) * (dimension >> i);
+    return offset;
+}
 } // namespace
 
+CPU_TEST(EnvMap_ImportanceMapConstant)
+{
+    // A constant environment map has constant importance at all mips.
+    const float3 radiance(1.f, 2.f, 3.f);
+    std::vector<float4> texels(16 * 8, float4(radiance, 1.f));
+    EnvMap::ImportanceMap importanceMap = EnvMap::computeImportanceMap(texels.data(), 16, 8, 32, 16);
+
+    EXPECT_EQ(importanceMap.dimension, 32u);
+    EXPECT_EQ(importanceMap.samples, 16u);
+    EXPECT_EQ(importanceMap.getMipCount(), 6u);
+    EXPECT_EQ(importanceMap.data.size(), getMipOffset(32, 6));
+
+    const float L = luminance(radiance);
+    for (float value : importanceMap.data)
+        EXPECT_LE(std::abs(value - L), 1e-5f * L);
+}
+
+CPU_TEST(EnvMap_ImportanceMapMips)
+{
+    const uint32_t dimension = 64;
+    std::vector<float4> texels = createRandomEnvMap(128, 64);
+    EnvMap::ImportanceMap importanceMap = EnvMap::computeImportanceMap(texels.data(), 128, 64, dimension, 4);
+    EXPECT_EQ(importanceMap.getMipCount(), 7u);
+
+    // Each texel is the average of the 2x2 texels at the next finer mip.
+    for (uint32_t mip = 1; mip < importanceMap.getMipCount(); mip++)
+    {
+        const float* pSrc = importanceMap.data.data() + getMipOffset(dimension, mip - 1);
+        const float* pDst = importanceMap.data.data() + getMipOffset(dimension, mip);
+        const uint32_t srcDim = dimension >> (mip - 1);
+        const uint32_t dstDim = dimension >> mip;
+        for (uint32_t y = 0; y < dstDim; y++)
+        {
+            for (uint32_t x = 0; x < dstDim; x++)
+            {
+                float ref = 0.25f * (pSrc[2 * y * srcDim + 2 * x] + pSrc[2 * y * srcDim + 2 * x + 1] + pSrc[(2 * y + 1) * srcDim + 2 * x] +
+                                     pSrc[(2 * y + 1) * srcDim + 2 * x + 1]);
+                EXPECT_LE(std::abs(pDst[y * dstDim + x] - ref), 1e-5f * ref) << "mip = " << mip << " x = " << x << " y = " << y;
+            }
+        }
+    }
+
+    // The octahedral map is equal-area, so the coarsest mip approximates the average luminance over the sphere.
+    double sum = 0.0, weightSum = 0.0;
+    for (uint32_t y = 0; y < 64; y++)
+    {
+        double weight = std::sin(M_PI * (y + 0.5) / 64);
+        for (uint32_t x = 0; x < 128; x++)
+            sum += weight * luminance(texels[y * 128 + x].xyz());
+        weightSum += weight * 128;
+    }
+    EXPECT_LE(std::abs(importanceMap.data.back() - sum / weightSum), 1e-2 * sum / weightSum);
+}
+
+CPU_BENCHMARK(EnvMap_ComputeImportanceMap)
+{
+    std::vector<float4> texels = createRandomEnvMap(2048, 1024);
+
+    bench.setItemsPerIteration(EnvMap::kDefaultImportanceMapDimension * EnvMap::kDefaultImportanceMapDimension);
+    bench.run(
+        [&]()
+        {
+            doNotOptimize(EnvMap::computeImportanceMap(
+                texels.data(), 2048, 1024, EnvMap::kDefaultImportanceMapDimension, EnvMap::kDefaultImportanceMapSamples
+            ));
+        }
+    );
+}
+
 GPU_TEST(EnvMap)
 {
     // Test loading a light probe.
@@ -65,4 +156,80 @@ GPU_TEST(EnvMap)
     EXPECT_EQ(w, h);
     EXPECT_EQ(w, 1 << (mipCount - 1));
 }
+
+GPU_TEST(EnvMap_ImportanceMapCPU)
+{
+    ref<EnvMap> pEnvMap = EnvMap::createFromFile(ctx.getDevice(), kEnvMapPath);
+    EXPECT_NE(pEnvMap, nullptr);
+    if (pEnvMap == nullptr)
+        return;
+
+    EnvMapSampler cpuSampler(ctx.getDevice(), pEnvMap, EnvMapSampler::SetupMode::CPU);
+    EnvMapSampler gpuSampler(ctx.getDevice(), pEnvMap, EnvMapSampler::SetupMode::GPU);
+
+    // The importance map is cached with the environment map.
+    const EnvMap::ImportanceMap& importanceMap = pEnvMap->getImportanceMap();
+    const float* pData = importanceMap.data.data();
+    EXPECT_EQ(pEnvMap->getImportanceMap().data.data(), pData);
+
+    auto pCpuMap = cpuSampler.getImportanceMap();
+    auto pGpuMap = gpuSampler.getImportanceMap();
+    EXPECT_EQ(pCpuMap->getWidth(), pGpuMap->getWidth());
+    EXPECT_EQ(pCpuMap->getMipCount(), pGpuMap->getMipCount());
+
+    // Hardware texture filtering uses reduced precision, so the maps are compared as distributions.
+    // The relative L1 distance of each mip bounds the difference in the sampling probabilities.
+    for (uint32_t mip = 0; mip < pGpuMap->getMipCount(); mip++)
+    {
+        std::vector<uint8_t> cpuData = ctx.getRenderContext()->readTextureSubresource(pCpuMap.get(), mip);
+        std::vector<uint8_t> gpuData = ctx.getRenderContext()->readTextureSubresource(pGpuMap.get(), mip);
+        EXPECT_EQ(cpuData.size(), gpuData.size());
+        if (cpuData.size() != gpuData.size())
+            return;
+
+        const float* pCpu = reinterpret_cast<const float*>(cpuData.data());
+        const float* pGpu = reinterpret_cast<const float*>(gpuData.data());
+        double diff = 0.0, sum = 0.0;
+        for (size_t i = 0; i < gpuData.size() / sizeof(float); i++)
+        {
+            diff += std::abs(pCpu[i] - pGpu[i]);
+            sum += pGpu[i];
+        }
+        EXPECT_LE(diff, 1e-3 * sum) << "mip = " << mip;
+    }
+}
+
+GPU_TEST(EnvMap_ImportanceMapDiskCache)
+{
+    EnvMapCache& cache = EnvMapCache::instance();
+    std::filesystem::path prevDirectory = cache.getDirectory();
+    std::filesystem::path directory = getTempFilePath();
+    directory += "_envmapcache";
+    cache.setDirectory(directory);
+    cache.resetStats();
+
+    // Environment maps loaded from the same file share the importance map through the disk cache.
+    ref<EnvMap> pEnvMapA = EnvMap::createFromFile(ctx.getDevice(), kEnvMapPath);
+    ref<EnvMap> pEnvMapB = EnvMap::createFromFile(ctx.getDevice(), kEnvMapPath);
+    if (pEnvMapA && pEnvMapB)
+    {
+        const EnvMap::ImportanceMap& importanceMapA = pEnvMapA->getImportanceMap();
+        const EnvMap::ImportanceMap& importanceMapB = pEnvMapB->getImportanceMap();
+        EXPECT(importanceMapA.data == importanceMapB.data);
+
+        auto stats = cache.getStats();
+        EXPECT_EQ(stats.misses, 1);
+        EXPECT_EQ(stats.writes, 1);
+        EXPECT_EQ(stats.hits, 1);
+    }
+
+    std::error_code ec;
+    cache.clear();
+    std::filesystem::remove_all(directory, ec);
+    cache.setDirectory(prevDirectory);
+    cache.resetStats();
+
+    EXPECT_NE(pEnvMapA, nullptr);
+    EXPECT_NE(pEnvMapB, nullptr);
+}
 } // namespace Falcor
@@ -0,0 +1,132 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/GridCache.h"
+#include "Core/Platform/OS.h"
+#include <nanovdb/util/GridBuilder.h>
+#include <nanovdb/util/Primitives.h>
+
+namespace Falcor
+{
+namespace
+{
+GridCache::Key createKey(uint32_t value)
+{
+    SHA1 sha1;
+    sha1.update(value);
+    return sha1.finalize();
+}
+
+Grid::HostData createHostData(double radius)
+{
+    return Grid::createHostData(nanovdb::createFogVolumeSphere<float>(radius, nanovdb::Vec3d(0.0), 1.0, 2.0, nanovdb::Vec3d(0.0), "density"));
+}
+
+/// Use a temporary cache directory for the duration of a test.
+struct ScopedGridCache
+{
+    GridCache& cache = GridCache::instance();
+    std::filesystem::path prevDirectory = cache.getDirectory();
+    uint64_t prevMaxSize = cache.getMaxSize();
+
+    ScopedGridCache()
+    {
+        std::filesystem::path directory = getTempFilePath();
+        directory += "_gridcache";
+        cache.setDirectory(directory);
+        cache.clear();
+        cache.resetStats();
+    }
+
+    ~ScopedGridCache()
+    {
+        std::error_code ec;
+        cache.clear();
+        std::filesystem::remove_all(cache.getDirectory(), ec);
+        cache.setDirectory(prevDirectory);
+        cache.setMaxSize(prevMaxSize);
+        cache.resetStats();
+    }
+};
+} // namespace
+
+CPU_TEST(GridCache_ReadWrite)
+{
+    ScopedGridCache scope;
+    auto& cache = scope.cache;
+
+    Grid::HostData hostData;
+    EXPECT(!cache.read(createKey(0), hostData));
+
+    auto src = createHostData(8.0);
+    cache.write(createKey(0), src);
+    EXPECT(cache.read(createKey(0), hostData));
+    ASSERT(hostData.gridHandle.grid<float>() != nullptr);
+    EXPECT_EQ(hostData.gridHandle.size(), src.gridHandle.size());
+    EXPECT_EQ(hostData.gridHandle.grid<float>()->activeVoxelCount(), src.gridHandle.grid<float>()->activeVoxelCount());
+    EXPECT(all(hostData.bricks.rangeSize == src.bricks.rangeSize));
+    EXPECT(all(hostData.bricks.atlasSize == src.bricks.atlasSize));
+    EXPECT(hostData.bricks.atlasFormat == src.bricks.atlasFormat);
+    EXPECT(hostData.bricks.rangeData == src.bricks.rangeData);
+    EXPECT(hostData.bricks.ptrData == src.bricks.ptrData);
+    EXPECT(hostData.bricks.atlasData == src.bricks.atlasData);
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.writes, 1);
+    EXPECT_GT(stats.bytesRead, 0);
+    EXPECT_EQ(stats.bytesRead, stats.bytesWritten);
+}
+
+CPU_TEST(GridCache_EvictLeastRecentlyUsed)
+{
+    ScopedGridCache scope;
+    auto& cache = scope.cache;
+
+    // Room for two entries.
+    auto src = createHostData(8.0);
+    cache.write(createKey(0), src);
+    const uint64_t entrySize = cache.getStats().bytesWritten;
+    cache.setMaxSize(entrySize * 5 / 2);
+    cache.write(createKey(1), src);
+
+    // Make the first entry the most recently used one.
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(cache.getDirectory() / SHA1::toString(createKey(1)), now - std::chrono::hours(1));
+    Grid::HostData hostData;
+    EXPECT(cache.read(createKey(0), hostData));
+
+    cache.write(createKey(2), src);
+    EXPECT_EQ(cache.getStats().evictions, 1);
+
+    EXPECT(cache.read(createKey(0), hostData));
+    EXPECT(!cache.read(createKey(1), hostData));
+    EXPECT(cache.read(createKey(2), hostData));
+}
+} // namespace Falcor
@@ -0,0 +1,221 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Volume/GridSequenceStreamer.h"
+#include "Scene/Volume/GridVolume.h"
+#include <nanovdb/util/GridBuilder.h>
+#include <nanovdb/util/Primitives.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace Falcor
+{
+namespace
+{
+const auto kTimeout = std::chrono::seconds(10);
+
+/// Create the host data of a frame: a small sphere centered at x = 10 * frame.
+Grid::HostData createFrame(uint32_t frame)
+{
+    auto handle = nanovdb::createFogVolumeSphere<float>(3.0, nanovdb::Vec3d(10.0 * frame, 0.0, 0.0), 1.0, 2.0, nanovdb::Vec3d(0.0), "density");
+    return Grid::createHostData(std::move(handle));
+}
+
+/// Check that a grid holds the given frame.
+bool isFrame(const ref<Grid>& pGrid, uint32_t frame)
+{
+    return pGrid && std::abs(pGrid->getWorldBounds().center().x - 10.f * frame) < 1.f;
+}
+
+/// Wait until a condition polled on the calling thread holds.
+template<typename Pred>
+bool waitUntil(Pred pred)
+{
+    auto deadline = std::chrono::steady_clock::now() + kTimeout;
+    while (!pred())
+    {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/// Frame loader recording the loaded frames. Loads block until the frame is released.
+struct TestLoader
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::set<uint32_t> released;
+    bool releaseAll = false;
+    std::set<uint32_t> inFlight;            ///< Frames currently blocked in the loader.
+    std::map<uint32_t, uint32_t> loadCount; ///< Number of loads per frame.
+
+    GridSequenceStreamer::LoadFunc getFunc()
+    {
+        return [this](uint32_t frame, Grid::HostData& hostData)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                inFlight.insert(frame);
+                loadCount[frame]++;
+                condition.notify_all();
+                condition.wait(lock, [&]() { return releaseAll || released.count(frame) != 0; });
+                inFlight.erase(frame);
+                condition.notify_all();
+            }
+            hostData = createFrame(frame);
+            return true;
+        };
+    }
+
+    void release(std::set<uint32_t> frames)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released.insert(frames.begin(), frames.end());
+        condition.notify_all();
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        releaseAll = true;
+        condition.notify_all();
+    }
+
+    bool waitForInFlight(const std::set<uint32_t>& frames)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, kTimeout, [&]() { return inFlight == frames; });
+    }
+
+    uint32_t getLoadCount(uint32_t frame)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = loadCount.find(frame);
+        return it != loadCount.end() ? it->second : 0;
+    }
+};
+
+/// Releases all frames before the streamer is destroyed so that its workers can terminate.
+struct ScopedRelease
+{
+    TestLoader& loader;
+    ~ScopedRelease() { loader.release(); }
+};
+} // namespace
+
+GPU_TEST(GridSequenceStreamer_PrefetchAndEvict)
+{
+    TestLoader loader;
+    loader.release({0});
+    auto pStreamer = GridSequenceStreamer::create(ctx.getDevice(), 16, loader.getFunc(), 8);
+    ScopedRelease scopedRelease{loader};
+
+    EXPECT(pStreamer->setFrame(0));
+    EXPECT_EQ(pStreamer->getFrame(), 0);
+    EXPECT(isFrame(pStreamer->getGrid(), 0));
+
+    // The 4 workers prefetch the frames closest to the current frame first.
+    EXPECT(loader.waitForInFlight({1, 2, 3, 4}));
+
+    loader.release();
+    EXPECT(waitUntil([&]() { return pStreamer->getResidentFrameCount() == 7; }));
+    for (uint32_t frame = 0; frame < 16; ++frame)
+        EXPECT_EQ_MSG(loader.getLoadCount(frame), frame < 8 ? 1 : 0, fmt::format("frame {}", frame));
+
+    // Moving the window evicts frames 1-3, keeps the prefetched frames 4-7 and loads frames 8-11.
+    ref<Grid> pGrid = pStreamer->getGrid();
+    EXPECT(pStreamer->setFrame(4));
+    EXPECT(pStreamer->getGrid() == pGrid);
+    EXPECT(isFrame(pStreamer->getGrid(), 4));
+    EXPECT(waitUntil([&]() { return pStreamer->getResidentFrameCount() == 7; }));
+    for (uint32_t frame = 0; frame < 16; ++frame)
+        EXPECT_EQ_MSG(loader.getLoadCount(frame), frame < 12 ? 1 : 0, fmt::format("frame {}", frame));
+
+    // Setting the current frame again does nothing.
+    EXPECT(!pStreamer->setFrame(4));
+}
+
+GPU_TEST(GridSequenceStreamer_FrameChangeWhileStreaming)
+{
+    TestLoader loader;
+    loader.release({0});
+    auto pStreamer = GridSequenceStreamer::create(ctx.getDevice(), 16, loader.getFunc(), 8);
+    ScopedRelease scopedRelease{loader};
+
+    EXPECT(pStreamer->setFrame(0));
+    EXPECT(loader.waitForInFlight({1, 2, 3, 4}));
+
+    // Jump ahead while frames 1-4 are loading. Frames 3 and 4 stay blocked, so they are still loading after they
+    // left the window (frames 9-15 and 0). The other two workers load the frames of the new window.
+    loader.release({0, 1, 2, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15});
+    EXPECT(pStreamer->setFrame(9));
+    EXPECT_EQ(pStreamer->getFrame(), 9);
+    EXPECT(isFrame(pStreamer->getGrid(), 9));
+    EXPECT(waitUntil([&]() { return pStreamer->getResidentFrameCount() == 7; }));
+    EXPECT(loader.waitForInFlight({3, 4}));
+
+    // Frames that finish loading after they left the window are discarded.
+    loader.release();
+    EXPECT(loader.waitForInFlight({}));
+    EXPECT(waitUntil([&]() { return pStreamer->getResidentFrameCount() == 7; }));
+    EXPECT_EQ(loader.getLoadCount(0), 2);
+    for (uint32_t frame : {1, 2, 3, 4, 9, 10, 11, 12, 13, 14, 15})
+        EXPECT_EQ_MSG(loader.getLoadCount(frame), 1, fmt::format("frame {}", frame));
+    EXPECT_EQ(loader.getLoadCount(8), 0);
+
+    // Frame 0 was loaded again as part of the new window and is resident.
+    EXPECT(pStreamer->setFrame(0));
+    EXPECT(isFrame(pStreamer->getGrid(), 0));
+}
+
+GPU_TEST(GridVolume_StreamKeepsGridFrame)
+{
+    auto pVolume = GridVolume::create(ctx.getDevice(), "volume");
+    pVolume->setGridFrame(5);
+
+    TestLoader loader;
+    loader.release();
+    auto pStreamer = GridSequenceStreamer::create(ctx.getDevice(), 8, loader.getFunc(), 4);
+    pVolume->setGridStreamer(GridVolume::GridSlot::Density, pStreamer);
+
+    EXPECT(pVolume->getGridStreamer(GridVolume::GridSlot::Density) == pStreamer);
+    EXPECT_EQ(pVolume->getGridFrameCount(), 8);
+    EXPECT_EQ(pVolume->getGridFrame(), 5);
+    EXPECT_EQ(pStreamer->getFrame(), 5);
+    EXPECT(isFrame(pVolume->getGrid(GridVolume::GridSlot::Density), 5));
+
+    pVolume->setGridFrame(2);
+    EXPECT_EQ(pStreamer->getFrame(), 2);
+    EXPECT(isFrame(pVolume->getGrid(GridVolume::GridSlot::Density), 2));
+}
+} // namespace Falcor
@@ -0,0 +1,373 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/Lights/LightCollection.h"
+#include "Scene/Lights/LightCollectionShared.slang"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Animation/Animation.h"
+#include "Scene/Material/StandardMaterial.h"
+#include <cstring>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/// Creates a texture where the left half of the texels is white and the right half is black.
+LightCollection::EmissiveTexture createHalfTexture(uint32_t width, uint32_t height)
+{
+    LightCollection::EmissiveTexture texture;
+    texture.width = width;
+    texture.height = height;
+    texture.texels.resize(width * height);
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+            texture.texels[y * width + x] = x < width / 2 ? float3(1.f) : float3(0.f);
+    return texture;
+}
+
+/// Creates an emissive texture with random texels.
+ref<Texture> createEmissiveTexture(ref<Device> pDevice, uint32_t width, uint32_t height, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::vector<float4> texels(width * height);
+    for (auto& texel : texels)
+        texel = float4(uniform(rng), uniform(rng), uniform(rng), 1.f);
+    return pDevice->createTexture2D(width, height, ResourceFormat::RGBA32Float, 1, 1, texels.data(), ResourceBindFlags::ShaderResource);
+}
+
+/// Creates an emissive texture where the left half of the texels is white and the right half is black.
+ref<Texture> createHalfEmissiveTexture(ref<Device> pDevice, uint32_t width, uint32_t height)
+{
+    std::vector<float4> texels(width * height);
+    for (uint32_t y = 0; y < height; y++)
+        for (uint32_t x = 0; x < width; x++)
+            texels[y * width + x] = x < width / 2 ? float4(1.f) : float4(0.f, 0.f, 0.f, 1.f);
+    return pDevice->createTexture2D(width, height, ResourceFormat::RGBA32Float, 1, 1, texels.data(), ResourceBindFlags::ShaderResource);
+}
+
+struct EmissiveScene
+{
+    ref<Scene> pScene;
+    ref<StandardMaterial> pConstantMaterial;
+    ref<StandardMaterial> pTexturedMaterial;
+};
+
+/**
+ * Build a scene with spheres alternating between constant and textured emission.
+ * Every other instance of each material is animated. The animation moves the instance and mirrors it
+ * over time (scaling goes from 1 at t=0 to -1 at t=1), which flips the winding of its triangles.
+ */
+EmissiveScene buildEmissiveScene(ref<Device> pDevice, uint32_t instanceCount)
+{
+    EmissiveScene result;
+    SceneBuilder builder(pDevice, Settings());
+
+    result.pConstantMaterial = StandardMaterial::create(pDevice, "Constant");
+    result.pConstantMaterial->setEmissiveColor(float3(1.f, 0.5f, 0.25f));
+    result.pConstantMaterial->setEmissiveFactor(2.f);
+
+    result.pTexturedMaterial = StandardMaterial::create(pDevice, "Textured");
+    result.pTexturedMaterial->setEmissiveColor(float3(1.f));
+    result.pTexturedMaterial->setEmissiveTexture(createEmissiveTexture(pDevice, 37, 23, 0));
+    result.pTexturedMaterial->setEmissiveFactor(3.f);
+
+    const MeshID meshIDs[2] = {
+        builder.addTriangleMesh(TriangleMesh::createSphere(0.5f, 16, 8), result.pConstantMaterial),
+        builder.addTriangleMesh(TriangleMesh::createSphere(0.5f, 16, 8), result.pTexturedMaterial),
+    };
+
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        float3 translation = float3(float(i) * 2.f, 0.f, 0.f);
+        NodeID nodeID = builder.addNode(SceneBuilder::Node{fmt::format("Node{}", i), math::matrixFromTranslation(translation), float4x4::identity()});
+        builder.addMeshInstance(nodeID, meshIDs[i % 2]);
+
+        if ((i / 2) % 2 == 1)
+        {
+            auto pAnimation = Animation::create(fmt::format("Anim{}", i), nodeID, 1.0);
+            pAnimation->addKeyframe(Animation::Keyframe{0.0, translation, float3(1.f)});
+            pAnimation->addKeyframe(Animation::Keyframe{1.0, translation + float3(0.f, 1.f, 0.f), float3(-1.f, 1.f, 2.f)});
+            builder.addAnimation(pAnimation);
+        }
+    }
+
+    result.pScene = builder.getScene();
+    return result;
+}
+
+bool isClose(float a, float b, float relEps)
+{
+    return std::abs(a - b) <= relEps * std::max(1.f, std::max(std::abs(a), std::abs(b)));
+}
+
+bool isClose(float3 a, float3 b, float relEps)
+{
+    return isClose(a.x, b.x, relEps) && isClose(a.y, b.y, relEps) && isClose(a.z, b.z, relEps);
+}
+} // namespace
+
+class LightCollectionTest
+{
+public:
+    static std::vector<PackedEmissiveTriangle> getTriangleData(const LightCollection& lightCollection)
+    {
+        return lightCollection.mpTriangleData->getElements<PackedEmissiveTriangle>();
+    }
+
+    static std::vector<EmissiveFlux> getFluxData(const LightCollection& lightCollection)
+    {
+        return lightCollection.mpFluxData->getElements<EmissiveFlux>();
+    }
+
+    static std::vector<uint32_t> getActiveTriangleList(const LightCollection& lightCollection)
+    {
+        const uint32_t activeCount = (uint32_t)lightCollection.mActiveTriangleList.size();
+        if (activeCount == 0)
+            return {};
+        return lightCollection.mpActiveTriangleList->getElements<uint32_t>(0, activeCount);
+    }
+
+    static std::vector<uint32_t> getTriToActiveList(const LightCollection& lightCollection)
+    {
+        return lightCollection.mpTriToActiveList->getElements<uint32_t>(0, lightCollection.getTotalLightCount());
+    }
+};
+
+CPU_TEST(LightCollection_IntegrateConstant)
+{
+    LightCollection::EmissiveTexture texture;
+    texture.width = 7;
+    texture.height = 5;
+    texture.texels.assign(texture.width * texture.height, float3(0.25f, 0.5f, 2.f));
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform(-2.f, 2.f);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        const float2 texCoords[3] = {
+            float2(uniform(rng), uniform(rng)),
+            float2(uniform(rng), uniform(rng)),
+            float2(uniform(rng), uniform(rng)),
+        };
+        float3 color = LightCollection::integrateEmissiveTexture(texture, texCoords);
+        EXPECT_LE(std::abs(color.x - 0.25f), 1e-5f);
+        EXPECT_LE(std::abs(color.y - 0.5f), 1e-5f);
+        EXPECT_LE(std::abs(color.z - 2.f), 1e-5f);
+    }
+}
+
+CPU_TEST(LightCollection_IntegrateCoverage)
+{
+    auto texture = createHalfTexture(4, 4);
+
+    // The triangle covers 1/4 of the white half and 3/4 of the black half.
+    const float2 texCoords0[3] = { float2(0.f, 0.f), float2(1.f, 0.f), float2(1.f, 1.f) };
+    EXPECT_LE(std::abs(LightCollection::integrateEmissiveTexture(texture, texCoords0).x - 0.25f), 1e-5f);
+
+    // Same with opposite winding and covering 3/4 white.
+    const float2 texCoords1[3] = { float2(0.f, 0.f), float2(0.f, 1.f), float2(1.f, 0.f) };
+    EXPECT_LE(std::abs(LightCollection::integrateEmissiveTexture(texture, texCoords1).x - 0.75f), 1e-5f);
+
+    // Texture coordinates outside [0,1] wrap around.
+    const float2 texCoords2[3] = { float2(3.f, -2.f), float2(4.f, -2.f), float2(3.f, -1.f) };
+    EXPECT_LE(std::abs(LightCollection::integrateEmissiveTexture(texture, texCoords2).x - 0.75f), 1e-5f);
+
+    // Triangle inside a single texel.
+    const float2 texCoords3[3] = { float2(0.01f, 0.01f), float2(0.2f, 0.01f), float2(0.01f, 0.2f) };
+    EXPECT_EQ(LightCollection::integrateEmissiveTexture(texture, texCoords3).x, 1.f);
+}
+
+CPU_TEST(LightCollection_IntegrateDegenerate)
+{
+    auto texture = createHalfTexture(4, 4);
+
+    // Degenerate triangles in texture space use the average of the texels at the vertices.
+    const float2 texCoords[3] = { float2(0.1f, 0.1f), float2(0.1f, 0.1f), float2(0.9f, 0.9f) };
+    EXPECT_LE(std::abs(LightCollection::integrateEmissiveTexture(texture, texCoords).x - 2.f / 3.f), 1e-5f);
+}
+
+CPU_TEST(LightCollection_EmissiveTextureAddressing)
+{
+    auto texture = createHalfTexture(4, 1);
+
+    texture.addressModeU = TextureAddressingMode::Wrap;
+    EXPECT_EQ(texture.fetch(-1, 0).x, 0.f);
+    EXPECT_EQ(texture.fetch(4, 0).x, 1.f);
+
+    texture.addressModeU = TextureAddressingMode::Mirror;
+    EXPECT_EQ(texture.fetch(-1, 0).x, 1.f);
+    EXPECT_EQ(texture.fetch(4, 0).x, 0.f);
+    EXPECT_EQ(texture.fetch(7, 0).x, 1.f);
+
+    texture.addressModeU = TextureAddressingMode::Clamp;
+    EXPECT_EQ(texture.fetch(-5, 0).x, 1.f);
+    EXPECT_EQ(texture.fetch(9, 0).x, 0.f);
+
+    texture.addressModeU = TextureAddressingMode::Border;
+    EXPECT_EQ(texture.fetch(-1, 0).x, 0.f);
+    EXPECT_EQ(texture.fetch(1, 0).x, 1.f);
+}
+
+GPU_TEST(LightCollection_CPUBuildMatchesGPU)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    auto scene = buildEmissiveScene(pDevice, 8);
+    scene.pScene->update(pRenderContext, 0.75);
+
+    auto pCPU = LightCollection::create(pDevice, pRenderContext, scene.pScene.get());
+    auto pGPU = LightCollection::create(pDevice, pRenderContext, scene.pScene.get(), false);
+    ASSERT(pCPU->isBuiltOnCPU());
+    ASSERT(!pGPU->isBuiltOnCPU());
+    ASSERT_EQ(pCPU->getTotalLightCount(), pGPU->getTotalLightCount());
+    ASSERT_GT(pCPU->getTotalLightCount(), 0u);
+
+    // Compare the uploaded triangle and flux data.
+    // The GPU path transforms and integrates on the GPU, so we allow for small differences.
+    const auto cpuTriangles = LightCollectionTest::getTriangleData(*pCPU);
+    const auto gpuTriangles = LightCollectionTest::getTriangleData(*pGPU);
+    const auto cpuFlux = LightCollectionTest::getFluxData(*pCPU);
+    const auto gpuFlux = LightCollectionTest::getFluxData(*pGPU);
+    ASSERT_EQ(cpuTriangles.size(), gpuTriangles.size());
+    ASSERT_EQ(cpuFlux.size(), gpuFlux.size());
+
+    for (size_t i = 0; i < cpuTriangles.size(); i++)
+    {
+        const EmissiveTriangle cpu = cpuTriangles[i].unpack();
+        const EmissiveTriangle gpu = gpuTriangles[i].unpack();
+        for (uint32_t j = 0; j < 3; j++)
+        {
+            EXPECT(isClose(cpu.posW[j], gpu.posW[j], 1e-5f)) << fmt::format("triangle {} vertex {}", i, j);
+            EXPECT(all(cpu.texCoords[j] == gpu.texCoords[j])) << fmt::format("triangle {} vertex {}", i, j);
+        }
+        EXPECT(isClose(cpu.normal, gpu.normal, 1e-3f)) << fmt::format("triangle {}", i);
+        EXPECT(isClose(cpu.area, gpu.area, 1e-4f)) << fmt::format("triangle {}", i);
+        EXPECT_EQ(cpu.materialID, gpu.materialID) << fmt::format("triangle {}", i);
+        EXPECT_EQ(cpu.lightIdx, gpu.lightIdx) << fmt::format("triangle {}", i);
+
+        EXPECT(isClose(cpuFlux[i].flux, gpuFlux[i].flux, 1e-3f)) << fmt::format("triangle {}", i);
+        EXPECT(isClose(cpuFlux[i].averageRadiance, gpuFlux[i].averageRadiance, 1e-3f)) << fmt::format("triangle {}", i);
+    }
+
+    const auto& cpuStats = pCPU->getStats(pRenderContext);
+    const auto& gpuStats = pGPU->getStats(pRenderContext);
+    EXPECT_EQ(cpuStats.trianglesActive, gpuStats.trianglesActive);
+    EXPECT_EQ(cpuStats.trianglesActiveTextured, gpuStats.trianglesActiveTextured);
+}
+
+GPU_TEST(LightCollection_IncrementalUpdate)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    RenderContext* pRenderContext = ctx.getRenderContext();
+    const uint32_t instanceCount = 8;
+    auto scene = buildEmissiveScene(pDevice, instanceCount);
+    scene.pScene->update(pRenderContext, 0.0);
+
+    const auto& pLightCollection = scene.pScene->getLightCollection(pRenderContext);
+    ASSERT(pLightCollection->isBuiltOnCPU());
+
+    // After each update, the uploaded data must match a light collection built from scratch.
+    auto checkUpdate = [&](size_t expectedUpdatedCount)
+    {
+        EXPECT_EQ(pLightCollection->getUpdatedMeshLights().size(), expectedUpdatedCount);
+
+        auto pReference = LightCollection::create(pDevice, pRenderContext, scene.pScene.get());
+        const auto triangles = LightCollectionTest::getTriangleData(*pLightCollection);
+        const auto referenceTriangles = LightCollectionTest::getTriangleData(*pReference);
+        const auto flux = LightCollectionTest::getFluxData(*pLightCollection);
+        const auto referenceFlux = LightCollectionTest::getFluxData(*pReference);
+        ASSERT_EQ(triangles.size(), referenceTriangles.size());
+        ASSERT_EQ(flux.size(), referenceFlux.size());
+        EXPECT(std::memcmp(triangles.data(), referenceTriangles.data(), triangles.size() * sizeof(PackedEmissiveTriangle)) == 0);
+        EXPECT(std::memcmp(flux.data(), referenceFlux.data(), flux.size() * sizeof(EmissiveFlux)) == 0);
+        EXPECT_EQ(pLightCollection->getActiveLightCount(pRenderContext), pReference->getActiveLightCount(pRenderContext));
+        EXPECT(LightCollectionTest::getActiveTriangleList(*pLightCollection) == LightCollectionTest::getActiveTriangleList(*pReference));
+        EXPECT(LightCollectionTest::getTriToActiveList(*pLightCollection) == LightCollectionTest::getTriToActiveList(*pReference));
+    };
+
+    // Transform changes update the animated instances only.
+    const size_t animatedCount = instanceCount / 2;
+    for (double time : {0.25, 0.75})
+    {
+        scene.pScene->update(pRenderContext, time);
+        checkUpdate(animatedCount);
+    }
+
+    // Update once more at the same time so that the animation controller stops reporting changed matrices.
+    scene.pScene->update(pRenderContext, 0.75);
+
+    // Emissive changes update the instances of the changed material only.
+    scene.pConstantMaterial->setEmissiveFactor(5.f);
+    scene.pScene->update(pRenderContext, 0.75);
+    checkUpdate(instanceCount / 2);
+
+    scene.pTexturedMaterial->setEmissiveTexture(createEmissiveTexture(pDevice, 16, 16, 1));
+    scene.pScene->update(pRenderContext, 0.75);
+    checkUpdate(instanceCount / 2);
+
+    // Triangles in the black half of the texture stop emitting and are culled from the active list.
+    const uint32_t activeCount = pLightCollection->getActiveLightCount(pRenderContext);
+    scene.pTexturedMaterial->setEmissiveTexture(createHalfEmissiveTexture(pDevice, 16, 16));
+    scene.pScene->update(pRenderContext, 0.75);
+    checkUpdate(instanceCount / 2);
+    EXPECT_LT(pLightCollection->getActiveLightCount(pRenderContext), activeCount);
+
+    // The culled triangles start emitting again and are added back to the active list.
+    scene.pTexturedMaterial->setEmissiveTexture(createEmissiveTexture(pDevice, 16, 16, 2));
+    scene.pScene->update(pRenderContext, 0.75);
+    checkUpdate(instanceCount / 2);
+    EXPECT_EQ(pLightCollection->getActiveLightCount(pRenderContext), activeCount);
+}
+
+CPU_BENCHMARK(LightCollection_IntegrateEmissiveTexture)
+{
+    auto texture = createHalfTexture(1024, 1024);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> uniform(0.f, 1.f);
+    std::vector<float2> texCoords(3 * 1000);
+    for (size_t i = 0; i < texCoords.size(); i += 3)
+    {
+        // Small triangles of up to 50x50 texels.
+        const float2 origin = float2(uniform(rng), uniform(rng));
+        for (size_t j = 0; j < 3; j++) texCoords[i + j] = origin + float2(uniform(rng), uniform(rng)) * 0.05f;
+    }
+
+    bench.setItemsPerIteration(texCoords.size() / 3);
+    bench.run([&]()
+    {
+        for (size_t i = 0; i < texCoords.size(); i += 3)
+        {
+            float3 color = LightCollection::integrateEmissiveTexture(texture, &texCoords[i]);
+            doNotOptimize(color);
+        }
+    });
+}
+} // namespace Falcor
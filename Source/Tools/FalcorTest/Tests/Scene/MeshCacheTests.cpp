@@ -0,0 +1,196 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshCache.h"
+#include "Scene/Material/StandardMaterial.h"
+#include "Core/Platform/OS.h"
+#include <fstream>
+
+namespace Falcor
+{
+namespace
+{
+MeshCache::Key createKey(uint32_t value)
+{
+    SHA1 sha1;
+    sha1.update(value);
+    return sha1.finalize();
+}
+
+SceneBuilder::ProcessedMesh createMesh(uint32_t vertexCount, uint32_t seed)
+{
+    SceneBuilder::ProcessedMesh mesh;
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        StaticVertexData v = {};
+        v.position = float3(float(i), float(seed), 0.f);
+        v.texCrd = float2(float(i) / vertexCount, 0.f);
+        mesh.staticData.push_back(v);
+    }
+    for (uint32_t i = 0; i + 2 < vertexCount; i++)
+        mesh.indexData.insert(mesh.indexData.end(), {i, i + 1, i + 2});
+    mesh.indexCount = mesh.indexData.size();
+    return mesh;
+}
+
+/// Use a temporary cache directory for the duration of a test.
+struct ScopedMeshCache
+{
+    MeshCache& cache = MeshCache::instance();
+    std::filesystem::path prevDirectory = cache.getDirectory();
+    uint64_t prevMaxSize = cache.getMaxSize();
+
+    ScopedMeshCache()
+    {
+        std::filesystem::path directory = getTempFilePath();
+        directory += "_meshcache";
+        cache.setDirectory(directory);
+        cache.clear();
+        cache.resetStats();
+    }
+
+    ~ScopedMeshCache()
+    {
+        std::error_code ec;
+        cache.clear();
+        std::filesystem::remove_all(cache.getDirectory(), ec);
+        cache.setDirectory(prevDirectory);
+        cache.setMaxSize(prevMaxSize);
+        cache.resetStats();
+    }
+};
+} // namespace
+
+CPU_TEST(MeshCache_ReadWrite)
+{
+    ScopedMeshCache scope;
+    auto& cache = scope.cache;
+
+    SceneBuilder::ProcessedMesh mesh;
+    EXPECT(!cache.read(createKey(0), mesh));
+
+    auto src = createMesh(100, 0);
+    cache.write(createKey(0), src);
+    EXPECT(cache.read(createKey(0), mesh));
+    EXPECT_EQ(mesh.indexCount, src.indexCount);
+    EXPECT_EQ(mesh.use16BitIndices, src.use16BitIndices);
+    EXPECT(mesh.indexData == src.indexData);
+    ASSERT_EQ(mesh.staticData.size(), src.staticData.size());
+    for (size_t i = 0; i < src.staticData.size(); i++)
+    {
+        EXPECT(all(mesh.staticData[i].position == src.staticData[i].position));
+        EXPECT(all(mesh.staticData[i].texCrd == src.staticData[i].texCrd));
+    }
+    EXPECT(mesh.skinningData.empty());
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.writes, 1);
+    EXPECT_GT(stats.bytesRead, 0);
+    EXPECT_EQ(stats.bytesRead, stats.bytesWritten);
+}
+
+CPU_TEST(MeshCache_EvictLeastRecentlyUsed)
+{
+    ScopedMeshCache scope;
+    auto& cache = scope.cache;
+
+    // Room for two entries.
+    const uint32_t vertexCount = 1000;
+    cache.setMaxSize(vertexCount * sizeof(StaticVertexData) * 5 / 2);
+
+    cache.write(createKey(0), createMesh(vertexCount, 0));
+    cache.write(createKey(1), createMesh(vertexCount, 1));
+
+    // Make the first entry the most recently used one.
+    auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(cache.getDirectory() / SHA1::toString(createKey(1)), now - std::chrono::hours(1));
+    SceneBuilder::ProcessedMesh mesh;
+    EXPECT(cache.read(createKey(0), mesh));
+
+    cache.write(createKey(2), createMesh(vertexCount, 2));
+    EXPECT_EQ(cache.getStats().evictions, 1);
+
+    EXPECT(cache.read(createKey(0), mesh));
+    EXPECT(!cache.read(createKey(1), mesh));
+    EXPECT(cache.read(createKey(2), mesh));
+    EXPECT_EQ(mesh.staticData[0].position.y, 2.f);
+}
+
+GPU_TEST(MeshCache_FileKeys)
+{
+    ScopedMeshCache scope;
+
+    std::filesystem::path path = getTempFilePath();
+    auto writeFile = [&](const char* content) { std::ofstream(path, std::ios_base::binary) << content; };
+    writeFile("mesh file");
+
+    // Meshes are keyed by the file content and the name of the mesh.
+    auto pMaterial = StandardMaterial::create(ctx.getDevice(), "Material");
+    auto pTriangleMesh = TriangleMesh::createQuad();
+    SceneBuilder builder(ctx.getDevice(), Settings(), SceneBuilder::Flags::UseCache);
+    auto key = builder.getMeshCacheKey({path}, "mesh");
+    ASSERT(key.has_value());
+    EXPECT(builder.getMeshCacheKey({path}, "other") != key);
+    EXPECT(!builder.getMeshCacheKey({path, path.string() + "_missing"}, "mesh"));
+
+    SceneBuilder::Mesh mesh;
+    mesh.name = "quad";
+    mesh.topology = Vao::Topology::TriangleList;
+    mesh.pMaterial = pMaterial;
+    mesh.cacheKey = key;
+    SceneBuilder::ProcessedMesh processedMesh;
+    EXPECT(!builder.isMeshCached(*key, pMaterial));
+    EXPECT(!builder.readCachedMesh(mesh, processedMesh));
+
+    // Adding the mesh with the key writes it to the cache.
+    builder.addTriangleMesh(pTriangleMesh, pMaterial, false, key);
+    EXPECT(builder.isMeshCached(*key, pMaterial));
+    EXPECT(builder.readCachedMesh(mesh, processedMesh));
+    EXPECT_EQ(processedMesh.name, "quad");
+    EXPECT(processedMesh.pMaterial == pMaterial);
+    EXPECT_EQ(processedMesh.indexCount, pTriangleMesh->getIndices().size());
+    EXPECT_EQ(processedMesh.staticData.size(), pTriangleMesh->getVertices().size());
+
+    // A modified file gives a new key.
+    writeFile("modified mesh file");
+    SceneBuilder builder2(ctx.getDevice(), Settings(), SceneBuilder::Flags::UseCache);
+    auto key2 = builder2.getMeshCacheKey({path}, "mesh");
+    ASSERT(key2.has_value());
+    EXPECT(*key2 != *key);
+    EXPECT(!builder2.isMeshCached(*key2, pMaterial));
+
+    // Without caching there are no keys.
+    SceneBuilder builder3(ctx.getDevice(), Settings());
+    EXPECT(!builder3.getMeshCacheKey({path}, "mesh"));
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+} // namespace Falcor
@@ -0,0 +1,142 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/MeshLayoutOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+/// Create a regular grid of quads with the triangles in random order.
+std::vector<uint32_t> createShuffledGrid(uint32_t size, uint32_t& vertexCount)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            uint32_t i0 = y * (size + 1) + x;
+            uint32_t i1 = i0 + 1;
+            uint32_t i2 = i0 + size + 1;
+            uint32_t i3 = i2 + 1;
+            triangles.push_back({i0, i1, i2});
+            triangles.push_back({i1, i3, i2});
+        }
+    }
+    std::mt19937 rng(0);
+    std::shuffle(triangles.begin(), triangles.end(), rng);
+
+    std::vector<uint32_t> indices;
+    for (const auto& t : triangles)
+        indices.insert(indices.end(), t.begin(), t.end());
+    vertexCount = (size + 1) * (size + 1);
+    return indices;
+}
+
+/// Get the triangles of an index buffer as a sorted list, with each triangle rotated to start with its smallest index.
+std::vector<std::array<uint32_t, 3>> getCanonicalTriangles(const std::vector<uint32_t>& indices)
+{
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::array<uint32_t, 3> t = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+} // namespace
+
+CPU_TEST(MeshLayoutOptimizer_CacheStats)
+{
+    // Strip-like order of a single quad row. Every vertex is transformed exactly once.
+    std::vector<uint32_t> indices = {0, 1, 2, 1, 3, 2, 2, 3, 4, 3, 5, 4};
+    auto stats = MeshLayoutOptimizer::computeCacheStats(indices, 6);
+    EXPECT_EQ(stats.triangleCount, 4);
+    EXPECT_EQ(stats.vertexCount, 6);
+    EXPECT_EQ(stats.transformedVertexCount, 6);
+    EXPECT_EQ(stats.getATVR(), 1.0);
+
+    // With a cache of size one, only consecutive repeated indices hit.
+    stats = MeshLayoutOptimizer::computeCacheStats({0, 1, 2, 2, 1, 0}, 3, 1);
+    EXPECT_EQ(stats.transformedVertexCount, 5);
+}
+
+CPU_TEST(MeshLayoutOptimizer_VertexCache)
+{
+    uint32_t vertexCount = 0;
+    std::vector<uint32_t> indices = createShuffledGrid(64, vertexCount);
+    const auto originalTriangles = getCanonicalTriangles(indices);
+
+    auto before = MeshLayoutOptimizer::computeCacheStats(indices, vertexCount);
+    MeshLayoutOptimizer::optimizeVertexCache(indices, vertexCount);
+    auto after = MeshLayoutOptimizer::computeCacheStats(indices, vertexCount);
+
+    // Same set of triangles with the same winding.
+    EXPECT(getCanonicalTriangles(indices) == originalTriangles);
+
+    // A randomly ordered grid is close to the worst case of 3 transformed vertices per triangle.
+    // Tipsify gets well below 1 for regular meshes.
+    EXPECT_GT(before.getACMR(), 2.5);
+    EXPECT_LT(after.getACMR(), 0.8);
+    EXPECT_LT(after.getATVR(), 1.5);
+}
+
+CPU_TEST(MeshLayoutOptimizer_VertexFetch)
+{
+    uint32_t vertexCount = 0;
+    std::vector<uint32_t> indices = createShuffledGrid(16, vertexCount);
+    // Add an unreferenced vertex.
+    vertexCount++;
+
+    std::vector<uint32_t> vertices(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++)
+        vertices[i] = i;
+
+    const std::vector<uint32_t> originalIndices = indices;
+    auto remap = MeshLayoutOptimizer::optimizeVertexFetch(indices, vertexCount);
+    MeshLayoutOptimizer::remapVertices(vertices, remap);
+
+    // The remapped indices reference the same vertex data.
+    for (size_t i = 0; i < indices.size(); i++)
+        EXPECT_EQ(vertices[indices[i]], originalIndices[i]);
+
+    // Vertices are in order of first reference, unreferenced vertices at the end.
+    uint32_t maxIndex = 0;
+    for (uint32_t index : indices)
+    {
+        EXPECT_LE(index, maxIndex + 1);
+        maxIndex = std::max(maxIndex, index);
+    }
+    EXPECT_EQ(vertices.back(), vertexCount - 1);
+}
+} // namespace Falcor
@@ -0,0 +1,187 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/PlyReader.h"
+#include "Core/Platform/OS.h"
+#include <fstream>
+#include <string>
+
+namespace Falcor
+{
+namespace
+{
+/// Append a value to a binary PLY body in the given byte order.
+template<typename T>
+void append(std::string& data, T value, bool bigEndian)
+{
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    if (bigEndian)
+    {
+        for (size_t i = 0; i < sizeof(T); i++)
+            data.push_back(bytes[sizeof(T) - 1 - i]);
+    }
+    else
+    {
+        data.append(bytes, sizeof(T));
+    }
+}
+
+/// Create a binary PLY grid with size x size quads, vertex normals and texture coordinates.
+std::string createBinaryGrid(uint32_t size, bool bigEndian)
+{
+    const uint32_t vertexCount = (size + 1) * (size + 1);
+    std::string data = fmt::format(
+        "ply\nformat {} 1.0\ncomment synthetic grid\nelement vertex {}\n"
+        "property float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n"
+        "property float u\nproperty float v\nelement face {}\nproperty list uchar int vertex_indices\nproperty int face_indices\nend_header\n",
+        bigEndian ? "binary_big_endian" : "binary_little_endian",
+        vertexCount,
+        size * size
+    );
+    for (uint32_t y = 0; y <= size; y++)
+    {
+        for (uint32_t x = 0; x <= size; x++)
+        {
+            for (float value : {float(x), float(y), 0.f, 0.f, 0.f, 1.f, float(x) / size, float(y) / size})
+                append(data, value, bigEndian);
+        }
+    }
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            int32_t i0 = y * (size + 1) + x;
+            append(data, uint8_t(4), bigEndian);
+            for (int32_t index : {i0, i0 + 1, i0 + int32_t(size) + 2, i0 + int32_t(size) + 1})
+                append(data, index, bigEndian);
+            append(data, int32_t(y * size + x), bigEndian);
+        }
+    }
+    return data;
+}
+} // namespace
+
+CPU_TEST(PlyReader_Ascii)
+{
+    const std::string data =
+        "ply\r\nformat ascii 1.0\r\ncomment test\r\nelement vertex 4\r\n"
+        "property float x\r\nproperty float y\r\nproperty float z\r\nproperty float s\r\nproperty float t\r\n"
+        "element face 1\r\nproperty list uchar int vertex_indices\r\nend_header\r\n"
+        "0 0 0 0 0\n1 0 0 1 0\n1 1 0 1 1\n0 1 0 0 1\n4 0 1 2 3\n";
+
+    auto mesh = PlyReader::read(data.data(), data.size());
+    EXPECT(!mesh.hasNormals);
+    EXPECT(mesh.hasTexCoords);
+    ASSERT_EQ(mesh.vertices.size(), 4);
+    EXPECT(all(mesh.vertices[2].position == float3(1.f, 1.f, 0.f)));
+    EXPECT(all(mesh.vertices[3].texCoord == float2(0.f, 1.f)));
+
+    // The quad is triangulated as a fan.
+    std::vector<uint32_t> expected = {0, 1, 2, 0, 2, 3};
+    EXPECT(mesh.indices == expected);
+}
+
+CPU_TEST(PlyReader_Binary)
+{
+    for (bool bigEndian : {false, true})
+    {
+        std::string data = createBinaryGrid(2, bigEndian);
+        auto mesh = PlyReader::read(data.data(), data.size());
+        EXPECT(mesh.hasNormals);
+        EXPECT(mesh.hasTexCoords);
+        ASSERT_EQ(mesh.vertices.size(), 9);
+        ASSERT_EQ(mesh.indices.size(), 4 * 6);
+        EXPECT(all(mesh.vertices[5].position == float3(2.f, 1.f, 0.f)));
+        EXPECT(all(mesh.vertices[5].normal == float3(0.f, 0.f, 1.f)));
+        EXPECT(all(mesh.vertices[5].texCoord == float2(1.f, 0.5f)));
+        std::vector<uint32_t> firstQuad(mesh.indices.begin(), mesh.indices.begin() + 6);
+        std::vector<uint32_t> expected = {0, 1, 4, 0, 4, 3};
+        EXPECT(firstQuad == expected);
+    }
+}
+
+CPU_TEST(PlyReader_Errors)
+{
+    auto expectThrow = [&](const std::string& data)
+    {
+        bool thrown = false;
+        try
+        {
+            PlyReader::read(data.data(), data.size());
+        }
+        catch (const RuntimeError&)
+        {
+            thrown = true;
+        }
+        EXPECT(thrown) << data;
+    };
+
+    expectThrow("not a ply file\n");
+    expectThrow("ply\nelement vertex 1\nproperty float x\nend_header\n0\n");
+    // Index out of range.
+    expectThrow("ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nelement face 1\nproperty list uchar int vertex_indices\nend_header\n0\n3 0 1 2\n");
+    // Truncated binary data.
+    std::string data = createBinaryGrid(4, false);
+    expectThrow(data.substr(0, data.size() - 10));
+    // Element counts exceeding the file size must fail before allocating.
+    const std::string floatVertexHeader = "element vertex 4611686018427387904\nproperty float x\nproperty float y\nproperty float z\nend_header\n";
+    expectThrow("ply\nformat binary_little_endian 1.0\n" + floatVertexHeader + std::string(12, '\0'));
+    expectThrow("ply\nformat binary_big_endian 1.0\n" + floatVertexHeader + std::string(12, '\0'));
+    expectThrow("ply\nformat ascii 1.0\n" + floatVertexHeader + "0 0 0\n");
+    expectThrow("ply\nformat ascii 1.0\nelement vertex 3\nproperty float x\nelement face 1000000000000\nproperty list uchar int vertex_indices\nend_header\n0\n1\n2\n3 0 1 2\n");
+    // List count exceeding the file size.
+    std::string faceData = "ply\nformat binary_little_endian 1.0\nelement vertex 0\nproperty float x\nelement face 1\nproperty list uint int vertex_indices\nend_header\n";
+    append(faceData, uint32_t(0xffffffff), false);
+    append(faceData, int32_t(0), false);
+    expectThrow(faceData);
+}
+
+CPU_BENCHMARK(PlyReader_ReadFile)
+{
+    // Throughput of reading a binary PLY file with 2M triangles through a memory mapped file.
+    const std::filesystem::path path = getTempFilePath().replace_extension(".ply");
+    {
+        std::string data = createBinaryGrid(1024, false);
+        std::ofstream ofs(path, std::ios::binary);
+        ofs.write(data.data(), data.size());
+    }
+
+    size_t indexCount = 0;
+    bench.setBytesPerIteration(std::filesystem::file_size(path));
+    bench.run(
+        [&]()
+        {
+            auto mesh = PlyReader::readFile(path);
+            indexCount = mesh.indices.size();
+        }
+    );
+    EXPECT_EQ(indexCount, 1024 * 1024 * 6);
+
+    std::filesystem::remove(path);
+}
+} // namespace Falcor
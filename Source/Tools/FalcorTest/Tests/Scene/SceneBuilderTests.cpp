@@ -0,0 +1,290 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Material/StandardMaterial.h"
+
+namespace Falcor
+{
+namespace
+{
+/**
+ * Build a synthetic scene with many small meshes. Every fourth mesh is mirrored (flipped winding)
+ * and every eighth mesh is instanced twice, the rest are static and get pre-transformed.
+ */
+ref<Scene> buildManyMeshScene(ref<Device> pDevice, uint32_t meshCount, SceneBuilder::Flags flags = SceneBuilder::Flags::Default)
+{
+    SceneBuilder builder(pDevice, Settings(), flags);
+    auto pMaterial = StandardMaterial::create(pDevice, "Material");
+    auto pMesh = TriangleMesh::createSphere(0.5f, 8, 4);
+
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        MeshID meshID = builder.addTriangleMesh(pMesh, pMaterial);
+
+        float3 translation = float3(float(i % 64), float((i / 64) % 64), float(i / 4096)) * 2.f;
+        float3 scale = (i % 4 == 0) ? float3(-1.f, 1.f, 1.f) : float3(1.f);
+        float4x4 transform = mul(math::matrixFromTranslation(translation), math::matrixFromScaling(scale));
+
+        builder.addMeshInstance(builder.addNode(SceneBuilder::Node{fmt::format("Node{}", i), transform, float4x4::identity()}), meshID);
+        if (i % 8 == 0)
+        {
+            float4x4 transform2 = mul(math::matrixFromTranslation(float3(0.f, 0.f, -10.f)), transform);
+            builder.addMeshInstance(builder.addNode(SceneBuilder::Node{fmt::format("Node{}b", i), transform2, float4x4::identity()}), meshID);
+        }
+    }
+
+    return builder.getScene();
+}
+} // namespace
+
+/// Gives the tests access to the mesh splitting helpers.
+class SceneBuilderTest
+{
+public:
+    using MeshSpec = SceneBuilder::MeshSpec;
+
+    /// Create a non-indexed mesh in the z = 0 plane with one unit triangle at each x offset.
+    /// If extent is non-zero, a sliver triangle from the origin to x = extent is added.
+    static MeshSpec createMesh(const std::vector<float>& xs, float extent)
+    {
+        MeshSpec mesh;
+        mesh.topology = Vao::Topology::TriangleList;
+        auto addTriangle = [&](float3 p0, float3 p1, float3 p2)
+        {
+            for (float3 p : {p0, p1, p2})
+            {
+                StaticVertexData v = {};
+                v.position = p;
+                v.texCrd = p.xy();
+                mesh.staticData.push_back(v);
+                mesh.boundingBox.include(p);
+            }
+        };
+        for (float x : xs)
+            addTriangle(float3(x, 0.f, 0.f), float3(x + 1.f, 0.f, 0.f), float3(x, 1.f, 0.f));
+        if (extent > 0.f)
+            addTriangle(float3(0.f), float3(extent, 0.f, 0.f), float3(0.f, 1.f, 0.f));
+        mesh.vertexCount = (uint32_t)mesh.staticData.size();
+        mesh.staticVertexCount = mesh.vertexCount;
+        return mesh;
+    }
+
+    static float findMedianCentroid(const MeshSpec& mesh, int axis) { return SceneBuilder::findMedianCentroid(mesh, axis); }
+
+    static std::pair<MeshSpec, MeshSpec> splitNonIndexedMesh(const MeshSpec& mesh, int axis, float pos)
+    {
+        std::pair<MeshSpec, MeshSpec> result;
+        result.first.topology = mesh.topology;
+        result.second.topology = mesh.topology;
+        SceneBuilder::splitNonIndexedMesh(mesh, result.first, result.second, axis, pos);
+        return result;
+    }
+};
+
+GPU_TEST(SceneBuilder_ManyMeshesDeterministic)
+{
+    // The per-mesh build passes run in parallel. Check that the output matches a serial build.
+    const uint32_t meshCount = 1000;
+    ref<Scene> pSceneA = buildManyMeshScene(ctx.getDevice(), meshCount);
+    ref<Scene> pSceneB = buildManyMeshScene(ctx.getDevice(), meshCount, SceneBuilder::Flags::SerialBuild);
+
+    ASSERT_EQ(pSceneA->getMeshCount(), meshCount);
+    ASSERT_EQ(pSceneB->getMeshCount(), meshCount);
+    ASSERT_EQ(pSceneA->getGeometryInstanceCount(), pSceneB->getGeometryInstanceCount());
+
+    for (uint32_t i = 0; i < meshCount; i++)
+    {
+        const auto& a = pSceneA->getMesh(MeshID{i});
+        const auto& b = pSceneB->getMesh(MeshID{i});
+        EXPECT_EQ(a.vbOffset, b.vbOffset);
+        EXPECT_EQ(a.ibOffset, b.ibOffset);
+        EXPECT_EQ(a.vertexCount, b.vertexCount);
+        EXPECT_EQ(a.indexCount, b.indexCount);
+        EXPECT_EQ(a.flags, b.flags);
+        EXPECT(pSceneA->getMeshBounds(i) == pSceneB->getMeshBounds(i));
+        EXPECT_EQ(pSceneA->getMeshName(i), pSceneB->getMeshName(i));
+    }
+
+    for (uint32_t i = 0; i < pSceneA->getGeometryInstanceCount(); i++)
+    {
+        const auto& a = pSceneA->getGeometryInstance(i);
+        const auto& b = pSceneB->getGeometryInstance(i);
+        EXPECT_EQ(a.geometryID, b.geometryID);
+        EXPECT_EQ(a.globalMatrixID, b.globalMatrixID);
+        EXPECT_EQ(a.vbOffset, b.vbOffset);
+        EXPECT_EQ(a.ibOffset, b.ibOffset);
+        EXPECT_EQ(a.instanceIndex, b.instanceIndex);
+        EXPECT_EQ(a.geometryIndex, b.geometryIndex);
+    }
+
+    // The pre-transformed and winding-corrected vertex and index data must be bit-identical.
+    // Vertex buffer 0 holds the static vertex data.
+    auto getBytes = [](const ref<Buffer>& pBuffer) { return pBuffer ? pBuffer->getElements<uint8_t>() : std::vector<uint8_t>(); };
+    EXPECT(getBytes(pSceneA->getMeshVao()->getVertexBuffer(0)) == getBytes(pSceneB->getMeshVao()->getVertexBuffer(0)));
+    EXPECT(getBytes(pSceneA->getMeshVao()->getIndexBuffer()) == getBytes(pSceneB->getMeshVao()->getIndexBuffer()));
+}
+
+GPU_BENCHMARK(SceneBuilder_ManyMeshes)
+{
+    // Scaling benchmark of scene building with increasing mesh counts.
+    for (uint32_t meshCount : {1000u, 4000u, 16000u})
+    {
+        ref<Scene> pScene;
+        bench.setItemsPerIteration(meshCount);
+        bench.run(fmt::format("{}", meshCount), [&]() { pScene = buildManyMeshScene(ctx.getDevice(), meshCount); });
+        EXPECT_EQ(pScene->getMeshCount(), meshCount);
+    }
+}
+
+CPU_TEST(SceneBuilder_FindMedianCentroid)
+{
+    // Most triangles are clustered at the origin, one long sliver extends the bounds to x = 100.
+    // All centroids are left of the midpoint, so the split falls back to the median centroid.
+    std::vector<float> xs;
+    for (uint32_t i = 0; i < 15; i++)
+        xs.push_back(float((i * 7) % 15));
+    auto mesh = SceneBuilderTest::createMesh(xs, 100.f);
+
+    // The median of the 16 centroids is the one of the unit triangle at x = 8.
+    const float pos = SceneBuilderTest::findMedianCentroid(mesh, 0);
+    EXPECT_EQ(pos, (8.f + 9.f + 8.f) / 3.f);
+
+    auto [left, right] = SceneBuilderTest::splitNonIndexedMesh(mesh, 0, mesh.boundingBox.center().x);
+    EXPECT_EQ(left.getTriangleCount(), mesh.getTriangleCount());
+    EXPECT_EQ(right.getTriangleCount(), 0u);
+
+    auto [medianLeft, medianRight] = SceneBuilderTest::splitNonIndexedMesh(mesh, 0, pos);
+    EXPECT_EQ(medianLeft.getTriangleCount(), 8u);
+    EXPECT_EQ(medianRight.getTriangleCount(), 8u);
+
+    // Indexed meshes with 16-bit and 32-bit indices give the same median.
+    for (bool use16BitIndices : {false, true})
+    {
+        auto indexed = SceneBuilderTest::createMesh(xs, 100.f);
+        // Reference the vertices in reverse order and reverse the triangles to match.
+        std::reverse(indexed.staticData.begin(), indexed.staticData.end());
+        indexed.indexCount = indexed.vertexCount;
+        indexed.use16BitIndices = use16BitIndices;
+        indexed.indexData.resize(use16BitIndices ? (indexed.indexCount + 1) / 2 : indexed.indexCount);
+        for (uint32_t i = 0; i < indexed.indexCount; i++)
+        {
+            uint32_t index = indexed.vertexCount - 1 - i;
+            if (use16BitIndices)
+                reinterpret_cast<uint16_t*>(indexed.indexData.data())[i] = (uint16_t)index;
+            else
+                indexed.indexData[i] = index;
+        }
+        EXPECT_EQ(SceneBuilderTest::findMedianCentroid(indexed, 0), pos);
+    }
+}
+
+CPU_TEST(SceneBuilder_SplitNonIndexedMesh)
+{
+    std::vector<float> xs;
+    for (uint32_t i = 0; i < 10; i++)
+        xs.push_back(float(9 - i));
+    auto mesh = SceneBuilderTest::createMesh(xs, 0.f);
+
+    auto [left, right] = SceneBuilderTest::splitNonIndexedMesh(mesh, 0, 4.f);
+
+    // Triangles with centroids x + 1/3 < 4 go to the left side, in their original order and with unchanged vertices.
+    ASSERT_EQ(left.getTriangleCount(), 4u);
+    ASSERT_EQ(right.getTriangleCount(), 6u);
+    for (const auto* pSide : {&left, &right})
+    {
+        EXPECT(pSide->indexData.empty());
+        EXPECT_EQ(pSide->vertexCount, pSide->getTriangleCount() * 3);
+        EXPECT_EQ(pSide->staticVertexCount, pSide->vertexCount);
+    }
+    for (uint32_t i = 0; i < 6 * 3; i++)
+        EXPECT(std::memcmp(&right.staticData[i], &mesh.staticData[i], sizeof(StaticVertexData)) == 0);
+    for (uint32_t i = 0; i < 4 * 3; i++)
+        EXPECT(std::memcmp(&left.staticData[i], &mesh.staticData[18 + i], sizeof(StaticVertexData)) == 0);
+
+    EXPECT(all(left.boundingBox.minPoint == float3(0.f)));
+    EXPECT(all(left.boundingBox.maxPoint == float3(4.f, 1.f, 0.f)));
+    EXPECT(all(right.boundingBox.minPoint == float3(4.f, 0.f, 0.f)));
+    EXPECT(all(right.boundingBox.maxPoint == float3(10.f, 1.f, 0.f)));
+}
+
+GPU_BENCHMARK(SceneBuilder_SplitOversizedMesh)
+{
+    // A single mesh above the per-BLAS triangle limit (2^24) is split into spatially coherent chunks.
+    const uint32_t kMaxTrianglesPerBLAS = 1u << 24;
+    auto pMesh = TriangleMesh::createSphere(1.f, 4200, 2048);
+    const size_t triangleCount = pMesh->getIndices().size() / 3;
+    ASSERT_GT(triangleCount, kMaxTrianglesPerBLAS);
+
+    auto pMaterial = StandardMaterial::create(ctx.getDevice(), "Emissive");
+    pMaterial->setEmissiveColor(float3(1.f));
+
+    ref<Scene> pScene;
+    bench.setItemsPerIteration(triangleCount);
+    bench.run(
+        [&]()
+        {
+            SceneBuilder builder(ctx.getDevice(), Settings());
+            MeshID meshID = builder.addTriangleMesh(pMesh, pMaterial);
+            NodeID nodeID = builder.addNode(SceneBuilder::Node{"Node", float4x4::identity(), float4x4::identity()});
+            builder.addMeshInstance(nodeID, meshID);
+
+            // The node is animated, the chunks must stay attached to it.
+            auto pAnimation = Animation::create("Animation", nodeID, 1.0);
+            pAnimation->addKeyframe(Animation::Keyframe{0.0, float3(0.f), float3(1.f), quatf::identity()});
+            pAnimation->addKeyframe(Animation::Keyframe{1.0, float3(1.f, 0.f, 0.f), float3(1.f), quatf::identity()});
+            builder.addAnimation(pAnimation);
+
+            pScene = builder.getScene();
+        }
+    );
+
+    ASSERT_GT(pScene->getMeshCount(), 1u);
+    ASSERT_EQ(pScene->getGeometryInstanceCount(), pScene->getMeshCount());
+    ASSERT_EQ(pScene->getAnimations().size(), 1);
+    const uint32_t animatedMatrixID = pScene->getAnimations()[0]->getNodeID().get();
+
+    size_t sceneTriangleCount = 0;
+    for (uint32_t i = 0; i < pScene->getMeshCount(); i++)
+    {
+        const auto& mesh = pScene->getMesh(MeshID{i});
+        EXPECT_LE(mesh.getTriangleCount(), kMaxTrianglesPerBLAS);
+        EXPECT_EQ(mesh.materialID, pScene->getMesh(MeshID{0}).materialID);
+        EXPECT_EQ(mesh.flags, pScene->getMesh(MeshID{0}).flags);
+        EXPECT(pScene->getMaterial(MaterialID{mesh.materialID})->isEmissive());
+        EXPECT(pScene->getEmissiveMeshGeometry(MeshID{i}) != nullptr);
+        sceneTriangleCount += mesh.getTriangleCount();
+    }
+    EXPECT_EQ(sceneTriangleCount, triangleCount);
+
+    for (uint32_t i = 0; i < pScene->getGeometryInstanceCount(); i++)
+        EXPECT_EQ(pScene->getGeometryInstance(i).globalMatrixID, animatedMatrixID);
+
+    logInfo("Split mesh with {} triangles into {} meshes.", triangleCount, pScene->getMeshCount());
+}
+} // namespace Falcor
@@ -0,0 +1,125 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/SceneBuilder.h"
+#include "Scene/Animation/Animation.h"
+#include "Scene/Animation/AnimationController.h"
+#include "Scene/Material/StandardMaterial.h"
+
+namespace Falcor
+{
+namespace
+{
+/**
+ * Build a scene with many instances of a single mesh. Every animatedStride-th instance gets an
+ * animation that mirrors it over time (scaling goes from 1 at t=0 to -1 at t=1).
+ */
+ref<Scene> buildAnimatedScene(ref<Device> pDevice, uint32_t instanceCount, uint32_t animatedStride)
+{
+    SceneBuilder builder(pDevice, Settings());
+    auto pMaterial = StandardMaterial::create(pDevice, "Material");
+    MeshID meshID = builder.addTriangleMesh(TriangleMesh::createCube(), pMaterial);
+
+    for (uint32_t i = 0; i < instanceCount; i++)
+    {
+        float3 translation = float3(float(i % 64), float((i / 64) % 64), float(i / 4096)) * 2.f;
+        NodeID nodeID = builder.addNode(SceneBuilder::Node{fmt::format("Node{}", i), math::matrixFromTranslation(translation), float4x4::identity()});
+        builder.addMeshInstance(nodeID, meshID);
+
+        if (i % animatedStride == 0)
+        {
+            auto pAnimation = Animation::create(fmt::format("Anim{}", i), nodeID, 1.0);
+            pAnimation->addKeyframe(Animation::Keyframe{0.0, translation, float3(1.f)});
+            pAnimation->addKeyframe(Animation::Keyframe{1.0, translation, float3(-1.f, 1.f, 1.f)});
+            builder.addAnimation(pAnimation);
+        }
+    }
+
+    return builder.getScene();
+}
+
+bool isFlipped(const Scene* pScene, const GeometryInstanceData& inst)
+{
+    const float4x4& transform = pScene->getAnimationController()->getGlobalMatrices()[inst.globalMatrixID];
+    return determinant(float3x3(transform)) < 0.f;
+}
+} // namespace
+
+GPU_TEST(SceneUpdate_IncrementalGeometryInstances)
+{
+    // Only the animated instances are revisited each frame. Check that their flags track the
+    // animated transforms while the static instances are left untouched.
+    const uint32_t instanceCount = 1000;
+    const uint32_t animatedStride = 7;
+    ref<Scene> pScene = buildAnimatedScene(ctx.getDevice(), instanceCount, animatedStride);
+    ASSERT_EQ(pScene->getGeometryInstanceCount(), instanceCount);
+
+    for (double time : {0.25, 0.75, 0.25, 0.75})
+    {
+        pScene->update(ctx.getRenderContext(), time);
+
+        uint32_t flippedCount = 0;
+        for (uint32_t i = 0; i < pScene->getGeometryInstanceCount(); i++)
+        {
+            const auto& inst = pScene->getGeometryInstance(i);
+            bool flipped = isFlipped(pScene.get(), inst);
+            EXPECT_EQ((inst.flags & (uint32_t)GeometryInstanceFlags::TransformFlipped) != 0, flipped);
+            EXPECT_EQ(inst.isWorldFrontFaceCW(), flipped);
+            if (flipped) flippedCount++;
+        }
+
+        uint32_t animatedCount = (instanceCount + animatedStride - 1) / animatedStride;
+        EXPECT_EQ(flippedCount, time > 0.5 ? animatedCount : 0u);
+    }
+}
+
+GPU_BENCHMARK(SceneUpdate_IncrementalGeometryInstances)
+{
+    // Per-frame CPU cost of the scene update as a function of instance count and animated fraction.
+    const uint32_t frameCount = 100;
+    for (uint32_t instanceCount : {1000u, 10000u, 100000u})
+    {
+        for (uint32_t animatedStride : {100u, 10u, 1u})
+        {
+            ref<Scene> pScene = buildAnimatedScene(ctx.getDevice(), instanceCount, animatedStride);
+            pScene->update(ctx.getRenderContext(), 0.0);
+
+            // Each iteration advances the animation by one frame so that the animated instances change.
+            uint32_t frame = 0;
+            bench.run(
+                fmt::format("{}/{}", instanceCount, animatedStride),
+                [&]()
+                {
+                    pScene->update(ctx.getRenderContext(), (frame % frameCount + 1) / double(frameCount + 1));
+                    frame++;
+                }
+            );
+        }
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,149 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/TangentGenerator.h"
+#include <cmath>
+
+namespace Falcor
+{
+namespace
+{
+/// Height field on a regular grid. The texture coordinates are mirrored at x = 0.5 to produce both texture space orientations.
+struct Grid
+{
+    std::vector<float3> positions;
+    std::vector<float3> normals;
+    std::vector<float2> texCrds;
+    std::vector<uint32_t> indices;
+
+    Grid(uint32_t size)
+    {
+        for (uint32_t y = 0; y <= size; y++)
+        {
+            for (uint32_t x = 0; x <= size; x++)
+            {
+                float u = float(x) / size;
+                float v = float(y) / size;
+                float h = 0.1f * std::sin(6.f * u) * std::cos(4.f * v);
+                float3 dx(1.f, 0.6f * std::cos(6.f * u) * std::cos(4.f * v), 0.f);
+                float3 dz(0.f, -0.4f * std::sin(6.f * u) * std::sin(4.f * v), 1.f);
+                positions.push_back(float3(u, h, v));
+                normals.push_back(normalize(cross(dz, dx)));
+                texCrds.push_back(float2(u > 0.5f ? 1.f - u : u, v));
+            }
+        }
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                uint32_t i0 = y * (size + 1) + x;
+                uint32_t i1 = i0 + 1;
+                uint32_t i2 = i0 + size + 1;
+                uint32_t i3 = i2 + 1;
+                indices.insert(indices.end(), {i0, i2, i1, i1, i2, i3});
+            }
+        }
+    }
+
+    SceneBuilder::Mesh getMesh() const
+    {
+        SceneBuilder::Mesh mesh;
+        mesh.name = "grid";
+        mesh.faceCount = (uint32_t)indices.size() / 3;
+        mesh.indexCount = (uint32_t)indices.size();
+        mesh.vertexCount = (uint32_t)positions.size();
+        mesh.pIndices = indices.data();
+        mesh.topology = Vao::Topology::TriangleList;
+        mesh.positions = {positions.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+        mesh.normals = {normals.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+        mesh.texCrds = {texCrds.data(), SceneBuilder::Mesh::AttributeFrequency::Vertex};
+        return mesh;
+    }
+};
+} // namespace
+
+CPU_TEST(TangentGenerator_MatchesMikkTSpace)
+{
+    Grid grid(64);
+    auto mesh = grid.getMesh();
+
+    auto tangents = TangentGenerator::generate(mesh, TangentGenerator::Mode::Parallel);
+    auto reference = TangentGenerator::generate(mesh, TangentGenerator::Mode::Reference);
+    ASSERT_EQ(tangents.size(), mesh.indexCount);
+    ASSERT_EQ(reference.size(), mesh.indexCount);
+
+    for (size_t i = 0; i < tangents.size(); i++)
+    {
+        float d = dot(tangents[i].xyz(), reference[i].xyz());
+        EXPECT_GE_MSG(d, 0.9999f, fmt::format("corner {}", i));
+        EXPECT_EQ_MSG(tangents[i].w, reference[i].w, fmt::format("corner {}", i));
+    }
+
+    // Splitting the vertices must not change the result.
+    std::vector<float3> positions(mesh.indexCount);
+    for (uint32_t i = 0; i < mesh.indexCount; i++)
+        positions[i] = grid.positions[grid.indices[i]];
+    mesh.positions = {positions.data(), SceneBuilder::Mesh::AttributeFrequency::FaceVarying};
+
+    auto faceVarying = TangentGenerator::generate(mesh, TangentGenerator::Mode::Parallel);
+    ASSERT_EQ(faceVarying.size(), tangents.size());
+    for (size_t i = 0; i < tangents.size(); i++)
+        EXPECT(all(faceVarying[i] == tangents[i]));
+}
+
+CPU_TEST(TangentGenerator_DegenerateTexCrds)
+{
+    Grid grid(4);
+    std::fill(grid.texCrds.begin(), grid.texCrds.end(), float2(0.5f));
+    auto mesh = grid.getMesh();
+
+    // Without a texture space the tangents are arbitrary but must be finite and orthogonal to the normal.
+    auto tangents = TangentGenerator::generate(mesh);
+    ASSERT_EQ(tangents.size(), mesh.indexCount);
+    for (uint32_t i = 0; i < mesh.indexCount; i++)
+    {
+        EXPECT(!any(isnan(tangents[i])));
+        EXPECT_LE(std::abs(dot(tangents[i].xyz(), grid.normals[grid.indices[i]])), 1e-5f);
+    }
+}
+
+CPU_BENCHMARK(TangentGenerator_Generate)
+{
+    Grid grid(512);
+    auto mesh = grid.getMesh();
+    bench.setItemsPerIteration(mesh.faceCount);
+
+    for (auto mode : {TangentGenerator::Mode::Parallel, TangentGenerator::Mode::Reference})
+    {
+        bench.run(
+            mode == TangentGenerator::Mode::Parallel ? "Parallel" : "Reference",
+            [&]() { doNotOptimize(TangentGenerator::generate(mesh, mode)); }
+        );
+    }
+}
+} // namespace Falcor
@@ -0,0 +1,104 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Scene/VertexQuantization.h"
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+std::vector<StaticVertexData> createRandomVertices(size_t count)
+{
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.f, 1.f);
+    auto randomDirection = [&]()
+    {
+        float3 d;
+        do
+        {
+            d = float3(u(rng), u(rng), u(rng));
+        } while (length(d) < 0.1f || length(d) > 1.f);
+        return normalize(d);
+    };
+
+    std::vector<StaticVertexData> vertices(count);
+    for (auto& v : vertices)
+    {
+        v.position = float3(u(rng) * 10.f, u(rng) * 2.f + 5.f, u(rng) * 0.5f);
+        v.normal = randomDirection();
+        v.tangent = float4(randomDirection(), u(rng) < 0.f ? -1.f : 1.f);
+        v.texCrd = float2(u(rng), u(rng)) * 4.f;
+        v.curveRadius = 0.f;
+    }
+    return vertices;
+}
+} // namespace
+
+CPU_TEST(VertexQuantization_BytesPerVertex)
+{
+    EXPECT_EQ(VertexQuantization::getBytesPerVertex(VertexQuantization::PositionFormat::Unorm16), 20);
+    EXPECT_EQ(VertexQuantization::getBytesPerVertex(VertexQuantization::PositionFormat::Unorm21), 22);
+    EXPECT_LT(VertexQuantization::getBytesPerVertex(VertexQuantization::PositionFormat::Unorm21), sizeof(PackedStaticVertexData));
+}
+
+CPU_TEST(VertexQuantization_Error)
+{
+    const auto vertices = createRandomVertices(10000);
+
+    for (auto format : {VertexQuantization::PositionFormat::Unorm16, VertexQuantization::PositionFormat::Unorm21})
+    {
+        auto encoded = VertexQuantization::encode(vertices, format);
+        ASSERT_EQ(encoded.getVertexCount(), vertices.size());
+        auto decoded = VertexQuantization::decode(encoded);
+        ASSERT_EQ(decoded.size(), vertices.size());
+
+        auto stats = VertexQuantization::computeError(vertices, decoded);
+        EXPECT_EQ(stats.vertexCount, vertices.size());
+        EXPECT_LE(stats.maxPositionError, VertexQuantization::getPositionErrorBound(encoded.bounds, format));
+        EXPECT_LT(stats.maxNormalError, 1e-3f);
+        EXPECT_LT(stats.maxTangentError, 1e-3f);
+        EXPECT_LT(stats.maxTexCrdError, 5e-3f);
+
+        for (size_t i = 0; i < vertices.size(); i++)
+            EXPECT_EQ(decoded[i].tangent.w, vertices[i].tangent.w);
+    }
+}
+
+CPU_TEST(VertexQuantization_Reencode)
+{
+    // Quantizing already quantized vertices is lossless.
+    const auto vertices = createRandomVertices(1000);
+    auto decoded = VertexQuantization::decode(VertexQuantization::encode(vertices, VertexQuantization::PositionFormat::Unorm16));
+    auto reencoded = VertexQuantization::decode(VertexQuantization::encode(decoded, VertexQuantization::PositionFormat::Unorm16));
+
+    auto stats = VertexQuantization::computeError(decoded, reencoded);
+    EXPECT_EQ(stats.maxPositionError, 0.f);
+    EXPECT_EQ(stats.maxTexCrdError, 0.f);
+}
+} // namespace Falcor
@@ -27,6 +27,8 @@
  **************************************************************************/
 #include "Testing/UnitTest.h"
 #include "Utils/Image/TextureManager.h"
+#include "Utils/StringUtils.h"
+#include "Core/Platform/OS.h"
 
 namespace Falcor
 {
@@ -51,4 +53,102 @@ GPU_TEST(TextureManager_LoadMips)
     EXPECT_EQ(tex->getMipCount(), 3);
     EXPECT_EQ(tex->getArraySize(), 1);
 }
+
+GPU_TEST(TextureManager_DeferredLoading)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    TextureManager textureManager(pDevice, 10);
+
+    // Use a tiny cap to force the decoder threads to wait on the upload thread.
+    auto& loader = textureManager.getTextureLoader();
+    loader.setMaxInFlightBytes(1);
+
+    std::filesystem::path dataDir = getRuntimeDirectory() / "data/tests";
+
+    textureManager.beginDeferredLoading();
+    auto mipped = textureManager.loadTexture(dataDir / "tiny_<MIP>.png", false, false);
+    auto generated = textureManager.loadTexture(dataDir / "tiny_mip0.png", true, false);
+    auto dds = textureManager.loadTexture(dataDir / "BC1Unorm.dds", false, false);
+    textureManager.endDeferredLoading();
+
+    auto pMipped = textureManager.getTexture(mipped);
+    ASSERT(pMipped != nullptr);
+    EXPECT_EQ(pMipped->getWidth(), 4);
+    EXPECT_EQ(pMipped->getMipCount(), 3);
+
+    auto pGenerated = textureManager.getTexture(generated);
+    ASSERT(pGenerated != nullptr);
+    EXPECT_EQ(pGenerated->getWidth(), 4);
+    EXPECT_EQ(pGenerated->getMipCount(), 3);
+
+    auto pDDS = textureManager.getTexture(dds);
+    ASSERT(pDDS != nullptr);
+    EXPECT(pDDS->getFormat() == ResourceFormat::BC1Unorm);
+
+    auto stats = loader.getStats();
+    EXPECT_EQ(stats.textureCount, 3);
+    EXPECT_EQ(stats.failedCount, 0);
+    EXPECT_GE(stats.batchCount, 1);
+}
+
+GPU_BENCHMARK(TextureManager_DeferredLoading)
+{
+    ref<Device> pDevice = ctx.getDevice();
+
+    const uint32_t textureCount = 10000;
+    const uint32_t size = 128;
+
+    // Write unique texture files to a temporary directory.
+    std::filesystem::path directory = getTempFilePath();
+    directory += "_textures";
+    std::filesystem::create_directories(directory);
+
+    std::vector<std::filesystem::path> paths(textureCount);
+    std::vector<uint32_t> pixels(size * size);
+    for (uint32_t i = 0; i < textureCount; i++)
+    {
+        for (uint32_t j = 0; j < pixels.size(); j++)
+            pixels[j] = (i * 2654435761u) ^ (j * 40503u);
+        paths[i] = directory / fmt::format("texture{}.png", i);
+        Bitmap::saveImage(
+            paths[i], size, size, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::RGBA8Unorm, true, pixels.data()
+        );
+    }
+
+    // Each iteration loads all textures into a new texture manager.
+    std::unique_ptr<TextureManager> pTextureManager;
+    bench.setItemsPerIteration(textureCount);
+    bench.setBytesPerIteration(double(textureCount) * size * size * 4);
+    bench.run(
+        [&]()
+        {
+            pTextureManager = std::make_unique<TextureManager>(pDevice, textureCount);
+            pTextureManager->getTextureLoader().setMaxInFlightBytes(64ull << 20);
+            pTextureManager->beginDeferredLoading();
+            for (const auto& path : paths)
+                pTextureManager->loadTexture(path, true, false);
+            pTextureManager->endDeferredLoading();
+        }
+    );
+
+    const auto& loader = pTextureManager->getTextureLoader();
+    auto stats = loader.getStats();
+    EXPECT_EQ(stats.textureCount, textureCount);
+    EXPECT_EQ(stats.failedCount, 0);
+    EXPECT_LE(stats.peakInFlightBytes, loader.getMaxInFlightBytes() + std::thread::hardware_concurrency() * size * size * 4);
+
+    logInfo(
+        "{} batches, {} syncs, peak in-flight {}, decode {:.3f} s, upload {:.3f} s.",
+        stats.batchCount,
+        stats.syncCount,
+        formatByteSize(stats.peakInFlightBytes),
+        stats.decodeTime,
+        stats.uploadTime
+    );
+
+    pTextureManager.reset();
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+}
 } // namespace Falcor
@@ -0,0 +1,188 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/Timing/LoadProfiler.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace Falcor
+{
+namespace
+{
+uint32_t findChild(const std::vector<LoadProfiler::Phase>& phases, uint32_t parent, const std::string& name)
+{
+    for (uint32_t child : phases[parent].children)
+        if (phases[child].name == name)
+            return child;
+    return LoadProfiler::kInvalidIndex;
+}
+
+uint32_t findPhase(const std::vector<LoadProfiler::Phase>& phases, const std::string& name)
+{
+    for (uint32_t i = 0; i < phases.size(); ++i)
+        if (phases[i].name == name)
+            return i;
+    return LoadProfiler::kInvalidIndex;
+}
+} // namespace
+
+CPU_TEST(LoadProfiler)
+{
+    auto& profiler = LoadProfiler::instance();
+    if (!profiler.isEnabled())
+        ctx.skip("Load profiler is disabled");
+
+    // Phases are recorded below whatever phase the test runner has open, use a unique root name.
+    static std::atomic<uint32_t> sInvocation{0};
+    const std::string rootName = fmt::format("LoadProfilerTest{}", sInvocation++);
+    {
+        ScopedLoadPhase root(rootName);
+        for (int i = 0; i < 3; ++i)
+        {
+            FALCOR_LOAD_PHASE("A");
+            profiler.addCount("items", 2);
+        }
+        {
+            ScopedLoadPhase b("B");
+            b.addCount("triangles", 100);
+            {
+                FALCOR_LOAD_PHASE("C");
+            }
+        }
+    }
+
+    auto phases = profiler.getPhases();
+    uint32_t root = findPhase(phases, rootName);
+    ASSERT_NE(root, LoadProfiler::kInvalidIndex);
+    EXPECT_EQ(phases[root].callCount, 1u);
+    ASSERT_EQ(phases[root].children.size(), 2u);
+
+    uint32_t a = findChild(phases, root, "A");
+    ASSERT_NE(a, LoadProfiler::kInvalidIndex);
+    EXPECT_EQ(phases[a].callCount, 3u);
+    EXPECT_EQ(phases[a].counters["items"], 6u);
+    EXPECT_GE(phases[root].wallTime, phases[a].wallTime);
+
+    uint32_t b = findChild(phases, root, "B");
+    ASSERT_NE(b, LoadProfiler::kInvalidIndex);
+    EXPECT_EQ(phases[b].callCount, 1u);
+    EXPECT_EQ(phases[b].counters["triangles"], 100u);
+    EXPECT_NE(findChild(phases, b, "C"), LoadProfiler::kInvalidIndex);
+
+    std::string json = profiler.toJsonString();
+    EXPECT(json.find(rootName) != std::string::npos);
+}
+
+CPU_TEST(LoadProfiler_ItemPhases)
+{
+    auto& profiler = LoadProfiler::instance();
+    if (!profiler.isEnabled())
+        ctx.skip("Load profiler is disabled");
+
+    static std::atomic<uint32_t> sInvocation{0};
+    const std::string workerName = fmt::format("LoadProfilerWorker{}", sInvocation++);
+    const uint32_t kThreadCount = 4;
+    const uint32_t kItemCount = 100;
+
+    // Each worker opens the same phase, the per-item phases of all threads are merged below it.
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kThreadCount; ++i)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                ScopedLoadPhase worker(workerName);
+                for (uint32_t j = 0; j < kItemCount; ++j)
+                {
+                    FALCOR_LOAD_ITEM_PHASE("Item");
+                    {
+                        FALCOR_LOAD_ITEM_PHASE("SubItem");
+                    }
+                }
+            }
+        );
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    auto phases = profiler.getPhases();
+    uint32_t worker = findPhase(phases, workerName);
+    ASSERT_NE(worker, LoadProfiler::kInvalidIndex);
+    EXPECT_EQ(phases[worker].callCount, kThreadCount);
+    EXPECT(!phases[worker].isItemPhase);
+
+    uint32_t item = findChild(phases, worker, "Item");
+    ASSERT_NE(item, LoadProfiler::kInvalidIndex);
+    EXPECT(phases[item].isItemPhase);
+    EXPECT_EQ(phases[item].callCount, kThreadCount * kItemCount);
+    EXPECT_EQ(phases[item].cpuTime, 0.0);
+    EXPECT_EQ(phases[item].peakRSS, 0u);
+    EXPECT_LE(phases[item].wallTime, phases[worker].wallTime);
+
+    uint32_t subItem = findChild(phases, item, "SubItem");
+    ASSERT_NE(subItem, LoadProfiler::kInvalidIndex);
+    EXPECT_EQ(phases[subItem].callCount, kThreadCount * kItemCount);
+}
+
+CPU_TEST(LoadProfiler_MixedPhaseKinds)
+{
+    auto& profiler = LoadProfiler::instance();
+    if (!profiler.isEnabled())
+        ctx.skip("Load profiler is disabled");
+
+    static std::atomic<uint32_t> sInvocation{0};
+    const std::string rootName = fmt::format("LoadProfilerMixed{}", sInvocation++);
+
+    // A regular and a per-item phase with the same name must not share their statistics.
+    {
+        FALCOR_LOAD_PHASE(rootName);
+        {
+            ScopedLoadPhase phase("Shared");
+            phase.addCount("meshes", 3);
+        }
+        for (uint32_t i = 0; i < 2; ++i)
+        {
+            FALCOR_LOAD_ITEM_PHASE("Shared");
+        }
+    }
+
+    auto phases = profiler.getPhases();
+    uint32_t root = findPhase(phases, rootName);
+    ASSERT_NE(root, LoadProfiler::kInvalidIndex);
+    ASSERT_EQ(phases[root].children.size(), 2u);
+    for (uint32_t child : phases[root].children)
+    {
+        const auto& phase = phases[child];
+        EXPECT_EQ(phase.name, "Shared");
+        EXPECT_EQ(phase.callCount, phase.isItemPhase ? 2u : 1u);
+        EXPECT_EQ(phase.counters.count("meshes"), phase.isItemPhase ? 0u : 1u);
+    }
+    EXPECT_NE(phases[phases[root].children[0]].isItemPhase, phases[phases[root].children[1]].isItemPhase);
+}
+} // namespace Falcor
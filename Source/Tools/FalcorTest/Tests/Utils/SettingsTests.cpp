@@ -43,6 +43,38 @@ namespace Falcor
 {
 namespace
 {
+/// Filters covering the matcher fast paths, generic regexes and the deprecated `.filter` syntax.
+nlohmann::json createTestFilters()
+{
+    return nlohmann::json::parse(R"([
+        { "regex": ".*", "attributes": { "curves": { "ShadingRate": 5.0, "mode": "tube" }, "refinementLevel": 1 } },
+        { "regex": "/World/Tiger_Fur.*", "attributes": { "curves": { "ShadingRate": 0.1 } } },
+        { "regex": ".*_proxy", "attributes": { "refinementLevel": 0 } },
+        { "regex": ".*Mane.*", "attributes": { "curves": { "mode": "ribbon" } } },
+        { "regex": "/World/Ground", "attributes": { "refinementLevel": 4 } },
+        { "regex": "/World/Rock_[0-9]+/mesh", "attributes": { "refinementLevel": 2 } },
+        { "regex": "/World/Tiger\\.Eye.*", "attributes": { "refinementLevel": 3 } },
+        { "regex": ".*\\d.*", "attributes": { "curves": { "ShadingRate": 2.0 } } },
+        { "displacement": 1.5, "displacement.filter": "/World/Rock_.*", "smooth": true, "smooth.filter": [".*_proxy", true] }
+    ])");
+}
+
+std::vector<std::string> createTestShapeNames(size_t count)
+{
+    const char* kNames[] = {
+        "/World/Tiger_Fur/back", "/World/Tiger_Mane/top", "/World/Tiger.Eye_L", "/World/TigerxEye_R", "/World/Ground",
+        "/World/Ground_proxy",   "/World/Rock_12/mesh",   "/World/Rock_a/mesh", "/World/Tree/leaves",  "",
+    };
+    std::vector<std::string> names;
+    for (size_t i = 0; i < count; i++)
+    {
+        std::string name = kNames[i % std::size(kNames)];
+        if (i >= std::size(kNames))
+            name += fmt::format("/prim{}", i);
+        names.push_back(name);
+    }
+    return names;
+}
 
 class Settings_UnitTestHarness
 {
@@ -62,6 +94,22 @@ FALCOR_SCRIPT_BINDING(Settings_UnitTestHarness)
 
 } // namespace
 
+namespace settings
+{
+/// Gives the tests access to the reference attribute lookup and the lookup memo.
+struct AttributeFilterTest
+{
+    static nlohmann::json getAttributeUncached(const AttributeFilter& filter, std::string_view shapeName, std::string_view attrName)
+    {
+        return filter.getAttributeUncached(shapeName, attrName);
+    }
+
+    static size_t getCacheSize(const AttributeFilter& filter) { return filter.mCache.size(); }
+    static uint64_t getCacheHits(const AttributeFilter& filter) { return filter.mCacheHits; }
+    static uint64_t getCacheMisses(const AttributeFilter& filter) { return filter.mCacheMisses; }
+};
+} // namespace settings
+
 CPU_TEST(Settings_PythonBinding)
 {
     Settings_UnitTestHarness harness;
@@ -431,4 +479,87 @@ CPU_TEST(Settings_UpdatePathsSeparate)
         EXPECT_EQ(settings.getSearchDirectories("media")[3], std::filesystem::weakly_canonical(C_DRIVE "/media/four"));
     }
 }
+
+CPU_TEST(Settings_AttributeFilterMatching)
+{
+    settings::AttributeFilter filter;
+    filter.add(createTestFilters());
+
+    const char* kAttributes[] = {"curves:ShadingRate", "curves:mode", "refinementLevel", "displacement", "smooth", "unknown"};
+
+    // Query twice to check both uncached and memoized lookups against matching all filters with std::regex.
+    const auto shapeNames = createTestShapeNames(100);
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (const auto& shapeName : shapeNames)
+        {
+            for (const char* attrName : kAttributes)
+            {
+                nlohmann::json expected = settings::AttributeFilterTest::getAttributeUncached(filter, shapeName, attrName);
+                std::string msg = fmt::format("shape '{}' attribute '{}'", shapeName, attrName);
+                if (expected.is_string())
+                    EXPECT_EQ_MSG(filter.getAttribute<std::string>(shapeName, attrName, ""), expected.get<std::string>(), msg);
+                else
+                    EXPECT_EQ_MSG(filter.getAttribute<float>(shapeName, attrName, -1.f), expected.is_null() ? -1.f : expected.get<float>(), msg);
+            }
+        }
+    }
+    const uint64_t lookupCount = shapeNames.size() * std::size(kAttributes);
+    EXPECT_EQ(settings::AttributeFilterTest::getCacheMisses(filter), lookupCount);
+    EXPECT_EQ(settings::AttributeFilterTest::getCacheHits(filter), lookupCount);
+
+    EXPECT_EQ(filter.getAttribute<int>("/World/Ground", "refinementLevel", -1), 4);
+    EXPECT_EQ(filter.getAttribute<int>("/World/Rock_12/mesh", "refinementLevel", -1), 2);
+    EXPECT_EQ(filter.getAttribute<int>("/World/Tiger.Eye_L", "refinementLevel", -1), 3);
+    EXPECT_EQ(filter.getAttribute<int>("/World/TigerxEye_R", "refinementLevel", -1), 1);
+    EXPECT_EQ(filter.getAttribute<std::string>("/World/Tiger_Mane/top", "curves:mode", ""), "ribbon");
+    EXPECT_EQ(filter.getAttribute<bool>("/World/Ground_proxy", "smooth", false), false);
+    EXPECT_EQ(filter.getAttribute<bool>("/World/Ground", "smooth", false), true);
+
+    // Adding filters rebuilds the attribute index and invalidates memoized results.
+    filter.add(nlohmann::json::parse(R"({ "regex": "/World/Ground", "attributes": { "refinementLevel": 5 } })"));
+    EXPECT_EQ(filter.getAttribute<int>("/World/Ground", "refinementLevel", -1), 5);
+    filter.clear();
+    EXPECT_EQ(filter.getAttribute<int>("/World/Ground", "refinementLevel", -1), -1);
+
+    // The memo is bounded.
+    filter.add(createTestFilters());
+    for (const auto& shapeName : createTestShapeNames(settings::AttributeFilter::kMaxCacheSize + 100))
+        filter.getAttribute<int>(shapeName, "refinementLevel", -1);
+    EXPECT_LE(settings::AttributeFilterTest::getCacheSize(filter), settings::AttributeFilter::kMaxCacheSize);
+    EXPECT_EQ(filter.getAttribute<int>("/World/Ground", "refinementLevel", -1), 4);
+}
+
+CPU_BENCHMARK(Settings_AttributeFilterLookup)
+{
+    // Lookup of a refinement level per prim, compared to matching all filters with std::regex.
+    settings::AttributeFilter filter;
+    filter.add(createTestFilters());
+    const auto shapeNames = createTestShapeNames(100000);
+    bench.setItemsPerIteration(shapeNames.size());
+
+    bench.run(
+        "Regex",
+        [&]()
+        {
+            for (const auto& shapeName : shapeNames)
+                doNotOptimize(settings::AttributeFilterTest::getAttributeUncached(filter, shapeName, "refinementLevel"));
+        }
+    );
+    bench.run(
+        "Memoized",
+        [&]()
+        {
+            for (const auto& shapeName : shapeNames)
+                doNotOptimize(filter.getAttribute<int>(shapeName, "refinementLevel", 0));
+        }
+    );
+
+    // Only the first iteration matches the filters, repeated lookups are answered by the memo.
+    const uint64_t misses = settings::AttributeFilterTest::getCacheMisses(filter);
+    const uint64_t hits = settings::AttributeFilterTest::getCacheHits(filter);
+    EXPECT_EQ(misses, shapeNames.size());
+    EXPECT_GT(hits, 0u);
+    EXPECT_EQ((misses + hits) % shapeNames.size(), 0u);
+}
 } // namespace Falcor
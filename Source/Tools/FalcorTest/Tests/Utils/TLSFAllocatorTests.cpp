@@ -0,0 +1,168 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/TLSFAllocator.h"
+
+#include <algorithm>
+#include <random>
+
+namespace Falcor
+{
+namespace
+{
+bool overlaps(const TLSFAllocator::Allocation& a, const TLSFAllocator::Allocation& b)
+{
+    return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+} // namespace
+
+CPU_TEST(TLSFAllocator_Basic)
+{
+    TLSFAllocator allocator(1024);
+    EXPECT(allocator.empty());
+    EXPECT(allocator.validate());
+
+    auto a = allocator.allocate(100);
+    auto b = allocator.allocate(100, 256);
+    ASSERT(a.isValid() && b.isValid());
+    EXPECT_EQ(a.offset, 0);
+    EXPECT_EQ(b.offset, 256); // The padding [100, 256) is returned to the free lists.
+    EXPECT(allocator.validate());
+
+    auto stats = allocator.getStats();
+    EXPECT_EQ(stats.allocationCount, 2);
+    EXPECT_EQ(stats.usedSize, 200);
+    EXPECT_EQ(stats.freeSize, 824);
+    EXPECT_EQ(stats.freeBlockCount, 2);
+    EXPECT_EQ(stats.largestFreeBlock, 668);
+
+    EXPECT(!allocator.allocate(1000).isValid());
+    EXPECT(!allocator.allocate(700).isValid());
+
+    // Freeing merges the free ranges again.
+    allocator.free(a);
+    allocator.free(b);
+    EXPECT(allocator.empty());
+    EXPECT(allocator.validate());
+    stats = allocator.getStats();
+    EXPECT_EQ(stats.freeBlockCount, 1);
+    EXPECT_EQ(stats.largestFreeBlock, 1024);
+    EXPECT_EQ(stats.getFragmentation(), 0.0);
+
+    auto c = allocator.allocate(1024);
+    EXPECT(c.isValid());
+    EXPECT_EQ(c.offset, 0);
+    allocator.free(c);
+
+    // Invalid allocations are ignored.
+    allocator.free(TLSFAllocator::Allocation());
+    EXPECT(allocator.validate());
+}
+
+CPU_TEST(TLSFAllocator_Fuzz)
+{
+    std::mt19937 rng(7);
+
+    for (uint32_t round = 0; round < 10; ++round)
+    {
+        uint64_t capacity = 1 + rng() % (1 << 20);
+        TLSFAllocator allocator(capacity);
+        std::vector<TLSFAllocator::Allocation> allocations;
+
+        for (uint32_t i = 0; i < 10000; ++i)
+        {
+            if (allocations.empty() || rng() % 100 < 55)
+            {
+                uint64_t size = 1 + (rng() % 4 == 0 ? rng() % 65536 : rng() % 256);
+                uint64_t alignment = 1ull << (rng() % 9);
+                auto allocation = allocator.allocate(size, alignment);
+                if (!allocation.isValid())
+                    continue;
+
+                EXPECT_EQ(allocation.offset % alignment, 0);
+                EXPECT_LE(allocation.offset + size, capacity);
+                for (const auto& other : allocations)
+                    EXPECT(!overlaps(allocation, other)) << "offset = " << allocation.offset << ", size = " << size;
+                allocations.push_back(allocation);
+            }
+            else
+            {
+                size_t index = rng() % allocations.size();
+                allocator.free(allocations[index]);
+                allocations[index] = allocations.back();
+                allocations.pop_back();
+            }
+
+            if (i % 1000 == 0)
+                EXPECT(allocator.validate()) << "round = " << round << ", i = " << i;
+        }
+
+        for (const auto& allocation : allocations)
+            allocator.free(allocation);
+        EXPECT(allocator.validate());
+        auto stats = allocator.getStats();
+        EXPECT_EQ(stats.freeBlockCount, 1);
+        EXPECT_EQ(stats.freeSize, capacity);
+    }
+}
+
+CPU_BENCHMARK(TLSFAllocator_Fragmentation)
+{
+    // Churn a mix of small allocations with random lifetimes, similar to per-object buffers.
+    const uint32_t kLiveCount = 10000;
+    TLSFAllocator allocator(256 * 1024 * 1024);
+    std::mt19937 rng(1);
+    std::vector<TLSFAllocator::Allocation> allocations;
+    allocations.reserve(kLiveCount);
+    for (uint32_t i = 0; i < kLiveCount; ++i)
+        allocations.push_back(allocator.allocate(16 + rng() % 4096, 16));
+
+    bench.setItemsPerIteration(1000);
+    bench.run(
+        [&]()
+        {
+            for (uint32_t i = 0; i < 1000; ++i)
+            {
+                size_t index = rng() % allocations.size();
+                allocator.free(allocations[index]);
+                allocations[index] = allocator.allocate(16 + rng() % 4096, 16);
+            }
+        }
+    );
+
+    auto stats = allocator.getStats();
+    logInfo(
+        "TLSFAllocator: {} allocations, {} free blocks, fragmentation {:.3f}.",
+        stats.allocationCount,
+        stats.freeBlockCount,
+        stats.getFragmentation()
+    );
+    EXPECT(allocator.validate());
+    EXPECT_EQ(stats.allocationCount, kLiveCount);
+}
+} // namespace Falcor
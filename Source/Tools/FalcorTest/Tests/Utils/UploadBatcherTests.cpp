@@ -0,0 +1,170 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Testing/UnitTest.h"
+#include "Utils/UploadBatcher.h"
+
+#include <numeric>
+
+namespace Falcor
+{
+namespace
+{
+using Range = UploadRangeList::Range;
+
+std::vector<uint8_t> makeData(uint64_t size, uint8_t value)
+{
+    return std::vector<uint8_t>(size, value);
+}
+} // namespace
+
+CPU_TEST(UploadRangeList_Coalesce)
+{
+    UploadRangeList list;
+    EXPECT(list.empty());
+    EXPECT(list.coalesce().empty());
+
+    auto data = makeData(64, 1);
+    list.write(32, data.data(), 16); // [32, 48)
+    list.write(0, data.data(), 16);  // [0, 16)
+    list.write(16, data.data(), 8);  // [16, 24), adjacent to [0, 16)
+    list.write(40, data.data(), 16); // [40, 56), overlaps [32, 48)
+    list.write(100, data.data(), 4); // [100, 104)
+    list.write(101, data.data(), 2); // [101, 103), contained in [100, 104)
+    list.write(200, data.data(), 0); // Empty, ignored.
+
+    EXPECT_EQ(list.getWriteCount(), 6);
+    EXPECT_EQ(list.getDataSize(), 62);
+
+    auto ranges = list.coalesce();
+    ASSERT_EQ(ranges.size(), 3);
+    EXPECT(ranges[0] == (Range{0, 24}));
+    EXPECT(ranges[1] == (Range{32, 24}));
+    EXPECT(ranges[2] == (Range{100, 4}));
+
+    list.clear();
+    EXPECT(list.empty());
+    EXPECT_EQ(list.getDataSize(), 0);
+}
+
+CPU_TEST(UploadRangeList_Gather)
+{
+    // Later writes win where writes overlap.
+    UploadRangeList list;
+    list.write(8, makeData(8, 1).data(), 8);   // [8, 16)
+    list.write(0, makeData(12, 2).data(), 12); // [0, 12)
+    list.write(40, makeData(4, 3).data(), 4);  // [40, 44)
+    list.write(4, makeData(2, 4).data(), 2);   // [4, 6)
+
+    auto ranges = list.coalesce();
+    ASSERT_EQ(ranges.size(), 2);
+    EXPECT(ranges[0] == (Range{0, 16}));
+    EXPECT(ranges[1] == (Range{40, 4}));
+
+    // Tightly packed.
+    {
+        EXPECT_EQ(UploadRangeList::getStagingSize(ranges), 20);
+        std::vector<uint8_t> staging(20, 0xff);
+        list.gather(ranges, staging.data());
+        const uint8_t expected[] = {2, 2, 2, 2, 4, 4, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 3, 3, 3, 3};
+        for (size_t i = 0; i < staging.size(); i++)
+            EXPECT_EQ(staging[i], expected[i]) << "i = " << i;
+    }
+
+    // Aligned ranges.
+    {
+        EXPECT_EQ(UploadRangeList::getStagingSize(ranges, 32), 36);
+        std::vector<uint8_t> staging(36, 0xff);
+        list.gather(ranges, staging.data(), 32);
+        for (size_t i = 16; i < 32; i++)
+            EXPECT_EQ(staging[i], 0xff) << "i = " << i;
+        for (size_t i = 32; i < 36; i++)
+            EXPECT_EQ(staging[i], 3) << "i = " << i;
+    }
+}
+
+CPU_TEST(UploadRangeList_ManyElements)
+{
+    // Per-element updates in random order coalesce into a single range.
+    const uint32_t elementCount = 1000;
+    std::vector<uint32_t> order(elementCount);
+    std::iota(order.begin(), order.end(), 0);
+    for (uint32_t i = 0; i < elementCount; i++)
+        std::swap(order[i], order[(i * 7919) % elementCount]);
+
+    UploadRangeList list;
+    for (uint32_t index : order)
+        list.write(index * sizeof(uint32_t), &index, sizeof(uint32_t));
+
+    auto ranges = list.coalesce();
+    ASSERT_EQ(ranges.size(), 1);
+    EXPECT(ranges[0] == (Range{0, elementCount * sizeof(uint32_t)}));
+
+    std::vector<uint32_t> staging(elementCount);
+    list.gather(ranges, reinterpret_cast<uint8_t*>(staging.data()));
+    for (uint32_t i = 0; i < elementCount; i++)
+        EXPECT_EQ(staging[i], i);
+}
+
+GPU_TEST(UploadBatcher_Flush)
+{
+    ref<Device> pDevice = ctx.getDevice();
+    const uint32_t elementCount = 256;
+
+    std::vector<uint32_t> initData(elementCount, 0);
+    ref<Buffer> pBufferA = pDevice->createStructuredBuffer(sizeof(uint32_t), elementCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, initData.data());
+    ref<Buffer> pBufferB = pDevice->createStructuredBuffer(sizeof(uint32_t), elementCount, ResourceBindFlags::ShaderResource, MemoryType::DeviceLocal, initData.data());
+
+    // Interleaved per-element writes to two buffers, every fourth element is skipped.
+    UploadBatcher batcher(pDevice);
+    for (uint32_t i = 0; i < elementCount; i++)
+    {
+        if (i % 4 == 3)
+            continue;
+        batcher.setElement(pBufferA, i, i + 1);
+        batcher.setElement(pBufferB, i, 2 * i + 1);
+    }
+    EXPECT(batcher.hasPendingWrites());
+
+    batcher.flush(ctx.getRenderContext());
+    EXPECT(!batcher.hasPendingWrites());
+
+    const auto& stats = batcher.getStats();
+    EXPECT_EQ(stats.flushCount, 1);
+    EXPECT_EQ(stats.writeCount, 2 * elementCount * 3 / 4);
+    EXPECT_EQ(stats.copyCount, 2 * elementCount / 4);
+    EXPECT_EQ(stats.uploadedBytes, stats.writtenBytes);
+
+    auto dataA = pBufferA->getElements<uint32_t>();
+    auto dataB = pBufferB->getElements<uint32_t>();
+    for (uint32_t i = 0; i < elementCount; i++)
+    {
+        EXPECT_EQ(dataA[i], i % 4 == 3 ? 0 : i + 1) << "i = " << i;
+        EXPECT_EQ(dataB[i], i % 4 == 3 ? 0 : 2 * i + 1) << "i = " << i;
+    }
+}
+} // namespace Falcor
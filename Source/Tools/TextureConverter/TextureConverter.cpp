@@ -0,0 +1,611 @@
+/***************************************************************************
+ # Copyright (c) 2015-23, NVIDIA CORPORATION. All rights reserved.
+ #
+ # Redistribution and use in source and binary forms, with or without
+ # modification, are permitted provided that the following conditions
+ # are met:
+ #  * Redistributions of source code must retain the above copyright
+ #    notice, this list of conditions and the following disclaimer.
+ #  * Redistributions in binary form must reproduce the above copyright
+ #    notice, this list of conditions and the following disclaimer in the
+ #    documentation and/or other materials provided with the distribution.
+ #  * Neither the name of NVIDIA CORPORATION nor the names of its
+ #    contributors may be used to endorse or promote products derived
+ #    from this software without specific prior written permission.
+ #
+ # THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS "AS IS" AND ANY
+ # EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ # IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ # PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ # CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ # EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ # PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ # PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ **************************************************************************/
+#include "Core/Error.h"
+#include "Core/Platform/OS.h"
+#include "Core/Platform/MemoryMappedFile.h"
+#include "Utils/CryptoUtils.h"
+#include "Utils/Image/Bitmap.h"
+#include "Utils/Image/ImageIO.h"
+#include "Utils/StringFormatters.h"
+#include "Utils/Timing/CpuTimer.h"
+
+#include <FreeImage.h>
+#include <args.hxx>
+#include <BS_thread_pool_light.hpp>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace Falcor;
+
+namespace
+{
+/// Name of the manifest file written to the output directory.
+const std::string kManifestFilename = "TextureConverter.json";
+/// Version of the manifest. Bump to invalidate all previously converted files.
+const uint32_t kManifestVersion = 1;
+/// File extensions picked up when scanning input directories.
+const std::set<std::string> kInputExtensions = {"png", "jpg", "jpeg", "tga", "bmp", "pfm", "exr", "hdr", "tif", "tiff"};
+
+const std::map<std::string, ImageIO::CompressionMode> kCompressionModes = {
+    {"none", ImageIO::CompressionMode::None},
+    {"bc1", ImageIO::CompressionMode::BC1},
+    {"bc2", ImageIO::CompressionMode::BC2},
+    {"bc3", ImageIO::CompressionMode::BC3},
+    {"bc4", ImageIO::CompressionMode::BC4},
+    {"bc5", ImageIO::CompressionMode::BC5},
+    {"bc6", ImageIO::CompressionMode::BC6},
+    {"bc7", ImageIO::CompressionMode::BC7},
+};
+
+std::string getCompressionModeName(ImageIO::CompressionMode mode)
+{
+    for (const auto& [name, value] : kCompressionModes)
+        if (value == mode)
+            return name;
+    FALCOR_UNREACHABLE();
+}
+
+/// Pick a compression mode matching the channels and range of the decoded bitmap.
+/// HDR data always uses BC6, as BC4 and BC5 would clamp it to [0,1].
+ImageIO::CompressionMode chooseCompressionMode(ResourceFormat format)
+{
+    if (getFormatType(format) == FormatType::Float)
+        return ImageIO::CompressionMode::BC6;
+    if (getFormatChannelCount(format) == 1)
+        return ImageIO::CompressionMode::BC4;
+    if (getFormatChannelCount(format) == 2)
+        return ImageIO::CompressionMode::BC5;
+    return ImageIO::CompressionMode::BC7;
+}
+
+struct Options
+{
+    std::optional<ImageIO::CompressionMode> mode; ///< Compression mode, chosen per file if not set.
+    bool generateMips = false;
+    bool force = false;
+    bool verbose = false;
+};
+
+struct Job
+{
+    std::filesystem::path input;
+    std::filesystem::path output;
+    std::string key; ///< Output path relative to the output directory, used as manifest key.
+};
+
+struct JobResult
+{
+    enum class Status
+    {
+        Converted,
+        Skipped,
+        Failed,
+    };
+
+    Status status = Status::Failed;
+    std::string hash;
+    std::string mode;
+    uint64_t pixelCount = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    double decodeTime = 0.0; ///< Decode time in ms.
+    double encodeTime = 0.0; ///< Mip generation, compression and write time in ms.
+    std::string error;
+};
+
+struct ManifestEntry
+{
+    std::string hash;
+    std::string mode;
+};
+
+using Manifest = std::map<std::string, ManifestEntry>;
+
+Manifest loadManifest(const std::filesystem::path& path)
+{
+    Manifest manifest;
+    std::ifstream ifs(path);
+    if (!ifs.good())
+        return manifest;
+
+    try
+    {
+        nlohmann::json json = nlohmann::json::parse(ifs);
+        if (json.at("version").get<uint32_t>() != kManifestVersion)
+            return manifest;
+        for (const auto& [key, value] : json.at("files").items())
+            manifest[key] = {value.at("hash").get<std::string>(), value.at("mode").get<std::string>()};
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        fmt::print(stderr, "Ignoring invalid manifest '{}': {}\n", path, e.what());
+        manifest.clear();
+    }
+    return manifest;
+}
+
+void saveManifest(const std::filesystem::path& path, const Manifest& manifest)
+{
+    nlohmann::json files = nlohmann::json::object();
+    for (const auto& [key, entry] : manifest)
+        files[key] = {{"hash", entry.hash}, {"mode", entry.mode}};
+
+    nlohmann::json json;
+    json["version"] = kManifestVersion;
+    json["files"] = std::move(files);
+
+    std::ofstream ofs(path);
+    ofs << json.dump(4);
+    if (!ofs.good())
+        fmt::print(stderr, "Failed to write manifest '{}'.\n", path);
+}
+
+/// Hash the file content together with all options that affect the output.
+std::string computeHash(const void* data, size_t size, const Options& options)
+{
+    SHA1 sha1;
+    sha1.update(kManifestVersion);
+    sha1.update(options.mode ? getCompressionModeName(*options.mode) : std::string("auto"));
+    sha1.update(options.generateMips);
+    sha1.update(data, size);
+    return SHA1::toString(sha1.finalize());
+}
+
+struct ImageInfo
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t bitsPerPixel = 0;
+};
+
+/// Read the image dimensions from the file header without decoding the pixels.
+std::optional<ImageInfo> probeImage(const void* data, size_t size)
+{
+    FIMEMORY* memory = FreeImage_OpenMemory((BYTE*)data, (DWORD)size);
+    FREE_IMAGE_FORMAT fif = FreeImage_GetFileTypeFromMemory(memory, 0);
+    FIBITMAP* pDib = fif != FIF_UNKNOWN ? FreeImage_LoadFromMemory(fif, memory, FIF_LOAD_NOPIXELS) : nullptr;
+    FreeImage_CloseMemory(memory);
+    if (pDib == nullptr)
+        return {};
+
+    ImageInfo info{FreeImage_GetWidth(pDib), FreeImage_GetHeight(pDib), FreeImage_GetBPP(pDib)};
+    FreeImage_Unload(pDib);
+    return info;
+}
+
+/**
+ * Estimate the peak memory needed to convert an image.
+ * This covers the decoded bitmap (palettized and 24-bit images are expanded to 32 bits, 96-bit images to 128 bits)
+ * and the float RGBA surfaces NVTT works on while building mips and compressing.
+ */
+uint64_t estimateMemory(const ImageInfo& info, bool generateMips)
+{
+    uint64_t bitmapBytesPerPixel = info.bitsPerPixel <= 32 ? 4 : (info.bitsPerPixel <= 64 ? 8 : 16);
+    if (info.bitsPerPixel == 16)
+        bitmapBytesPerPixel = 2;
+    uint64_t bytes = uint64_t(info.width) * info.height * (bitmapBytesPerPixel + 2 * 4 * sizeof(float));
+    if (generateMips)
+        bytes += bytes / 3;
+    return bytes;
+}
+
+/**
+ * Bounds the memory used by conversions in flight.
+ * A request larger than the whole budget is admitted once nothing else is in flight so it cannot stall forever.
+ */
+class MemoryBudget
+{
+public:
+    MemoryBudget(uint64_t capacity) : mCapacity(capacity) {}
+
+    void acquire(uint64_t size)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [&]() { return mUsed + size <= mCapacity || mUsed == 0; });
+        mUsed += size;
+        mPeak = std::max(mPeak, mUsed);
+    }
+
+    void release(uint64_t size)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            FALCOR_ASSERT(mUsed >= size);
+            mUsed -= size;
+        }
+        mCondition.notify_all();
+    }
+
+    uint64_t getPeak() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPeak;
+    }
+
+private:
+    uint64_t mCapacity;
+    uint64_t mUsed = 0;
+    uint64_t mPeak = 0;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+};
+
+/// Holds a reservation in a memory budget for the lifetime of the object.
+class BudgetReservation
+{
+public:
+    BudgetReservation(MemoryBudget& budget, uint64_t size) : mBudget(budget), mSize(size) { mBudget.acquire(mSize); }
+    ~BudgetReservation() { mBudget.release(mSize); }
+
+    BudgetReservation(const BudgetReservation&) = delete;
+    BudgetReservation& operator=(const BudgetReservation&) = delete;
+
+private:
+    MemoryBudget& mBudget;
+    uint64_t mSize;
+};
+
+JobResult convert(const Job& job, const Options& options, const Manifest& manifest, MemoryBudget& budget)
+{
+    JobResult result;
+    result.mode = options.mode ? getCompressionModeName(*options.mode) : "auto";
+
+    try
+    {
+        // Hash the source and probe its header. Unchanged files are skipped before any decoding happens.
+        std::optional<ImageInfo> info;
+        {
+            MemoryMappedFile file(job.input, MemoryMappedFile::kWholeFile, MemoryMappedFile::AccessHint::SequentialScan);
+            FALCOR_CHECK(file.isOpen(), "Failed to open file.");
+            result.inputBytes = file.getSize();
+            result.hash = computeHash(file.getData(), file.getSize(), options);
+
+            auto it = manifest.find(job.key);
+            if (!options.force && it != manifest.end() && it->second.hash == result.hash && std::filesystem::exists(job.output))
+            {
+                result.status = JobResult::Status::Skipped;
+                result.mode = it->second.mode;
+                return result;
+            }
+
+            info = probeImage(file.getData(), file.getSize());
+            FALCOR_CHECK(info, "Unsupported image file.");
+        }
+
+        BudgetReservation reservation(budget, estimateMemory(*info, options.generateMips));
+
+        auto startTime = CpuTimer::getCurrentTimePoint();
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(job.input, true);
+        FALCOR_CHECK(pBitmap, "Failed to decode image.");
+        auto decodeTime = CpuTimer::getCurrentTimePoint();
+
+        ImageIO::CompressionMode mode = options.mode ? *options.mode : chooseCompressionMode(pBitmap->getFormat());
+        result.mode = getCompressionModeName(mode);
+        ImageIO::saveToDDS(job.output, *pBitmap, mode, options.generateMips);
+        auto encodeTime = CpuTimer::getCurrentTimePoint();
+
+        result.status = JobResult::Status::Converted;
+        result.pixelCount = uint64_t(pBitmap->getWidth()) * pBitmap->getHeight();
+        result.outputBytes = std::filesystem::file_size(job.output);
+        result.decodeTime = CpuTimer::calcDuration(startTime, decodeTime);
+        result.encodeTime = CpuTimer::calcDuration(decodeTime, encodeTime);
+    }
+    catch (const std::exception& e)
+    {
+        result.status = JobResult::Status::Failed;
+        result.error = e.what();
+    }
+
+    return result;
+}
+
+/// Collect conversion jobs from the input files and directories.
+std::vector<Job> gatherJobs(const std::vector<std::string>& inputs, const std::filesystem::path& outputDir, bool recursive)
+{
+    std::vector<Job> jobs;
+    std::map<std::string, std::filesystem::path> inputsByKey;
+    auto addJob = [&](const std::filesystem::path& input, std::filesystem::path relativePath)
+    {
+        relativePath.replace_extension(".dds");
+        std::string key = relativePath.generic_string();
+        // Inputs differing only in extension or input directory would overwrite each other's output.
+        auto [it, inserted] = inputsByKey.emplace(key, input);
+        if (!inserted)
+            FALCOR_THROW("Inputs '{}' and '{}' both convert to '{}'.", it->second, input, key);
+        jobs.push_back({input, outputDir / relativePath, std::move(key)});
+    };
+
+    for (const auto& input : inputs)
+    {
+        std::filesystem::path path(input);
+        if (std::filesystem::is_directory(path))
+        {
+            std::vector<std::filesystem::path> files;
+            auto addFile = [&](const std::filesystem::directory_entry& entry)
+            {
+                if (entry.is_regular_file() && kInputExtensions.count(getExtensionFromPath(entry.path())) > 0)
+                    files.push_back(entry.path());
+            };
+            if (recursive)
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path))
+                    addFile(entry);
+            else
+                for (const auto& entry : std::filesystem::directory_iterator(path))
+                    addFile(entry);
+
+            // Directory iteration order is unspecified, sort to get deterministic output.
+            std::sort(files.begin(), files.end());
+            for (const auto& file : files)
+                addJob(file, std::filesystem::relative(file, path));
+        }
+        else if (std::filesystem::is_regular_file(path))
+        {
+            addJob(path, path.filename());
+        }
+        else
+        {
+            FALCOR_THROW("Input '{}' does not exist.", path);
+        }
+    }
+
+    return jobs;
+}
+
+struct FormatStats
+{
+    uint32_t converted = 0;
+    uint32_t skipped = 0;
+    uint32_t failed = 0;
+    uint64_t pixelCount = 0;
+    uint64_t inputBytes = 0;
+    uint64_t outputBytes = 0;
+    double decodeTime = 0.0;
+    double encodeTime = 0.0;
+
+    void add(const JobResult& result)
+    {
+        switch (result.status)
+        {
+        case JobResult::Status::Converted:
+            converted++;
+            break;
+        case JobResult::Status::Skipped:
+            skipped++;
+            return;
+        case JobResult::Status::Failed:
+            failed++;
+            return;
+        }
+        pixelCount += result.pixelCount;
+        inputBytes += result.inputBytes;
+        outputBytes += result.outputBytes;
+        decodeTime += result.decodeTime;
+        encodeTime += result.encodeTime;
+    }
+};
+
+void printReport(const std::vector<JobResult>& results, double totalTime, uint64_t peakMemory)
+{
+    std::map<std::string, FormatStats> statsPerMode;
+    FormatStats total;
+    for (const auto& result : results)
+    {
+        statsPerMode[result.mode].add(result);
+        total.add(result);
+    }
+
+    // Decode and encode rates are per worker thread, the total rate covers wall-clock time across all threads.
+    auto rate = [](uint64_t count, double ms) { return ms > 0.0 ? count * 1e-6 / (ms * 1e-3) : 0.0; };
+    auto printRow = [&](const std::string& name, const FormatStats& stats)
+    {
+        fmt::print(
+            "{:<8}{:>10}{:>9}{:>8}{:>12.2f}{:>12.2f}{:>12.2f}{:>15.2f}{:>15.2f}\n",
+            name,
+            stats.converted,
+            stats.skipped,
+            stats.failed,
+            stats.pixelCount * 1e-6,
+            stats.inputBytes * 1e-6,
+            stats.outputBytes * 1e-6,
+            rate(stats.pixelCount, stats.decodeTime),
+            rate(stats.pixelCount, stats.encodeTime)
+        );
+    };
+
+    fmt::print(
+        "\n{:<8}{:>10}{:>9}{:>8}{:>12}{:>12}{:>12}{:>15}{:>15}\n",
+        "Mode",
+        "Converted",
+        "Skipped",
+        "Failed",
+        "MPixels",
+        "Input MB",
+        "Output MB",
+        "Decode MPix/s",
+        "Encode MPix/s"
+    );
+    for (const auto& [mode, stats] : statsPerMode)
+        printRow(mode, stats);
+    printRow("total", total);
+
+    fmt::print(
+        "\nConverted {} of {} files in {:.2f} s ({:.2f} MPix/s, {:.2f} MB/s input), peak reserved memory {:.1f} MB.\n",
+        total.converted,
+        results.size(),
+        totalTime * 1e-3,
+        rate(total.pixelCount, totalTime),
+        rate(total.inputBytes, totalTime),
+        peakMemory * 1e-6
+    );
+}
+} // namespace
+
+int runMain(int argc, char** argv)
+{
+    args::ArgumentParser parser("Batch convert images to compressed DDS textures.");
+    parser.helpParams.programName = "TextureConverter";
+    args::HelpFlag helpFlag(parser, "help", "Display this help menu.", {'h', "help"});
+    args::ValueFlag<std::string> outputFlag(parser, "dir", "Output directory.", {'o', "output"}, args::Options::Required);
+    args::ValueFlag<std::string> modeFlag(
+        parser, "auto|none|bc1..bc7", "Compression mode (default: auto, chosen from the image channels and range).", {'c', "compression"}
+    );
+    args::Flag mipsFlag(parser, "", "Generate mip maps.", {'m', "mips"});
+    args::Flag recursiveFlag(parser, "", "Recurse into input directories.", {'r', "recursive"});
+    args::Flag forceFlag(parser, "", "Convert all files, even if unchanged since the last run.", {'f', "force"});
+    args::ValueFlag<uint32_t> threadsFlag(parser, "N", "Number of worker threads (default: number of logical cores).", {'j', "threads"});
+    args::ValueFlag<uint64_t> memoryFlag(parser, "MB", "Memory budget for conversions in flight (default: 4096).", {"memory-budget"});
+    args::Flag verboseFlag(parser, "", "Print a line for each file.", {'v', "verbose"});
+    args::PositionalList<std::string> inputsList(parser, "inputs", "Input image files or directories.", args::Options::Required);
+
+    args::CompletionFlag completionFlag(parser, {"complete"});
+
+    try
+    {
+        parser.ParseCLI(argc, argv);
+    }
+    catch (const args::Completion& e)
+    {
+        std::cout << e.what();
+        return 0;
+    }
+    catch (const args::Help&)
+    {
+        std::cout << parser;
+        return 0;
+    }
+    catch (const args::ParseError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+    catch (const args::RequiredError& e)
+    {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    Options options;
+    if (modeFlag && args::get(modeFlag) != "auto")
+    {
+        auto it = kCompressionModes.find(args::get(modeFlag));
+        if (it == kCompressionModes.end())
+        {
+            std::cerr << "Invalid compression mode, use 'auto', 'none' or 'bc1' to 'bc7'" << std::endl;
+            return 1;
+        }
+        options.mode = it->second;
+    }
+    options.generateMips = mipsFlag;
+    options.force = forceFlag;
+    options.verbose = verboseFlag;
+
+    const std::filesystem::path outputDir = args::get(outputFlag);
+    const uint64_t memoryBudget = (memoryFlag ? args::get(memoryFlag) : 4096) << 20;
+
+    std::vector<Job> jobs = gatherJobs(args::get(inputsList), outputDir, recursiveFlag);
+    std::set<std::filesystem::path> outputDirs;
+    for (const auto& job : jobs)
+        outputDirs.insert(job.output.parent_path());
+    for (const auto& dir : outputDirs)
+        std::filesystem::create_directories(dir);
+
+    const std::filesystem::path manifestPath = outputDir / kManifestFilename;
+    Manifest manifest = loadManifest(manifestPath);
+
+    std::vector<JobResult> results(jobs.size());
+    MemoryBudget budget(memoryBudget);
+    std::mutex printMutex;
+    size_t finishedCount = 0;
+
+    auto startTime = CpuTimer::getCurrentTimePoint();
+    {
+        BS::thread_pool_light threadPool(threadsFlag ? args::get(threadsFlag) : 0);
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            threadPool.push_task(
+                [&, i]()
+                {
+                    const JobResult& result = results[i] = convert(jobs[i], options, manifest, budget);
+
+                    std::lock_guard<std::mutex> lock(printMutex);
+                    ++finishedCount;
+                    if (result.status == JobResult::Status::Failed)
+                        fmt::print(stderr, "[{}/{}] Failed to convert '{}': {}\n", finishedCount, jobs.size(), jobs[i].input, result.error);
+                    else if (options.verbose)
+                        fmt::print(
+                            "[{}/{}] {} '{}' ({}, {:.1f} ms)\n",
+                            finishedCount,
+                            jobs.size(),
+                            result.status == JobResult::Status::Converted ? "Converted" : "Skipped",
+                            jobs[i].input,
+                            result.mode,
+                            result.decodeTime + result.encodeTime
+                        );
+                }
+            );
+        }
+        threadPool.wait_for_tasks();
+    }
+    double totalTime = CpuTimer::calcDuration(startTime, CpuTimer::getCurrentTimePoint());
+
+    // Record the converted files. Failed files are dropped from the manifest so they are retried on the next run.
+    uint32_t failedCount = 0;
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        if (results[i].status == JobResult::Status::Converted)
+            manifest[jobs[i].key] = {results[i].hash, results[i].mode};
+        else if (results[i].status == JobResult::Status::Failed)
+        {
+            manifest.erase(jobs[i].key);
+            failedCount++;
+        }
+    }
+    saveManifest(manifestPath, manifest);
+
+    printReport(results, totalTime, budget.getPeak());
+
+    return failedCount > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    return catchAndReportAllExceptions([&]() { return runMain(argc, argv); });
+}
@@ -31,6 +31,7 @@
 #include "Utils/Logger.h"
 #include "Utils/StringUtils.h"
 #include "Utils/NumericRange.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/Common.h"
 #include "Utils/Math/FalcorMath.h"
@@ -40,12 +41,15 @@
 #include "Scene/Material/StandardMaterial.h"
 
 #include <assimp/Importer.hpp>
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
+#include <assimp/version.h>
 #include <assimp/GltfMaterial.h>
 
 #include <pybind11/pybind11.h>
 
+#include <algorithm>
 #include <execution>
 #include <fstream>
 
@@ -153,6 +157,7 @@ public:
     std::map<uint32_t, ref<Material>> materialMap;
     std::map<uint32_t, MeshID> meshMap; // Assimp mesh index to Falcor mesh ID
     std::map<std::string, float4x4> localToBindPoseMatrices;
+    std::vector<std::filesystem::path> sourcePaths; ///< Files read by Assimp, or empty if loaded from memory. Used for the mesh cache keys.
 
     NodeID getFalcorNodeID(const aiNode* pNode) const { return mAiToFalcorNodeID.at(pNode); }
 
@@ -568,6 +573,7 @@ void createMeshes(ImporterData& data)
     const bool loadTangents = is_set(data.builder.getFlags(), SceneBuilder::Flags::UseOriginalTangentSpace);
 
     std::vector<const aiMesh*> meshes;
+    std::vector<uint32_t> meshIndices;
     for (uint32_t i = 0; i < pScene->mNumMeshes; ++i)
     {
         const aiMesh* pMesh = pScene->mMeshes[i];
@@ -582,8 +588,21 @@ void createMeshes(ImporterData& data)
             continue;
         }
         meshes.push_back(pMesh);
+        meshIndices.push_back(i);
     }
 
+    // Meshes loaded from files are looked up in the mesh cache by the file contents, so unchanged meshes are not converted and processed.
+    // The mesh name includes the options affecting Assimp's output. Meshes with bones are keyed by content,
+    // as their bone IDs depend on the scene graph.
+    const bool useFileCacheKeys = !data.sourcePaths.empty() && is_set(data.builder.getFlags(), SceneBuilder::Flags::UseCache);
+    const std::string cacheNamePrefix = fmt::format(
+        "assimp/{}.{}.{}/{}/",
+        aiGetVersionMajor(),
+        aiGetVersionMinor(),
+        aiGetVersionRevision(),
+        is_set(data.builder.getFlags(), SceneBuilder::Flags::DontMergeMeshes)
+    );
+
     // Pre-process meshes.
     std::vector<SceneBuilder::ProcessedMesh> processedMeshes(meshes.size());
     auto range = NumericRange<size_t>(0, meshes.size());
@@ -598,6 +617,16 @@ void createMeshes(ImporterData& data)
 
             SceneBuilder::Mesh mesh;
             mesh.name = pAiMesh->mName.C_Str();
+            mesh.topology = Vao::Topology::TriangleList;
+            mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
+
+            if (useFileCacheKeys && !pAiMesh->HasBones())
+            {
+                mesh.cacheKey = data.builder.getMeshCacheKey(data.sourcePaths, cacheNamePrefix + std::to_string(meshIndices[i]));
+                if (mesh.cacheKey && data.builder.readCachedMesh(mesh, processedMeshes[i]))
+                    return;
+            }
+
             mesh.faceCount = pAiMesh->mNumFaces;
 
             // Temporary memory for the vertex and index data.
@@ -612,7 +641,6 @@ void createMeshes(ImporterData& data)
             FALCOR_ASSERT(indexList.size() <= std::numeric_limits<uint32_t>::max());
             mesh.indexCount = (uint32_t)indexList.size();
             mesh.pIndices = indexList.data();
-            mesh.topology = Vao::Topology::TriangleList;
 
             // Vertices
             FALCOR_ASSERT(pAiMesh->mVertices);
@@ -649,8 +677,6 @@ void createMeshes(ImporterData& data)
                 mesh.boneWeights.frequency = SceneBuilder::Mesh::AttributeFrequency::Vertex;
             }
 
-            mesh.pMaterial = data.materialMap.at(pAiMesh->mMaterialIndex);
-
             processedMeshes[i] = data.builder.processMesh(mesh);
         }
     );
@@ -1098,6 +1124,27 @@ void dumpAssimpData(ImporterData& data)
     logInfo(out);
 }
 
+/**
+ * Assimp IO system recording the paths of all opened files.
+ */
+class RecordingIOSystem : public Assimp::DefaultIOSystem
+{
+public:
+    Assimp::IOStream* Open(const char* pFile, const char* pMode) override
+    {
+        Assimp::IOStream* pStream = Assimp::DefaultIOSystem::Open(pFile, pMode);
+        std::filesystem::path path(pFile);
+        if (pStream && std::find(mPaths.begin(), mPaths.end(), path) == mPaths.end())
+            mPaths.push_back(path);
+        return pStream;
+    }
+
+    const std::vector<std::filesystem::path>& getPaths() const { return mPaths; }
+
+private:
+    std::vector<std::filesystem::path> mPaths;
+};
+
 void importInternal(const void* buffer, size_t byteSize, const std::filesystem::path& path, SceneBuilder& builder)
 {
     TimeReport timeReport;
@@ -1125,18 +1172,25 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
     Assimp::Importer importer;
     importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, removeFlags);
 
+    // Record the files read by Assimp, such as glTF buffers. The importer takes ownership of the IO system.
+    auto pIOSystem = new RecordingIOSystem();
+    importer.SetIOHandler(pIOSystem);
+
     const aiScene* pScene = nullptr;
-    if (!path.empty())
     {
-        FALCOR_ASSERT(buffer == nullptr && byteSize == 0);
-        if (!path.is_absolute())
-            throw ImporterError(path, "Expected absolute path.");
-        pScene = importer.ReadFile(path.string().c_str(), assimpFlags);
-    }
-    else
-    {
-        FALCOR_ASSERT(buffer != nullptr && byteSize != 0);
-        pScene = importer.ReadFileFromMemory(buffer, byteSize, assimpFlags);
+        FALCOR_LOAD_PHASE("Loading asset file");
+        if (!path.empty())
+        {
+            FALCOR_ASSERT(buffer == nullptr && byteSize == 0);
+            if (!path.is_absolute())
+                throw ImporterError(path, "Expected absolute path.");
+            pScene = importer.ReadFile(path.string().c_str(), assimpFlags);
+        }
+        else
+        {
+            FALCOR_ASSERT(buffer != nullptr && byteSize != 0);
+            pScene = importer.ReadFileFromMemory(buffer, byteSize, assimpFlags);
+        }
     }
     if (!pScene)
         throw ImporterError(path, "Failed to open scene: {}", importer.GetErrorString());
@@ -1144,6 +1198,8 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
     timeReport.measure("Loading asset file");
 
     ImporterData data(path, pScene, builder);
+    if (!path.empty())
+        data.sourcePaths = pIOSystem->getPaths();
 
     validateScene(data);
     timeReport.measure("Verifying scene");
@@ -1160,14 +1216,22 @@ void importInternal(const void* buffer, size_t byteSize, const std::filesystem::
 
     // dumpAssimpData(data);
 
-    createAllMaterials(data, searchPath, importMode);
+    {
+        FALCOR_LOAD_PHASE("Creating materials");
+        createAllMaterials(data, searchPath, importMode);
+        LoadProfiler::instance().addCount("materials", pScene->mNumMaterials);
+    }
     timeReport.measure("Creating materials");
 
     createSceneGraph(data);
     timeReport.measure("Creating scene graph");
 
-    createMeshes(data);
-    addMeshInstances(data, data.pScene->mRootNode);
+    {
+        FALCOR_LOAD_PHASE("Creating meshes");
+        createMeshes(data);
+        addMeshInstances(data, data.pScene->mRootNode);
+        LoadProfiler::instance().addCount("meshes", pScene->mNumMeshes);
+    }
     timeReport.measure("Creating meshes");
 
     createAnimations(data, importMode);
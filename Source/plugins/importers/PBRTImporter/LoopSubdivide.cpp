@@ -30,133 +30,167 @@
 // pbrt is Copyright(c) 1998-2020 Matt Pharr, Wenzel Jakob, and Greg Humphreys.
 // The pbrt source code is licensed under the Apache License, Version 2.0.
 // SPDX: Apache-2.0
-
 #include "LoopSubdivide.h"
 #include "Core/Error.h"
+#include "Utils/NumericRange.h"
+#include "Utils/Timing/LoadProfiler.h"
+
+#include <fmt/format.h>
 
 #include <algorithm>
-#include <map>
-#include <memory>
-#include <memory_resource>
-#include <set>
+#include <execution>
+#include <numeric>
+#include <unordered_map>
 
 #include <cmath>
 
 namespace Falcor::pbrt
 {
 
-struct SDFace;
-struct SDVertex;
+namespace
+{
 
 #define NEXT(i) (((i) + 1) % 3)
 #define PREV(i) (((i) + 2) % 3)
 
-struct SDVertex
+constexpr uint32_t kInvalid = uint32_t(-1);
+
+/**
+ * Subdivision mesh stored in flat arrays.
+ * This mirrors the pointer based SDVertex/SDFace representation of pbrt, using indices instead of pointers.
+ * Vertex and face orders follow the pbrt implementation so that the results are identical.
+ */
+struct SubdivMesh
 {
-    SDVertex(const float3& p = float3(0.f)) : p(p) {}
+    // Vertices.
+    std::vector<float3> positions;
+    std::vector<uint32_t> startFace; ///< Index of a face adjacent to the vertex.
+    std::vector<uint8_t> boundary;   ///< 1 if vertex is on the boundary.
+    std::vector<uint8_t> regular;    ///< 1 if vertex is regular (valence 6 interior, valence 4 boundary).
 
-    int valence();
-    void oneRing(float3* p);
+    // Faces.
+    std::vector<uint32_t> faceVertices;  ///< 3 vertex indices per face.
+    std::vector<uint32_t> faceNeighbors; ///< 3 neighbor face indices per face. Neighbor k is adjacent across edge (k, NEXT(k)).
 
-    float3 p;
-    SDFace* startFace = nullptr;
-    SDVertex* child = nullptr;
-    bool regular = false;
-    bool boundary = false;
-};
+    uint32_t getVertexCount() const { return (uint32_t)positions.size(); }
+    uint32_t getFaceCount() const { return (uint32_t)(faceVertices.size() / 3); }
 
-struct SDFace
-{
-    SDFace()
+    uint32_t vnum(uint32_t face, uint32_t vertex) const
     {
         for (uint32_t i = 0; i < 3; ++i)
         {
-            v[i] = nullptr;
-            f[i] = nullptr;
-        }
-        for (uint32_t i = 0; i < 4; ++i)
-        {
-            children[i] = nullptr;
+            if (faceVertices[3 * face + i] == vertex)
+                return i;
         }
+        FALCOR_ASSERT(false);
+        return 0;
     }
 
-    uint32_t vnum(SDVertex* vert) const
+    uint32_t nextFace(uint32_t face, uint32_t vertex) const { return faceNeighbors[3 * face + vnum(face, vertex)]; }
+    uint32_t prevFace(uint32_t face, uint32_t vertex) const { return faceNeighbors[3 * face + PREV(vnum(face, vertex))]; }
+    uint32_t nextVert(uint32_t face, uint32_t vertex) const { return faceVertices[3 * face + NEXT(vnum(face, vertex))]; }
+    uint32_t prevVert(uint32_t face, uint32_t vertex) const { return faceVertices[3 * face + PREV(vnum(face, vertex))]; }
+    uint32_t otherVert(uint32_t face, uint32_t v0, uint32_t v1) const
     {
-        for (int i = 0; i < 3; ++i)
+        for (uint32_t i = 0; i < 3; ++i)
         {
-            if (v[i] == vert)
-                return i;
+            uint32_t v = faceVertices[3 * face + i];
+            if (v != v0 && v != v1)
+                return v;
         }
-        FALCOR_THROW("Basic logic error in SDFace::vnum().");
+        FALCOR_ASSERT(false);
+        return 0;
     }
 
-    SDFace* nextFace(SDVertex* vert) const { return f[vnum(vert)]; }
-    SDFace* prevFace(SDVertex* vert) const { return f[PREV(vnum(vert))]; }
-    SDVertex* nextVert(SDVertex* vert) const { return v[NEXT(vnum(vert))]; }
-    SDVertex* prevVert(SDVertex* vert) const { return v[PREV(vnum(vert))]; }
-    SDVertex* otherVert(SDVertex* v0, SDVertex* v1)
+    uint32_t valence(uint32_t vertex) const
     {
-        for (uint32_t i = 0; i < 3; ++i)
+        uint32_t f = startFace[vertex];
+        if (!boundary[vertex])
+        {
+            // Compute valence of interior vertex.
+            uint32_t nf = 1;
+            while ((f = nextFace(f, vertex)) != startFace[vertex])
+                ++nf;
+            return nf;
+        }
+        else
         {
-            if (v[i] != v0 && v[i] != v1)
-                return v[i];
+            // Compute valence of boundary vertex.
+            uint32_t nf = 1;
+            while ((f = nextFace(f, vertex)) != kInvalid)
+                ++nf;
+            f = startFace[vertex];
+            while ((f = prevFace(f, vertex)) != kInvalid)
+                ++nf;
+            return nf + 1;
         }
-        FALCOR_THROW("Basic logic error in SDFace::otherVert()");
     }
 
-    SDVertex* v[3];
-    SDFace* f[3];
-    SDFace* children[4];
-};
-
-struct SDEdge
-{
-    SDEdge(SDVertex* v0 = nullptr, SDVertex* v1 = nullptr)
+    /// Call func(j, position) for the one-ring vertices of a vertex, in the same order as pbrt's SDVertex::oneRing().
+    template<typename Func>
+    void forEachOneRing(uint32_t vertex, Func func) const
     {
-        v[0] = std::min(v0, v1);
-        v[1] = std::max(v0, v1);
-        f[0] = f[1] = nullptr;
-        f0edgeNum = -1;
+        uint32_t j = 0;
+        if (!boundary[vertex])
+        {
+            // Get one-ring vertices for interior vertex.
+            uint32_t face = startFace[vertex];
+            do
+            {
+                func(j++, positions[nextVert(face, vertex)]);
+                face = nextFace(face, vertex);
+            } while (face != startFace[vertex]);
+        }
+        else
+        {
+            // Get one-ring vertices for boundary vertex.
+            uint32_t face = startFace[vertex];
+            uint32_t f2;
+            while ((f2 = nextFace(face, vertex)) != kInvalid)
+                face = f2;
+            func(j++, positions[nextVert(face, vertex)]);
+            do
+            {
+                func(j++, positions[prevVert(face, vertex)]);
+                face = prevFace(face, vertex);
+            } while (face != kInvalid);
+        }
     }
 
-    bool operator<(const SDEdge& e2) const
+    float3 weightOneRing(uint32_t vertex, float beta) const
     {
-        if (v[0] == e2.v[0])
-            return v[1] < e2.v[1];
-        return v[0] < e2.v[0];
+        uint32_t valence = this->valence(vertex);
+        float3 p = (1 - valence * beta) * positions[vertex];
+        forEachOneRing(vertex, [&](uint32_t, const float3& pRing) { p += beta * pRing; });
+        return p;
     }
 
-    SDVertex* v[2];
-    SDFace* f[2];
-    int f0edgeNum;
-};
-
-static float3 weightOneRing(SDVertex* vert, float beta);
-static float3 weightBoundary(SDVertex* vert, float beta);
-
-inline int SDVertex::valence()
-{
-    SDFace* f = startFace;
-    if (!boundary)
+    float3 weightBoundary(uint32_t vertex, float beta) const
     {
-        // Compute valence of interior vertex.
-        int nf = 1;
-        while ((f = f->nextFace(this)) != startFace)
-            ++nf;
-        return nf;
+        uint32_t valence = this->valence(vertex);
+        float3 pFirst(0.f), pLast(0.f);
+        forEachOneRing(
+            vertex,
+            [&](uint32_t j, const float3& pRing)
+            {
+                if (j == 0)
+                    pFirst = pRing;
+                if (j == valence - 1)
+                    pLast = pRing;
+            }
+        );
+        float3 p = (1 - 2 * beta) * positions[vertex];
+        p += beta * pFirst;
+        p += beta * pLast;
+        return p;
     }
-    else
+
+    size_t getMemoryUsage() const
     {
-        // Compute valence of boundary vertex
-        int nf = 1;
-        while ((f = f->nextFace(this)) != nullptr)
-            ++nf;
-        f = startFace;
-        while ((f = f->prevFace(this)) != nullptr)
-            ++nf;
-        return nf + 1;
+        return positions.size() * sizeof(float3) + startFace.size() * sizeof(uint32_t) + boundary.size() + regular.size() +
+               faceVertices.size() * sizeof(uint32_t) + faceNeighbors.size() * sizeof(uint32_t);
     }
-}
+};
 
 inline float beta(uint32_t valence)
 {
@@ -171,372 +205,379 @@ inline float loopGamma(uint32_t valence)
     return 1.f / (valence + 3.f / (8.f * beta(valence)));
 }
 
-LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+template<typename Func>
+void parallelFor(uint32_t count, Func func)
 {
-    std::vector<SDVertex*> vertices;
-    std::vector<SDFace*> faces;
-
-    // Allocate vertices and faces.
-    std::unique_ptr<SDVertex[]> vertexBuffer = std::make_unique<SDVertex[]>(positions.size());
-    for (size_t i = 0; i < positions.size(); ++i)
-    {
-        vertexBuffer[i] = SDVertex(positions[i]);
-        vertices.push_back(&vertexBuffer[i]);
-    }
-    size_t faceCount = indices.size() / 3;
-    std::unique_ptr<SDFace[]> fs = std::make_unique<SDFace[]>(faceCount);
-    for (size_t i = 0; i < faceCount; ++i)
-    {
-        faces.push_back(&fs[i]);
-    }
+    auto range = NumericRange<uint32_t>(0, count);
+    std::for_each(std::execution::par_unseq, range.begin(), range.end(), func);
+}
 
-    // Set face to vertex pointers.
+SubdivMesh createBaseMesh(fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+{
+    SubdivMesh mesh;
+    const uint32_t vertexCount = (uint32_t)positions.size();
+    const uint32_t faceCount = (uint32_t)(indices.size() / 3);
+
+    mesh.positions.assign(positions.begin(), positions.end());
+    mesh.startFace.assign(vertexCount, kInvalid);
+    mesh.boundary.assign(vertexCount, 0);
+    mesh.regular.assign(vertexCount, 0);
+    mesh.faceVertices.assign(indices.begin(), indices.begin() + 3 * faceCount);
+    mesh.faceNeighbors.assign(3 * faceCount, kInvalid);
+
+    // Set face to vertex references.
+    for (uint32_t i = 0; i < faceCount; ++i)
     {
-        const uint32_t* vp = indices.data();
-        for (size_t i = 0; i < faceCount; ++i, vp += 3)
+        for (uint32_t j = 0; j < 3; ++j)
         {
-            SDFace* f = faces[i];
-            for (uint32_t j = 0; j < 3; ++j)
-            {
-                SDVertex* v = vertices[vp[j]];
-                f->v[j] = v;
-                v->startFace = f;
-            }
+            uint32_t v = mesh.faceVertices[3 * i + j];
+            if (v >= vertexCount)
+                FALCOR_THROW("Vertex index {} out of range.", v);
+            mesh.startFace[v] = i;
         }
     }
 
-    // Set neighbor pointers in faces.
-    std::set<SDEdge> edges;
-    for (size_t i = 0; i < faceCount; ++i)
+    // Set neighbor references in faces.
+    // An edge is matched with the next face using the same (unordered) vertex pair, then released again.
+    std::unordered_map<uint64_t, uint32_t> edges; // Edge key -> 3 * face + edgeNum of the first face.
+    edges.reserve(3 * faceCount / 2);
+    for (uint32_t i = 0; i < faceCount; ++i)
     {
-        SDFace* f = faces[i];
         for (uint32_t edgeNum = 0; edgeNum < 3; ++edgeNum)
         {
-            // Update neighbor pointer for edgeNum.
-            int v0 = edgeNum, v1 = NEXT(edgeNum);
-            SDEdge e(f->v[v0], f->v[v1]);
-            if (edges.find(e) == edges.end())
+            uint32_t v0 = mesh.faceVertices[3 * i + edgeNum];
+            uint32_t v1 = mesh.faceVertices[3 * i + NEXT(edgeNum)];
+            uint64_t key = (uint64_t(std::min(v0, v1)) << 32) | std::max(v0, v1);
+            auto it = edges.find(key);
+            if (it == edges.end())
             {
                 // Handle new edge.
-                e.f[0] = f;
-                e.f0edgeNum = edgeNum;
-                edges.insert(e);
+                edges.emplace(key, 3 * i + edgeNum);
             }
             else
             {
                 // Handle previously seen edge.
-                e = *edges.find(e);
-                e.f[0]->f[e.f0edgeNum] = f;
-                f->f[edgeNum] = e.f[0];
-                edges.erase(e);
+                uint32_t other = it->second;
+                mesh.faceNeighbors[other] = i;
+                mesh.faceNeighbors[3 * i + edgeNum] = other / 3;
+                edges.erase(it);
             }
         }
     }
 
     // Finish vertex initialization.
-    for (size_t i = 0; i < positions.size(); ++i)
+    for (uint32_t v = 0; v < vertexCount; ++v)
     {
-        SDVertex* v = vertices[i];
-        SDFace* f = v->startFace;
-        do
-        {
-            f = f->nextFace(v);
-        } while ((f != nullptr) && f != v->startFace);
-        v->boundary = (f == nullptr);
-        if (!v->boundary && v->valence() == 6)
-            v->regular = true;
-        else if (v->boundary && v->valence() == 4)
-            v->regular = true;
-        else
-            v->regular = false;
+        if (mesh.startFace[v] == kInvalid)
+            FALCOR_THROW("Vertex {} is not referenced by any face.", v);
     }
 
-    // Refine LoopSubdiv into triangles.
-    std::vector<SDFace*> f = faces;
-    std::vector<SDVertex*> v = vertices;
-
-    std::pmr::monotonic_buffer_resource buffer;
-    std::pmr::polymorphic_allocator<SDVertex> vertexAllocator(&buffer);
-    std::pmr::polymorphic_allocator<SDFace> faceAllocator(&buffer);
-
-    for (size_t i = 0; i < levels; ++i)
-    {
-        // Update f and v for next level of subdivision.
-        std::vector<SDFace*> newFaces;
-        std::vector<SDVertex*> newVertices;
-
-        // Allocate next level of children in mesh tree.
-        for (SDVertex* vertex : v)
+    parallelFor(
+        vertexCount,
+        [&](uint32_t v)
         {
-            vertex->child = vertexAllocator.allocate(1);
-            vertex->child->regular = vertex->regular;
-            vertex->child->boundary = vertex->boundary;
-            newVertices.push_back(vertex->child);
+            uint32_t f = mesh.startFace[v];
+            do
+            {
+                f = mesh.nextFace(f, v);
+            } while (f != kInvalid && f != mesh.startFace[v]);
+            mesh.boundary[v] = f == kInvalid;
+            uint32_t valence = mesh.valence(v);
+            mesh.regular[v] = (!mesh.boundary[v] && valence == 6) || (mesh.boundary[v] && valence == 4);
         }
-        for (SDFace* face : f)
+    );
+
+    return mesh;
+}
+
+SubdivMesh subdivide(const SubdivMesh& mesh)
+{
+    const uint32_t vertexCount = mesh.getVertexCount();
+    const uint32_t faceCount = mesh.getFaceCount();
+
+    // Odd vertices are created for each edge in the order edges are first encountered when iterating over the faces.
+    // An edge is first encountered in the face with the lower index, which owns the odd vertex.
+    std::vector<uint32_t> ownedEdgeCount(faceCount);
+    parallelFor(
+        faceCount,
+        [&](uint32_t f)
         {
-            for (uint32_t k = 0; k < 4; ++k)
+            uint32_t count = 0;
+            for (uint32_t k = 0; k < 3; ++k)
             {
-                face->children[k] = faceAllocator.allocate(1);
-                newFaces.push_back(face->children[k]);
+                uint32_t neighbor = mesh.faceNeighbors[3 * f + k];
+                count += (neighbor == kInvalid || neighbor > f) ? 1 : 0;
             }
+            ownedEdgeCount[f] = count;
         }
-
-        // Update vertex positions and create new edge vertices.
-
-        // Update vertex positions for even vertices.
-        for (SDVertex* vertex : v)
+    );
+
+    std::vector<uint32_t> oddVertexOffset(faceCount);
+    std::exclusive_scan(ownedEdgeCount.begin(), ownedEdgeCount.end(), oddVertexOffset.begin(), vertexCount);
+    const uint32_t oddVertexCount = faceCount > 0 ? oddVertexOffset.back() + ownedEdgeCount.back() - vertexCount : 0;
+
+    SubdivMesh child;
+    const uint32_t childVertexCount = vertexCount + oddVertexCount;
+    const uint32_t childFaceCount = 4 * faceCount;
+    child.positions.resize(childVertexCount);
+    child.startFace.resize(childVertexCount);
+    child.boundary.resize(childVertexCount);
+    child.regular.resize(childVertexCount);
+    child.faceVertices.resize(3 * childFaceCount);
+    child.faceNeighbors.resize(3 * childFaceCount);
+
+    // Odd vertex index for each face edge.
+    std::vector<uint32_t> edgeVertices(3 * faceCount);
+
+    // Update vertex positions for even vertices. Children of even vertices keep their index.
+    parallelFor(
+        vertexCount,
+        [&](uint32_t v)
         {
-            if (!vertex->boundary)
+            if (!mesh.boundary[v])
             {
                 // Apply one-ring rule for even vertex.
-                if (vertex->regular)
-                    vertex->child->p = weightOneRing(vertex, 1.f / 16.f);
+                if (mesh.regular[v])
+                    child.positions[v] = mesh.weightOneRing(v, 1.f / 16.f);
                 else
-                    vertex->child->p = weightOneRing(vertex, beta(vertex->valence()));
+                    child.positions[v] = mesh.weightOneRing(v, beta(mesh.valence(v)));
             }
             else
             {
                 // Apply boundary rule for even vertex.
-                vertex->child->p = weightBoundary(vertex, 1.f / 8.f);
+                child.positions[v] = mesh.weightBoundary(v, 1.f / 8.f);
             }
+
+            // Update even vertex face references.
+            uint32_t startFace = mesh.startFace[v];
+            child.startFace[v] = 4 * startFace + mesh.vnum(startFace, v);
+            child.boundary[v] = mesh.boundary[v];
+            child.regular[v] = mesh.regular[v];
         }
+    );
 
-        // Compute new odd edge vertices.
-        std::map<SDEdge, SDVertex*> edgeVerts;
-        for (SDFace* face : f)
+    // Compute new odd edge vertices.
+    parallelFor(
+        faceCount,
+        [&](uint32_t f)
         {
+            uint32_t next = oddVertexOffset[f];
             for (uint32_t k = 0; k < 3; ++k)
             {
-                // Compute odd vertex on kth edge.
-                SDEdge edge(face->v[k], face->v[NEXT(k)]);
-                SDVertex* vert = edgeVerts[edge];
-                if (vert == nullptr)
+                uint32_t neighbor = mesh.faceNeighbors[3 * f + k];
+                if (neighbor != kInvalid && neighbor < f)
+                    continue;
+
+                uint32_t vert = next++;
+                edgeVertices[3 * f + k] = vert;
+
+                uint32_t v0 = mesh.faceVertices[3 * f + k];
+                uint32_t v1 = mesh.faceVertices[3 * f + NEXT(k)];
+
+                child.regular[vert] = 1;
+                child.boundary[vert] = neighbor == kInvalid;
+                child.startFace[vert] = 4 * f + 3;
+
+                // Apply edge rules to compute new vertex position.
+                float3 p;
+                if (child.boundary[vert])
                 {
-                    // Create and initialize new odd vertex
-                    vert = vertexAllocator.allocate(1);
-                    newVertices.push_back(vert);
-                    vert->regular = true;
-                    vert->boundary = (face->f[k] == nullptr);
-                    vert->startFace = face->children[3];
-
-                    // Apply edge rules to compute new vertex position
-                    if (vert->boundary)
-                    {
-                        vert->p = 0.5f * edge.v[0]->p;
-                        vert->p += 0.5f * edge.v[1]->p;
-                    }
-                    else
-                    {
-                        vert->p = 3.f / 8.f * edge.v[0]->p;
-                        vert->p += 3.f / 8.f * edge.v[1]->p;
-                        vert->p += 1.f / 8.f * face->otherVert(edge.v[0], edge.v[1])->p;
-                        vert->p += 1.f / 8.f * face->f[k]->otherVert(edge.v[0], edge.v[1])->p;
-                    }
-                    edgeVerts[edge] = vert;
+                    p = 0.5f * mesh.positions[v0];
+                    p += 0.5f * mesh.positions[v1];
+                }
+                else
+                {
+                    p = 3.f / 8.f * mesh.positions[v0];
+                    p += 3.f / 8.f * mesh.positions[v1];
+                    p += 1.f / 8.f * mesh.positions[mesh.otherVert(f, v0, v1)];
+                    p += 1.f / 8.f * mesh.positions[mesh.otherVert(neighbor, v0, v1)];
                 }
+                child.positions[vert] = p;
             }
         }
+    );
 
-        // Update new mesh topology.
-
-        // Update even vertex face pointers.
-        for (SDVertex* vertex : v)
+    // Look up the odd vertices of edges owned by the neighbor face.
+    parallelFor(
+        faceCount,
+        [&](uint32_t f)
         {
-            int vertNum = vertex->startFace->vnum(vertex);
-            vertex->child->startFace = vertex->startFace->children[vertNum];
+            for (uint32_t k = 0; k < 3; ++k)
+            {
+                uint32_t neighbor = mesh.faceNeighbors[3 * f + k];
+                if (neighbor == kInvalid || neighbor > f)
+                    continue;
+
+                uint32_t v0 = mesh.faceVertices[3 * f + k];
+                uint32_t v1 = mesh.faceVertices[3 * f + NEXT(k)];
+                for (uint32_t kk = 0; kk < 3; ++kk)
+                {
+                    uint32_t w0 = mesh.faceVertices[3 * neighbor + kk];
+                    uint32_t w1 = mesh.faceVertices[3 * neighbor + NEXT(kk)];
+                    if ((w0 == v0 && w1 == v1) || (w0 == v1 && w1 == v0))
+                    {
+                        edgeVertices[3 * f + k] = edgeVertices[3 * neighbor + kk];
+                        break;
+                    }
+                }
+            }
         }
+    );
 
-        // Update face neighbor pointers.
-        for (SDFace* face : f)
+    // Update new mesh topology.
+    parallelFor(
+        faceCount,
+        [&](uint32_t f)
         {
+            auto childFace = [&](uint32_t i) { return 4 * f + i; };
+
             for (uint32_t j = 0; j < 3; ++j)
             {
-                // Update children f pointers for siblings.
-                face->children[3]->f[j] = face->children[NEXT(j)];
-                face->children[j]->f[NEXT(j)] = face->children[3];
-
-                // Update children f pointers for neighbor children.
-                SDFace* f2 = face->f[j];
-                face->children[j]->f[j] = f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
-                f2 = face->f[PREV(j)];
-                face->children[j]->f[PREV(j)] = f2 != nullptr ? f2->children[f2->vnum(face->v[j])] : nullptr;
+                // Update children face references for siblings.
+                child.faceNeighbors[3 * childFace(3) + j] = childFace(NEXT(j));
+                child.faceNeighbors[3 * childFace(j) + NEXT(j)] = childFace(3);
+
+                // Update children face references for neighbor children.
+                uint32_t v = mesh.faceVertices[3 * f + j];
+                uint32_t f2 = mesh.faceNeighbors[3 * f + j];
+                child.faceNeighbors[3 * childFace(j) + j] = f2 != kInvalid ? 4 * f2 + mesh.vnum(f2, v) : kInvalid;
+                f2 = mesh.faceNeighbors[3 * f + PREV(j)];
+                child.faceNeighbors[3 * childFace(j) + PREV(j)] = f2 != kInvalid ? 4 * f2 + mesh.vnum(f2, v) : kInvalid;
             }
-        }
 
-        // Update face vertex pointers.
-        for (SDFace* face : f)
-        {
             for (uint32_t j = 0; j < 3; ++j)
             {
-                // Update child vertex pointer to new even vertex
-                face->children[j]->v[j] = face->v[j]->child;
-
-                // Update child vertex pointer to new odd vertex
-                SDVertex* vert = edgeVerts[SDEdge(face->v[j], face->v[NEXT(j)])];
-                face->children[j]->v[NEXT(j)] = vert;
-                face->children[NEXT(j)]->v[j] = vert;
-                face->children[3]->v[j] = vert;
+                // Update child vertex reference to new even vertex.
+                child.faceVertices[3 * childFace(j) + j] = mesh.faceVertices[3 * f + j];
+
+                // Update child vertex reference to new odd vertex.
+                uint32_t vert = edgeVertices[3 * f + j];
+                child.faceVertices[3 * childFace(j) + NEXT(j)] = vert;
+                child.faceVertices[3 * childFace(NEXT(j)) + j] = vert;
+                child.faceVertices[3 * childFace(3) + j] = vert;
             }
         }
+    );
 
-        // Prepare for next level of subdivision
-        f = newFaces;
-        v = newVertices;
-    }
+    return child;
+}
 
-    // Push vertices to limit surface.
-    std::vector<float3> pLimit(v.size());
-    for (size_t i = 0; i < v.size(); ++i)
-    {
-        if (v[i]->boundary)
-            pLimit[i] = weightBoundary(v[i], 1.f / 5.f);
-        else
-            pLimit[i] = weightOneRing(v[i], loopGamma(v[i]->valence()));
-    }
-    for (size_t i = 0; i < v.size(); ++i)
+} // namespace
+
+LoopSubdivideResult loopSubdivide(uint32_t levels, fstd::span<const float3> positions, fstd::span<const uint32_t> indices)
+{
+    SubdivMesh mesh = createBaseMesh(positions, indices);
+
+    // Refine into triangles.
+    for (uint32_t level = 0; level < levels; ++level)
     {
-        v[i]->p = pLimit[i];
+        ScopedLoadPhase phase(fmt::format("Loop subdivision level {}", level + 1));
+        // The parent mesh, the child mesh and the 5 per-face edge arrays of subdivide() are alive at the same time.
+        const size_t parentBytes = mesh.getMemoryUsage() + 5 * sizeof(uint32_t) * mesh.getFaceCount();
+        mesh = subdivide(mesh);
+        phase.addCount("vertices", mesh.getVertexCount());
+        phase.addCount("faces", mesh.getFaceCount());
+        phase.addCount("bytes", mesh.getMemoryUsage());
+        phase.addCount("peak bytes", parentBytes + mesh.getMemoryUsage());
     }
 
-    // Compute vertex tangents on limit surface.
-    std::vector<float3> Ns;
-    Ns.reserve(v.size());
-    std::vector<float3> pRing(16, float3());
-    for (SDVertex* vertex : v)
-    {
-        float3 S(0.f);
-        float3 T(0.f);
-        uint32_t valence = vertex->valence();
-        if (valence > pRing.size())
-            pRing.resize(valence);
-        vertex->oneRing(&pRing[0]);
-        if (!vertex->boundary)
+    const uint32_t vertexCount = mesh.getVertexCount();
+
+    // Push vertices to limit surface.
+    std::vector<float3> pLimit(vertexCount);
+    parallelFor(
+        vertexCount,
+        [&](uint32_t v)
         {
-            // Compute tangents of interior face
-            for (uint32_t j = 0; j < valence; ++j)
-            {
-                S += std::cos(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
-                T += std::sin(2.f * float(M_PI) * j / valence) * float3(pRing[j]);
-            }
+            if (mesh.boundary[v])
+                pLimit[v] = mesh.weightBoundary(v, 1.f / 5.f);
+            else
+                pLimit[v] = mesh.weightOneRing(v, loopGamma(mesh.valence(v)));
         }
-        else
+    );
+    mesh.positions = std::move(pLimit);
+
+    // Compute vertex tangents on limit surface.
+    std::vector<float3> Ns(vertexCount);
+    parallelFor(
+        vertexCount,
+        [&](uint32_t v)
         {
-            // Compute tangents of boundary face
-            S = pRing[valence - 1] - pRing[0];
-            if (valence == 2)
+            float3 S(0.f);
+            float3 T(0.f);
+            uint32_t valence = mesh.valence(v);
+            const float3& p = mesh.positions[v];
+            if (!mesh.boundary[v])
             {
-                T = float3(pRing[0] + pRing[1] - 2.f * vertex->p);
-            }
-            else if (valence == 3)
-            {
-                T = pRing[1] - vertex->p;
-            }
-            else if (valence == 4) // regular
-            {
-                T = float3(-1.f * pRing[0] + 2.f * pRing[1] + 2.f * pRing[2] + -1.f * pRing[3] + -2.f * vertex->p);
+                // Compute tangents of interior face.
+                mesh.forEachOneRing(
+                    v,
+                    [&](uint32_t j, const float3& pRing)
+                    {
+                        S += std::cos(2.f * float(M_PI) * j / valence) * float3(pRing);
+                        T += std::sin(2.f * float(M_PI) * j / valence) * float3(pRing);
+                    }
+                );
             }
             else
             {
-                float theta = float(M_PI) / float(valence - 1);
-                T = float3(std::sin(theta) * (pRing[0] + pRing[valence - 1]));
-                for (uint32_t k = 1; k < valence - 1; ++k)
+                // Compute tangents of boundary face.
+                float3 pRing[4];
+                float3 pFirst(0.f), pLast(0.f);
+                mesh.forEachOneRing(
+                    v,
+                    [&](uint32_t j, const float3& pr)
+                    {
+                        if (j < 4)
+                            pRing[j] = pr;
+                        if (j == 0)
+                            pFirst = pr;
+                        if (j == valence - 1)
+                            pLast = pr;
+                    }
+                );
+
+                S = pLast - pFirst;
+                if (valence == 2)
                 {
-                    float wt = (2 * std::cos(theta) - 2) * std::sin((k)*theta);
-                    T += float3(wt * pRing[k]);
+                    T = float3(pRing[0] + pRing[1] - 2.f * p);
+                }
+                else if (valence == 3)
+                {
+                    T = pRing[1] - p;
+                }
+                else if (valence == 4) // regular
+                {
+                    T = float3(-1.f * pRing[0] + 2.f * pRing[1] + 2.f * pRing[2] + -1.f * pRing[3] + -2.f * p);
+                }
+                else
+                {
+                    float theta = float(M_PI) / float(valence - 1);
+                    T = float3(std::sin(theta) * (pFirst + pLast));
+                    mesh.forEachOneRing(
+                        v,
+                        [&](uint32_t k, const float3& pr)
+                        {
+                            if (k >= 1 && k < valence - 1)
+                            {
+                                float wt = (2 * std::cos(theta) - 2) * std::sin((k)*theta);
+                                T += float3(wt * pr);
+                            }
+                        }
+                    );
+                    T = -T;
                 }
-                T = -T;
-            }
-        }
-        Ns.push_back(cross(S, T));
-    }
-
-    // Create triangle mesh from subdivision mesh
-    {
-        size_t ntris = f.size();
-        std::vector<uint32_t> verts(3 * ntris);
-        uint32_t* vp = verts.data();
-        uint32_t totVerts = (uint32_t)v.size();
-        std::map<SDVertex*, uint32_t> usedVerts;
-        for (uint32_t i = 0; i < totVerts; ++i)
-        {
-            usedVerts[v[i]] = i;
-        }
-        for (size_t i = 0; i < ntris; ++i)
-        {
-            for (uint32_t j = 0; j < 3; ++j)
-            {
-                *vp = usedVerts[f[i]->v[j]];
-                ++vp;
             }
+            Ns[v] = cross(S, T);
         }
-
-        LoopSubdivideResult result;
-        result.positions = std::move(pLimit);
-        result.normals = std::move(Ns);
-        result.indices = std::move(verts);
-        return result;
-    }
-}
-
-static float3 weightOneRing(SDVertex* vert, float beta)
-{
-    // Put vert one-ring in pRing.
-    uint32_t valence = vert->valence();
-    FALCOR_ASSERT(valence < 16);
-    float3 pRing[16];
-
-    vert->oneRing(pRing);
-    float3 p = (1 - valence * beta) * vert->p;
-    for (uint32_t i = 0; i < valence; ++i)
-    {
-        p += beta * pRing[i];
-    }
-    return p;
-}
-
-void SDVertex::oneRing(float3* p_)
-{
-    if (!boundary)
-    {
-        // Get one-ring vertices for interior vertex.
-        SDFace* face = startFace;
-        do
-        {
-            *p_++ = face->nextVert(this)->p;
-            face = face->nextFace(this);
-        } while (face != startFace);
-    }
-    else
-    {
-        // Get one-ring vertices for boundary vertex.
-        SDFace* face = startFace;
-        SDFace* f2;
-        while ((f2 = face->nextFace(this)) != nullptr)
-        {
-            face = f2;
-        }
-        *p_++ = face->nextVert(this)->p;
-        do
-        {
-            *p_++ = face->prevVert(this)->p;
-            face = face->prevFace(this);
-        } while (face != nullptr);
-    }
-}
-
-static float3 weightBoundary(SDVertex* vert, float beta)
-{
-    // Put vert one-ring in pRing.
-    uint32_t valence = vert->valence();
-    FALCOR_ASSERT(valence < 16);
-    float3 pRing[16];
-
-    vert->oneRing(pRing);
-    float3 p = (1 - 2 * beta) * vert->p;
-    p += beta * pRing[0];
-    p += beta * pRing[valence - 1];
-    return p;
+    );
+
+    // Create triangle mesh from subdivision mesh.
+    LoopSubdivideResult result;
+    result.positions = std::move(mesh.positions);
+    result.normals = std::move(Ns);
+    result.indices = std::move(mesh.faceVertices);
+    return result;
 }
 
 } // namespace Falcor::pbrt
@@ -68,6 +68,7 @@
 #include "Core/API/Device.h"
 #include "Utils/Settings/Settings.h"
 #include "Utils/Logger.h"
+#include "Utils/Timing/LoadProfiler.h"
 #include "Utils/Timing/TimeReport.h"
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/FNVHash.h"
@@ -86,6 +87,10 @@
 
 #include <pybind11/pybind11.h>
 
+#include <execution>
+#include <numeric>
+#include <optional>
+#include <set>
 #include <unordered_map>
 
 namespace Falcor
@@ -110,6 +115,12 @@ const float4x4 kInvertZ = {
     // clang-format on
 };
 
+/// Maximum total file size of the ply meshes loaded in parallel in one batch.
+const uint64_t kPlyMeshBatchBytes = 1ull << 30;
+
+/// Name of plymesh meshes in the mesh cache, see SceneBuilder::getMeshCacheKey().
+const char kPlyMeshCacheName[] = "pbrt/plymesh";
+
 /**
  * Holds the results from creating a camera.
  */
@@ -176,6 +187,11 @@ struct Shape
     Falcor::ref<Falcor::TriangleMesh> pTriangleMesh;
     float4x4 transform = float4x4::identity();
     Falcor::ref<Falcor::Material> pMaterial;
+
+    // Plymesh shapes. The mesh is not loaded by createShape(), but read from the mesh cache or loaded by addShapeMesh().
+    std::filesystem::path plyPath;
+    std::string plyName;
+    bool reverseOrientation = false;
 };
 
 /**
@@ -226,6 +242,17 @@ struct BuilderContext
 
     std::map<std::string, InstanceDefinition> instanceDefinitions;
 
+    /// Triangle meshes of plymesh shapes, by resolved path. Meshes are loaded in batches by loadPlyMeshes()
+    /// and shared by all shapes referencing the same file. A mesh is released after its last use.
+    struct PlyMesh
+    {
+        Falcor::ref<Falcor::TriangleMesh> pTriangleMesh;
+        bool frontFaceCW = false; ///< Winding of the mesh as loaded from file.
+        bool loaded = false;
+        size_t useCount = 0; ///< Number of shapes still referencing the mesh.
+    };
+    std::map<std::filesystem::path, PlyMesh> plyMeshes;
+
     size_t curveCount = 0;
 
     bool usePBRTMaterials = false;
@@ -1591,11 +1618,9 @@ Shape createShape(BuilderContext& ctx, const ShapeSceneEntity& entity)
         warnUnsupportedParameters(params, {"displacement", "displacement.edgelength"});
 
         auto filename = params.getString("filename", "");
-        auto path = ctx.resolver(filename);
-
-        shape.pTriangleMesh = Falcor::TriangleMesh::createFromFile(path.string());
-        if (shape.pTriangleMesh)
-            shape.pTriangleMesh->setName(filename);
+        shape.plyPath = ctx.resolver(filename);
+        shape.plyName = filename;
+        shape.reverseOrientation = entity.reverseOrientation;
         shape.transform = entity.transform;
     }
     else if (type == "loopsubdiv")
@@ -1754,39 +1779,217 @@ std::variant<Falcor::MeshID, Falcor::CurveID> createCurveGeometry(BuilderContext
     }
 }
 
-InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceDefinitionSceneEntity& entity)
+/**
+ * Add the triangle mesh of a shape to the scene builder.
+ * Plymesh shapes are read from the mesh cache if possible. Otherwise the mesh loaded by loadPlyMeshes() is used,
+ * or the file is loaded if it is not resident.
+ */
+std::optional<Falcor::MeshID> addShapeMesh(BuilderContext& ctx, const Shape& shape)
 {
-    InstanceDefinition instanceDefinition;
+    if (shape.plyPath.empty())
+    {
+        if (!shape.pTriangleMesh)
+            return {};
+        return ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
+    }
+
+    // Take the shared mesh and release the shape's use of it.
+    Falcor::ref<Falcor::TriangleMesh> pTriangleMesh;
+    bool loaded = false;
+    bool frontFaceCW = false; // Meshes loaded from file have counter-clockwise winding.
+    auto it = ctx.plyMeshes.find(shape.plyPath);
+    if (it != ctx.plyMeshes.end())
+    {
+        auto& plyMesh = it->second;
+        pTriangleMesh = plyMesh.pTriangleMesh;
+        loaded = plyMesh.loaded;
+        frontFaceCW = plyMesh.frontFaceCW;
+        if (--plyMesh.useCount == 0)
+            ctx.plyMeshes.erase(it);
+    }
 
-    for (const auto& shapeEntity : entity.shapes)
+    auto cacheKey = ctx.builder.getMeshCacheKey({shape.plyPath}, kPlyMeshCacheName);
+    if (cacheKey)
     {
-        // Process shapes and create meshes.
-        auto shape = createShape(ctx, shapeEntity);
-        if (shape.pTriangleMesh)
+        Falcor::SceneBuilder::Mesh mesh;
+        mesh.name = shape.plyName;
+        mesh.topology = Falcor::Vao::Topology::TriangleList;
+        mesh.pMaterial = shape.pMaterial;
+        mesh.isFrontFaceCW = frontFaceCW != shape.reverseOrientation;
+        mesh.cacheKey = cacheKey;
+
+        Falcor::SceneBuilder::ProcessedMesh processedMesh;
+        if (ctx.builder.readCachedMesh(mesh, processedMesh))
+            return ctx.builder.addProcessedMesh(processedMesh);
+    }
+
+    if (!loaded)
+    {
+        pTriangleMesh = Falcor::TriangleMesh::createFromFile(shape.plyPath);
+        if (pTriangleMesh)
+            frontFaceCW = pTriangleMesh->getFrontFaceCW();
+    }
+    if (!pTriangleMesh)
+        return {};
+
+    // The winding of the shared mesh is set on every use, as shapes may reverse it. This is safe because the
+    // scene builder copies the mesh data before the next shape is added.
+    pTriangleMesh->setName(shape.plyName);
+    pTriangleMesh->setFrontFaceCW(frontFaceCW != shape.reverseOrientation);
+    return ctx.builder.addTriangleMesh(pTriangleMesh, shape.pMaterial, false, cacheKey);
+}
+
+/**
+ * Check if the mesh of a plymesh shape is in the mesh cache, so that its file does not need to be loaded.
+ * The shape's material is not created yet, but area lights use a copy with the same texture transform.
+ * If the check is wrong, addShapeMesh() loads the file instead.
+ */
+bool isPlyMeshCached(BuilderContext& ctx, const ShapeSceneEntity& entity, const std::filesystem::path& path)
+{
+    auto cacheKey = ctx.builder.getMeshCacheKey({path}, kPlyMeshCacheName);
+    return cacheKey && ctx.builder.isMeshCached(*cacheKey, ctx.getMaterial(entity.materialRef));
+}
+
+void countPlyMeshUses(BuilderContext& ctx)
+{
+    // Count the uses of each ply file by the shapes of the scene and of all instantiated object definitions.
+    auto addShape = [&ctx](const ShapeSceneEntity& entity)
+    {
+        if (entity.name != "plymesh")
+            return;
+        auto path = ctx.resolver(entity.params.getString("filename", ""));
+        ctx.plyMeshes[path].useCount++;
+    };
+
+    for (const auto& entity : ctx.scene.getShapes())
+        addShape(entity);
+
+    std::set<std::string> instantiated;
+    for (const auto& entity : ctx.scene.getInstances())
+        instantiated.insert(entity.name);
+    for (const auto& [name, definition] : ctx.scene.getInstanceDefinitions())
+    {
+        if (instantiated.count(name) == 0)
+            continue;
+        for (const auto& entity : definition.shapes)
+            addShape(entity);
+    }
+}
+
+void loadPlyMeshes(const std::vector<BuilderContext::PlyMesh*>& plyMeshes, const std::vector<std::filesystem::path>& paths)
+{
+    FALCOR_LOAD_PHASE("Loading ply meshes");
+
+    std::vector<size_t> indices(plyMeshes.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    std::for_each(
+        std::execution::par,
+        indices.begin(),
+        indices.end(),
+        [&](size_t i) { plyMeshes[i]->pTriangleMesh = Falcor::TriangleMesh::createFromFile(paths[i]); }
+    );
+
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    for (auto* pPlyMesh : plyMeshes)
+    {
+        pPlyMesh->loaded = true;
+        if (!pPlyMesh->pTriangleMesh)
+            continue;
+        pPlyMesh->frontFaceCW = pPlyMesh->pTriangleMesh->getFrontFaceCW();
+        vertexCount += pPlyMesh->pTriangleMesh->getVertices().size();
+        triangleCount += pPlyMesh->pTriangleMesh->getIndices().size() / 3;
+    }
+    LoadProfiler::instance().addCount("files", plyMeshes.size());
+    LoadProfiler::instance().addCount("vertices", vertexCount);
+    LoadProfiler::instance().addCount("triangles", triangleCount);
+}
+
+/**
+ * Calls a function for each shape, loading the ply meshes of the shapes in parallel batches beforehand.
+ * Each batch loads at most kPlyMeshBatchBytes of not yet loaded files (but at least one file),
+ * so only the meshes of the current batch and those still referenced by later shapes are resident.
+ * Files are not loaded for shapes whose mesh is in the mesh cache.
+ */
+template<typename Func>
+void forEachShape(BuilderContext& ctx, const std::vector<ShapeSceneEntity>& shapes, Func func)
+{
+    size_t batchBegin = 0;
+    while (batchBegin < shapes.size())
+    {
+        std::vector<BuilderContext::PlyMesh*> plyMeshes;
+        std::vector<std::filesystem::path> paths;
+        std::set<BuilderContext::PlyMesh*> batchMeshes;
+        uint64_t batchBytes = 0;
+
+        size_t batchEnd = batchBegin;
+        for (; batchEnd < shapes.size(); ++batchEnd)
         {
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
-            instanceDefinition.meshes.emplace_back(meshID, shape.transform);
+            const auto& entity = shapes[batchEnd];
+            if (entity.name != "plymesh")
+                continue;
+            auto path = ctx.resolver(entity.params.getString("filename", ""));
+            auto it = ctx.plyMeshes.find(path);
+            if (it == ctx.plyMeshes.end() || it->second.loaded || batchMeshes.count(&it->second) != 0)
+                continue;
+            if (isPlyMeshCached(ctx, entity, path))
+                continue;
+
+            std::error_code ec;
+            uint64_t fileSize = std::filesystem::file_size(path, ec);
+            if (ec)
+                fileSize = 0;
+            if (!plyMeshes.empty() && batchBytes + fileSize > kPlyMeshBatchBytes)
+                break;
+            batchBytes += fileSize;
+            batchMeshes.insert(&it->second);
+            plyMeshes.push_back(&it->second);
+            paths.push_back(path);
         }
 
-        // Create curves from curve aggregates assembled during the processing step above.
-        for (const auto& [_, curveAggregate] : ctx.curveAggregates)
+        if (!plyMeshes.empty())
+            loadPlyMeshes(plyMeshes, paths);
+
+        for (size_t i = batchBegin; i < batchEnd; ++i)
+            func(shapes[i]);
+        batchBegin = batchEnd;
+    }
+}
+
+InstanceDefinition createInstanceDefinition(BuilderContext& ctx, const InstanceDefinitionSceneEntity& entity)
+{
+    InstanceDefinition instanceDefinition;
+
+    forEachShape(
+        ctx,
+        entity.shapes,
+        [&](const ShapeSceneEntity& shapeEntity)
         {
-            auto meshOrCurveID = createCurveGeometry(ctx, curveAggregate);
-            if (auto meshID = std::get_if<Falcor::MeshID>(&meshOrCurveID))
-            {
-                instanceDefinition.meshes.emplace_back(*meshID, curveAggregate.transform);
-            }
-            else if (auto curveID = std::get_if<Falcor::CurveID>(&meshOrCurveID))
-            {
-                instanceDefinition.curves.emplace_back(*curveID, curveAggregate.transform);
-            }
-            else
+            // Process shapes and create meshes.
+            auto shape = createShape(ctx, shapeEntity);
+            if (auto meshID = addShapeMesh(ctx, shape))
+                instanceDefinition.meshes.emplace_back(*meshID, shape.transform);
+
+            // Create curves from curve aggregates assembled during the processing step above.
+            for (const auto& [_, curveAggregate] : ctx.curveAggregates)
             {
-                FALCOR_UNREACHABLE();
+                auto meshOrCurveID = createCurveGeometry(ctx, curveAggregate);
+                if (auto meshID = std::get_if<Falcor::MeshID>(&meshOrCurveID))
+                {
+                    instanceDefinition.meshes.emplace_back(*meshID, curveAggregate.transform);
+                }
+                else if (auto curveID = std::get_if<Falcor::CurveID>(&meshOrCurveID))
+                {
+                    instanceDefinition.curves.emplace_back(*curveID, curveAggregate.transform);
+                }
+                else
+                {
+                    FALCOR_UNREACHABLE();
+                }
             }
+            ctx.curveAggregates.clear();
         }
-        ctx.curveAggregates.clear();
-    }
+    );
 
     return instanceDefinition;
 }
@@ -1842,17 +2045,23 @@ void buildScene(BuilderContext& ctx)
         }
     }
 
+    // Count the uses of each ply file so that shared meshes can be released after their last use.
+    countPlyMeshUses(ctx);
+
     // Process shapes and create meshes.
-    for (const auto& entity : ctx.scene.getShapes())
-    {
-        auto shape = createShape(ctx, entity);
-        if (shape.pTriangleMesh)
+    forEachShape(
+        ctx,
+        ctx.scene.getShapes(),
+        [&](const ShapeSceneEntity& entity)
         {
-            auto nodeID = ctx.builder.addNode({entity.name, shape.transform});
-            auto meshID = ctx.builder.addTriangleMesh(shape.pTriangleMesh, shape.pMaterial);
-            ctx.builder.addMeshInstance(nodeID, meshID);
+            auto shape = createShape(ctx, entity);
+            if (auto meshID = addShapeMesh(ctx, shape))
+            {
+                auto nodeID = ctx.builder.addNode({entity.name, shape.transform});
+                ctx.builder.addMeshInstance(nodeID, *meshID);
+            }
         }
-    }
+    );
 
     // Create curves from curve aggregates assembled during the processing step above.
     for (const auto& [_, curveAggregate] : ctx.curveAggregates)
@@ -1924,13 +2133,19 @@ void PBRTImporter::importScene(
     {
         TimeReport timeReport;
         pbrt::BasicScene pbrtScene(path.parent_path());
-        pbrt::BasicSceneBuilder pbrtBuilder(pbrtScene);
-        pbrt::parseFile(pbrtBuilder, path);
+        {
+            FALCOR_LOAD_PHASE("Parsing pbrt scene");
+            pbrt::BasicSceneBuilder pbrtBuilder(pbrtScene);
+            pbrt::parseFile(pbrtBuilder, path);
+        }
         timeReport.measure("Parsing pbrt scene");
 
-        pbrt::BuilderContext ctx{pbrtScene, builder};
-        ctx.usePBRTMaterials = builder.getSettings().getOption("PBRTImporter:usePBRTMaterials", false);
-        pbrt::buildScene(ctx);
+        {
+            FALCOR_LOAD_PHASE("Building pbrt scene");
+            pbrt::BuilderContext ctx{pbrtScene, builder};
+            ctx.usePBRTMaterials = builder.getSettings().getOption("PBRTImporter:usePBRTMaterials", false);
+            pbrt::buildScene(ctx);
+        }
         timeReport.measure("Building pbrt scene");
         timeReport.printToLog();
     }
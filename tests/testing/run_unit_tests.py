@@ -26,6 +26,22 @@ def run_unit_tests(env: Environment, args):
 
     return p.returncode == 0
 
+def add_benchmark_tag(args):
+    '''
+    Add the benchmark tag to the tag filter in the FalcorTest arguments.
+    Benchmarks are excluded by FalcorTest unless the tag filter includes the benchmark tag.
+    '''
+    args = list(args)
+    for i, arg in enumerate(args):
+        for prefix in ['--tags=', '-t=']:
+            if arg.startswith(prefix):
+                args[i] = arg + ',benchmark'
+                return args
+        if arg in ['--tags', '-t'] and i + 1 < len(args):
+            args[i + 1] = args[i + 1] + ',benchmark'
+            return args
+    return args + ['--tags=benchmark']
+
 def main():
     default_config = find_most_recent_build_config()
 
@@ -34,6 +50,7 @@ def main():
     parser.add_argument('--environment', type=str, action='store', help=f'Environment', default=None)
     parser.add_argument('--config', type=str, action='store', help=f'Build configuration (default: {default_config})', default=default_config)
     parser.add_argument('--list-configs', action='store_true', help='List available build configurations')
+    parser.add_argument('--benchmarks', action='store_true', help='Include benchmarks (excluded by default)')
     args, passthrough_args = parser.parse_known_args()
 
     # Try to load environment.
@@ -63,6 +80,9 @@ def main():
         print(f"\nFailed to load environment: {env_error}")
         sys.exit(1)
 
+    if args.benchmarks:
+        passthrough_args = add_benchmark_tag(passthrough_args)
+
     # Run tests.
     success = run_unit_tests(env, passthrough_args)
 